@@ -63,33 +63,23 @@ static bool ADC_InitHardware(AInModule* pBoardAInModule);
  */
 void ADC_HandleAD7609Interrupt(void) {
     AInSample sample;
-    AInSampleArray samples;
+    AD7609SlotMap_t map;
+    uint32_t values[AD7609_NUM_CHANNELS];
     uint32_t *valueTMR = (uint32_t*) BoardData_Get(BOARDDATA_STREAMING_TIMESTAMP, 0);
 
-    samples.Size = 8;
-
     // Ensure timestamp pointer is valid; use 0 as safe fallback
     uint32_t timestamp = (valueTMR != NULL) ? *valueTMR : 0;
 
     // Read all AD7609 channels (polls BSY internally for safety)
-    if (AD7609_ReadSamples(&samples, &gpBoardConfig->AInChannels,
-                          &gpBoardRuntimeConfig->AInChannels, timestamp)) {
-
-        // Store each sample to BoardData at its array index
-        for (size_t s = 0; s < samples.Size; s++) {
-            // Find the array index for this channel
-            uint8_t channelId = samples.Data[s].Channel;
-            for (size_t i = 0; i < gpBoardConfig->AInChannels.Size; i++) {
-                if (gpBoardConfig->AInChannels.Data[i].Type == AIn_AD7609 &&
-                    gpBoardConfig->AInChannels.Data[i].DaqifiAdcChannelId == channelId) {
-
-                    sample.Timestamp = samples.Data[s].Timestamp;
-                    sample.Channel = channelId;
-                    sample.Value = samples.Data[s].Value;
-                    BoardData_Set(BOARDDATA_AIN_LATEST, i, &sample);
-                    break;
-                }
-            }
+    if (AD7609_ReadSamples(&map, values, &gpBoardConfig->AInChannels,
+                          &gpBoardRuntimeConfig->AInChannels)) {
+
+        // The map carries each channel's BoardData index -- no table search.
+        sample.Timestamp = timestamp;
+        for (uint8_t j = 0; j < map.count; j++) {
+            sample.Channel = map.channelId[j];
+            sample.Value = values[j];
+            BoardData_Set(BOARDDATA_AIN_LATEST, map.slot[j], &sample);
         }
     }
 }
@@ -107,7 +97,9 @@ void ADC_HandleAD7609Interrupt(void) {
 // dependency).  This task keeps the IDLE T1 reads so MEAS:VOLT:DC? and the
 // LATEST cache stay live between sessions.  T2 (shared) user channels stay
 // on their priority-1 ADC_DATAx ISRs — adding them here would double-write
-// AInLatest and regress T2 ceilings (confirmed empirically, #292).
+// AInLatest and regress T2 ceilings (confirmed empirically, #292) — except
+// in a CONF:ADC:SCAN:DMA session, where those ISRs are gated off and this
+// task is the only reader of the scan, from RAM.
 // Monitoring gating: when streaming with OBDiag=0, MODULE7 monitoring
 // results are stale — skip those reads so gLastDiagScanTick goes stale for
 // SYST:INFo? reporting.
@@ -146,6 +138,7 @@ void MC12bADC_EosInterruptTask(void) {
         bool streamingActive = gpBoardRuntimeConfig->StreamingConfig.Running;
         bool diagScanning = !streamingActive ||
                             gpBoardRuntimeConfig->StreamingConfig.OnboardDiagEnabled;
+        bool scanDma = MC12b_IsScanDmaActive();
 
         for (i = 0; i < gpBoardConfig->AInChannels.Size; i++) {
             const AInChannel* cfg = &gpBoardConfig->AInChannels.Data[i];
@@ -156,7 +149,7 @@ void MC12bADC_EosInterruptTask(void) {
             bool isType1User = (!isMonitoring && cfg->Config.MC12b.ChannelType == 1);
 
             if (isMonitoring && !diagScanning) continue;
-            if (!isMonitoring && !isType1User) continue; // T2 user → pri-1 ISRs
+            if (!isMonitoring && !isType1User && !scanDma) continue; // T2 user → pri-1 ISRs
             // #541 D-A/D-E: while streaming, T1 user results are read
             // directly by the deferred streaming task via per-input ARDY.
             // Reading them here too would clear ARDY before that task gets
@@ -489,6 +482,38 @@ double ADC_ConvertToVoltageByIndex(size_t channelIndex, uint32_t rawValue) {
     }
 }
 
+bool ADC_GetLinearConversionByIndex(size_t channelIndex,
+                                    ADC_LinearConversion* pOut) {
+    if (channelIndex >= gpBoardConfig->AInChannels.Size) {
+        return false;
+    }
+
+    const AInChannel* channelConfig =
+            &gpBoardConfig->AInChannels.Data[channelIndex];
+    const AInRuntimeConfig* pRuntimeConfig =
+            &gpBoardRuntimeConfig->AInChannels.Data[channelIndex];
+
+    switch (channelConfig->Type) {
+        case AIn_MC12bADC:
+            pOut->CodeMax = MC12b_GetLinearConversion(
+                    &channelConfig->Config.MC12b,
+                    pRuntimeConfig,
+                    &pOut->Gain,
+                    &pOut->Offset);
+            pOut->SignBits = 0;
+            return true;
+        case AIn_AD7609:
+            pOut->CodeMax = AD7609_GetLinearConversion(
+                    pRuntimeConfig,
+                    &pOut->Gain,
+                    &pOut->Offset);
+            pOut->SignBits = 18;
+            return true;
+        default:
+            return false;
+    }
+}
+
 double ADC_ConvertToVoltage(const AInSample* sample) {
     size_t channelIndex = ADC_FindChannelIndex(sample->Channel);
     if (channelIndex >= gpBoardConfig->AInChannels.Size) {
@@ -79,6 +79,27 @@ double ADC_ConvertToVoltage(const AInSample* sample);
  */
 double ADC_ConvertToVoltageByIndex(size_t channelIndex, uint32_t rawValue);
 
+/*! ADC_ConvertToVoltageByIndex for one channel in linear form:
+ * volts = code * Gain + Offset, where code is the raw value taken as
+ * unsigned (SignBits 0) or as SignBits-wide two's complement. Read once per
+ * session by encoders that precompute a fixed-point table (FixedPointCal.h).
+ */
+typedef struct {
+    double   Gain;      /**< Volts per code */
+    double   Offset;    /**< Volts added after scaling */
+    uint32_t CodeMax;   /**< Largest code magnitude the channel produces */
+    uint8_t  SignBits;  /**< 0: unsigned code; N: N-bit two's complement */
+} ADC_LinearConversion;
+
+/*! Fills @p pOut with the linear form of channel @p channelIndex's conversion.
+ * @param channelIndex Board config array index (NOT the DaqifiAdcChannelId)
+ * @param pOut         Receives the gain, offset and code range
+ * @return false if channelIndex is out of range or the channel type has no
+ *         linear form, in which case only ADC_ConvertToVoltageByIndex applies
+ */
+bool ADC_GetLinearConversionByIndex(size_t channelIndex,
+                                    ADC_LinearConversion* pOut);
+
 bool ADC_ReadADCSampleFromISR(uint32_t value,uint8_t bufferIndex);
 
 /*! Function to be called from the ISR for deferring the ADC interrupt */
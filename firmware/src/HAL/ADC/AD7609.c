@@ -26,6 +26,7 @@
 #include "state/runtime/BoardRuntimeConfig.h"
 #include "HAL/ADC.h"
 #include "Util/Logger.h"
+#include "Util/AD7609Unpack.h"
 #include "system/cache/sys_cache.h"
 #include "FreeRTOS.h"
 #include "task.h"
@@ -49,33 +50,6 @@ static void AD7609_Delay_ms(uint32_t milliseconds) {
 //! SPI timeout in iterations (approximately 100k iterations = ~10ms at 200MHz)
 #define AD7609_SPI_TIMEOUT 100000
 
-/**
- * @brief Extract 18-bit value from big-endian bitstream
- *
- * Optimized for AD7609: No bounds checking needed. Buffer is 19 bytes (18 data + 1 padding)
- * to allow 4-byte window loads for all channels (0-7) without bounds checking overhead.
- * Valid bit positions: 0, 18, 36, 54, 72, 90, 108, 126 (hwChannel validated in caller).
- *
- * @param buf Pointer to 19-byte buffer (18 data + 1 padding)
- * @param bitPos Bit position in stream (0-126 for channels 0-7)
- * @return Extracted 18-bit value
- */
-static uint32_t AD7609_Extract18Bit(const uint8_t* buf, uint16_t bitPos) {
-    // Calculate byte index and bit offset
-    size_t byteIndex = bitPos >> 3;  // bitPos / 8
-    uint8_t bitInByte = (uint8_t)(bitPos & 0x7U);  // bitPos % 8
-
-    // Load 32-bit window from buffer (big-endian, MSB first)
-    // Channel 7 (bit 126) loads buf[15..18] - all within 19-byte buffer
-    uint32_t window = ((uint32_t)buf[byteIndex]     << 24) |
-                      ((uint32_t)buf[byteIndex + 1U] << 16) |
-                      ((uint32_t)buf[byteIndex + 2U] << 8)  |
-                      ((uint32_t)buf[byteIndex + 3U]);
-
-    // Shift to align 18-bit field at top of window, then shift down and mask
-    return ((window << bitInByte) >> (32 - 18)) & 0x3FFFFU;
-}
-
 //! BSY pin settling timeout
 //! Datasheet: BSY deasserts typically <10us after conversion/read complete
 //! Timeout: 10x datasheet spec = 100us for safety margin
@@ -130,10 +104,34 @@ static void AD7609_Unlock(const AD7609ModuleConfig* config, bool csAsserted)
 }
 
 // DMA-coherent SPI buffers (must be global for cache coherency)
-// RX buffer is 19 bytes (18 data + 1 padding) to allow window-loading for channel 7
-// without bounds checking overhead. AD7609 sends 144 bits (18 bytes) of data.
-static __attribute__((coherent)) uint8_t gAD7609_txBuffer[18];
-static __attribute__((coherent)) uint8_t gAD7609_rxBuffer[19];
+// AD7609 sends 144 bits (18 bytes) of data. RX is word-aligned for the
+// word-at-a-time unpacker (Util/AD7609Unpack.c).
+static __attribute__((coherent)) uint8_t gAD7609_txBuffer[AD7609_BUFFER_BYTES];
+static __attribute__((coherent, aligned(4))) uint8_t gAD7609_rxBuffer[AD7609_BUFFER_BYTES];
+
+// Every AD7609 entry of the board channel table, in table order. The table
+// is const, so this is built once; each read only filters it by IsEnabled.
+static AD7609SlotMap_t gAD7609_BoardMap;
+static bool gAD7609_BoardMapBuilt = false;
+
+static void AD7609_BuildBoardMap(const AInArray* channelConfigList)
+{
+    AD7609SlotMap_Reset(&gAD7609_BoardMap);
+    for (size_t i = 0; i < channelConfigList->Size; i++) {
+        const AInChannel* ch = &channelConfigList->Data[i];
+        if (ch->Type != AIn_AD7609) {
+            continue;
+        }
+        // Out-of-range ChannelNumber (or a ninth entry) is skipped, as the
+        // per-read validation used to.
+        if (!AD7609SlotMap_Add(&gAD7609_BoardMap, ch->Config.AD7609.ChannelNumber,
+                               (uint8_t)i, ch->DaqifiAdcChannelId)) {
+            LOG_E("AD7609: channel table entry %u skipped (hw %u)",
+                  (unsigned)i, (unsigned)ch->Config.AD7609.ChannelNumber);
+        }
+    }
+    gAD7609_BoardMapBuilt = true;
+}
 
 // Accessor function for task handle (used by tasks.c)
 volatile void* AD7609_GetTaskHandle(void) {
@@ -332,10 +330,10 @@ bool AD7609_WriteStateAll(void) {
     return true;
 }
 
-bool AD7609_ReadSamples(AInSampleArray* samples,
+bool AD7609_ReadSamples(AD7609SlotMap_t* pMap,
+                        uint32_t* values,
                         const AInArray* channelConfigList,
-                        AInRuntimeArray* channelRuntimeConfigList,
-                        uint32_t triggerTimeStamp)
+                        const AInRuntimeArray* channelRuntimeConfigList)
 {
     if (pModuleConfigAD7609 == NULL || spi_handle == DRV_HANDLE_INVALID) {
         LOG_E("AD7609_ReadSamples: not initialized");
@@ -426,51 +424,20 @@ read_cleanup:
 
     // AD7609 sends data in serial mode: 18 bits per channel, 8 channels sequentially
     // Total: 144 bits (18 bytes) in continuous stream, MSB first per channel
-
-    // Treat samples->Size as capacity (maximum samples buffer can hold)
-    size_t capacity = samples->Size;
-    size_t sampleCount = 0;
-
-    for (size_t i = 0; i < channelConfigList->Size; i++) {
-        if (channelConfigList->Data[i].Type == AIn_AD7609 &&
-            channelRuntimeConfigList->Data[i].IsEnabled) {
-
-            // Get the hardware channel number from config
-            uint8_t hwChannel = channelConfigList->Data[i].Config.AD7609.ChannelNumber;
-
-            // Validate hardware channel is in range
-            if (hwChannel >= AD7609_NUM_CHANNELS) {
-                continue; // Skip invalid channels
-            }
-
-            // Calculate bit position in the bitstream
-            uint16_t bitPosition = hwChannel * AD7609_BITS_PER_CHANNEL;
-
-            // Extract 18-bit value (no bounds checking needed - buffer is fixed size)
-            uint32_t tmpData = AD7609_Extract18Bit(gAD7609_rxBuffer, bitPosition);
-
-            // Convert from 18-bit 2's complement to signed 32-bit
-            if (tmpData & AD7609_SIGN_BIT) {
-                tmpData |= AD7609_SIGN_EXTEND;  // Sign extend
-            }
-
-            // Create sample entry with DAQiFi channel ID (check capacity, not current size)
-            if (sampleCount < capacity) {
-                samples->Data[sampleCount].Channel = channelConfigList->Data[i].DaqifiAdcChannelId;
-                samples->Data[sampleCount].Value = (int32_t)tmpData;
-                samples->Data[sampleCount].Timestamp = triggerTimeStamp;
-                sampleCount++;
-            } else {
-                LOG_E("AD7609_ExtractSamples: Sample buffer full (capacity=%u)", capacity);
-                break;  // Stop processing if buffer is full
-            }
+    if (!gAD7609_BoardMapBuilt) {
+        AD7609_BuildBoardMap(channelConfigList);
+    }
+    AD7609SlotMap_Reset(pMap);
+    for (uint8_t j = 0; j < gAD7609_BoardMap.count; j++) {
+        if (channelRuntimeConfigList->Data[gAD7609_BoardMap.slot[j]].IsEnabled) {
+            (void)AD7609SlotMap_Add(pMap, gAD7609_BoardMap.hw[j],
+                                    gAD7609_BoardMap.slot[j],
+                                    gAD7609_BoardMap.channelId[j]);
         }
     }
+    AD7609Unpack_Packed(gAD7609_rxBuffer, pMap, values);
 
-    // Update Size to reflect actual number of samples written
-    samples->Size = sampleCount;
-    
-    return (sampleCount > 0); // Return true if we got any samples
+    return (pMap->count > 0); // Return true if we got any samples
 }
 
 bool AD7609_TriggerConversion(const AD7609ModuleConfig* moduleConfig)
@@ -551,4 +518,25 @@ double AD7609_ConvertToVoltage(
     // Convert to voltage: raw / maxCode * fullScale
     double voltage = ((double)signedValue / (double)maxCode) * fullScaleVoltage;
     return voltage;
+}
+
+uint32_t AD7609_GetLinearConversion(
+                        const AInRuntimeConfig* runtimeConfig,
+                        double* pGain,
+                        double* pOffset)
+{
+    UNUSED(runtimeConfig);
+
+    // Same range lookup and scaling as AD7609_ConvertToVoltage; keep the two
+    // in step.
+    AInModRuntimeArray* pRuntimeModules = BoardRunTimeConfig_Get(BOARDRUNTIMECONFIG_AIN_MODULES);
+    double fullScaleVoltage = 10.0;
+
+    if (pRuntimeModules != NULL && pRuntimeModules->Size > AIn_AD7609) {
+        fullScaleVoltage = pRuntimeModules->Data[AIn_AD7609].Range;
+    }
+
+    *pGain = fullScaleVoltage / (double)AD7609_MAX_VALUE;
+    *pOffset = 0.0;
+    return AD7609_SIGN_BIT;
 }
\ No newline at end of file
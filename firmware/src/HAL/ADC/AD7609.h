@@ -8,6 +8,7 @@
 #include "state/board/AInConfig.h"
 #include "state/runtime/AInRuntimeConfig.h"
 #include "state/data/AInSample.h"
+#include "Util/AD7609Unpack.h"
 
 
 #ifdef	__cplusplus
@@ -56,16 +57,18 @@ bool AD7609_WriteStateAll(void);
 
     
 /*!
- * Populates the sample array using data in the board config
- * @param[in/out] samples The array to populate
+ * Reads the latest conversion and unpacks the enabled channels
+ * @param[out] pMap The enabled AD7609 channels, in board-config order, with
+ *                  their LATEST slots and DAQiFi channel IDs
+ * @param[out] values pMap->count sign-extended 18-bit codes, in pMap order
  * @param channelConfig The static channel configuration for the board
  * @param channelRuntimeConfig The runtime channel configuration for the board
- * @param triggerTimeStamp The timestamp when the module was most recently triggered to convert
+ * @return true if at least one enabled channel was read
  */
-bool AD7609_ReadSamples(AInSampleArray* samples,                            \
+bool AD7609_ReadSamples(AD7609SlotMap_t* pMap,                              \
+                        uint32_t* values,                                   \
                         const AInArray* channelConfigList,                  \
-                        AInRuntimeArray* channelRuntimeConfigList,          \
-                        uint32_t triggerTimeStamp);
+                        const AInRuntimeArray* channelRuntimeConfigList);
     
 /*!
  * Triggers a conversion
@@ -85,6 +88,20 @@ double AD7609_ConvertToVoltage(
                         const AInRuntimeConfig* runtimeConfig,
                         uint32_t rawValue);
 
+/*!
+ * The conversion above as volts = code * gain + offset over the sign-extended
+ * 18-bit code, for callers that precompute it per session (see
+ * ADC_GetLinearConversionByIndex).
+ * @param[in] runtimeConfig Runtime channel information (unused, as above)
+ * @param[out] pGain Volts per code
+ * @param[out] pOffset Volts added after scaling (always 0: no CalB applied)
+ * @return The largest code magnitude (the most negative code, 2^17)
+ */
+uint32_t AD7609_GetLinearConversion(
+                        const AInRuntimeConfig* runtimeConfig,
+                        double* pGain,
+                        double* pOffset);
+
 /*!
  * AD7609 deferred interrupt task (handles SPI read after BSY interrupt)
  * This function is called by FreeRTOS task scheduler
@@ -68,6 +68,11 @@ typedef struct {
 
 static ThreshUnit gUnits[ADC_THRESHOLD_UNITS];
 
+/* Trips of any unit since boot, for the capture trigger. Never reset (Clear
+ * zeroes tripCount), so a reader's snapshot only ever sees new trips; the six
+ * DC ISRs share IPL3, so they serialize and the ISR is the sole writer. */
+static volatile uint32_t gTripSeq;
+
 static SemaphoreHandle_t gMutex;
 static StaticSemaphore_t gMutexBuf;
 
@@ -290,6 +295,22 @@ void AdcThreshold_Clear(uint8_t chId) {
     xSemaphoreGive(thr_Mutex());
 }
 
+void AdcThreshold_Rearm(void) {
+    xSemaphoreTake(thr_Mutex(), portMAX_DELAY);
+    for (uint8_t u = 0; u < ADC_THRESHOLD_UNITS; u++) {
+        if (!gUnits[u].inUse) { continue; }
+        thr_IntDisable(u);
+        (void)*(gRegs[u].con);  /* same stale-DCMPED rule as Clear */
+        thr_IntClearFlag(u);
+        thr_IntEnable(u);
+    }
+    xSemaphoreGive(thr_Mutex());
+}
+
+uint32_t AdcThreshold_TripSeq(void) {
+    return gTripSeq;
+}
+
 bool AdcThreshold_AnyLatched(void) {
     /* Lock-free read: each latched flag is a bool written only by its ISR; a
      * stale miss is corrected on the next SyncQuesBits. */
@@ -330,6 +351,7 @@ void AdcThreshold_IsrTrip(uint8_t unit) {
     thr_IntClearFlag(unit);
     gUnits[unit].tripCount++;          /* ISR is the sole writer of this field */
     gUnits[unit].latched = true;
+    gTripSeq++;
     /* Latch-and-mask. The comparator is LEVEL-evaluated: a signal parked past the
      * limit (exactly the alarm condition) re-asserts DCMPED on every conversion,
      * so leaving the IRQ enabled is an IPL3 ISR storm (up to the streaming rate)
@@ -81,6 +81,15 @@ bool AdcThreshold_Query(uint8_t chId, AdcThresholdMode* mode,
  *  @p chId == ADC_THRESHOLD_ALL_CH. The comparator keeps monitoring. */
 void AdcThreshold_Clear(uint8_t chId);
 
+/** Re-enable the interrupt of every configured unit WITHOUT clearing its latch or
+ *  trip counter, so a unit that tripped (and masked itself) fires again. Used by
+ *  the streaming capture trigger when a capture is armed. Task context. */
+void AdcThreshold_Rearm(void);
+
+/** Trips of any unit since boot (wraps; never reset by Clear). A change between
+ *  two reads means a comparator fired in between. Lock-free, any context. */
+uint32_t AdcThreshold_TripSeq(void);
+
 /** True if any configured threshold has latched a trip since its last Clear.
  *  Task context; SCPI_SyncQuesBits derives the QUES analog-limit bit from this. */
 bool AdcThreshold_AnyLatched(void);
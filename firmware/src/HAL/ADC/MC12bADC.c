@@ -12,6 +12,7 @@
 #include "state/board/BoardConfig.h"
 #include "state/runtime/BoardRuntimeConfig.h"
 #include "Util/Logger.h"
+#include "Util/ScanDma.h"
 
 //#define UNUSED(x) (void)(x)
 #define UNUSED(identifier) /* identifier */
@@ -258,7 +259,128 @@ double MC12b_ConvertToVoltage(
             (gpModuleConfigMC12->Resolution) + runtimeConfig->CalB;
 }
 
+uint32_t MC12b_GetLinearConversion(
+        const MC12bChannelConfig* channelConfig,
+        const AInRuntimeConfig* runtimeConfig,
+        double* pGain,
+        double* pOffset) {
+
+    // Same terms as MC12b_ConvertToVoltage; keep the two in step.
+    double range = gpModuleRuntimeConfigMC12->Range;
+    double scale = channelConfig->InternalScale;
+    double CalM = runtimeConfig->CalM;
+
+    *pGain = (range * scale * CalM) / (gpModuleConfigMC12->Resolution);
+    *pOffset = runtimeConfig->CalB;
+    return gpModuleConfigMC12->Resolution - 1u;
+}
+
+// --- Scan DMA readout (CONF:ADC:SCAN:DMA) — see Util/ScanDma.h ----------
+//
+// DCH4 (DMAC channels 0-3 belong to the Harmony drivers) is started by the
+// ADC EOS interrupt flag and copies ADCDATA[firstAn..lastAn] into one half
+// of gScanDmaBuf. The EOS CPU interrupt and the data-ready interrupts of
+// the scanned inputs are gated off for the session; DMA4_Handler stands in
+// for ADC_EOS_Handler, so the scan costs one interrupt instead of
+// nUserT2 + 1. Reading ADCDATAx clears its ARDY, exactly as the ISR reads
+// it did. The channel is re-enabled from its block-complete interrupt
+// (priority 3, same as EOS), which lands ~1 us after the scan — far inside
+// the next scan's >= 11 us; a scan that ends before the re-enable is not
+// copied and shows up as a missed EOS in the #557 drop accounting.
+#define SCAN_DMA_PRIORITY   3u
+
+static bool gScanDmaEnabled = false;            // CONF:ADC:SCAN:DMA
+static volatile bool gScanDmaActive = false;    // armed for this session
+static ScanDma_t gScanDma;
+static uint32_t gSavedGirqEn1, gSavedGirqEn2;
+static volatile uint32_t __attribute__((coherent, aligned(16)))
+        gScanDmaBuf[2][SCAN_DMA_MAX_WORDS];
+
+bool MC12b_SetScanDma(bool enable) {
+    if (enable && !MC12B_SCAN_DMA_VECTOR) {
+        return false;
+    }
+    gScanDmaEnabled = enable;
+    return true;
+}
+
+bool MC12b_GetScanDma(void) { return gScanDmaEnabled; }
+
+bool MC12b_IsScanDmaActive(void) { return gScanDmaActive; }
+
+bool MC12b_StartScanDma(uint32_t css1, uint32_t css2) {
+    ScanLayout_t layout;
+    if (!MC12B_SCAN_DMA_VECTOR || !gScanDmaEnabled || gScanDmaActive ||
+        !ScanLayout_Build(&layout, css1, css2)) {
+        return false;
+    }
+    ScanDma_Init(&gScanDma, &layout, gScanDmaBuf[0], gScanDmaBuf[1]);
+
+    uint32_t bytes = (uint32_t)layout.words * sizeof(uint32_t);
+    DCH4CONCLR = _DCH4CON_CHEN_MASK;
+    DCH4CON = 0;                                    // CHPRI 0, no auto-enable
+    DCH4ECON = ((uint32_t)_ADC_EOS_VECTOR << _DCH4ECON_CHSIRQ_POSITION)
+             | _DCH4ECON_SIRQEN_MASK;
+    DCH4SSA = KVA_TO_PA(&ADCDATA0 + layout.firstAn);
+    DCH4DSA = KVA_TO_PA(ScanDma_Target(&gScanDma));
+    DCH4SSIZ = bytes;
+    DCH4DSIZ = bytes;
+    DCH4CSIZ = bytes;                               // whole span per EOS
+    DCH4INT = _DCH4INT_CHBCIE_MASK;                 // flags cleared too
+    IPC34bits.DMA4IP = SCAN_DMA_PRIORITY;
+    IPC34bits.DMA4IS = 0;
+    IFS4CLR = _IFS4_DMA4IF_MASK;
+    IEC4SET = _IEC4_DMA4IE_MASK;
+
+    gSavedGirqEn1 = ADCGIRQEN1;
+    gSavedGirqEn2 = ADCGIRQEN2;
+    ADCGIRQEN1 = gSavedGirqEn1 & ~css1;
+    ADCGIRQEN2 = gSavedGirqEn2 & ~css2;
+    IEC6CLR = _IEC6_ADCEOSIE_MASK;
+    (void)ADCCON2;                                  // EOSRDY clears on read
+    IFS6CLR = _IFS6_ADCEOSIF_MASK;                  // next EOS is a fresh edge
+    gScanDmaActive = true;
+    DCH4CONSET = _DCH4CON_CHEN_MASK;
+    return true;
+}
+
+void MC12b_StopScanDma(void) {
+    if (!gScanDmaActive) return;
+    IEC4CLR = _IEC4_DMA4IE_MASK;
+    DCH4ECONSET = _DCH4ECON_CABORT_MASK;
+    DCH4CONCLR = _DCH4CON_CHEN_MASK;
+    DCH4INTCLR = 0xFFu;
+    IFS4CLR = _IFS4_DMA4IF_MASK;
+    // Readers fall back to the result SFRs before the ISRs come back.
+    gScanDmaActive = false;
+    ADCGIRQEN1 = gSavedGirqEn1;
+    ADCGIRQEN2 = gSavedGirqEn2;
+    (void)ADCCON2;
+    IFS6CLR = _IFS6_ADCEOSIF_MASK;
+    IEC6SET = _IEC6_ADCEOSIE_MASK;
+}
+
+bool MC12b_ScanDmaIsr(void) {
+    uint32_t flags = DCH4INT;
+    DCH4INTCLR = flags & 0xFFu;
+    IFS4CLR = _IFS4_DMA4IF_MASK;
+    if (!gScanDmaActive || (flags & _DCH4INT_CHBCIF_MASK) == 0u) {
+        return false;
+    }
+    // What ADC_EOS_InterruptHandler does for the interrupt it replaces.
+    (void)ADCCON2;
+    IFS6CLR = _IFS6_ADCEOSIF_MASK;
+    DCH4DSA = KVA_TO_PA(ScanDma_Complete(&gScanDma));
+    DCH4CONSET = _DCH4CON_CHEN_MASK;
+    return true;
+}
+
 bool MC12b_ReadResult(ADCHS_CHANNEL_NUM channel, uint32_t *pVal) {
+    if (gScanDmaActive && ScanLayout_Contains(&gScanDma.layout, channel)) {
+        // Newest completed scan; stays readable until the next one lands,
+        // where ARDY would have read "not ready" after the first read.
+        return ScanDma_Read(&gScanDma, channel, pVal);
+    }
     if (ADCHS_ChannelResultIsReady(channel)) {
         *pVal = ADCHS_ChannelResultGet(channel);
         return true;
@@ -291,8 +413,8 @@ bool MC12b_ReadResult(ADCHS_CHANNEL_NUM channel, uint32_t *pVal) {
 // Erratum 18 (DS80000663R): the internal temperature sensor (AN44) is
 // nonfunctional on all silicon revs, no workaround.  It is never included
 // in any scan list — the boot CSS wasted a full SAMC+conversion slot per
-// scan reading dead silicon.
-#define ADC_AN_TEMP_SENSOR  44u
+// scan reading dead silicon.  The per-input rule (ScanList_Includes) is in
+// Util/ScanDma.c so the host tests can replay it against the board maps.
 
 uint32_t MC12b_ComputeScanList(bool enabledOnly, bool includeMonitoring,
                                uint32_t *pCss1, uint32_t *pCss2) {
@@ -307,23 +429,14 @@ uint32_t MC12b_ComputeScanList(bool enabledOnly, bool includeMonitoring,
     for (size_t i = 0; i < n; i++) {
         const AInChannel* ch = &pCfg->AInChannels.Data[i];
         if (ch->Type != AIn_MC12bADC) continue;
-        if (ch->Config.MC12b.ChannelType == 1) continue;  // dedicated, never scanned
-        uint32_t an = ch->Config.MC12b.ChannelId;          // CSS bit == AN number
-        if (an == ADC_AN_TEMP_SENSOR) continue;            // erratum 18
-        if (an >= 64u) continue;  // defensive: beyond ADCCSS1/2 bit range
-                                  // (hardware max is AN44; a corrupted config
-                                  // entry must not shift out of range)
-        bool isMonitoring = (ch->Config.MC12b.IsPublic != 1);
-        if (isMonitoring) {
-            if (!includeMonitoring) continue;
-            // Monitoring channels are not user-controllable; IsEnabled is
-            // the boot default (true except the dead temp sensor).
-            if (pRt->Data[i].IsEnabled != 1) continue;
-        } else if (enabledOnly && pRt->Data[i].IsEnabled != 1) {
-            continue;
-        }
-        if (an < 32u) css1 |= (1U << an);
-        else          css2 |= (1U << (an - 32u));
+        ScanListInput_t in = {
+            .an = ch->Config.MC12b.ChannelId,               // CSS bit == AN number
+            .dedicated = (ch->Config.MC12b.ChannelType == 1),
+            .monitoring = (ch->Config.MC12b.IsPublic != 1),
+            .enabled = (pRt->Data[i].IsEnabled == 1),
+        };
+        if (!ScanList_Includes(&in, enabledOnly, includeMonitoring)) continue;
+        ScanList_Add(&css1, &css2, in.an);
         count++;
     }
     if (pCss1 != NULL) *pCss1 = css1;
@@ -83,6 +83,21 @@ double MC12b_ConvertToVoltage(
                         const MC12bChannelConfig* channelConfig,
                         const AInRuntimeConfig* runtimeConfig,
                         uint32_t rawValue);
+
+/**
+ * The conversion above as volts = code * gain + offset, for callers that
+ * precompute it per session (see ADC_GetLinearConversionByIndex).
+ * @param[in] channelConfig Information about the channel
+ * @param[in] runtimeConfig Runtime channel information
+ * @param[out] pGain Volts per code
+ * @param[out] pOffset Volts added after scaling (CalB)
+ * @return The largest code the module produces
+ */
+uint32_t MC12b_GetLinearConversion(
+                        const MC12bChannelConfig* channelConfig,
+                        const AInRuntimeConfig* runtimeConfig,
+                        double* pGain,
+                        double* pOffset);
 bool MC12b_ReadResult(ADCHS_CHANNEL_NUM channel, uint32_t *pVal);
 
 /**
@@ -115,6 +130,51 @@ void MC12b_ApplyScanList(uint32_t css1, uint32_t css2);
 /** #541 D-B: restore the idle scan list (all public T2 + enabled monitoring). */
 void MC12b_RestoreIdleScanList(void);
 
+/**
+ * Build flag for the scan DMA readout. Its block-complete interrupt (DMA4,
+ * vector 138) must be dispatched through a portSAVE_CONTEXT wrapper in
+ * config/default/interrupts_a.S -- IntVectorDMA4_Handler calling
+ * DMA4_Handler, the same shape as DMA3's -- and that file is MCC-generated
+ * and not tracked (firmware/.gitignore ignores *.S). A build whose
+ * interrupts_a.S carries the wrapper defines this to 1; without it the
+ * vector is not dispatched, so the readout is compiled out of use.
+ */
+#ifndef MC12B_SCAN_DMA_VECTOR
+#define MC12B_SCAN_DMA_VECTOR 0
+#endif
+
+/**
+ * CONF:ADC:SCAN:DMA — read the shared scan through DMA into RAM instead of
+ * per-input data-ready ISRs (see Util/ScanDma.h). Latched by the next
+ * MC12b_StartScanDma; the SCPI layer rejects changes while streaming.
+ * Default off.
+ * @return false if @p enable asks for it in a build without
+ *         MC12B_SCAN_DMA_VECTOR (the setting stays off)
+ */
+bool MC12b_SetScanDma(bool enable);
+bool MC12b_GetScanDma(void);
+
+/** True while a session's scan is read by DMA (MC12b_ReadResult uses RAM). */
+bool MC12b_IsScanDmaActive(void);
+
+/**
+ * Arm the DMA readout for a session scan list already applied with
+ * MC12b_ApplyScanList: gates the EOS and scanned-input data-ready CPU
+ * interrupts and starts DCH4 on the EOS flag.
+ * @return false when scan DMA is off or not built in, or the list is empty
+ *         (ISRs stay)
+ */
+bool MC12b_StartScanDma(uint32_t css1, uint32_t css2);
+
+/** Stop the DMA readout and restore the interrupts it gated. No-op if idle. */
+void MC12b_StopScanDma(void);
+
+/**
+ * DMA4 interrupt body: acknowledge, publish the completed half and re-arm.
+ * @return true when a scan completed (caller runs the EOS callback)
+ */
+bool MC12b_ScanDmaIsr(void);
+
 /**
  * #541 D-C: max safe scan trigger rate (Hz) — min of the scan-busy bound
  * (nActive-input scan time from live SAMC / clock-divider registers), the
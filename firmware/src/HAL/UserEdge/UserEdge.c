@@ -136,6 +136,10 @@ static volatile uint8_t     gFifoHead;    /* next push slot */
 static volatile uint8_t     gFifoTail;    /* next pop slot  */
 static volatile uint32_t    gFifoDropped;
 
+/* Events on any pin since boot, for the capture trigger. Never reset (a re-arm
+ * zeroes the per-pin count); the INT ISRs share one priority, so single writer. */
+static volatile uint32_t    gEventSeq;
+
 static uint32_t gStormWindowTicks = 126000u;   /* 1 ms @ 126 MHz core timer */
 
 static SemaphoreHandle_t gMutex;
@@ -711,6 +715,7 @@ void UserEdge_IsrEvent(uint8_t unit) {
 
     edge_FifoPush(gIntState[unit].dio, ts, edge);
     gIntState[unit].count++;   /* ISRs serialized by equal priority -> single writer */
+    gEventSeq++;
 
     if (mode == (uint8_t)USER_EDGE_BOTH) {
         /* Retarget the opposite edge: disable -> flip EP -> read-back (retire the
@@ -738,6 +743,10 @@ void UserEdge_IsrEvent(uint8_t unit) {
     }
 }
 
+uint32_t UserEdge_EventSeq(void) {
+    return gEventSeq;
+}
+
 void UserEdge_IsrCounterRollover(uint8_t unit) {
     if (unit >= USER_EDGE_CTR_UNITS) { return; }
     gCtrState[unit].high++;           /* sole writer (rollover interrupt) */
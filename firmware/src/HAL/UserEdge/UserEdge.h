@@ -93,6 +93,11 @@ int8_t UserEdge_EventMode(uint8_t dio);
  *  active event pin), for DIO:EVENt:COUNt?. */
 uint64_t UserEdge_EventCount(uint8_t dio);
 
+/** Edge events on any armed pin since boot (wraps; never reset by a re-arm). A
+ *  change between two reads means an edge fired in between, for the streaming
+ *  capture trigger. Lock-free, any context. */
+uint32_t UserEdge_EventSeq(void);
+
 /**
  * Pop the oldest event from the shared FIFO into @p dio / @p ts / @p edge
  * (edge: 1 = rising, 0 = falling; @p ts is the streaming timebase count). @p dropped
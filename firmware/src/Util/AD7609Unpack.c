@@ -0,0 +1,65 @@
+#include "AD7609Unpack.h"
+#include <string.h>
+
+/* Bits dropped by the arithmetic shift that brings a field down from the
+ * top of a word: 32 - 18. */
+#define AD7609_FIELD_SHIFT      14
+
+static inline uint32_t AD7609Unpack_LoadBE32(const uint8_t* p) {
+    uint32_t w;
+    memcpy(&w, __builtin_assume_aligned(p, 4), sizeof(w));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    w = __builtin_bswap32(w);
+#endif
+    return w;
+}
+
+/* Arithmetic right shift of a negative int32 is GCC/XC32-defined (sign
+ * fill); that is the sign extension. */
+static inline int32_t AD7609Unpack_Field(uint32_t top) {
+    return (int32_t)top >> AD7609_FIELD_SHIFT;
+}
+
+void AD7609SlotMap_Reset(AD7609SlotMap_t* map) {
+    memset(map, 0, sizeof(*map));
+}
+
+bool AD7609SlotMap_Add(AD7609SlotMap_t* map, uint8_t hw, uint8_t slot,
+                       uint8_t channelId) {
+    if (hw >= AD7609_FRAME_CHANNELS || map->count >= AD7609_FRAME_CHANNELS) {
+        return false;
+    }
+    map->hw[map->count] = hw;
+    map->slot[map->count] = slot;
+    map->channelId[map->count] = channelId;
+    map->count++;
+    return true;
+}
+
+void AD7609Unpack_Frame(const uint8_t* frame, int32_t out[AD7609_FRAME_CHANNELS]) {
+    const uint32_t w0 = AD7609Unpack_LoadBE32(frame);
+    const uint32_t w1 = AD7609Unpack_LoadBE32(frame + 4);
+    const uint32_t w2 = AD7609Unpack_LoadBE32(frame + 8);
+    const uint32_t w3 = AD7609Unpack_LoadBE32(frame + 12);
+    const uint32_t w4 = ((uint32_t)frame[16] << 24) | ((uint32_t)frame[17] << 16);
+
+    /* Channel k starts at stream bit 18k: word 18k / 32, bit 18k % 32. */
+    out[0] = AD7609Unpack_Field(w0);                        /* bit   0 */
+    out[1] = AD7609Unpack_Field((w0 << 18) | (w1 >> 14));   /* bit  18 */
+    out[2] = AD7609Unpack_Field(w1 << 4);                   /* bit  36 */
+    out[3] = AD7609Unpack_Field((w1 << 22) | (w2 >> 10));   /* bit  54 */
+    out[4] = AD7609Unpack_Field(w2 << 8);                   /* bit  72 */
+    out[5] = AD7609Unpack_Field((w2 << 26) | (w3 >> 6));    /* bit  90 */
+    out[6] = AD7609Unpack_Field(w3 << 12);                  /* bit 108 */
+    out[7] = AD7609Unpack_Field((w3 << 30) | (w4 >> 2));    /* bit 126 */
+}
+
+void AD7609Unpack_Packed(const uint8_t* frame, const AD7609SlotMap_t* map,
+                         uint32_t* values) {
+    int32_t all[AD7609_FRAME_CHANNELS];
+    AD7609Unpack_Frame(frame, all);
+    const uint32_t count = map->count;
+    for (uint32_t j = 0; j < count; j++) {
+        values[j] = (uint32_t)all[map->hw[j]];
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * AD7609 Unpack — the 144-bit serial frame to eight sign-extended codes
+ *
+ * The AD7609 shifts out its eight 18-bit two's-complement results back to
+ * back, MSB first: channel k occupies stream bits 18k..18k+17. The old
+ * reader pulled a 4-byte window per enabled channel, shifted and masked it,
+ * then sign-extended with a branch. Here the frame is loaded once as four
+ * big-endian words plus the trailing 16 bits, and every field is moved to
+ * the top of a 32-bit word with constant shifts and brought down with one
+ * arithmetic right shift, which sign-extends it -- eight fixed,
+ * branch-free extractions whatever the channel set.
+ *
+ * The frame buffer is the SPI DMA target, which is uncached on the PIC32MZ
+ * (coherent), so the five word loads also replace up to 32 uncached byte
+ * reads.
+ *
+ * Which channels a read returns, and where each one goes, is an
+ * AD7609SlotMap_t: packed index j -> hardware channel, board-config slot
+ * (the BOARDDATA_AIN_LATEST index) and DaqifiAdcChannelId. AD7609.c builds
+ * the board's map once and filters it by IsEnabled per read, so neither the
+ * read nor the LATEST store searches the channel table.
+ *
+ * THREAD-SAFETY: pure functions over caller-owned data.
+ */
+
+#define AD7609_FRAME_CHANNELS   8u      /* AD7609_NUM_CHANNELS */
+#define AD7609_FRAME_BYTES      18u     /* AD7609_BUFFER_BYTES: 8 x 18 bits */
+
+typedef struct {
+    uint8_t count;
+    uint8_t hw[AD7609_FRAME_CHANNELS];          /* packed j -> ChannelNumber */
+    uint8_t slot[AD7609_FRAME_CHANNELS];        /* packed j -> board-config index */
+    uint8_t channelId[AD7609_FRAME_CHANNELS];   /* packed j -> DaqifiAdcChannelId */
+} AD7609SlotMap_t;
+
+void AD7609SlotMap_Reset(AD7609SlotMap_t* map);
+
+/**
+ * Append a channel at the next packed index.
+ *
+ * @return false when @p hw is not 0-7 or the map is full (map unchanged)
+ */
+bool AD7609SlotMap_Add(AD7609SlotMap_t* map, uint8_t hw, uint8_t slot,
+                       uint8_t channelId);
+
+/**
+ * Unpack all eight channels of @p frame (AD7609_FRAME_BYTES, 4-byte
+ * aligned) into @p out, sign-extended from 18 bits.
+ */
+void AD7609Unpack_Frame(const uint8_t* frame, int32_t out[AD7609_FRAME_CHANNELS]);
+
+/**
+ * Unpack the channels of @p map into @p values[0..map->count-1], in map
+ * order, as the sign-extended codes the LATEST cache stores.
+ */
+void AD7609Unpack_Packed(const uint8_t* frame, const AD7609SlotMap_t* map,
+                         uint32_t* values);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,170 @@
+#include "AcqPlan.h"
+#include <string.h>
+
+/* Sign bit flip: maps two's-complement order onto unsigned order. */
+#define ACQ_SIGN_BIAS           0x80000000u
+
+// Sine wave period for test pattern 6: 256 samples per cycle.
+// Integer-only implementation via Q0.16 lookup table —
+// eliminates FPU usage in the deferred task so context switches
+// don't pay FPU save/restore cost. Table: (sin(i*2π/256)+1)*0.5 scaled
+// to [0,65535]. Runtime scaling: (lut[phase] * adcMax) >> 16 is one
+// 32-bit multiply + shift, no FPU.
+#define SINE_PERIOD 256
+static const uint16_t kSineLutQ16[SINE_PERIOD] = {
+    32768, 33572, 34375, 35178, 35979, 36779, 37575, 38369,
+    39160, 39947, 40729, 41507, 42279, 43046, 43807, 44560,
+    45307, 46046, 46777, 47500, 48214, 48919, 49613, 50298,
+    50972, 51635, 52287, 52927, 53555, 54170, 54773, 55362,
+    55938, 56499, 57047, 57579, 58097, 58600, 59087, 59558,
+    60013, 60451, 60873, 61278, 61666, 62036, 62389, 62724,
+    63041, 63339, 63620, 63881, 64124, 64348, 64553, 64739,
+    64905, 65053, 65180, 65289, 65377, 65446, 65496, 65525,
+    65535, 65525, 65496, 65446, 65377, 65289, 65180, 65053,
+    64905, 64739, 64553, 64348, 64124, 63881, 63620, 63339,
+    63041, 62724, 62389, 62036, 61666, 61278, 60873, 60451,
+    60013, 59558, 59087, 58600, 58097, 57579, 57047, 56499,
+    55938, 55362, 54773, 54170, 53555, 52927, 52287, 51635,
+    50972, 50298, 49613, 48919, 48214, 47500, 46777, 46046,
+    45307, 44560, 43807, 43046, 42279, 41507, 40729, 39947,
+    39160, 38369, 37575, 36779, 35979, 35178, 34375, 33572,
+    32768, 31963, 31160, 30357, 29556, 28756, 27960, 27166,
+    26375, 25588, 24806, 24028, 23256, 22489, 21728, 20975,
+    20228, 19489, 18758, 18035, 17321, 16616, 15922, 15237,
+    14563, 13900, 13248, 12608, 11980, 11365, 10762, 10173,
+     9597,  9036,  8488,  7956,  7438,  6935,  6448,  5977,
+     5522,  5084,  4662,  4257,  3869,  3499,  3146,  2811,
+     2494,  2196,  1915,  1654,  1411,  1187,   982,   796,
+      630,   482,   355,   246,   158,    89,    39,    10,
+        0,    10,    39,    89,   158,   246,   355,   482,
+      630,   796,   982,  1187,  1411,  1654,  1915,  2196,
+     2494,  2811,  3146,  3499,  3869,  4257,  4662,  5084,
+     5522,  5977,  6448,  6935,  7438,  7956,  8488,  9036,
+     9597, 10173, 10762, 11365, 11980, 12608, 13248, 13900,
+    14563, 15237, 15922, 16616, 17321, 18035, 18758, 19489,
+    20228, 20975, 21728, 22489, 23256, 24028, 24806, 25588,
+    26375, 27166, 27960, 28756, 29556, 30357, 31160, 31963,
+};
+
+_Static_assert((sizeof(kSineLutQ16) / sizeof(kSineLutQ16[0])) == SINE_PERIOD,
+               "kSineLutQ16 must have exactly SINE_PERIOD entries");
+
+void AcqPlan_Reset(AcqPlan_t* plan) {
+    memset(plan, 0, sizeof(*plan));
+}
+
+bool AcqPlan_Add(AcqPlan_t* plan, AcqOpKind kind, uint8_t slot,
+                 uint8_t hwChannel, uint8_t channelId) {
+    if (plan->count >= ACQ_PLAN_MAX_CHANNELS) {
+        return false;
+    }
+    AcqOp_t* op = &plan->op[plan->count];
+    memset(op, 0, sizeof(*op));
+    op->kind = (uint8_t)kind;
+    op->slot = slot;
+    op->hwChannel = hwChannel;
+    op->channelId = channelId;
+    if (kind == ACQ_OP_AD7609) {
+        /* Sign-extended 18-bit codes (Util/AD7609Unpack.c): the
+         * rails are -131072 and +131071, derived from adcMax so they track
+         * the module's Resolution. 0 is mid-scale here, not a rail. */
+        const int32_t posRail = (int32_t)(ACQ_AD7609_ADC_MAX >> 1);
+        const int32_t negRail = -(int32_t)((ACQ_AD7609_ADC_MAX >> 1) + 1u);
+        op->adcMax = ACQ_AD7609_ADC_MAX;
+        op->railBias = ACQ_SIGN_BIAS;
+        op->railLow = (uint32_t)negRail ^ ACQ_SIGN_BIAS;
+        op->railHigh = (uint32_t)posRail ^ ACQ_SIGN_BIAS;
+    } else {
+        op->adcMax = ACQ_MC12B_ADC_MAX;
+        op->railBias = 0u;
+        op->railLow = 0u;
+        op->railHigh = ACQ_MC12B_ADC_MAX;
+    }
+    if (kind == ACQ_OP_T1_DIRECT) {
+        plan->t1Count++;
+    }
+    plan->count++;
+    return true;
+}
+
+uint32_t AcqPlan_RunHardware(const AcqPlan_t* plan, const AcqPlanIo_t* io,
+                             void* ctx, uint32_t* values, uint32_t* pClipMask) {
+    uint32_t validMask = 0u;
+    uint32_t clipMask = 0u;
+    const uint32_t count = plan->count;
+    for (uint32_t j = 0; j < count; j++) {
+        const AcqOp_t* op = &plan->op[j];
+        uint32_t v;
+        if (op->kind == ACQ_OP_T1_DIRECT) {
+            if (!io->readResult(ctx, op->hwChannel, &v)) {
+                io->t1Miss(ctx, op);
+                continue;
+            }
+            io->storeLatest(ctx, op, v);
+        } else if (!io->readLatest(ctx, op->slot, &v)) {
+            continue;
+        }
+        values[j] = v;
+        validMask |= (1u << j);
+        const uint32_t b = v ^ op->railBias;
+        if (b <= op->railLow || b >= op->railHigh) {
+            clipMask |= (1u << j);
+        }
+    }
+    *pClipMask = clipMask;
+    return validMask;
+}
+
+uint32_t AcqPlan_RunSynthetic(const AcqPlan_t* plan, uint32_t pattern,
+                              uint64_t sampleCount, uint32_t* values,
+                              uint32_t* pClipMask) {
+    uint32_t clipMask = 0u;
+    const uint32_t count = plan->count;
+    for (uint32_t j = 0; j < count; j++) {
+        const AcqOp_t* op = &plan->op[j];
+        /* Generated codes are unsigned whatever the channel (#814). */
+        const uint32_t v = AcqPlan_GenerateTestValue(pattern, op->channelId,
+                                                     sampleCount, op->adcMax);
+        values[j] = v;
+        if (v == 0u || v >= op->adcMax) {
+            clipMask |= (1u << j);
+        }
+    }
+    *pClipMask = clipMask;
+    return (count >= 32u) ? 0xFFFFFFFFu : ((1u << count) - 1u);
+}
+
+uint32_t AcqPlan_GenerateTestValue(uint32_t pattern, uint8_t channel,
+                                   uint64_t sampleCount, uint32_t adcMax) {
+    uint32_t range = adcMax + 1;  // Values from 0 to adcMax inclusive
+    switch (pattern) {
+        case 1:  // Counter: predictable sequence for integrity verification
+            return (uint32_t)((sampleCount + channel) % range);
+        case 2:  // Midscale: constant value for consistent encoding size
+            return adcMax / 2;
+        case 3:  // Fullscale: maximum value for worst-case ProtoBuf size
+            return adcMax;
+        case 4:  // Walking: channel-dependent ramp for visual verification
+            return (uint32_t)(((sampleCount * (channel + 1))) % range);
+        case 5: {  // Triangle: ramps up then down, period = 2*adcMax samples
+            // Phase offset per channel so multi-channel view is staggered
+            uint32_t period = 2 * range;
+            uint32_t pos = (uint32_t)((sampleCount + (uint32_t)channel * (range / 4)) % period);
+            return (pos < range) ? pos : (period - 1 - pos);
+        }
+        case 6: {  // Sine: 256-sample period, integer Q0.16 LUT scaling
+            uint32_t phase = (uint32_t)((sampleCount + (uint32_t)channel * 32) % SINE_PERIOD);
+            /* Scale lut[phase] ∈ [0,65535] to [0,adcMax] with rounding.
+             * Multiply by (adcMax+1) and >>16 maps the full Q0.16 range
+             * (where 65535 represents ~1.0) to [0,adcMax] exactly; add
+             * 0x8000 for round-to-nearest; clamp against the +1 overshoot. */
+            uint64_t scaled =
+                ((uint64_t)kSineLutQ16[phase] * (uint64_t)(adcMax + 1U) + 0x8000ULL) >> 16;
+            if (scaled > adcMax) scaled = adcMax;
+            return (uint32_t)scaled;
+        }
+        default:
+            return 0;
+    }
+}
+
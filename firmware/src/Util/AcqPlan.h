@@ -0,0 +1,125 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Acquisition Plan — the deferred tick task's per-channel work, decided once
+ *
+ * For every channel of every tick the deferred task used to re-derive the
+ * same things from the board config: is this frame synthetic (PIPELINE or a
+ * test pattern), is the channel T1-direct, is it an AD7609 (signed 18-bit)
+ * or an MC12b (unsigned 12-bit) channel, and what are its rail codes.
+ * None of that changes within a session, so Streaming_BuildChannelMapping
+ * now compiles it into a flat array of ops, one per packed channel, next to
+ * the AInChannelMapping:
+ *
+ *   ACQ_OP_T1_DIRECT  ADC result register, gated on its ARDY flag (#541)
+ *   ACQ_OP_LATEST     the BOARDDATA_AIN_LATEST cache slot (#533 ts != 0)
+ *   ACQ_OP_AD7609     the same cache, holding sign-extended 18-bit codes
+ *
+ * and the tick runs them: AcqPlan_RunHardware for a measured frame,
+ * AcqPlan_RunSynthetic (the test-pattern generator over every op) for a
+ * PIPELINE / test-pattern frame. Whether a frame is synthetic is still
+ * decided per frame from the snapshotted mode globals (#814), since SCPI
+ * can change them mid-session.
+ *
+ * Rails (#814) are precomputed per op as a bias and two bounds on the
+ * biased code: an unsigned channel is railed at 0 or at/above full scale,
+ * an AD7609 code at -131072 or +131071, which after flipping the sign bit is
+ * the same unsigned test. Synthetic codes are always unsigned in
+ * [0, adcMax].
+ *
+ * The hardware accesses go through AcqPlanIo_t, so the builder and both
+ * executors run on the host against a fake register file
+ * (tests/host/test_acq_plan.c).
+ *
+ * THREAD-SAFETY: none. The plan is built before the session is enabled and
+ * only read by the deferred task while it runs (same rule as the mapping).
+ */
+
+#define ACQ_PLAN_MAX_CHANNELS   16u     /* MAX_AIN_PUBLIC_CHANNELS */
+
+#define ACQ_MC12B_ADC_MAX       4095u   /* 12-bit MC12bADC */
+#define ACQ_AD7609_ADC_MAX      262143u /* 18-bit AD7609 */
+
+typedef enum {
+    ACQ_OP_LATEST = 0,
+    ACQ_OP_T1_DIRECT,
+    ACQ_OP_AD7609,
+} AcqOpKind;
+
+typedef struct {
+    uint8_t  kind;          /* AcqOpKind */
+    uint8_t  slot;          /* board config index: the LATEST cache slot */
+    uint8_t  hwChannel;     /* ADCHS channel, ACQ_OP_T1_DIRECT only */
+    uint8_t  channelId;     /* DaqifiAdcChannelId: generator seed */
+    uint32_t adcMax;        /* synthetic codes are 0..adcMax */
+    uint32_t railBias;      /* XORed into a measured code before the rail test */
+    uint32_t railLow;       /* biased code <= railLow ... */
+    uint32_t railHigh;      /* ... or >= railHigh is at a rail */
+} AcqOp_t;
+
+typedef struct {
+    AcqOp_t op[ACQ_PLAN_MAX_CHANNELS];
+    uint8_t count;
+    uint8_t t1Count;        /* ACQ_OP_T1_DIRECT ops */
+} AcqPlan_t;
+
+/** The executor's view of the hardware; @p ctx is AcqPlan_RunHardware's. */
+typedef struct {
+    /** ADC result of @p hwChannel if its ARDY is set (the read clears it). */
+    bool (*readResult)(void* ctx, uint8_t hwChannel, uint32_t* pValue);
+    /** LATEST cache value of board channel @p slot; false while invalid. */
+    bool (*readLatest)(void* ctx, uint8_t slot, uint32_t* pValue);
+    /** A T1-direct result was read: refresh the LATEST cache with it. */
+    void (*storeLatest)(void* ctx, const AcqOp_t* op, uint32_t value);
+    /** A T1-direct result was not ready this tick. */
+    void (*t1Miss)(void* ctx, const AcqOp_t* op);
+} AcqPlanIo_t;
+
+void AcqPlan_Reset(AcqPlan_t* plan);
+
+/**
+ * Append the op for the next packed channel, with its range and rails.
+ *
+ * @return false when the plan is full (plan unchanged)
+ */
+bool AcqPlan_Add(AcqPlan_t* plan, AcqOpKind kind, uint8_t slot,
+                 uint8_t hwChannel, uint8_t channelId);
+
+/**
+ * One measured frame: run every op into @p values[0..count-1].
+ *
+ * @param pClipMask  set to the valid channels whose code is at a rail
+ * @return validMask: bit j set when values[j] was written
+ */
+uint32_t AcqPlan_RunHardware(const AcqPlan_t* plan, const AcqPlanIo_t* io,
+                             void* ctx, uint32_t* values, uint32_t* pClipMask);
+
+/**
+ * One synthetic frame (PIPELINE or test pattern @p pattern; 0 generates 0s)
+ * at @p sampleCount. Every channel is valid.
+ */
+uint32_t AcqPlan_RunSynthetic(const AcqPlan_t* plan, uint32_t pattern,
+                              uint64_t sampleCount, uint32_t* values,
+                              uint32_t* pClipMask);
+
+/**
+ * The test-pattern generator (SYST:STR:TEST:PATtern 1-6) for one channel.
+ * Integer-only: pattern 6 scales a Q0.16 sine table, so the deferred task
+ * stays off the FPU.
+ *
+ * @return a code in [0, adcMax]
+ */
+uint32_t AcqPlan_GenerateTestValue(uint32_t pattern, uint8_t channel,
+                                   uint64_t sampleCount, uint32_t adcMax);
+
+#ifdef __cplusplus
+}
+#endif
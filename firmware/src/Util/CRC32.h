@@ -4,8 +4,14 @@
  *
  * #306: single small implementation serving settings integrity, SD file
  * integrity, and transfer verification - severs those paths from wolfSSL
- * (pinned at v5.4.0, not upgradable). Nibble-table variant: 64-byte table,
- * ~2 cycles/bit - SD/NVM I/O dominates every intended use.
+ * (pinned at v5.4.0, not upgradable).
+ *
+ * CRC32_SLICING picks the table at build time. SYST:STOR:SD:CRC over a
+ * multi-GB log made the original nibble loop (two dependent lookups per
+ * byte) the bottleneck rather than the card, so the default is now
+ * slicing-by-8: 8 KB of const tables, one word-parallel step per 8 bytes.
+ * 4 halves the tables; 0 keeps the 64-byte nibble table for builds that are
+ * short of flash. All three produce identical CRCs (tests/host).
  *
  * Usage (streaming):
  *   uint32_t crc = CRC32_Init();
@@ -21,6 +27,11 @@
 #include <stdint.h>
 #include <stddef.h>
 
+/** 0 = nibble table (64 B), 4 = slicing-by-4 (4 KB), 8 = slicing-by-8 (8 KB). */
+#ifndef CRC32_SLICING
+#define CRC32_SLICING 8
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -0,0 +1,144 @@
+#include "CaptureRing.h"
+
+uint32_t CaptureRing_MaxFrames(uint32_t size, uint8_t channels) {
+    if (channels == 0u || channels > CAPTURE_MAX_CHANNELS) {
+        return 0u;
+    }
+    return (uint32_t)(size / CAPTURE_FRAME_STRIDE(channels));
+}
+
+bool CaptureRing_Configure(CaptureRing_t* ring, uint8_t* buf, uint32_t size,
+                           uint8_t channels, uint32_t pre, uint32_t post) {
+    uint32_t maxFrames = CaptureRing_MaxFrames(size, channels);
+    if (buf == NULL || post == 0u || pre > maxFrames || post > maxFrames - pre) {
+        return false;
+    }
+    ring->buf = buf;
+    ring->stride = CAPTURE_FRAME_STRIDE(channels);
+    ring->frames = pre + post;
+    ring->pre = pre;
+    ring->post = post;
+    ring->channels = channels;
+    ring->head = 0u;
+    ring->filled = 0u;
+    ring->postLeft = 0u;
+    ring->readPos = 0u;
+    ring->readLeft = 0u;
+    ring->triggerTs = 0u;
+    ring->ignoredTriggers = 0u;
+    ring->state = CAPTURE_IDLE;
+    return true;
+}
+
+void CaptureRing_Arm(CaptureRing_t* ring) {
+    ring->head = 0u;
+    ring->filled = 0u;
+    ring->postLeft = 0u;
+    ring->readPos = 0u;
+    ring->readLeft = 0u;
+    ring->triggerTs = 0u;
+    ring->ignoredTriggers = 0u;
+    ring->state = (ring->pre == 0u) ? CAPTURE_ARMED : CAPTURE_FILLING;
+}
+
+static CaptureFrame_t* CaptureRing_Slot(const CaptureRing_t* ring, uint32_t index) {
+    return (CaptureFrame_t*)(ring->buf + (size_t)index * ring->stride);
+}
+
+CaptureFrame_t* CaptureRing_Claim(CaptureRing_t* ring) {
+    switch (ring->state) {
+        case CAPTURE_FILLING:
+        case CAPTURE_ARMED:
+        case CAPTURE_TRIGGERED:
+            return CaptureRing_Slot(ring, ring->head);
+        default:
+            return NULL;
+    }
+}
+
+CaptureState CaptureRing_Commit(CaptureRing_t* ring, bool trigger) {
+    uint8_t state = ring->state;
+    if (state != CAPTURE_FILLING && state != CAPTURE_ARMED &&
+        state != CAPTURE_TRIGGERED) {
+        return (CaptureState)state;
+    }
+    const CaptureFrame_t* frame = CaptureRing_Slot(ring, ring->head);
+    uint32_t before = ring->filled;
+    if (++ring->head == ring->frames) {
+        ring->head = 0u;
+    }
+    if (ring->filled < ring->frames) {
+        ring->filled++;
+    }
+
+    if (state == CAPTURE_TRIGGERED) {
+        ring->postLeft--;
+    } else if (trigger && before >= ring->pre) {
+        /* The trigger frame is the first of the post window. */
+        ring->triggerTs = frame->Timestamp;
+        ring->postLeft = ring->post - 1u;
+        state = CAPTURE_TRIGGERED;
+    } else {
+        if (trigger) {
+            ring->ignoredTriggers++;
+        }
+        if (ring->filled >= ring->pre) {
+            state = CAPTURE_ARMED;
+        }
+    }
+
+    if (state == CAPTURE_TRIGGERED && ring->postLeft == 0u) {
+        /* pre frames before the trigger + post from it = the whole ring,
+         * so the oldest frame is the one head points at. */
+        ring->readPos = ring->head;
+        ring->readLeft = ring->frames;
+        state = CAPTURE_DONE;
+    }
+    ring->state = state;
+    return (CaptureState)state;
+}
+
+const CaptureFrame_t* CaptureRing_Peek(const CaptureRing_t* ring) {
+    if (ring->state != CAPTURE_DONE || ring->readLeft == 0u) {
+        return NULL;
+    }
+    return CaptureRing_Slot(ring, ring->readPos);
+}
+
+void CaptureRing_Consume(CaptureRing_t* ring) {
+    if (ring->state != CAPTURE_DONE || ring->readLeft == 0u) {
+        return;
+    }
+    if (++ring->readPos == ring->frames) {
+        ring->readPos = 0u;
+    }
+    if (--ring->readLeft == 0u) {
+        ring->state = CAPTURE_READ;
+    }
+}
+
+void CaptureTrigger_Init(CaptureTrigger_t* trig, uint8_t sources,
+                         uint32_t adcSeq, uint32_t edgeSeq, uint32_t forceSeq) {
+    trig->sources = sources;
+    trig->adcSeq = adcSeq;
+    trig->edgeSeq = edgeSeq;
+    trig->forceSeq = forceSeq;
+}
+
+uint8_t CaptureTrigger_Poll(CaptureTrigger_t* trig, uint32_t adcSeq,
+                            uint32_t edgeSeq, uint32_t forceSeq) {
+    uint8_t fired = 0u;
+    if ((trig->sources & CAPTURE_SRC_ADC_THRESHOLD) && adcSeq != trig->adcSeq) {
+        fired |= CAPTURE_SRC_ADC_THRESHOLD;
+    }
+    if ((trig->sources & CAPTURE_SRC_DIO_EDGE) && edgeSeq != trig->edgeSeq) {
+        fired |= CAPTURE_SRC_DIO_EDGE;
+    }
+    if (forceSeq != trig->forceSeq) {
+        fired |= CAPTURE_SRC_FORCE;
+    }
+    trig->adcSeq = adcSeq;
+    trig->edgeSeq = edgeSeq;
+    trig->forceSeq = forceSeq;
+    return fired;
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Capture Ring — pre/post-trigger burst capture for SYST:STR:CAPture
+ *
+ * A capture session does not stream while it acquires. Every timer tick's
+ * frame goes into a circular buffer of pre+post frames carved from the
+ * StreamingBufferPool tail (StreamingBufferPool_GetCapture), so the rate is
+ * bounded by the ADC and the deferred task only -- no encoder, transport or
+ * sample pool is in the loop. When a trigger arrives the ring keeps filling
+ * for `post` more frames (the trigger frame included) and stops; the oldest
+ * frame is then `pre` ticks before the trigger and the ring is read out in
+ * order, the trigger frame at readout index `pre`:
+ *
+ *   IDLE -Arm-> FILLING -pre frames-> ARMED -trigger-> TRIGGERED
+ *                                       -post frames-> DONE -read-> READ
+ *
+ * A trigger before `pre` frames exist would leave the pre-trigger window
+ * short, so it is counted in ignoredTriggers and the ring keeps filling
+ * (pre == 0 arms at once).
+ *
+ * Triggers are edge-detected on free-running event counters by
+ * CaptureTrigger_Poll: the comparator trip count (AdcThreshold_TripSeq),
+ * the DIO edge count (UserEdge_EventSeq) and a software force. Events that
+ * happened while a source was not selected, or before the ring was ready,
+ * are consumed and never fire later.
+ *
+ * THREAD-SAFETY: none. Configured and armed before the session is enabled;
+ * the deferred task is then the only writer until the state reads DONE, and
+ * only the readout side (same task) touches it after that. state is
+ * volatile so SCPI queries can read it lock-free.
+ */
+
+#define CAPTURE_MAX_CHANNELS        16u     /* MAX_AIN_PUBLIC_CHANNELS */
+
+/** Trigger sources (SYST:STR:CAPture <pre>,<post>,<sources>). */
+#define CAPTURE_SRC_ADC_THRESHOLD   0x1u    /* any CONF:ADC:THREshold unit trips */
+#define CAPTURE_SRC_DIO_EDGE        0x2u    /* any DIO:EVENt pin sees its edge */
+#define CAPTURE_SRC_ALL             (CAPTURE_SRC_ADC_THRESHOLD | CAPTURE_SRC_DIO_EDGE)
+#define CAPTURE_SRC_FORCE           0x80u   /* SYST:STR:CAPture:FORCe (always honored) */
+
+typedef enum {
+    CAPTURE_IDLE = 0,       /* not configured / not armed */
+    CAPTURE_FILLING,        /* fewer than pre frames so far */
+    CAPTURE_ARMED,          /* pre-trigger window full, waiting for a trigger */
+    CAPTURE_TRIGGERED,      /* recording the post-trigger frames */
+    CAPTURE_DONE,           /* complete, readout in progress */
+    CAPTURE_READ,           /* every frame has been read out */
+} CaptureState;
+
+/** One captured tick; Values has the ring's channel count of entries. */
+typedef struct {
+    uint32_t Timestamp;
+    uint16_t validMask;
+    uint16_t clipMask;
+    uint32_t Values[];
+} CaptureFrame_t;
+
+/** Bytes per frame for @p channels channels (4-byte multiple). */
+#define CAPTURE_FRAME_STRIDE(channels) \
+    (sizeof(CaptureFrame_t) + (size_t)(channels) * sizeof(uint32_t))
+
+typedef struct {
+    uint8_t* buf;
+    size_t   stride;
+    uint32_t frames;            /* pre + post */
+    uint32_t pre;
+    uint32_t post;
+    uint32_t head;              /* next slot to write */
+    uint32_t filled;            /* frames written, saturating at frames */
+    uint32_t postLeft;          /* TRIGGERED: frames still to record */
+    uint32_t readPos;
+    uint32_t readLeft;
+    uint32_t triggerTs;         /* Timestamp of the trigger frame */
+    uint32_t ignoredTriggers;   /* triggers before the pre window was full */
+    uint8_t  channels;
+    volatile uint8_t state;     /* CaptureState */
+} CaptureRing_t;
+
+typedef struct {
+    uint8_t  sources;           /* CAPTURE_SRC_* */
+    uint32_t adcSeq;            /* last seen event counters */
+    uint32_t edgeSeq;
+    uint32_t forceSeq;
+} CaptureTrigger_t;
+
+/** Frames of @p channels channels that fit in @p size bytes. */
+uint32_t CaptureRing_MaxFrames(uint32_t size, uint8_t channels);
+
+/**
+ * Lay a ring of pre+post frames over @p buf (4-byte aligned) and leave it
+ * IDLE.
+ *
+ * @return false when post is 0, channels is out of range, or the frames do
+ *         not fit in @p size (@p ring unchanged)
+ */
+bool CaptureRing_Configure(CaptureRing_t* ring, uint8_t* buf, uint32_t size,
+                           uint8_t channels, uint32_t pre, uint32_t post);
+
+/** Start a capture: FILLING (ARMED when pre is 0), counters cleared. */
+void CaptureRing_Arm(CaptureRing_t* ring);
+
+static inline CaptureState CaptureRing_State(const CaptureRing_t* ring) {
+    return (CaptureState)ring->state;
+}
+
+/**
+ * The slot for this tick's frame, or NULL when the ring is not recording.
+ * The caller fills it and hands it over with CaptureRing_Commit.
+ */
+CaptureFrame_t* CaptureRing_Claim(CaptureRing_t* ring);
+
+/**
+ * Commit the claimed frame; @p trigger is true when a trigger fired on
+ * this tick. A trigger counts only while FILLING/ARMED with the pre window
+ * full (otherwise ignoredTriggers++, or nothing once TRIGGERED).
+ *
+ * @return the state after the commit
+ */
+CaptureState CaptureRing_Commit(CaptureRing_t* ring, bool trigger);
+
+/** The oldest frame not read out yet, or NULL unless DONE. */
+const CaptureFrame_t* CaptureRing_Peek(const CaptureRing_t* ring);
+
+/** Drop the frame Peek returned; the last one moves DONE -> READ. */
+void CaptureRing_Consume(CaptureRing_t* ring);
+
+/** Select @p sources and take the counters' current values as seen. */
+void CaptureTrigger_Init(CaptureTrigger_t* trig, uint8_t sources,
+                         uint32_t adcSeq, uint32_t edgeSeq, uint32_t forceSeq);
+
+/**
+ * Compare the counters with the last poll.
+ *
+ * @return the CAPTURE_SRC_* bits that fired (0 = no trigger). Every counter
+ *         is taken as seen, selected or not.
+ */
+uint8_t CaptureTrigger_Poll(CaptureTrigger_t* trig, uint32_t adcSeq,
+                            uint32_t edgeSeq, uint32_t forceSeq);
+
+#ifdef __cplusplus
+}
+#endif
@@ -297,6 +297,51 @@ uint32_t CircularBuf_AddBytes(CircularBuf_t* cirbuf, uint8_t* bytesBuf, uint32_t
 
     return numBytesCopied;
 }
+/*======================================================================================
+  CircularBuf_Reserve
+  Returns the insert point and, in *pSpan, how many bytes can be written there
+  contiguously (free space, up to the end of the buffer). NULL with *pSpan = 0
+  on a NULL or uninitialized buffer. See ZERO-COPY WRITES in the header.
+  =====================================================================================*/
+uint8_t* CircularBuf_Reserve(CircularBuf_t* cirbuf, uint32_t* pSpan)
+{
+    if (pSpan == NULL) return NULL;
+    *pSpan = 0;
+    if (cirbuf == NULL || cirbuf->buf_ptr == NULL) return NULL;
+
+    // A write that ended on the last byte leaves insertPtr one past the end;
+    // AddBytes wraps it lazily on its next call. Wrap it here instead, so the
+    // span offered is the one at the start of the buffer. insertPtr is
+    // producer-owned, so this is safe against a concurrent consumer.
+    if (cirbuf->insertPtr > BUF_END) {
+        cirbuf->insertPtr = BUF_START;
+    }
+
+    uint32_t toEnd = (uint32_t)(BUF_END - cirbuf->insertPtr + 1);
+    *pSpan = min(CircularBuf_NumBytesFree(cirbuf), toEnd);
+    return cirbuf->insertPtr;
+}
+
+/*======================================================================================
+  CircularBuf_Commit
+  Publishes bytesWritten bytes written at the pointer the last Reserve returned.
+  All-or-nothing like AddBytes: returns bytesWritten, or 0 (nothing published)
+  if that is more than the reservation could have offered.
+  =====================================================================================*/
+uint32_t CircularBuf_Commit(CircularBuf_t* cirbuf, uint32_t bytesWritten)
+{
+    if (cirbuf == NULL || cirbuf->buf_ptr == NULL || bytesWritten == 0) return 0;
+    if (cirbuf->insertPtr > BUF_END) return 0;   // no Reserve since the last fill
+
+    uint32_t toEnd = (uint32_t)(BUF_END - cirbuf->insertPtr + 1);
+    if (bytesWritten > toEnd || bytesWritten > CircularBuf_NumBytesFree(cirbuf)) {
+        return 0;
+    }
+    cirbuf->insertPtr += bytesWritten;
+    cirbuf->producedBytes += bytesWritten;  // SPSC: single writer
+    return bytesWritten;
+}
+
 void CircularBuf_Reset(CircularBuf_t* cirbuf)
 {
     if (cirbuf != NULL) {
@@ -74,6 +74,20 @@ extern "C" {
  *    pipeline behind this buffer.
  * - Must not re-enter this module on the SAME instance (AddBytes to a
  *    DIFFERENT buffer is fine and common - e.g. transport fan-out).
+ *
+ * ZERO-COPY WRITES (Reserve/Commit):
+ *
+ * - Producer-side alternative to AddBytes for a writer that can produce its
+ *    data in place (the streaming encoder). Reserve returns the insert point
+ *    and the CONTIGUOUS free span there - never across the wrap, so a short
+ *    span near the end of the buffer is normal; the caller either makes do
+ *    with it or falls back to AddBytes from its own buffer, which splits
+ *    across the wrap.
+ * - Commit publishes the first N bytes of the last reservation. Until then
+ *    the consumer cannot see them, so a reservation abandoned without a
+ *    commit (or committed with 0) leaves the buffer unchanged.
+ * - Reserve/Commit count as the producer side: the same one-producer rule
+ *    (and external lock, where there are several writers) spans the pair.
  */
 typedef struct s_CircularBuf
 {
@@ -98,6 +112,8 @@ void     CircularBuf_InitExternal(CircularBuf_t*, int (*fp)(uint8_t*,uint32_t),
 void     CircularBuf_Deinit(CircularBuf_t*);
 bool     CircularBuf_Resize(CircularBuf_t*, uint32_t newSize);
 uint32_t CircularBuf_AddBytes(CircularBuf_t*, uint8_t*, uint32_t);
+uint8_t* CircularBuf_Reserve(CircularBuf_t*, uint32_t* pSpan);
+uint32_t CircularBuf_Commit(CircularBuf_t*, uint32_t);
 uint32_t CircularBuf_NumBytesAvailable(CircularBuf_t*);
 uint32_t CircularBuf_NumBytesFree(CircularBuf_t*);
 uint32_t CircularBuf_ProcessBytes(CircularBuf_t*,uint8_t*, uint32_t,int*);
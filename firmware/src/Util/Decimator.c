@@ -0,0 +1,106 @@
+#include "Decimator.h"
+#include <string.h>
+
+/* gainMul = 2^DECIM_GAIN_Q / N^stages. With |y| < 2^18 * N^stages the
+ * product stays below 2^62, and the reciprocal's rounding error moves the
+ * estimate by at most N^stages * 2^(extraBits - 27) <= 1/4 LSB, so it is
+ * never more than one away from the exact quotient. */
+#define DECIM_GAIN_Q            44u
+
+bool Decimator_IsValidConfig(uint32_t factor, uint32_t stages, uint32_t extraBits) {
+    return (factor >= 2u) && (factor <= DECIM_MAX_FACTOR) &&
+           (stages >= 1u) && (stages <= DECIM_MAX_STAGES) &&
+           (extraBits <= DECIM_MAX_EXTRA_BITS);
+}
+
+bool Decimator_Configure(Decimator_t* dec, uint8_t channels, uint16_t factor,
+                         uint8_t stages, uint8_t extraBits) {
+    if (!Decimator_IsValidConfig(factor, stages, extraBits) ||
+        channels > DECIM_MAX_CHANNELS) {
+        return false;
+    }
+    uint64_t gain = 1u;
+    for (uint8_t k = 0; k < stages; k++) {
+        gain *= factor;
+    }
+    dec->channels = channels;
+    dec->stages = stages;
+    dec->extraBits = extraBits;
+    dec->factor = factor;
+    dec->settle = (uint16_t)(stages * (factor - 1u) + 1u);
+    dec->gainShift = (uint8_t)(DECIM_GAIN_Q - extraBits);
+    dec->gainMul = (int64_t)(((1ull << DECIM_GAIN_Q) + gain / 2u) / gain);
+    dec->gain2 = (int64_t)(2u * gain);
+    Decimator_Reset(dec);
+    return true;
+}
+
+void Decimator_Reset(Decimator_t* dec) {
+    memset(dec->ch, 0, sizeof(dec->ch));
+    dec->phase = 0;
+    dec->clipMask = 0;
+}
+
+bool Decimator_Push(Decimator_t* dec, const uint32_t* values,
+                    uint32_t validMask, uint32_t clipMask, uint32_t* out,
+                    uint32_t* pValidMask, uint32_t* pClipMask) {
+    const uint8_t stages = dec->stages;
+
+    for (uint8_t j = 0; j < dec->channels; j++) {
+        DecimChannel_t* c = &dec->ch[j];
+        if (validMask & (1u << j)) {
+            c->held = (int32_t)values[j];
+        } else if (c->fed == 0u) {
+            continue;                       /* not started yet */
+        }
+        if (c->fed != UINT16_MAX) {
+            c->fed++;
+        }
+        /* Modular 64-bit sums: the comb differences are exact as long as
+         * the true result fits, which the register-growth bound guarantees. */
+        uint64_t v = (uint64_t)(int64_t)c->held;
+        for (uint8_t k = 0; k < stages; k++) {
+            c->integ[k] += v;
+            v = c->integ[k];
+        }
+    }
+    dec->clipMask |= clipMask;
+
+    if (++dec->phase < dec->factor) {
+        return false;
+    }
+    dec->phase = 0;
+
+    uint32_t outValid = 0;
+    const int64_t round = (int64_t)1 << (dec->gainShift - 1u);
+    for (uint8_t j = 0; j < dec->channels; j++) {
+        DecimChannel_t* c = &dec->ch[j];
+        if (c->fed == 0u) {
+            continue;
+        }
+        uint64_t v = c->integ[stages - 1u];
+        for (uint8_t k = 0; k < stages; k++) {
+            uint64_t d = v - c->comb[k];
+            c->comb[k] = v;
+            v = d;
+        }
+        /* Arithmetic right shift: floor, so +round is round-half-up. The
+         * exact result q satisfies 0 <= 2*y*2^bits + gain - q*gain2 < gain2. */
+        int64_t y = (int64_t)v;
+        int64_t q = (y * dec->gainMul + round) >> dec->gainShift;
+        int64_t rem = y * ((int64_t)2 << dec->extraBits) + dec->gain2 / 2 - q * dec->gain2;
+        if (rem < 0) {
+            q--;
+        } else if (rem >= dec->gain2) {
+            q++;
+        }
+        out[j] = (uint32_t)(int32_t)q;
+        if (c->fed >= dec->settle) {
+            outValid |= (1u << j);
+        }
+    }
+    *pValidMask = outValid;
+    *pClipMask = dec->clipMask & outValid;
+    dec->clipMask = 0;
+    return true;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Decimator — on-device oversampling for SYST:STR:DECimate
+ *
+ * The ADC ticks at the configured rate R; every tick's frame is pushed here
+ * and only every N-th tick produces a frame for the sample pool, so the
+ * stream goes out at R/N and every transport carries 1/N of the samples.
+ * The filter is a CIC decimator of 1-3 stages (differential delay 1):
+ *
+ *   1 stage   N-sample boxcar average
+ *   2 stages  CIC2, a triangle window over 2N-1 inputs
+ *   3 stages  CIC3, a parabolic window over 3N-2 inputs, better alias
+ *             rejection at the same N
+ *
+ * Integrators run on every input, the combs once per output, all in 64-bit
+ * two's-complement, so register growth (18 + stages*log2(N) bits at most)
+ * never overflows. The DC gain N^stages is corrected with a precomputed
+ * reciprocal, out = (y * gainMul) >> gainShift, which also scales the result
+ * up by 2^extraBits -- the extra LSBs of effective resolution the averaging
+ * buys, carried in the int32 value (code * 2^extraBits). The estimate is
+ * within one of the exact quotient and one multiply-and-compare fixes it up,
+ * so every output is exactly round-half-up(y * 2^bits / N^stages) with no
+ * divide (tests/host/test_decimator.c checks it against a reference FIR).
+ *
+ * Inputs are int32 codes of at most DECIM_INPUT_BITS bits: MC12b (0..4095),
+ * sign-extended AD7609 (+-131072) and synthetic codes (0..262143).
+ *
+ * Validity: a channel is fed from its first valid input on; a later invalid
+ * input (a #535 T1 ARDY miss, a stale cache slot) repeats the channel's last
+ * valid code. Its output is valid once the whole window behind it has been
+ * fed (stages*(N-1)+1 inputs). The clip mask of an output is the OR of its
+ * inputs' (#814: a rail anywhere in the window is reported).
+ *
+ * THREAD-SAFETY: none. Configured before the session is enabled and then
+ * run by the deferred task only.
+ */
+
+#define DECIM_MAX_CHANNELS      16u     /* MAX_AIN_PUBLIC_CHANNELS */
+#define DECIM_MAX_STAGES        3u
+#define DECIM_MAX_FACTOR        128u
+#define DECIM_MAX_EXTRA_BITS    4u
+#define DECIM_INPUT_BITS        19u     /* signed: |code| < 2^18 */
+
+typedef struct {
+    uint64_t integ[DECIM_MAX_STAGES];   /* integrator cascade */
+    uint64_t comb[DECIM_MAX_STAGES];    /* comb delay elements */
+    int32_t  held;                      /* last valid input */
+    uint16_t fed;                       /* inputs since the first valid one (saturates) */
+} DecimChannel_t;
+
+typedef struct {
+    DecimChannel_t ch[DECIM_MAX_CHANNELS];
+    uint8_t  channels;
+    uint8_t  stages;
+    uint8_t  extraBits;
+    uint8_t  gainShift;
+    uint16_t factor;
+    uint16_t phase;                     /* inputs into the current window */
+    uint16_t settle;                    /* stages*(factor-1)+1 */
+    uint32_t clipMask;                  /* OR of the window's input clip masks */
+    int64_t  gainMul;
+    int64_t  gain2;                     /* 2 * N^stages */
+} Decimator_t;
+
+/** true when (factor, stages, extraBits) is a configuration Decimator_Configure accepts. */
+bool Decimator_IsValidConfig(uint32_t factor, uint32_t stages, uint32_t extraBits);
+
+/**
+ * Set up @p dec for @p channels packed channels and clear its state.
+ *
+ * @param factor     N, 2..DECIM_MAX_FACTOR
+ * @param stages     1 (boxcar) .. DECIM_MAX_STAGES
+ * @param extraBits  output scale 2^extraBits, 0..DECIM_MAX_EXTRA_BITS
+ * @return false on an invalid configuration (@p dec unchanged)
+ */
+bool Decimator_Configure(Decimator_t* dec, uint8_t channels, uint16_t factor,
+                         uint8_t stages, uint8_t extraBits);
+
+/** Clear the filter state and start a new window (configuration kept). */
+void Decimator_Reset(Decimator_t* dec);
+
+/**
+ * Push one input frame.
+ *
+ * @param values     input codes (int32 in uint32), [0..channels-1]
+ * @param validMask  bit j set when values[j] is a measurement
+ * @param clipMask   inputs at a rail
+ * @param out        decimated frame, written on an output tick only
+ * @param pValidMask set on an output tick: the valid outputs
+ * @param pClipMask  set on an output tick: the window's clip mask
+ * @return true when this input completed a window and @p out was written
+ */
+bool Decimator_Push(Decimator_t* dec, const uint32_t* values,
+                    uint32_t validMask, uint32_t clipMask, uint32_t* out,
+                    uint32_t* pValidMask, uint32_t* pClipMask);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,188 @@
+/* ==========================================================================
+ * FixedPointCal.h — integer calibrated-voltage conversion for the CSV
+ * streaming hot path
+ *
+ * The CSV value column is ADC_ConvertToVoltageByIndex() -> "%.*f". That
+ * conversion is a double multiply/divide/add chain per value per channel per
+ * sample (MC12b_ConvertToVoltage, AD7609_ConvertToVoltage). Every ADC module
+ * this firmware drives is LINEAR in the code, though:
+ *
+ *     volts = code * gain + offset
+ *
+ * so once per session the gain and offset can be turned into 64-bit
+ * fixed-point coefficients that produce the value directly in units of the
+ * last printed digit (10^-precision V; microvolts at precision 6). One
+ * integer multiply-add per value, then FixedPointFmt's digit renderer.
+ *
+ * Header-only and dependency-free for the same reason FixedPointFmt.h is: the
+ * correctness bar is byte-identity with snprintf of the DOUBLE path, and that
+ * is only credible when checked exhaustively on a host. See
+ * tests/host/test_fixedpointcal.c, which walks every 12-bit and 18-bit code
+ * at every precision over a spread of calibrations.
+ *
+ * HOW EXACTNESS IS KEPT. The integer result is not the double result: the
+ * double path rounds at every operation and the coefficients are quantised.
+ * Both errors are bounded, and they only change the printed digits when the
+ * value sits within that bound of a rounding boundary (a half of the last
+ * digit) or of zero (the sign). fixedcal_prepare() computes the bound in Q
+ * units; fixedcal_scaled() declines any value that lands inside it, and the
+ * caller formats that one from the double path exactly as before. Nothing is
+ * approximated -- a declined value costs what every value used to.
+ * ========================================================================== */
+#ifndef FIXEDPOINTCAL_H
+#define FIXEDPOINTCAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <float.h>
+
+#include "FixedPointFmt.h"
+
+/* Widest code the integer path takes. 2^24 leaves the gain at least 37 bits
+ * of fraction in the worst case below; the ADCs here are 12 and 18 bits. */
+#define FIXEDCAL_MAX_CODE (1ul << 24)
+
+/* Fewest fraction bits worth running with. The coefficient quantisation error
+ * grows with the code, so below this too many values would land inside the
+ * undecidable band for the integer path to pay for itself. */
+#define FIXEDCAL_MIN_SHIFT 20
+
+typedef struct {
+    int64_t  gainQ;      // 10^-precision V per code, Q<shift>
+    int64_t  offsetQ;    // 10^-precision V, Q<shift>
+    uint64_t margin;     // Q units either side of a boundary left to the double path
+    uint64_t scaledMax;  // largest |result| the channel can produce
+    uint32_t codeMax;    // largest code magnitude covered
+    uint8_t  shift;
+    uint8_t  signBits;   // 0: unsigned code; N: N-bit two's complement
+    bool     zeroExact;  // offset is exactly 0.0, so code 0 is exactly +/-0
+    bool     zeroNeg;    // ... and this is the sign the double path gives it
+    bool     valid;
+} FixedCalChannel;
+
+/**
+ * @brief Builds one channel's coefficients for @p precision decimals.
+ *
+ * @param gain       volts per code, as the double path's formula implies it
+ * @param offset     volts added after scaling (CalB; 0 where there is none)
+ * @param codeMax    largest code magnitude the ADC produces
+ * @param signBits   0 for unsigned codes, else the two's-complement width
+ * @param atZero     the double path's value at code 0 (only its sign is used)
+ * @param precision  decimals, 0..FIXEDFMT_MAX_PRECISION
+ *
+ * Leaves c->valid false when the channel is outside what the integer path
+ * can decide (non-finite calibration, a range too wide for 64 bits); the
+ * caller then keeps the double path for that channel.
+ */
+static inline void fixedcal_prepare(FixedCalChannel* c, double gain,
+                                    double offset, uint32_t codeMax,
+                                    unsigned signBits, double atZero,
+                                    unsigned precision) {
+    c->valid = false;
+    if (precision > FIXEDFMT_MAX_PRECISION || codeMax == 0u ||
+        codeMax > FIXEDCAL_MAX_CODE || signBits > 25u ||
+        !isfinite(gain) || !isfinite(offset)) {
+        return;
+    }
+    const double scale = (double)kFixedFmtPow10[precision];
+
+    /* Largest |value| in output units, plus one for the rounding carry. */
+    const double span = (fabs(gain) * (double)codeMax + fabs(offset)) * scale;
+    if (!(span < 4294967295.0 * scale) || !(span < 0x1p40)) {
+        return;
+    }
+
+    /* As many fraction bits as keep |code * gainQ + offsetQ| and the error
+     * band under 2^62. */
+    int exp;
+    (void)frexp(span + 1.0, &exp);        // span + 1 < 2^exp
+    int shift = 61 - exp;
+    if (shift > 52) {
+        shift = 52;
+    }
+    if (shift < FIXEDCAL_MIN_SHIFT) {
+        return;
+    }
+
+    c->gainQ = llround(ldexp(gain * scale, shift));
+    c->offsetQ = llround(ldexp(offset * scale, shift));
+
+    /* The undecidable band, in Q units:
+     *  - quantising the gain is off by <= 1/2 per code, the offset by <= 1/2;
+     *  - the double path's own rounding (up to five roundings through the
+     *    MC12b chain, one more for the *1000 of the millivolt column) and the
+     *    two roundings taken to form gain*scale and offset*scale are each at
+     *    most half an ULP of a value no larger than `span`.
+     * 16 * DBL_EPSILON covers those eight half-ULPs four times over. The
+     * slack is insurance for the same gap FixedPointFmt.h describes -- host
+     * libm as the oracle, XC32 on the device. The code term dominates: the
+     * host test measures ~0.06% of values declined at precision 6 and ~0.7%
+     * at precision 9 (NQ3, where the 18-bit code meets the fewest fraction
+     * bits), ~0.016% at the NQ1 default of 4. */
+    c->margin = (uint64_t)ceil(ldexp(span * (16.0 * DBL_EPSILON), shift))
+              + (uint64_t)codeMax + 2u;
+    c->scaledMax = (uint64_t)span + 1u;
+    c->codeMax = codeMax;
+    c->shift = (uint8_t)shift;
+    c->signBits = (uint8_t)signBits;
+    c->zeroExact = (offset == 0.0);
+    c->zeroNeg = signbit(atZero) != 0;
+    c->valid = true;
+}
+
+/**
+ * @brief Converts one raw code to a rounded magnitude in 10^-precision V.
+ *
+ * On true, *pScaled and *pNeg are exactly what "%.*f" of the double path
+ * prints -- ready for fixedfmt_scaled_to_str() -- and, for precision 3, what
+ * the millivolt column's half-away-from-zero rounding gives. On false the
+ * value is too close to a boundary to decide (or out of range) and the
+ * caller must use the double path.
+ *
+ * @pre c->valid
+ */
+static inline bool fixedcal_scaled(const FixedCalChannel* c, uint32_t raw,
+                                   uint64_t* pScaled, bool* pNeg) {
+    int32_t code;
+    if (c->signBits != 0u) {
+        /* Same mask and sign extension as AD7609_ConvertToVoltage. */
+        const uint32_t sign = 1ul << (c->signBits - 1u);
+        uint32_t v = raw & ((sign << 1) - 1u);
+        code = (int32_t)(v ^ sign) - (int32_t)sign;
+        if ((uint32_t)(code < 0 ? -code : code) > c->codeMax) {
+            return false;
+        }
+    } else {
+        if (raw > c->codeMax) {
+            return false;
+        }
+        code = (int32_t)raw;
+    }
+
+    if (code == 0 && c->zeroExact) {
+        *pScaled = 0u;
+        *pNeg = c->zeroNeg;
+        return true;
+    }
+
+    const int64_t q = (int64_t)code * c->gainQ + c->offsetQ;
+    const bool neg = (q < 0);
+    const uint64_t m = neg ? 0u - (uint64_t)q : (uint64_t)q;
+    if (m <= c->margin) {
+        return false;       // the sign itself is undecided
+    }
+
+    const uint64_t half = 1ull << (c->shift - 1u);
+    const uint64_t frac = m & ((half << 1) - 1u);
+    const uint64_t dist = (frac > half) ? frac - half : half - frac;
+    if (dist <= c->margin) {
+        return false;       // which way it rounds is undecided
+    }
+
+    *pScaled = (m >> c->shift) + (frac > half ? 1u : 0u);
+    *pNeg = neg;
+    return true;
+}
+
+#endif /* FIXEDPOINTCAL_H */
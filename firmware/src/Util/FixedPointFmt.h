@@ -144,66 +144,23 @@ static inline bool fixedfmt_can_format(double v, unsigned precision) {
 }
 
 /**
- * @brief Formats @p v with exactly @p precision decimals, like "%.*f".
+ * @brief Renders an already-scaled magnitude as "%.*f" would print it.
  *
- * Writes without a NUL terminator (the CSV encoder appends its own separators)
- * and returns the new write pointer, or NULL if @p rem is too small -- the same
- * contract as uint32_to_str/int_to_str in csv_encoder.c.
+ * @p scaled is the value in units of 10^-precision, already rounded; @p neg
+ * is printf's sign (it prints "-0.000" for a negative value that rounds to
+ * zero, so the sign cannot be recovered from @p scaled). fixedfmt_to_str
+ * ends here, and so does the integer calibration path in FixedPointCal.h,
+ * which produces the scaled integer without going through a double.
  *
- * Rounding is half-to-EVEN on the scaled value (nearbyint under the default
- * FE_TONEAREST), which is what printf does. Exact ties are the only place the
- * two rounding rules can differ, and the ADC generates them routinely because
- * its conversion divides by a power of two -- so this is not a corner case,
- * it is ordinary traffic. See the note at the nearbyint() call.
- *
- * @pre fixedfmt_can_format(v, precision) is true.
+ * Same contract as fixedfmt_to_str: no NUL, NULL if @p rem is too small.
  */
-static inline char* fixedfmt_to_str(double v, unsigned precision,
-                                    char* buf, size_t rem) {
+static inline char* fixedfmt_scaled_to_str(uint64_t scaled, bool neg,
+                                           unsigned precision,
+                                           char* buf, size_t rem) {
     if (buf == NULL || precision == 0u || precision > FIXEDFMT_MAX_PRECISION) {
         return NULL;
     }
-
-    /* Sign is taken from the value, not from the rounded result: -0.0004 at
-     * precision 3 must print "-0.000", exactly as printf does. Rounding first
-     * and testing the integer would lose that minus. */
-    const bool neg = signbit(v);
     const uint64_t scale = kFixedFmtPow10[precision];
-
-    /* nearbyint(), NOT round(). This is the whole correctness hinge.
-     *
-     * round() is half-AWAY-FROM-ZERO. printf("%.*f") is correctly rounded in
-     * the current FP rounding mode, which is FE_TONEAREST by default, i.e.
-     * half-to-EVEN. They agree everywhere except on an exact tie -- and the
-     * ADC produces ties constantly, because MC12b_ConvertToVoltage divides by
-     * the module Resolution (4096 on NQ1, MC12bADC.c:257), making every
-     * converted voltage a DYADIC rational that can land exactly halfway.
-     *
-     * Concretely, with round(): raw code 128 at the shipped NQ1 default
-     * precision 4 is 0.15625, which printed as "0.1563" where snprintf gives
-     * "0.1562" -- one wrong digit, silently, on ~8 of every 4096 codes.
-     * nearbyint() under FE_TONEAREST reproduces printf exactly.
-     *
-     * Found by adversarial audit on PR #819; the differential test missed it
-     * because it swept scales over 4095 (adcMax) instead of 4096
-     * (Resolution), and 1/4095 is not dyadic so it never generated a tie. The
-     * test now uses the firmware's own divisor and carries explicit dyadic
-     * tie cases of both parities. */
-    /* Round the SIGNED product, then take the magnitude -- not the reverse.
-     * Under the default FE_TONEAREST the two are identical, because ties-to-
-     * even is symmetric about zero. They diverge under a DIRECTED mode
-     * (FE_UPWARD/FE_DOWNWARD/FE_TOWARDZERO), where rounding a magnitude and
-     * then negating rounds the wrong way: nearbyint(-1.5) is -1 under
-     * FE_UPWARD, while -nearbyint(1.5) is -2. printf follows the mode too, so
-     * rounding the signed value is what keeps byte-identity true under ANY
-     * mode rather than only the default. Nothing in this firmware calls
-     * fesetround today -- this costs nothing and removes the assumption. */
-    const double scaledF = fabs(nearbyint(v * (double)scale));
-    if (!(scaledF >= 0.0) || scaledF > 1.8e19) {   /* NaN-safe bound check */
-        return NULL;
-    }
-    const uint64_t scaled = (uint64_t)scaledF;
-
     const uint64_t whole = scaled / scale;
     const uint64_t frac = scaled % scale;
 
@@ -213,8 +170,8 @@ static inline char* fixedfmt_to_str(double v, unsigned precision,
      * this runs once per value per channel per sample.
      *
      * The narrowing is only sound while both parts fit in 32 bits.
-     * fixedfmt_can_format() bounds |v| < FIXEDFMT_MAX_ABS (1e9), which bounds
-     * `whole`; and `frac < scale <= 1e9` by construction, so the fraction needs
+     * fixedfmt_can_format() bounds |v| < FIXEDFMT_MAX_ABS (1e9), and
+     * fixedcal_prepare() bounds its channel's range, which bounds `whole`; and `frac < scale <= 1e9` by construction, so the fraction needs
      * no check. `whole` DOES get one: this function is reachable directly, and
      * an unchecked cast would turn a precondition violation into a silently
      * truncated number instead of a clean failure. Failing closed sends the
@@ -270,4 +227,68 @@ static inline char* fixedfmt_to_str(double v, unsigned precision,
     return buf;
 }
 
+/**
+ * @brief Formats @p v with exactly @p precision decimals, like "%.*f".
+ *
+ * Writes without a NUL terminator (the CSV encoder appends its own separators)
+ * and returns the new write pointer, or NULL if @p rem is too small -- the same
+ * contract as uint32_to_str/int_to_str in csv_encoder.c.
+ *
+ * Rounding is half-to-EVEN on the scaled value (nearbyint under the default
+ * FE_TONEAREST), which is what printf does. Exact ties are the only place the
+ * two rounding rules can differ, and the ADC generates them routinely because
+ * its conversion divides by a power of two -- so this is not a corner case,
+ * it is ordinary traffic. See the note at the nearbyint() call.
+ *
+ * @pre fixedfmt_can_format(v, precision) is true.
+ */
+static inline char* fixedfmt_to_str(double v, unsigned precision,
+                                    char* buf, size_t rem) {
+    if (buf == NULL || precision == 0u || precision > FIXEDFMT_MAX_PRECISION) {
+        return NULL;
+    }
+
+    /* Sign is taken from the value, not from the rounded result: -0.0004 at
+     * precision 3 must print "-0.000", exactly as printf does. Rounding first
+     * and testing the integer would lose that minus. */
+    const bool neg = signbit(v);
+    const uint64_t scale = kFixedFmtPow10[precision];
+
+    /* nearbyint(), NOT round(). This is the whole correctness hinge.
+     *
+     * round() is half-AWAY-FROM-ZERO. printf("%.*f") is correctly rounded in
+     * the current FP rounding mode, which is FE_TONEAREST by default, i.e.
+     * half-to-EVEN. They agree everywhere except on an exact tie -- and the
+     * ADC produces ties constantly, because MC12b_ConvertToVoltage divides by
+     * the module Resolution (4096 on NQ1, MC12bADC.c:257), making every
+     * converted voltage a DYADIC rational that can land exactly halfway.
+     *
+     * Concretely, with round(): raw code 128 at the shipped NQ1 default
+     * precision 4 is 0.15625, which printed as "0.1563" where snprintf gives
+     * "0.1562" -- one wrong digit, silently, on ~8 of every 4096 codes.
+     * nearbyint() under FE_TONEAREST reproduces printf exactly.
+     *
+     * Found by adversarial audit on PR #819; the differential test missed it
+     * because it swept scales over 4095 (adcMax) instead of 4096
+     * (Resolution), and 1/4095 is not dyadic so it never generated a tie. The
+     * test now uses the firmware's own divisor and carries explicit dyadic
+     * tie cases of both parities. */
+    /* Round the SIGNED product, then take the magnitude -- not the reverse.
+     * Under the default FE_TONEAREST the two are identical, because ties-to-
+     * even is symmetric about zero. They diverge under a DIRECTED mode
+     * (FE_UPWARD/FE_DOWNWARD/FE_TOWARDZERO), where rounding a magnitude and
+     * then negating rounds the wrong way: nearbyint(-1.5) is -1 under
+     * FE_UPWARD, while -nearbyint(1.5) is -2. printf follows the mode too, so
+     * rounding the signed value is what keeps byte-identity true under ANY
+     * mode rather than only the default. Nothing in this firmware calls
+     * fesetround today -- this costs nothing and removes the assumption. */
+    const double scaledF = fabs(nearbyint(v * (double)scale));
+    if (!(scaledF >= 0.0) || scaledF > 1.8e19) {   /* NaN-safe bound check */
+        return NULL;
+    }
+    const uint64_t scaled = (uint64_t)scaledF;
+
+    return fixedfmt_scaled_to_str(scaled, neg, precision, buf, rem);
+}
+
 #endif /* FIXEDPOINTFMT_H */
@@ -233,6 +233,7 @@ extern "C" {
         LOG_SESSION_PACKETSIZE,            /**< streaming.c: encoder packetSize before WriteBuffer */
         LOG_SESSION_BUFFER_TAIL,           /**< streaming.c: bytes left in WiFi circular buffer at Stop */
         LOG_SESSION_T1_ARDY_MISS,          /**< streaming.c: T1 result not ready at direct read (#541) */
+        LOG_SESSION_SD_PREALLOC_DENIED,    /**< sd_card_manager.c: no contiguous space for SD:PREALLoc, file grows normally */
         /* Add new entries above this line */
         LOG_SESSION_COUNT                  /**< Must be <= 32 */
     } LogSessionBit_t;
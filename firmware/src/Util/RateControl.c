@@ -0,0 +1,93 @@
+#include "RateControl.h"
+#include <string.h>
+
+#define RATE_CONTROL_SINCE_MAX  0xFFu
+
+void RateControl_DefaultConfig(RateControlConfig_t* cfg) {
+    cfg->maxDivisor = 8u;
+    /* A PB block session holds up to half the ring on purpose
+     * (Streaming_EncodeSetBlockHold), so headroom has to start above that. */
+    cfg->fillHighPct = 80u;
+    cfg->fillLowPct = 60u;
+    cfg->raiseAfter = 4u;
+    cfg->raiseAfterMax = 32u;
+    cfg->holdoff = 1u;
+}
+
+void RateControl_Init(RateControl_t* rc, const RateControlConfig_t* cfg) {
+    memset(rc, 0, sizeof(*rc));
+    if (cfg != NULL) {
+        rc->cfg = *cfg;
+    } else {
+        RateControl_DefaultConfig(&rc->cfg);
+    }
+    if (rc->cfg.maxDivisor < 1u) rc->cfg.maxDivisor = 1u;
+    if (rc->cfg.maxDivisor > RATE_CONTROL_MAX_DIVISOR) {
+        rc->cfg.maxDivisor = RATE_CONTROL_MAX_DIVISOR;
+    }
+    if (rc->cfg.raiseAfter < 1u) rc->cfg.raiseAfter = 1u;
+    if (rc->cfg.raiseAfterMax < rc->cfg.raiseAfter) {
+        rc->cfg.raiseAfterMax = rc->cfg.raiseAfter;
+    }
+    rc->divisor = 1u;
+    rc->raiseNeed = rc->cfg.raiseAfter;
+    rc->sinceRaise = RATE_CONTROL_SINCE_MAX;
+}
+
+RateControlStep RateControl_Update(RateControl_t* rc, const RateControlSample_t* s) {
+    bool congested = (s->lostSamples > 0u) || (s->droppedBytes > 0u) ||
+                     (s->peakFillPct >= rc->cfg.fillHighPct);
+
+    if (rc->holdoff > 0u) {
+        rc->holdoff--;
+        rc->cleanRun = 0u;
+        return RATE_CONTROL_HOLD;
+    }
+
+    if (congested) {
+        rc->cleanRun = 0u;
+        if (rc->sinceRaise < rc->raiseNeed) {
+            /* The last step up did not hold: wait longer before the next. */
+            rc->failedProbes++;
+            uint32_t need = (uint32_t)rc->raiseNeed * 2u;
+            rc->raiseNeed = (uint8_t)((need > rc->cfg.raiseAfterMax)
+                                      ? rc->cfg.raiseAfterMax : need);
+        }
+        rc->sinceRaise = RATE_CONTROL_SINCE_MAX;
+        if (rc->divisor >= rc->cfg.maxDivisor) {
+            return RATE_CONTROL_HOLD;
+        }
+        uint32_t d = (uint32_t)rc->divisor * 2u;
+        rc->divisor = (uint8_t)((d > rc->cfg.maxDivisor) ? rc->cfg.maxDivisor : d);
+        rc->decreases++;
+        rc->holdoff = rc->cfg.holdoff;
+        return RATE_CONTROL_DOWN;
+    }
+
+    if (rc->sinceRaise < RATE_CONTROL_SINCE_MAX) {
+        rc->sinceRaise++;
+        if (rc->sinceRaise == rc->raiseNeed) {
+            rc->raiseNeed = rc->cfg.raiseAfter;     /* the raise held */
+        }
+    }
+
+    if (s->peakFillPct >= rc->cfg.fillLowPct) {
+        rc->cleanRun = 0u;                          /* no loss, no headroom */
+        return RATE_CONTROL_HOLD;
+    }
+    if (rc->cleanRun < RATE_CONTROL_SINCE_MAX) {
+        rc->cleanRun++;
+    }
+    if (rc->divisor > 1u && rc->cleanRun >= rc->raiseNeed) {
+        rc->divisor--;
+        rc->increases++;
+        rc->cleanRun = 0u;
+        rc->sinceRaise = 0u;
+        return RATE_CONTROL_UP;
+    }
+    return RATE_CONTROL_HOLD;
+}
+
+uint8_t RateControl_Divisor(const RateControl_t* rc) {
+    return rc->divisor;
+}
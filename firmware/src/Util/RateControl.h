@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Rate Control — AIMD on the streaming decimation divisor (SYST:STR:ADAPTive)
+ *
+ * The static transport caps (Streaming_TransportMaxFreq) are fitted to the
+ * worst night a link was ever measured on, so on every other night the link
+ * runs well under what it could carry. Adaptive mode lets the configured rate
+ * go above the WiFi cap and instead emits every d-th timer tick, choosing d
+ * from what the pipeline reports once per control period:
+ *
+ *   - congestion (any lost sample, any transport drop, or the sample ring
+ *     filling past fillHighPct): the rate is cut multiplicatively, d doubles;
+ *   - headroom (none of those, and the ring stayed under fillLowPct for
+ *     raiseNeed periods in a row): the rate steps up additively, d - 1.
+ *
+ * A raise that is followed by congestion before it has lasted raiseNeed
+ * periods was a failed probe, and doubles raiseNeed (up to raiseAfterMax) so
+ * a link sitting just under a step does not oscillate across it at the base
+ * cadence. A raise that lasts that long resets raiseNeed to raiseAfter. The
+ * holdoff periods after a cut are ignored while the backlog built at the old
+ * rate drains.
+ *
+ * Pure logic over the counters it is handed, so it runs on the host against
+ * simulated bandwidth traces (tests/host/test_rate_control.c).
+ *
+ * THREAD-SAFETY: none; streaming_Task is the only caller.
+ */
+
+#define RATE_CONTROL_MAX_DIVISOR  16u
+
+typedef struct {
+    uint8_t maxDivisor;     /* slowest rate: the configured rate / maxDivisor */
+    uint8_t fillHighPct;    /* peak ring fill at or above this is congestion */
+    uint8_t fillLowPct;     /* peak ring fill below this is headroom */
+    uint8_t raiseAfter;     /* clean periods before a rate step up */
+    uint8_t raiseAfterMax;  /* ceiling for raiseNeed after failed probes */
+    uint8_t holdoff;        /* periods ignored after a cut */
+} RateControlConfig_t;
+
+/** One control period's worth of pipeline health. */
+typedef struct {
+    uint32_t peakFillPct;   /* highest sample-ring fill seen, 0-100 */
+    uint32_t lostSamples;   /* samples dropped before encoding or by the encoder */
+    uint32_t droppedBytes;  /* encoded bytes a transport refused */
+} RateControlSample_t;
+
+typedef enum {
+    RATE_CONTROL_HOLD = 0,
+    RATE_CONTROL_DOWN,      /* divisor went up: fewer samples per second */
+    RATE_CONTROL_UP,        /* divisor went down */
+} RateControlStep;
+
+typedef struct {
+    RateControlConfig_t cfg;
+    uint8_t  divisor;
+    uint8_t  cleanRun;      /* consecutive headroom periods */
+    uint8_t  raiseNeed;     /* clean periods the next raise waits for */
+    uint8_t  holdoff;       /* periods still ignored */
+    uint8_t  sinceRaise;    /* periods since the last raise, saturating */
+    uint32_t decreases;
+    uint32_t increases;
+    uint32_t failedProbes;
+} RateControl_t;
+
+/** The defaults streaming.c runs with. */
+void RateControl_DefaultConfig(RateControlConfig_t* cfg);
+
+/**
+ * Start at full rate (divisor 1). @p cfg NULL takes the defaults; fields out
+ * of range are clamped (maxDivisor to 1..RATE_CONTROL_MAX_DIVISOR, raiseAfter
+ * to at least 1, raiseAfterMax to at least raiseAfter).
+ */
+void RateControl_Init(RateControl_t* rc, const RateControlConfig_t* cfg);
+
+/** Feed one control period. @return what, if anything, happened to the divisor. */
+RateControlStep RateControl_Update(RateControl_t* rc, const RateControlSample_t* s);
+
+uint8_t RateControl_Divisor(const RateControl_t* rc);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,92 @@
+#include "ScanDma.h"
+
+/* A read loses a race only if a whole scan completes inside a few loads;
+ * a scan takes >= ~11 us, so more than one retry means the reader was
+ * preempted that long, and the next attempt is as likely to lose. */
+#define SCAN_DMA_READ_TRIES     3u
+
+bool ScanList_Includes(const ScanListInput_t* in, bool enabledOnly,
+                       bool includeMonitoring) {
+    if (in->dedicated) {
+        return false;                       /* own module, never scanned */
+    }
+    if (in->an == SCAN_LIST_AN_TEMP_SENSOR) {
+        return false;                       /* erratum 18 */
+    }
+    if (in->an >= 64u) {
+        return false;   /* beyond ADCCSS1/2; a corrupted entry must not shift out */
+    }
+    if (in->monitoring) {
+        /* Not user-controllable; IsEnabled is the boot default. */
+        return includeMonitoring && in->enabled;
+    }
+    return !enabledOnly || in->enabled;
+}
+
+void ScanList_Add(uint32_t* pCss1, uint32_t* pCss2, uint32_t an) {
+    if (an < 32u) {
+        *pCss1 |= (1u << an);
+    } else if (an < 64u) {
+        *pCss2 |= (1u << (an - 32u));
+    }
+}
+
+bool ScanLayout_Build(ScanLayout_t* layout, uint32_t css1, uint32_t css2) {
+    uint64_t css = ((uint64_t)css2 << 32) | css1;
+    if (css == 0u || (css >> SCAN_LIST_AN_COUNT) != 0u) {
+        return false;
+    }
+    uint32_t first = (uint32_t)__builtin_ctzll(css);
+    uint32_t last = 63u - (uint32_t)__builtin_clzll(css);
+    layout->css1 = css1;
+    layout->css2 = css2;
+    layout->firstAn = (uint8_t)first;
+    layout->lastAn = (uint8_t)last;
+    layout->count = (uint8_t)__builtin_popcountll(css);
+    layout->words = (uint16_t)(last - first + 1u);
+    return true;
+}
+
+bool ScanLayout_Contains(const ScanLayout_t* layout, uint32_t an) {
+    if (an < 32u) {
+        return (layout->css1 >> an) & 1u;
+    }
+    if (an < 64u) {
+        return (layout->css2 >> (an - 32u)) & 1u;
+    }
+    return false;
+}
+
+void ScanDma_Init(ScanDma_t* dma, const ScanLayout_t* layout,
+                  volatile uint32_t* buf0, volatile uint32_t* buf1) {
+    dma->layout = *layout;
+    dma->buf[0] = buf0;
+    dma->buf[1] = buf1;
+    dma->seq = 0u;
+}
+
+volatile uint32_t* ScanDma_Complete(ScanDma_t* dma) {
+    uint32_t seq = dma->seq + 1u;
+    dma->seq = seq;
+    return dma->buf[seq & 1u];
+}
+
+bool ScanDma_Read(const ScanDma_t* dma, uint32_t an, uint32_t* pVal) {
+    *pVal = 0u;
+    if (!ScanLayout_Contains(&dma->layout, an)) {
+        return false;
+    }
+    uint32_t offset = ScanLayout_WordOffset(&dma->layout, an);
+    for (uint32_t tries = 0; tries < SCAN_DMA_READ_TRIES; tries++) {
+        uint32_t seq = dma->seq;
+        if (seq == 0u) {
+            return false;
+        }
+        uint32_t value = dma->buf[(seq - 1u) & 1u][offset];
+        if (dma->seq == seq) {
+            *pVal = value;
+            return true;
+        }
+    }
+    return false;
+}
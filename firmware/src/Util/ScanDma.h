@@ -0,0 +1,128 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Scan DMA — MODULE7 shared-scan readout into RAM (CONF:ADC:SCAN:DMA)
+ *
+ * Without it every scanned Type 2 user input raises its own priority-1
+ * ADC_DATAx data-ready ISR per conversion, on top of the per-scan EOS
+ * interrupt (the nUserT2 + 1 events per tick the MC12b_ScanMaxFreq
+ * event-rate term counts). In scan DMA mode the data-ready interrupts of
+ * the scanned inputs are gated off and a DMAC channel, started by the
+ * ADC EOS interrupt flag, copies the ADCDATAx block of the scan into one
+ * half of a ping-pong buffer; its block-complete interrupt is then the
+ * only interrupt per scan. MC12b_ReadResult and the EOS task read the
+ * last completed half instead of the result SFRs.
+ *
+ * The DMAC copies a contiguous span, so a layout covers firstAn..lastAn of
+ * the scan list. ADCDATAx are consecutive words (ADCHS_ChannelResultGet
+ * indexes them from ADCDATA0), so an input's word offset is an - firstAn;
+ * unscanned inputs inside the span are copied and ignored. Inputs below
+ * AN5 are the dedicated modules and never scanned, so the copy cannot
+ * clear a Type 1 ARDY flag.
+ *
+ * The rule that picks the scanned inputs from the board table (shared by
+ * MC12b_ComputeScanList) lives here too so the layouts can be checked on
+ * the host against the recorded board maps.
+ *
+ * THREAD-SAFETY: ScanDma_Complete runs in the DMA ISR and is the only
+ * writer. Readers take a sequence snapshot, read the completed half and
+ * retry when a completion moved in between (the DMAC starts refilling
+ * that half right after the next completion).
+ */
+
+/** ADCDATA0..ADCDATA44: highest result register on the PIC32MZ EF. */
+#define SCAN_LIST_AN_COUNT          45u
+/** Words one half of the ping-pong buffer needs for the widest span. */
+#define SCAN_DMA_MAX_WORDS          SCAN_LIST_AN_COUNT
+/** Internal temperature sensor, nonfunctional (erratum 18). */
+#define SCAN_LIST_AN_TEMP_SENSOR    44u
+
+/** One MC12b board-table entry as the scan-list rule sees it. */
+typedef struct {
+    uint32_t an;                /* ADCHS channel (CSS bit) */
+    bool     dedicated;         /* ChannelType 1 */
+    bool     monitoring;        /* IsPublic != 1 */
+    bool     enabled;           /* runtime IsEnabled */
+} ScanListInput_t;
+
+typedef struct {
+    uint32_t css1;              /* ADCCSS1/2 values the layout was built from */
+    uint32_t css2;
+    uint8_t  firstAn;
+    uint8_t  lastAn;
+    uint8_t  count;             /* inputs in the scan */
+    uint16_t words;             /* words copied per scan */
+} ScanLayout_t;
+
+typedef struct {
+    volatile uint32_t* buf[2];
+    ScanLayout_t layout;
+    volatile uint32_t seq;      /* completed scans; newest is buf[(seq - 1) & 1] */
+} ScanDma_t;
+
+/**
+ * Whether @p in belongs in the shared-scan list.
+ *
+ * @param enabledOnly        only enabled public inputs (session list);
+ *                           false = every public input (idle list)
+ * @param includeMonitoring  include enabled monitoring inputs
+ */
+bool ScanList_Includes(const ScanListInput_t* in, bool enabledOnly,
+                       bool includeMonitoring);
+
+/** Set @p an's bit in the ADCCSS1/2 pair. */
+void ScanList_Add(uint32_t* pCss1, uint32_t* pCss2, uint32_t an);
+
+/**
+ * Describe the DMA span of a scan list.
+ *
+ * @return false when the list is empty or names an input past
+ *         SCAN_LIST_AN_COUNT (@p layout unchanged)
+ */
+bool ScanLayout_Build(ScanLayout_t* layout, uint32_t css1, uint32_t css2);
+
+/** Whether @p an is one of the scanned inputs. */
+bool ScanLayout_Contains(const ScanLayout_t* layout, uint32_t an);
+
+/** Word offset of @p an's result in a buffer half (an must be scanned). */
+static inline uint32_t ScanLayout_WordOffset(const ScanLayout_t* layout, uint32_t an) {
+    return an - layout->firstAn;
+}
+
+/**
+ * Attach the two buffer halves (layout->words words each) and reset the
+ * sequence. The first scan lands in the half ScanDma_Target returns.
+ */
+void ScanDma_Init(ScanDma_t* dma, const ScanLayout_t* layout,
+                  volatile uint32_t* buf0, volatile uint32_t* buf1);
+
+/** The half the DMAC fills next. */
+static inline volatile uint32_t* ScanDma_Target(const ScanDma_t* dma) {
+    return dma->buf[dma->seq & 1u];
+}
+
+/**
+ * A scan has landed in ScanDma_Target: publish it and return the half to
+ * point the DMAC at for the next one. ISR context.
+ */
+volatile uint32_t* ScanDma_Complete(ScanDma_t* dma);
+
+/**
+ * The newest completed result of @p an.
+ *
+ * @return false when @p an is not scanned, no scan has completed yet, or
+ *         completions kept racing the read (*pVal = 0)
+ */
+bool ScanDma_Read(const ScanDma_t* dma, uint32_t an, uint32_t* pVal);
+
+#ifdef __cplusplus
+}
+#endif
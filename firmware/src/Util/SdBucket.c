@@ -0,0 +1,129 @@
+#include "SdBucket.h"
+#include <stddef.h>
+#include <string.h>
+
+void SdBucket_Init(SdBucket_t* b, uint32_t maxFiles, uint32_t maxBucket) {
+    memset(b, 0, sizeof(*b));
+    b->maxFiles = maxFiles;
+    b->maxBucket = maxBucket;
+    SdPartCache_Init(&b->parts);
+    SdPartCache_Invalidate(&b->parts);  /* nothing walked yet */
+}
+
+bool SdBucket_Full(const SdBucket_t* b) {
+    return b->countAtStart + b->filesIn >= b->maxFiles;
+}
+
+bool SdBucket_Enter(SdBucket_t* b, const SdBucketIo_t* io, uint32_t bucket) {
+    uint32_t count = 0u;
+    SdPartCache_t parts;
+    bool nextExists = false;
+    SdPartCache_Init(&parts);
+    if (!io->enter(io->ctx, bucket, &count, &parts, &nextExists)) {
+        if (bucket == b->cur + 1u) {
+            b->nextExists = true;
+        }
+        return false;
+    }
+    b->cur = bucket;
+    b->countAtStart = count;
+    b->filesIn = 0u;
+    b->parts = parts;
+    b->nextExists = nextExists;
+    return true;
+}
+
+SdBucketResult SdBucket_Place(SdBucket_t* b, const SdBucketIo_t* io,
+                              uint32_t counter, bool* pReopen) {
+    *pReopen = false;
+
+    uint32_t reuse = b->cur;
+    for (uint32_t probe = b->cur; probe <= b->maxBucket; probe++) {
+        if (probe != b->cur) {
+            /* The bucket after the active one was looked up when the active
+             * one was entered; the session cannot have created it since
+             * without entering it. */
+            if (probe == b->cur + 1u && !b->nextExists) {
+                break;
+            }
+            bool fsError = false;
+            bool present = io->bucketExists(io->ctx, probe, &fsError);
+            if (fsError) {
+                return SD_BUCKET_UNREADABLE;
+            }
+            if (!present) {
+                break;
+            }
+        }
+        bool found;
+        if (probe != b->cur || !SdPartCache_Lookup(&b->parts, counter, &found)) {
+            bool fsError = false;
+            found = io->partExists(io->ctx, probe, counter, &fsError);
+            if (fsError) {
+                return SD_BUCKET_UNREADABLE;
+            }
+        }
+        if (found) {
+            *pReopen = true;
+            reuse = probe;
+            break;
+        }
+    }
+    if (*pReopen) {
+        /* Re-entering the active bucket would re-count it and forget what
+         * this session added, so only a part found elsewhere moves us. */
+        if (reuse != b->cur && !SdBucket_Enter(b, io, reuse)) {
+            *pReopen = false;
+            return SD_BUCKET_ENTER_FAILED;
+        }
+        return SD_BUCKET_OK;
+    }
+
+    uint32_t advanced = 0u;
+    while (SdBucket_Full(b)) {
+        if (b->cur >= b->maxBucket || advanced > b->maxBucket) {
+            return SD_BUCKET_EXHAUSTED;
+        }
+        if (!SdBucket_Enter(b, io, b->cur + 1u)) {
+            return SD_BUCKET_ENTER_FAILED;
+        }
+        advanced++;
+    }
+    /* Count the attempt, not the success: a failed create still costs a
+     * directory scan, and over-counting only rolls sooner. */
+    SdBucket_NoteCreated(b, counter);
+    return SD_BUCKET_OK;
+}
+
+SdBucketPrecreate SdBucket_PlanPrecreate(SdBucket_t* b, const SdBucketIo_t* io,
+                                         uint32_t counter) {
+    bool present;
+    if (!SdPartCache_Lookup(&b->parts, counter, &present)) {
+        return SD_BUCKET_PRE_DECLINE;
+    }
+    if (present) {
+        return SD_BUCKET_PRE_REOPEN;
+    }
+    if (b->nextExists) {
+        return SD_BUCKET_PRE_DECLINE;   /* an earlier session's copy may be further on */
+    }
+    if (SdBucket_Full(b)) {
+        if (b->cur >= b->maxBucket) {
+            return SD_BUCKET_PRE_DECLINE;   /* Place refuses, with the reason */
+        }
+        if (!SdBucket_Enter(b, io, b->cur + 1u)) {
+            return SD_BUCKET_PRE_ROLL_FAILED;
+        }
+    }
+    return SD_BUCKET_PRE_NEW;
+}
+
+void SdBucket_NoteCreated(SdBucket_t* b, uint32_t counter) {
+    b->filesIn++;
+    SdPartCache_Add(&b->parts, counter);
+}
+
+bool SdBucket_Adoptable(const SdBucket_t* b, uint32_t nextBucket,
+                        uint32_t nextCounter, uint32_t counter) {
+    return nextCounter == counter && nextBucket == b->cur;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "SdPartCache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * SD Bucket — where the next split-file part goes (#689 bucketing)
+ *
+ * A split log's parts are created into bucket directories of at most
+ * maxFiles entries: bucket 0 is the configured directory, then P001, P002,
+ * ... up to maxBucket. This unit holds the decisions the SD manager makes
+ * about them -- which bucket a part is opened in, whether it reopens an
+ * existing copy, when to roll, and whether a part created ahead of time can
+ * be taken over at the rotation -- with the card reached only through
+ * SdBucketIo_t, so the same code runs against FatFs on a host.
+ *
+ * The fullness test is a counter, not a walk: a bucket is walked once when
+ * it is entered (its entry count, capped at maxFiles, and the log's parts in
+ * it, see SdPartCache.h), and every part created after that is counted
+ * here. Entering the next bucket is the only card work a rotation needs
+ * besides the create, and PlanPrecreate does that ahead of the rotation.
+ *
+ * The state is not kept across sessions: each session's first open enters
+ * bucket 0 again, so a card swap, a format or files deleted on a PC can
+ * never leave it describing directories that are no longer there.
+ *
+ * THREAD-SAFETY: none; owned by the SD manager task.
+ */
+
+typedef struct {
+    void* ctx;
+    /**
+     * Make @p bucket the active directory: create it if needed, walk it once
+     * (entries up to maxFiles into @p pCount, this log's parts into @p pParts),
+     * and look up whether bucket + 1 exists (an unreadable one reads as
+     * present). False on any failure; the callee records why.
+     */
+    bool (*enter)(void* ctx, uint32_t bucket, uint32_t* pCount,
+                  SdPartCache_t* pParts, bool* pNextExists);
+    /** Is @p bucket a directory? @p pFsError when the card could not say. */
+    bool (*bucketExists)(void* ctx, uint32_t bucket, bool* pFsError);
+    /** Does @p bucket hold part @p counter as a file? @p pFsError as above. */
+    bool (*partExists)(void* ctx, uint32_t bucket, uint32_t counter, bool* pFsError);
+} SdBucketIo_t;
+
+typedef struct {
+    uint32_t      maxFiles;     /* entries a bucket may hold before the roll */
+    uint32_t      maxBucket;    /* highest bucket index */
+    uint32_t      cur;          /* active bucket; 0 is the configured directory */
+    uint32_t      countAtStart; /* entries it held when entered */
+    uint32_t      filesIn;      /* parts this session has created in it since */
+    SdPartCache_t parts;        /* the log's parts it holds */
+    bool          nextExists;   /* bucket cur + 1 was there when cur was entered */
+} SdBucket_t;
+
+typedef enum {
+    SD_BUCKET_OK = 0,
+    SD_BUCKET_UNREADABLE,       /* the search met a bucket or part it could not stat */
+    SD_BUCKET_EXHAUSTED,        /* every bucket up to maxBucket is full */
+    SD_BUCKET_ENTER_FAILED,     /* io->enter failed; it recorded why */
+} SdBucketResult;
+
+typedef enum {
+    SD_BUCKET_PRE_DECLINE = 0,  /* leave the part to Place at the rotation */
+    SD_BUCKET_PRE_NEW,          /* create it in the active bucket, then NoteCreated */
+    SD_BUCKET_PRE_REOPEN,       /* the active bucket holds it: reopen in place */
+    SD_BUCKET_PRE_ROLL_FAILED,  /* declined: the roll ahead of time failed */
+} SdBucketPrecreate;
+
+/** Limits, bucket 0, nothing known: call SdBucket_Enter(b, io, 0) before use. */
+void SdBucket_Init(SdBucket_t* b, uint32_t maxFiles, uint32_t maxBucket);
+
+/** Has the active bucket reached maxFiles? */
+bool SdBucket_Full(const SdBucket_t* b);
+
+/**
+ * Enter @p bucket through io->enter. On failure the state is left as it was,
+ * except that a failed entry of bucket cur + 1 marks it as existing (its
+ * mkdir may have landed).
+ */
+bool SdBucket_Enter(SdBucket_t* b, const SdBucketIo_t* io, uint32_t bucket);
+
+/**
+ * OPEN_FILE: settle the bucket part @p counter is opened in.
+ *
+ * Searches forward from the active bucket for an existing copy -- the active
+ * bucket from the part cache when it can tell, every other one by a stat --
+ * and stops at the first absent bucket (they are created in ascending order).
+ * A copy found is reopened in place (@p pReopen) and adds no entry.
+ * Otherwise the part is new: rolls while the active bucket is full, at most
+ * maxBucket + 1 buckets, and counts it in the bucket it lands in.
+ */
+SdBucketResult SdBucket_Place(SdBucket_t* b, const SdBucketIo_t* io,
+                              uint32_t counter, bool* pReopen);
+
+/**
+ * Creating part @p counter ahead of its rotation: decide from the part cache
+ * alone, or decline. Declines when the cache cannot tell, or when the part
+ * is not in the active bucket and a later bucket exists that might hold it --
+ * Place's search is the authoritative one. A new part in a full bucket rolls
+ * now (the bucket it rolls into does not exist yet, so holds no part).
+ */
+SdBucketPrecreate SdBucket_PlanPrecreate(SdBucket_t* b, const SdBucketIo_t* io,
+                                         uint32_t counter);
+
+/** Part @p counter, planned SD_BUCKET_PRE_NEW, was created in the active bucket. */
+void SdBucket_NoteCreated(SdBucket_t* b, uint32_t counter);
+
+/**
+ * May the part pre-created as @p nextCounter in @p nextBucket be taken over
+ * when the log rotates to @p counter? Only if it is that part and the active
+ * bucket is still the one it was created in.
+ */
+bool SdBucket_Adoptable(const SdBucket_t* b, uint32_t nextBucket,
+                        uint32_t nextCounter, uint32_t counter);
+
+#ifdef __cplusplus
+}
+#endif
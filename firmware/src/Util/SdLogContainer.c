@@ -0,0 +1,472 @@
+#include "SdLogContainer.h"
+#include "CRC32.h"
+#include <string.h>
+
+#define SDLOG_INDEX_HEADER_SIZE 40u
+#define SDLOG_INDEX_ENTRY_SIZE  12u
+
+static const uint8_t kTrailerMagic[4] = {'D', 'Q', 'B', 'K'};
+static const uint8_t kIndexMagic[4] = {'D', 'Q', 'I', 'X'};
+
+_Static_assert(SDLOG_INDEX_HEADER_SIZE + SDLOG_INDEX_MAX * SDLOG_INDEX_ENTRY_SIZE
+               <= SDLOG_PAYLOAD_SIZE, "the index must fit one block");
+
+static void SDL_Put16(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void SDL_Put32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t SDL_Get16(const uint8_t* p) {
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+static uint32_t SDL_Get32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void SdLog_EncodeTrailer(const SdLogTrailer_t* t, uint32_t payloadCrc,
+                         uint8_t out[SDLOG_TRAILER_SIZE]) {
+    memcpy(out, kTrailerMagic, 4);
+    SDL_Put32(out + 4, t->firstTs);
+    SDL_Put32(out + 8, t->lastTs);
+    SDL_Put32(out + 12, t->mapHash);
+    SDL_Put16(out + 16, t->samples);
+    SDL_Put16(out + 18, t->firstRecord);
+    SDL_Put16(out + 20, t->payloadLen);
+    SDL_Put16(out + 22, t->epoch);
+    out[24] = t->type;
+    out[25] = SDLOG_VERSION;
+    out[26] = t->scaleBits;
+    out[27] = 0u;
+    SDL_Put32(out + 28, CRC32_Finalize(CRC32_Update(payloadCrc, out, 28)));
+}
+
+bool SdLog_DecodeTrailer(const uint8_t in[SDLOG_TRAILER_SIZE], SdLogTrailer_t* t) {
+    if (memcmp(in, kTrailerMagic, 4) != 0 || in[25] != SDLOG_VERSION) {
+        return false;
+    }
+    t->firstTs = SDL_Get32(in + 4);
+    t->lastTs = SDL_Get32(in + 8);
+    t->mapHash = SDL_Get32(in + 12);
+    t->samples = SDL_Get16(in + 16);
+    t->firstRecord = SDL_Get16(in + 18);
+    t->payloadLen = SDL_Get16(in + 20);
+    t->epoch = SDL_Get16(in + 22);
+    t->type = in[24];
+    t->version = in[25];
+    t->scaleBits = in[26];
+    return t->payloadLen <= SDLOG_PAYLOAD_SIZE;
+}
+
+bool SdLog_CheckBlock(const uint8_t block[SDLOG_BLOCK_SIZE], SdLogTrailer_t* t) {
+    const uint8_t* tr = block + SDLOG_PAYLOAD_SIZE;
+    if (!SdLog_DecodeTrailer(tr, t)) {
+        return false;
+    }
+    return CRC32_Compute(block, SDLOG_BLOCK_SIZE - 4u) == SDL_Get32(tr + 28);
+}
+
+int64_t SdLog_TrailerTicks(const SdLogTrailer_t* t, uint32_t baseTs) {
+    return (int64_t)(((uint64_t)t->epoch << 32) + t->firstTs) - (int64_t)baseTs;
+}
+
+void SdLogIndex_Init(SdLogIndex_t* ix) {
+    memset(ix, 0, sizeof(*ix));
+    ix->stride = 1u;
+}
+
+void SdLogIndex_Note(SdLogIndex_t* ix, uint32_t block, const SdLogTrailer_t* t) {
+    ix->blocks = block + 1u;
+    if (t->type != SDLOG_BLOCK_DATA) {
+        return;
+    }
+    if ((ix->dataBlocks % ix->stride) == 0u) {
+        if (ix->count == SDLOG_INDEX_MAX) {
+            /* Keep the even entries: they sit on multiples of the doubled
+             * stride, and so does this block only if it lands on one too. */
+            for (uint32_t i = 0; i < SDLOG_INDEX_MAX / 2u; i++) {
+                ix->entries[i] = ix->entries[2u * i];
+            }
+            ix->count = SDLOG_INDEX_MAX / 2u;
+            ix->stride *= 2u;
+        }
+        if ((ix->dataBlocks % ix->stride) == 0u) {
+            SdLogIndexEntry_t* e = &ix->entries[ix->count++];
+            e->block = block;
+            e->firstTs = t->firstTs;
+            e->epoch = t->epoch;
+        }
+    }
+    ix->dataBlocks++;
+}
+
+/* Zero padding is fed to the sink from this, a slice at a time. */
+static const uint8_t kZeros[64];
+
+static uint32_t SDL_Pad(uint32_t crc, size_t len, SdLogSink_t sink, void* ctx) {
+    while (len > 0u) {
+        size_t n = (len < sizeof(kZeros)) ? len : sizeof(kZeros);
+        sink(ctx, kZeros, n);
+        crc = CRC32_Update(crc, kZeros, n);
+        len -= n;
+    }
+    return crc;
+}
+
+void SdLogIndex_Emit(const SdLogIndex_t* ix, SdLogSink_t sink, void* ctx) {
+    uint8_t buf[SDLOG_INDEX_HEADER_SIZE + SDLOG_INDEX_MAX * SDLOG_INDEX_ENTRY_SIZE];
+    memcpy(buf, kIndexMagic, 4);
+    buf[4] = SDLOG_VERSION;
+    buf[5] = (uint8_t)ix->scaleBits;
+    SDL_Put16(buf + 6, ix->count);
+    SDL_Put32(buf + 8, ix->stride);
+    SDL_Put32(buf + 12, ix->blocks);
+    SDL_Put32(buf + 16, ix->dataBlocks);
+    SDL_Put32(buf + 20, ix->samples);
+    SDL_Put32(buf + 24, ix->firstTs);
+    SDL_Put32(buf + 28, ix->lastTs);
+    SDL_Put32(buf + 32, ix->lastEpoch);
+    SDL_Put32(buf + 36, ix->mapHash);
+    size_t len = SDLOG_INDEX_HEADER_SIZE;
+    for (uint32_t i = 0; i < ix->count; i++) {
+        SDL_Put32(buf + len, ix->entries[i].block);
+        SDL_Put32(buf + len + 4, ix->entries[i].firstTs);
+        SDL_Put32(buf + len + 8, ix->entries[i].epoch);
+        len += SDLOG_INDEX_ENTRY_SIZE;
+    }
+    sink(ctx, buf, len);
+    uint32_t crc = CRC32_Update(CRC32_Init(), buf, len);
+    crc = SDL_Pad(crc, SDLOG_PAYLOAD_SIZE - len, sink, ctx);
+
+    SdLogTrailer_t t = {
+        .firstTs = ix->firstTs,
+        .lastTs = ix->lastTs,
+        .mapHash = ix->mapHash,
+        .samples = 0u,
+        .firstRecord = 0u,
+        .payloadLen = (uint16_t)len,
+        .epoch = (uint16_t)ix->lastEpoch,
+        .type = SDLOG_BLOCK_INDEX,
+        .scaleBits = (uint8_t)ix->scaleBits,
+    };
+    uint8_t tr[SDLOG_TRAILER_SIZE];
+    SdLog_EncodeTrailer(&t, crc, tr);
+    sink(ctx, tr, sizeof(tr));
+}
+
+bool SdLogIndex_Decode(const uint8_t* payload, size_t len, SdLogIndex_t* ix) {
+    if (len < SDLOG_INDEX_HEADER_SIZE || memcmp(payload, kIndexMagic, 4) != 0 ||
+        payload[4] != SDLOG_VERSION) {
+        return false;
+    }
+    SdLogIndex_Init(ix);
+    ix->count = SDL_Get16(payload + 6);
+    ix->stride = SDL_Get32(payload + 8);
+    ix->blocks = SDL_Get32(payload + 12);
+    ix->dataBlocks = SDL_Get32(payload + 16);
+    ix->samples = SDL_Get32(payload + 20);
+    ix->firstTs = SDL_Get32(payload + 24);
+    ix->lastTs = SDL_Get32(payload + 28);
+    ix->lastEpoch = SDL_Get32(payload + 32);
+    ix->mapHash = SDL_Get32(payload + 36);
+    ix->scaleBits = payload[5];
+    if (ix->count > SDLOG_INDEX_MAX || ix->stride == 0u ||
+        len < SDLOG_INDEX_HEADER_SIZE + ix->count * SDLOG_INDEX_ENTRY_SIZE) {
+        return false;
+    }
+    const uint8_t* p = payload + SDLOG_INDEX_HEADER_SIZE;
+    for (uint32_t i = 0; i < ix->count; i++, p += SDLOG_INDEX_ENTRY_SIZE) {
+        ix->entries[i].block = SDL_Get32(p);
+        ix->entries[i].firstTs = SDL_Get32(p + 4);
+        ix->entries[i].epoch = SDL_Get32(p + 8);
+    }
+    return true;
+}
+
+void SdLogWriter_Begin(SdLogWriter_t* w) {
+    memset(w, 0, sizeof(*w));
+    SdLogIndex_Init(&w->index);
+}
+
+/* Open a fresh block. Timestamps default to the last record seen, so a
+ * block that no record starts in still sorts where it sits in the file. */
+static void SDL_Open(SdLogWriter_t* w, uint8_t type, uint16_t firstRecord) {
+    memset(&w->open, 0, sizeof(w->open));
+    w->open.type = type;
+    w->open.firstRecord = firstRecord;
+    w->open.firstTs = w->prevTs;
+    w->open.lastTs = w->prevTs;
+    w->open.epoch = (uint16_t)w->epoch;
+    w->open.mapHash = w->index.mapHash;
+    w->open.scaleBits = (uint8_t)w->index.scaleBits;
+    w->used = 0u;
+    w->crc = CRC32_Init();
+}
+
+static void SDL_Seal(SdLogWriter_t* w, SdLogSink_t sink, void* ctx) {
+    w->open.payloadLen = (uint16_t)w->used;
+    w->crc = SDL_Pad(w->crc, SDLOG_PAYLOAD_SIZE - w->used, sink, ctx);
+    uint8_t tr[SDLOG_TRAILER_SIZE];
+    SdLog_EncodeTrailer(&w->open, w->crc, tr);
+    sink(ctx, tr, sizeof(tr));
+    SdLogIndex_Note(&w->index, w->index.blocks, &w->open);
+    w->used = 0u;
+}
+
+size_t SdLogWriter_Cost(const SdLogWriter_t* w, size_t len, const SdLogMark_t* mark) {
+    if (mark == NULL || mark->type != SDLOG_BLOCK_DATA) {
+        size_t seal = (w->used > 0u) ? (SDLOG_BLOCK_SIZE - w->used) : 0u;
+        size_t blocks = (len + SDLOG_PAYLOAD_SIZE - 1u) / SDLOG_PAYLOAD_SIZE;
+        return seal + blocks * SDLOG_BLOCK_SIZE + SDLOG_BLOCK_SIZE;
+    }
+    size_t blocks = (w->used + len + SDLOG_PAYLOAD_SIZE - 1u) / SDLOG_PAYLOAD_SIZE;
+    return blocks * SDLOG_BLOCK_SIZE - w->used + SDLOG_BLOCK_SIZE;
+}
+
+size_t SdLogWriter_Room(const SdLogWriter_t* w, size_t ringFree) {
+    if (ringFree + w->used < SDLOG_BLOCK_SIZE) {
+        return 0u;
+    }
+    size_t blocks = (ringFree + w->used - SDLOG_BLOCK_SIZE) / SDLOG_BLOCK_SIZE;
+    size_t payload = blocks * SDLOG_PAYLOAD_SIZE;
+    return (payload > w->used) ? payload - w->used : 0u;
+}
+
+static void SDL_Copy(SdLogWriter_t* w, const uint8_t* data, size_t n,
+                     SdLogSink_t sink, void* ctx) {
+    sink(ctx, data, n);
+    w->crc = CRC32_Update(w->crc, data, n);
+    w->used += (uint32_t)n;
+}
+
+static void SDL_AppendHeader(SdLogWriter_t* w, const uint8_t* data, size_t len,
+                             SdLogSink_t sink, void* ctx) {
+    if (w->used > 0u) {
+        SDL_Seal(w, sink, ctx);
+    }
+    uint16_t firstRecord = 0u;
+    while (len > 0u) {
+        SDL_Open(w, SDLOG_BLOCK_HEADER, firstRecord);
+        size_t n = (len < SDLOG_PAYLOAD_SIZE) ? len : SDLOG_PAYLOAD_SIZE;
+        SDL_Copy(w, data, n, sink, ctx);
+        SDL_Seal(w, sink, ctx);
+        data += n;
+        len -= n;
+        firstRecord = SDLOG_NO_RECORD;
+    }
+}
+
+void SdLogWriter_Append(SdLogWriter_t* w, const uint8_t* data, size_t len,
+                        const SdLogMark_t* mark, SdLogSink_t sink, void* ctx) {
+    if (len == 0u) {
+        return;
+    }
+    if (mark == NULL || mark->type != SDLOG_BLOCK_DATA) {
+        if (mark != NULL) {
+            w->index.mapHash = mark->mapHash;
+            w->index.scaleBits = mark->scaleBits;
+        }
+        SDL_AppendHeader(w, data, len, sink, ctx);
+        return;
+    }
+
+    /* The timer wrapped if this record starts before the previous one
+     * ended, or ends before it starts. */
+    if (!w->haveTs) {
+        w->haveTs = true;
+        w->epoch = 0u;
+        w->index.firstTs = mark->firstTs;
+    } else if (mark->firstTs < w->prevTs) {
+        w->epoch++;
+    }
+    uint16_t startEpoch = (uint16_t)w->epoch;
+    if (mark->lastTs < mark->firstTs) {
+        w->epoch++;
+    }
+    w->prevTs = mark->lastTs;
+    w->index.mapHash = mark->mapHash;
+    w->index.scaleBits = mark->scaleBits;
+    w->index.samples += mark->samples;
+    w->index.lastTs = mark->lastTs;
+    w->index.lastEpoch = w->epoch;
+
+    if (w->used == 0u) {
+        SDL_Open(w, SDLOG_BLOCK_DATA, 0u);
+        w->open.firstTs = mark->firstTs;
+        w->open.epoch = startEpoch;
+    } else if (w->open.firstRecord == SDLOG_NO_RECORD) {
+        w->open.firstRecord = (uint16_t)w->used;
+        w->open.firstTs = mark->firstTs;
+        w->open.epoch = startEpoch;
+    }
+    uint32_t samples = w->open.samples + mark->samples;
+    w->open.samples = (samples > 0xFFFFu) ? 0xFFFFu : (uint16_t)samples;
+    w->open.lastTs = mark->firstTs;
+    w->open.mapHash = mark->mapHash;
+    w->open.scaleBits = mark->scaleBits;
+
+    while (len > 0u) {
+        size_t n = SDLOG_PAYLOAD_SIZE - w->used;
+        if (n > len) {
+            n = len;
+        }
+        SDL_Copy(w, data, n, sink, ctx);
+        data += n;
+        len -= n;
+        if (w->used == SDLOG_PAYLOAD_SIZE) {
+            SDL_Seal(w, sink, ctx);
+            if (len > 0u) {
+                /* Continuation: no record starts here; it sorts by the
+                 * record running into it. */
+                SDL_Open(w, SDLOG_BLOCK_DATA, SDLOG_NO_RECORD);
+                w->open.firstTs = mark->firstTs;
+                w->open.lastTs = mark->firstTs;
+                w->open.epoch = startEpoch;
+            }
+        }
+    }
+}
+
+void SdLogWriter_Finish(SdLogWriter_t* w, SdLogSink_t sink, void* ctx) {
+    if (w->used > 0u) {
+        SDL_Seal(w, sink, ctx);
+    }
+    if (w->index.blocks > 0u) {
+        SdLogIndex_Emit(&w->index, sink, ctx);
+    }
+    SdLogWriter_Begin(w);
+}
+
+/* Ticks to a trailer's lastTs: its firstTs plus the (sub-wrap) gap. */
+static int64_t SDL_LastTicks(const SdLogTrailer_t* t, uint32_t baseTs) {
+    return SdLog_TrailerTicks(t, baseTs) + (int64_t)(uint32_t)(t->lastTs - t->firstTs);
+}
+
+static bool SDL_IsData(SdLogTrailerReader_t read, void* ctx, uint32_t b,
+                       SdLogTrailer_t* t) {
+    return read(ctx, b, t) && t->type == SDLOG_BLOCK_DATA;
+}
+
+/* The first DATA block in [b, end), or end. */
+static uint32_t SDL_NextData(uint32_t b, uint32_t end, SdLogTrailerReader_t read,
+                             void* ctx, SdLogTrailer_t* t) {
+    while (b < end && !SDL_IsData(read, ctx, b, t)) {
+        b++;
+    }
+    return b;
+}
+
+/* The last DATA block in [lo, hi) whose firstTs is at or before @p ticks,
+ * or UINT32_MAX. Trailer keys never decrease along the file; blocks of
+ * other types (and unreadable ones) are stepped over. The index, when there
+ * is one, first narrows [lo, hi) to the entries bracketing @p ticks. */
+static uint32_t SDL_LastAtOrBefore(const SdLogIndex_t* index, uint32_t lo,
+                                   uint32_t hi, int64_t ticks, uint32_t baseTs,
+                                   SdLogTrailerReader_t read, void* ctx) {
+    if (index != NULL) {
+        for (uint32_t i = 0; i < index->count; i++) {
+            SdLogTrailer_t e = {.firstTs = index->entries[i].firstTs,
+                                .epoch = (uint16_t)index->entries[i].epoch};
+            if (SdLog_TrailerTicks(&e, baseTs) > ticks) {
+                if (index->entries[i].block < hi) {
+                    hi = index->entries[i].block;
+                }
+                break;
+            }
+            if (index->entries[i].block > lo) {
+                lo = index->entries[i].block;
+            }
+        }
+    }
+    uint32_t found = UINT32_MAX;
+    SdLogTrailer_t t;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2u;
+        uint32_t b = SDL_NextData(mid, hi, read, ctx, &t);
+        if (b == hi) {
+            hi = mid;
+        } else if (SdLog_TrailerTicks(&t, baseTs) <= ticks) {
+            found = b;
+            lo = b + 1u;
+        } else {
+            hi = mid;
+        }
+    }
+    return found;
+}
+
+bool SdLog_FindRange(uint32_t nblocks, const SdLogIndex_t* index,
+                     uint64_t t1, uint64_t t2,
+                     SdLogTrailerReader_t read, void* ctx,
+                     uint32_t* pFirst, uint32_t* pLast) {
+    SdLogTrailer_t t;
+    uint32_t baseTs;
+    uint32_t lo = 0u;
+    uint32_t hi = nblocks;
+
+    if (t1 > t2 || t2 > (uint64_t)INT64_MAX) {
+        return false;
+    }
+    if (index != NULL && index->dataBlocks > 0u) {
+        baseTs = index->firstTs;
+        if (index->blocks < hi) {
+            hi = index->blocks;
+        }
+    } else {
+        index = NULL;
+        lo = SDL_NextData(0u, nblocks, read, ctx, &t);
+        if (lo == nblocks) {
+            return false;
+        }
+        baseTs = t.firstTs;
+    }
+
+    /* The record covering t1 is the last one starting at or before it (the
+     * first record of all if none does). It starts in the block found, unless
+     * that block is a continuation: then back up to where it began. */
+    uint32_t first = SDL_LastAtOrBefore(index, lo, hi, (int64_t)t1, baseTs,
+                                        read, ctx);
+    if (first == UINT32_MAX) {
+        first = SDL_NextData(lo, hi, read, ctx, &t);
+        if (first == hi) {
+            return false;
+        }
+    }
+    while (first > lo && SDL_IsData(read, ctx, first, &t) &&
+           t.firstRecord == SDLOG_NO_RECORD) {
+        uint32_t b = first - 1u;
+        while (b > lo && !SDL_IsData(read, ctx, b, &t)) {
+            b--;
+        }
+        first = b;
+    }
+
+    /* The last record starting at or before t2 starts in block `last`. If it
+     * is that block's last record, it may run on: through continuations, and
+     * into the next block that a record starts in part-way. */
+    uint32_t last = SDL_LastAtOrBefore(index, first, hi, (int64_t)t2, baseTs,
+                                       read, ctx);
+    if (last == UINT32_MAX) {
+        return false;
+    }
+    if (SDL_IsData(read, ctx, last, &t) && SDL_LastTicks(&t, baseTs) <= (int64_t)t2) {
+        while (last + 1u < hi && SDL_IsData(read, ctx, last + 1u, &t) &&
+               t.firstRecord != 0u) {
+            last++;
+            if (t.firstRecord != SDLOG_NO_RECORD) {
+                break;
+            }
+        }
+    }
+    *pFirst = first;
+    *pLast = last;
+    return true;
+}
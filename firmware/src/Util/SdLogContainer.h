@@ -0,0 +1,198 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * SD Log Container — indexed block framing for SD log files (SD:CONTainer 1)
+ *
+ * A plain SD log is the stream's bytes back to back (CSV rows, JSON objects,
+ * length-delimited PB), so finding one minute of a multi-GB capture means
+ * reading the file from byte 0. In container mode the same bytes are cut into
+ * fixed SDLOG_BLOCK_SIZE blocks, each ending in a 32-byte trailer that says
+ * what the block holds; the last block of a closed file is an index. A reader
+ * can then seek straight to a block number, or binary-search the trailers for
+ * a time, touching a few dozen bytes per probe.
+ *
+ * Trailer, not header: the writer streams payload into the SD ring as it
+ * arrives and only learns the block's sample count and last timestamp when it
+ * fills. A leading header would have to be patched or staged; a trailer is
+ * just the next 32 bytes.
+ *
+ * Block layout (little-endian):
+ *   [0, SDLOG_PAYLOAD_SIZE)   payload; a sealed partial block is zero-padded
+ *   trailer +0   "DQBK"
+ *           +4   firstTs      raw stream timestamp of the first record that
+ *                             starts in the block (or, in a continuation
+ *                             block, of the record that runs into it)
+ *           +8   lastTs       raw timestamp of the last record that starts in
+ *                             the block (firstTs again in a continuation)
+ *           +12  mapHash      CRC-32 of the session's channel map + encoding
+ *           +16  samples      u16, sample sets of the records starting here
+ *           +18  firstRecord  u16, payload offset of the first record that
+ *                             starts here; SDLOG_NO_RECORD if none does
+ *           +20  payloadLen   u16, bytes of payload before the padding
+ *           +22  epoch        u16, timer wraps between the file's first
+ *                             record and firstTs
+ *           +24  type         SdLogBlockType
+ *           +25  version      SDLOG_VERSION
+ *           +26  scaleBits    values are ADC codes x 2^scaleBits (the
+ *                             SYST:STR:DECimate extra bits; 0 otherwise)
+ *           +27  reserved     0
+ *           +28  crc          CRC-32 of the payload, padding and trailer[0,28)
+ *
+ * A "record" is one append: a batch of whole framed messages, so a reader can
+ * start decoding at firstRecord. Timestamps wrap (32-bit timer), so ranges are
+ * searched on ticks since the file's first record: (epoch << 32) + firstTs
+ * minus that record's ts.
+ *
+ * THREAD-SAFETY: none. The SD manager drives the writer under its ring mutex.
+ */
+
+#define SDLOG_BLOCK_SIZE    4096u
+#define SDLOG_TRAILER_SIZE  32u
+#define SDLOG_PAYLOAD_SIZE  (SDLOG_BLOCK_SIZE - SDLOG_TRAILER_SIZE)
+#define SDLOG_VERSION       1u
+#define SDLOG_NO_RECORD     0xFFFFu
+/** Index entries kept per file; decimated by doubling the stride when full. */
+#define SDLOG_INDEX_MAX     16u
+
+typedef enum {
+    SDLOG_BLOCK_DATA = 0,     /**< encoded samples */
+    SDLOG_BLOCK_HEADER = 1,   /**< per-file header (CSV/JSON header, PB metadata) */
+    SDLOG_BLOCK_INDEX = 2,    /**< trailing index, see SdLogIndex_t */
+} SdLogBlockType;
+
+/** What the producer knows about one append. */
+typedef struct {
+    uint32_t firstTs;   /**< timestamp of the first sample set */
+    uint32_t lastTs;    /**< timestamp of the last message's first sample set */
+    uint32_t samples;   /**< sample sets encoded */
+    uint32_t mapHash;   /**< channel map + encoding, see header comment */
+    uint8_t  type;      /**< SdLogBlockType (DATA or HEADER) */
+    uint8_t  scaleBits; /**< code scale of the samples, see trailer +26 */
+} SdLogMark_t;
+
+typedef struct {
+    uint32_t firstTs;
+    uint32_t lastTs;
+    uint32_t mapHash;
+    uint16_t samples;
+    uint16_t firstRecord;
+    uint16_t payloadLen;
+    uint16_t epoch;
+    uint8_t  type;
+    uint8_t  version;
+    uint8_t  scaleBits;
+} SdLogTrailer_t;
+
+typedef struct {
+    uint32_t block;     /**< block number in the file */
+    uint32_t firstTs;   /**< the block's trailer firstTs */
+    uint32_t epoch;     /**< the block's trailer epoch */
+} SdLogIndexEntry_t;
+
+/** Contents of the INDEX block's payload. */
+typedef struct {
+    uint32_t blocks;      /**< blocks ahead of the index block */
+    uint32_t dataBlocks;  /**< of which DATA */
+    uint32_t samples;     /**< sample sets in the file */
+    uint32_t firstTs;     /**< the file's first record (epoch 0) */
+    uint32_t lastTs;      /**< the file's last record */
+    uint32_t lastEpoch;   /**< epoch of lastTs */
+    uint32_t mapHash;
+    uint32_t scaleBits;   /**< the last record's, as mapHash */
+    uint32_t stride;      /**< every stride-th DATA block has an entry */
+    uint32_t count;
+    SdLogIndexEntry_t entries[SDLOG_INDEX_MAX];
+} SdLogIndex_t;
+
+/** Receives the container's bytes in file order; must take all of them. */
+typedef void (*SdLogSink_t)(void* ctx, const uint8_t* data, size_t len);
+
+/** Reads block @p block's trailer; false if unreadable or not a block. */
+typedef bool (*SdLogTrailerReader_t)(void* ctx, uint32_t block, SdLogTrailer_t* t);
+
+typedef struct {
+    SdLogTrailer_t open;  /* trailer being built for the open block */
+    uint32_t used;        /* payload bytes in the open block */
+    uint32_t crc;         /* running CRC-32 of the open block */
+    uint32_t prevTs;      /* lastTs of the previous DATA append */
+    uint32_t epoch;       /* epoch of prevTs */
+    bool     haveTs;
+    SdLogIndex_t index;
+} SdLogWriter_t;
+
+/** Encode @p t with its CRC into @p out; @p payloadCrc is the running
+ *  (unfinalized) CRC-32 of the block's payload and padding. */
+void SdLog_EncodeTrailer(const SdLogTrailer_t* t, uint32_t payloadCrc,
+                         uint8_t out[SDLOG_TRAILER_SIZE]);
+
+/** Decode a trailer without checking the CRC; false on a bad magic/version. */
+bool SdLog_DecodeTrailer(const uint8_t in[SDLOG_TRAILER_SIZE], SdLogTrailer_t* t);
+
+/** Decode a whole block's trailer and check its CRC. */
+bool SdLog_CheckBlock(const uint8_t block[SDLOG_BLOCK_SIZE], SdLogTrailer_t* t);
+
+/** Ticks from the file's first record (@p baseTs) to trailer @p t's firstTs. */
+int64_t SdLog_TrailerTicks(const SdLogTrailer_t* t, uint32_t baseTs);
+
+/** Empty index (stride 1). */
+void SdLogIndex_Init(SdLogIndex_t* ix);
+
+/** Account sealed block @p block, described by @p t, in the index. */
+void SdLogIndex_Note(SdLogIndex_t* ix, uint32_t block, const SdLogTrailer_t* t);
+
+/** Write @p ix as one INDEX block (payload, padding, trailer) through @p sink. */
+void SdLogIndex_Emit(const SdLogIndex_t* ix, SdLogSink_t sink, void* ctx);
+
+/** Decode an INDEX block's payload; false if it is not one. */
+bool SdLogIndex_Decode(const uint8_t* payload, size_t len, SdLogIndex_t* ix);
+
+/** Start a new file: nothing open, empty index. */
+void SdLogWriter_Begin(SdLogWriter_t* w);
+
+/**
+ * Ring bytes an append needs free: what it writes now plus what sealing
+ * the file afterwards will still write (padding, trailer, index block).
+ * Keeping every append within this means SdLogWriter_Finish always fits.
+ */
+size_t SdLogWriter_Cost(const SdLogWriter_t* w, size_t len, const SdLogMark_t* mark);
+
+/** Largest DATA append that fits in @p ringFree free ring bytes. */
+size_t SdLogWriter_Room(const SdLogWriter_t* w, size_t ringFree);
+
+/**
+ * Append @p len bytes described by @p mark. DATA records share blocks; a
+ * HEADER append (or a NULL mark) gets blocks of its own.
+ */
+void SdLogWriter_Append(SdLogWriter_t* w, const uint8_t* data, size_t len,
+                        const SdLogMark_t* mark, SdLogSink_t sink, void* ctx);
+
+/** Seal the open block, write the index block if anything was written, and
+ *  start over. */
+void SdLogWriter_Finish(SdLogWriter_t* w, SdLogSink_t sink, void* ctx);
+
+/**
+ * Blocks [*pFirst, *pLast] of an @p nblocks-block file that hold every record
+ * from @p t1 to @p t2 ticks after the file's first record -- widened to whole
+ * records, so the first block returned starts the record covering @p t1.
+ *
+ * @p index (NULL if the file has none) narrows the search; otherwise the
+ * file's first DATA block supplies the base timestamp.
+ *
+ * @return false if no record falls in the range
+ */
+bool SdLog_FindRange(uint32_t nblocks, const SdLogIndex_t* index,
+                     uint64_t t1, uint64_t t2,
+                     SdLogTrailerReader_t read, void* ctx,
+                     uint32_t* pFirst, uint32_t* pLast);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,121 @@
+#include "SdPartCache.h"
+#include <stddef.h>
+#include <string.h>
+
+static char SPC_Lower(char ch) {
+    return (ch >= 'A' && ch <= 'Z') ? (char)(ch - 'A' + 'a') : ch;
+}
+
+/* Case-insensitive prefix match; returns what follows the prefix, or NULL. */
+static const char* SPC_SkipPrefix(const char* s, const char* prefix) {
+    while (*prefix != '\0') {
+        if (SPC_Lower(*s) != SPC_Lower(*prefix)) {
+            return NULL;
+        }
+        s++;
+        prefix++;
+    }
+    return s;
+}
+
+void SdPartCache_Init(SdPartCache_t* c) {
+    memset(c, 0, sizeof(*c));
+    c->complete = true;
+}
+
+void SdPartCache_Invalidate(SdPartCache_t* c) {
+    c->complete = false;
+}
+
+bool SdPartCache_ParseName(const char* name, const char* base, const char* file,
+                           uint32_t* pCounter) {
+    const char* rest = SPC_SkipPrefix(name, file);
+    if (rest != NULL && *rest == '\0') {
+        *pCounter = 0u;
+        return true;
+    }
+    rest = SPC_SkipPrefix(name, base);
+    if (rest == NULL || *rest != '-' || rest[1] < '1' || rest[1] > '9') {
+        return false;
+    }
+    rest++;
+    uint32_t n = 0u;
+    int digits = 0;
+    while (*rest >= '0' && *rest <= '9') {
+        if (++digits > 9) {
+            return false;   /* the manager never writes a counter this long */
+        }
+        n = n * 10u + (uint32_t)(*rest - '0');
+        rest++;
+    }
+    const char* ext = strrchr(file, '.');
+    rest = SPC_SkipPrefix(rest, (ext != NULL) ? ext : "");
+    if (rest == NULL || *rest != '\0') {
+        return false;
+    }
+    *pCounter = n;
+    return true;
+}
+
+void SdPartCache_Note(SdPartCache_t* c, const char* name, const char* base,
+                      const char* file) {
+    uint32_t n;
+    if (!SdPartCache_ParseName(name, base, file, &n)) {
+        return;
+    }
+    if (n == 0u) {
+        c->base = true;
+        return;
+    }
+    if (c->count == 0u) {
+        c->lo = n;
+        c->hi = n;
+    } else {
+        if (n < c->lo) c->lo = n;
+        if (n > c->hi) c->hi = n;
+    }
+    c->count++;
+}
+
+bool SdPartCache_Lookup(const SdPartCache_t* c, uint32_t counter, bool* pPresent) {
+    if (!c->complete) {
+        return false;
+    }
+    if (counter == 0u) {
+        *pPresent = c->base;
+        return true;
+    }
+    if (c->count == 0u || counter < c->lo || counter > c->hi) {
+        *pPresent = false;
+        return true;
+    }
+    if (c->count == c->hi - c->lo + 1u) {
+        *pPresent = true;
+        return true;
+    }
+    return false;           /* inside a range with holes */
+}
+
+void SdPartCache_Add(SdPartCache_t* c, uint32_t counter) {
+    bool present;
+    if (counter == 0u) {
+        c->base = true;
+        return;
+    }
+    if (!SdPartCache_Lookup(c, counter, &present) || present) {
+        return;             /* unknown stays unknown; a reopen adds nothing */
+    }
+    if (c->count == 0u) {
+        c->lo = counter;
+        c->hi = counter;
+    } else if (counter == c->hi + 1u) {
+        c->hi = counter;
+    } else if (counter + 1u == c->lo) {
+        c->lo = counter;
+    } else {
+        /* Not adjacent: the range would gain holes it cannot describe. */
+        SdPartCache_Invalidate(c);
+        return;
+    }
+    c->count++;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * SD Part Cache — which split-file parts a bucket directory already holds
+ *
+ * A split log is written as "<file>" (part 0), then "<base>-1<ext>",
+ * "<base>-2<ext>", ... into bucket directories of at most a few dozen
+ * entries. Before creating a part the SD manager has to know whether that
+ * name is already taken in the active bucket -- an existing part is reopened
+ * in place rather than counted as a new directory entry. Asking FatFs means a
+ * stat, which is a scan of the directory; this cache answers from the one
+ * walk the manager already makes when it enters a bucket.
+ *
+ * The numbered parts are kept as a range plus a count. Parts a session writes
+ * are consecutive, so the range is exact in every directory this firmware
+ * produced; when it is not (a part deleted on a PC, or the walk stopped
+ * early), the cache says so and the caller falls back to the stat.
+ *
+ * Names compare case-insensitively (ASCII), as FatFs matches them. Counters
+ * are the decimal the manager writes: no sign, no leading zero.
+ *
+ * THREAD-SAFETY: none; owned by the SD manager task.
+ */
+
+typedef struct {
+    uint32_t lo;        /* lowest numbered part seen */
+    uint32_t hi;        /* highest numbered part seen */
+    uint32_t count;     /* numbered parts seen; the range is exact when == hi - lo + 1 */
+    bool     base;      /* part 0, the un-numbered "<file>" */
+    bool     complete;  /* the walk saw every entry, so absence is known */
+} SdPartCache_t;
+
+/** An empty, complete cache: what a walk of an empty directory produces. */
+void SdPartCache_Init(SdPartCache_t* c);
+
+/** The walk stopped early or failed: every lookup answers "unknown" from now on. */
+void SdPartCache_Invalidate(SdPartCache_t* c);
+
+/**
+ * Is @p name a part of the log @p file (extension included) whose numbered
+ * parts use @p base (the file name without its extension)?
+ *
+ * @return true and the part's counter (0 for @p file itself) in @p pCounter
+ */
+bool SdPartCache_ParseName(const char* name, const char* base, const char* file,
+                           uint32_t* pCounter);
+
+/** Walk step: record one directory entry; names that are not parts are ignored. */
+void SdPartCache_Note(SdPartCache_t* c, const char* name, const char* base,
+                      const char* file);
+
+/**
+ * Does the directory hold part @p counter?
+ *
+ * @return false when the cache cannot tell (stat instead); otherwise true,
+ *         with the answer in @p pPresent
+ */
+bool SdPartCache_Lookup(const SdPartCache_t* c, uint32_t counter, bool* pPresent);
+
+/** Part @p counter was just created in the directory. */
+void SdPartCache_Add(SdPartCache_t* c, uint32_t counter);
+
+#ifdef __cplusplus
+}
+#endif
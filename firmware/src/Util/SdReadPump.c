@@ -0,0 +1,95 @@
+#include "SdReadPump.h"
+#include "CRC32.h"
+
+size_t SdReadPump_BlockHeader(uint8_t out[SD_READ_PUMP_HEADER_MAX], uint32_t len) {
+    uint8_t digits[SD_READ_PUMP_HEADER_MAX - 2u];
+    size_t n = 0;
+    do {
+        digits[n++] = (uint8_t)('0' + (len % 10u));
+        len /= 10u;
+    } while (len != 0u);
+    out[0] = '#';
+    out[1] = (uint8_t)('0' + n);
+    for (size_t i = 0; i < n; i++) {
+        out[2 + i] = digits[n - 1u - i];
+    }
+    return n + 2u;
+}
+
+static void SdReadPump_PutCrc(uint8_t* out, uint32_t crc) {
+    out[0] = (uint8_t)(crc >> 24);
+    out[1] = (uint8_t)(crc >> 16);
+    out[2] = (uint8_t)(crc >> 8);
+    out[3] = (uint8_t)crc;
+}
+
+bool SdReadPump_SendEnd(const SdReadPumpIo_t* io) {
+    uint8_t end[SD_READ_PUMP_HEADER_MAX + SD_READ_PUMP_CRC_SIZE];
+    size_t n = SdReadPump_BlockHeader(end, 0u);
+    SdReadPump_PutCrc(end + n, CRC32_Compute(end, 0u));
+    return io->send(io->ctx, end, n + SD_READ_PUMP_CRC_SIZE);
+}
+
+SdReadPumpResult SdReadPump_Run(const SdReadPumpIo_t* io, uint8_t* buf, size_t bufSize,
+                                uint64_t length, bool framed, uint64_t* pSent) {
+    *pSent = 0;
+    if (bufSize < SD_READ_PUMP_MIN_BUFFER) {
+        return SD_READ_PUMP_BAD_BUFFER;
+    }
+    /* Halves are whole sectors; framed chunks leave a sector's room at the
+     * end of theirs for the CRC, so the card read stays sector-sized. */
+    size_t half = (bufSize / 2u) / SD_READ_PUMP_SECTOR * SD_READ_PUMP_SECTOR;
+    size_t cap = framed ? half - SD_READ_PUMP_SECTOR : half;
+    const uint8_t* pending = NULL;
+    size_t pendingLen = 0;
+    uint32_t cur = 0;
+
+    for (;;) {
+        if (io->aborted(io->ctx)) {
+            return SD_READ_PUMP_ABORTED;
+        }
+        uint8_t* chunk = buf + cur * half;
+        size_t want = (length < cap) ? (size_t)length : cap;
+        size_t n = (want > 0u) ? io->read(io->ctx, chunk, want) : 0u;
+
+        /* The read overlapped the transport draining the previous chunk;
+         * finish that chunk before anything of this one goes out. */
+        if (pendingLen > 0u && !io->send(io->ctx, pending, pendingLen)) {
+            return SD_READ_PUMP_ABORTED;
+        }
+        pendingLen = 0;
+
+        if (n == (size_t)-1) {
+            return SD_READ_PUMP_READ_ERROR;
+        }
+        if (n == 0u) {
+            if (framed && !SdReadPump_SendEnd(io)) {
+                return SD_READ_PUMP_ABORTED;
+            }
+            return SD_READ_PUMP_DONE;
+        }
+        if (n > want) {
+            n = want;
+        }
+
+        size_t len = n;
+        if (framed) {
+            uint8_t hdr[SD_READ_PUMP_HEADER_MAX];
+            size_t hdrLen = SdReadPump_BlockHeader(hdr, (uint32_t)n);
+            if (!io->send(io->ctx, hdr, hdrLen)) {
+                return SD_READ_PUMP_ABORTED;
+            }
+            SdReadPump_PutCrc(chunk + n, CRC32_Compute(chunk, n));
+            len += SD_READ_PUMP_CRC_SIZE;
+        }
+        size_t taken = io->trySend(io->ctx, chunk, len);
+        if (taken > len) {
+            taken = len;
+        }
+        pending = chunk + taken;
+        pendingLen = len - taken;
+        *pSent += n;
+        length -= n;
+        cur ^= 1u;
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * SD Read Pump — the SD:GET transfer loop, double-buffered and optionally framed
+ *
+ * The buffer is split into two halves. While one half's chunk is still being
+ * pushed to the reply transport, the next chunk is read from the card into
+ * the other; the previous chunk is finished only after that read returns. A
+ * chunk is first offered without waiting (trySend takes what fits), so the
+ * reply ring is full when the card read starts and the USB / TCP task drains
+ * it underneath the SPI transfer, instead of the two taking turns.
+ *
+ * Framed mode (SD:GET "file",offset,length) sends every chunk as an IEEE
+ * 488.2 definite-length block followed by the CRC-32 of its bytes:
+ *
+ *     #<n><len><len bytes><crc32, 4 bytes big-endian>
+ *
+ * and ends with an empty block, "#10" and a zero CRC. A host checks each
+ * block as it arrives; after an abort or a bad CRC it re-requests from the
+ * requested offset plus the bytes of the blocks that checked. Unframed mode
+ * is the plain byte stream SD:GET always sent.
+ *
+ * Chunks go out whole and in order; a read error or an abort returns at a
+ * chunk boundary, so whatever the caller sends next (an error marker) never
+ * lands inside a block.
+ *
+ * THREAD-SAFETY: none; runs on the SD task.
+ */
+
+/** Longest block header: '#', the digit count, nine length digits (488.2
+ *  allows at most nine; a chunk is never near 10^9 bytes). */
+#define SD_READ_PUMP_HEADER_MAX  11u
+#define SD_READ_PUMP_CRC_SIZE    4u
+/** Chunks are whole multiples of this (the card's sector size). */
+#define SD_READ_PUMP_SECTOR      512u
+/** Smallest buffer Run accepts: two halves holding a sector and a CRC. */
+#define SD_READ_PUMP_MIN_BUFFER  (4u * SD_READ_PUMP_SECTOR)
+
+typedef enum {
+    SD_READ_PUMP_DONE = 0,      /**< all of @p length sent (or the file ended) */
+    SD_READ_PUMP_ABORTED = 1,   /**< aborted() or send() gave up */
+    SD_READ_PUMP_READ_ERROR = 2,
+    SD_READ_PUMP_BAD_BUFFER = 3,/**< buffer below SD_READ_PUMP_MIN_BUFFER */
+} SdReadPumpResult;
+
+typedef struct {
+    /** Reads up to @p len bytes; returns bytes read, 0 at EOF, (size_t)-1 on error. */
+    size_t (*read)(void* ctx, uint8_t* buf, size_t len);
+    /** Takes what fits now without waiting; returns the bytes taken. */
+    size_t (*trySend)(void* ctx, const uint8_t* data, size_t len);
+    /** Sends all of @p len, waiting as needed; false if the transfer was given up. */
+    bool   (*send)(void* ctx, const uint8_t* data, size_t len);
+    /** True once the transfer should stop (checked once per chunk). */
+    bool   (*aborted)(void* ctx);
+    void*  ctx;
+} SdReadPumpIo_t;
+
+/** Write "#<n><len>" for @p len (< 10^9) into @p out; returns its length. */
+size_t SdReadPump_BlockHeader(uint8_t out[SD_READ_PUMP_HEADER_MAX], uint32_t len);
+
+/** Send the framed-mode terminator (empty block). False if send() gave up. */
+bool SdReadPump_SendEnd(const SdReadPumpIo_t* io);
+
+/**
+ * Send up to @p length bytes from io->read. Framed mode also sends the
+ * terminator after the last chunk. @p pSent receives the payload bytes
+ * handed to the transport, complete chunks or not.
+ */
+SdReadPumpResult SdReadPump_Run(const SdReadPumpIo_t* io, uint8_t* buf, size_t bufSize,
+                                uint64_t length, bool framed, uint64_t* pSent);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,98 @@
+#include "SdWriteSlots.h"
+#include <string.h>
+
+/* Counters run free (uint32_t, wrapping); the slot is the low bits, so the
+ * count is kept a power of two. */
+#define SWS_SLOT(s, seq) (&(s)->slot[(seq) & ((s)->count - 1u)])
+
+bool SdWriteSlots_Init(SdWriteSlots_t* s, uint8_t* buf, uint32_t size,
+                       uint32_t count, uint32_t align) {
+    if (s == NULL) return false;
+    memset(s, 0, sizeof(*s));
+    if (buf == NULL || align == 0u || count == 0u) {
+        return false;
+    }
+    if (count > SD_WRITE_SLOTS_MAX) count = SD_WRITE_SLOTS_MAX;
+    while ((count & (count - 1u)) != 0u) {
+        count &= count - 1u;
+    }
+    /* Fewer, aligned slots rather than unaligned ones: a slot that is not a
+     * sector multiple sends FatFs through its single-sector window copy. */
+    while (count > 0u && (size / count) / align == 0u) {
+        count >>= 1;
+    }
+    if (count == 0u) {
+        return false;
+    }
+    s->buf = buf;
+    s->bufSize = size;
+    s->count = count;
+    s->slotSize = ((size / count) / align) * align;
+    for (uint32_t i = 0; i < count; i++) {
+        s->slot[i].data = buf + i * s->slotSize;
+    }
+    return true;
+}
+
+uint8_t* SdWriteSlots_Acquire(SdWriteSlots_t* s, uint32_t* pCap) {
+    *pCap = 0u;
+    if (s->count == 0u || (uint32_t)(s->submitted - s->reaped) >= s->count) {
+        return NULL;
+    }
+    *pCap = s->slotSize;
+    return SWS_SLOT(s, s->submitted)->data;
+}
+
+void SdWriteSlots_Submit(SdWriteSlots_t* s, uint32_t len) {
+    if (s->count == 0u || (uint32_t)(s->submitted - s->reaped) >= s->count) {
+        return;
+    }
+    SdWriteSlot_t* slot = SWS_SLOT(s, s->submitted);
+    slot->len = (len > s->slotSize) ? s->slotSize : len;
+    slot->done = 0u;
+    s->submitted++;
+}
+
+bool SdWriteSlots_Service(SdWriteSlots_t* s, SdWriteSlots_WriteFn write, void* ctx) {
+    if (s->completed == s->submitted) {
+        return false;
+    }
+    SdWriteSlot_t* slot = SWS_SLOT(s, s->completed);
+    uint32_t done = 0u;
+    if (!s->failed) {
+        while (done < slot->len) {
+            int n = write(ctx, slot->data + done, slot->len - done);
+            if (n <= 0) {
+                break;
+            }
+            done += ((uint32_t)n > slot->len - done) ? slot->len - done : (uint32_t)n;
+        }
+        if (done < slot->len) {
+            s->failed = true;
+        }
+    }
+    slot->done = done;
+    s->completed++;
+    return true;
+}
+
+const SdWriteSlot_t* SdWriteSlots_Reap(const SdWriteSlots_t* s) {
+    if (s->reaped == s->completed) {
+        return NULL;
+    }
+    return SWS_SLOT(s, s->reaped);
+}
+
+void SdWriteSlots_Release(SdWriteSlots_t* s) {
+    if (s->reaped != s->completed) {
+        s->reaped++;
+    }
+}
+
+uint32_t SdWriteSlots_InFlight(const SdWriteSlots_t* s) {
+    return (uint32_t)(s->submitted - s->completed);
+}
+
+uint32_t SdWriteSlots_Outstanding(const SdWriteSlots_t* s) {
+    return (uint32_t)(s->submitted - s->reaped);
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * SD Write Slots — ping-pong (N-deep) staging for the SD log writer
+ *
+ * The SD write buffer is carved into N equal, sector-multiple slots. The SD
+ * manager (the producer) stages the next chunk from the circular buffer into
+ * a free slot and submits it; a writer task takes submitted slots in order,
+ * puts each on the card, and completes it; the manager then reaps the
+ * completed slot (accounting, CRC) and reuses it. With two slots the copy of
+ * chunk k+1 overlaps the SPI transfer of chunk k instead of following it.
+ *
+ * Slots move strictly in order through three free-running counters:
+ *
+ *     reaped <= completed <= submitted <= reaped + count
+ *
+ * A chunk is written completely before the next one starts (short writes are
+ * retried inside the slot), so the file is the submitted chunks in order. If
+ * a slot fails, every later slot is completed WITHOUT being written -- a gap
+ * in the middle of a log is worse than a truncated one -- and reports
+ * done == 0 so the producer can count what was lost.
+ *
+ * THREAD-SAFETY: single producer (Init, Acquire, Submit, Reap, Release) and
+ * single writer (Service). The counters are volatile, but
+ * the slot contents are plain memory: the firmware pairs every Submit and
+ * every Complete with a semaphore give, which is also what orders them.
+ */
+
+#define SD_WRITE_SLOTS_MAX  4
+
+typedef struct {
+    uint8_t*          data;
+    volatile uint32_t len;      /* staged bytes */
+    volatile uint32_t done;     /* bytes that reached the card (== len on success) */
+} SdWriteSlot_t;
+
+typedef struct {
+    SdWriteSlot_t     slot[SD_WRITE_SLOTS_MAX];
+    uint8_t*          buf;          /* what the slots were carved from */
+    uint32_t          bufSize;
+    uint32_t          count;        /* a power of two */
+    uint32_t          slotSize;
+    volatile uint32_t submitted;    /* producer */
+    volatile uint32_t completed;    /* writer */
+    uint32_t          reaped;       /* producer */
+    volatile bool     failed;       /* writer: a slot came back short */
+} SdWriteSlots_t;
+
+/** Writes up to @p len bytes; returns bytes written, 0 for no progress, <0 on error. */
+typedef int (*SdWriteSlots_WriteFn)(void* ctx, const uint8_t* data, uint32_t len);
+
+/**
+ * Carve @p size bytes at @p buf into up to @p count slots, each a multiple of
+ * @p align bytes. The count is rounded down to a power of two, and halved
+ * while the buffer is too small for that many aligned slots.
+ *
+ * @return false if not even one aligned slot fits (instance left empty)
+ */
+bool SdWriteSlots_Init(SdWriteSlots_t* s, uint8_t* buf, uint32_t size,
+                       uint32_t count, uint32_t align);
+
+/** Producer: the next free slot and its capacity, or NULL when all are outstanding. */
+uint8_t* SdWriteSlots_Acquire(SdWriteSlots_t* s, uint32_t* pCap);
+
+/** Producer: hand the acquired slot, holding @p len staged bytes, to the writer. */
+void SdWriteSlots_Submit(SdWriteSlots_t* s, uint32_t len);
+
+/**
+ * Writer: put the oldest submitted slot on the card through @p write,
+ * retrying short writes, and complete it. Once a slot has failed, later
+ * slots are completed unwritten.
+ *
+ * @return false when nothing was submitted
+ */
+bool SdWriteSlots_Service(SdWriteSlots_t* s, SdWriteSlots_WriteFn write, void* ctx);
+
+/** Producer: the oldest completed, unreaped slot, or NULL. */
+const SdWriteSlot_t* SdWriteSlots_Reap(const SdWriteSlots_t* s);
+
+/** Producer: return the slot Reap handed out to the free list. */
+void SdWriteSlots_Release(SdWriteSlots_t* s);
+
+/** Slots submitted and not yet completed by the writer. */
+uint32_t SdWriteSlots_InFlight(const SdWriteSlots_t* s);
+
+/** Slots submitted and not yet released by the producer. */
+uint32_t SdWriteSlots_Outstanding(const SdWriteSlots_t* s);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,216 @@
+#include "SharedBlockQueue.h"
+#include <string.h>
+
+/* Sequence numbers run free (uint32_t, wrapping); a slot is the low bits.
+ * head..tail never spans more than the ring, so equality is the only
+ * comparison ever made between them and a cursor. */
+#define SBQ_SLOT(q, seq) ((seq) & (q)->slotMask)
+#define SBQ_ATTACHED(q, c) ((((q)->attached >> (c)) & 1u) != 0u)
+
+bool SharedBlockQueue_Init(SharedBlockQueue_t* q, SharedBlock_t* blocks,
+                           uint32_t slots, uint8_t* arena, uint32_t size,
+                           uint8_t consumers, uint32_t maxBlock) {
+    if (q == NULL) return false;
+    memset(q, 0, sizeof(*q));
+    if (blocks == NULL || slots < 2u || (slots & (slots - 1u)) != 0u ||
+        arena == NULL || size == 0u || consumers == 0u ||
+        consumers > SBQ_MAX_CONSUMERS) {
+        return false;
+    }
+    q->blocks = blocks;
+    q->slotMask = slots - 1u;
+    q->arena = arena;
+    q->size = size;
+    q->maxBlock = (maxBlock == 0u || maxBlock > size) ? size : maxBlock;
+    q->consumers = consumers;
+    q->attached = (uint8_t)((1u << consumers) - 1u);
+    return true;
+}
+
+/* Free contiguous room for the next block and where it starts. Live data is
+ * [first, end) when unwrapped -- room after it, else wrap to 0 and use the
+ * room before it -- or [first, size) + [0, end) when wrapped. */
+static uint32_t SharedBlockQueue_Room(const SharedBlockQueue_t* q, uint32_t minLen,
+                                      uint32_t* pOffset) {
+    if (q->head == q->tail) {
+        *pOffset = 0u;
+        return q->size;
+    }
+    const SharedBlock_t* first = &q->blocks[SBQ_SLOT(q, q->head)];
+    const SharedBlock_t* last = &q->blocks[SBQ_SLOT(q, q->tail - 1u)];
+    uint32_t end = last->offset + last->len;
+    if (last->offset >= first->offset) {
+        if (q->size - end >= minLen) {
+            *pOffset = end;
+            return q->size - end;
+        }
+        *pOffset = 0u;
+        return first->offset;
+    }
+    *pOffset = end;
+    return first->offset - end;
+}
+
+/* Drop leading blocks every consumer has finished. */
+static void SharedBlockQueue_Reclaim(SharedBlockQueue_t* q) {
+    while (q->head != q->tail && q->blocks[SBQ_SLOT(q, q->head)].refs == 0u) {
+        q->head++;
+    }
+}
+
+/* Evict the oldest block from every consumer still holding it. Refused if one
+ * of them is part-way through it: the transport has already sent the front
+ * of that block, and skipping the rest would tear a message in two. Refused
+ * too if one of them is kept: that one is waited for instead. */
+static bool SharedBlockQueue_Evict(SharedBlockQueue_t* q, SharedBlockDrops_t* pDrops) {
+    const SharedBlock_t* b = &q->blocks[SBQ_SLOT(q, q->head)];
+    uint8_t c;
+    for (c = 0; c < q->consumers; c++) {
+        if (SBQ_ATTACHED(q, c) && q->cursor[c].next == q->head &&
+            (q->cursor[c].offset != 0u || ((q->keep >> c) & 1u) != 0u)) {
+            return false;
+        }
+    }
+    for (c = 0; c < q->consumers; c++) {
+        if (SBQ_ATTACHED(q, c) && q->cursor[c].next == q->head) {
+            pDrops->bytes[c] += b->len;
+            pDrops->blocks[c]++;
+            q->cursor[c].next++;
+        }
+    }
+    q->head++;
+    SharedBlockQueue_Reclaim(q);
+    return true;
+}
+
+uint8_t* SharedBlockQueue_Reserve(SharedBlockQueue_t* q, uint32_t minLen,
+                                  uint32_t* pSpan, SharedBlockDrops_t* pDrops) {
+    memset(pDrops, 0, sizeof(*pDrops));
+    *pSpan = 0u;
+    q->reserved = false;
+    if (q->arena == NULL || minLen > q->maxBlock) {
+        return NULL;
+    }
+    for (;;) {
+        uint32_t offset;
+        uint32_t room = SharedBlockQueue_Room(q, minLen, &offset);
+        if (room >= minLen && (uint32_t)(q->tail - q->head) <= q->slotMask) {
+            if (room > q->maxBlock) room = q->maxBlock;
+            q->resOffset = offset;
+            q->resLen = room;
+            q->reserved = true;
+            *pSpan = room;
+            return q->arena + offset;
+        }
+        if (q->head == q->tail || !SharedBlockQueue_Evict(q, pDrops)) {
+            return NULL;
+        }
+    }
+}
+
+void SharedBlockQueue_Commit(SharedBlockQueue_t* q, uint32_t len) {
+    if (!q->reserved) return;
+    q->reserved = false;
+    if (len == 0u) return;
+    if (len > q->resLen) len = q->resLen;
+    SharedBlock_t* b = &q->blocks[SBQ_SLOT(q, q->tail)];
+    uint8_t refs = 0u;
+    uint8_t c;
+    for (c = 0; c < q->consumers; c++) {
+        if (SBQ_ATTACHED(q, c)) refs++;
+    }
+    b->offset = q->resOffset;
+    b->len = len;
+    b->refs = refs;
+    q->tail++;
+    SharedBlockQueue_Reclaim(q);    /* nobody attached: gone at once */
+}
+
+const uint8_t* SharedBlockQueue_Peek(const SharedBlockQueue_t* q, uint8_t c,
+                                     uint32_t maxLen, uint32_t* pLen) {
+    *pLen = 0u;
+    if (c >= q->consumers || !SBQ_ATTACHED(q, c) ||
+        q->cursor[c].next == q->tail || maxLen == 0u) {
+        return NULL;
+    }
+    const SharedBlockCursor_t* cur = &q->cursor[c];
+    const SharedBlock_t* b = &q->blocks[SBQ_SLOT(q, cur->next)];
+    if (cur->offset != 0u) {
+        uint32_t rest = b->len - cur->offset;
+        *pLen = (rest < maxLen) ? rest : maxLen;
+        return q->arena + b->offset + cur->offset;
+    }
+    if (b->len > maxLen) {
+        return NULL;
+    }
+    uint32_t len = b->len;
+    uint32_t end = b->offset + b->len;
+    uint32_t seq;
+    for (seq = cur->next + 1u; seq != q->tail; seq++) {
+        const SharedBlock_t* n = &q->blocks[SBQ_SLOT(q, seq)];
+        if (n->offset != end || n->len > maxLen - len) break;
+        len += n->len;
+        end += n->len;
+    }
+    *pLen = len;
+    return q->arena + b->offset;
+}
+
+uint32_t SharedBlockQueue_Consume(SharedBlockQueue_t* q, uint8_t c, uint32_t n) {
+    if (c >= q->consumers || !SBQ_ATTACHED(q, c)) return 0u;
+    SharedBlockCursor_t* cur = &q->cursor[c];
+    uint32_t done = 0u;
+    while (n > 0u && cur->next != q->tail) {
+        SharedBlock_t* b = &q->blocks[SBQ_SLOT(q, cur->next)];
+        uint32_t rest = b->len - cur->offset;
+        if (n < rest) {
+            cur->offset += n;
+            done += n;
+            break;
+        }
+        n -= rest;
+        done += rest;
+        cur->offset = 0u;
+        cur->next++;
+        if (b->refs > 0u) b->refs--;
+    }
+    SharedBlockQueue_Reclaim(q);
+    return done;
+}
+
+uint32_t SharedBlockQueue_Pending(const SharedBlockQueue_t* q, uint8_t c) {
+    if (c >= q->consumers || !SBQ_ATTACHED(q, c)) return 0u;
+    const SharedBlockCursor_t* cur = &q->cursor[c];
+    uint32_t pending = 0u;
+    uint32_t seq;
+    for (seq = cur->next; seq != q->tail; seq++) {
+        pending += q->blocks[SBQ_SLOT(q, seq)].len;
+    }
+    return pending - cur->offset;
+}
+
+uint32_t SharedBlockQueue_Discard(SharedBlockQueue_t* q, uint8_t c) {
+    return SharedBlockQueue_Consume(q, c, SharedBlockQueue_Pending(q, c));
+}
+
+void SharedBlockQueue_Attach(SharedBlockQueue_t* q, uint8_t c) {
+    if (c >= q->consumers || SBQ_ATTACHED(q, c)) return;
+    q->cursor[c].next = q->tail;
+    q->cursor[c].offset = 0u;
+    q->attached |= (uint8_t)(1u << c);
+}
+
+uint32_t SharedBlockQueue_Detach(SharedBlockQueue_t* q, uint8_t c) {
+    if (c >= q->consumers || !SBQ_ATTACHED(q, c)) return 0u;
+    uint32_t lost = SharedBlockQueue_Discard(q, c);
+    q->attached &= (uint8_t)~(1u << c);
+    return lost;
+}
+
+bool SharedBlockQueue_IsAttached(const SharedBlockQueue_t* q, uint8_t c) {
+    return c < q->consumers && SBQ_ATTACHED(q, c);
+}
+
+void SharedBlockQueue_SetKeep(SharedBlockQueue_t* q, uint8_t mask) {
+    q->keep = mask;
+}
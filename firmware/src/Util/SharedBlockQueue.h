@@ -0,0 +1,158 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Shared Block Queue — one encoded copy, several readers
+ *
+ * An arena of variable-length blocks that every consumer reads through its
+ * own cursor. The producer encodes each batch ONCE into a block; each block
+ * carries a reference count (one per consumer) and its bytes are reclaimed
+ * only when the last consumer has finished with it. USB+SD streaming uses
+ * it so a batch is neither encoded nor copied once per transport, and so a
+ * slow consumer backs up only its own cursor.
+ *
+ * Allocation is contiguous (bip-buffer style): a block never straddles the
+ * end of the arena. When the tail does not have room the allocator wraps to
+ * offset 0 and the unused tail is skipped until the oldest block is reclaimed.
+ *
+ * Overflow is per consumer. When the producer needs room and the oldest
+ * block is still referenced, that block is EVICTED: every consumer still
+ * holding it skips it, and the bytes are reported back to the producer
+ * per consumer (SharedBlockDrops_t) so each transport's drop counter sees
+ * only its own loss. A consumer that keeps up never loses anything to a
+ * consumer that does not, as long as the arena holds the slower one's lag.
+ *
+ * Consumers read whole blocks: Peek never splits one, so a block must fit
+ * in what every consumer can accept at once (maxBlock at Init). A consumer
+ * may still Consume part of a block (a short transport write); the block is
+ * then PINNED and cannot be evicted until that consumer finishes it.
+ *
+ * Consumers can come and go (WiFi TCP clients connecting mid-session): a
+ * DETACHED consumer holds no references and is never charged, and one that
+ * attaches starts at the next block published. A consumer may also be KEPT:
+ * its blocks are never evicted, so Reserve fails instead and the producer
+ * waits for it -- the backpressure the primary transport wants, while the
+ * others still lose only their own backlog.
+ *
+ * THREAD-SAFETY: none. One producer and any number of consumer calls may
+ * share an instance only under one external lock (see gFanoutMutex in
+ * streaming.c). Between Reserve and Commit the reserved span belongs to the
+ * producer alone, so the encode itself can run outside that lock.
+ */
+
+#define SBQ_MAX_CONSUMERS   4
+
+typedef struct {
+    uint32_t offset;        /* start in the arena */
+    uint32_t len;
+    uint8_t  refs;          /* consumers that have not finished this block */
+} SharedBlock_t;
+
+typedef struct {
+    uint32_t next;          /* sequence number of the next block to read */
+    uint32_t offset;        /* bytes of that block already consumed */
+} SharedBlockCursor_t;
+
+/** Bytes/blocks each consumer lost to evictions in one Reserve call. */
+typedef struct {
+    uint32_t bytes[SBQ_MAX_CONSUMERS];
+    uint32_t blocks[SBQ_MAX_CONSUMERS];
+} SharedBlockDrops_t;
+
+typedef struct {
+    uint8_t*  arena;
+    uint32_t  size;
+    SharedBlock_t* blocks;  /* descriptor ring, caller-owned */
+    uint32_t  slotMask;     /* descriptors - 1 (a power of two) */
+    uint32_t  maxBlock;     /* largest span Reserve hands out */
+    uint32_t  head;         /* sequence number of the oldest live block */
+    uint32_t  tail;         /* sequence number the next Commit publishes */
+    uint32_t  resOffset;    /* current reservation (valid while reserved) */
+    uint32_t  resLen;
+    bool      reserved;
+    uint8_t   consumers;
+    uint8_t   attached;     /* bit per consumer; all of them after Init */
+    uint8_t   keep;         /* bit per consumer whose blocks are never evicted */
+    SharedBlockCursor_t cursor[SBQ_MAX_CONSUMERS];
+} SharedBlockQueue_t;
+
+/**
+ * Initialize an empty queue over caller-owned memory.
+ *
+ * @param blocks     descriptor ring; @p slots is a power of two >= 2 and caps
+ *                   how many blocks can be live at once (the producer evicts
+ *                   when it runs out, as when the arena does)
+ * @param consumers  readers, 1..SBQ_MAX_CONSUMERS
+ * @param maxBlock   largest block (0 = size); every consumer must be able to
+ *                   take a block this size in one Peek
+ * @return false on a bad argument (queue left unusable)
+ */
+bool SharedBlockQueue_Init(SharedBlockQueue_t* q, SharedBlock_t* blocks,
+                           uint32_t slots, uint8_t* arena, uint32_t size,
+                           uint8_t consumers, uint32_t maxBlock);
+
+/**
+ * Reserve a contiguous span of at least @p minLen bytes for the next block,
+ * evicting the oldest blocks if that is the only way to get it.
+ *
+ * @param[out] pSpan   usable length (>= minLen, <= maxBlock)
+ * @param[out] pDrops  per-consumer eviction losses from this call (zeroed first)
+ * @return the span, or NULL if minLen cannot be had: larger than maxBlock or
+ *         the arena, or the room is held by a pinned block or a kept consumer
+ */
+uint8_t* SharedBlockQueue_Reserve(SharedBlockQueue_t* q, uint32_t minLen,
+                                  uint32_t* pSpan, SharedBlockDrops_t* pDrops);
+
+/**
+ * Publish the first @p len bytes of the reservation as one block for every
+ * consumer. 0 releases the reservation without publishing anything.
+ */
+void SharedBlockQueue_Commit(SharedBlockQueue_t* q, uint32_t len);
+
+/**
+ * The run of whole, arena-contiguous blocks consumer @p c should read next,
+ * at most @p maxLen bytes (or the rest of a block it has partly consumed).
+ *
+ * @return NULL when there is nothing pending, or the next block does not fit
+ *         @p maxLen
+ */
+const uint8_t* SharedBlockQueue_Peek(const SharedBlockQueue_t* q, uint8_t c,
+                                     uint32_t maxLen, uint32_t* pLen);
+
+/** Advance consumer @p c by @p n bytes; reclaims blocks nobody still needs. */
+uint32_t SharedBlockQueue_Consume(SharedBlockQueue_t* q, uint8_t c, uint32_t n);
+
+/** Bytes published and not yet consumed by @p c. */
+uint32_t SharedBlockQueue_Pending(const SharedBlockQueue_t* q, uint8_t c);
+
+/** Drop everything pending for @p c (its own backlog only); returns the bytes. */
+uint32_t SharedBlockQueue_Discard(SharedBlockQueue_t* q, uint8_t c);
+
+/**
+ * Start (or keep) reading with consumer @p c. A consumer that was detached
+ * starts at the next block Commit publishes; nothing already queued is its.
+ */
+void SharedBlockQueue_Attach(SharedBlockQueue_t* q, uint8_t c);
+
+/**
+ * Stop reading with consumer @p c: its backlog is dropped, as by Discard,
+ * and later blocks are published without a reference for it.
+ * @return the backlog bytes dropped
+ */
+uint32_t SharedBlockQueue_Detach(SharedBlockQueue_t* q, uint8_t c);
+
+bool SharedBlockQueue_IsAttached(const SharedBlockQueue_t* q, uint8_t c);
+
+/** Consumers (bit per consumer) whose blocks Reserve must not evict. */
+void SharedBlockQueue_SetKeep(SharedBlockQueue_t* q, uint8_t mask);
+
+#ifdef __cplusplus
+}
+#endif
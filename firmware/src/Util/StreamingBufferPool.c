@@ -62,8 +62,9 @@ void StreamingBufferPool_Partition(uint32_t usbSize, uint32_t wifiSize,
         sampleElementSize = AInSampleList_ElementSize(MAX_AIN_PUBLIC_CHANNELS);
     }
 
-    /* Per-sample memory cost: data element + free-list index */
-    size_t sampleBytes = sampleElementSize + sizeof(int16_t);
+    /* Per-sample memory cost: the slot itself (the AInSample ring needs no
+     * free list or pointer queue alongside it) */
+    size_t sampleBytes = sampleElementSize;
 
     /* Clamp buffer minimums */
     if (usbSize < STREAMING_USB_MIN) usbSize = STREAMING_USB_MIN;
@@ -145,39 +146,45 @@ void StreamingBufferPool_GetWifi(uint8_t** buf, uint32_t* size) {
     *size = gWifiSize;
 }
 
-void StreamingBufferPool_GetSamplePool(void** poolBuf, int16_t** nextFreeBuf,
-                                        uint32_t* count, size_t* elementSize) {
+void StreamingBufferPool_GetSamplePool(void** poolBuf, uint32_t* count,
+                                        size_t* elementSize) {
     if (gPool == NULL || gSampleCount == 0 || gSampleElementSize == 0) {
         *poolBuf = NULL;
-        *nextFreeBuf = NULL;
         *count = 0;
         *elementSize = 0;
         return;
     }
-    /* Layout: [USB | WiFi | encoder | SD_circular | <align> | samplePool[count] | nextFree[count]] */
+    /* Layout: [USB | WiFi | encoder | SD_circular | <align> | samplePool[count]] */
     uintptr_t base = (uintptr_t)gPool;
     uintptr_t off = (uintptr_t)(gUsbSize + gWifiSize + gEncoderSize + gSdCircularSize);
 
     /* Align sample pool start to 4 bytes (uint32_t members) */
     off = (off + 3U) & ~3U;
 
-    uintptr_t nextFreeOff = off + (uintptr_t)gSampleCount * gSampleElementSize;
-    /* int16_t needs 2-byte alignment */
-    nextFreeOff = (nextFreeOff + 1U) & ~1U;
-
     /* Bounds check (all values are offsets from pool start, not addresses) */
-    uintptr_t end = nextFreeOff + gSampleCount * sizeof(int16_t);
+    uintptr_t end = off + (uintptr_t)gSampleCount * gSampleElementSize;
     if (end > gPoolSize) {
-        *poolBuf = NULL; *nextFreeBuf = NULL; *count = 0; *elementSize = 0;
+        *poolBuf = NULL; *count = 0; *elementSize = 0;
         return;
     }
 
     *poolBuf = (void*)(base + off);
-    *nextFreeBuf = (int16_t*)(base + nextFreeOff);
     *count = gSampleCount;
     *elementSize = gSampleElementSize;
 }
 
+void StreamingBufferPool_GetCapture(uint8_t** buf, uint32_t* size) {
+    *buf = NULL;
+    *size = 0;
+    if (gPool == NULL) return;
+    uint32_t off = (gUsbSize + gWifiSize + gEncoderSize + gSdCircularSize + 3U) & ~3U;
+    off += (uint32_t)(gSampleCount * gSampleElementSize);
+    off = (off + 3U) & ~3U;
+    if (off >= gPoolSize) return;
+    *buf = gPool + off;
+    *size = gPoolSize - off;
+}
+
 uint32_t StreamingBufferPool_TotalSize(void)  { return gPoolSize; }
 uint32_t StreamingBufferPool_UsbSize(void)    { return gUsbSize; }
 uint32_t StreamingBufferPool_WifiSize(void)   { return gWifiSize; }
@@ -12,12 +12,16 @@ extern "C" {
  * Unified Streaming Memory Pool
  *
  * A static BSS array that holds ALL streaming-related memory:
- * USB circular buffer, WiFi circular buffer, sample pool array,
- * and sample free-list array.  Partitioned at each stream start
+ * USB circular buffer, WiFi circular buffer, encoder buffer, SD circular
+ * buffer and the sample slot ring.  Partitioned at each stream start
  * based on active interfaces — no malloc, no fragmentation.
  *
  * Layout after partition:
- *   [USB circular | WiFi circular | encoder buf | SD circular | <align> | samplePool[] | nextFree[]]
+ *   [USB circular | WiFi circular | encoder buf | SD circular | <align> | samplePool[] | <align> | capture]
+ *
+ * The capture region is whatever the sample pool leaves over. It is only
+ * sizeable when the sample pool was partitioned small on purpose, which a
+ * SYST:STR:CAPture session does (Util/CaptureRing.h).
  *
  * Boot:   StreamingBufferPool_Init() sets default partition.
  * Start:  StreamingBufferPool_Partition() re-carves all regions.
@@ -48,6 +52,12 @@ extern "C" {
 
 /** Active-interface defaults used by Streaming_ComputeAutoBuffers */
 #define STREAMING_USB_DEFAULT       (64U * 1024U)  /* USB circular when active */
+/* Encoder region for USB+SD sessions: it holds the shared block queue both
+ * transports read from (streaming.c, Streaming_FanoutConfigure), so it takes
+ * the USB circular's active share -- the USB circular then only carries SCPI
+ * replies and stays at STREAMING_USB_ACTIVE_MIN. Within the 64 KB the SCPI
+ * encoder limit advertises. */
+#define STREAMING_SHARED_QUEUE_DEFAULT (64U * 1024U)
 /* WiFi circular when WiFi is the active interface.  WiFi is always
  * single-interface — the StreamingInterface enum has no USB+WiFi or
  * WiFi+SD value, and the SCPIInterface.c runtime guard refuses WiFi
@@ -62,13 +72,18 @@ extern "C" {
  *
  * Tradeoff (Qodo PR #501 pass 2): when SamplePoolCount is auto (0),
  * Partition() sets the pool depth from remaining pool bytes — so
- * bumping this constant shrinks the auto-sized sample pool and
- * indirectly shrinks the FreeRTOS heap used by AInSample's queue.
+ * bumping this constant shrinks the auto-sized sample pool.
  * MAX_AIN_SAMPLE_COUNT is 10000 (not 1100 — that's the DEFAULT).
  * Acceptable because SamplePoolMaxUsed on actual workloads stays
  * ≤16 (per #497 evidence), so the post-shrink pool still has 100×
  * headroom. */
 #define STREAMING_WIFI_WIFI_ONLY    (96U * 1024U)
+/* WiFi TCP sessions encode into a shared block queue that every connected
+ * TCP client reads (streaming.c, Streaming_FanoutConfigure), so the WiFi-only
+ * share moves to the encoder region and the WiFi circular keeps what the
+ * console's SCPI replies need. Same 96 KB total as a single-ring session. */
+#define STREAMING_WIFI_SHARED_QUEUE_DEFAULT (88U * 1024U)
+#define STREAMING_WIFI_CONSOLE_ACTIVE       (8U * 1024U)
 
 /**
  * Initialize the pool and set default partition.
@@ -113,8 +128,11 @@ void StreamingBufferPool_GetEncoder(uint8_t** buf, uint32_t* size);
 void StreamingBufferPool_GetSdCircular(uint8_t** buf, uint32_t* size);
 
 /** Get current sample pool region, count, and per-element size */
-void StreamingBufferPool_GetSamplePool(void** poolBuf, int16_t** nextFreeBuf,
-                                        uint32_t* count, size_t* elementSize);
+void StreamingBufferPool_GetSamplePool(void** poolBuf, uint32_t* count,
+                                        size_t* elementSize);
+
+/** Get the unused tail after the sample pool (4-byte aligned; size 0 when none) */
+void StreamingBufferPool_GetCapture(uint8_t** buf, uint32_t* size);
 
 /** Query total pool size */
 uint32_t StreamingBufferPool_TotalSize(void);
@@ -0,0 +1,108 @@
+#include "TcpFanout.h"
+#include <string.h>
+
+bool TcpFanout_Init(TcpFanout_t* f, SharedBlockQueue_t* q, uint8_t clients,
+                    uint32_t maxSend) {
+    if (f == NULL) return false;
+    memset(f, 0, sizeof(*f));
+    if (q == NULL || clients == 0u || clients != q->consumers || maxSend == 0u) {
+        return false;
+    }
+    f->q = q;
+    f->clients = clients;
+    f->maxSend = maxSend;
+    uint8_t c;
+    for (c = 0; c < clients; c++) {
+        SharedBlockQueue_Detach(q, c);
+    }
+    SharedBlockQueue_SetKeep(q, (uint8_t)(1u << TCP_FANOUT_PRIMARY));
+    return true;
+}
+
+void TcpFanout_Attach(TcpFanout_t* f, uint8_t c, uint32_t now) {
+    if (f->q == NULL || c >= f->clients || SharedBlockQueue_IsAttached(f->q, c)) {
+        return;
+    }
+    memset(&f->client[c], 0, sizeof(f->client[c]));
+    f->client[c].lastProgress = now;
+    SharedBlockQueue_Attach(f->q, c);
+}
+
+uint32_t TcpFanout_Detach(TcpFanout_t* f, uint8_t c) {
+    if (f->q == NULL || c >= f->clients) return 0u;
+    return SharedBlockQueue_Detach(f->q, c);
+}
+
+bool TcpFanout_IsAttached(const TcpFanout_t* f, uint8_t c) {
+    return f->q != NULL && SharedBlockQueue_IsAttached(f->q, c);
+}
+
+uint32_t TcpFanout_ChargeDrops(TcpFanout_t* f, const SharedBlockDrops_t* d) {
+    uint8_t c;
+    for (c = 0; c < f->clients; c++) {
+        f->client[c].droppedBytes += d->bytes[c];
+        f->client[c].droppedBlocks += d->blocks[c];
+        if (d->blocks[c] > 0u) {
+            f->client[c].evicted = true;
+        }
+    }
+    return d->bytes[TCP_FANOUT_PRIMARY];
+}
+
+uint32_t TcpFanout_ReleasePrimary(TcpFanout_t* f) {
+    if (f->q == NULL) return 0u;
+    uint32_t lost = SharedBlockQueue_Discard(f->q, TCP_FANOUT_PRIMARY);
+    f->client[TCP_FANOUT_PRIMARY].droppedBytes += lost;
+    if (lost > 0u) {
+        f->client[TCP_FANOUT_PRIMARY].droppedBlocks++;
+    }
+    return lost;
+}
+
+int32_t TcpFanout_Drain(TcpFanout_t* f, uint8_t c, uint32_t minLen, uint32_t now,
+                        TcpFanoutSend send, void* ctx) {
+    if (f->q == NULL || c >= f->clients) return 0;
+    TcpFanoutClient_t* cl = &f->client[c];
+    int32_t taken = 0;
+    for (;;) {
+        uint32_t len = 0;
+        const uint8_t* p = SharedBlockQueue_Peek(f->q, c, f->maxSend, &len);
+        if (p == NULL) {
+            if (SharedBlockQueue_Pending(f->q, c) == 0u && !cl->evicted) {
+                cl->lastProgress = now;     /* caught up */
+            }
+            return taken;
+        }
+        if (len < minLen) {
+            return taken;
+        }
+        int ret = send(ctx, c, p, len);
+        if (ret < 0) {
+            cl->sendErrors++;
+            return (taken > 0) ? taken : -1;
+        }
+        if (ret == 0) {
+            return taken;
+        }
+        uint32_t n = SharedBlockQueue_Consume(f->q, c, (uint32_t)ret);
+        cl->bytesSent += n;
+        cl->sends++;
+        cl->lastProgress = now;
+        cl->evicted = false;
+        taken += (int32_t)n;
+    }
+}
+
+uint32_t TcpFanout_Pending(const TcpFanout_t* f, uint8_t c) {
+    if (f->q == NULL) return 0u;
+    return SharedBlockQueue_Pending(f->q, c);
+}
+
+bool TcpFanout_Stalled(const TcpFanout_t* f, uint8_t c, uint32_t now, uint32_t limit) {
+    if (f->q == NULL || c == TCP_FANOUT_PRIMARY || c >= f->clients ||
+        !SharedBlockQueue_IsAttached(f->q, c) ||
+        SharedBlockQueue_Pending(f->q, c) == 0u) {
+        return false;
+    }
+    return (uint32_t)(now - f->client[c].lastProgress) > limit;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "SharedBlockQueue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * TCP Fan-out — several socket clients reading one encoded stream
+ *
+ * The clients of the WiFi TCP server each read a SharedBlockQueue through
+ * their own cursor (consumer index = client slot), so a batch is encoded
+ * once however many clients are connected, and no client has a ring of its
+ * own. This module is the per-client half: which clients are attached, how
+ * a client's cursor is handed to its socket, and what each one lost.
+ *
+ * Client 0 is the primary (the SCPI console). Its blocks are KEPT: when the
+ * arena is full behind it the producer waits, as it did on the console's own
+ * ring (#520 backpressure). Every other client is a tap: when it falls
+ * behind, the producer evicts its oldest blocks and charges them to that tap
+ * alone, and a tap that makes no progress at all for the stall limit is
+ * reported by Stalled so its owner can disconnect it.
+ *
+ * Sends go through a callback, so the logic runs on the host against
+ * simulated sockets (tests/host/test_tcp_fanout.c). The callback gets whole
+ * blocks, at most maxSend bytes at a time -- one WINC send() -- and returns
+ * how many it took: the full length, 0 when the socket cannot take more yet
+ * (WINC buffer full, in-flight cap), or negative on a send error.
+ *
+ * THREAD-SAFETY: none; one lock covers this and its queue (gFanoutMutex in
+ * streaming.c).
+ */
+
+#define TCP_FANOUT_PRIMARY  0u
+
+typedef int (*TcpFanoutSend)(void* ctx, uint8_t client, const uint8_t* data, uint32_t len);
+
+typedef struct {
+    uint32_t lastProgress;  /* tick of the last send taken, or of catching up */
+    bool     evicted;       /* lost blocks since its last send: an emptied
+                             * cursor is not a caught-up one */
+    uint64_t bytesSent;
+    uint32_t sends;
+    uint32_t sendErrors;
+    uint32_t droppedBytes;  /* evicted or discarded before this client read them */
+    uint32_t droppedBlocks;
+} TcpFanoutClient_t;
+
+typedef struct {
+    SharedBlockQueue_t* q;
+    uint8_t  clients;
+    uint32_t maxSend;
+    TcpFanoutClient_t client[SBQ_MAX_CONSUMERS];
+} TcpFanout_t;
+
+/**
+ * Bind to @p q, which must have been initialized with @p clients consumers.
+ * Every client starts detached and the primary is marked kept.
+ * @return false on a bad argument
+ */
+bool TcpFanout_Init(TcpFanout_t* f, SharedBlockQueue_t* q, uint8_t clients,
+                    uint32_t maxSend);
+
+/** A client connected: it reads from the next block published. Its counters restart. */
+void TcpFanout_Attach(TcpFanout_t* f, uint8_t c, uint32_t now);
+
+/** A client went away: its backlog is dropped (and returned) without being charged. */
+uint32_t TcpFanout_Detach(TcpFanout_t* f, uint8_t c);
+
+bool TcpFanout_IsAttached(const TcpFanout_t* f, uint8_t c);
+
+/**
+ * Charge one Reserve's evictions to the clients that lost them.
+ * @return the bytes the primary lost (the transport's own drop counter's share)
+ */
+uint32_t TcpFanout_ChargeDrops(TcpFanout_t* f, const SharedBlockDrops_t* d);
+
+/**
+ * The primary has been waited on for as long as the producer allows: drop its
+ * backlog, charged to it, so the producer can go on. Returns the bytes.
+ */
+uint32_t TcpFanout_ReleasePrimary(TcpFanout_t* f);
+
+/**
+ * Hand client @p c's pending blocks to @p send until it stops taking them or
+ * nothing is left. A run shorter than @p minLen is held back (the streaming
+ * task's early kick) unless @p minLen is 0 or 1. Catching up counts as
+ * progress.
+ * @return bytes taken, or negative if @p send failed (what it took before
+ *         that still counts)
+ */
+int32_t TcpFanout_Drain(TcpFanout_t* f, uint8_t c, uint32_t minLen, uint32_t now,
+                        TcpFanoutSend send, void* ctx);
+
+/** Bytes queued for @p c and not yet handed to its socket. */
+uint32_t TcpFanout_Pending(const TcpFanout_t* f, uint8_t c);
+
+/**
+ * True when tap @p c has had data waiting and taken none of it for more
+ * than @p limit ticks. Never true for the primary, which the producer waits
+ * on instead.
+ */
+bool TcpFanout_Stalled(const TcpFanout_t* f, uint8_t c, uint32_t now, uint32_t limit);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,116 @@
+#include "UdpStream.h"
+
+static void UdpStream_Put16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static void UdpStream_Put32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static uint32_t UdpStream_Get32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | p[3];
+}
+
+void UdpStream_EncodeHeader(uint8_t out[UDP_STREAM_HEADER_SIZE], const UdpStreamHeader_t* h) {
+    out[0] = UDP_STREAM_MAGIC0;
+    out[1] = UDP_STREAM_MAGIC1;
+    out[2] = UDP_STREAM_VERSION;
+    out[3] = h->flags;
+    UdpStream_Put32(out + 4, h->seq);
+    UdpStream_Put32(out + 8, h->firstTs);
+    UdpStream_Put16(out + 12, h->payloadLen);
+    out[14] = h->encoding;
+    out[15] = 0u;
+}
+
+bool UdpStream_DecodeHeader(const uint8_t* in, size_t len, UdpStreamHeader_t* h) {
+    if (len < UDP_STREAM_HEADER_SIZE || in[0] != UDP_STREAM_MAGIC0 ||
+        in[1] != UDP_STREAM_MAGIC1 || in[2] != UDP_STREAM_VERSION) {
+        return false;
+    }
+    h->flags = in[3];
+    h->seq = UdpStream_Get32(in + 4);
+    h->firstTs = UdpStream_Get32(in + 8);
+    h->payloadLen = (uint16_t)(((uint16_t)in[12] << 8) | in[13]);
+    h->encoding = in[14];
+    return (size_t)h->payloadLen <= len - UDP_STREAM_HEADER_SIZE;
+}
+
+size_t UdpStream_WireSize(size_t len, size_t maxPayload) {
+    size_t n = (len + maxPayload - 1u) / maxPayload;
+    if (n == 0u) {
+        n = 1u;   /* an empty batch is still one (header-only) datagram */
+    }
+    return len + n * UDP_STREAM_HEADER_SIZE;
+}
+
+uint32_t UdpStream_Pack(uint32_t* pSeq, uint8_t encoding, uint32_t firstTs,
+                        const uint8_t* data, size_t len, size_t maxPayload,
+                        UdpStreamSink sink, void* ctx) {
+    uint8_t hdr[UDP_STREAM_HEADER_SIZE];
+    UdpStreamHeader_t h = {.encoding = encoding, .firstTs = firstTs};
+    uint32_t count = 0;
+    size_t at = 0;
+    do {
+        size_t n = len - at;
+        if (n > maxPayload) {
+            n = maxPayload;
+        }
+        h.flags = (uint8_t)(((at > 0u) ? UDP_STREAM_FLAG_CONT : 0u) |
+                            ((at + n < len) ? UDP_STREAM_FLAG_MORE : 0u));
+        h.seq = (*pSeq)++;
+        h.payloadLen = (uint16_t)n;
+        UdpStream_EncodeHeader(hdr, &h);
+        sink(ctx, hdr, data + at, n);
+        at += n;
+        count++;
+    } while (at < len);
+    return count;
+}
+
+UdpStreamRxResult UdpStreamRx_Accept(UdpStreamRx_t* rx, const UdpStreamHeader_t* h) {
+    rx->received++;
+    bool gap = false;
+    if (!rx->started || (h->seq == 0u && rx->nextSeq != 0u)) {
+        /* First datagram seen, or the device began a new session. Anything
+         * sent before it in this session never arrived. */
+        if (rx->started) {
+            rx->sessions++;
+        }
+        rx->started = true;
+        rx->lost += h->seq;
+        gap = true;
+    } else {
+        uint32_t ahead = h->seq - rx->nextSeq;
+        if (ahead >= 0x80000000u) {
+            rx->late++;
+            return UDP_STREAM_RX_LATE;
+        }
+        if (ahead > 0u) {
+            rx->lost += ahead;
+            gap = true;
+        }
+    }
+    rx->nextSeq = h->seq + 1u;
+
+    bool cont = (h->flags & UDP_STREAM_FLAG_CONT) != 0u;
+    bool torn = rx->holding && (gap || !cont);
+    if (torn) {
+        rx->torn++;
+    }
+    if (cont && (gap || !rx->holding)) {
+        /* The start of this batch, or a piece before this one, is gone. */
+        rx->dropped++;
+        rx->holding = false;
+        return UDP_STREAM_RX_DROP;
+    }
+    rx->holding = (h->flags & UDP_STREAM_FLAG_MORE) != 0u;
+    rx->bytes += h->payloadLen;
+    return torn ? UDP_STREAM_RX_RESTART : UDP_STREAM_RX_DELIVER;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * UDP Stream — datagram framing for WiFi UDP streaming (SYST:STR:INT 4)
+ *
+ * Every datagram is a fixed header followed by encoded stream bytes, all
+ * multi-byte fields big-endian:
+ *
+ *     0  'D' 'Q'      magic
+ *     2  version      UDP_STREAM_VERSION
+ *     3  flags        UDP_STREAM_FLAG_*
+ *     4  seq          u32, 0 for the first datagram of a session, +1 per datagram
+ *     8  firstTs      u32, TS-timer ticks of the batch's first sample set
+ *    12  payloadLen   u16
+ *    14  encoding     StreamingEncoding of the payload
+ *    15  reserved     0
+ *
+ * A datagram holds one encoder batch: whole messages, starting on a message
+ * boundary. A batch larger than one datagram is split; every piece but the
+ * last sets UDP_STREAM_FLAG_MORE, every piece but the first sets
+ * UDP_STREAM_FLAG_CONT, and all of them repeat the batch's firstTs.
+ *
+ * Nothing is retransmitted. A receiver counts a gap in seq as lost datagrams
+ * and drops any batch that lost a piece, so what it passes on is always whole
+ * messages (UdpStreamRx_Accept); the next batch starts clean.
+ *
+ * THREAD-SAFETY: none; callers serialise.
+ */
+
+#define UDP_STREAM_HEADER_SIZE  16u
+#define UDP_STREAM_VERSION      1u
+#define UDP_STREAM_MAGIC0       'D'
+#define UDP_STREAM_MAGIC1       'Q'
+
+/** The payload continues a batch begun in the previous datagram. */
+#define UDP_STREAM_FLAG_CONT    0x01u
+/** The batch continues in the next datagram. */
+#define UDP_STREAM_FLAG_MORE    0x02u
+
+typedef struct {
+    uint8_t  flags;
+    uint8_t  encoding;
+    uint16_t payloadLen;
+    uint32_t seq;
+    uint32_t firstTs;
+} UdpStreamHeader_t;
+
+void UdpStream_EncodeHeader(uint8_t out[UDP_STREAM_HEADER_SIZE], const UdpStreamHeader_t* h);
+
+/** False unless @p in starts with a header of this version whose payloadLen
+ *  fits in @p len. */
+bool UdpStream_DecodeHeader(const uint8_t* in, size_t len, UdpStreamHeader_t* h);
+
+/** Bytes @p len payload bytes take on the wire, headers included, when no
+ *  datagram carries more than @p maxPayload of them. */
+size_t UdpStream_WireSize(size_t len, size_t maxPayload);
+
+/** Receives one datagram: its encoded header, then its payload. */
+typedef void (*UdpStreamSink)(void* ctx, const uint8_t* hdr, const uint8_t* payload, size_t len);
+
+/**
+ * Split one batch of @p len bytes into datagrams of at most @p maxPayload
+ * payload bytes and hand each to @p sink, numbering them from *pSeq (which
+ * is advanced). Returns the number of datagrams.
+ */
+uint32_t UdpStream_Pack(uint32_t* pSeq, uint8_t encoding, uint32_t firstTs,
+                        const uint8_t* data, size_t len, size_t maxPayload,
+                        UdpStreamSink sink, void* ctx);
+
+/** Receiver-side accounting. Zero-initialise. */
+typedef struct {
+    bool     started;
+    bool     holding;       ///< a MORE piece was delivered; its batch is open
+    uint32_t nextSeq;
+    uint64_t received;      ///< datagrams seen, used or not
+    uint64_t lost;          ///< seq numbers skipped over
+    uint64_t late;          ///< arrived after a later seq (already counted lost)
+    uint64_t dropped;       ///< pieces of batches that lost another piece
+    uint64_t torn;          ///< batches dropped for a lost piece
+    uint64_t sessions;      ///< seq restarts at 0 (a new STR:START)
+    uint64_t bytes;         ///< payload bytes of the datagrams delivered
+} UdpStreamRx_t;
+
+/**
+ * What to do with a datagram's payload. The caller keeps the open batch:
+ * DELIVER appends to it, and the batch is complete (pass it on) when the
+ * header has no UDP_STREAM_FLAG_MORE.
+ */
+typedef enum {
+    UDP_STREAM_RX_DELIVER = 0,  ///< append the payload to the open batch
+    UDP_STREAM_RX_RESTART = 1,  ///< discard the open batch (torn), then DELIVER
+    UDP_STREAM_RX_DROP = 2,     ///< discard the payload and the open batch
+    UDP_STREAM_RX_LATE = 3,     ///< discard the payload; the stream moved on
+} UdpStreamRxResult;
+
+/** Account for one received datagram and say what to do with its payload. */
+UdpStreamRxResult UdpStreamRx_Accept(UdpStreamRx_t* rx, const UdpStreamHeader_t* h);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,127 @@
+#include "UsbTxSlots.h"
+#include <string.h>
+
+#define UTS_SLOT(t, seq) (&(t)->slot[(seq) % (t)->count])
+
+bool UsbTxSlots_Init(UsbTxSlots_t* t, uint8_t* buf, uint32_t size,
+                     uint32_t maxPacket, uintptr_t invalidHandle) {
+    if (t == NULL) return false;
+    memset(t, 0, sizeof(*t));
+    t->invalid = invalidHandle;
+    t->maxPacket = (maxPacket != 0u) ? maxPacket : USB_TX_MAX_PACKET_HS;
+    if (buf == NULL) {
+        return false;
+    }
+    /* Whole high-speed packets per slot: also keeps the second slot on the
+     * coherent pool's alignment. */
+    uint32_t count = USB_TX_SLOTS_MAX;
+    while (count > 0u && (size / count) / USB_TX_MAX_PACKET_HS == 0u) {
+        count--;
+    }
+    if (count == 0u) {
+        return false;
+    }
+    uint32_t slotSize = ((size / count) / USB_TX_MAX_PACKET_HS) * USB_TX_MAX_PACKET_HS;
+    if (slotSize > USB_TX_TRANSFER_MAX) {
+        slotSize = USB_TX_TRANSFER_MAX;
+    }
+    t->count = count;
+    t->slotSize = slotSize;
+    for (uint32_t i = 0; i < count; i++) {
+        t->slot[i].data = buf + i * slotSize;
+        t->slot[i].handle = invalidHandle;
+    }
+    return true;
+}
+
+void UsbTxSlots_SetMaxPacket(UsbTxSlots_t* t, uint32_t maxPacket) {
+    if (maxPacket != 0u) {
+        t->maxPacket = maxPacket;
+    }
+}
+
+uint8_t* UsbTxSlots_Claim(UsbTxSlots_t* t, uint32_t* pCap) {
+    *pCap = 0u;
+    if (t->count == 0u || t->claimed ||
+        (uint32_t)(t->queued - t->completed) >= t->count) {
+        return NULL;
+    }
+    t->claimed = true;
+    *pCap = t->slotSize;
+    return UTS_SLOT(t, t->queued)->data;
+}
+
+void UsbTxSlots_Unclaim(UsbTxSlots_t* t) {
+    t->claimed = false;
+}
+
+UsbTxSlot_t* UsbTxSlots_Queue(UsbTxSlots_t* t, uint32_t len, bool moreWaiting) {
+    if (!t->claimed || len == 0u) {
+        return NULL;
+    }
+    UsbTxSlot_t* slot = UTS_SLOT(t, t->queued);
+    if (len > t->slotSize) len = t->slotSize;
+    bool packetMultiple = (len % t->maxPacket) == 0u;
+    slot->len = len;
+    slot->handle = t->invalid;
+    slot->morePending = packetMultiple && moreWaiting;
+    slot->overlapped = (t->queued != t->completed);
+    t->moreWaiting = moreWaiting;
+    t->queued++;
+    return slot;
+}
+
+void UsbTxSlots_Submitted(UsbTxSlots_t* t, bool ok) {
+    if (!t->claimed) {
+        return;                 /* Reset ran while the driver call was out */
+    }
+    t->claimed = false;
+    if (t->queued == t->completed) {
+        return;
+    }
+    UsbTxSlot_t* slot = UTS_SLOT(t, t->queued - 1u);
+    if (!ok) {
+        slot->handle = t->invalid;
+        t->queued--;
+        return;
+    }
+    t->transfers++;
+    if (slot->overlapped) {
+        t->overlapped++;
+    }
+    if (!slot->morePending && (slot->len % t->maxPacket) == 0u) {
+        t->zlps++;
+    }
+}
+
+bool UsbTxSlots_Complete(UsbTxSlots_t* t, uintptr_t handle, uint32_t* pLen) {
+    if (t->queued == t->completed || handle == t->invalid) {
+        return false;
+    }
+    UsbTxSlot_t* slot = UTS_SLOT(t, t->completed);
+    if (slot->handle != handle) {
+        return false;
+    }
+    if (pLen != NULL) {
+        *pLen = slot->len;
+    }
+    slot->handle = t->invalid;
+    t->completed++;
+    return true;
+}
+
+void UsbTxSlots_Reset(UsbTxSlots_t* t) {
+    for (uint32_t i = 0; i < t->count; i++) {
+        t->slot[i].handle = t->invalid;
+    }
+    t->completed = t->queued;
+    t->claimed = false;
+}
+
+uint32_t UsbTxSlots_InFlight(const UsbTxSlots_t* t) {
+    return (uint32_t)(t->queued - t->completed);
+}
+
+uint32_t UsbTxSlots_SlotSize(const UsbTxSlots_t* t) {
+    return t->slotSize;
+}
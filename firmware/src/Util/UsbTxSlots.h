@@ -0,0 +1,136 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * USB TX Slots — double-buffered staging for the CDC IN endpoint
+ *
+ * The USB DMA write buffer is carved into two slots of whole high-speed
+ * packets, each up to USB_TX_TRANSFER_MAX bytes. A writer claims the free
+ * slot, fills it from the circular buffer (or the USB+SD fan-out queue) and
+ * queues it on the endpoint; while that transfer is on the wire the next
+ * writer fills the other slot and queues it behind, so the host always finds
+ * a transfer waiting instead of an idle gap while the device copies. A buffer
+ * too small for two slots runs as one (the old single-transfer behaviour).
+ *
+ * Slots are handed to the driver and come back strictly in order, through two
+ * free-running counters:
+ *
+ *     completed <= queued <= completed + count
+ *
+ * Zero-length packets: a bulk IN transfer ends at a short packet. One whose
+ * length is an exact multiple of the endpoint's max packet size has no short
+ * packet, so the host keeps its read open until a ZLP or more data arrives.
+ * Queue picks the send mode for every slot:
+ *
+ *   - a multiple of the max packet with more bytes already waiting behind it
+ *     goes out as "more data pending": no ZLP, the next slot continues the
+ *     host's read;
+ *   - anything else goes out as "data complete": the driver appends the ZLP
+ *     when the length is a packet multiple, and a short packet ends it
+ *     otherwise.
+ *
+ * The last slot of a burst therefore always terminates the host's read.
+ *
+ * Claim also serves as the #127 write-submission claim: it is held from the
+ * fill until the driver call returns (Submitted), so two tasks can never
+ * queue slots out of order or fill the same one.
+ *
+ * THREAD-SAFETY: none internally. UsbCdc.c calls Claim, Queue, Submitted and
+ * Unclaim inside taskENTER_CRITICAL, and Complete / Reset from the USB event
+ * handlers (interrupt context), which that critical section masks.
+ */
+
+#define USB_TX_SLOTS_MAX        2u
+#define USB_TX_TRANSFER_MAX     (64u * 1024u)
+#define USB_TX_MAX_PACKET_HS    512u
+#define USB_TX_MAX_PACKET_FS    64u
+
+typedef struct {
+    uint8_t*  data;
+    uint32_t  len;          /* bytes queued */
+    uintptr_t handle;       /* driver transfer handle, written by the driver */
+    bool      morePending;  /* send without terminating the host read */
+    bool      overlapped;   /* queued behind a transfer still on the wire */
+} UsbTxSlot_t;
+
+typedef struct {
+    UsbTxSlot_t       slot[USB_TX_SLOTS_MAX];
+    uint32_t          count;        /* 1 or 2; 0 when Init failed */
+    uint32_t          slotSize;     /* a multiple of USB_TX_MAX_PACKET_HS */
+    uint32_t          maxPacket;    /* of the enumerated IN endpoint */
+    uintptr_t         invalid;      /* the driver's "no transfer" handle */
+    volatile uint32_t queued;       /* writers */
+    volatile uint32_t completed;    /* WRITE_COMPLETE */
+    volatile bool     claimed;      /* a writer holds the next slot */
+    bool              moreWaiting;  /* the last Queue left bytes behind it */
+    uint32_t          transfers;    /* queued since Init */
+    uint32_t          overlapped;   /* ... while the other slot was on the wire */
+    uint32_t          zlps;         /* ... ending in a driver-appended ZLP */
+} UsbTxSlots_t;
+
+/**
+ * Carve @p size bytes at @p buf into two slots when each can hold at least
+ * one high-speed packet, otherwise one. @p maxPacket is the IN endpoint's
+ * (USB_TX_MAX_PACKET_HS until enumeration says otherwise).
+ *
+ * @return false when not even one packet fits (instance left empty)
+ */
+bool UsbTxSlots_Init(UsbTxSlots_t* t, uint8_t* buf, uint32_t size,
+                     uint32_t maxPacket, uintptr_t invalidHandle);
+
+/** The enumerated speed's max packet size, for the ZLP rule. */
+void UsbTxSlots_SetMaxPacket(UsbTxSlots_t* t, uint32_t maxPacket);
+
+/**
+ * Writer: the next free slot and its capacity, or NULL when every slot is
+ * queued or another writer holds the claim.
+ */
+uint8_t* UsbTxSlots_Claim(UsbTxSlots_t* t, uint32_t* pCap);
+
+/** Writer: give the claim back with nothing queued. */
+void UsbTxSlots_Unclaim(UsbTxSlots_t* t);
+
+/**
+ * Writer: queue the claimed slot with @p len bytes. @p moreWaiting says more
+ * bytes are already buffered behind these (kept in t->moreWaiting, so the
+ * caller can fill the other slot in the same pass). The claim is kept until
+ * Submitted; the slot's handle is reset to the invalid handle for the driver
+ * to fill.
+ *
+ * @return the slot to hand to the driver, or NULL (no claim, or @p len 0)
+ */
+UsbTxSlot_t* UsbTxSlots_Queue(UsbTxSlots_t* t, uint32_t len, bool moreWaiting);
+
+/** Writer: the driver call returned; @p ok false takes the slot back. */
+void UsbTxSlots_Submitted(UsbTxSlots_t* t, bool ok);
+
+/**
+ * WRITE_COMPLETE for @p handle. Only the oldest queued slot can complete;
+ * any other handle (a transfer abandoned by Reset) is ignored.
+ *
+ * @return true, with the slot's queued length in @p pLen, when it matched
+ */
+bool UsbTxSlots_Complete(UsbTxSlots_t* t, uintptr_t handle, uint32_t* pLen);
+
+/**
+ * Link teardown: transfers in flight never complete, so forget them and the
+ * claim. A writer still between Queue and Submitted finds nothing to undo.
+ */
+void UsbTxSlots_Reset(UsbTxSlots_t* t);
+
+/** Transfers queued on the endpoint and not yet completed. */
+uint32_t UsbTxSlots_InFlight(const UsbTxSlots_t* t);
+
+/** Largest single transfer: what one block must fit. */
+uint32_t UsbTxSlots_SlotSize(const UsbTxSlots_t* t);
+
+#ifdef __cplusplus
+}
+#endif
@@ -215,12 +215,11 @@ static size_t sd_reply_write_tcp(const char* data, size_t len)
     return wifi_tcp_server_WriteBuffer(data, len);
 }
 
-void sd_card_manager_DataReadyCB(sd_card_manager_mode_t mode, uint8_t *pDataBuff, size_t dataLen) {
-    // Defensive checks
-    if (pDataBuff == NULL || dataLen == 0) {
-        return;
-    }
-
+/* The writer for the interface the pending READ/LIST replies to, or NULL
+ * (transfer aborted) when that was a TCP client that is no longer there. */
+typedef size_t (*sd_reply_write_fn)(const char*, size_t);
+static sd_reply_write_fn sd_reply_writer(bool* pToTcp)
+{
     const sd_card_manager_settings_t* pSet =
             (const sd_card_manager_settings_t*) BoardRunTimeConfig_Get(BOARDRUNTIME_SD_CARD_SETTINGS);
     const bool toTcp = (pSet != NULL) && (pSet->replyTarget == SD_CARD_REPLY_WIFI_TCP);
@@ -233,14 +232,50 @@ void sd_card_manager_DataReadyCB(sd_card_manager_mode_t mode, uint8_t *pDataBuff
      * connection no longer owns the slot, and abort the SD READ so it closes
      * the file and resets mode cleanly on its next loop iteration (the LIST
      * path simply finishes with its remaining chunks dropped). */
+    *pToTcp = toTcp;
     if (toTcp && !wifi_tcp_server_ConnIsCurrent(pSet->replyGeneration)) {
         sd_card_manager_AbortTransfer();
         LOG_E("[SD reply] TCP client changed/gone (gen %u) - reply aborted",
               (unsigned)pSet->replyGeneration);
+        return NULL;
+    }
+    return toTcp ? sd_reply_write_tcp : sd_reply_write_usb;
+}
+
+size_t sd_card_manager_DataReadyTryCB(sd_card_manager_mode_t mode, const uint8_t *pDataBuff, size_t dataLen) {
+    (void)mode;
+    if (pDataBuff == NULL || dataLen == 0) {
+        return 0;
+    }
+    bool toTcp;
+    sd_reply_write_fn writeFn = sd_reply_writer(&toTcp);
+    if (writeFn == NULL) {
+        return dataLen;   /* aborted: nothing more will be sent */
+    }
+    size_t sent = 0;
+    while (sent < dataLen) {
+        size_t remaining = dataLen - sent;
+        size_t n = writeFn((const char *) pDataBuff + sent,
+                           (remaining < USB_TRANSFER_CHUNK_SIZE) ? remaining : USB_TRANSFER_CHUNK_SIZE);
+        if (n == 0) {
+            break;        /* ring full: the caller comes back after its next read */
+        }
+        sent += n;
+    }
+    return sent;
+}
+
+void sd_card_manager_DataReadyCB(sd_card_manager_mode_t mode, uint8_t *pDataBuff, size_t dataLen) {
+    // Defensive checks
+    if (pDataBuff == NULL || dataLen == 0) {
         return;
     }
 
-    size_t (*writeFn)(const char*, size_t) = toTcp ? sd_reply_write_tcp : sd_reply_write_usb;
+    bool toTcp;
+    sd_reply_write_fn writeFn = sd_reply_writer(&toTcp);
+    if (writeFn == NULL) {
+        return;
+    }
 
     size_t transferredLength = 0;
     uint32_t retryCount = 0;
@@ -421,9 +456,9 @@ bool app_SDCard_SpiOwnedByWifi(void) {
         BoardRunTimeConfig_Get(BOARDRUNTIME_STREAMING_CONFIGURATION);
     bool isStreaming = pStreamConfig->IsEnabled;
     /* Interface_All is USB+SD — WiFi is NOT used in that mode. Only
-     * explicit Interface_WiFi puts WiFi on the SPI bus. */
+     * explicit Interface_WiFi / WiFiUdp puts WiFi on the SPI bus. */
     bool isWifiStreaming = isStreaming &&
-                          pStreamConfig->ActiveInterface == StreamingInterface_WiFi;
+                          StreamingInterface_IsWiFi(pStreamConfig->ActiveInterface);
     return isWifiStreaming || wifi_manager_IsWifiFirmwareUpdateActive() ||
            SpiBusHealth_IsSdQuarantined();  // #589: jammed-bus quarantine
 }
@@ -555,6 +590,8 @@ void app_SystemInit() {
     // #347 / #350: init the shared SCPI response-buffer mutex before any
     // transport creates its SCPI context or dispatches a callback.
     SCPI_ResponseBuf_Init();
+    // Hashed SCPI command lookup; also before any transport task exists.
+    SCPI_InitCommandIndex();
 
     // Initialize SPI coordination framework (currently disabled)
     // Note: Coordination disabled (SPI0_COORDINATION_ENABLED=0) - no runtime overhead
@@ -910,6 +947,21 @@ static void app_TasksCreate() {
         while (1);
     }
 
+    errStatus = xTaskCreate((TaskFunction_t) sd_card_manager_WriterTask,
+            "SDWriterTask",
+            768,   // Not yet profiled. Runs SYS_FS_FileWrite -> FatFs ->
+                   // diskio -> SDSPI plus the slow-op LOG_E, the same write
+                   // path inside SDCardTask's 468-word profiled peak.
+            NULL,
+            6,  // Pri 6: above SDCardTask, so a submitted chunk starts on the
+                // wire before SDCardTask stages the next one. Blocks on the
+                // SPI DMA for nearly all of its time.
+            NULL);
+    if (errStatus != pdTRUE) {
+        LOG_E("FATAL: Failed to create SDWriterTask\r\n");
+        while (1);
+    }
+
     // Dedicated iperf2 task for tight client-mode pacing (#377).  Runs at
     // pri 5 with adaptive 2 ms (active) / 50 ms (idle) cadence.  WifiTask
     // (pri 2) keeps its 5 ms cadence for streaming + SCPI dispatch paths.
@@ -582,7 +582,9 @@ static const SYS_FS_FUNCTIONS FatFsFunctions =
     .testerror         = FATFS_error,
     .formatDisk        = (FORMAT_DISK)FATFS_mkfs,
     .partitionDisk     = FATFS_fdisk,
-    .getCluster        = FATFS_getclusters
+    .getCluster        = FATFS_getclusters,
+    .reserve           = FATFS_reserve,     /* DAQiFi patch: SD log preallocation */
+    .release           = FATFS_release
 };
 
 
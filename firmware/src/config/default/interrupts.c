@@ -104,6 +104,7 @@ void DMA0_Handler (void);
 void DMA1_Handler (void);
 void DMA2_Handler (void);
 void DMA3_Handler (void);
+void DMA4_Handler (void);
 void SPI2_RX_Handler (void);
 void SPI2_TX_Handler (void);
 void SPI4_RX_Handler (void);
@@ -322,6 +323,15 @@ void __attribute__((used)) DMA3_Handler (void)
     DMA3_InterruptHandler();
 }
 
+// CONF:ADC:SCAN:DMA: DCH4 block-complete stands in for ADC_EOS_Handler while
+// the shared scan is read by DMA (EOS CPU interrupt gated off meanwhile).
+void __attribute__((used)) DMA4_Handler (void)
+{
+    if (MC12b_ScanDmaIsr()) {
+        ADC_EOSInterruptCB(0);
+    }
+}
+
 void __attribute__((used)) SPI2_RX_Handler (void)
 {
     SPI2_RX_InterruptHandler();
@@ -0,0 +1,51 @@
+/*-----------------------------------------------------------------------*/
+/* DAQiFi extension: contiguous preallocation for streamed log files     */
+/* See ffprealloc.h.                                                     */
+/*-----------------------------------------------------------------------*/
+
+#include "ffprealloc.h"
+
+#if FF_USE_EXPAND && !FF_FS_READONLY
+
+FRESULT f_reserve (
+	FIL* fp,		/* Pointer to the file object */
+	FSIZE_t fsz		/* Bytes to allocate */
+)
+{
+	FRESULT res;
+
+
+	/* f_expand() refuses a non-empty file, but a reserved one reads as empty
+	/  again: check the chain too, or a second call would orphan the first. */
+	if (fp->obj.sclust != 0) return FR_DENIED;
+	res = f_expand(fp, fsz, 1);
+	if (res == FR_OK) {
+		/* f_expand() set the size to the extent. Take it back: f_write()
+		/  follows an existing chain through create_chain() without touching
+		/  the FAT, and grows the size as it goes. */
+		fp->obj.objsize = 0;
+		/* Commit the chain and the start cluster now. Left to the first sync
+		/  of the stream, the last FAT sector f_expand() dirtied would go out
+		/  in the middle of it. */
+		res = f_sync(fp);
+	}
+	return res;
+}
+
+
+FRESULT f_release (
+	FIL* fp			/* Pointer to the file object */
+)
+{
+	/* f_truncate() acts only when the pointer is short of the size; the size
+	/  of a reserved file never runs ahead of the pointer, so lift it past for
+	/  the call. f_truncate() sets it back to the pointer itself, removes the
+	/  chain after the current cluster (the whole chain at 0) and flushes a
+	/  dirty partial sector. */
+	if (fp->obj.sclust != 0 && fp->fptr == fp->obj.objsize) {
+		fp->obj.objsize = fp->fptr + 1;
+	}
+	return f_truncate(fp);
+}
+
+#endif /* FF_USE_EXPAND && !FF_FS_READONLY */
@@ -0,0 +1,49 @@
+/*-----------------------------------------------------------------------*/
+/* DAQiFi extension: contiguous preallocation for streamed log files     */
+/*-----------------------------------------------------------------------*/
+/*
+/ A file that grows cluster by cluster takes a FAT walk and dirties a FAT
+/ sector every time it crosses into a new cluster, and that FAT sector then
+/ goes out (to both FATs) on the next f_sync. f_reserve() lays the whole
+/ extent down up front as one contiguous chain, so the streaming writes that
+/ follow only follow the chain: the data sectors are consecutive and no FAT
+/ sector is written until f_release() gives the unused tail back.
+/
+/ Unlike a bare f_expand(), the reserved file keeps its REAL size. f_expand()
+/ sets the size to the whole extent, which every f_sync() would then commit:
+/ a reader (or a power cut) would see the extent's stale tail as file data,
+/ and f_write() would read back every partial sector it touches inside the
+/ extent. f_reserve() keeps the chain but resets the size, so a power cut
+/ leaves a correctly-sized file whose chain runs past its end -- the surplus
+/ clusters are lost to f_getfree() until chkdsk, never visible as data.
+/
+/ Both functions must be called with the volume held (sys_fs takes
+/ mutexDiskVolume around them), like the rest of the FatFs API here.
+*/
+
+#ifndef FFPREALLOC_DEFINED
+#define FFPREALLOC_DEFINED
+
+#include "ff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Allocate fsz bytes (rounded up to whole clusters) as one contiguous chain
+/  for a file just opened for writing and still empty, and commit it. The file
+/  size stays 0. FR_DENIED: the file is not empty, already has a chain or is
+/  not writable, or no contiguous free area that large exists -- the file is
+/  left untouched and grows normally. */
+FRESULT f_reserve (FIL* fp, FSIZE_t fsz);
+
+/* Free the part of the chain past the read/write pointer, as f_truncate()
+/  would if the size still covered the extent. Call before the final f_sync()
+/  or f_close(). A no-op on a file that was never reserved. */
+FRESULT f_release (FIL* fp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FFPREALLOC_DEFINED */
@@ -2585,6 +2585,131 @@ SYS_FS_RESULT SYS_FS_FileTruncate
     }
 }
 
+//******************************************************************************
+/*Function:
+    SYS_FS_RESULT SYS_FS_FileReserve
+    (
+    SYS_FS_HANDLE handle,
+    uint32_t size
+    );
+
+  Summary:
+    Preallocates a contiguous extent for an empty file
+
+  Description:
+    This function allocates size bytes, rounded up to whole clusters, as one
+    contiguous cluster chain for an empty file opened for writing. The file
+    size is not changed.
+
+  Remarks:
+    DAQiFi patch. See sys_fs.h for usage information.
+***************************************************************************/
+SYS_FS_RESULT SYS_FS_FileReserve
+(
+    SYS_FS_HANDLE handle,
+    uint32_t size
+)
+{
+    int fileStatus = -1;
+    SYS_FS_OBJ *obj = (SYS_FS_OBJ *)handle;
+
+    if(handle == SYS_FS_HANDLE_INVALID)
+    {
+        errorValue = SYS_FS_ERROR_INVALID_OBJECT;
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if(obj->inUse == false)
+    {
+        errorValue = SYS_FS_ERROR_INVALID_OBJECT;
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if(obj->mountPoint->fsFunctions->reserve == NULL)
+    {
+        obj->errorValue = SYS_FS_ERROR_NOT_SUPPORTED_IN_NATIVE_FS;
+        return SYS_FS_RES_FAILURE;
+    }
+    if(OSAL_MUTEX_Lock(&(obj->mountPoint->mutexDiskVolume), OSAL_WAIT_FOREVER)
+                                                        == OSAL_RESULT_SUCCESS)
+    {
+        fileStatus = obj->mountPoint->fsFunctions->reserve(obj->nativeFSFileObj, size);
+
+        (void) OSAL_MUTEX_Unlock(&(obj->mountPoint->mutexDiskVolume));
+    }
+
+    if(fileStatus == 0)
+    {
+        return SYS_FS_RES_SUCCESS;
+    }
+    else
+    {
+        obj->errorValue = (SYS_FS_ERROR)fileStatus;
+        return SYS_FS_RES_FAILURE;
+    }
+}
+
+//******************************************************************************
+/*Function:
+    SYS_FS_RESULT SYS_FS_FileRelease
+    (
+    SYS_FS_HANDLE handle
+    );
+
+  Summary:
+    Frees the part of a reserved extent past the file pointer
+
+  Description:
+    This function frees every cluster after the one holding the current
+    read/write pointer. It has no effect on a file that was never reserved.
+
+  Remarks:
+    DAQiFi patch. See sys_fs.h for usage information.
+***************************************************************************/
+SYS_FS_RESULT SYS_FS_FileRelease
+(
+    SYS_FS_HANDLE handle
+)
+{
+    int fileStatus = -1;
+    SYS_FS_OBJ *obj = (SYS_FS_OBJ *)handle;
+
+    if(handle == SYS_FS_HANDLE_INVALID)
+    {
+        errorValue = SYS_FS_ERROR_INVALID_OBJECT;
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if(obj->inUse == false)
+    {
+        errorValue = SYS_FS_ERROR_INVALID_OBJECT;
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if(obj->mountPoint->fsFunctions->release == NULL)
+    {
+        obj->errorValue = SYS_FS_ERROR_NOT_SUPPORTED_IN_NATIVE_FS;
+        return SYS_FS_RES_FAILURE;
+    }
+    if(OSAL_MUTEX_Lock(&(obj->mountPoint->mutexDiskVolume), OSAL_WAIT_FOREVER)
+                                                        == OSAL_RESULT_SUCCESS)
+    {
+        fileStatus = obj->mountPoint->fsFunctions->release(obj->nativeFSFileObj);
+
+        (void) OSAL_MUTEX_Unlock(&(obj->mountPoint->mutexDiskVolume));
+    }
+
+    if(fileStatus == 0)
+    {
+        return SYS_FS_RES_SUCCESS;
+    }
+    else
+    {
+        obj->errorValue = (SYS_FS_ERROR)fileStatus;
+        return SYS_FS_RES_FAILURE;
+    }
+}
+
 //******************************************************************************
 /*Function:
     SYS_FS_RESULT SYS_FS_FileCharacterPut
@@ -23,6 +23,7 @@
 
 #include "system/fs/sys_fs_fat_interface.h"
 #include "system/fs/sys_fs.h"
+#include "system/fs/fat_fs/file_system/ffprealloc.h"
 
 typedef struct
 {
@@ -549,6 +550,35 @@ int FATFS_truncate (
     return ((int)res);
 }
 
+int FATFS_reserve (
+    uintptr_t handle, /* Pointer to the file object */
+    uint32_t size     /* Bytes to allocate */
+)
+{
+    FRESULT res;
+
+    FATFS_FILE_OBJECT *ptr = (FATFS_FILE_OBJECT *)handle;
+    FIL *fp = &ptr->fileObj;
+
+    res = f_reserve(fp, (FSIZE_t)size);
+
+    return ((int)res);
+}
+
+int FATFS_release (
+    uintptr_t handle /* Pointer to the file object */
+)
+{
+    FRESULT res;
+
+    FATFS_FILE_OBJECT *ptr = (FATFS_FILE_OBJECT *)handle;
+    FIL *fp = &ptr->fileObj;
+
+    res = f_release(fp);
+
+    return ((int)res);
+}
+
 int FATFS_chmod (
     const char* path,  /* Pointer to the file path */
     uint8_t attr,       /* Attribute bits */
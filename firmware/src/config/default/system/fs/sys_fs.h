@@ -582,6 +582,10 @@ typedef struct
     /* Function pointer of native file system to get total sectors and free
      * sectors */
     int(*getCluster)(const char *path, uint32_t *tot_sec, uint32_t *free_sec);
+    /* DAQiFi patch: preallocate an empty file as one contiguous extent, and
+     * give the unwritten part back (see fat_fs/file_system/ffprealloc.h) */
+    int(*reserve)(uintptr_t handle, uint32_t size);
+    int(*release)(uintptr_t handle);
 } SYS_FS_FUNCTIONS;
 
 // *****************************************************************************
@@ -2763,6 +2767,74 @@ SYS_FS_RESULT SYS_FS_FileTruncate
     SYS_FS_HANDLE handle
 );
 
+//******************************************************************************
+/* Function:
+    SYS_FS_RESULT SYS_FS_FileReserve
+    (
+        SYS_FS_HANDLE handle,
+        uint32_t size
+    );
+
+    Summary:
+      Preallocates a contiguous extent for an empty file (DAQiFi patch).
+
+    Description:
+      Allocates size bytes, rounded up to whole clusters, as one contiguous
+      cluster chain for a file that was just opened for writing and is still
+      empty, and commits it. The file size is not changed: writes that follow
+      fill the extent in order without allocating, and the size grows with
+      them.
+
+    Precondition:
+      A valid, empty file handle opened with write access.
+
+    Returns:
+      SYS_FS_RES_SUCCESS - The extent was allocated.
+      SYS_FS_RES_FAILURE - Nothing was allocated (not empty, not writable, or
+                           no contiguous free area that large); the file grows
+                           cluster by cluster as usual. SYS_FS_FileError gives
+                           the reason.
+
+    Remarks:
+      Call SYS_FS_FileRelease before the file is closed, or the unwritten part
+      of the extent stays allocated to the file.
+*/
+
+SYS_FS_RESULT SYS_FS_FileReserve
+(
+    SYS_FS_HANDLE handle,
+    uint32_t size
+);
+
+//******************************************************************************
+/* Function:
+    SYS_FS_RESULT SYS_FS_FileRelease
+    (
+        SYS_FS_HANDLE handle
+    );
+
+    Summary:
+      Frees the part of a reserved extent past the file pointer (DAQiFi patch).
+
+    Description:
+      Frees every cluster after the one holding the current read/write
+      pointer, as SYS_FS_FileTruncate would if the file size still covered the
+      reserved extent. Harmless on a file that was never reserved.
+
+    Precondition:
+      A valid file handle opened with write access.
+
+    Returns:
+      SYS_FS_RES_SUCCESS - The unwritten extent was freed.
+      SYS_FS_RES_FAILURE - The release failed; SYS_FS_FileError gives the
+                           reason.
+*/
+
+SYS_FS_RESULT SYS_FS_FileRelease
+(
+    SYS_FS_HANDLE handle
+);
+
 //******************************************************************************
 /* Function:
     SYS_FS_RESULT SYS_FS_FileSync
@@ -84,6 +84,10 @@ int FATFS_setlabel (const char* label);
 
 int FATFS_truncate (uintptr_t handle);
 
+int FATFS_reserve (uintptr_t handle, uint32_t size);
+
+int FATFS_release (uintptr_t handle);
+
 int FATFS_chmod (const char* path, uint8_t attr, uint8_t mask);
 
 int FATFS_utime (const char* path, const uintptr_t ptr);
@@ -0,0 +1,58 @@
+/**
+ * @file   cmdindex.h
+ *
+ * @brief  Command header index (DAQiFi addition)
+ *
+ * findCommandHeader() tries every pattern of the command list in turn, so a
+ * header near the end of a long table costs a few hundred matchCommand()
+ * calls. The index is built once from the command list and hashes a header
+ * to the few patterns that can match it:
+ *
+ * Every node of a header is reduced to a key - trailing digits dropped (the
+ * numeric suffix of "CHANnel#", or a literal "DNS1"), upper-cased, cut to 3
+ * characters. The short and long forms of a pattern node share their first
+ * 3 characters, so both reduce to the same key whenever the short form has
+ * at least 3; a shorter one ("CHannel", "chanCALM") contributes both keys.
+ * The header's hash covers its node keys and whether it is a query, and each
+ * pattern is entered under every hash its optional nodes ("[:NODE]") and
+ * forms can produce.
+ *
+ * A lookup hashes the header (O(length)), then runs matchCommand() on the
+ * patterns in its bucket, in table order, so the result is exactly the
+ * linear scan's. Patterns the index cannot expand (nested or multi-node
+ * optional groups, more than SCPI_COMMAND_INDEX_MAX_NODES nodes) are tried
+ * for every header; headers it cannot hash (":*IDN?", a '?' mid-header) go
+ * through the linear scan.
+ */
+#ifndef SCPI_CMDINDEX_H
+#define SCPI_CMDINDEX_H
+
+#include "scpi/config.h"
+#include "scpi/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SCPI_COMMAND_INDEX_MAX_NODES 8
+
+    /**
+     * Build @p index over @p cmdlist, with @p entries_size entries of storage
+     * at @p entries (one or two per command for a table without optional
+     * nodes). On FALSE - the table did not fit - the index is left disabled
+     * and findCommandHeader() keeps the linear scan.
+     */
+    scpi_bool_t SCPI_CommandIndexInit(scpi_command_index_t * index, const scpi_command_t * cmdlist,
+            scpi_command_index_entry_t * entries, size_t entries_size);
+
+    /**
+     * The first command of the index's list whose pattern matches @p header,
+     * or NULL - the same command the linear scan would find.
+     */
+    const scpi_command_t * SCPI_CommandIndexFind(const scpi_command_index_t * index, const char * header, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCPI_CMDINDEX_H */
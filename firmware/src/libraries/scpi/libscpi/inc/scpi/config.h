@@ -180,6 +180,15 @@ extern "C" {
 #define USE_UNITS_ELECTRIC_CHARGE_CONDUCTANCE SYSTEM_TYPE
 #endif
 
+/**
+ * DAQiFi addition: hash buckets of the command index (cmdindex.h), a power
+ * of two. Costs 2 bytes per bucket; a few hundred commands spread over 128
+ * buckets leave about three entries to scan per lookup.
+ */
+#ifndef SCPI_COMMAND_INDEX_BUCKETS
+#define SCPI_COMMAND_INDEX_BUCKETS 128
+#endif
+
 /* define local macros depending on existance of strnlen */
 #if HAVE_STRNLEN
 #define SCPIDEFINE_strnlen(s, l)	strnlen((s), (l))
@@ -421,6 +421,21 @@ extern "C" {
         scpi_command_callback_t reset;
     };
 
+    struct _scpi_command_index_entry_t {
+        uint16_t tag;
+        uint16_t cmd;
+    };
+    typedef struct _scpi_command_index_entry_t scpi_command_index_entry_t;
+
+    struct _scpi_command_index_t {
+        const scpi_command_t * cmdlist;
+        scpi_command_index_entry_t * entries;
+        uint16_t hashed;
+        uint16_t unindexed;
+        uint16_t bucket[SCPI_COMMAND_INDEX_BUCKETS + 1];
+    };
+    typedef struct _scpi_command_index_t scpi_command_index_t;
+
     struct _scpi_t {
         const scpi_command_t * cmdlist;
         scpi_buffer_t buffer;
@@ -440,6 +455,7 @@ extern "C" {
         scpi_parser_state_t parser_state;
         const char * idn[4];
         size_t arbitrary_remaining;
+        const scpi_command_index_t * cmd_index;
     };
 
     enum _scpi_array_format_t {
@@ -0,0 +1,345 @@
+/**
+ * @file   cmdindex.c
+ *
+ * @brief  Command header index (DAQiFi addition), see cmdindex.h
+ *
+ *
+ */
+
+#include <ctype.h>
+#include <string.h>
+
+#include "scpi/cmdindex.h"
+#include "utils_private.h"
+
+#define INDEX_KEY_LEN           3
+#define INDEX_MAX_EXPANSIONS    32
+#define INDEX_MAX_COMMANDS      0xFFFFu
+
+/* 32-bit FNV-1a */
+#define INDEX_HASH_INIT         2166136261u
+#define INDEX_HASH_PRIME        16777619u
+
+typedef struct {
+    const char * key[2];
+    size_t key_len[2];
+    int keys;
+    scpi_bool_t optional;
+} index_node_t;
+
+typedef struct {
+    index_node_t node[SCPI_COMMAND_INDEX_MAX_NODES];
+    int count;
+    scpi_bool_t query;
+} index_pattern_t;
+
+static uint32_t indexHashChar(uint32_t hash, char c) {
+    return (hash ^ (uint8_t) toupper((unsigned char) c)) * INDEX_HASH_PRIME;
+}
+
+/**
+ * Reduce a keyword to its key: trailing digits dropped, cut to INDEX_KEY_LEN
+ * @param str - keyword
+ * @param len - keyword length
+ * @return key length (the key starts at str)
+ */
+static size_t indexKeyLen(const char * str, size_t len) {
+    while (len > 0 && isdigit((unsigned char) str[len - 1])) {
+        len--;
+    }
+    return (len > INDEX_KEY_LEN) ? INDEX_KEY_LEN : len;
+}
+
+static uint32_t indexHashKey(uint32_t hash, const char * key, size_t len) {
+    size_t i;
+    for (i = 0; i < len; i++) {
+        hash = indexHashChar(hash, key[i]);
+    }
+    return indexHashChar(hash, ':');
+}
+
+/**
+ * Split a pattern into nodes with their keys. Accepts the forms matchCommand
+ * treats as single-node optional groups: "[:NODE]" anywhere, "[NODE]" first.
+ * @param pattern
+ * @param out - parsed pattern
+ * @return FALSE if the pattern has to be tried for every header
+ */
+static scpi_bool_t indexParsePattern(const char * pattern, index_pattern_t * out) {
+    size_t len = strlen(pattern);
+    size_t pos = 0;
+
+    out->count = 0;
+    out->query = FALSE;
+    if ((len > 0) && (pattern[len - 1] == '?')) {
+        out->query = TRUE;
+        len--;
+    }
+
+    while (pos < len) {
+        index_node_t * node;
+        size_t start;
+        size_t end;
+        size_t short_len;
+        scpi_bool_t optional = FALSE;
+
+        if (out->count == SCPI_COMMAND_INDEX_MAX_NODES) {
+            return FALSE;
+        }
+        if (pattern[pos] == '[') {
+            optional = TRUE;
+            pos++;
+        }
+        if ((pos < len) && (pattern[pos] == ':')) {
+            pos++;
+        } else if (out->count > 0) {
+            return FALSE;
+        }
+
+        start = pos;
+        while ((pos < len) && (strchr(":[]?#", pattern[pos]) == NULL)) {
+            pos++;
+        }
+        end = pos;
+        if ((pos < len) && (pattern[pos] == '#')) {
+            pos++;
+        }
+        if (end == start) {
+            return FALSE;
+        }
+        if (optional) {
+            if ((pos >= len) || (pattern[pos] != ']')) {
+                return FALSE;
+            }
+            pos++;
+        }
+        if ((pos < len) && (pattern[pos] != ':') && (pattern[pos] != '[')) {
+            return FALSE;
+        }
+
+        /* short form: up to the first lowercase letter, as matchPattern */
+        for (short_len = 0; short_len < end - start; short_len++) {
+            if (islower((unsigned char) pattern[start + short_len])) {
+                break;
+            }
+        }
+
+        node = &out->node[out->count++];
+        node->optional = optional;
+        node->key[0] = &pattern[start];
+        node->key_len[0] = indexKeyLen(&pattern[start], short_len);
+        node->key[1] = &pattern[start];
+        node->key_len[1] = indexKeyLen(&pattern[start], end - start);
+        node->keys = (node->key_len[0] == node->key_len[1]) ? 1 : 2;
+    }
+
+    return out->count > 0;
+}
+
+static int indexExpansions(const index_pattern_t * pattern) {
+    int result = 1;
+    int i;
+    for (i = 0; i < pattern->count; i++) {
+        result *= pattern->node[i].keys + (pattern->node[i].optional ? 1 : 0);
+        if (result > INDEX_MAX_EXPANSIONS) {
+            break;
+        }
+    }
+    return result;
+}
+
+/**
+ * Enter a command under every hash its pattern can produce: pass one
+ * (fill FALSE) counts bucket sizes into bucket[b + 1], pass two writes the
+ * entries through the cursors in bucket[b].
+ * @return number of entries
+ */
+static size_t indexExpand(scpi_command_index_t * index, const index_pattern_t * pattern,
+        int node, uint32_t hash, uint16_t cmd, scpi_bool_t fill) {
+    const index_node_t * n;
+    size_t result = 0;
+    int k;
+
+    if (node == pattern->count) {
+        uint32_t b;
+        if (pattern->query) {
+            hash = indexHashChar(hash, '?');
+        }
+        b = hash & (SCPI_COMMAND_INDEX_BUCKETS - 1);
+        if (fill) {
+            scpi_command_index_entry_t * e = &index->entries[index->bucket[b]++];
+            e->tag = (uint16_t) (hash >> 16);
+            e->cmd = cmd;
+        } else {
+            index->bucket[b + 1]++;
+        }
+        return 1;
+    }
+
+    n = &pattern->node[node];
+    if (n->optional) {
+        result += indexExpand(index, pattern, node + 1, hash, cmd, fill);
+    }
+    for (k = 0; k < n->keys; k++) {
+        result += indexExpand(index, pattern, node + 1, indexHashKey(hash, n->key[k], n->key_len[k]), cmd, fill);
+    }
+    return result;
+}
+
+static scpi_bool_t indexCommand(const scpi_command_t * cmd, index_pattern_t * pattern) {
+    return indexParsePattern(cmd->pattern, pattern) &&
+            (indexExpansions(pattern) <= INDEX_MAX_EXPANSIONS);
+}
+
+/**
+ * Build the index
+ * @param index
+ * @param cmdlist - command list, terminated by a NULL pattern
+ * @param entries - entry storage
+ * @param entries_size - number of entries at entries
+ * @return TRUE if the whole list was indexed
+ */
+scpi_bool_t SCPI_CommandIndexInit(scpi_command_index_t * index, const scpi_command_t * cmdlist,
+        scpi_command_index_entry_t * entries, size_t entries_size) {
+    index_pattern_t pattern;
+    size_t total = 0;
+    size_t i;
+    int b;
+
+    memset(index, 0, sizeof (*index));
+    if ((cmdlist == NULL) || (entries == NULL)) {
+        return FALSE;
+    }
+    if (entries_size > INDEX_MAX_COMMANDS) {
+        entries_size = INDEX_MAX_COMMANDS;
+    }
+    index->entries = entries;
+
+    for (i = 0; cmdlist[i].pattern != NULL; i++) {
+        if (indexCommand(&cmdlist[i], &pattern)) {
+            total += indexExpand(index, &pattern, 0, INDEX_HASH_INIT, (uint16_t) i, FALSE);
+        } else {
+            total++;
+        }
+        /* checked per command, so no bucket count can wrap */
+        if ((i >= INDEX_MAX_COMMANDS) || (total > entries_size)) {
+            memset(index, 0, sizeof (*index));
+            return FALSE;
+        }
+    }
+    for (b = 0; b < SCPI_COMMAND_INDEX_BUCKETS; b++) {
+        index->bucket[b + 1] += index->bucket[b];
+    }
+    index->hashed = index->bucket[SCPI_COMMAND_INDEX_BUCKETS];
+
+    for (i = 0; cmdlist[i].pattern != NULL; i++) {
+        if (indexCommand(&cmdlist[i], &pattern)) {
+            indexExpand(index, &pattern, 0, INDEX_HASH_INIT, (uint16_t) i, TRUE);
+        } else {
+            scpi_command_index_entry_t * e = &entries[index->hashed + index->unindexed++];
+            e->tag = 0;
+            e->cmd = (uint16_t) i;
+        }
+    }
+    /* the cursors now hold each bucket's end: shift them back to starts */
+    for (b = SCPI_COMMAND_INDEX_BUCKETS - 1; b > 0; b--) {
+        index->bucket[b] = index->bucket[b - 1];
+    }
+    index->bucket[0] = 0;
+
+    index->cmdlist = cmdlist;
+    return TRUE;
+}
+
+static const scpi_command_t * indexLinear(const scpi_command_t * cmdlist, const char * header, size_t len) {
+    size_t i;
+    for (i = 0; cmdlist[i].pattern != NULL; i++) {
+        if (matchCommand(cmdlist[i].pattern, header, len, NULL, 0, 0)) {
+            return &cmdlist[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Find the command matching a header
+ * @param index
+ * @param header - program header, e.g. "SYST:STR:STOP" or ":meas:volt:dc?"
+ * @param len - header length
+ * @return first matching command of the list or NULL
+ */
+const scpi_command_t * SCPI_CommandIndexFind(const scpi_command_index_t * index, const char * header, size_t len) {
+    const scpi_command_t * cmdlist = index->cmdlist;
+    const scpi_command_index_entry_t * e = index->entries;
+    size_t n = SCPIDEFINE_strnlen(header, len);
+    size_t pos = 0;
+    uint32_t hash = INDEX_HASH_INIT;
+    size_t i, i_end, w, w_end;
+    uint16_t tag;
+    int32_t last = -1;
+    scpi_bool_t query = FALSE;
+
+    /* Headers matchCommand treats specially go the long way */
+    if (n == 0) {
+        return indexLinear(cmdlist, header, len);
+    }
+    if (header[0] == ':') {
+        if ((n < 2) || (header[1] == '*')) {
+            return indexLinear(cmdlist, header, len);
+        }
+        pos = 1;
+    }
+    if (header[n - 1] == '?') {
+        query = TRUE;
+        n--;
+    }
+    if (n <= pos) {
+        return indexLinear(cmdlist, header, len);
+    }
+
+    while (1) {
+        size_t start = pos;
+        while ((pos < n) && (header[pos] != ':')) {
+            if (header[pos] == '?') {
+                return indexLinear(cmdlist, header, len);
+            }
+            pos++;
+        }
+        hash = indexHashKey(hash, &header[start], indexKeyLen(&header[start], pos - start));
+        if (pos >= n) {
+            break;
+        }
+        pos++;
+    }
+    if (query) {
+        hash = indexHashChar(hash, '?');
+    }
+
+    /* The bucket and the unindexed run are both in table order: merge */
+    tag = (uint16_t) (hash >> 16);
+    i = index->bucket[hash & (SCPI_COMMAND_INDEX_BUCKETS - 1)];
+    i_end = index->bucket[(hash & (SCPI_COMMAND_INDEX_BUCKETS - 1)) + 1];
+    w = index->hashed;
+    w_end = (size_t) index->hashed + index->unindexed;
+    while (1) {
+        uint16_t cmd;
+        while ((i < i_end) && (e[i].tag != tag)) {
+            i++;
+        }
+        if ((i < i_end) && ((w >= w_end) || (e[i].cmd < e[w].cmd))) {
+            cmd = e[i++].cmd;
+        } else if (w < w_end) {
+            cmd = e[w++].cmd;
+        } else {
+            break;
+        }
+        if ((int32_t) cmd == last) {
+            continue;
+        }
+        last = cmd;
+        if (matchCommand(cmdlist[cmd].pattern, header, len, NULL, 0, 0)) {
+            return &cmdlist[cmd];
+        }
+    }
+    return NULL;
+}
@@ -45,6 +45,7 @@
 #include "scpi/error.h"
 #include "scpi/constants.h"
 #include "scpi/utils.h"
+#include "scpi/cmdindex.h"
 
 /**
  * Write data to SCPI output
@@ -168,6 +169,8 @@ static scpi_bool_t processCommand(scpi_t * context) {
 
 /**
  * Cycle all patterns and search matching pattern. Execute command callback.
+ * With a command index attached (DAQiFi addition) only the patterns it
+ * selects are tried; the first match in table order wins either way.
  * @param context
  * @result TRUE if context->paramlist is filled with correct values
  */
@@ -175,6 +178,15 @@ static scpi_bool_t findCommandHeader(scpi_t * context, const char * header, int
     int32_t i;
     const scpi_command_t * cmd;
 
+    if (context->cmd_index != NULL && context->cmd_index->cmdlist == context->cmdlist) {
+        cmd = SCPI_CommandIndexFind(context->cmd_index, header, len);
+        if (cmd != NULL) {
+            context->param_list.cmd = cmd;
+            return TRUE;
+        }
+        return FALSE;
+    }
+
     for (i = 0; context->cmdlist[i].pattern != NULL; i++) {
         cmd = &context->cmdlist[i];
         if (matchCommand(cmd->pattern, header, len, NULL, 0, 0)) {
@@ -45,8 +45,8 @@
 #define STREAMING_MSG_MAX_SIZE (                                              \
     PB_VARINT32_MAX +                            /* length-delimited prefix */\
     PB_TAG1_SIZE + PB_VARINT32_MAX +             /* field 1: uint32 ts */     \
-    PB_TAG1_SIZE + PB_VARINT32_MAX +             /* field 2: packed length */ \
-    (PB_AIN_MAX_COUNT * PB_VARINT32_MAX) +       /* field 2: sint32 values */\
+    PB_TAG2_SIZE + PB_VARINT32_MAX +             /* field 2 (73): length */   \
+    (PB_AIN_MAX_COUNT * PB_VARINT32_MAX) +       /* field 2 (73): values */   \
     PB_TAG1_SIZE + 1 + PB_DIO_DATA_MAX +         /* field 5: digital_data */ \
     PB_TAG2_SIZE + 1 + PB_DIO_DIR_MAX            /* field 37: port_dir */    \
 )
@@ -574,18 +574,21 @@ size_t Nanopb_Encode(tBoardData* state,
                  * 0 when no rate has been configured yet, so a client can tell
                  * "unconfigured" from a real value. Computed by the streaming
                  * module so these can never disagree with the stamps the
-                 * deferred task actually emits (#717 gStreamPeriodTicks). */
+                 * deferred task actually emits (#717 gStreamPeriodTicks).
+                 * Scaled by the adaptive-rate divisor, which is 1 except in
+                 * the rate stamps of a decimated session. */
                 const StreamingRuntimeConfig* cfg = BoardRunTimeConfig_Get(
                         BOARDRUNTIME_STREAMING_CONFIGURATION);
                 uint32_t clockPeriod = (cfg != NULL) ? cfg->ClockPeriod : 0u;
                 bool configured = Streaming_IsRateConfigured();
+                uint32_t divisor = Streaming_RateStampDivisor();
                 if (fields->Data[i] ==
                         DaqifiOutMessage_timestamp_ticks_per_sample_tag) {
                     message.timestamp_ticks_per_sample = configured
-                            ? Streaming_TimestampTicksPerSample(clockPeriod) : 0u;
+                            ? Streaming_TimestampTicksPerSample(clockPeriod) * divisor : 0u;
                 } else {
                     message.actual_rate_millihz = configured
-                            ? Streaming_ActualRateMilliHz(clockPeriod) : 0u;
+                            ? Streaming_ActualRateMilliHz(clockPeriod) / divisor : 0u;
                 }
                 break;
             }
@@ -796,6 +799,10 @@ size_t Nanopb_Encode(tBoardData* state,
                     default:
                         break;
                 }
+                /* A decimated session with extra bits streams codes scaled
+                 * by 2^bits: report the code count they run over, so the
+                 * consumer formula above stays right unchanged. */
+                message.analog_in_res <<= Streaming_CodeScaleBits();
 
                 break;
             }
@@ -1234,22 +1241,21 @@ void int2PBByteArray(const size_t integer,
  *
  * ENCODING APPROACH:
  * ------------------
- * Uses nanopb's public low-level encoding API:
- *   - pb_encode_tag()    : write field tag (field number + wire type)
- *   - pb_encode_varint() : write unsigned variable-length integer
- *   - pb_encode_svarint(): write signed zigzag-encoded varint
- *   - pb_encode_string() : write length-prefixed byte array
- *   - PB_OSTREAM_SIZING  : null stream that counts bytes without writing
- *
- * The two-pass pattern (size then encode) matches how nanopb implements
- * pb_encode_delimited() internally, but only touches 2-4 fields instead
- * of 65.
+ * Writes the wire bytes directly into the output buffer in one front-to-back
+ * pass (encode_streaming_msg_delimited). Both length prefixes -- the
+ * message's and the packed analog payload's -- are provably a single varint
+ * byte, so each is reserved and patched once the bytes behind it are down.
+ * No pb_ostream_t, no PB_OSTREAM_SIZING pass, and each channel value is
+ * zigzagged and written exactly once. The earlier version ran the fields
+ * twice through nanopb's stream API (size, then encode) plus a third sizing
+ * pass over the values; at 16 channels that sizing was most of the encode.
  *
  * WHEN TO MODIFY THIS CODE:
  * -------------------------
  * If the streaming message format changes (new fields added to the
  * streaming path, field types changed, or tag numbers reassigned),
- * update encode_streaming_fields() to match. The field tags are
+ * update encode_streaming_msg_delimited() to match (and the differential
+ * test in tests/host/test_pb_stream.c will say so). The field tags are
  * defined in DaqifiOutMessage.pb.h as DaqifiOutMessage_*_tag macros.
  *
  * For metadata/config messages (device info, network config, etc.),
@@ -1271,140 +1277,261 @@ void int2PBByteArray(const size_t integer,
  *   16ch: 3kHz -> 5kHz   (1.7x improvement)
  * ========================================================================= */
 
+/* Single-pass wire writer.
+ *
+ * Every length a streaming message carries is bounded at compile time below
+ * 128, so each one is a single varint byte that can be reserved and patched
+ * once the bytes behind it are down: the packed analog payload is at most
+ * 16 x 5 bytes, the whole inner message at most STREAMING_MSG_MAX_SIZE minus
+ * its own prefix. That lets the message be written front to back with each
+ * channel value zigzagged and emitted exactly once -- no PB_OSTREAM_SIZING
+ * pass over the fields, no sub-sizing pass over the values, no pb_ostream_t
+ * callback per byte. The asserts pin the bound; if a future .options change
+ * breaks it, this writer must grow a multi-byte length path. */
+_Static_assert(PB_AIN_MAX_COUNT * PB_VARINT32_MAX <= 127u,
+               "packed analog_in_data length must fit one varint byte");
+_Static_assert(STREAMING_MSG_MAX_SIZE - PB_VARINT32_MAX <= 127u,
+               "streaming message length must fit one varint byte");
+_Static_assert(PB_DIO_DATA_MAX <= 127u && PB_DIO_DIR_MAX <= 127u,
+               "DIO byte fields must have single-byte lengths");
+
+#define PB_WIRE_TAG(field, wt) ((uint32_t)(((uint32_t)(field) << 3) | (uint32_t)(wt)))
+
+static inline uint8_t* pbw_put_varint(uint8_t* p, uint32_t value) {
+    while (value >= 0x80u) {
+        *p++ = (uint8_t)(value | 0x80u);
+        value >>= 7;
+    }
+    *p++ = (uint8_t)value;
+    return p;
+}
+
+static inline size_t pbw_varint_size(uint32_t value) {
+    if (value < (1u << 7))  return 1;
+    if (value < (1u << 14)) return 2;
+    if (value < (1u << 21)) return 3;
+    if (value < (1u << 28)) return 4;
+    return 5;
+}
+
+/* sint32 zigzag, same mapping as pb_encode_svarint(). */
+static inline uint32_t pbw_zigzag32(int32_t value) {
+    return (value < 0) ? ~((uint32_t)value << 1) : ((uint32_t)value << 1);
+}
+
+static inline uint8_t* pbw_put_bytes_field(uint8_t* p, uint32_t tag,
+                                           const uint8_t* data, size_t size) {
+    p = pbw_put_varint(p, tag);
+    *p++ = (uint8_t)size;
+    memcpy(p, data, size);
+    return p + size;
+}
+
 /**
- * @brief Encode streaming fields to a pb_ostream_t.
+ * @brief Encode a single length-delimited streaming message to a buffer.
+ *
+ * Produces one protobuf message with a varint length prefix, suitable for
+ * concatenation in a stream (the standard protobuf delimited format used
+ * by all DAQiFi clients). Byte-identical to pb_encode_delimited() of a
+ * DaqifiOutMessage carrying only these fields (tests/host/test_pb_stream.c).
+ *
+ * Field order and proto3 presence rules match the generated descriptor:
+ * timestamp omitted when 0, analog_in_data omitted when empty, the DIO
+ * byte fields omitted when NULL/empty.
  *
- * Writes the protobuf wire format for streaming-specific fields only.
- * Works with both sizing streams (PB_OSTREAM_SIZING) and real buffer
- * streams (pb_ostream_from_buffer). Call once with a sizing stream to
- * get the encoded size, then again with a real stream to write bytes.
+ * When @p buffSize can't hold a worst-case message the bytes are built in a
+ * stack scratch first and copied only if they fit, so a short buffer fails
+ * cleanly (returns 0, nothing written past the end) instead of truncating.
  *
- * @param stream    nanopb output stream (sizing or buffer-backed)
- * @param timestamp Sample set timestamp (ISR trigger time from hardware timer)
- * @param ainData   Array of raw ADC values (sint32, zigzag-encoded on wire)
- * @param ainCount  Number of values in ainData (= number of enabled channels)
- * @param dioData   Digital I/O sample bytes (2 bytes, LSB=ch0), or NULL
- * @param dioSize   Size of dioData (0 if no DIO data)
- * @param dioDir    Digital port direction bitmap bytes, or NULL
- * @param dioDirSize Size of dioDir (0 if no direction data)
- * @return true on success, false if stream write failed
+ * @param pBuffer   Output buffer
+ * @param buffSize  Available space in output buffer
+ * @param timestamp Sample set timestamp
+ * @param ainField  Field number for the packed values: analog_in_data (2),
+ *                  or PB_DELTA_ANALOG_IN_TAG (73) when they are deltas
+ * @param ainData   ADC channel values array, or NULL if no AIN data
+ * @param ainCount  Number of AIN values (0 if no AIN data)
+ * @param dioData   Digital I/O sample bytes, or NULL
+ * @param dioSize   Size of dioData
+ * @param dioDir    Digital port direction bytes, or NULL
+ * @param dioDirSize Size of dioDir
+ * @return Bytes written to pBuffer, or 0 on error
  */
-static bool encode_streaming_fields(pb_ostream_t *stream,
-        uint32_t timestamp,
+static size_t encode_streaming_msg_delimited(
+        uint8_t* pBuffer, size_t buffSize,
+        uint32_t timestamp, uint32_t ainField,
         const int32_t* ainData, size_t ainCount,
         const uint8_t* dioData, size_t dioSize,
         const uint8_t* dioDir, size_t dioDirSize) {
 
+    if (ainCount > PB_AIN_MAX_COUNT || dioSize > PB_DIO_DATA_MAX ||
+        dioDirSize > PB_DIO_DIR_MAX) {
+        LOG_E_SESSION(LOG_SESSION_NANOPB_FAIL, "NanoPB: streaming field over max");
+        return 0;
+    }
+
+    uint8_t scratch[STREAMING_MSG_MAX_SIZE];
+    uint8_t* out = (buffSize >= STREAMING_MSG_MAX_SIZE) ? pBuffer : scratch;
+    uint8_t* p = out + 1;                  /* out[0]: length prefix, patched last */
+
     /* Field 1: msg_time_stamp (uint32, wire type 0 = varint)
      * Proto3: zero-valued fields are omitted (not encoded on wire). */
     if (timestamp != 0) {
-        if (!pb_encode_tag(stream, PB_WT_VARINT, DaqifiOutMessage_msg_time_stamp_tag))
-            return false;
-        if (!pb_encode_varint(stream, (uint32_t)timestamp))
-            return false;
+        p = pbw_put_varint(p, PB_WIRE_TAG(DaqifiOutMessage_msg_time_stamp_tag, PB_WT_VARINT));
+        p = pbw_put_varint(p, timestamp);
     }
 
-    /* Field 2: analog_in_data (packed repeated sint32, wire type 2 = length-delimited)
-     *
-     * Proto3 packs repeated scalar fields by default. The packed format is:
+    /* Field 2: analog_in_data (packed repeated sint32, wire type 2)
      *   [tag] [varint: total_payload_bytes] [zigzag_val1] [zigzag_val2] ...
-     *
-     * Each sint32 value is zigzag-encoded: (n << 1) ^ (n >> 31), then
-     * varint-encoded. This makes small negative values compact (e.g., -1 = 1 byte).
-     *
-     * We need the packed payload size BEFORE writing it (for the length prefix),
-     * so we use a sizing sub-stream to calculate it first. */
+     * The payload length byte is reserved and patched after the values.
+     * Delta-coded messages carry the same layout under field 73. */
     if (ainCount > 0) {
-        /* Sub-sizing pass: count bytes for all zigzag varints */
-        pb_ostream_t sizestream = PB_OSTREAM_SIZING;
+        p = pbw_put_varint(p, PB_WIRE_TAG(ainField, PB_WT_STRING));
+        uint8_t* pLen = p++;
+        const uint8_t* payload = p;
         for (size_t i = 0; i < ainCount; i++) {
-            if (!pb_encode_svarint(&sizestream, (int32_t)ainData[i]))
-                return false;
-        }
-
-        /* Write: [tag 2, wire type 2] [payload length] [zigzag values...] */
-        if (!pb_encode_tag(stream, PB_WT_STRING, DaqifiOutMessage_analog_in_data_tag))
-            return false;
-        if (!pb_encode_varint(stream, (uint32_t)sizestream.bytes_written))
-            return false;
-        for (size_t i = 0; i < ainCount; i++) {
-            if (!pb_encode_svarint(stream, (int32_t)ainData[i]))
-                return false;
+            p = pbw_put_varint(p, pbw_zigzag32(ainData[i]));
         }
+        *pLen = (uint8_t)(p - payload);
     }
 
-    /* Field 5: digital_data (bytes, wire type 2 = length-delimited)
+    /* Field 5: digital_data (bytes, wire type 2)
      * 2-byte bitmap: bit N = digital channel N value (LSB = ch0). */
     if (dioData != NULL && dioSize > 0) {
-        if (!pb_encode_tag(stream, PB_WT_STRING, DaqifiOutMessage_digital_data_tag))
-            return false;
-        if (!pb_encode_string(stream, dioData, dioSize))
-            return false;
+        p = pbw_put_bytes_field(p, PB_WIRE_TAG(DaqifiOutMessage_digital_data_tag, PB_WT_STRING),
+                                dioData, dioSize);
     }
 
-    /* Field 37: digital_port_dir (bytes, wire type 2 = length-delimited)
+    /* Field 37: digital_port_dir (bytes, wire type 2)
      * 2-byte bitmap: bit N = 1 if channel N is input, 0 if output.
      * Tag 37 requires 2 bytes on wire: (37 << 3 | 2) = 298 = 0xAA 0x02. */
     if (dioDir != NULL && dioDirSize > 0) {
-        if (!pb_encode_tag(stream, PB_WT_STRING, DaqifiOutMessage_digital_port_dir_tag))
-            return false;
-        if (!pb_encode_string(stream, dioDir, dioDirSize))
-            return false;
+        p = pbw_put_bytes_field(p, PB_WIRE_TAG(DaqifiOutMessage_digital_port_dir_tag, PB_WT_STRING),
+                                dioDir, dioDirSize);
     }
 
-    return true;
+    size_t total = (size_t)(p - out);
+    out[0] = (uint8_t)(total - 1u);
+
+    if (out == scratch) {
+        if (total > buffSize) {
+            LOG_E_SESSION(LOG_SESSION_NANOPB_FAIL, "NanoPB: streaming encode failed");
+            return 0;
+        }
+        memcpy(pBuffer, scratch, total);
+    }
+    return total;
 }
 
-/**
- * @brief Encode a single length-delimited streaming message to a buffer.
+/* Streaming DIO fields for one encoder call: at most one queued DIO sample
+ * plus the port-direction bitmap, shared by the per-sample and block paths. */
+typedef struct {
+    uint8_t  values[2];
+    size_t   size;
+    uint8_t  dir[2];
+    size_t   dirSize;
+    uint32_t timestamp;
+} StreamingDioFields;
+
+static void prepare_streaming_dio(tBoardData* state, bool hasDIO,
+                                  StreamingDioFields* dio) {
+    memset(dio, 0, sizeof(*dio));
+    dio->timestamp = state->StreamTrigStamp;  /* #614: fallback if no DIO sample */
+    if (!hasDIO) {
+        return;
+    }
+
+    const tBoardConfig* pBoardConfig = BoardConfig_Get(BOARDCONFIG_ALL_CONFIG, 0);
+    DIORuntimeArray* pRuntimeDIOChannels = BoardRunTimeConfig_Get(BOARDRUNTIMECONFIG_DIO_CHANNELS);
+
+    DIOSample DIOdata;
+    if (DIOSampleList_PopFront(&state->DIOSamples, &DIOdata)) {
+        memcpy(dio->values, &DIOdata.Values, sizeof(dio->values));
+        dio->size = sizeof(dio->values);
+        /* #614 (Qodo): stamp the standalone DIO frame with the tick that
+         * captured this sample, not the live StreamTrigStamp, which drifts
+         * ahead under encoder lag. */
+        dio->timestamp = DIOdata.Timestamp;
+    }
+
+    /* Build port direction bitmap (1=input per channel) */
+    uint32_t dirData = 0;
+    for (uint32_t x = 0; x < pBoardConfig->DIOChannels.Size && x < 32; x++) {
+        dirData |= ((uint32_t)pRuntimeDIOChannels->Data[x].IsInput << x);
+    }
+    for (size_t y = 0; y < sizeof(dio->dir); y++) {
+        dio->dir[y] = (uint8_t)(dirData >> (y * 8));
+    }
+    dio->dirSize = sizeof(dio->dir);
+}
+
+/* Delta coding of the per-sample path (StreamingRuntimeConfig
+ * PbDeltaKeyframeInterval, SYST:STR:DELTa).
  *
- * Produces one protobuf message with a varint length prefix, suitable for
- * concatenation in a stream (the standard protobuf delimited format used
- * by all DAQiFi clients).
+ * A delta message is a normal per-sample message whose packed values sit in
+ * field 73 (analog_in_data_delta) instead of field 2, each the wrapping int32
+ * difference from the same channel in the previous AIN message. Keyframes
+ * are ordinary field-2 messages, byte-identical to the non-delta path, so a
+ * legacy client still decodes every keyframe and a delta-aware one can join
+ * the stream at any of them.
  *
- * Uses two passes:
- *   1. Sizing pass (PB_OSTREAM_SIZING) — counts inner message bytes
- *   2. Encoding pass — writes [varint length] [message bytes] to buffer
+ * A message goes out as a keyframe when: no previous AIN message exists this
+ * session, the channel layout (channelCount/validMask) changed, K-1 deltas
+ * have followed the last keyframe, a keyframe was forced (SD file rotation,
+ * a transport drop, a failed encode), or the deltas would not be smaller
+ * than the absolute values. The last rule keeps a delta session's byte rate
+ * at or below the plain PB rate, so the PB transport caps still hold.
  *
- * @param pBuffer   Output buffer
- * @param buffSize  Available space in output buffer
- * @param timestamp Sample set timestamp
- * @param ainData   ADC channel values array, or NULL if no AIN data
- * @param ainCount  Number of AIN values (0 if no AIN data)
- * @param dioData   Digital I/O sample bytes, or NULL
- * @param dioSize   Size of dioData
- * @param dioDir    Digital port direction bytes, or NULL
- * @param dioDirSize Size of dioDir
- * @return Bytes written to pBuffer, or 0 on error
- */
-static size_t encode_streaming_msg_delimited(
-        uint8_t* pBuffer, size_t buffSize,
-        uint32_t timestamp,
-        const int32_t* ainData, size_t ainCount,
-        const uint8_t* dioData, size_t dioSize,
-        const uint8_t* dioDir, size_t dioDirSize) {
+ * State is owned by streaming_Task (the only caller of the encoder and of
+ * Nanopb_StreamingDeltaForceKeyframe); Nanopb_StreamingDeltaConfigure runs
+ * at Start/Stop while no encode is in flight. */
+static struct {
+    uint32_t interval;        /* K; 0 = off */
+    uint32_t sinceKey;        /* deltas sent since the last keyframe */
+    bool     forceKey;
+    bool     havePrev;
+    uint16_t validMask;       /* layout of prev[] */
+    uint16_t channelCount;
+    int32_t  prev[MAX_AIN_PUBLIC_CHANNELS];
+} gPbDelta;
+
+void Nanopb_StreamingDeltaConfigure(uint32_t keyframeInterval) {
+    memset(&gPbDelta, 0, sizeof(gPbDelta));
+    gPbDelta.interval = keyframeInterval;
+    gPbDelta.forceKey = true;
+}
 
-    /* Pass 1: calculate inner message size without writing */
-    pb_ostream_t sizestream = PB_OSTREAM_SIZING;
-    if (!encode_streaming_fields(&sizestream, timestamp,
-            ainData, ainCount, dioData, dioSize, dioDir, dioDirSize)) {
-        LOG_E_SESSION(LOG_SESSION_NANOPB_FAIL, "NanoPB: streaming size pass failed");
-        return 0;
-    }
+void Nanopb_StreamingDeltaForceKeyframe(void) {
+    gPbDelta.forceKey = true;
+}
 
-    /* Pass 2: write [varint length prefix] [message bytes] to buffer */
-    pb_ostream_t stream = pb_ostream_from_buffer(pBuffer, buffSize);
-    if (!pb_encode_varint(&stream, (uint32_t)sizestream.bytes_written)) {
-        LOG_E_SESSION(LOG_SESSION_NANOPB_FAIL, "NanoPB: varint encode failed");
-        return 0;
+/* Fill @p deltas and return true if this sample set should go out delta
+ * coded; false means send @p values as a keyframe. */
+static bool pb_delta_choose(uint16_t validMask, uint16_t channelCount,
+                            const int32_t* values, size_t count,
+                            int32_t* deltas) {
+    if (gPbDelta.interval == 0 || gPbDelta.forceKey || !gPbDelta.havePrev ||
+        gPbDelta.sinceKey + 1u >= gPbDelta.interval ||
+        validMask != gPbDelta.validMask || channelCount != gPbDelta.channelCount) {
+        return false;
     }
-    if (!encode_streaming_fields(&stream, timestamp,
-            ainData, ainCount, dioData, dioSize, dioDir, dioDirSize)) {
-        LOG_E_SESSION(LOG_SESSION_NANOPB_FAIL, "NanoPB: streaming encode failed");
-        return 0;
+    size_t rawBytes = 0, deltaBytes = PB_TAG2_SIZE - PB_TAG1_SIZE;
+    for (size_t i = 0; i < count; i++) {
+        deltas[i] = (int32_t)((uint32_t)values[i] - (uint32_t)gPbDelta.prev[i]);
+        rawBytes += pbw_varint_size(pbw_zigzag32(values[i]));
+        deltaBytes += pbw_varint_size(pbw_zigzag32(deltas[i]));
     }
+    return deltaBytes < rawBytes;
+}
 
-    return stream.bytes_written;
+/* Record a message that made it into the output buffer. */
+static void pb_delta_commit(uint16_t validMask, uint16_t channelCount,
+                            const int32_t* values, size_t count, bool wasDelta) {
+    memcpy(gPbDelta.prev, values, count * sizeof(values[0]));
+    gPbDelta.validMask = validMask;
+    gPbDelta.channelCount = channelCount;
+    gPbDelta.havePrev = true;
+    gPbDelta.forceKey = false;
+    gPbDelta.sinceKey = wasDelta ? gPbDelta.sinceKey + 1u : 0u;
 }
 
 /**
@@ -1421,6 +1548,8 @@ static size_t encode_streaming_msg_delimited(
  *   3. Encode as a length-delimited DaqifiOutMessage (fast wire-format path)
  *   4. Append to output buffer (may contain multiple delimited messages)
  *   5. DIO data (if available) is included in the first AIN message
+ *   6. With delta coding configured, values may go out as field-73 deltas
+ *      between keyframes (see Nanopb_StreamingDeltaConfigure above)
  *
  * Called from: streaming_Task (priority 2) in the encode loop.
  * Replaces: Nanopb_Encode() for the streaming hot path only.
@@ -1451,37 +1580,8 @@ size_t Nanopb_EncodeStreamingFast(tBoardData* state,
         }
     }
 
-    /* Prepare DIO data upfront */
-    const tBoardConfig* pBoardConfig = BoardConfig_Get(BOARDCONFIG_ALL_CONFIG, 0);
-    DIORuntimeArray* pRuntimeDIOChannels = BoardRunTimeConfig_Get(BOARDRUNTIMECONFIG_DIO_CHANNELS);
-
-    uint8_t dioValues[2] = {0};
-    size_t dioSize = 0;
-    uint8_t dioDir[2] = {0};
-    size_t dioDirSize = 0;
-    uint32_t dioTimestamp = state->StreamTrigStamp;  /* #614: fallback if no DIO sample */
-
-    if (hasDIO) {
-        DIOSample DIOdata;
-        if (DIOSampleList_PopFront(&state->DIOSamples, &DIOdata)) {
-            memcpy(dioValues, &DIOdata.Values, sizeof(dioValues));
-            dioSize = sizeof(dioValues);
-            /* #614 (Qodo): stamp the standalone DIO frame with the tick that
-             * captured this sample, not the live StreamTrigStamp, which drifts
-             * ahead under encoder lag. */
-            dioTimestamp = DIOdata.Timestamp;
-        }
-
-        /* Build port direction bitmap (1=input per channel) */
-        uint32_t dirData = 0;
-        for (uint32_t x = 0; x < pBoardConfig->DIOChannels.Size && x < 32; x++) {
-            dirData |= ((uint32_t)pRuntimeDIOChannels->Data[x].IsInput << x);
-        }
-        for (size_t y = 0; y < sizeof(dioDir); y++) {
-            dioDir[y] = (uint8_t)(dirData >> (y * 8));
-        }
-        dioDirSize = sizeof(dioDir);
-    }
+    StreamingDioFields dio;
+    prepare_streaming_dio(state, hasDIO, &dio);
 
     uint32_t bufferOffset = 0;
 
@@ -1513,6 +1613,7 @@ size_t Nanopb_EncodeStreamingFast(tBoardData* state,
             int32_t values[MAX_AIN_PUBLIC_CHANNELS];
             size_t count = 0;
             uint32_t timestamp = pPublicSampleList->Timestamp;
+            uint16_t validMask = pPublicSampleList->validMask;
             uint16_t chCount = pPublicSampleList->channelCount;
             if (chCount > MAX_AIN_PUBLIC_CHANNELS) {
                 chCount = MAX_AIN_PUBLIC_CHANNELS;
@@ -1540,23 +1641,34 @@ size_t Nanopb_EncodeStreamingFast(tBoardData* state,
 
             if (count > 0) {
                 /* Include DIO in the first AIN message only */
-                const uint8_t* dioV = (!dioIncluded && dioSize > 0) ? dioValues : NULL;
-                size_t dioS = (!dioIncluded && dioSize > 0) ? dioSize : 0;
-                const uint8_t* dioD = (!dioIncluded && dioDirSize > 0) ? dioDir : NULL;
-                size_t dioDS = (!dioIncluded && dioDirSize > 0) ? dioDirSize : 0;
+                const uint8_t* dioV = (!dioIncluded && dio.size > 0) ? dio.values : NULL;
+                size_t dioS = (!dioIncluded && dio.size > 0) ? dio.size : 0;
+                const uint8_t* dioD = (!dioIncluded && dio.dirSize > 0) ? dio.dir : NULL;
+                size_t dioDS = (!dioIncluded && dio.dirSize > 0) ? dio.dirSize : 0;
                 if (dioS > 0) dioIncluded = true;
 
+                int32_t deltas[MAX_AIN_PUBLIC_CHANNELS];
+                bool isDelta = pb_delta_choose(validMask, chCount, values, count, deltas);
+
                 size_t written = encode_streaming_msg_delimited(
                     pBuffer + bufferOffset, buffSize - bufferOffset,
-                    timestamp, values, count,
+                    timestamp,
+                    isDelta ? PB_DELTA_ANALOG_IN_TAG : DaqifiOutMessage_analog_in_data_tag,
+                    isDelta ? deltas : values, count,
                     dioV, dioS, dioD, dioDS);
 
                 if (written == 0) {
                     LOG_E("[PB] Encode failed: buf=%u off=%u max=%u ch=%u",
                           (unsigned)buffSize, (unsigned)bufferOffset,
                           (unsigned)STREAMING_MSG_MAX_SIZE, (unsigned)count);
+                    /* The popped sample is gone: the next one must not be a
+                     * delta against it. */
+                    Nanopb_StreamingDeltaForceKeyframe();
                     return bufferOffset > 0 ? bufferOffset : 0;
                 }
+                if (gPbDelta.interval != 0) {
+                    pb_delta_commit(validMask, chCount, values, count, isDelta);
+                }
                 bufferOffset += written;
             }
         }
@@ -1568,11 +1680,11 @@ size_t Nanopb_EncodeStreamingFast(tBoardData* state,
      * so hasAIN was always true, the AIN branch popped the DIO sample, every
      * empty list skipped encoding at count>0, and the popped DIO sample was
      * destroyed. Zero bytes forever, no SCPI error. Gate on dioIncluded. */
-    if (!dioIncluded && dioSize > 0) {
+    if (!dioIncluded && dio.size > 0) {
         size_t written = encode_streaming_msg_delimited(
             pBuffer + bufferOffset, buffSize - bufferOffset,
-            dioTimestamp, NULL, 0,
-            dioValues, dioSize, dioDir, dioDirSize);
+            dio.timestamp, DaqifiOutMessage_analog_in_data_tag, NULL, 0,
+            dio.values, dio.size, dio.dir, dio.dirSize);
 
         if (written > 0) {
             bufferOffset += written;
@@ -1581,3 +1693,242 @@ size_t Nanopb_EncodeStreamingFast(tBoardData* state,
 
     return bufferOffset;
 }
+
+/* =========================================================================
+ * PB block streaming encoder (Streaming_ProtoBufferBlock)
+ * =========================================================================
+ *
+ * One length-delimited DaqifiOutMessage carries N consecutive ticks instead
+ * of one. At 1 channel the per-sample path spends ~9 of its ~12 wire bytes
+ * on framing (length prefix, timestamp tag + varint, packed tag + length);
+ * a block pays that once per N samples:
+ *
+ *   [varint: inner_message_length]
+ *   [0x08] [varint: base timestamp]      <- field 1, tick 0 of the block
+ *   [0x2A] [len] [bytes]                 <- field 5 (optional, first tick)
+ *   [0x60] [varint: period ticks]        <- field 12, omitted when N == 1
+ *   [0x68] [varint: N]                   <- field 13, always present
+ *   [0x72] [varint: len] [sint32 ...]    <- field 14, N values per channel,
+ *                                           channel-major
+ *   [0x78] [varint: delta rows]          <- field 15, omitted when 0
+ *   [0xAA 0x02] [len] [bytes]            <- field 37 (optional)
+ *
+ * Tick k of the block is stamped base + k*period (the #717 deterministic
+ * timestamps make that exact); the encoder closes a block at the first
+ * sample whose stamp breaks the progression, i.e. after a dropped tick, so a
+ * gap never hides inside one. Row r of field 14 holds the r-th valid channel
+ * of the block's (shared) validMask; bit r of field 15 marks the row as
+ * delta coded -- first value absolute, each later value the wrapping int32
+ * difference from the one before. The encoder picks raw or delta per row,
+ * whichever is fewer bytes. The presence of field 13 is what tells a decoder
+ * it has a block rather than a per-sample message; tests/host/pb_block_decode.c
+ * is the reference decoder.
+ *
+ * Fields 12-15 are FT_IGNORE in DaqifiOutMessage.options: they exist in the
+ * .proto for clients, but nanopb never sees them -- only this writer does.
+ * ========================================================================= */
+
+#define PB_BLOCK_HEADER_MAX (                                                 \
+    2U +                                         /* length prefix */          \
+    PB_TAG1_SIZE + PB_VARINT32_MAX +             /* field 1: base ts */       \
+    PB_TAG1_SIZE + 1 + PB_DIO_DATA_MAX +         /* field 5: digital_data */  \
+    PB_TAG1_SIZE + PB_VARINT32_MAX +             /* field 12: period */       \
+    PB_TAG1_SIZE + PB_VARINT32_MAX +             /* field 13: count */        \
+    PB_TAG1_SIZE + 2U +                          /* field 14: packed length */\
+    PB_TAG1_SIZE + PB_VARINT32_MAX +             /* field 15: delta rows */   \
+    PB_TAG2_SIZE + 1 + PB_DIO_DIR_MAX            /* field 37: port_dir */     \
+)
+
+/* Both variable lengths (message, packed field 14) stay under 2^14, so each
+ * is at most a two-byte varint -- PB_BLOCK_HEADER_MAX budgets exactly that. */
+_Static_assert(STREAMING_PB_BLOCK_MAX_BYTES < 16384u,
+               "PB block lengths must fit a two-byte varint");
+_Static_assert(STREAMING_PB_BLOCK_MAX_BYTES >= PB_BLOCK_HEADER_MAX +
+                   MAX_AIN_PUBLIC_CHANNELS * PB_VARINT32_MAX,
+               "a PB block must hold at least one full-width sample");
+
+size_t Nanopb_StreamingBlockMaxSamples(size_t channelCount, size_t buffSize) {
+    size_t room = min(buffSize, (size_t)STREAMING_PB_BLOCK_MAX_BYTES);
+    if (channelCount == 0) {
+        return STREAMING_PB_BLOCK_MAX_SAMPLES;
+    }
+    if (room < PB_BLOCK_HEADER_MAX) {
+        return 0;
+    }
+    size_t n = (room - PB_BLOCK_HEADER_MAX) / (channelCount * PB_VARINT32_MAX);
+    return min(n, (size_t)STREAMING_PB_BLOCK_MAX_SAMPLES);
+}
+
+/**
+ * @brief Block protobuf encoder for streaming data (Streaming_ProtoBufferBlock).
+ *
+ * Pops the longest run of queued sample sets that share a channel layout and
+ * a constant timestamp step, bounded by STREAMING_PB_BLOCK_MAX_SAMPLES and by
+ * min(@p buffSize, STREAMING_PB_BLOCK_MAX_BYTES) at worst-case value width,
+ * and writes it as ONE block message (layout above). DIO rides in the block
+ * message like it rides the first per-sample message; with no block to carry
+ * it, it goes out as a standalone per-sample DIO message.
+ *
+ * The run's pool slots are held while the rows are written (channel-major
+ * needs every tick at once) and released in pop order afterwards.
+ *
+ * @return Bytes written (one delimited message), or 0 if nothing was encoded
+ */
+size_t Nanopb_EncodeStreamingBlock(tBoardData* state,
+        const NanopbFlagsArray* fields,
+        uint8_t* pBuffer, size_t buffSize) {
+
+    if (pBuffer == NULL || buffSize == 0) {
+        LOG_E("NanoPB: NULL buffer or zero size");
+        return 0;
+    }
+
+    bool hasAIN = false, hasDIO = false;
+    for (size_t i = 0; i < fields->Size; i++) {
+        switch (fields->Data[i]) {
+            case DaqifiOutMessage_analog_in_data_tag: hasAIN = true; break;
+            case DaqifiOutMessage_digital_data_tag:   hasDIO = true; break;
+        }
+    }
+
+    AInPublicSampleList_t* held[STREAMING_PB_BLOCK_MAX_SAMPLES];
+    size_t n = 0;
+    uint8_t rowChannel[MAX_AIN_PUBLIC_CHANNELS];
+    size_t rows = 0;
+    uint32_t period = 0;
+
+    if (hasAIN) {
+        AInPublicSampleList_t* pSample;
+
+        /* Leading sample sets with no valid channel carry nothing (the DIO-only
+         * tick fallback enqueues one every tick, #593): release them here,
+         * exactly as the per-sample path does. */
+        while (AInSampleList_PeekFront(&pSample) && pSample != NULL) {
+            uint16_t chCount = min(pSample->channelCount, (uint16_t)MAX_AIN_PUBLIC_CHANNELS);
+            rows = 0;
+            for (uint16_t j = 0; j < chCount; j++) {
+                if (pSample->validMask & (1U << j)) {
+                    rowChannel[rows++] = (uint8_t)j;
+                }
+            }
+            if (rows > 0) {
+                break;
+            }
+            AInSampleList_PopFront(&pSample);
+            AInSampleList_FreeToPool(pSample);
+        }
+
+        size_t maxN = (rows > 0) ? Nanopb_StreamingBlockMaxSamples(rows, buffSize) : 0;
+        while (n < maxN && AInSampleList_PeekFront(&pSample) && pSample != NULL) {
+            if (n > 0) {
+                if (pSample->channelCount != held[0]->channelCount ||
+                    pSample->validMask != held[0]->validMask) {
+                    break;   /* layout change: the next block starts here */
+                }
+                uint32_t step = pSample->Timestamp - held[n - 1]->Timestamp;
+                if (n == 1) {
+                    if (step == 0) break;
+                    period = step;
+                } else if (step != period) {
+                    break;   /* dropped tick (or clock step): close the block */
+                }
+            }
+            if (!AInSampleList_PopFront(&pSample) || pSample == NULL) break;
+            held[n++] = pSample;
+        }
+    }
+
+    StreamingDioFields dio;
+    prepare_streaming_dio(state, hasDIO, &dio);
+
+    if (n == 0) {
+        /* Same standalone-DIO rule as the per-sample path (#593). */
+        if (dio.size > 0) {
+            return encode_streaming_msg_delimited(pBuffer, buffSize,
+                dio.timestamp, DaqifiOutMessage_analog_in_data_tag, NULL, 0,
+                dio.values, dio.size, dio.dir, dio.dirSize);
+        }
+        return 0;
+    }
+
+    /* Size every row both ways and keep the shorter. */
+    uint32_t deltaRows = 0;
+    size_t packedLen = 0;
+    for (size_t r = 0; r < rows; r++) {
+        uint8_t j = rowChannel[r];
+        size_t rawBytes = 0, deltaBytes = 0;
+        uint32_t prev = 0;
+        for (size_t k = 0; k < n; k++) {
+            uint32_t v = held[k]->Values[j];
+            rawBytes += pbw_varint_size(pbw_zigzag32((int32_t)v));
+            deltaBytes += pbw_varint_size(pbw_zigzag32((int32_t)(v - prev)));
+            prev = v;
+        }
+        if (deltaBytes < rawBytes) {
+            deltaRows |= (1u << r);
+            packedLen += deltaBytes;
+        } else {
+            packedLen += rawBytes;
+        }
+    }
+
+    uint32_t timestamp = held[0]->Timestamp;
+    size_t inner = 0;
+    if (timestamp != 0) inner += PB_TAG1_SIZE + pbw_varint_size(timestamp);
+    if (dio.size > 0)   inner += PB_TAG1_SIZE + 1 + dio.size;
+    if (n > 1)          inner += PB_TAG1_SIZE + pbw_varint_size(period);
+    inner += PB_TAG1_SIZE + pbw_varint_size((uint32_t)n);
+    inner += PB_TAG1_SIZE + pbw_varint_size((uint32_t)packedLen) + packedLen;
+    if (deltaRows != 0) inner += PB_TAG1_SIZE + pbw_varint_size(deltaRows);
+    if (dio.dirSize > 0) inner += PB_TAG2_SIZE + 1 + dio.dirSize;
+    size_t total = pbw_varint_size((uint32_t)inner) + inner;
+
+    size_t written = 0;
+    if (total <= buffSize) {
+        uint8_t* p = pbw_put_varint(pBuffer, (uint32_t)inner);
+        if (timestamp != 0) {
+            p = pbw_put_varint(p, PB_WIRE_TAG(DaqifiOutMessage_msg_time_stamp_tag, PB_WT_VARINT));
+            p = pbw_put_varint(p, timestamp);
+        }
+        if (dio.size > 0) {
+            p = pbw_put_bytes_field(p, PB_WIRE_TAG(DaqifiOutMessage_digital_data_tag, PB_WT_STRING),
+                                    dio.values, dio.size);
+        }
+        if (n > 1) {
+            p = pbw_put_varint(p, PB_WIRE_TAG(PB_BLOCK_PERIOD_TICKS_TAG, PB_WT_VARINT));
+            p = pbw_put_varint(p, period);
+        }
+        p = pbw_put_varint(p, PB_WIRE_TAG(PB_BLOCK_SAMPLE_COUNT_TAG, PB_WT_VARINT));
+        p = pbw_put_varint(p, (uint32_t)n);
+        p = pbw_put_varint(p, PB_WIRE_TAG(PB_BLOCK_ANALOG_IN_TAG, PB_WT_STRING));
+        p = pbw_put_varint(p, (uint32_t)packedLen);
+        for (size_t r = 0; r < rows; r++) {
+            uint8_t j = rowChannel[r];
+            bool delta = (deltaRows & (1u << r)) != 0;
+            uint32_t prev = 0;
+            for (size_t k = 0; k < n; k++) {
+                uint32_t v = held[k]->Values[j];
+                p = pbw_put_varint(p, pbw_zigzag32((int32_t)(delta ? v - prev : v)));
+                prev = v;
+            }
+        }
+        if (deltaRows != 0) {
+            p = pbw_put_varint(p, PB_WIRE_TAG(PB_BLOCK_DELTA_ROWS_TAG, PB_WT_VARINT));
+            p = pbw_put_varint(p, deltaRows);
+        }
+        if (dio.dirSize > 0) {
+            p = pbw_put_bytes_field(p, PB_WIRE_TAG(DaqifiOutMessage_digital_port_dir_tag, PB_WT_STRING),
+                                    dio.dir, dio.dirSize);
+        }
+        written = (size_t)(p - pBuffer);
+    } else {
+        /* Unreachable while the run is bounded by Nanopb_StreamingBlockMaxSamples;
+         * if it ever trips, the run is lost like any encoder failure. */
+        LOG_E_SESSION(LOG_SESSION_NANOPB_FAIL, "NanoPB: block over buffer");
+    }
+
+    for (size_t k = 0; k < n; k++) {
+        AInSampleList_FreeToPool(held[k]);
+    }
+    return written;
+}
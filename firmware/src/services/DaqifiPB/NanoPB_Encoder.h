@@ -35,6 +35,51 @@ size_t Nanopb_EncodeStreamingFast(tBoardData* state,
                         const NanopbFlagsArray* fields,
                         uint8_t* pBuffer, size_t buffSize);
 
+/* Delta coding of the per-sample path: packed sint32 differences from the
+ * previous AIN message, in place of analog_in_data. FT_IGNORE for nanopb. */
+#define PB_DELTA_ANALOG_IN_TAG         73
+
+/**
+ * Arm (keyframeInterval > 0) or disable (0) delta coding in
+ * Nanopb_EncodeStreamingFast for the next session. Always resets the delta
+ * chain, so the first AIN message after a call is a keyframe.
+ */
+void Nanopb_StreamingDeltaConfigure(uint32_t keyframeInterval);
+
+/** Make the next AIN message from Nanopb_EncodeStreamingFast a keyframe. */
+void Nanopb_StreamingDeltaForceKeyframe(void);
+
+/* PB block encoding (Streaming_ProtoBufferBlock). Field numbers of the block
+ * fields in DaqifiOutMessage.proto; they are FT_IGNORE for nanopb, so the
+ * generated header has no DaqifiOutMessage_*_tag for them. */
+#define PB_BLOCK_PERIOD_TICKS_TAG      12  /* uint32: timestamp step per tick */
+#define PB_BLOCK_SAMPLE_COUNT_TAG      13  /* uint32: ticks in this message */
+#define PB_BLOCK_ANALOG_IN_TAG         14  /* packed sint32, channel-major */
+#define PB_BLOCK_DELTA_ROWS_TAG        15  /* uint32: bit r = row r delta coded */
+
+/* Upper bounds on one block message: ticks, and bytes including the length
+ * prefix. The byte bound keeps a block within the streaming task's
+ * worst-case single-message room (STREAMING_BATCH_MIN_ROOM). */
+#define STREAMING_PB_BLOCK_MAX_SAMPLES 128u
+#define STREAMING_PB_BLOCK_MAX_BYTES   1024u
+
+/**
+ * Block streaming encoder: packs consecutive queued sample sets that share a
+ * channel layout and timestamp step into ONE length-delimited message
+ * (base timestamp + period + channel-major packed values, optionally delta
+ * coded per channel). See the format notes in NanoPB_Encoder.c and the
+ * reference decoder in tests/host/pb_block_decode.c.
+ */
+size_t Nanopb_EncodeStreamingBlock(tBoardData* state,
+                        const NanopbFlagsArray* fields,
+                        uint8_t* pBuffer, size_t buffSize);
+
+/**
+ * Most ticks one block message can carry for @p channelCount valid channels
+ * in @p buffSize bytes, at worst-case value width. 0 if even one won't fit.
+ */
+size_t Nanopb_StreamingBlockMaxSamples(size_t channelCount, size_t buffSize);
+
 void int2PBByteArray(   const size_t integer,
                         pb_bytes_array_t* byteArray,                        
                         size_t maxArrayLen);
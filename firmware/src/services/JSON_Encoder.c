@@ -11,6 +11,7 @@
 #include "state/runtime/BoardRuntimeConfig.h"
 #include "Util/StringFormatters.h"
 #include "Util/Logger.h"
+#include "Util/FixedPointCal.h"   /* integer calibrated conversion */
 #include "encoder.h"
 #include "JSON_Encoder.h"
 #include "../HAL/ADC.h"
@@ -34,6 +35,65 @@ static char tmp[ TMP_MAX_LEN ];
 // Track whether JSON header has been sent (reset when streaming stops)
 static bool jsonHeaderSent = false;
 
+// Widest "val" a fixed-point value renders to: sign, 10 integer digits,
+// point, FIXEDFMT_MAX_PRECISION decimals, NUL.
+#define JSON_FIXED_VALUE_MAX (13u + FIXEDFMT_MAX_PRECISION)
+
+// Session conversion table: the same per-channel coefficients csv_encoder.c
+// builds for its row writers, keyed by the precision and mapping they were
+// built for. Chosen by json_SelectFixedPoint at START.
+static struct {
+    bool           enabled;     // false: double path for every value
+    bool           valid;
+    uint8_t        precision;   // key the table was built from
+    uint8_t        channelCount;
+    const uint8_t* configIdx;
+    FixedCalChannel      cal[MAX_AIN_PUBLIC_CHANNELS];
+    ADC_LinearConversion calSrc[MAX_AIN_PUBLIC_CHANNELS];  // cal built from
+} gJsonCal;
+
+void json_SelectFixedPoint(bool fixedPoint) {
+    gJsonCal.enabled = fixedPoint;
+    gJsonCal.valid = false;
+}
+
+// (Re)builds the entries whose conversion changed. Calibration and range are
+// not locked while streaming, so Json_Encode calls this once per call; the
+// whole table is rebuilt when the precision or the channel mapping changed.
+static void json_RefreshCalTable(const AInChannelMapping* mapping,
+                                 uint8_t precision) {
+    bool force = !gJsonCal.valid || gJsonCal.precision != precision ||
+                 gJsonCal.channelCount != mapping->count ||
+                 gJsonCal.configIdx != mapping->configIndices;
+    gJsonCal.valid = true;
+    gJsonCal.precision = precision;
+    gJsonCal.channelCount = mapping->count;
+    gJsonCal.configIdx = mapping->configIndices;
+    // Precision 0 is the integer millivolt field: three decimals of volts.
+    unsigned calPrecision = (precision == 0u) ? 3u : precision;
+
+    for (uint8_t j = 0; j < mapping->count; j++) {
+        ADC_LinearConversion lin;
+        memset(&lin, 0, sizeof(lin));   // padding too: compared with memcmp
+        if (!ADC_GetLinearConversionByIndex(mapping->configIndices[j], &lin)) {
+            memset(&lin, 0, sizeof(lin));   // CodeMax 0: prepare declines
+        }
+        if (!force && memcmp(&lin, &gJsonCal.calSrc[j], sizeof(lin)) == 0) {
+            continue;
+        }
+        gJsonCal.calSrc[j] = lin;
+        fixedcal_prepare(&gJsonCal.cal[j], lin.Gain, lin.Offset, lin.CodeMax,
+                         lin.SignBits,
+                         ADC_ConvertToVoltageByIndex(mapping->configIndices[j], 0u),
+                         calPrecision);
+        // The millivolt field is an int32; leave anything wider to the
+        // double path's clamp.
+        if (precision == 0u && gJsonCal.cal[j].scaledMax > INT32_MAX) {
+            gJsonCal.cal[j].valid = false;
+        }
+    }
+}
+
 /**
  * @brief Reset JSON encoder state (call when streaming stops)
  */
@@ -433,6 +493,10 @@ size_t Json_Encode(tBoardData* state,
                 BOARDRUNTIME_STREAMING_CONFIGURATION);
         uint8_t precision = (pStreamCfg != NULL) ? pStreamCfg->VoltagePrecision : 4;
         bool rawMode = (pStreamCfg != NULL) ? pStreamCfg->RawOutputMode : false;   /* #158/#270 */
+        bool useCal = gJsonCal.enabled && !rawMode;
+        if (useCal) {
+            json_RefreshCalTable(mapping, precision);
+        }
         while (((buffSize - startIndex) >= 65) && (qSize > 0)) {
             if (!AInSampleList_PopFront(&pPublicSampleList)) {
                 break;
@@ -483,31 +547,56 @@ size_t Json_Encode(tBoardData* state,
                             "{\"ch\":%u, \"val\":%d},\n",
                             channelId,
                             (int32_t)rawValue);
-                } else
-                // Convert raw ADC value to voltage by board config index
-                // directly (#268/#269). Skips O(N) channel-ID search.
-                if (precision == 0) {
-                    // Integer millivolts (backwards compatible)
-                    double voltage_mv = ADC_ConvertToVoltageByIndex(
-                        mapConfigIdx[j], rawValue) * 1000.0;
-                    int32_t mv;
-                    if (voltage_mv > (double)INT32_MAX) mv = INT32_MAX;
-                    else if (voltage_mv < (double)INT32_MIN) mv = INT32_MIN;
-                    else mv = (int32_t)(voltage_mv >= 0.0 ? voltage_mv + 0.5 : voltage_mv - 0.5);
-                    written = snprintf(charBuffer + startIndex,
-                            buffSize - startIndex,
-                            "{\"ch\":%u, \"val\":%d},\n",
-                            channelId,
-                            (int)mv);
                 } else {
-                    // Volts with N decimal places
-                    double voltage = ADC_ConvertToVoltageByIndex(
-                        mapConfigIdx[j], rawValue);
-                    written = snprintf(charBuffer + startIndex,
-                            buffSize - startIndex,
-                            "{\"ch\":%u, \"val\":%.*f},\n",
-                            channelId,
-                            (int)precision, voltage);
+                    // Integer conversion first (FixedPointCal.h); the double
+                    // path below only for a value it cannot decide.
+                    uint64_t scaled = 0;
+                    bool neg = false;
+                    bool exact = useCal && gJsonCal.cal[j].valid &&
+                            fixedcal_scaled(&gJsonCal.cal[j], rawValue, &scaled, &neg);
+                    char valStr[JSON_FIXED_VALUE_MAX];
+                    char* valEnd = NULL;
+                    if (exact && precision != 0) {
+                        valEnd = fixedfmt_scaled_to_str(scaled, neg, precision,
+                                                        valStr, sizeof(valStr) - 1u);
+                    }
+                    // Convert raw ADC value to voltage by board config index
+                    // directly (#268/#269). Skips O(N) channel-ID search.
+                    if (precision == 0) {
+                        // Integer millivolts (backwards compatible)
+                        int32_t mv;
+                        if (exact) {
+                            mv = neg ? -(int32_t)scaled : (int32_t)scaled;
+                        } else {
+                            double voltage_mv = ADC_ConvertToVoltageByIndex(
+                                mapConfigIdx[j], rawValue) * 1000.0;
+                            if (voltage_mv > (double)INT32_MAX) mv = INT32_MAX;
+                            else if (voltage_mv < (double)INT32_MIN) mv = INT32_MIN;
+                            else mv = (int32_t)(voltage_mv >= 0.0 ? voltage_mv + 0.5 : voltage_mv - 0.5);
+                        }
+                        written = snprintf(charBuffer + startIndex,
+                                buffSize - startIndex,
+                                "{\"ch\":%u, \"val\":%d},\n",
+                                channelId,
+                                (int)mv);
+                    } else if (valEnd != NULL) {
+                        // Same digits "%.*f" prints for the double path.
+                        *valEnd = '\0';
+                        written = snprintf(charBuffer + startIndex,
+                                buffSize - startIndex,
+                                "{\"ch\":%u, \"val\":%s},\n",
+                                channelId,
+                                valStr);
+                    } else {
+                        // Volts with N decimal places
+                        double voltage = ADC_ConvertToVoltageByIndex(
+                            mapConfigIdx[j], rawValue);
+                        written = snprintf(charBuffer + startIndex,
+                                buffSize - startIndex,
+                                "{\"ch\":%u, \"val\":%.*f},\n",
+                                channelId,
+                                (int)precision, voltage);
+                    }
                 }
                 if (written < 0 || written >= (int)(buffSize - startIndex)) break;
                 startIndex += written;
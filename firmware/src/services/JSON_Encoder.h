@@ -39,6 +39,15 @@ bool json_IsHeaderSent(void);
  */
 size_t json_GenerateHeaderToBuffer(char* buffer, size_t size);
 
+/*!
+ * Select how voltage values are converted for the session (call at START).
+ * true: per-channel fixed-point coefficients (Util/FixedPointCal.h), with the
+ * double ADC_ConvertToVoltageByIndex path only for values they cannot decide;
+ * false: the double path for every value. Output is byte-identical.
+ * @param fixedPoint Use the integer conversion
+ */
+void json_SelectFixedPoint(bool fixedPoint);
+
 #ifdef	__cplusplus
 }
 #endif
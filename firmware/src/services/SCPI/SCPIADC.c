@@ -969,4 +969,32 @@ scpi_result_t SCPI_ADCSamcSharedGet(scpi_t *context) {
     MC12b_GetAcquisitionSamc(NULL, &samc);
     SCPI_ResultInt32(context, (int32_t)samc);
     return SCPI_RES_OK;
+}
+
+// --- Shared-scan DMA readout ---------------------------------------------
+// Latched at stream start (MC12b_StartScanDma), so like SAMC it is rejected
+// while a session is enabled or running.
+scpi_result_t SCPI_ADCScanDmaSet(scpi_t *context) {
+    int32_t val;
+    if (!SCPI_ParamInt32(context, &val, TRUE)) return SCPI_RES_ERR;
+    if (val != 0 && val != 1) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+    StreamingRuntimeConfig *pStreamCfg =
+            BoardRunTimeConfig_Get(BOARDRUNTIME_STREAMING_CONFIGURATION);
+    if (pStreamCfg->IsEnabled || pStreamCfg->Running) {
+        SCPI_ExecutionError(context, "CONF:ADC:SCAN:DMA: cannot change while streaming");
+        return SCPI_RES_ERR;
+    }
+    if (!MC12b_SetScanDma(val == 1)) {
+        SCPI_ExecutionError(context, "CONF:ADC:SCAN:DMA: not in this build (MC12B_SCAN_DMA_VECTOR)");
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
+scpi_result_t SCPI_ADCScanDmaGet(scpi_t *context) {
+    SCPI_ResultInt32(context, MC12b_GetScanDma() ? 1 : 0);
+    return SCPI_RES_OK;
 }
\ No newline at end of file
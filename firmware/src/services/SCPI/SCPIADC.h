@@ -186,6 +186,20 @@ extern "C" {
     scpi_result_t SCPI_ADCSamcSharedSet(scpi_t * context);
     scpi_result_t SCPI_ADCSamcSharedGet(scpi_t * context);
 
+    /**
+     * Shared-scan (MODULE7) readout by DMA.
+     *   CONFigure:ADC:SCAN:DMA <0|1>  — 1 = a DMAC channel copies each
+     *       completed scan into RAM and interrupts once per scan; the
+     *       per-input data-ready ISRs of the scanned channels stay off for
+     *       the session. 0 (default) = per-input ISRs.
+     *   CONFigure:ADC:SCAN:DMA?       — current setting
+     * Takes effect at the next stream start; rejected while streaming.
+     * Enabling it is refused in a build without MC12B_SCAN_DMA_VECTOR
+     * (MC12bADC.h: the DMA4 vector wrapper it needs is not tracked).
+     */
+    scpi_result_t SCPI_ADCScanDmaSet(scpi_t * context);
+    scpi_result_t SCPI_ADCScanDmaGet(scpi_t * context);
+
     /**
      * #670 — hardware analog threshold alarms via the ADCHS digital comparators.
      *   CONFigure:ADC:THREshold <ch>,<mode 0-4>,<lo>,<hi>  — mode 0=off,
@@ -55,8 +55,11 @@
 #include "../UsbCdc/UsbCdc.h"
 #include "config/default/driver/usb/usbhs/src/plib_usbhs_header.h"
 #include "Util/CoherentPool.h"
+#include "Util/Decimator.h"
+#include "Util/CaptureRing.h"
 #include "state/data/AInSample.h"  // For AInSampleList_PoolCapacity
 #include "services/wifi_services/wifi_tcp_server.h"  // For WIFI_CIRCULAR_BUFF_SIZE
+#include "services/wifi_services/wifi_udp_stream.h"  // SYST:STR:INT 4 transport
 #include "services/wifi_services/iperf2/iperf2.h"   // #377 iperf2 control
 #include "config/default/driver/winc/include/dev/wdrv_winc_spi.h"  // For WDRV_WINC_SPI_SetBuffer/WaitIdle
 #include "config/default/WincIdleGate.h"  // For SYST:WINC:GATE? debug accessor
@@ -2256,7 +2259,8 @@ static scpi_result_t SCPI_RunThroughputBench(scpi_t * context) {
     scpi_printf(context, "QueueDropped=%u\r\n", (unsigned)s.queueDroppedSamples);
     // #499: split sub-counters — QueueDropped is their sum (kept for back-compat).
     //   PoolExhausted = sample pool depth too shallow for the rate.
-    //   QueueOverflow = streaming_Task drain too slow (queue full while pool has slots).
+    //   QueueOverflow = publish rejected (the pool and queue are one slot ring,
+    //                   so a slow streaming_Task shows up as PoolExhausted).
     scpi_printf(context, "PoolExhausted=%u\r\n", (unsigned)s.poolExhaustedSamples);
     scpi_printf(context, "QueueOverflow=%u\r\n", (unsigned)s.queueOverflowSamples);
     scpi_printf(context, "UsbDropped=%u\r\n", (unsigned)s.usbDroppedBytes);
@@ -3135,7 +3139,8 @@ scpi_result_t SCPI_GetStreamStats(scpi_t * context) {
     scpi_printf(context, "QueueDroppedSamples=%u\r\n", (unsigned)s.queueDroppedSamples);
     // #499: split sub-counters — QueueDroppedSamples is their sum (kept for back-compat).
     //   PoolExhaustedSamples = sample pool depth too shallow for the rate.
-    //   QueueOverflowSamples = streaming_Task drain too slow (queue full while pool has slots).
+    //   QueueOverflowSamples = publish rejected (pool and queue are one slot ring,
+    //                          so a slow streaming_Task shows up as PoolExhausted).
     // #483: Steady = post-grace subset of QueueDroppedSamples (no per-sub-counter Steady).
     scpi_printf(context, "QueueDroppedSamplesSteady=%u\r\n", (unsigned)s.queueDroppedSamplesSteady);
     scpi_printf(context, "PoolExhaustedSamples=%u\r\n", (unsigned)s.poolExhaustedSamples);
@@ -3230,6 +3235,13 @@ scpi_result_t SCPI_GetStreamStats(scpi_t * context) {
         scpi_printf(context, "SdWriteErrors=%u\r\n", (unsigned)sdm.writeErrors);
         scpi_printf(context, "SdWriteMaxLatencyMs=%u\r\n", (unsigned)sdm.writeMaxLatencyMs);
         scpi_printf(context, "SdWriteAlignedCopies=%u\r\n", (unsigned)sdm.writeAlignedCopies);
+        scpi_printf(context, "SdSlotWrites=%u\r\n", (unsigned)sdm.slotWrites);
+        scpi_printf(context, "SdSlotOverlapStages=%u\r\n", (unsigned)sdm.slotOverlapStages);
+        scpi_printf(context, "SdSlotBarrierWaits=%u\r\n", (unsigned)sdm.slotBarrierWaits);
+        scpi_printf(context, "SdPreallocFiles=%u\r\n", (unsigned)sdm.preallocFiles);
+        scpi_printf(context, "SdPreallocFallbacks=%u\r\n", (unsigned)sdm.preallocFallbacks);
+        scpi_printf(context, "SdRotationsPrecreated=%u\r\n", (unsigned)sdm.rotationsPrecreated);
+        scpi_printf(context, "SdRotationsInline=%u\r\n", (unsigned)sdm.rotationsInline);
     }
     scpi_printf(context, "EncoderFailures=%u\r\n", (unsigned)s.encoderFailures);
     scpi_printf(context, "EncoderFailuresSteady=%u\r\n", (unsigned)s.encoderFailuresSteady);
@@ -3268,11 +3280,17 @@ scpi_result_t SCPI_GetStreamStats(scpi_t * context) {
     scpi_printf(context, "TimerISRCalls=%llu\r\n", (unsigned long long)s.timerISRCalls);
     // #367 diag: bytes sitting in WiFi circular buffer at session end (Stop)
     scpi_printf(context, "CircularBufferEndBytes=%u\r\n", (unsigned)s.circularBufferEndBytes);
+    // SYST:STR:ADAPTive: ticks decimated on purpose (NOT loss -- add them to
+    // the #265 invariant above), the live divisor and the controller's steps.
+    scpi_printf(context, "DecimatedTicks=%llu\r\n", (unsigned long long)s.decimatedTicks);
+    scpi_printf(context, "RateDivisor=%u\r\n", (unsigned)s.rateDivisor);
+    scpi_printf(context, "RateDecreases=%u\r\n", (unsigned)s.rateDecreases);
+    scpi_printf(context, "RateIncreases=%u\r\n", (unsigned)s.rateIncreases);
     // #499 diag: sample-pool peak utilization this session.  Compare with
     // SamplePoolCount (MEM:FREE?) — if Used == Count, the pool was saturated
-    // and PoolExhaustedSamples > 0 makes sense.  If Used << Count but
-    // QueueOverflowSamples > 0, the queue is the bottleneck (streaming_Task
-    // drain too slow), not the pool.
+    // and PoolExhaustedSamples > 0 makes sense -- either the pool is too
+    // shallow for the burst or streaming_Task is draining too slowly (the
+    // pool and the queue are one slot ring, so both look the same here).
     scpi_printf(context, "SamplePoolMaxUsed=%u\r\n",
                 (unsigned)AInSampleList_PoolMaxUsed());
 #if PB_PROFILE_COUNTERS
@@ -3483,7 +3501,7 @@ static scpi_result_t SCPI_StartStreaming(scpi_t * context) {
     // in this function may pick WiFi anyway — false negatives here are
     // acceptable since the floor is purely defensive.
     StreamingInterface currentInterfaceAtCheck = pRunTimeStreamConfig->ActiveInterface;
-    if (currentInterfaceAtCheck == StreamingInterface_WiFi) {
+    if (StreamingInterface_IsWiFi(currentInterfaceAtCheck)) {
         size_t heapFreeAtStart = xPortGetFreeHeapSize();
         if (heapFreeAtStart < MIN_HEAP_FREE_FOR_STREAM_START_BYTES) {
             LOG_E("WiFi streaming start rejected: free heap %u < floor %u (#475 - bounce LAN:APPLY or reboot)",
@@ -3508,6 +3526,15 @@ static scpi_result_t SCPI_StartStreaming(scpi_t * context) {
         }
     }
 
+    // UDP streams to an address the host named; there is no connection to
+    // fall back on.
+    if (pRunTimeStreamConfig->ActiveInterface == StreamingInterface_WiFiUdp &&
+        !wifi_udp_stream_HasDestination()) {
+        SCPI_ExecutionError(context,
+            "STR:START: UDP interface needs SYST:COMM:LAN:UDPStream:DESTination");
+        return SCPI_RES_ERR;
+    }
+
     // #524 (Qodo): a no-argument START reuses the stored frequency — resolve it
     // here so the muxed + transport-cap validation below covers BOTH the
     // explicit-freq and no-arg restart paths. The no-arg path previously skipped
@@ -3608,11 +3635,11 @@ static scpi_result_t SCPI_StartStreaming(scpi_t * context) {
      * card is enabled and a filename is set. */
     sd_card_manager_settings_t* pSDCardSettings =
         BoardRunTimeConfig_Get(BOARDRUNTIME_SD_CARD_SETTINGS);
-    bool sdLoggingRequested = (pRunTimeStreamConfig->ActiveInterface != StreamingInterface_WiFi) &&
+    bool sdLoggingRequested = !StreamingInterface_IsWiFi(pRunTimeStreamConfig->ActiveInterface) &&
                               pSDCardSettings != NULL && pSDCardSettings->enable &&
                               pSDCardSettings->file[0] != '\0';
 
-    if (pRunTimeStreamConfig->ActiveInterface == StreamingInterface_WiFi &&
+    if (StreamingInterface_IsWiFi(pRunTimeStreamConfig->ActiveInterface) &&
         pSDCardSettings != NULL && pSDCardSettings->enable &&
         pSDCardSettings->mode == SD_CARD_MANAGER_MODE_WRITE) {
         LOG_E("Cannot start WiFi streaming while SD logging is active (SPI bus conflict)");
@@ -3817,11 +3844,36 @@ static scpi_result_t SCPI_StartStreaming(scpi_t * context) {
         const AInChannelMapping* chMapping = Streaming_GetChannelMapping();
         uint8_t enabledChannels = (chMapping->count > 0) ? chMapping->count : 1;
         MemoryConfig* mc = BoardRunTimeConfig_Get(BOARDRUNTIME_MEMORY_CONFIG);
-        if (!PrepareStreamingBuffers(mc->samplePoolCount,
+        // SYST:STR:CAPture: the sample pool only paces the readout, so it
+        // is kept at its floor and the rest of the pool holds the capture.
+        bool capture = (pRunTimeStreamConfig->CapturePost > 0u);
+        if (capture && chMapping->count == 0) {
+            SCPI_ExecutionError(context, "STR:START: capture needs an enabled analog channel");
+            return SCPI_RES_ERR;
+        }
+        if (!PrepareStreamingBuffers(capture ? MIN_AIN_SAMPLE_COUNT : mc->samplePoolCount,
                                      AInSampleList_ElementSize(enabledChannels))) {
             SCPI_ExecutionError(context, "STR:START: buffer partition failed (USB DMA / tasks not quiescent, or pool error)");
             return SCPI_RES_ERR;
         }
+        if (capture) {
+            uint8_t* capBuf;
+            uint32_t capSize;
+            StreamingBufferPool_GetCapture(&capBuf, &capSize);
+            uint32_t capMax = CaptureRing_MaxFrames(capSize, chMapping->count);
+            uint64_t want = (uint64_t)pRunTimeStreamConfig->CapturePre +
+                            pRunTimeStreamConfig->CapturePost;
+            if (want > capMax) {
+                LOG_E("Capture rejected: %u+%u frames exceed the %u that fit "
+                      "(%u ch, %u bytes free)",
+                      (unsigned)pRunTimeStreamConfig->CapturePre,
+                      (unsigned)pRunTimeStreamConfig->CapturePost,
+                      (unsigned)capMax, (unsigned)chMapping->count,
+                      (unsigned)capSize);
+                SCPI_ExecutionError(context, "STR:START: capture does not fit (see SYST:LOG?)");
+                return SCPI_RES_ERR;
+            }
+        }
 
         // Re-enable SD if it was closed for DMA quiesce
         if (sdLoggingRequested) {
@@ -4065,7 +4117,7 @@ static scpi_result_t SCPI_SetStreamFormat(scpi_t * context) {
     if (param1 < (int)Streaming_ProtoBuffer
             || param1 >= (int)Streaming_Encoding_COUNT) {
         LOG_E("Stream format %d is not a known encoding (0=PB, 1=JSON, "
-              "2=CSV, 3=CsvCompact)", param1);
+              "2=CSV, 3=CsvCompact, 4=PbBlock)", param1);
         SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
         return SCPI_RES_ERR;
     }
@@ -4085,6 +4137,213 @@ static scpi_result_t SCPI_GetStreamFormat(scpi_t * context) {
     return SCPI_RES_OK;
 }
 
+/**
+ * SYSTem:STReam:DELTa <K> — delta/zigzag compression of the per-sample
+ * ProtoBuffer path (FORmat 0). 0 = off (default); K in 1..65535 sends channel
+ * values as differences from the previous message with an absolute keyframe
+ * at least every K messages. Ignored by the other encodings. Runtime-only.
+ *
+ * Latched at START like the encoding itself, and rejected while streaming for
+ * the same #619 reason: a client that has already chosen how to decode the
+ * session must not see the wire format change under it.
+ */
+static scpi_result_t SCPI_SetStreamDelta(scpi_t * context) {
+    int32_t interval;
+    StreamingRuntimeConfig * pRunTimeStreamConfig = BoardRunTimeConfig_Get(
+            BOARDRUNTIME_STREAMING_CONFIGURATION);
+
+    if (!SCPI_ParamInt32(context, &interval, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+    if (interval < 0 || interval > UINT16_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+    if (pRunTimeStreamConfig->IsEnabled || pRunTimeStreamConfig->Running) {
+        LOG_E("Stream delta change rejected: streaming is active "
+              "(stop streaming first)");
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+    pRunTimeStreamConfig->PbDeltaKeyframeInterval = (uint16_t)interval;
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t SCPI_GetStreamDelta(scpi_t * context) {
+    StreamingRuntimeConfig * pRunTimeStreamConfig = BoardRunTimeConfig_Get(
+            BOARDRUNTIME_STREAMING_CONFIGURATION);
+
+    SCPI_ResultInt32(context, (int32_t) pRunTimeStreamConfig->PbDeltaKeyframeInterval);
+    return SCPI_RES_OK;
+}
+
+/**
+ * SYSTem:STReam:ADAPTive <0|1> — adaptive rate control. 1 lets the rate go up
+ * to 3/2 of the static WiFi transport cap and decimates it at runtime, every
+ * d-th tick, when the link cannot carry it (Util/RateControl.h); the live d
+ * and the controller's steps are in SYST:STR:STATS?. Runtime-only.
+ *
+ * Rejected while streaming: the cap it relaxes was checked at START.
+ */
+static scpi_result_t SCPI_SetStreamAdaptive(scpi_t * context) {
+    int32_t enable;
+    StreamingRuntimeConfig * pRunTimeStreamConfig = BoardRunTimeConfig_Get(
+            BOARDRUNTIME_STREAMING_CONFIGURATION);
+
+    if (!SCPI_ParamInt32(context, &enable, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+    if (enable != 0 && enable != 1) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+    if (pRunTimeStreamConfig->IsEnabled || pRunTimeStreamConfig->Running) {
+        LOG_E("Stream adaptive change rejected: streaming is active "
+              "(stop streaming first)");
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+    pRunTimeStreamConfig->AdaptiveRate = (enable == 1);
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t SCPI_GetStreamAdaptive(scpi_t * context) {
+    StreamingRuntimeConfig * pRunTimeStreamConfig = BoardRunTimeConfig_Get(
+            BOARDRUNTIME_STREAMING_CONFIGURATION);
+
+    SCPI_ResultInt32(context, pRunTimeStreamConfig->AdaptiveRate ? 1 : 0);
+    return SCPI_RES_OK;
+}
+
+/**
+ * SYSTem:STReam:DECimate <N>[,<stages>[,<bits>]] — on-device decimation
+ * (Util/Decimator.h). N = 1 (default) streams every tick; N in 2..128 streams
+ * one filtered sample per N ticks: stages 1 = boxcar average (default), 2-3 =
+ * CIC2/CIC3. bits (0..4, default 0) scales PB / raw-mode values by 2^bits to
+ * carry the extra resolution; INFO's and the SD PB header's analog_in_res
+ * grow by the same factor, and SD container blocks record it (see
+ * Streaming_CodeScaleBits). The rate set by SYST:STR:FREQ stays the ADC
+ * tick rate; the stream runs at FREQ/N. Runtime-only.
+ *
+ * Rejected while streaming: it changes the stream rate and the caps checked
+ * at START. The query returns "N,stages,bits".
+ */
+static scpi_result_t SCPI_SetStreamDecimate(scpi_t * context) {
+    int32_t factor;
+    int32_t stages = 1;
+    int32_t bits = 0;
+    StreamingRuntimeConfig * pRunTimeStreamConfig = BoardRunTimeConfig_Get(
+            BOARDRUNTIME_STREAMING_CONFIGURATION);
+
+    if (!SCPI_ParamInt32(context, &factor, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+    (void)SCPI_ParamInt32(context, &stages, FALSE);
+    (void)SCPI_ParamInt32(context, &bits, FALSE);
+    if (SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+    if (factor < 1 || stages < 1 || bits < 0 ||
+        (factor > 1 && !Decimator_IsValidConfig((uint32_t)factor,
+                                                (uint32_t)stages, (uint32_t)bits))) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+    if (pRunTimeStreamConfig->IsEnabled || pRunTimeStreamConfig->Running) {
+        LOG_E("Stream decimation change rejected: streaming is active "
+              "(stop streaming first)");
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+    pRunTimeStreamConfig->DecimateFactor = (uint16_t)factor;
+    pRunTimeStreamConfig->DecimateStages = (factor > 1) ? (uint8_t)stages : 1u;
+    pRunTimeStreamConfig->DecimateExtraBits = (factor > 1) ? (uint8_t)bits : 0u;
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t SCPI_GetStreamDecimate(scpi_t * context) {
+    StreamingRuntimeConfig * pRunTimeStreamConfig = BoardRunTimeConfig_Get(
+            BOARDRUNTIME_STREAMING_CONFIGURATION);
+
+    SCPI_ResultInt32(context, (int32_t) pRunTimeStreamConfig->DecimateFactor);
+    SCPI_ResultInt32(context, (int32_t) pRunTimeStreamConfig->DecimateStages);
+    SCPI_ResultInt32(context, (int32_t) pRunTimeStreamConfig->DecimateExtraBits);
+    return SCPI_RES_OK;
+}
+
+/**
+ * SYSTem:STReam:CAPture <pre>,<post>[,<sources>] — pre/post-trigger burst
+ * capture (Util/CaptureRing.h). With post > 0 the next STR:START records
+ * every tick into RAM instead of streaming; after a trigger it keeps post
+ * frames (the trigger frame first) and the pre frames before it, stops
+ * acquiring, and streams the capture out on the active interface. sources:
+ * 1 = ADC threshold trip (CONF:ADC:THREshold), 2 = DIO edge (DIO:EVENt),
+ * 3 = either (default); SYST:STR:CAPture:FORCe always triggers. 0,0 turns
+ * capture off. The transport rate cap does not apply to a capture session;
+ * START rejects a capture that does not fit the streaming pool.
+ *
+ * Rejected while streaming. The query returns "pre,post,sources";
+ * SYST:STR:CAPture:STATe? returns "state,framesLeft,triggerTs,ignored"
+ * (state: 0 idle, 1 filling, 2 armed, 3 triggered, 4 reading out, 5 read).
+ */
+static scpi_result_t SCPI_SetStreamCapture(scpi_t * context) {
+    int32_t pre;
+    int32_t post;
+    int32_t sources = (int32_t)CAPTURE_SRC_ALL;
+    StreamingRuntimeConfig * pRunTimeStreamConfig = BoardRunTimeConfig_Get(
+            BOARDRUNTIME_STREAMING_CONFIGURATION);
+
+    if (!SCPI_ParamInt32(context, &pre, TRUE) ||
+        !SCPI_ParamInt32(context, &post, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+    (void)SCPI_ParamInt32(context, &sources, FALSE);
+    if (SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+    if (pre < 0 || post < 0 || (post == 0 && pre != 0) ||
+        sources < 1 || sources > (int32_t)CAPTURE_SRC_ALL) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+    if (pRunTimeStreamConfig->IsEnabled || pRunTimeStreamConfig->Running) {
+        LOG_E("Stream capture change rejected: streaming is active "
+              "(stop streaming first)");
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+    pRunTimeStreamConfig->CapturePre = (uint32_t)pre;
+    pRunTimeStreamConfig->CapturePost = (uint32_t)post;
+    pRunTimeStreamConfig->CaptureSources = (uint8_t)sources;
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t SCPI_GetStreamCapture(scpi_t * context) {
+    StreamingRuntimeConfig * pRunTimeStreamConfig = BoardRunTimeConfig_Get(
+            BOARDRUNTIME_STREAMING_CONFIGURATION);
+
+    SCPI_ResultUInt32(context, pRunTimeStreamConfig->CapturePre);
+    SCPI_ResultUInt32(context, pRunTimeStreamConfig->CapturePost);
+    SCPI_ResultInt32(context, (int32_t) pRunTimeStreamConfig->CaptureSources);
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t SCPI_GetStreamCaptureState(scpi_t * context) {
+    uint32_t state, framesLeft, triggerTs, ignored;
+    Streaming_GetCaptureStatus(&state, &framesLeft, &triggerTs, &ignored);
+    SCPI_ResultUInt32(context, state);
+    SCPI_ResultUInt32(context, framesLeft);
+    SCPI_ResultUInt32(context, triggerTs);
+    SCPI_ResultUInt32(context, ignored);
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t SCPI_ForceStreamCapture(scpi_t * context) {
+    (void)context;
+    Streaming_CaptureForce();
+    return SCPI_RES_OK;
+}
+
 static scpi_result_t SCPI_SetDataPrecision(scpi_t * context) {
     int32_t param1;
     StreamingRuntimeConfig * pRunTimeStreamConfig = BoardRunTimeConfig_Get(
@@ -4210,8 +4469,8 @@ static scpi_result_t SCPI_SetStreamInterface(scpi_t * context) {
         return SCPI_RES_ERR;
     }
 
-    // Validate interface value: 0=USB, 1=WiFi, 2=SD, 3=All
-    if (param1 < 0 || param1 > 3) {
+    // Validate interface value: 0=USB, 1=WiFi, 2=SD, 3=All, 4=WiFi UDP
+    if (param1 < 0 || param1 > StreamingInterface_WiFiUdp) {
         SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
         return SCPI_RES_ERR;
     }
@@ -4242,7 +4501,7 @@ static scpi_result_t SCPI_SetStreamInterface(scpi_t * context) {
          param1 == StreamingInterface_UsbAndSd) && !pSDCardSettings->enable) {
         // Cannot stream to a card that is not enabled.
         rejectSdNotEnabled = true;
-    } else if (param1 == StreamingInterface_WiFi &&
+    } else if (StreamingInterface_IsWiFi((StreamingInterface)param1) &&
                pSDCardSettings->enable &&
                pSDCardSettings->mode == SD_CARD_MANAGER_MODE_WRITE) {
         /* WiFi+SD SPI conflict: only a risk when switching explicitly to
@@ -4638,15 +4897,12 @@ static scpi_result_t SCPI_GetMemFree(scpi_t * context) {
                 (unsigned)StreamingBufferPool_SdCircularSize());
     size_t elemSize = AInSampleList_PoolElementSize();
     scpi_printf(context, "SamplePoolCount=%u\r\n", (unsigned)samplePoolCap);
-    /* #828: the partition and the queue can disagree. StreamingBufferPool_Partition
-     * carves as many slots as the pool fits (`samplePoolCount == 0` means maximize),
-     * but AInSampleList_InitializeExternal refuses to GROW the FreeRTOS sample queue
-     * unless freeHeap >= needed + 1024 -- and on a clamp it keeps the old queue size.
-     * SamplePoolCount above is the USABLE depth; without the two fields below the
-     * shortfall was announced only in a LOG_E line, so a host saw a depth that
-     * silently disagreed with the partition. Clamped=0 on a device with heap to
-     * spare. Appended, not substituted -- MEM:FREE? is a key=value list and existing
-     * keys keep their meaning.
+    /* #828: the partition and the usable depth used to disagree when the old
+     * FreeRTOS pointer queue could not be grown to the partitioned count. The
+     * sample pool is now a single slot ring carved straight from the partition, so
+     * SamplePoolCount == SamplePoolPartitioned and ClampedSlots is 0 unless the
+     * count hit MIN/MAX_AIN_SAMPLE_COUNT. The keys stay -- MEM:FREE? is a
+     * key=value list and existing keys keep their meaning.
      *
      * Partitioned == 0 is a FAULT, not a pre-stream state. The pool is partitioned at
      * boot -- StreamingBufferPool_Init (app_freertos.c) calls Partition with
@@ -4664,10 +4920,10 @@ static scpi_result_t SCPI_GetMemFree(scpi_t * context) {
     scpi_printf(context, "SampleElementBytes=%u\r\n", (unsigned)elemSize);
     scpi_printf(context, "SamplePoolBytes=%u\r\n",
                 (unsigned)(samplePoolCap * elemSize));
-    scpi_printf(context, "SampleNextFreeBytes=%u\r\n",
-                (unsigned)(samplePoolCap * sizeof(int16_t)));
-    scpi_printf(context, "SampleQueueBytes=%u\r\n",
-                (unsigned)(samplePoolCap * sizeof(void*) + 80));
+    /* The slot ring has no free-list array and no pointer queue; both keys
+     * are kept (key=value compatibility) and now report 0. */
+    scpi_printf(context, "SampleNextFreeBytes=%u\r\n", 0u);
+    scpi_printf(context, "SampleQueueBytes=%u\r\n", 0u);
     scpi_printf(context, "SamplePoolInUse=%u\r\n",
                 (unsigned)AInSampleList_PoolInUse());
     scpi_printf(context, "SamplePoolMaxUsed=%u\r\n",
@@ -4735,12 +4991,28 @@ static bool PrepareStreamingBuffers(uint32_t poolCount, size_t sampleElemSize) {
         encSize    = mc->encoderBufSize ? mc->encoderBufSize : ENCODER_BUFFER_DEFAULT;
     }
 
-    // Wait for any in-flight USB DMA write before swapping buffers; ABORT on
-    // timeout rather than proceeding (#486) — swapping the write buffer while
-    // a DMA transfer is live would race the SetWriteBuffer pointer.
-    UsbCdcData_t* pUsb = UsbCdc_GetSettings();
+    /* UDP streaming carves its ring out of the WiFi region (below), leaving
+     * the TCP console enough for SCPI replies. A region too small for both
+     * would stream nothing, so refuse it up front. */
+    StreamingRuntimeConfig* sc = BoardRunTimeConfig_Get(BOARDRUNTIME_STREAMING_CONFIGURATION);
+    bool udpStream = (sc->ActiveInterface == StreamingInterface_WiFiUdp);
+    const uint32_t udpTcpShare = 2u * STREAMING_WIFI_MIN;
+    if (udpStream && wifiSize < udpTcpShare + WIFI_UDP_STREAM_MIN_BUFFER) {
+        LOG_E("PrepareStreamingBuffers: WiFi region %u too small for UDP streaming (min %u)",
+              (unsigned)wifiSize, (unsigned)(udpTcpShare + WIFI_UDP_STREAM_MIN_BUFFER));
+        return false;
+    }
+
+    /* The USB+SD fan-out queue lives in the encoder region and the USB task
+     * reads it on its own: stop that first, so no new DMA starts from it after
+     * the wait below and nothing reads the region while it is re-carved. */
+    Streaming_FanoutDetach();
+
+    // Wait for both USB DMA transfer slots to drain before swapping buffers;
+    // ABORT on timeout rather than proceeding (#486) — swapping the write
+    // buffer while a DMA transfer is live would race the SetWriteBuffer pointer.
     TickType_t t = xTaskGetTickCount();
-    while (pUsb->writeTransferHandle != USB_DEVICE_CDC_TRANSFER_HANDLE_INVALID) {
+    while (UsbCdc_WriteInFlight()) {
         if ((xTaskGetTickCount() - t) > pdMS_TO_TICKS(1000)) return false;
         vTaskDelay(1);
     }
@@ -4825,12 +5097,24 @@ static bool PrepareStreamingBuffers(uint32_t poolCount, size_t sampleElemSize) {
         return false;
     }
     // All allocations succeeded — now apply every buffer pointer together
-    // (circular pool + coherent DMA) so the config is all-or-nothing.
+    // (circular pool + coherent DMA) so the config is all-or-nothing. The SD
+    // write buffer goes first: it is the one swap that can be refused (a log
+    // write still in flight), and nothing else has moved yet when it is.
+    if (!sd_card_manager_SetWriteBuffer(sdDmaBuf, sdDmaSize)) {
+        LOG_E("PrepareStreamingBuffers: SD write buffer busy, aborting");
+        sd_card_manager_UnlockBuffer();   /* #703: release SD buffer lock on abort */
+        return false;
+    }
     UsbCdc_SetWriteBuffer(usbBuf, usbLen);
-    wifi_tcp_server_SetWriteBuffer(wifiBuf, wifiLen);
+    if (udpStream && wifiLen >= udpTcpShare + WIFI_UDP_STREAM_MIN_BUFFER) {
+        wifi_tcp_server_SetWriteBuffer(wifiBuf, udpTcpShare);
+        wifi_udp_stream_SetBuffer(wifiBuf + udpTcpShare, wifiLen - udpTcpShare);
+    } else {
+        wifi_tcp_server_SetWriteBuffer(wifiBuf, wifiLen);
+        wifi_udp_stream_SetBuffer(NULL, 0);
+    }
     Streaming_SetEncoderBuffer(encBuf, encLen);
     sd_card_manager_SetCircularBuffer(sdCircBuf, sdCircLen);
-    sd_card_manager_SetWriteBuffer(sdDmaBuf, sdDmaSize);
     UsbCdc_SetDmaWriteBuffer(usbDmaBuf, usbDmaSize);
     WDRV_WINC_SPI_SetBuffer(wifiDmaBuf, wifiDmaSize);
     /* #703: swap complete — release the SD buffer lock. Any SD op that armed
@@ -4838,9 +5122,9 @@ static bool PrepareStreamingBuffers(uint32_t poolCount, size_t sampleElemSize) {
      * against the new buffer size. */
     sd_card_manager_UnlockBuffer();
 
-    void* sPoolMem; int16_t* sFreeMem; uint32_t sCount; size_t sElemSz;
-    StreamingBufferPool_GetSamplePool(&sPoolMem, &sFreeMem, &sCount, &sElemSz);
-    AInSampleList_InitializeExternal(sPoolMem, sFreeMem, sCount, sElemSz);
+    void* sPoolMem; uint32_t sCount; size_t sElemSz;
+    StreamingBufferPool_GetSamplePool(&sPoolMem, &sCount, &sElemSz);
+    AInSampleList_InitializeExternal(sPoolMem, sCount, sElemSz);
     return true;
 }
 
@@ -5435,7 +5719,8 @@ static scpi_result_t SCPI_CapabilitiesJsonGet(scpi_t * context) {
          * supports. Adding an encoding the firmware accepts but never
          * advertises leaves every schema-following client unable to offer it.
          * Appended last so existing clients see their three unchanged. */
-        "\"streaming\":{\"encodings\":[\"pb\",\"csv\",\"json\",\"csv_compact\"],"
+        "\"streaming\":{\"encodings\":[\"pb\",\"csv\",\"json\",\"csv_compact\",\"pb_block\"],"
+        "\"pb_delta_keyframe_max\":65535,"
         "\"transports\":[");
     {
         bool first = true;
@@ -6005,6 +6290,10 @@ static const scpi_command_t scpi_commands[] = {
     //
     {.pattern = "SYSTem:COMMunicate:LAN:GETChipInfo?", .callback = SCPI_LANGetChipInfo,},
     {.pattern = "SYSTem:COMMunicate:LAN:MDNS?", .callback = SCPI_LANMdnsDiagGet,},  // #58 mDNS diagnostics
+    {.pattern = "SYSTem:COMMunicate:LAN:UDPStream:DESTination", .callback = SCPI_LANUdpStreamDestSet,},  // SYST:STR:INT 4
+    {.pattern = "SYSTem:COMMunicate:LAN:UDPStream:DESTination?", .callback = SCPI_LANUdpStreamDestGet,},
+    {.pattern = "SYSTem:COMMunicate:LAN:UDPStream:STATs?", .callback = SCPI_LANUdpStreamStatsGet,},
+    {.pattern = "SYSTem:COMMunicate:LAN:CLIents?", .callback = SCPI_LANClientsGet,},  // TCP stream fan-out
     // User SPI1 master on the DIO terminal (#665, epic #664)
     {.pattern = "SYSTem:COMMunicate:SPI:CONFig", .callback = SCPI_SpiConfigSet,},
     {.pattern = "SYSTem:COMMunicate:SPI:CONFig?", .callback = SCPI_SpiConfigGet,},
@@ -6062,6 +6351,8 @@ static const scpi_command_t scpi_commands[] = {
     {.pattern = "CONFigure:ADC:SAMC:DEDicated?", .callback = SCPI_ADCSamcDedicatedGet,},
     {.pattern = "CONFigure:ADC:SAMC:SHARed", .callback = SCPI_ADCSamcSharedSet,},
     {.pattern = "CONFigure:ADC:SAMC:SHARed?", .callback = SCPI_ADCSamcSharedGet,},
+    {.pattern = "CONFigure:ADC:SCAN:DMA", .callback = SCPI_ADCScanDmaSet,},
+    {.pattern = "CONFigure:ADC:SCAN:DMA?", .callback = SCPI_ADCScanDmaGet,},
     //
     // Voltage output precision
     {.pattern = "CONFigure:VOLTage:PRECision", .callback = SCPI_SetDataPrecision,},
@@ -6102,6 +6393,16 @@ static const scpi_command_t scpi_commands[] = {
     {.pattern = "SYSTem:StreamData?", .callback = SCPI_IsStreaming,},
     {.pattern = "SYSTem:STReam:FORmat", .callback = SCPI_SetStreamFormat,}, // 0 = pb = default, 1 = text (json)
     {.pattern = "SYSTem:STReam:FORmat?", .callback = SCPI_GetStreamFormat,},
+    {.pattern = "SYSTem:STReam:DELTa", .callback = SCPI_SetStreamDelta,}, // 0=off, K=PB keyframe interval
+    {.pattern = "SYSTem:STReam:DELTa?", .callback = SCPI_GetStreamDelta,},
+    {.pattern = "SYSTem:STReam:ADAPTive", .callback = SCPI_SetStreamAdaptive,}, // 0=static caps, 1=AIMD decimation
+    {.pattern = "SYSTem:STReam:ADAPTive?", .callback = SCPI_GetStreamAdaptive,},
+    {.pattern = "SYSTem:STReam:DECimate", .callback = SCPI_SetStreamDecimate,}, // N[,stages[,bits]]: boxcar/CIC oversampling
+    {.pattern = "SYSTem:STReam:DECimate?", .callback = SCPI_GetStreamDecimate,},
+    {.pattern = "SYSTem:STReam:CAPture", .callback = SCPI_SetStreamCapture,}, // pre,post[,sources]: pre/post-trigger burst to RAM
+    {.pattern = "SYSTem:STReam:CAPture?", .callback = SCPI_GetStreamCapture,},
+    {.pattern = "SYSTem:STReam:CAPture:STATe?", .callback = SCPI_GetStreamCaptureState,},
+    {.pattern = "SYSTem:STReam:CAPture:FORCe", .callback = SCPI_ForceStreamCapture,},
     {.pattern = "SYSTem:STReam:INTerface", .callback = SCPI_SetStreamInterface,}, // 0=USB, 1=WiFi, 2=SD, 3=USB+SD
     {.pattern = "SYSTem:STReam:INTerface?", .callback = SCPI_GetStreamInterface,},
     {.pattern = "SYSTem:STReam:STATS?", .callback = SCPI_GetStreamStats,},
@@ -6151,6 +6452,8 @@ static const scpi_command_t scpi_commands[] = {
     //
     {.pattern = "SYSTem:STORage:SD:FILE", .callback = SCPI_StorageSDLoggingSet,},
     {.pattern = "SYSTem:STORage:SD:GET", .callback = SCPI_StorageSDGetData},
+    {.pattern = "SYSTem:STORage:SD:GET:BLOCks", .callback = SCPI_StorageSDGetBlocks},
+    {.pattern = "SYSTem:STORage:SD:GET:TIMe", .callback = SCPI_StorageSDGetTime},
     {.pattern = "SYSTem:STORage:SD:CRC", .callback = SCPI_StorageSDCrcStart,},
     {.pattern = "SYSTem:STORage:SD:CRC?", .callback = SCPI_StorageSDCrcGet,},
     {.pattern = "SYSTem:STORage:SD:LISt?", .callback = SCPI_StorageSDListDir},
@@ -6172,6 +6475,10 @@ static const scpi_command_t scpi_commands[] = {
     {.pattern = "SYSTem:STORage:SD:MAXSize?", .callback = SCPI_StorageSDMaxSizeGet},
     {.pattern = "SYSTem:STORage:SD:MINFree", .callback = SCPI_StorageSDMinFreeSet},   // #498
     {.pattern = "SYSTem:STORage:SD:MINFree?", .callback = SCPI_StorageSDMinFreeGet},  // #498
+    {.pattern = "SYSTem:STORage:SD:PREALLoc", .callback = SCPI_StorageSDPreallocSet},
+    {.pattern = "SYSTem:STORage:SD:PREALLoc?", .callback = SCPI_StorageSDPreallocGet},
+    {.pattern = "SYSTem:STORage:SD:CONTainer", .callback = SCPI_StorageSDContainerSet},
+    {.pattern = "SYSTem:STORage:SD:CONTainer?", .callback = SCPI_StorageSDContainerGet},
     {.pattern = "SYSTem:STORage:SD:SPACe?", .callback = SCPI_StorageSDSpaceGet},
     {.pattern = "SYSTem:STORage:SD:ABORt", .callback = SCPI_StorageSDAbort},
     {.pattern = "SYSTem:STORage:SD:INFO?", .callback = SCPI_StorageSDInfo},
@@ -6191,6 +6498,32 @@ static const scpi_command_t scpi_commands[] = {
     {.pattern = NULL, .callback = SCPI_NotImplemented,},
 };
 
+// Hashed index over scpi_commands (libscpi cmdindex.c): findCommandHeader
+// tries the one or two patterns a header can match instead of scanning the
+// ~300-entry table, which cost ~200 matchCommand calls for the SYST:STR
+// commands near its end. The table needs ~330 entries (one per pattern, two
+// for the few whose short form is under 3 characters); the headroom covers
+// commands added later. If it ever overflows, SCPI_InitCommandIndex logs it
+// and dispatch stays on the linear scan.
+#define SCPI_COMMAND_INDEX_ENTRIES 512
+static scpi_command_index_entry_t scpi_command_index_entries[SCPI_COMMAND_INDEX_ENTRIES];
+static scpi_command_index_t scpi_command_index;
+
+void SCPI_InitCommandIndex(void) {
+    if (scpi_command_index.cmdlist == scpi_commands) {
+        return;
+    }
+    if (SCPI_CommandIndexInit(&scpi_command_index, scpi_commands,
+            scpi_command_index_entries, SCPI_COMMAND_INDEX_ENTRIES)) {
+        LOG_I("SCPI: command index, %u entries (%u unindexed)",
+              (unsigned)(scpi_command_index.hashed + scpi_command_index.unindexed),
+              (unsigned)scpi_command_index.unindexed);
+    } else {
+        LOG_E("SCPI: command index needs more than %u entries, using linear lookup",
+              (unsigned)SCPI_COMMAND_INDEX_ENTRIES);
+    }
+}
+
 #define SCPI_INPUT_BUFFER_LENGTH 512  // Match USB CDC max packet size to prevent silent truncation
 #define SCPI_ERROR_QUEUE_SIZE 17
 char scpi_input_buffer[SCPI_INPUT_BUFFER_LENGTH];
@@ -6305,6 +6638,10 @@ scpi_t CreateSCPIContext(scpi_interface_t* interface, void* user_context) {
     // (wifi_tcp_server_ContextIsTcp) needs it actually set.
     daqifiScpiContext.user_context = user_context;
 
+    // Shared by every context. findCommandHeader only consults it once
+    // SCPI_InitCommandIndex has built it over this same table.
+    daqifiScpiContext.cmd_index = &scpi_command_index;
+
     // Return it to the app
     return daqifiScpiContext;
 }
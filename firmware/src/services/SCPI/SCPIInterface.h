@@ -39,6 +39,15 @@ extern "C" {
      */
     void SCPI_InitIdentification(void);
 
+    /**
+     * Build the hashed command index every SCPI context dispatches through.
+     * Call once from app_SystemInit before any transport task is created,
+     * like SCPI_InitIdentification. Until it has run, or if the table does
+     * not fit, command lookup falls back to libscpi's linear scan.
+     * Idempotent.
+     */
+    void SCPI_InitCommandIndex(void);
+
     /* #833: compute the program-image CRC that CONF:CAP:JSON? reports as
      * identity.firmware_crc32. Call ONCE from main(), BEFORE the scheduler
      * starts: it takes ~120 ms (measured on the bench -- a cold
@@ -22,6 +22,8 @@
 #include "services/daqifi_settings.h"
 #include "services/wifi_services/wifi_manager.h"
 #include "services/wifi_services/mdns_responder.h"   // #58: mDNS diagnostics
+#include "services/wifi_services/wifi_udp_stream.h"  // SYST:STR:INT 4 destination
+#include "services/streaming_fanout.h"                // SYST:COMM:LAN:CLIents?
 #include "services/SCPI/SCPIInterface.h"              // #58: shared response buffer
 #include "HAL/UserSpi/UserSpi.h"                      // #665: user SPI1 master
 #include "HAL/UserUart/UserUart.h"                    // #16: user UART
@@ -748,6 +750,81 @@ scpi_result_t SCPI_LANMdnsDiagGet(scpi_t * context) {
     return r;
 }
 
+scpi_result_t SCPI_LANUdpStreamDestSet(scpi_t * context) {
+    wifi_manager_ipv4Addr_t ip;
+    int32_t port = (int32_t)WIFI_UDP_STREAM_DEFAULT_PORT;
+    if (SCPI_LANAddrSetImpl(context, &ip) != SCPI_RES_OK) {
+        return SCPI_RES_ERR;
+    }
+    if (!SCPI_ParamInt32(context, &port, FALSE)) {
+        port = (int32_t)WIFI_UDP_STREAM_DEFAULT_PORT;   /* optional */
+    }
+    /* inet_addr answers 0xFFFFFFFF (the broadcast address) for a malformed
+     * string; streaming to every host on the LAN is never what was meant. */
+    if (ip.Val == 0xFFFFFFFFu || port < 1 || port > 65535) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+    wifi_udp_stream_SetDestination(ip.Val, (uint16_t)port);
+    return SCPI_RES_OK;
+}
+
+scpi_result_t SCPI_LANUdpStreamDestGet(scpi_t * context) {
+    wifi_manager_ipv4Addr_t ip;
+    uint16_t port;
+    wifi_udp_stream_GetDestination(&ip.Val, &port);
+    SCPI_LANAddrGetImpl(context, &ip);
+    SCPI_ResultInt32(context, (int32_t)port);
+    return SCPI_RES_OK;
+}
+
+scpi_result_t SCPI_LANUdpStreamStatsGet(scpi_t * context) {
+    wifi_udp_stream_stats_t s;
+    wifi_udp_stream_GetStats(&s);
+    char jsonChar[256];
+    snprintf(jsonChar, sizeof(jsonChar),
+             "{\"Running\":%d,\"Socket\":%d,\"NextSeq\":%lu,\"Batches\":%lu,"
+             "\"Sent\":%lu,\"SendFail\":%lu,\"Rejected\":%lu,\"RejectedBytes\":%lu,"
+             "\"BytesSent\":%llu}\n",
+             (int)s.running, (int)s.socketOpen, (unsigned long)s.nextSeq,
+             (unsigned long)s.batches, (unsigned long)s.datagramsSent,
+             (unsigned long)s.datagramsFailed, (unsigned long)s.rejectedBatches,
+             (unsigned long)s.rejectedBytes, (unsigned long long)s.bytesSent);
+    return SCPI_LANStringGetImpl(context, jsonChar);
+}
+
+scpi_result_t SCPI_LANClientsGet(scpi_t * context) {
+    wifi_tcp_server_context_t* srv = wifi_manager_GetTcpServerContext();
+    char *buf = (char *)SCPI_ResponseBuf_Take();
+    if (buf == NULL) {
+        return SCPI_RES_ERR;
+    }
+    size_t n = (size_t)snprintf(buf, SCPI_RESPONSE_BUF_SIZE,
+             "{\"TapAccepted\":%lu,\"TapStallClosed\":%lu,\"Clients\":[",
+             (unsigned long)srv->tapAccepted, (unsigned long)srv->tapStallClosed);
+    uint8_t c;
+    for (c = 0; c < WIFI_MAX_CLIENT && n < SCPI_RESPONSE_BUF_SIZE; c++) {
+        TcpFanoutClient_t s;
+        uint32_t pending;
+        bool attached = Streaming_FanoutGetWifiClient(c, &s, &pending);
+        n += (size_t)snprintf(buf + n, SCPI_RESPONSE_BUF_SIZE - n,
+             "%s{\"Slot\":%u,\"Connected\":%d,\"Streaming\":%d,\"BytesSent\":%llu,"
+             "\"Sends\":%lu,\"SendErrors\":%lu,\"Pending\":%lu,"
+             "\"DroppedBytes\":%lu,\"DroppedBlocks\":%lu}",
+             (c > 0u) ? "," : "", (unsigned)c,
+             (int)wifi_tcp_server_ClientConnected(c), (int)attached,
+             (unsigned long long)s.bytesSent, (unsigned long)s.sends,
+             (unsigned long)s.sendErrors, (unsigned long)pending,
+             (unsigned long)s.droppedBytes, (unsigned long)s.droppedBlocks);
+    }
+    if (n < SCPI_RESPONSE_BUF_SIZE) {
+        snprintf(buf + n, SCPI_RESPONSE_BUF_SIZE - n, "]}\n");
+    }
+    scpi_result_t r = SCPI_LANStringGetImpl(context, buf);
+    SCPI_ResponseBuf_Give();
+    return r;
+}
+
 // =========================================================================
 // User SPI1 master (#665, epic #664) -- SYST:COMM:SPI:*
 // =========================================================================
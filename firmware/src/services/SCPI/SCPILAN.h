@@ -199,6 +199,38 @@ scpi_result_t SCPI_LANGetChipInfo(scpi_t * context);
  * @return SCPI_RES_OK on success, SCPI_RES_ERR on error
  */
 scpi_result_t SCPI_LANMdnsDiagGet(scpi_t * context);
+
+/**
+ * SCPI Callback: where WiFi UDP streaming (SYST:STR:INT 4) sends its
+ * datagrams: "a.b.c.d"[,port]. Port defaults to 9761. Runtime only, not saved.
+ * @param context
+ * @return SCPI_RES_OK on success, SCPI_RES_ERR on error
+ */
+scpi_result_t SCPI_LANUdpStreamDestSet(scpi_t * context);
+
+/**
+ * SCPI Callback: the UDP stream destination, "a.b.c.d",port ("0.0.0.0" unset).
+ * @param context
+ * @return SCPI_RES_OK on success, SCPI_RES_ERR on error
+ */
+scpi_result_t SCPI_LANUdpStreamDestGet(scpi_t * context);
+
+/**
+ * SCPI Callback: UDP stream transmit counters as JSON. Loss itself is only
+ * visible at the receiver, from gaps in the datagram sequence numbers.
+ * @param context
+ * @return SCPI_RES_OK on success, SCPI_RES_ERR on error
+ */
+scpi_result_t SCPI_LANUdpStreamStatsGet(scpi_t * context);
+
+/**
+ * SCPI Callback: the TCP stream clients as JSON -- slot 0 is this console,
+ * the others stream taps -- with what each was sent, still has queued, and
+ * lost to falling behind. Counters are from each slot's latest connection.
+ * @param context
+ * @return SCPI_RES_OK on success, SCPI_RES_ERR on error
+ */
+scpi_result_t SCPI_LANClientsGet(scpi_t * context);
 /* ---------------------------------------------------------------------
  * User SPI1 master on the DIO terminal (#665, epic #664). SYST:COMM:SPI:*.
  * Hosted here as the SYST:COMM namespace home until the epic's I2C/UART
@@ -32,6 +32,8 @@
 #include "../wifi_services/wifi_manager.h"     /* #589 FW-update owner */
 #include "app_freertos.h"                       /* #589 live SPI-owner test */
 #include "../../state/runtime/BoardRuntimeConfig.h"
+#include "../../state/board/BoardConfig.h"
+#include "../../HAL/TimerApi/TimerApi.h"
 #include "system/fs/sys_fs_media_manager.h"
 #include "system/fs/sys_fs.h"
 #include "Util/Logger.h"
@@ -626,7 +628,41 @@ scpi_result_t SCPI_StorageSDCrcGet(scpi_t * context) {
     return SCPI_RES_ERR;
 }
 
-scpi_result_t SCPI_StorageSDGetData(scpi_t * context) {
+/* Range operands of SD:GET:BLOCks / SD:GET:TIMe, after the file name.
+ * BLOCks: first block, block count. TIMe: start and stop in seconds after
+ * the file's first record, converted to timestamp ticks -- the unit of the
+ * container trailers. */
+static bool SD_ParseReadRange(scpi_t *context, sd_card_manager_read_select_t select,
+                              uint64_t *pArg1, uint64_t *pArg2) {
+    if (select == SD_CARD_READ_BLOCKS) {
+        return SCPI_ParamUInt64(context, pArg1, TRUE) &&
+               SCPI_ParamUInt64(context, pArg2, TRUE);
+    }
+    double start;
+    double stop;
+    if (!SCPI_ParamDouble(context, &start, TRUE) ||
+        !SCPI_ParamDouble(context, &stop, TRUE) ||
+        start < 0.0 || stop < start) {
+        return false;
+    }
+    const tBoardConfig* pBoardConfig = (const tBoardConfig*)BoardConfig_Get(BOARDCONFIG_ALL_CONFIG, 0);
+    uint32_t tickRate = TimerApi_FrequencyGet(pBoardConfig->StreamingConfig.TSTimerIndex);
+    // 2^32 ticks per timer wrap, 2^16 wraps per file (trailer epoch).
+    const double maxTicks = 281474976710655.0;
+    double ticks1 = start * (double)tickRate;
+    double ticks2 = stop * (double)tickRate;
+    if (tickRate == 0u || ticks1 > maxTicks) {
+        return false;
+    }
+    *pArg1 = (uint64_t)ticks1;
+    *pArg2 = (ticks2 > maxTicks) ? (uint64_t)maxTicks : (uint64_t)ticks2;
+    return true;
+}
+
+/* SD:GET and its ranged forms: validate, claim, stage opFile/range/reply
+ * target and arm the SD task's READ. @p cmd names the command in logs. */
+static scpi_result_t SD_StartRead(scpi_t *context, const char *cmd,
+                                  sd_card_manager_read_select_t select) {
     /* #747: NULL, not indeterminate. SCPI_ParamCharacters(..., mandatory=false)
      * leaves pBuff untouched when the argument is omitted, and the operand
      * normalizer is called unconditionally. fileLen is 0 in that case so the
@@ -645,13 +681,15 @@ scpi_result_t SCPI_StorageSDGetData(scpi_t * context) {
     }
 
     // Check if SD card is busy with another operation
-    if (SD_RefuseIfSuspended(context, "GET")) {
+    if (SD_RefuseIfSuspended(context, cmd)) {
         result = SCPI_RES_ERR;
         goto __exit_point;
     }
 
     if (sd_card_manager_IsBusy()) {
-        LOG_SD_BUSY("GET");
+        /* LOG_SD_BUSY's format, with cmd not a literal here. */
+        LOG_E("SD:%s - SD card busy, state=%s mode=%s\r\n", cmd,
+              sd_card_manager_GetStateName(), sd_card_manager_GetModeName());
         SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
         result = SCPI_RES_ERR;
         goto __exit_point;
@@ -670,8 +708,8 @@ scpi_result_t SCPI_StorageSDGetData(scpi_t * context) {
      * from ever tripping in practice; it's the host-visible mirror of the SD-task
      * terminal bail so a client gets an error instead of a bare EOF marker. */
     if (!sd_card_manager_ReadBufferReady()) {
-        LOG_E("[SD] GET rejected: read buffer too small - start an SD-logging "
-              "session or reboot to restore the SD buffer");
+        LOG_E("[SD] %s rejected: read buffer too small - start an SD-logging "
+              "session or reboot to restore the SD buffer", cmd);
         SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
         result = SCPI_RES_ERR;
         goto __exit_point;
@@ -683,11 +721,31 @@ scpi_result_t SCPI_StorageSDGetData(scpi_t * context) {
      * prefix the device itself emitted. */
     pBuff = SD_StripConfiguredDir(pBuff, &fileLen, pSDCardRuntimeConfig->directory);
 
+    // The ranged forms name the file explicitly: the operands follow it.
+    // SD:GET "file",offset[,length] is the framed byte-range form.
+    uint64_t rangeArg1 = 0;
+    uint64_t rangeArg2 = 0;
+    if (select == SD_CARD_READ_ALL && fileLen > 0 &&
+        SCPI_ParamUInt64(context, &rangeArg1, FALSE)) {
+        select = SD_CARD_READ_BYTES;
+        (void)SCPI_ParamUInt64(context, &rangeArg2, FALSE);   /* 0 = to the end */
+    }
+    if (SCPI_ParamErrorOccurred(context)) {
+        result = SCPI_RES_ERR;   /* a malformed offset/length; error already pushed */
+        goto __exit_point;
+    }
+    if (select != SD_CARD_READ_ALL && select != SD_CARD_READ_BYTES &&
+        (fileLen == 0 || !SD_ParseReadRange(context, select, &rangeArg1, &rangeArg2))) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        result = SCPI_RES_ERR;
+        goto __exit_point;
+    }
+
     /* #829: claim before the operand and replyTarget writes below. replyTarget
      * decides which interface this file is delivered to, so a lost race here
      * sends a client's file to the OTHER transport. The two validation paths
      * inside the block release the claim before bailing. */
-    if (!SD_ClaimOrRefuse(context, "GET")) {
+    if (!SD_ClaimOrRefuse(context, cmd)) {
         result = SCPI_RES_ERR;
         goto __exit_point;
     }
@@ -714,6 +772,9 @@ scpi_result_t SCPI_StorageSDGetData(scpi_t * context) {
         snprintf(pSDCardRuntimeConfig->opFile, sizeof(pSDCardRuntimeConfig->opFile),
                  "%s", pSDCardRuntimeConfig->file);
     }
+    pSDCardRuntimeConfig->readSelect = select;
+    pSDCardRuntimeConfig->readArg1 = rangeArg1;
+    pSDCardRuntimeConfig->readArg2 = rangeArg2;
     /* #598: route the async file data back to the interface that asked.
      * #599: capture the requesting TCP connection's generation so the SD
      * reply can't leak into a different client that later inherits the slot. */
@@ -723,7 +784,7 @@ scpi_result_t SCPI_StorageSDGetData(scpi_t * context) {
     pSDCardRuntimeConfig->replyGeneration =
             getOverTcp ? wifi_tcp_server_GetConnGeneration() : 0u;
     pSDCardRuntimeConfig->mode = SD_CARD_MANAGER_MODE_READ;  /* #829: LAST write */
-    if (!SD_ArmOrRefuse(context, "GET", pSDCardRuntimeConfig)) {
+    if (!SD_ArmOrRefuse(context, cmd, pSDCardRuntimeConfig)) {
         pSDCardRuntimeConfig->mode = SD_CARD_MANAGER_MODE_NONE;
         result = SCPI_RES_ERR;
         goto __exit_point;
@@ -733,6 +794,54 @@ __exit_point:
     return result;
 }
 
+/**
+ * @brief Send a file from the SD card, whole or a byte range of it
+ *
+ * Command: SYST:STOR:SD:GET ["<file>"[,<offset>[,<length>]]]
+ *
+ * Without an offset: the file's bytes, then __END_OF_FILE__ (unchanged).
+ * With one: bytes offset..offset+length-1 (length 0 or omitted = to the
+ * end), sent as IEEE 488.2 definite-length blocks "#<n><len><data>" each
+ * followed by the CRC-32 of its data (4 bytes, big-endian), and ended by
+ * the empty block "#10" with a zero CRC. A host that loses the link or sees
+ * a bad CRC re-requests from offset + the bytes of the blocks that checked,
+ * so an offload resumes instead of restarting. __TRANSFER_ERROR__ in place
+ * of a block header means the card read failed. See Util/SdReadPump.h.
+ */
+scpi_result_t SCPI_StorageSDGetData(scpi_t * context) {
+    return SD_StartRead(context, "GET", SD_CARD_READ_ALL);
+}
+
+/**
+ * @brief Send part of a container-mode log by block number
+ *
+ * Command: SYST:STOR:SD:GET:BLOCks "<file>",<first>,<count>
+ *
+ * Sends blocks first..first+count-1 (4 KB each, clipped to the file) as
+ * they sit on the card, then __END_OF_FILE__; a range past the end sends
+ * only the marker. Only meaningful for files written with SD:CONTainer 1.
+ */
+scpi_result_t SCPI_StorageSDGetBlocks(scpi_t * context) {
+    return SD_StartRead(context, "GET:BLOCks", SD_CARD_READ_BLOCKS);
+}
+
+/**
+ * @brief Send the part of a container-mode log covering a time window
+ *
+ * Command: SYST:STOR:SD:GET:TIMe "<file>",<start_s>,<stop_s>
+ *
+ * Times are seconds after the file's first record. The device binary-
+ * searches the block trailers (narrowed by the index block when the file
+ * was closed cleanly) and sends the whole blocks holding every record from
+ * start to stop, starting at the block where the record covering start
+ * begins; a window holding no records sends only __END_OF_FILE__. Each
+ * block is self-describing, so tests/host/sdlog_tool cat turns the reply
+ * back into the plain stream.
+ */
+scpi_result_t SCPI_StorageSDGetTime(scpi_t * context) {
+    return SD_StartRead(context, "GET:TIMe", SD_CARD_READ_TIME);
+}
+
 scpi_result_t SCPI_StorageSDListDir(scpi_t * context){
     /* #747: NULL, not indeterminate. SCPI_ParamCharacters(..., mandatory=false)
      * leaves pBuff untouched when the argument is omitted, and the operand
@@ -1766,6 +1875,94 @@ scpi_result_t SCPI_StorageSDMinFreeGet(scpi_t * context) {
     return SCPI_RES_OK;
 }
 
+/**
+ * @brief Set the contiguous preallocation extent for SD log files
+ *
+ * Command: SYST:STOR:SD:PREALLoc <bytes>
+ *   Default: 0 (no preallocation; files grow cluster by cluster)
+ *   Typical: 67108864 (64 MB)
+ *
+ * When > 0, each log file is opened with min(<bytes>, MAXSize) reserved as
+ * one contiguous cluster chain, so streaming writes land on consecutive
+ * sectors with no FAT updates in between; the unwritten tail is freed when
+ * the file is closed or rotated. The reserve runs at every file open (and
+ * so inside every rotation) and scans the FAT over the extent, so very large
+ * extents lengthen rotation. A card without that much contiguous free space
+ * falls back to normal growth (SdPreallocFallbacks in the stats).
+ */
+scpi_result_t SCPI_StorageSDPreallocSet(scpi_t * context) {
+    sd_card_manager_settings_t* pSDCardRuntimeConfig = BoardRunTimeConfig_Get(BOARDRUNTIME_SD_CARD_SETTINGS);
+
+    uint64_t preallocBytes;
+    if (!SCPI_ParamUInt64(context, &preallocBytes, TRUE)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+    // Same FAT32 ceiling SD:MAXSize enforces.
+    if (preallocBytes > 4294967295ULL) {
+        LOG_E("SD:PREALLoc - %llu exceeds FAT32 limit\r\n",
+              (unsigned long long)preallocBytes);
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+    // 32-bit store, atomic on PIC32MZ. Config-only like MINFree: consulted
+    // at the next file open, so an active session is not bounced.
+    pSDCardRuntimeConfig->preallocBytes = (uint32_t)preallocBytes;
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Query the SD log file preallocation extent
+ *
+ * Command: SYST:STOR:SD:PREALLoc?
+ * Returns: <bytes> (0 = no preallocation)
+ */
+scpi_result_t SCPI_StorageSDPreallocGet(scpi_t * context) {
+    sd_card_manager_settings_t* pSDCardRuntimeConfig = BoardRunTimeConfig_Get(BOARDRUNTIME_SD_CARD_SETTINGS);
+
+    SCPI_ResultUInt32(context, pSDCardRuntimeConfig->preallocBytes);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Enable or disable container-mode SD logging
+ *
+ * Command: SYST:STOR:SD:CONTainer <0|1>
+ *   Default: 0 (files hold the bare stream)
+ *
+ * When 1, the next logging session writes each file as 4 KB blocks with a
+ * 32-byte trailer (timestamps, sample count, CRC-32) and ends it with an
+ * index block; see Util/SdLogContainer.h. That costs ~0.8% of the card and
+ * is what makes SD:GET:BLOCks and SD:GET:TIMe possible. Streaming to USB and
+ * SD at once falls back to separate encodes (no shared fan-out queue) in
+ * this mode. Config-only like PREALLoc: latched when the session opens its
+ * first file. tests/host/sdlog_tool reads and repairs these files.
+ */
+scpi_result_t SCPI_StorageSDContainerSet(scpi_t * context) {
+    sd_card_manager_settings_t* pSDCardRuntimeConfig = BoardRunTimeConfig_Get(BOARDRUNTIME_SD_CARD_SETTINGS);
+
+    int32_t enable;
+    if (!SCPI_ParamInt32(context, &enable, TRUE) || (enable != 0 && enable != 1)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+    pSDCardRuntimeConfig->container = (enable == 1);
+    return SCPI_RES_OK;
+}
+
+/**
+ * @brief Query container-mode SD logging
+ *
+ * Command: SYST:STOR:SD:CONTainer?
+ * Returns: 0 or 1
+ */
+scpi_result_t SCPI_StorageSDContainerGet(scpi_t * context) {
+    sd_card_manager_settings_t* pSDCardRuntimeConfig = BoardRunTimeConfig_Get(BOARDRUNTIME_SD_CARD_SETTINGS);
+
+    SCPI_ResultInt32(context, pSDCardRuntimeConfig->container ? 1 : 0);
+    return SCPI_RES_OK;
+}
+
 /**
  * @brief Query SD card free and total space
  *
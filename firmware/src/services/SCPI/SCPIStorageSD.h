@@ -58,6 +58,16 @@ scpi_result_t SCPI_StorageSDDirectorySet(scpi_t * context);
 scpi_result_t SCPI_StorageSDMinFreeSet(scpi_t * context);
 scpi_result_t SCPI_StorageSDMinFreeGet(scpi_t * context);
 
+// SD Log File Preallocation (contiguous extent per file)
+scpi_result_t SCPI_StorageSDPreallocSet(scpi_t * context);
+scpi_result_t SCPI_StorageSDPreallocGet(scpi_t * context);
+
+// SD Container-Mode Logs (indexed blocks) and ranged reads of them
+scpi_result_t SCPI_StorageSDContainerSet(scpi_t * context);
+scpi_result_t SCPI_StorageSDContainerGet(scpi_t * context);
+scpi_result_t SCPI_StorageSDGetBlocks(scpi_t * context);
+scpi_result_t SCPI_StorageSDGetTime(scpi_t * context);
+
 // SD Card Space Query
 scpi_result_t SCPI_StorageSDSpaceGet(scpi_t * context);
 
@@ -7,13 +7,14 @@
 #include "services/streaming_profile.h"  // PB_PROFILE_COUNTERS gate +
                                           // accumulator hook declarations.
                                           // Avoid pulling in full streaming.h.
+#include "services/streaming_fanout.h"   // USB+SD fan-out queue drain
 
 #if PB_PROFILE_COUNTERS
 #include <xc.h>  // _CP0_GET_COUNT()
-// CP0 timestamp captured at USB_DEVICE_CDC_Write() success, consumed at
-// WRITE_COMPLETE.  Single-writer / single-reader pattern: write from the
-// task-context CircularBufferToUsbWrite path, read from the ISR-context
-// WRITE_COMPLETE callback.  32-bit reads/writes are atomic on PIC32MZ.
+// CP0 timestamp of the transfer at the head of the IN queue starting on the
+// wire: captured at USB_DEVICE_CDC_Write() success when nothing was queued
+// ahead of it, or at the previous WRITE_COMPLETE when it was; consumed at its
+// own WRITE_COMPLETE.  32-bit reads/writes are atomic on PIC32MZ.
 static volatile uint32_t gUsbWriteStartCycles;
 
 // #388: called from Streaming_ClearStats() so a transfer-in-flight at
@@ -245,7 +246,8 @@ USB_DEVICE_CDC_EVENT_RESPONSE UsbCdc_CDCEventHandler
             /* This means that the data write got completed. We can schedule
              * the next write. */
             USB_DEVICE_CDC_EVENT_DATA_WRITE_COMPLETE val = *(USB_DEVICE_CDC_EVENT_DATA_WRITE_COMPLETE*) (pData);
-            if (val.handle == pUsbCdcDataObject->writeTransferHandle) {
+            uint32_t queuedLen = 0;
+            if (UsbTxSlots_Complete(&pUsbCdcDataObject->txSlots, val.handle, &queuedLen)) {
                 /* #511: wire-confirmed bytes. Count ONLY writes the peripheral
                  * actually delivered. val.status==USB_DEVICE_CDC_RESULT_OK means
                  * the IRP COMPLETED (or COMPLETED_SHORT) and val.length is the
@@ -262,7 +264,7 @@ USB_DEVICE_CDC_EVENT_RESPONSE UsbCdc_CDCEventHandler
                     gUsbWireBytesSent += val.length;
                 }
                 // Log warning if actual transferred length differs from requested
-                if (val.length != pUsbCdcDataObject->writeBufferLength) {
+                if (val.length != queuedLen) {
                     LOG_E_ONCE(LOG_ONCE_USB_WRITE_MISMATCH, "USB write length mismatch");
                 }
                 // Always finalize to prevent stuck state, even on partial write
@@ -293,14 +295,13 @@ void UsbCdc_EventHandler(USB_DEVICE_EVENT event, void * eventData, uintptr_t con
             // NanoPB_Encoder reads it directly for the streaming device_status
             // "USB connected" bit. Clear it on real teardown (stale-global audit).
             gRunTimeUsbSttings.isCdcHostConnected = 0;
-            /* #127/#617: a write in flight at teardown may never get its
-             * WRITE_COMPLETE (comment below), so the writeInProgress claim
-             * and the transfer handle would stay set forever and wedge every
-             * write after re-enumeration. Clear both here - the abandoned
-             * transfer is gone with the disconnect; a late WRITE_COMPLETE for
-             * the old handle no longer matches and is harmlessly ignored. */
-            gRunTimeUsbSttings.writeInProgress = false;
-            gRunTimeUsbSttings.writeTransferHandle = USB_DEVICE_CDC_TRANSFER_HANDLE_INVALID;
+            /* #127/#617: writes in flight at teardown may never get their
+             * WRITE_COMPLETE (comment below), so their slots and the writer
+             * claim would stay taken forever and wedge every write after
+             * re-enumeration. Release them here - the abandoned transfers are
+             * gone with the disconnect; a late WRITE_COMPLETE for an old
+             * handle no longer matches and is harmlessly ignored. */
+            UsbTxSlots_Reset(&gRunTimeUsbSttings.txSlots);
             if (gRunTimeUsbSttings.deviceHandle != USB_DEVICE_HANDLE_INVALID) {
                 gRunTimeUsbSttings.state = USB_CDC_STATE_BEGIN_CLOSE;
             }
@@ -326,6 +327,12 @@ void UsbCdc_EventHandler(USB_DEVICE_EVENT event, void * eventData, uintptr_t con
                         UsbCdc_CDCEventHandler,
                         (uintptr_t) & gRunTimeUsbSttings);
 
+                /* The ZLP rule needs the IN endpoint's packet size: 512
+                 * at high speed, 64 when the host enumerated us at full. */
+                UsbTxSlots_SetMaxPacket(&gRunTimeUsbSttings.txSlots,
+                        (USB_DEVICE_ActiveSpeedGet(gRunTimeUsbSttings.deviceHandle) == USB_SPEED_FULL)
+                            ? USB_TX_MAX_PACKET_FS : USB_TX_MAX_PACKET_HS);
+
                 /* Mark that the device is now configured */
                 gRunTimeUsbSttings.state = USB_CDC_STATE_WAIT;
                 gRunTimeUsbSttings.isConfigured = true;
@@ -407,13 +414,12 @@ void UsbCdc_EventHandler(USB_DEVICE_EVENT event, void * eventData, uintptr_t con
             // but conservative approach is to reset the interface
             gRunTimeUsbSttings.isConfigured = false;
             gRunTimeUsbSttings.isCdcHostConnected = 0;  // host link reset (stale-global audit)
-            /* #127/#617: mirror the DECONFIGURED/RESET clear - a write in
-             * flight when this error resets the interface may never get its
-             * WRITE_COMPLETE, so release the claim and the transfer handle
-             * here or writeInProgress stays stuck true and wedges every write
-             * once the interface is re-established. */
-            gRunTimeUsbSttings.writeInProgress = false;
-            gRunTimeUsbSttings.writeTransferHandle = USB_DEVICE_CDC_TRANSFER_HANDLE_INVALID;
+            /* #127/#617: mirror the DECONFIGURED/RESET clear - writes in
+             * flight when this error resets the interface may never get their
+             * WRITE_COMPLETE, so release the slots and the claim here or they
+             * stay taken and wedge every write once the interface is
+             * re-established. */
+            UsbTxSlots_Reset(&gRunTimeUsbSttings.txSlots);
             gRunTimeUsbSttings.state = USB_CDC_STATE_BEGIN_CLOSE;
             break;
         default:
@@ -421,9 +427,67 @@ void UsbCdc_EventHandler(USB_DEVICE_EVENT event, void * eventData, uintptr_t con
     }
 }
 
+/**
+ * Queues the claimed transfer slot, holding len bytes, on the IN endpoint
+ * and releases the claim. moreWaiting: bytes are already buffered behind
+ * these, so a packet-multiple slot may skip its ZLP (UsbTxSlots.h).
+ * @return The driver's result; -1 when teardown took the claim meanwhile
+ */
+static int UsbCdc_SubmitSlot(UsbCdcData_t* client, uint32_t len, bool moreWaiting) {
+    taskENTER_CRITICAL();
+    UsbTxSlot_t* slot = UsbTxSlots_Queue(&client->txSlots, len, moreWaiting);
+    taskEXIT_CRITICAL();
+    if (slot == NULL) {
+        return -1;
+    }
+
+    // Call USB driver outside critical section (may block/take time). The
+    // driver writes slot->handle before it submits, so a WRITE_COMPLETE that
+    // fires before this call returns still matches the slot.
+    USB_DEVICE_CDC_RESULT writeResult = USB_DEVICE_CDC_Write(USB_DEVICE_CDC_INDEX_0,
+            (USB_DEVICE_CDC_TRANSFER_HANDLE*) &slot->handle,
+            slot->data,
+            slot->len,
+            slot->morePending ? USB_DEVICE_CDC_TRANSFER_FLAGS_MORE_DATA_PENDING
+                              : USB_DEVICE_CDC_TRANSFER_FLAGS_DATA_COMPLETE);
+
+#if PB_PROFILE_COUNTERS
+    // #388: stamp the start time only on successful submission so a
+    // failed Write() doesn't pollute the pending-cycles accumulator, and
+    // only for a transfer that went straight onto an idle endpoint — one
+    // queued behind another starts when that one completes (FinalizeWrite
+    // stamps it there).  Race note: WRITE_COMPLETE ISR can fire before this
+    // store retires; that costs one reading, same as the single-slot path.
+    if (writeResult == USB_DEVICE_CDC_RESULT_OK && !slot->overlapped) {
+        gUsbWriteStartCycles = _CP0_GET_COUNT();
+    }
+#endif
+
+    taskENTER_CRITICAL();
+    UsbTxSlots_Submitted(&client->txSlots, writeResult == USB_DEVICE_CDC_RESULT_OK);
+    taskEXIT_CRITICAL();
+
+    if (writeResult != USB_DEVICE_CDC_RESULT_OK) {
+        LOG_E("USB CDC write API failed");
+#if PB_PROFILE_COUNTERS
+        // #388: ensure no stale start cycles linger after a failure when
+        // nothing is left on the wire to consume them.
+        if (UsbTxSlots_InFlight(&client->txSlots) == 0u) {
+            UsbCdc_Profile_ResetPendingStamp();
+        }
+#endif
+    }
+    return (int)writeResult;
+}
+
+/** True while a transfer slot is not on the wire (it may still be claimed). */
+static bool UsbCdc_WriteSlotFree(const UsbCdcData_t* client) {
+    return UsbTxSlots_InFlight(&client->txSlots) < client->txSlots.count;
+}
+
 int UsbCdc_Wrapper_Write(uint8_t* buf, uint32_t len) {
-    // Validate length against buffer size to prevent overflow
-    if (len == 0 || len > gRunTimeUsbSttings.dmaWriteBufferSize) {
+    // Validate length against one transfer slot to prevent overflow
+    if (len == 0 || len > UsbTxSlots_SlotSize(&gRunTimeUsbSttings.txSlots)) {
         LOG_D("USB write: invalid length %lu", (unsigned long)len);
         return -1;  // Invalid length
     }
@@ -440,140 +504,115 @@ int UsbCdc_Wrapper_Write(uint8_t* buf, uint32_t len) {
         return -1;  // USB not configured/ready
     }
 
-    // Begin atomic section to prevent race conditions with concurrent writes
+    // #127: claim a free slot atomically; the claim excludes every other
+    // writer until SubmitSlot has handed it to the driver, so the copy below
+    // can run outside the critical section.
+    uint32_t cap = 0;
     taskENTER_CRITICAL();
-
-    // Check if previous write is still pending to prevent buffer corruption.
-    // #127: writeInProgress closes the TOCTOU window - the handle reads
-    // INVALID between this critical section and the driver call assigning
-    // it, so the handle alone can't exclude a concurrent writer.
-    if (gRunTimeUsbSttings.writeTransferHandle != USB_DEVICE_CDC_TRANSFER_HANDLE_INVALID ||
-        gRunTimeUsbSttings.writeInProgress) {
-        taskEXIT_CRITICAL();
-        LOG_D("USB write: previous transfer pending");
-        return -1;  // Previous write still in progress
-    }
-    gRunTimeUsbSttings.writeInProgress = true;
-
-    // Prepare buffer while in atomic section to prevent another task from corrupting it
-    memcpy(gRunTimeUsbSttings.dmaWriteBuffer, buf, (size_t)len);
-    gRunTimeUsbSttings.writeBufferLength = len;
-    gRunTimeUsbSttings.writeTransferHandle = USB_DEVICE_CDC_TRANSFER_HANDLE_INVALID;
-
+    uint8_t* dst = UsbTxSlots_Claim(&gRunTimeUsbSttings.txSlots, &cap);
     taskEXIT_CRITICAL();
-
-    // Call USB driver outside critical section (may block/take time)
-    USB_DEVICE_CDC_RESULT writeResult = USB_DEVICE_CDC_Write(USB_DEVICE_CDC_INDEX_0,
-            &gRunTimeUsbSttings.writeTransferHandle,
-            gRunTimeUsbSttings.dmaWriteBuffer,
-            len,
-            USB_DEVICE_CDC_TRANSFER_FLAGS_DATA_COMPLETE);
-
-#if PB_PROFILE_COUNTERS
-    // #388: stamp the start time only on successful submission so a
-    // failed Write() doesn't pollute the pending-cycles accumulator.
-    // Race note: WRITE_COMPLETE ISR can fire before this store retires,
-    // but that's OK — the ISR reads writeTransferHandle invalid first
-    // and skips the accumulator unless gUsbWriteStartCycles is nonzero
-    // (the test below).  Single-writer single-reader pattern, no need
-    // for a critical section on a 32-bit value.
-    if (writeResult == USB_DEVICE_CDC_RESULT_OK) {
-        gUsbWriteStartCycles = _CP0_GET_COUNT();
+    if (dst == NULL) {
+        LOG_D("USB write: no free transfer slot");
+        return -1;  // Both slots on the wire, or another writer mid-submit
     }
-#endif
 
-    if (writeResult != USB_DEVICE_CDC_RESULT_OK) {
-        LOG_E("USB CDC write API failed");
-        // Write failed - ensure handle is invalid (atomic update)
-        taskENTER_CRITICAL();
-        gRunTimeUsbSttings.writeTransferHandle = USB_DEVICE_CDC_TRANSFER_HANDLE_INVALID;
-        gRunTimeUsbSttings.writeBufferLength = 0;
-        gRunTimeUsbSttings.writeInProgress = false;   /* #127: release claim */
-        taskEXIT_CRITICAL();
-#if PB_PROFILE_COUNTERS
-        // #388: ensure no stale start cycles linger after a partial
-        // failure (the conditional set above only runs on OK, but if
-        // a prior successful write left a value and was canceled
-        // before WRITE_COMPLETE could fire, this is the path that
-        // would observe it next.)
-        UsbCdc_Profile_ResetPendingStamp();
-#endif
+    memcpy(dst, buf, (size_t)len);
+    if (UsbCdc_SubmitSlot(&gRunTimeUsbSttings, len, false) != USB_DEVICE_CDC_RESULT_OK) {
         return -1;
     }
 
     // Success: report bytes accepted for transfer
-    // Note: Don't check if handle is still valid here - the write complete interrupt
-    // can fire so fast that UsbCdc_FinalizeWrite already reset it to INVALID
+    // Note: Don't check the slot here - the write complete interrupt
+    // can fire so fast that UsbCdc_FinalizeWrite already released it
     return (int)len;
 }
 
 /**
- * Enqueues client data for writing 
+ * Enqueues client data for writing into the next free transfer slot
  */
 static bool UsbCdc_BeginWrite(UsbCdcData_t* client) {
 
-    USB_DEVICE_CDC_RESULT writeResult = USB_DEVICE_CDC_RESULT_OK;
+    int writeResult = USB_DEVICE_CDC_RESULT_OK;
 
     if (client->state != USB_CDC_STATE_PROCESS) {
         LOG_D("USB BeginWrite: not in PROCESS state");
         return false;
     }
 
-    // make sure there is no write transfer in progress
-    if (client->writeTransferHandle == USB_DEVICE_CDC_TRANSFER_HANDLE_INVALID) {
-        xSemaphoreTake(client->wMutex, portMAX_DELAY);
-        if (CircularBuf_NumBytesAvailable(&client->wCirbuf) > 0) {
+    // Claim the free slot before touching the ring (#127): a concurrent
+    // writer that loses the claim returns here having consumed nothing.
+    uint32_t cap = 0;
+    taskENTER_CRITICAL();
+    uint8_t* dst = UsbTxSlots_Claim(&client->txSlots, &cap);
+    taskEXIT_CRITICAL();
+    if (dst == NULL) {
+        // Both slots on the wire, or another writer is mid-submit.  See
+        // the USB_CDC_STATE_PROCESS caller for the idle-count
+        // instrumentation (it gates BeginWrite on a free slot).
+        return false;
+    }
+
+    xSemaphoreTake(client->wMutex, portMAX_DELAY);
+    if (CircularBuf_NumBytesAvailable(&client->wCirbuf) > 0) {
+        // Copy straight into the slot: one transfer spans the ring's wrap
+        // point instead of one per contiguous span. A failed submit loses
+        // these bytes, but the driver only refuses a link being torn down.
 #if PB_PROFILE_COUNTERS
-            uint32_t dcStart = _CP0_GET_COUNT();
-            CircularBuf_ProcessBytes(&client->wCirbuf, NULL, client->dmaWriteBufferSize, &writeResult);
-            Streaming_AddProfileSample_DmaCopy(_CP0_GET_COUNT() - dcStart);
+        uint32_t dcStart = _CP0_GET_COUNT();
+        uint32_t n = CircularBuf_ProcessBytes(&client->wCirbuf, dst, cap, &writeResult);
+        Streaming_AddProfileSample_DmaCopy(_CP0_GET_COUNT() - dcStart);
 #else
-            CircularBuf_ProcessBytes(&client->wCirbuf, NULL, client->dmaWriteBufferSize, &writeResult);
+        uint32_t n = CircularBuf_ProcessBytes(&client->wCirbuf, dst, cap, &writeResult);
 #endif
-        } else {
+        bool moreWaiting = CircularBuf_NumBytesAvailable(&client->wCirbuf) > 0;
+        xSemaphoreGive(client->wMutex);
+        writeResult = UsbCdc_SubmitSlot(client, n, moreWaiting);
+    } else {
+        xSemaphoreGive(client->wMutex);
+        taskENTER_CRITICAL();
+        UsbTxSlots_Unclaim(&client->txSlots);
+        taskEXIT_CRITICAL();
+        // Ring empty (SCPI replies go first): in a USB+SD session the
+        // stream itself waits in the shared queue, read straight into
+        // a transfer slot from there.
+        int queued = Streaming_FanoutDrainUsb(cap, UsbCdc_Wrapper_Write);
+        if (queued == 0) {
             // No data to write, return true (success - nothing to do)
-            xSemaphoreGive(client->wMutex);
             return true;
         }
-        xSemaphoreGive(client->wMutex);
+        writeResult = queued;
+    }
 
-        // CircularBuffer callback now returns bytes written (>= 0) on success, < 0 on error
-        // Handle errors
-        if (writeResult < 0) {
-            switch (writeResult) {
-                case USB_DEVICE_CDC_RESULT_ERROR_INSTANCE_NOT_CONFIGURED:
-                case USB_DEVICE_CDC_RESULT_ERROR_INSTANCE_INVALID:
-                case USB_DEVICE_CDC_RESULT_ERROR_PARAMETER_INVALID:
-                case USB_DEVICE_CDC_RESULT_ERROR_ENDPOINT_HALTED:
-                case USB_DEVICE_CDC_RESULT_ERROR_TERMINATED_BY_HOST:
-                    // Reset the interface
-                    gRunTimeUsbSttings.state = USB_CDC_STATE_BEGIN_CLOSE;
-                    return false;
+    // Driver results are >= 0 on success, < 0 on error
+    // Handle errors
+    if (writeResult < 0) {
+        switch (writeResult) {
+            case USB_DEVICE_CDC_RESULT_ERROR_INSTANCE_NOT_CONFIGURED:
+            case USB_DEVICE_CDC_RESULT_ERROR_INSTANCE_INVALID:
+            case USB_DEVICE_CDC_RESULT_ERROR_PARAMETER_INVALID:
+            case USB_DEVICE_CDC_RESULT_ERROR_ENDPOINT_HALTED:
+            case USB_DEVICE_CDC_RESULT_ERROR_TERMINATED_BY_HOST:
+                // Reset the interface
+                gRunTimeUsbSttings.state = USB_CDC_STATE_BEGIN_CLOSE;
+                return false;
 
-                case USB_DEVICE_CDC_RESULT_ERROR_TRANSFER_SIZE_INVALID: // Bad input (GIGO)
-                    SYS_DEBUG_MESSAGE(SYS_ERROR_ERROR, "Bad USB write size");
-                    return false;
-                case USB_DEVICE_CDC_RESULT_ERROR_TRANSFER_QUEUE_FULL: // Too many pending requests. Just wait.
-                case USB_DEVICE_CDC_RESULT_ERROR: // Concurrency issue. Just wait.
-                default:
-                    // No action
-                    return false;
-            }
+            case USB_DEVICE_CDC_RESULT_ERROR_TRANSFER_SIZE_INVALID: // Bad input (GIGO)
+                SYS_DEBUG_MESSAGE(SYS_ERROR_ERROR, "Bad USB write size");
+                return false;
+            case USB_DEVICE_CDC_RESULT_ERROR_TRANSFER_QUEUE_FULL: // Too many pending requests. Just wait.
+            case USB_DEVICE_CDC_RESULT_ERROR: // Concurrency issue. Just wait.
+            default:
+                // No action
+                return false;
         }
-
-        // Success: callback returned bytes written (>= 0)
-        return true;
     }
 
-    // writeTransferHandle != INVALID — prior DMA still in flight.  See
-    // the USB_CDC_STATE_PROCESS caller for the actual idle-count
-    // instrumentation (it gates BeginWrite on the same handle check, so
-    // counting here is unreachable — Qodo finding #3).
-    return false;
+    // Success
+    return true;
 }
 
 /**
- * Waits for a write operation to complete
+ * Waits for every queued write transfer to complete
  */
 static bool UsbCdc_WaitForWrite(UsbCdcData_t* client) {
     if (client->state != USB_CDC_STATE_PROCESS) {
@@ -581,19 +620,19 @@ static bool UsbCdc_WaitForWrite(UsbCdcData_t* client) {
     }
 
     // #525: if a prior wait already detected a host-read stall, bail immediately
-    // (drop) instead of burning the full timeout again. We do NOT read
-    // writeTransferHandle here: the stalled in-flight transfer completes on its
+    // (drop) instead of burning the full timeout again. We do NOT poll the
+    // slots here: the stalled in-flight transfer completes on its
     // own when the host resumes draining, firing the WRITE_COMPLETE ISR →
     // UsbCdc_FinalizeWrite, which clears this latch — independent of whether we
     // attempt a write. So the next call after the host resumes sees writeStalled
     // == false, skips this branch, and proceeds normally. (volatile writeStalled
-    // is the single completion signal; no non-volatile handle poll needed.)
+    // is the single completion signal.)
     if (client->writeStalled) {
         return false;
     }
 
     TickType_t start = xTaskGetTickCount();
-    while (client->writeTransferHandle != USB_DEVICE_CDC_TRANSFER_HANDLE_INVALID) {
+    while (UsbTxSlots_InFlight(&client->txSlots) > 0u) {
         if (client->state != USB_CDC_STATE_PROCESS) {
             return false;
         }
@@ -617,7 +656,8 @@ static bool UsbCdc_WaitForWrite(UsbCdcData_t* client) {
 }
 
 /**
- * Finalizes a write operation by clearing the buffer for additional content 
+ * Finalizes a write operation: its slot is free for the next fill
+ * (UsbTxSlots_Complete already released it)
  */
 static bool UsbCdc_FinalizeWrite(UsbCdcData_t* client) {
 #if PB_PROFILE_COUNTERS
@@ -629,12 +669,11 @@ static bool UsbCdc_FinalizeWrite(UsbCdcData_t* client) {
     uint32_t startCycles = gUsbWriteStartCycles;
     if (startCycles != 0) {
         Streaming_AddProfileSample_DmaPending_FromISR(_CP0_GET_COUNT() - startCycles);
-        gUsbWriteStartCycles = 0;
     }
+    // The transfer queued behind this one, if any, goes on the wire now.
+    gUsbWriteStartCycles = (UsbTxSlots_InFlight(&client->txSlots) > 0u)
+                               ? _CP0_GET_COUNT() : 0;
 #endif
-    client->writeTransferHandle = USB_DEVICE_CDC_TRANSFER_HANDLE_INVALID;
-    client->writeBufferLength = 0;
-    client->writeInProgress = false;   /* #127: release claim on completion */
     // #525: a completed transfer means the host resumed draining the IN
     // endpoint — clear the stall latch so the next write proceeds normally
     // instead of being dropped by the early-bail in WaitForWrite.
@@ -999,6 +1038,37 @@ size_t UsbCdc_WriteToBuffer(UsbCdcData_t* client, const char* data, size_t len)
     return bytesAdded;
 }
 
+uint8_t* UsbCdc_ReserveWriteSpan(UsbCdcData_t* client, size_t minLen, size_t* pLen) {
+    if (client == NULL) {
+        client = &gRunTimeUsbSttings;
+    }
+    *pLen = 0;
+    if (gRunTimeUsbSttings.state != USB_CDC_STATE_PROCESS) {
+        return NULL;
+    }
+    // Same try-lock as UsbCdc_WriteToBuffer: never block the streaming task.
+    if (xSemaphoreTake(client->wMutex, 0) != pdTRUE) {
+        return NULL;
+    }
+    uint32_t span = 0;
+    uint8_t* p = CircularBuf_Reserve(&client->wCirbuf, &span);
+    if (p == NULL || span < minLen) {
+        xSemaphoreGive(client->wMutex);
+        return NULL;
+    }
+    *pLen = span;
+    return p;   // mutex held until UsbCdc_CommitWriteSpan
+}
+
+size_t UsbCdc_CommitWriteSpan(UsbCdcData_t* client, size_t len) {
+    if (client == NULL) {
+        client = &gRunTimeUsbSttings;
+    }
+    size_t committed = CircularBuf_Commit(&client->wCirbuf, (uint32_t)len);
+    xSemaphoreGive(client->wMutex);
+    return committed;
+}
+
 /*
 size_t UsbCdc_WriteDefault(const char* data, size_t len)
 {
@@ -1022,10 +1092,11 @@ bool UsbCdc_FlushWriteBuffer(void) {
     }
 
     // Drain all data from the circular buffer within a total 500ms deadline.
-    // Loops until the circular buffer is empty: wait for any in-flight DMA,
-    // then start the next write chunk, repeat until nothing left to write.
-    // All waits (both initial DMA and each new write DMA) share the deadline,
-    // so the function is fully bounded even if the host disconnects mid-flush.
+    // Loops until the circular buffer is empty: wait for a free transfer
+    // slot, start the next write chunk in it, repeat until nothing is left to
+    // write, then wait for the transfers still on the wire. All waits share
+    // the deadline, so the function is fully bounded even if the host
+    // disconnects mid-flush.
     // #525: already-latched host stall — don't burn the 500ms flush deadline
     // again. The latch clears in UsbCdc_FinalizeWrite (WRITE_COMPLETE ISR) once
     // the host resumes, independent of this call — no handle poll needed.
@@ -1034,10 +1105,12 @@ bool UsbCdc_FlushWriteBuffer(void) {
     }
 
     TickType_t start = xTaskGetTickCount();
+    bool draining = false;  // BeginWrite found nothing left to start
 
     while (true) {
-        // Wait for any in-flight DMA transfer to complete.
-        while (client->writeTransferHandle != USB_DEVICE_CDC_TRANSFER_HANDLE_INVALID) {
+        // Wait for a free slot; once nothing new starts, for all of them.
+        while (draining ? UsbTxSlots_InFlight(&client->txSlots) > 0u
+                        : !UsbCdc_WriteSlotFree(client)) {
             if (client->state != USB_CDC_STATE_PROCESS) {
                 return false;
             }
@@ -1052,16 +1125,16 @@ bool UsbCdc_FlushWriteBuffer(void) {
             }
             vTaskDelay(pdMS_TO_TICKS(10));
         }
+        if (draining) {
+            return true;    // circular buffer empty and every transfer sent
+        }
 
-        // No in-flight DMA — start the next write chunk from the circular buffer.
+        // A slot is free — start the next write chunk from the circular buffer.
+        uint32_t before = client->txSlots.queued;
         if (!UsbCdc_BeginWrite(client)) {
             return false;
         }
-
-        // If no new DMA was started, the circular buffer is now empty — done.
-        if (client->writeTransferHandle == USB_DEVICE_CDC_TRANSFER_HANDLE_INVALID) {
-            return true;
-        }
+        draining = (client->txSlots.queued == before);
     }
 }
 
@@ -1244,8 +1317,6 @@ void UsbCdc_Initialize() {
 
     gRunTimeUsbSttings.readTransferHandle =
             USB_DEVICE_CDC_TRANSFER_HANDLE_INVALID;
-    gRunTimeUsbSttings.writeTransferHandle =
-            USB_DEVICE_CDC_TRANSFER_HANDLE_INVALID;
     gRunTimeUsbSttings.readBufferLength = 0;
 
     microrl_init(&gRunTimeUsbSttings.console, microrl_echo);
@@ -1262,6 +1333,11 @@ void UsbCdc_Initialize() {
     if (gRunTimeUsbSttings.dmaWriteBuffer == NULL) {
         LOG_E("[USB] Failed to allocate DMA write buffer from coherent pool");
     }
+    UsbTxSlots_Init(&gRunTimeUsbSttings.txSlots,
+                    gRunTimeUsbSttings.dmaWriteBuffer,
+                    gRunTimeUsbSttings.dmaWriteBufferSize,
+                    USB_TX_MAX_PACKET_HS,
+                    USB_DEVICE_CDC_TRANSFER_HANDLE_INVALID);
 
     // Initialize circular buffer from streaming buffer pool (partitioned at boot).
     // Re-partitioned at each stream start via UsbCdc_SetWriteBuffer.
@@ -1289,9 +1365,9 @@ void UsbCdc_Initialize() {
 
 void UsbCdc_PumpWrite(void) {
     /* Same guard order as the write branch of UsbCdc_ProcessState: only in
-     * PROCESS state, and only when no transfer is already in flight (the
-     * driver allows a single outstanding write). BeginWrite re-checks the
-     * state itself; the check here keeps the intent readable at the call site.
+     * PROCESS state, and only when a transfer slot is free (at most two
+     * writes are outstanding). BeginWrite re-checks both itself; the checks
+     * here keep the intent readable at the call site.
      *
      * Safe to call from within a SCPI callback, but NOT because it is always
      * the same task -- it is not. SYST:STOR:SD:LISt? also serves TCP origin
@@ -1300,10 +1376,10 @@ void UsbCdc_PumpWrite(void) {
      * ProcessState -> BeginWrite. Concurrent BeginWrite is tolerated because:
      *   - the consumer side runs under wMutex, the external serialization
      *     CircularBuffer.h requires for multiple consumers;
-     *   - the DMA submit is claimed under the #127 writeInProgress flag inside
-     *     a critical section, so the loser's callback returns -1 and
-     *     CircularBuf_ProcessBytes consumes nothing on a negative return --
-     *     no lost bytes, no double-consume;
+     *   - the transfer slot is claimed (#127, UsbTxSlots_Claim) inside a
+     *     critical section before the ring is touched, so the loser's
+     *     BeginWrite returns false having consumed nothing -- no lost bytes,
+     *     no double-consume, no slots queued out of order;
      *   - -1 is not a USB_ERROR_* value (those are SCHAR_MIN-based), so it
      *     falls through BeginWrite's switch as "no action" and cannot trip the
      *     BEGIN_CLOSE arms.
@@ -1315,9 +1391,8 @@ void UsbCdc_PumpWrite(void) {
     if (gRunTimeUsbSttings.state != USB_CDC_STATE_PROCESS) {
         return;
     }
-    if (gRunTimeUsbSttings.writeTransferHandle !=
-            USB_DEVICE_CDC_TRANSFER_HANDLE_INVALID) {
-        return;                 /* a write is already in flight */
+    if (!UsbCdc_WriteSlotFree(&gRunTimeUsbSttings)) {
+        return;                 /* both transfer slots are in flight */
     }
     (void)UsbCdc_BeginWrite(&gRunTimeUsbSttings);
 }
@@ -1360,20 +1435,29 @@ void UsbCdc_ProcessState() {
                 }
             }
 
-            // I a read operation is not in progress
-            if (gRunTimeUsbSttings.writeTransferHandle ==
-                    USB_DEVICE_CDC_TRANSFER_HANDLE_INVALID) {
+            // If a transfer slot is free
+            if (UsbCdc_WriteSlotFree(&gRunTimeUsbSttings)) {
                 // Schedule any output;
+                uint32_t before = gRunTimeUsbSttings.txSlots.queued;
                 if (!UsbCdc_BeginWrite(&gRunTimeUsbSttings)) {
                     break;
                 }
-
+                // More than one slot's worth was waiting: queue the rest in
+                // the other slot now, so it is on the endpoint before this
+                // one finishes rather than a task tick later.
+                if (gRunTimeUsbSttings.txSlots.queued != before &&
+                    gRunTimeUsbSttings.txSlots.moreWaiting &&
+                    UsbCdc_WriteSlotFree(&gRunTimeUsbSttings)) {
+                    if (!UsbCdc_BeginWrite(&gRunTimeUsbSttings)) {
+                        break;
+                    }
+                }
             }
 #if PB_PROFILE_COUNTERS
             else {
-                // #388: state-machine iteration where the prior DMA
-                // transfer hadn't completed — count these to size how
-                // often the single-in-flight-DMA pattern stalls progress.
+                // #388: state-machine iteration where both transfer slots
+                // were still on the wire — count these to size how often
+                // the host, not the device, is the bottleneck.
                 Streaming_AddProfileSample_DmaIdle();
             }
 #endif
@@ -1399,16 +1483,14 @@ void UsbCdc_ProcessState() {
 
             gRunTimeUsbSttings.readTransferHandle =
                     USB_DEVICE_CDC_TRANSFER_HANDLE_INVALID;
-            gRunTimeUsbSttings.writeTransferHandle =
-                    USB_DEVICE_CDC_TRANSFER_HANDLE_INVALID;
             gRunTimeUsbSttings.readBufferLength = 0;
             /* #127/#617: teardown funnel. The endpoint-halt / terminated-by-
              * host resets in BeginRead/BeginWrite reach CLOSED only through
              * BEGIN_CLOSE - no event handler clears them - so release the
-             * write claim here too. An in-flight write abandoned at teardown
-             * must not leave writeInProgress stuck true and wedge every write
-             * after re-enumeration. */
-            gRunTimeUsbSttings.writeInProgress = false;
+             * write slots and claim here too. Writes abandoned at teardown
+             * must not leave their slots taken and wedge every write after
+             * re-enumeration. */
+            UsbTxSlots_Reset(&gRunTimeUsbSttings.txSlots);
 
             gRunTimeUsbSttings.state = USB_CDC_STATE_INIT;
 
@@ -1435,6 +1517,14 @@ bool UsbCdc_IsConfigured(void) {
     return gRunTimeUsbSttings.isConfigured;
 }
 
+bool UsbCdc_WriteInFlight(void) {
+    return UsbTxSlots_InFlight(&gRunTimeUsbSttings.txSlots) > 0u;
+}
+
+uint32_t UsbCdc_WriteTransferMax(void) {
+    return UsbTxSlots_SlotSize(&gRunTimeUsbSttings.txSlots);
+}
+
 tRunTimeUsbSettings* UsbCdc_GetRuntimeSettings(void) {
     // Return pointer to runtime settings for monitoring USB state
     return (tRunTimeUsbSettings*)&gRunTimeUsbSttings;
@@ -1446,7 +1536,7 @@ bool UsbCdc_ResizeWriteBuffer(uint32_t newSize) {
 
     // Wait for any in-flight USB DMA write to complete.
     TickType_t start = xTaskGetTickCount();
-    while (gRunTimeUsbSttings.writeTransferHandle != USB_DEVICE_CDC_TRANSFER_HANDLE_INVALID) {
+    while (UsbCdc_WriteInFlight()) {
         if ((xTaskGetTickCount() - start) > pdMS_TO_TICKS(1000)) {
             LOG_E("USB resize aborted: write transfer stuck");
             return false;
@@ -1484,4 +1574,10 @@ void UsbCdc_SetDmaWriteBuffer(uint8_t* buf, uint32_t size) {
     if (buf == NULL || size == 0) return;
     gRunTimeUsbSttings.dmaWriteBuffer = buf;
     gRunTimeUsbSttings.dmaWriteBufferSize = size;
+    UsbTxSlots_Init(&gRunTimeUsbSttings.txSlots, buf, size,
+                    gRunTimeUsbSttings.txSlots.maxPacket,
+                    USB_DEVICE_CDC_TRANSFER_HANDLE_INVALID);
+    LOG_I("USB DMA write buffer: %u bytes, %u x %u byte transfers",
+          (unsigned)size, (unsigned)gRunTimeUsbSttings.txSlots.count,
+          (unsigned)gRunTimeUsbSttings.txSlots.slotSize);
 }
\ No newline at end of file
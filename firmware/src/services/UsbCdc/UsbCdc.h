@@ -23,10 +23,11 @@ extern "C" {
 #include "libraries/microrl/src/microrl.h"
 #include "libraries/scpi/libscpi/inc/scpi/scpi.h"
 #include "Util/CircularBuffer.h"
+#include "Util/UsbTxSlots.h"
 
 #define USBCDC_WBUFFER_SIZE 4096
 #define USBCDC_DMA_WBUFFER_MAX 16384   // Max DMA staging when USB streaming active
-#define USBCDC_DMA_WBUFFER_MIN 512     // Min DMA staging (enough for SCPI responses)
+#define USBCDC_DMA_WBUFFER_MIN 512     // Min DMA staging (enough for SCPI responses; one transfer slot)
 #define USBCDC_RBUFFER_SIZE 512
 #define USBCDC_CIRCULAR_BUFF_SIZE USBCDC_WBUFFER_SIZE*4
 
@@ -78,16 +79,14 @@ extern "C" {
         /** Read transfer handle */
         USB_DEVICE_CDC_TRANSFER_HANDLE readTransferHandle;
 
-        /** Write transfer handle */
-        USB_DEVICE_CDC_TRANSFER_HANDLE writeTransferHandle;
-
-        /** #127: write-submission claim. writeTransferHandle alone can't gate
-         * concurrent writers - it is INVALID during the window between the
-         * critical-section check and USB_DEVICE_CDC_Write() assigning it, so
-         * two tasks could both pass the check and race on dmaWriteBuffer.
-         * Claimed (set true) inside the checking critical section; cleared on
-         * WRITE_COMPLETE (FinalizeWrite) or submission failure. */
-        volatile bool writeInProgress;
+        /** Write transfers: dmaWriteBuffer carved into two slots, one on
+         * the wire while the next is filled (Util/UsbTxSlots.h). Each slot
+         * holds its own transfer handle. #127: the slot claim is also the
+         * write-submission claim - taken inside a critical section before a
+         * writer touches a slot, released once USB_DEVICE_CDC_Write() has
+         * returned - so two tasks never fill the same slot or queue out of
+         * order. */
+        UsbTxSlots_t txSlots;
 
         /** #525: latched true when a write/flush wait times out (host stopped
          * draining the CDC IN endpoint). While set, WaitForWrite/FlushWriteBuffer
@@ -111,14 +110,12 @@ extern "C" {
         /** The current length of the read buffer */
         size_t readBufferLength;
 
-        /** The current length of the write buffer */
-        size_t writeBufferLength;
-
         /** Client read buffer */
         uint8_t readBuffer[USBCDC_RBUFFER_SIZE] __attribute__((coherent, aligned(16)));
         ;
 
-        /** Client DMA write buffer (allocated from CoherentPool, auto-sized) */
+        /** Client DMA write buffer (allocated from CoherentPool, auto-sized;
+         * split into txSlots) */
         uint8_t* dmaWriteBuffer;
         uint32_t dmaWriteBufferSize;
 
@@ -187,6 +184,26 @@ extern "C" {
      */
     size_t UsbCdc_WriteToBuffer(UsbCdcData_t* client, const char* data, size_t len);
 
+    /**
+     * Reserves a contiguous span of the write buffer for the caller to fill
+     * in place (zero-copy streaming). Non-blocking like UsbCdc_WriteToBuffer:
+     * returns NULL when the mutex is busy, USB is not up, or the contiguous
+     * span is shorter than minLen. On success the write mutex is HELD until
+     * UsbCdc_CommitWriteSpan(), which must follow on the same task.
+     * @param client The usb client (NULL: the default client)
+     * @param minLen Smallest span worth taking
+     * @param pLen Receives the span length
+     * @return The span, or NULL
+     */
+    uint8_t* UsbCdc_ReserveWriteSpan(UsbCdcData_t* client, size_t minLen, size_t* pLen);
+
+    /**
+     * Publishes the first len bytes of the reserved span and releases the
+     * write mutex. len == 0 abandons the reservation.
+     * @return The number of bytes committed
+     */
+    size_t UsbCdc_CommitWriteSpan(UsbCdcData_t* client, size_t len);
+
     /**
      * Writes to the default (only) client
      * @param data The data to write
@@ -256,13 +273,27 @@ uint64_t UsbCdc_GetWireBytesSent(void);
 
     /**
      * Set the USB CDC DMA write staging buffer.
-     * Called at each stream start to auto-size for active interfaces.
+     * Called at each stream start to auto-size for active interfaces; the
+     * buffer is split into two transfer slots of up to USB_TX_TRANSFER_MAX
+     * when it holds two high-speed packets, one otherwise.
      * Must only be called when no USB DMA transfer is in flight.
      * @param buf Pointer to coherent buffer memory
      * @param size Buffer size in bytes
      */
     void UsbCdc_SetDmaWriteBuffer(uint8_t* buf, uint32_t size);
 
+    /**
+     * Whether any USB write transfer is still queued on the IN endpoint.
+     * Buffer swaps (UsbCdc_SetDmaWriteBuffer) wait for this to go false.
+     */
+    bool UsbCdc_WriteInFlight(void);
+
+    /**
+     * Largest single USB write transfer (one slot of the DMA buffer).
+     * A fan-out block must fit it whole.
+     */
+    uint32_t UsbCdc_WriteTransferMax(void);
+
     /**
      * Flush any pending data in the USB CDC write circular buffer.
      * Drains circular buffer to DMA, waits for DMA transfer to complete.
@@ -31,6 +31,7 @@
 #include <limits.h>  // For INT_MIN
 #include <string.h>  // For strlen
 #include "Util/FixedPointFmt.h"   /* #250: fast %.*f replacement */
+#include "Util/FixedPointCal.h"   /* integer calibrated conversion */
 
 // =============================================================================
 // Fast Integer Formatting (avoids snprintf overhead in hot path)
@@ -567,6 +568,313 @@ static size_t tryWriteRow(
     return (size_t)(q - out);
 }
 
+// =============================================================================
+// Specialized row writers
+// =============================================================================
+// tryWriteRow above is the general writer: it re-decides compact / raw /
+// precision for every channel of every row and bounds-checks each field. The
+// writers below are the same row, instantiated once per (value format x
+// layout) from one inline body, so each has those decisions folded away at
+// compile time. A writer is only called when the buffer already holds a
+// worst-case row (CsvRowPlan.rowMax), so it writes without per-field checks.
+//
+// tryWriteRow stays the reference and the fallback: csv_Encode uses it when
+// no writer applies (precision above FIXEDFMT_MAX_PRECISION), for the rows
+// that no longer have a worst-case row of room at the end of a buffer, and
+// for a row a writer declines (a fixed-point value outside the fixedfmt
+// envelope, which needs snprintf). tests/host/test_csv_rows.c holds the two
+// byte-for-byte equal.
+
+typedef enum {
+    CSV_VALUE_RAW,      // raw ADC code, signed (#158/#270)
+    CSV_VALUE_MV,       // integer millivolts (precision 0)
+    CSV_VALUE_FIXED,    // volts, 1..FIXEDFMT_MAX_PRECISION decimals (#250)
+    CSV_VALUE_COUNT
+} CsvValueMode;
+
+// Worst-case field widths. A clamped int32 is at most 11 characters. A
+// fixedfmt value has |v| < FIXEDFMT_MAX_ABS (1e9), which rounding can carry
+// to 10 integer digits, plus sign, point and the decimals.
+#define CSV_TS_MAX          10u
+#define CSV_INT_VALUE_MAX   11u
+#define CSV_FIXED_VALUE_MAX(prec) (12u + (unsigned)(prec))
+
+typedef struct {
+    CsvValueMode   mode;
+    bool           compact;
+    uint8_t        precision;
+    uint8_t        channelCount;     // mapping->count the plan was built for
+    const uint8_t* configIdx;        // mapping->configIndices
+    size_t         rowMax;           // worst-case row bytes, incl. DIO and '\n'
+    // MV / FIXED: per mapped channel, the conversion as fixed-point
+    // coefficients (millivolts for MV, 10^-precision V for FIXED).
+    FixedCalChannel cal[MAX_AIN_PUBLIC_CHANNELS];
+} CsvRowPlan;
+
+typedef size_t (*CsvRowWriter)(char* out, const AInPublicSampleList_t* ain,
+                               const DIOSample* dio, bool dioEnabled,
+                               const CsvRowPlan* plan);
+
+// Unchecked digit writers: the caller has reserved the room. Two digits per
+// divide, from a pair table, back to front into a scratch.
+static const char kCsvDigitPairs[200] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static inline char* csv_put_u32(char* p, uint32_t value) {
+    char temp[MAX_UINT32_STR_LEN];
+    char* t = temp + sizeof(temp);
+    while (value >= 100u) {
+        uint32_t pair = (value % 100u) * 2u;
+        value /= 100u;
+        *--t = kCsvDigitPairs[pair + 1u];
+        *--t = kCsvDigitPairs[pair];
+    }
+    if (value >= 10u) {
+        *--t = kCsvDigitPairs[value * 2u + 1u];
+        *--t = kCsvDigitPairs[value * 2u];
+    } else {
+        *--t = (char)('0' + value);
+    }
+    size_t len = (size_t)(temp + sizeof(temp) - t);
+    memcpy(p, t, len);
+    return p + len;
+}
+
+static inline char* csv_put_i32(char* p, int32_t value) {
+    if (value < 0) {
+        *p++ = '-';
+        return csv_put_u32(p, 0u - (uint32_t)value);   // INT_MIN safe
+    }
+    return csv_put_u32(p, (uint32_t)value);
+}
+
+/* One row, same bytes as tryWriteRow. `mode` and `compact` are compile-time
+ * constants in every instantiation below; everything that depends on them
+ * folds away. Returns 0 only when a fixed-point value needs the snprintf
+ * fallback, leaving the row to tryWriteRow. */
+static inline __attribute__((always_inline)) size_t csv_row_emit(
+        char* out, const AInPublicSampleList_t* ain, const DIOSample* dio,
+        bool dioEnabled, const CsvRowPlan* plan,
+        const CsvValueMode mode, const bool compact) {
+    char* q = out;
+    bool firstField = true;
+
+    uint8_t chCount = plan->channelCount;
+    uint32_t validMask = 0;
+    char ts[CSV_TS_MAX];
+    size_t tsLen = 0;
+    if (ain != NULL) {
+        if (ain->channelCount < chCount) {
+            chCount = (uint8_t)ain->channelCount;
+        }
+        validMask = ain->validMask;
+        // Every channel of the set shares this timestamp (#115): format it
+        // once, copy it per channel in the full layout.
+        tsLen = (size_t)(csv_put_u32(ts, ain->Timestamp) - ts);
+    }
+
+    if (compact) {
+        memcpy(q, ts, tsLen);
+        q += tsLen;
+        firstField = false;
+    }
+
+    for (uint8_t j = 0; j < chCount; j++) {
+        if (!firstField) {
+            *q++ = ',';
+        }
+        firstField = false;
+        if (!(validMask & (1U << j))) {
+            if (!compact) {
+                *q++ = ',';
+            }
+            continue;
+        }
+        if (!compact) {
+            memcpy(q, ts, tsLen);
+            q += tsLen;
+            *q++ = ',';
+        }
+        if (mode == CSV_VALUE_RAW) {
+            q = csv_put_i32(q, (int32_t)ain->Values[j]);
+        } else {
+            // Integer conversion first; the double path below only for a
+            // value it cannot decide (FixedPointCal.h).
+            uint64_t scaled;
+            bool neg;
+            bool exact = plan->cal[j].valid &&
+                    fixedcal_scaled(&plan->cal[j], ain->Values[j], &scaled, &neg);
+            if (mode == CSV_VALUE_MV) {
+                int32_t mv;
+                if (exact) {
+                    mv = neg ? -(int32_t)scaled : (int32_t)scaled;
+                } else {
+                    double voltage_mv = ADC_ConvertToVoltageByIndex(
+                        plan->configIdx[j], ain->Values[j]) * 1000.0;
+                    if (voltage_mv > (double)INT32_MAX) {
+                        mv = INT32_MAX;
+                    } else if (voltage_mv < (double)INT32_MIN) {
+                        mv = INT32_MIN;
+                    } else {
+                        mv = (int32_t)(voltage_mv >= 0.0 ? voltage_mv + 0.5 : voltage_mv - 0.5);
+                    }
+                }
+                q = csv_put_i32(q, mv);
+            } else if (exact) {
+                q = fixedfmt_scaled_to_str(scaled, neg, plan->precision, q,
+                                           CSV_FIXED_VALUE_MAX(plan->precision));
+            } else {
+                double voltage_v = ADC_ConvertToVoltageByIndex(
+                    plan->configIdx[j], ain->Values[j]);
+                if (!fixedfmt_can_format(voltage_v, plan->precision)) {
+                    return 0;
+                }
+                q = fixedfmt_to_str(voltage_v, plan->precision, q,
+                                    CSV_FIXED_VALUE_MAX(plan->precision));
+            }
+            if (q == NULL) {
+                return 0;
+            }
+        }
+    }
+
+    if (dioEnabled) {
+        if (dio != NULL) {
+            if (!firstField) {
+                *q++ = ',';
+            }
+            q = csv_put_u32(q, dio->Timestamp);
+            *q++ = ',';
+            q = csv_put_u32(q, dio->Values);
+        } else {
+            if (!firstField) {
+                *q++ = ',';
+            }
+            *q++ = ',';
+        }
+    }
+
+    *q++ = '\n';
+    return (size_t)(q - out);
+}
+
+// (name, value format, compact) for every specialized writer.
+#define CSV_ROW_WRITERS(X)                           \
+    X(RawFull,      CSV_VALUE_RAW,   false)          \
+    X(RawCompact,   CSV_VALUE_RAW,   true)           \
+    X(MvFull,       CSV_VALUE_MV,    false)          \
+    X(MvCompact,    CSV_VALUE_MV,    true)           \
+    X(FixedFull,    CSV_VALUE_FIXED, false)          \
+    X(FixedCompact, CSV_VALUE_FIXED, true)
+
+#define CSV_DEFINE_ROW_WRITER(name, mode, compact)                            \
+    static size_t csvRow##name(char* out, const AInPublicSampleList_t* ain,  \
+                               const DIOSample* dio, bool dioEnabled,        \
+                               const CsvRowPlan* plan) {                     \
+        return csv_row_emit(out, ain, dio, dioEnabled, plan, (mode), (compact)); \
+    }
+CSV_ROW_WRITERS(CSV_DEFINE_ROW_WRITER)
+
+#define CSV_ROW_WRITER_ENTRY(name, mode, compact) [(mode)][(compact) ? 1 : 0] = csvRow##name,
+static const CsvRowWriter kCsvRowWriters[CSV_VALUE_COUNT][2] = {
+    CSV_ROW_WRITERS(CSV_ROW_WRITER_ENTRY)
+};
+
+// Session row plan: chosen by csv_SelectRowWriter at START, re-checked once
+// per csv_Encode call so a mid-session precision / raw-mode change still
+// takes effect on the next batch, exactly as it did with tryWriteRow alone.
+static struct {
+    bool         specialized;  // false: always use tryWriteRow
+    bool         valid;
+    uint8_t      precision;    // key the plan was built from
+    bool         rawMode;
+    CsvRowPlan   plan;
+    CsvRowWriter write;        // NULL: no writer for this configuration
+    ADC_LinearConversion calSrc[MAX_AIN_PUBLIC_CHANNELS];  // plan.cal built from
+} gCsvRow;
+
+// (Re)builds plan.cal for the channels whose conversion differs from the one
+// their entry was built from. Calibration and range are not locked while
+// streaming, so csv_Encode calls this once per batch; on an unchanged
+// configuration it is one small read and compare per channel.
+static void csv_RefreshCalTable(bool force) {
+    CsvRowPlan* plan = &gCsvRow.plan;
+    unsigned precision = (plan->mode == CSV_VALUE_MV) ? 3u : plan->precision;
+
+    for (uint8_t j = 0; j < plan->channelCount; j++) {
+        ADC_LinearConversion lin;
+        memset(&lin, 0, sizeof(lin));   // padding too: compared with memcmp
+        if (!ADC_GetLinearConversionByIndex(plan->configIdx[j], &lin)) {
+            memset(&lin, 0, sizeof(lin));   // CodeMax 0: prepare declines
+        }
+        if (!force && memcmp(&lin, &gCsvRow.calSrc[j], sizeof(lin)) == 0) {
+            continue;
+        }
+        gCsvRow.calSrc[j] = lin;
+        fixedcal_prepare(&plan->cal[j], lin.Gain, lin.Offset, lin.CodeMax,
+                         lin.SignBits,
+                         ADC_ConvertToVoltageByIndex(plan->configIdx[j], 0u),
+                         precision);
+        // The millivolt column is an int32; leave anything wider to the
+        // double path's clamp.
+        if (plan->mode == CSV_VALUE_MV && plan->cal[j].scaledMax > INT32_MAX) {
+            plan->cal[j].valid = false;
+        }
+    }
+}
+
+static void csv_BuildRowPlan(uint8_t voltagePrecision, bool rawMode, bool compact) {
+    const AInChannelMapping* mapping = Streaming_GetChannelMapping();
+
+    gCsvRow.valid = true;
+    gCsvRow.precision = voltagePrecision;
+    gCsvRow.rawMode = rawMode;
+    gCsvRow.plan.compact = compact;
+    gCsvRow.plan.precision = voltagePrecision;
+    gCsvRow.plan.channelCount = mapping->count;
+    gCsvRow.plan.configIdx = mapping->configIndices;
+    gCsvRow.write = NULL;
+
+    size_t valueMax;
+    if (rawMode) {
+        gCsvRow.plan.mode = CSV_VALUE_RAW;
+        valueMax = CSV_INT_VALUE_MAX;
+    } else if (voltagePrecision == 0) {
+        gCsvRow.plan.mode = CSV_VALUE_MV;
+        valueMax = CSV_INT_VALUE_MAX;
+    } else if (voltagePrecision <= FIXEDFMT_MAX_PRECISION) {
+        gCsvRow.plan.mode = CSV_VALUE_FIXED;
+        valueMax = CSV_FIXED_VALUE_MAX(voltagePrecision);
+    } else {
+        return;   // snprintf-only precision: tryWriteRow
+    }
+
+    size_t perChannel = compact ? 1u + valueMax : 1u + CSV_TS_MAX + 1u + valueMax;
+    gCsvRow.plan.rowMax = (compact ? CSV_TS_MAX : 0u)
+                        + (size_t)mapping->count * perChannel
+                        + 1u + CSV_TS_MAX + 1u + CSV_TS_MAX    // DIO ts,val
+                        + 1u;                                   // '\n'
+    if (gCsvRow.specialized) {
+        gCsvRow.write = kCsvRowWriters[gCsvRow.plan.mode][compact ? 1 : 0];
+        if (gCsvRow.plan.mode != CSV_VALUE_RAW) {
+            csv_RefreshCalTable(true);
+        }
+    }
+}
+
+void csv_SelectRowWriter(bool specialized) {
+    StreamingRuntimeConfig *pStreamCfg = BoardRunTimeConfig_Get(
+            BOARDRUNTIME_STREAMING_CONFIGURATION);
+    gCsvRow.specialized = specialized;
+    gCsvRow.valid = false;
+    if (pStreamCfg != NULL) {
+        csv_BuildRowPlan(pStreamCfg->VoltagePrecision, pStreamCfg->RawOutputMode,
+                         pStreamCfg->Encoding == Streaming_CsvCompact);
+    }
+}
+
 
 /**
  * @brief Main CSV encoder - encodes all available samples into buffer.
@@ -628,13 +936,42 @@ size_t csv_Encode(
         csvHeaderSent = true;
     }
 
+    bool rawMode = (pStreamCfg != NULL) ? pStreamCfg->RawOutputMode : false;
+
+    // The writer chosen at START, unless the settings it was built from have
+    // changed since (or it was never built).
+    if (!gCsvRow.valid || gCsvRow.precision != voltagePrecision ||
+        gCsvRow.rawMode != rawMode || gCsvRow.plan.compact != compact ||
+        gCsvRow.plan.channelCount != Streaming_GetChannelMapping()->count) {
+        csv_BuildRowPlan(voltagePrecision, rawMode, compact);
+    } else if (gCsvRow.write != NULL && gCsvRow.plan.mode != CSV_VALUE_RAW) {
+        csv_RefreshCalTable(false);
+    }
+    const CsvRowWriter writeRow = gCsvRow.write;
+    const CsvRowPlan* plan = &gCsvRow.plan;
+
     while (1) {
         bool hadAIN, hadDIO;
-        // attempt to write the next row in-place
-        bool rawMode = (pStreamCfg != NULL) ? pStreamCfg->RawOutputMode : false;
-        size_t rowLen = tryWriteRow(p, rem, state, channelConfig, dioEnabled, &hadAIN, &hadDIO, voltagePrecision, rawMode, compact);
-        if (rowLen == 0 || rowLen > rem) {
-            break;  // no data left or row won?t fit
+        size_t rowLen = 0;
+
+        // Worst-case row of room: the specialized writer, no per-field checks.
+        if (writeRow != NULL && rem >= plan->rowMax) {
+            AInPublicSampleList_t *ainPeek = NULL;
+            DIOSample dioPeek;
+            hadAIN = AInSampleList_PeekFront(&ainPeek);
+            hadDIO = DIOSampleList_PeekFront(&state->DIOSamples, &dioPeek);
+            if (!hadAIN && !hadDIO) {
+                break;  // no data left
+            }
+            rowLen = writeRow(p, hadAIN ? ainPeek : NULL, hadDIO ? &dioPeek : NULL,
+                              dioEnabled, plan);
+        }
+        if (rowLen == 0) {
+            // attempt to write the next row in-place
+            rowLen = tryWriteRow(p, rem, state, channelConfig, dioEnabled, &hadAIN, &hadDIO, voltagePrecision, rawMode, compact);
+            if (rowLen == 0 || rowLen > rem) {
+                break;  // no data left or row won?t fit
+            }
         }
 
         // now that it?s safely written, consume the queues:
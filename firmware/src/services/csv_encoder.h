@@ -40,6 +40,16 @@ bool csv_IsHeaderSent(void);
  */
 size_t csv_GenerateHeaderToBuffer(char* buffer, size_t size);
 
+/*!
+ * Select the session's data-row writer from the current encoding, voltage
+ * precision, raw mode and channel mapping. Called at SYSTem:STReam:START;
+ * csv_Encode re-selects by itself if any of those change mid-session.
+ * @param specialized  true: compile-time specialized writers where one
+ *                     applies; false: the generic per-field-checked writer
+ *                     only (the byte-for-byte reference)
+ */
+void csv_SelectRowWriter(bool specialized);
+
 #ifdef	__cplusplus
 }
 #endif
@@ -10,6 +10,11 @@
 #include "sd_card_manager.h"
 #include "services/UsbCdc/UsbCdc.h"
 #include "Util/CRC32.h"   /* #306 */
+#include "Util/SdWriteSlots.h"
+#include "Util/SdPartCache.h"
+#include "Util/SdBucket.h"
+#include "Util/SdLogContainer.h"
+#include "Util/SdReadPump.h"
 #include "services/streaming.h"  // For Streaming_ResetSdFileHeader on file rotation
 #include <stddef.h>
 #include "ff.h"   /* #810: FILINFO, for the layout assert below */
@@ -108,6 +113,11 @@ _Static_assert(offsetof(SYS_FS_FSTAT, lfname) >= sizeof(FILINFO),
  * more than the time it saves (see the fileCounter==0 branch for the three
  * ways the stale one went wrong). */
 #define SD_CARD_MANAGER_BUCKET_ADVANCE_MAX (SD_CARD_MANAGER_MAX_BUCKET + 1u)
+/* Pre-create the next split part once the current one holds 1/DIVISOR of
+ * SD:MAXSize (see SD_PrecreateNextLogFile). Late enough that a stop rarely
+ * leaves an unused part behind, early enough that the pre-create's own stall
+ * has half a file of buffer time to recover in before the rotation. */
+#define SD_CARD_MANAGER_PRECREATE_DIVISOR  2u
 /* #780: how long the pumped wait blocks between USB write pumps. Small enough
  * that a filling circular buffer is serviced promptly, large enough that the
  * wait is not a busy-spin against the SD task.
@@ -217,6 +227,18 @@ static volatile bool gTransferAbortRequested = false;
  * PIC32MZ; volatile is here because the two contexts differ, not to imply
  * read-modify-write safety. */
 static volatile bool gSdRotating = false;
+
+/* Container-mode writer (SD:CONTainer, Util/SdLogContainer.h). Blocks are cut
+ * as bytes enter the write ring, so everything below is touched only under
+ * gSDCardData.wMutex: the streaming task appends through WriteToBuffer(), the
+ * SD task seals (rotation, unmount) and restarts (resets). gSdLogActive is
+ * latched from the setting when a session opens its first file. The staged
+ * mark is producer-only (see sd_card_manager_StageWriteMark). */
+static SdLogWriter_t gSdLog;
+static bool gSdLogActive = false;
+static SdLogMark_t gSdLogMark;
+static bool gSdLogMarkSet = false;
+
 static int gFormatStatus = 0;  // 0=idle, 1=in progress, 2=success, -1=failed
 static uint32_t gFormatSectorsEstimate = 0;  // Estimated total sectors written during format
 
@@ -260,6 +282,19 @@ typedef enum {
     SD_CARD_MANAGER_PROCESS_STATE_ERROR,
 } sd_card_manager_processState_t;
 
+/* A log file closed by this session, keyed by a CRC32 of its path. Size and
+ * FAT timestamp are checked against the directory entry before the stored CRC
+ * is used, so a file rewritten or replaced since (another card, a PC edit)
+ * falls back to reading it. 16 B each. */
+#define SD_CLOSED_CRC_SLOTS 8u
+typedef struct {
+    uint32_t pathKey;         /* 0 = empty slot */
+    uint32_t crc;             /* finalized */
+    uint32_t size;
+    uint16_t fdate;
+    uint16_t ftime;
+} SdClosedCrc_t;
+
 typedef struct {
     sd_card_manager_processState_t currentProcessState;
     /** Control message buffer (for EOF marker, error messages) */
@@ -297,6 +332,17 @@ typedef struct {
     uint32_t fileCounter;        // Current file number (1, 2, 3, ...)
     uint64_t currentFileBytes;   // Bytes written to current file
     bool fileSplittingEnabled;   // True if maxFileSizeBytes > 0
+    bool fileReserved;           // Current log file holds a preallocated extent
+    /* The next split part, opened (and reserved) while the current one is
+     * still being written; the rotation adopts it. nextFileKey is the
+     * SD_ClosedCrcKey of its path, which is not kept: it is rebuilt from the
+     * bucket and counter, and the key proves the rebuild names the same file. */
+    SYS_FS_HANDLE nextFileHandle;
+    uint32_t nextFileCounter;
+    uint32_t nextFileBucket;
+    uint32_t nextFileKey;
+    bool nextFileReserved;
+    bool nextFileTried;          // one pre-create attempt per part
 
     // Operation result tracking
     bool lastOperationSuccess;   // Result of last completed operation
@@ -310,6 +356,20 @@ typedef struct {
     uint32_t crcResult;
     uint64_t crcLength;
     uint32_t crcRunning;      /* streaming accumulator (task-only access) */
+    /* CRC of the log file being written, folded in as each chunk reaches the
+     * card (SD_AccountWritten), and the last few closed files' results -- a
+     * CRC request for one of those is answered without reading it back. */
+    uint32_t writeCrcRunning;
+    SdClosedCrc_t closedCrc[SD_CLOSED_CRC_SLOTS];
+    uint8_t closedCrcNext;
+
+    /* Steady-state log writes: writeBuffer carved into slots that
+     * sd_card_manager_WriterTask puts on the card while the next chunk is
+     * staged. writeSubmitSem wakes the writer; writeDoneSem is given for
+     * every slot it completes. */
+    SdWriteSlots_t writeSlots;
+    SemaphoreHandle_t writeSubmitSem;
+    SemaphoreHandle_t writeDoneSem;
 
     // Space query result (populated by GET_SPACE mode)
     uint64_t spaceResultFreeBytes;
@@ -340,25 +400,44 @@ typedef struct {
      * the flag above (SD task pri 5 writer, SCPI pri 7/2 readers); a 32-bit
      * enum load/store is atomic on PIC32MZ, so no critical section is needed. */
     volatile SdWriteRefuseReason writeRefuseReason;
-    // #689: bucketing state. curBucket is the subdirectory index currently
-    // being filled (0 == the configured directory itself); bucketPath is its
-    // full path, rebuilt only when the bucket changes. bucketFileCountAtStart
-    // is the pre-existing occupancy of that bucket, counted ONCE when we enter
-    // it, and filesInCurBucket counts what this session has added since — so
-    // the fullness test costs no per-rotation re-scan.
-    uint32_t curBucket;
-    uint32_t bucketFileCountAtStart;
-    uint32_t filesInCurBucket;
+    // #689: bucketing state (Util/SdBucket.h). bucket.cur is the subdirectory
+    // index currently being filled (0 == the configured directory itself);
+    // bucketPath is its full path, rebuilt only when the bucket changes. The
+    // bucket's pre-existing occupancy is counted ONCE when we enter it and
+    // what this session adds is counted on top -- so the fullness test costs
+    // no per-rotation re-scan -- and the same walk notes which parts of this
+    // log it holds, which answers the OPEN_FILE part search without a stat in
+    // the common case.
+    SdBucket_t bucket;
     char bucketPath[SD_CARD_MANAGER_FILE_PATH_LEN_MAX + 1];
 } sd_card_manager_context_t;
 
 sd_card_manager_context_t gSDCardData;
 sd_card_manager_settings_t *gpSDCardSettings;
 
+/* SdLogWriter sink: the ring. Callers hold wMutex and have checked
+ * SdLogWriter_Cost() against the free space, so this always fits. */
+static void sd_LogSink(void* ctx, const uint8_t* data, size_t len) {
+    (void)ctx;
+    CircularBuf_AddBytes(&gSDCardData.wCirbuf, (uint8_t*)data, len);
+}
+
+/* Seal the container file being written: pad the open block and append the
+ * index. Caller holds wMutex; the bytes go out with the rest of the ring. */
+static void sd_LogSeal(void) {
+    if (gSdLogActive) {
+        SdLogWriter_Finish(&gSdLog, sd_LogSink, NULL);
+    }
+}
+
 void __attribute__((weak)) sd_card_manager_DataReadyCB(sd_card_manager_mode_t mode, uint8_t *pDataBuff, size_t dataLen) {
 
 }
 
+size_t __attribute__((weak)) sd_card_manager_DataReadyTryCB(sd_card_manager_mode_t mode, const uint8_t *pDataBuff, size_t dataLen) {
+    return dataLen;
+}
+
 static int SDCardWrite() {
     int writeLen = -1;
     if (gSDCardData.fileHandle == SYS_FS_HANDLE_INVALID) {
@@ -387,6 +466,285 @@ static int CircularBufferToSDWrite(uint8_t* buf, uint32_t len) {
     return len;
 }
 
+/* Account `n` bytes at `p` that just reached the card. Only what reached
+ * the card is folded, so the running CRC is the CRC of the file as written. */
+static void SD_AccountWrittenFrom(const uint8_t* p, uint32_t n) {
+    gSDCardData.writeCrcRunning = CRC32_Update(gSDCardData.writeCrcRunning, p, n);
+    gSDCardData.currentFileBytes += n;
+}
+
+/* The same for SDCardWrite() and the pending chunk. Called before the chunk
+ * offset advances, so the bytes are still at writeBuffer +
+ * sdCardWriteBufferOffset. */
+static void SD_AccountWritten(uint32_t n) {
+    SD_AccountWrittenFrom(gSDCardData.writeBuffer + gSDCardData.sdCardWriteBufferOffset, n);
+}
+
+static uint32_t SD_ClosedCrcKey(const char* path) {
+    uint32_t key = CRC32_Compute(path, strlen(path));
+    return (key != 0u) ? key : 1u;
+}
+
+static void SD_ForgetClosedCrc(const char* path) {
+    uint32_t key = SD_ClosedCrcKey(path);
+    for (uint32_t i = 0; i < SD_CLOSED_CRC_SLOTS; i++) {
+        if (gSDCardData.closedCrc[i].pathKey == key) {
+            gSDCardData.closedCrc[i].pathKey = 0u;
+        }
+    }
+}
+
+/* The write file (filePath) was just closed cleanly: keep its CRC. Not kept
+ * if the directory entry disagrees with what was accounted -- a write the
+ * driver reported as failed may still have landed partly. */
+static void SD_RecordClosedCrc(void) {
+    SYS_FS_FSTAT st;
+    SD_ForgetClosedCrc(gSDCardData.filePath);
+    if (SYS_FS_FileStat(gSDCardData.filePath, &st) != SYS_FS_RES_SUCCESS ||
+        (uint64_t)st.fsize != gSDCardData.currentFileBytes) {
+        return;
+    }
+    SdClosedCrc_t* e = &gSDCardData.closedCrc[gSDCardData.closedCrcNext];
+    gSDCardData.closedCrcNext =
+            (uint8_t)((gSDCardData.closedCrcNext + 1u) % SD_CLOSED_CRC_SLOTS);
+    e->pathKey = SD_ClosedCrcKey(gSDCardData.filePath);
+    e->crc = CRC32_Finalize(gSDCardData.writeCrcRunning);
+    e->size = (uint32_t)st.fsize;
+    e->fdate = st.fdate;
+    e->ftime = st.ftime;
+}
+
+/* SD:CRC fast path: the stored CRC of `path` if this session wrote and closed
+ * it and its directory entry still matches. */
+static bool SD_LookupClosedCrc(const char* path, uint32_t* pCrc, uint32_t* pSize) {
+    uint32_t key = SD_ClosedCrcKey(path);
+    for (uint32_t i = 0; i < SD_CLOSED_CRC_SLOTS; i++) {
+        const SdClosedCrc_t* e = &gSDCardData.closedCrc[i];
+        if (e->pathKey != key) {
+            continue;
+        }
+        SYS_FS_FSTAT st;
+        if (SYS_FS_FileStat(path, &st) != SYS_FS_RES_SUCCESS ||
+            st.fsize != e->size || st.fdate != e->fdate || st.ftime != e->ftime) {
+            return false;
+        }
+        *pCrc = e->crc;
+        *pSize = e->size;
+        return true;
+    }
+    return false;
+}
+
+/* --- Ping-pong log writes ---------------------------------------------------
+ *
+ * The steady-state WRITE_TO_FILE loop used to extract a chunk into writeBuffer
+ * and block in SDCardWrite() until the card had it, so nothing left wCirbuf
+ * while the SPI DMA ran. writeBuffer is now carved into
+ * SD_CARD_MANAGER_WRITE_SLOTS sector-multiple slots (Util/SdWriteSlots.h):
+ * this task stages the next chunk into a free slot while
+ * sd_card_manager_WriterTask writes the previous one.
+ *
+ * Harmony's SYS_FS_FileWrite is synchronous and FatFs is built with
+ * FF_FS_REENTRANT 0, so only one task may be inside it at a time. While any
+ * slot is in flight the writer owns the file system; everything else this
+ * state machine does with it -- sync, close, rotation, unmount, any other
+ * mode -- goes through SD_WriteSlotsBarrier() first. The rotation and unmount
+ * drains keep writing synchronously from the whole writeBuffer, which is free
+ * again once the barrier returns. */
+
+static void SD_TrackSlot(uint32_t writes, uint32_t overlapStages, uint32_t barrierWaits);
+static void SD_TrackPrealloc(uint32_t files, uint32_t fallbacks);
+static void SD_TrackRotation(uint32_t precreated, uint32_t inlined);
+
+static int SD_SlotWrite(void* ctx, const uint8_t* data, uint32_t len) {
+    TickType_t startTick = xTaskGetTickCount();
+    int writeLen = SYS_FS_FileWrite(*(SYS_FS_HANDLE*) ctx, (const void *) data, len);
+    SD_CheckFsOpDuration(startTick, "FileWrite", writeLen);
+    return writeLen;
+}
+
+/* Account every chunk the writer has finished, in order. A short one means the
+ * write failed, and the writer completes every chunk behind it unwritten: all
+ * of those bytes already left wCirbuf and never reached the card, so they are
+ * reported like the #825 drain losses. Returns false if any chunk failed. */
+static bool SD_WriteSlotsReap(void) {
+    bool ok = true;
+    const SdWriteSlot_t* s;
+    while ((s = SdWriteSlots_Reap(&gSDCardData.writeSlots)) != NULL) {
+        if (s->done > 0u) {
+            SD_AccountWrittenFrom(s->data, s->done);
+        }
+        if (s->done < s->len) {
+            if (ok) {
+                LOG_E("[SD] Error writing to SD Card (%u of %u bytes)",
+                      (unsigned) s->done, (unsigned) s->len);
+            }
+            Streaming_ReportSdDiscard(s->len - s->done);
+            ok = false;
+        }
+        SdWriteSlots_Release(&gSDCardData.writeSlots);
+        SD_TrackSlot(1u, 0u, 0u);
+    }
+    return ok;
+}
+
+/* Wait for the writer to finish every submitted chunk, then account them.
+ * Afterwards the file system and the whole writeBuffer belong to this task. */
+static bool SD_WriteSlotsBarrier(void) {
+    if (SdWriteSlots_Outstanding(&gSDCardData.writeSlots) == 0u) {
+        return true;
+    }
+    if (SdWriteSlots_InFlight(&gSDCardData.writeSlots) > 0u) {
+        SD_TrackSlot(0u, 0u, 1u);
+        while (SdWriteSlots_InFlight(&gSDCardData.writeSlots) > 0u) {
+            /* Not bounded: returning with a write in flight would put two
+             * tasks in FatFs. The driver's own timeouts end a wedged write. */
+            if (xSemaphoreTake(gSDCardData.writeDoneSem, pdMS_TO_TICKS(1000)) != pdTRUE) {
+                LOG_E("[SD] waiting on the log writer (%u chunks in flight)",
+                      (unsigned) SdWriteSlots_InFlight(&gSDCardData.writeSlots));
+            }
+        }
+    }
+    return SD_WriteSlotsReap();
+}
+
+/* One WRITE_TO_FILE pass: reap, then stage up to
+ * SD_CARD_MANAGER_MAX_CHUNKS_PER_CYCLE sector-aligned chunks into free slots,
+ * handing each to the writer as soon as it is copied. Returns without waiting
+ * once every slot is outstanding -- the writer keeps the card busy with the
+ * one queued behind the transfer in progress. Sets ERROR if a write failed. */
+static void SD_WriteSlotsPump(void) {
+    SdWriteSlots_t* slots = &gSDCardData.writeSlots;
+    if (!SD_WriteSlotsReap()) {
+        gSDCardData.currentProcessState = SD_CARD_MANAGER_PROCESS_STATE_ERROR;
+        return;
+    }
+
+    /* #738: carve what auto-balance actually assigned (writeBufferSize), not
+     * the compile-time ceiling. Re-carved only while nothing is outstanding,
+     * so a slot never moves under the writer; read under wMutex, which
+     * sd_card_manager_SetWriteBuffer takes to change it. */
+    if (SdWriteSlots_Outstanding(slots) == 0u) {
+        SD_TakeMutexDebug(gSDCardData.wMutex, "write_slots_carve");
+        if (slots->buf != gSDCardData.writeBuffer
+                || slots->bufSize != gSDCardData.writeBufferSize
+                || slots->count == 0u || slots->failed) {
+            if (!SdWriteSlots_Init(slots, gSDCardData.writeBuffer,
+                    gSDCardData.writeBufferSize, SD_CARD_MANAGER_WRITE_SLOTS,
+                    SD_SECTOR_SIZE_BYTES)) {
+                /* Unreachable with the 512-byte floor; see Qodo #748. */
+                LOG_E_ONCE(LOG_ONCE_SD_WBUF_SUBSECTOR,
+                           "[SD] write buffer below one sector - drain stalled");
+            }
+        }
+        xSemaphoreGive(gSDCardData.wMutex);
+    }
+
+    for (int chunks = 0; chunks < SD_CARD_MANAGER_MAX_CHUNKS_PER_CYCLE; chunks++) {
+        uint32_t cap;
+        uint8_t* dst = SdWriteSlots_Acquire(slots, &cap);
+        if (dst == NULL) {
+            break;
+        }
+        SD_TakeMutexDebug(gSDCardData.wMutex, "write_slots_stage");
+        uint32_t availBytes = CircularBuf_NumBytesAvailable(&gSDCardData.wCirbuf);
+        uint32_t extract = (availBytes < cap) ? availBytes : cap;
+        extract = (extract / SD_SECTOR_SIZE_BYTES) * SD_SECTOR_SIZE_BYTES;
+        if (extract == 0u) {
+            xSemaphoreGive(gSDCardData.wMutex);
+            break;
+        }
+        int err;
+        extract = CircularBuf_ProcessBytes(&gSDCardData.wCirbuf, dst, extract, &err);
+        gSDCardData.totalBytesFlushPending += extract;
+        xSemaphoreGive(gSDCardData.wMutex);
+
+        bool overlapped = SdWriteSlots_InFlight(slots) > 0u;
+        SdWriteSlots_Submit(slots, extract);
+        xSemaphoreGive(gSDCardData.writeSubmitSem);
+        if (overlapped) {
+            SD_TrackSlot(0u, 1u, 0u);
+        }
+    }
+}
+
+void sd_card_manager_WriterTask(void) {
+    while (gSDCardData.writeSubmitSem == NULL || gSDCardData.writeDoneSem == NULL) {
+        vTaskDelay(pdMS_TO_TICKS(100));     /* sd_card_manager_Init not run yet */
+    }
+    for (;;) {
+        xSemaphoreTake(gSDCardData.writeSubmitSem, portMAX_DELAY);
+        while (SdWriteSlots_Service(&gSDCardData.writeSlots, SD_SlotWrite,
+                                    &gSDCardData.fileHandle)) {
+            xSemaphoreGive(gSDCardData.writeDoneSem);
+        }
+    }
+}
+
+/* --- Preallocated log files -------------------------------------------------
+ *
+ * A log file that grows cluster by cluster walks the FAT for every new
+ * cluster and leaves a dirty FAT sector behind for the next sync to write to
+ * both FATs -- FS traffic interleaved with the stream, and the scattered
+ * small writes SD cards answer with internal GC stalls. With SD:PREALLoc set,
+ * OPEN_FILE reserves the extent as one contiguous chain up front
+ * (SYS_FS_FileReserve, fat_fs/file_system/ffprealloc.h): the stream then
+ * lands on consecutive sectors and no FAT sector is written until the file
+ * is closed. The file keeps its real size throughout, so a sync (or a power
+ * cut) never exposes the unwritten extent as data.
+ *
+ * Every close of a log file gives the unwritten tail back first. The reserve
+ * costs a FAT scan over the extent; for split parts it runs when the part is
+ * pre-created, ahead of the rotation, but the first file's runs at session
+ * start, so the extent should still be sized to the stream rather than a
+ * blanket 3.9 GB. */
+
+/* Reserve the configured extent for the log file just opened as `h` (`path`
+ * is for the log). Returns whether it now holds one. */
+static bool SD_ReserveLogFile(SYS_FS_HANDLE h, const char* path) {
+    uint64_t extent = gpSDCardSettings->preallocBytes;
+    if (extent == 0u || h == SYS_FS_HANDLE_INVALID) {
+        return false;
+    }
+    if (gSDCardData.fileSplittingEnabled
+            && extent > gpSDCardSettings->maxFileSizeBytes) {
+        extent = gpSDCardSettings->maxFileSizeBytes;
+    }
+    TickType_t startTick = xTaskGetTickCount();
+    SYS_FS_RESULT res = SYS_FS_FileReserve(h, (uint32_t)extent);
+    SD_CheckFsOpDuration(startTick, "FileReserve", (int)res);
+    if (res == SYS_FS_RES_SUCCESS) {
+        SD_TrackPrealloc(1u, 0u);
+        return true;
+    }
+    /* Not fatal: the file just grows the old way. FR_DENIED (no contiguous
+     * run that long) is the expected reason on a card with fragmented free
+     * space. */
+    LOG_I_SESSION(LOG_SESSION_SD_PREALLOC_DENIED,
+                  "[SD] %u-byte preallocation for '%s' refused (error=%d) - file grows normally",
+                  (unsigned)extent, path, (int)SYS_FS_FileError(h));
+    SD_TrackPrealloc(0u, 1u);
+    return false;
+}
+
+/* Before a log file's final sync and close: free the extent past what was
+ * written. The caller has already run the writer barrier. */
+static void SD_ReleaseLogFile(void) {
+    if (!gSDCardData.fileReserved) {
+        return;
+    }
+    gSDCardData.fileReserved = false;
+    TickType_t startTick = xTaskGetTickCount();
+    SYS_FS_RESULT res = SYS_FS_FileRelease(gSDCardData.fileHandle);
+    SD_CheckFsOpDuration(startTick, "FileRelease", (int)res);
+    if (res == SYS_FS_RES_FAILURE) {
+        /* The data is intact; the unwritten clusters stay chained to the
+         * file (beyond its size) until a chkdsk reclaims them. */
+        LOG_E("[SD] Failed to release preallocated space of '%s', error=%d",
+              gSDCardData.filePath, (int)SYS_FS_FileError(gSDCardData.fileHandle));
+    }
+}
+
 /* #689: count entries in a directory, early-exiting once `cap` is reached so the
  * O(N) directory scan cost is bounded to ~cap entries regardless of directory
  * size. Runs in the SD task, which owns the filesystem. "." / ".." are skipped.
@@ -396,12 +754,21 @@ static int CircularBufferToSDWrite(uint8_t* buf, uint32_t len) {
  * #689: `cap` is returned BOTH for "at least cap files" and for a real FS
  * error, so callers that act on fullness must be able to tell them apart —
  * rolling to a fresh bucket is right for a full directory and wrong for a
- * broken filesystem. pFsError (optional) reports which happened. */
+ * broken filesystem. pFsError (optional) reports which happened.
+ *
+ * pParts (optional) is handed every entry of the walk, to note the parts of
+ * the current log it holds; it is invalidated unless the walk reached the end
+ * of the directory. A bucket this session filled holds exactly cap entries, so
+ * a walk that reaches cap reads one entry more to see whether that is the end
+ * -- otherwise the cache would know nothing about any full bucket. */
 static uint32_t CountDirEntries(const char* dirPath, uint32_t cap,
-                                bool* pFsError) {
+                                bool* pFsError, SdPartCache_t* pParts) {
     if (pFsError != NULL) {
         *pFsError = false;
     }
+    if (pParts != NULL) {
+        SdPartCache_Init(pParts);
+    }
     SYS_FS_HANDLE dh = SYS_FS_DirOpen(dirPath);
     if (dh == SYS_FS_HANDLE_INVALID) {
         /* #690 review (Qodo): distinguish "directory doesn't exist yet" (the
@@ -417,6 +784,9 @@ static uint32_t CountDirEntries(const char* dirPath, uint32_t cap,
         if (pFsError != NULL) {
             *pFsError = true;
         }
+        if (pParts != NULL) {
+            SdPartCache_Invalidate(pParts);
+        }
         return cap;
     }
     uint32_t count = 0;
@@ -434,6 +804,9 @@ static uint32_t CountDirEntries(const char* dirPath, uint32_t cap,
             if (pFsError != NULL) {
                 *pFsError = true;
             }
+            if (pParts != NULL) {
+                SdPartCache_Invalidate(pParts);
+            }
             return cap;
         }
         if (st.fname[0] == '\0') {
@@ -442,8 +815,19 @@ static uint32_t CountDirEntries(const char* dirPath, uint32_t cap,
         if (strcmp(st.fname, ".") == 0 || strcmp(st.fname, "..") == 0) {
             continue;                       // skip dot entries
         }
+        /* A directory wearing a part's name is not a part -- the same
+         * distinction sd_TargetExistsInBucketPath draws. */
+        if (pParts != NULL && (st.fattrib & SYS_FS_ATTR_DIR) == 0) {
+            SdPartCache_Note(pParts, st.fname, gSDCardData.baseFilename,
+                             gpSDCardSettings->file);
+        }
         count++;
     }
+    if (count >= cap && pParts != NULL) {
+        if (SYS_FS_DirRead(dh, &st) == SYS_FS_RES_FAILURE || st.fname[0] != '\0') {
+            SdPartCache_Invalidate(pParts); // stopped short of the end
+        }
+    }
     (void)SYS_FS_DirClose(dh);
     return count;
 }
@@ -929,6 +1313,9 @@ bool sd_card_manager_Init(sd_card_manager_settings_t *pSettings) {
         gSDCardData.wMutex = xSemaphoreCreateMutex();
         xSemaphoreGive(gSDCardData.wMutex);
         gSDCardData.opCompleteSemaphore = xSemaphoreCreateBinary();
+        gSDCardData.writeSubmitSem = xSemaphoreCreateBinary();
+        gSDCardData.writeDoneSem = xSemaphoreCreateBinary();
+        memset(&gSDCardData.writeSlots, 0, sizeof(gSDCardData.writeSlots));
         gSDCardData.lastOperationSuccess = true;  // Initialize to success
 
         // Create operation mutex to serialize READ/WRITE/LIST on gSDSharedBuffer
@@ -945,6 +1332,14 @@ bool sd_card_manager_Init(sd_card_manager_settings_t *pSettings) {
         gSDCardData.fileCounter = 0;
         gSDCardData.currentFileBytes = 0;
         gSDCardData.fileSplittingEnabled = false;
+        gSDCardData.fileReserved = false;
+        gSDCardData.nextFileHandle = SYS_FS_HANDLE_INVALID;
+        gSDCardData.nextFileReserved = false;
+        gSDCardData.nextFileTried = false;
+        SdBucket_Init(&gSDCardData.bucket, SD_CARD_MANAGER_MAX_DIR_FILES,
+                      SD_CARD_MANAGER_MAX_BUCKET);
+        memset(gSDCardData.closedCrc, 0, sizeof(gSDCardData.closedCrc));
+        gSDCardData.closedCrcNext = 0;
     }
     return true;
 }
@@ -989,14 +1384,34 @@ static bool sd_BuildBucketPath(char* out, size_t outLen, const char* dir,
 
 
 
-/* #689: make `bucket` the active one — create its directory if needed and
- * count what it already holds, ONCE, so the per-rotation fullness test is
- * arithmetic rather than another O(N) scan.
+static bool sd_BucketDirExists(const char* bucketPath, bool* fsError);
+
+/* #689: SdBucketIo_t.enter -- make `bucket` the active one: create its
+ * directory if needed and count what it already holds, ONCE, so the
+ * per-rotation fullness test is arithmetic rather than another O(N) scan.
+ * SdBucket_Enter takes the count only on success; on failure bucketPath is
+ * put back to the bucket that stays active.
  *
  * An existing directory is success, not an error: buckets are reused across
  * sessions by design (the same base filename overwrites the same part names,
  * matching the pre-#689 single-directory behaviour). */
-static bool sd_EnterBucket(const char* dir, uint32_t bucket) {
+static bool sd_EnterBucketPath(const char* dir, uint32_t bucket, uint32_t* pCount,
+                               SdPartCache_t* pParts, bool* pNextExists);
+
+static bool sd_EnterBucket(void* ctx, uint32_t bucket, uint32_t* pCount,
+                           SdPartCache_t* pParts, bool* pNextExists) {
+    (void)ctx;
+    const char* dir = gpSDCardSettings->directory;
+    if (sd_EnterBucketPath(dir, bucket, pCount, pParts, pNextExists)) {
+        return true;
+    }
+    (void)sd_BuildBucketPath(gSDCardData.bucketPath, sizeof(gSDCardData.bucketPath),
+                             dir, gSDCardData.bucket.cur);
+    return false;
+}
+
+static bool sd_EnterBucketPath(const char* dir, uint32_t bucket, uint32_t* pCount,
+                               SdPartCache_t* pParts, bool* pNextExists) {
     if (!sd_BuildBucketPath(gSDCardData.bucketPath,
                             sizeof(gSDCardData.bucketPath), dir, bucket)) {
         /* Keep the invariant "refused => a reason is recorded". Without this the
@@ -1037,25 +1452,37 @@ static bool sd_EnterBucket(const char* dir, uint32_t bucket) {
             }
         }
     }
-    gSDCardData.curBucket = bucket;
     /* An FS error must NOT be read as "this bucket is full": that would roll us
      * forward, creating a spurious empty directory per attempt on a filesystem
      * that is already failing. Refuse instead -- the caller's clean stop is the
      * right answer for a broken card. */
     bool fsError = false;
-    gSDCardData.bucketFileCountAtStart =
-        CountDirEntries(gSDCardData.bucketPath, SD_CARD_MANAGER_MAX_DIR_FILES,
-                        &fsError);
+    *pCount = CountDirEntries(gSDCardData.bucketPath, SD_CARD_MANAGER_MAX_DIR_FILES,
+                              &fsError, pParts);
     if (fsError) {
         LOG_E("[SD] #689 bucket '%s' unreadable - refusing rather than rolling",
               gSDCardData.bucketPath);
         gSDCardData.writeRefuseReason = SD_REFUSE_BUCKET_UNREADABLE;
         return false;
     }
-    gSDCardData.filesInCurBucket = 0u;
+    /* Look up the next bucket once here, so the part search does not stat it
+     * on every open. Its path is built in bucketPath and put back after,
+     * rather than in another path-sized local on the SD task's stack. A stat
+     * that fails for any other reason than "not there" reads as present: the
+     * search then stats it itself and refuses on the error, as it always did. */
+    *pNextExists = false;
+    if (bucket < SD_CARD_MANAGER_MAX_BUCKET &&
+        sd_BuildBucketPath(gSDCardData.bucketPath, sizeof(gSDCardData.bucketPath),
+                           dir, bucket + 1u)) {
+        bool nextFsError = false;
+        *pNextExists =
+            sd_BucketDirExists(gSDCardData.bucketPath, &nextFsError) || nextFsError;
+    }
+    (void)sd_BuildBucketPath(gSDCardData.bucketPath, sizeof(gSDCardData.bucketPath),
+                             dir, bucket);
     gSDCardData.writeRefuseReason = SD_REFUSE_NONE;
     LOG_D("[SD] #689 bucket '%s' active (holds %u)\r\n", gSDCardData.bucketPath,
-          (unsigned)gSDCardData.bucketFileCountAtStart);
+          (unsigned)*pCount);
     return true;
 }
 
@@ -1155,7 +1582,8 @@ static bool sd_BucketDirExists(const char* bucketPath, bool* fsError) {
  * copy of a part that does exist, which is the one outcome this whole search
  * is here to prevent -- and it would do so silently, on a card that is telling
  * us it is unwell. */
-static bool sd_TargetExistsInBucketPath(const char* bucketPath, bool* fsError) {
+static bool sd_TargetExistsInBucketPath(const char* bucketPath, uint32_t counter,
+                                        bool* fsError) {
     *fsError = false;
     /* Scratch in gSDCardData.filePath rather than a ~511-byte stack local.
      * Two such buffers would otherwise live at once during the reuse pre-walk
@@ -1167,15 +1595,15 @@ static bool sd_TargetExistsInBucketPath(const char* bucketPath, bool* fsError) {
      *
      * Safe, and narrowly so -- keep it that way: filePath is memset at
      * OPEN_FILE entry, this function is called only from the WRITE branch's
-     * pre-walk, and the REAL path is written over it by generateFilename
-     * further down before anything reads it. Do not add a read of filePath
-     * between those two points. */
+     * part search (SdBucket_Place, through sd_BucketHoldsPart), and the REAL
+     * path is written over it by generateFilename further down before
+     * anything reads it. Do not add a read of filePath between those two
+     * points. */
     char* candidate = gSDCardData.filePath;
     /* sizeof(gSDCardData.filePath), NOT sizeof(candidate) -- candidate is a
      * pointer here, so sizeof would be 4 and generateFilename would reject
      * every path as too long. */
-    generateFilename(candidate, sizeof(gSDCardData.filePath),
-                     gSDCardData.fileCounter,
+    generateFilename(candidate, sizeof(gSDCardData.filePath), counter,
                      bucketPath, gSDCardData.baseFilename,
                      gpSDCardSettings->file);
     if (candidate[0] == '\0') {
@@ -1195,6 +1623,168 @@ static bool sd_TargetExistsInBucketPath(const char* bucketPath, bool* fsError) {
     return ((st.fattrib & SYS_FS_ATTR_DIR) == 0);
 }
 
+/* SdBucketIo_t.bucketExists / .partExists, by bucket index. The bucket's path
+ * is a local rather than bucketPath, which names the ACTIVE bucket while
+ * SdBucket_Place searches the ones after it. A path that does not fit reads
+ * as absent, as the search always treated it. */
+static bool sd_BucketExists(void* ctx, uint32_t bucket, bool* pFsError) {
+    (void)ctx;
+    char path[SD_CARD_MANAGER_FILE_PATH_LEN_MAX + 1];
+    *pFsError = false;
+    if (!sd_BuildBucketPath(path, sizeof(path), gpSDCardSettings->directory, bucket)) {
+        return false;
+    }
+    return sd_BucketDirExists(path, pFsError);
+}
+
+static bool sd_BucketHoldsPart(void* ctx, uint32_t bucket, uint32_t counter,
+                               bool* pFsError) {
+    (void)ctx;
+    char path[SD_CARD_MANAGER_FILE_PATH_LEN_MAX + 1];
+    *pFsError = false;
+    if (!sd_BuildBucketPath(path, sizeof(path), gpSDCardSettings->directory, bucket)) {
+        return false;
+    }
+    return sd_TargetExistsInBucketPath(path, counter, pFsError);
+}
+
+static const SdBucketIo_t gSdBucketIo = {
+    .ctx = NULL,
+    .enter = sd_EnterBucket,
+    .bucketExists = sd_BucketExists,
+    .partExists = sd_BucketHoldsPart,
+};
+
+/* --- Pre-created split parts ------------------------------------------------
+ *
+ * Rotation used to create the next part inside the #757 window: the search
+ * for an existing part (a stat per bucket, each a directory scan), FatFs's
+ * O(directory) create and, with SD:PREALLoc, the extent's FAT scan -- all
+ * while the encoder filled the buffer and nothing drained it. Instead, once
+ * the current part is half written, WRITE_TO_FILE opens and reserves the next
+ * one, and OPEN_FILE adopts that handle when the rotation comes. The window
+ * is left with the old part's drain and close.
+ *
+ * The pre-create decides the name from the bucket's part cache alone. When
+ * the cache cannot tell, or a later bucket exists that might hold the part,
+ * it leaves the part to OPEN_FILE, whose search is the authoritative one: a
+ * slower rotation is better than a duplicate part.
+ *
+ * FatFs is touched only from this task, after the writer barrier, and with
+ * FF_FS_LOCK the two open files are distinct names. A part that is never
+ * adopted (the session stopped first) is closed and deleted by UNMOUNT_DISK,
+ * which owns closing log files. */
+
+/* Close the unused pre-created part and remove it: it is empty, and an empty
+ * part after the last real one would read as a truncated log. Borrows
+ * filePath to rebuild its name, so call it only where filePath is free --
+ * after the current file's close, or at OPEN_FILE entry. */
+static void SD_DiscardNextLogFile(void) {
+    SYS_FS_HANDLE h = gSDCardData.nextFileHandle;
+    if (h == SYS_FS_HANDLE_INVALID) {
+        return;
+    }
+    gSDCardData.nextFileHandle = SYS_FS_HANDLE_INVALID;
+    if (gSDCardData.nextFileReserved) {
+        gSDCardData.nextFileReserved = false;
+        (void)SYS_FS_FileRelease(h);
+    }
+    if (SYS_FS_FileClose(h) == SYS_FS_RES_FAILURE) {
+        LOG_E("[SD] Failed to close pre-created part %u, error=%d",
+              (unsigned)gSDCardData.nextFileCounter, (int)SYS_FS_Error());
+        return;
+    }
+    generateFilename(gSDCardData.filePath, sizeof(gSDCardData.filePath),
+                     gSDCardData.nextFileCounter, gSDCardData.bucketPath,
+                     gSDCardData.baseFilename, gpSDCardSettings->file);
+    /* SD:FILe may have changed the extension since; then this is not the
+     * part that was created, and it is left alone rather than risk removing
+     * someone else's file. */
+    if (gSDCardData.filePath[0] != '\0' &&
+        SD_ClosedCrcKey(gSDCardData.filePath) == gSDCardData.nextFileKey) {
+        if (SYS_FS_FileDirectoryRemove(gSDCardData.filePath) == SYS_FS_RES_FAILURE) {
+            LOG_E("[SD] Failed to remove unused part '%s', error=%d",
+                  gSDCardData.filePath, (int)SYS_FS_Error());
+        }
+    }
+    gSDCardData.filePath[0] = '\0';
+}
+
+/* OPEN_FILE for the part just rotated to: take over the pre-created handle if
+ * it is that part. Returns false -- and OPEN_FILE creates the part itself --
+ * when there is none or it does not match. */
+static bool SD_AdoptNextLogFile(void) {
+    if (gSDCardData.nextFileHandle == SYS_FS_HANDLE_INVALID) {
+        return false;
+    }
+    generateFilename(gSDCardData.filePath, sizeof(gSDCardData.filePath),
+                     gSDCardData.fileCounter, gSDCardData.bucketPath,
+                     gSDCardData.baseFilename, gpSDCardSettings->file);
+    if (!SdBucket_Adoptable(&gSDCardData.bucket, gSDCardData.nextFileBucket,
+                            gSDCardData.nextFileCounter, gSDCardData.fileCounter) ||
+        gSDCardData.filePath[0] == '\0' ||
+        SD_ClosedCrcKey(gSDCardData.filePath) != gSDCardData.nextFileKey) {
+        SD_DiscardNextLogFile();
+        return false;
+    }
+    gSDCardData.fileHandle = gSDCardData.nextFileHandle;
+    gSDCardData.fileReserved = gSDCardData.nextFileReserved;
+    gSDCardData.nextFileHandle = SYS_FS_HANDLE_INVALID;
+    gSDCardData.nextFileReserved = false;
+    return true;
+}
+
+/* WRITE_TO_FILE, writer idle: open (and reserve) part fileCounter + 1.
+ * Leaves nothing behind when it declines or fails -- OPEN_FILE then does the
+ * work at the rotation, as it did before. */
+static void __attribute__((noinline)) SD_PrecreateNextLogFile(void) {
+    const uint32_t counter = gSDCardData.fileCounter + 1u;
+    gSDCardData.nextFileTried = true;
+
+    /* A roll ahead of the rotation that fails leaves the active bucket in
+     * place; the roll, and reporting its error, are left to OPEN_FILE. */
+    const SdWriteRefuseReason prevReason = gSDCardData.writeRefuseReason;
+    const SdBucketPrecreate plan =
+        SdBucket_PlanPrecreate(&gSDCardData.bucket, &gSdBucketIo, counter);
+    if (plan == SD_BUCKET_PRE_ROLL_FAILED) {
+        gSDCardData.writeRefuseReason = prevReason;
+        return;
+    }
+    if (plan == SD_BUCKET_PRE_DECLINE) {
+        return;
+    }
+
+    /* filePath is the part being written, so the name is built here. One
+     * path on the stack for the length of this call, inside the SD task's
+     * margin (see the SDCardTask xTaskCreate note in app_freertos.c); the
+     * noinline keeps it out of sd_card_manager_ProcessState's own frame. */
+    char path[SD_CARD_MANAGER_FILE_PATH_LEN_MAX + 1];
+    generateFilename(path, sizeof(path), counter, gSDCardData.bucketPath,
+                     gSDCardData.baseFilename, gpSDCardSettings->file);
+    if (path[0] == '\0') {
+        return;
+    }
+    TickType_t startTick = xTaskGetTickCount();
+    SYS_FS_HANDLE h = SYS_FS_FileOpen(path, SYS_FS_FILE_OPEN_WRITE_PLUS);
+    SD_CheckFsOpDuration(startTick, "FileOpen(precreate)",
+                         (h == SYS_FS_HANDLE_INVALID) ? -1 : 0);
+    if (h == SYS_FS_HANDLE_INVALID) {
+        LOG_I("[SD] pre-create of '%s' failed (error=%d) - creating it at rotation",
+              path, (int)SYS_FS_Error());
+        return;
+    }
+    if (plan == SD_BUCKET_PRE_NEW) {
+        SdBucket_NoteCreated(&gSDCardData.bucket, counter);
+    }
+    SD_ForgetClosedCrc(path);  // truncated by the open
+    gSDCardData.nextFileHandle = h;
+    gSDCardData.nextFileCounter = counter;
+    gSDCardData.nextFileBucket = gSDCardData.bucket.cur;
+    gSDCardData.nextFileKey = SD_ClosedCrcKey(path);
+    gSDCardData.nextFileReserved = SD_ReserveLogFile(h, path);
+    LOG_D("[SD] Pre-created '%s'\r\n", path);
+}
+
 /* #800: a teardown raised while the SD task is mid-transition must not be lost.
  *
  * sd_card_manager_UpdateSettings() and sd_card_manager_Deinit() run on the
@@ -1275,6 +1865,7 @@ static void sd_AbandonRotationWindow(const char* why) {
     gSdRotating = false;
     size_t buffered = CircularBuf_NumBytesAvailable(&gSDCardData.wCirbuf);
     CircularBuf_Reset(&gSDCardData.wCirbuf);
+    SdLogWriter_Begin(&gSdLog);
     xSemaphoreGive(gSDCardData.wMutex);
     if (buffered > 0u) {
         Streaming_ReportSdDiscard(buffered);
@@ -1283,6 +1874,135 @@ static void sd_AbandonRotationWindow(const char* why) {
     }
 }
 
+/* SdLogTrailerReader_t over the open READ file. */
+static bool sd_ReadTrailer(void* ctx, uint32_t block, SdLogTrailer_t* t) {
+    (void)ctx;
+    uint8_t tr[SDLOG_TRAILER_SIZE];
+    /* Offsets past 2 GB: SYS_FS_FileSeek takes int32_t but casts back to the
+     * FatFs uint32 offset for SEEK_SET, so the wrap is intended -- and it
+     * returns that offset, so only -1 means failure. */
+    uint32_t off = block * SDLOG_BLOCK_SIZE + SDLOG_PAYLOAD_SIZE;
+    if (SYS_FS_FileSeek(gSDCardData.fileHandle, (int32_t)off, SYS_FS_SEEK_SET) == -1 ||
+        SYS_FS_FileRead(gSDCardData.fileHandle, tr, sizeof(tr)) != sizeof(tr)) {
+        return false;
+    }
+    return SdLog_DecodeTrailer(tr, t);
+}
+
+/* SD:GET transfer callbacks for SdReadPump_Run (SD task). */
+typedef struct {
+    uint32_t readCount;
+    TickType_t lastYieldTime;
+} sd_read_pump_ctx_t;
+
+static size_t sd_PumpRead(void* ctx, uint8_t* buf, size_t len) {
+    sd_read_pump_ctx_t* pc = (sd_read_pump_ctx_t*)ctx;
+    size_t bytesRead = SYS_FS_FileRead(gSDCardData.fileHandle, buf, len);
+    if (bytesRead != (size_t)-1 && bytesRead > 0u) {
+        pc->readCount++;
+        // Delay every 1 second to allow lower priority tasks to run
+        if ((xTaskGetTickCount() - pc->lastYieldTime) >= pdMS_TO_TICKS(1000)) {
+            vTaskDelay(pdMS_TO_TICKS(1));
+            pc->lastYieldTime = xTaskGetTickCount();
+        }
+    }
+    return bytesRead;
+}
+
+static size_t sd_PumpTrySend(void* ctx, const uint8_t* data, size_t len) {
+    (void)ctx;
+    return sd_card_manager_DataReadyTryCB(SD_CARD_MANAGER_MODE_READ, data, len);
+}
+
+static bool sd_PumpSend(void* ctx, const uint8_t* data, size_t len) {
+    (void)ctx;
+    sd_card_manager_DataReadyCB(SD_CARD_MANAGER_MODE_READ, (uint8_t*)data, len);
+    return !gTransferAbortRequested;   /* DataReadyCB requests it when it gives up */
+}
+
+static bool sd_PumpAborted(void* ctx) {
+    (void)ctx;
+    return gTransferAbortRequested || gSDCardData.fileHandle == SYS_FS_HANDLE_INVALID;
+}
+
+/* Position the READ file for gpSDCardSettings->readSelect and set *pLength
+ * to how many bytes to send: the whole file for SD:GET, the clipped byte
+ * range for a ranged SD:GET, the resolved block range for GET:BLOCks /
+ * GET:TIMe. Zero (an empty transfer, terminator only) when the range holds
+ * nothing or the file is not a container log; false only if the seek failed.
+ * Uses gSdSharedBuffer for the index block, before the transfer needs it. */
+static bool sd_ResolveReadRange(uint32_t* pLength) {
+    uint32_t size = (uint32_t)SYS_FS_FileSize(gSDCardData.fileHandle);
+    *pLength = 0;
+    if (gpSDCardSettings->readSelect == SD_CARD_READ_ALL) {
+        *pLength = size;
+        return true;
+    }
+    if (gpSDCardSettings->readSelect == SD_CARD_READ_BYTES) {
+        uint64_t offset = gpSDCardSettings->readArg1;
+        uint64_t length = gpSDCardSettings->readArg2;
+        if (offset >= size) {
+            return true;   /* a resume at (or past) the end: just the terminator */
+        }
+        if (length == 0u || length > size - offset) {
+            length = size - (uint32_t)offset;
+        }
+        if (SYS_FS_FileSeek(gSDCardData.fileHandle, (int32_t)(uint32_t)offset,
+                            SYS_FS_SEEK_SET) == -1) {
+            LOG_E("[SD] GET: seek to %u failed", (unsigned)offset);
+            return false;
+        }
+        *pLength = (uint32_t)length;
+        return true;
+    }
+    uint32_t nblocks = size / SDLOG_BLOCK_SIZE;
+    uint32_t first = 0;
+    uint32_t last = 0;
+    bool found = false;
+
+    if (gpSDCardSettings->readSelect == SD_CARD_READ_BLOCKS) {
+        uint64_t start = gpSDCardSettings->readArg1;
+        uint64_t count = gpSDCardSettings->readArg2;
+        if (start < nblocks && count > 0u) {
+            first = (uint32_t)start;
+            last = (count > (uint64_t)(nblocks - first)) ? nblocks - 1u
+                                                         : first + (uint32_t)count - 1u;
+            found = true;
+        }
+    } else if (nblocks > 0u) {
+        SdLogIndex_t index;
+        SdLogTrailer_t t;
+        bool haveIndex = false;
+        if (gSdSharedBufferSize >= SDLOG_BLOCK_SIZE &&
+            SYS_FS_FileSeek(gSDCardData.fileHandle,
+                            (int32_t)((nblocks - 1u) * SDLOG_BLOCK_SIZE),
+                            SYS_FS_SEEK_SET) != -1 &&
+            SYS_FS_FileRead(gSDCardData.fileHandle, gSdSharedBuffer,
+                            SDLOG_BLOCK_SIZE) == SDLOG_BLOCK_SIZE &&
+            SdLog_CheckBlock(gSdSharedBuffer, &t) && t.type == SDLOG_BLOCK_INDEX) {
+            haveIndex = SdLogIndex_Decode(gSdSharedBuffer, t.payloadLen, &index);
+        }
+        found = SdLog_FindRange(nblocks, haveIndex ? &index : NULL,
+                                gpSDCardSettings->readArg1, gpSDCardSettings->readArg2,
+                                sd_ReadTrailer, NULL, &first, &last);
+    }
+
+    if (!found) {
+        LOG_I("[SD] GET range: nothing to send from '%s' (%u blocks)",
+              gSDCardData.filePath, (unsigned)nblocks);
+        return true;
+    }
+    if (SYS_FS_FileSeek(gSDCardData.fileHandle, (int32_t)(first * SDLOG_BLOCK_SIZE),
+                        SYS_FS_SEEK_SET) == -1) {
+        LOG_E("[SD] GET range: seek to block %u failed", (unsigned)first);
+        return false;
+    }
+    LOG_D("[SD] GET range: blocks %u..%u of %u\r\n",
+          (unsigned)first, (unsigned)last, (unsigned)nblocks);
+    *pLength = (last - first + 1u) * SDLOG_BLOCK_SIZE;
+    return true;
+}
+
 void sd_card_manager_ProcessState() {
     /* #800: honour a teardown that raced a state store, before dispatching. */
     if (gSdTeardownRequested) {
@@ -1299,6 +2019,14 @@ void sd_card_manager_ProcessState() {
         gSDCardData.currentProcessState = SD_CARD_MANAGER_PROCESS_STATE_DEINIT;
     }
 
+    /* Only WRITE_TO_FILE runs alongside the log writer. Every other state
+     * either touches the file system or is on its way to, so the writer must
+     * be finished first -- this is also how a teardown, an error or a
+     * graceful shutdown waits for the chunks already submitted. */
+    if (gSDCardData.currentProcessState != SD_CARD_MANAGER_PROCESS_STATE_WRITE_TO_FILE) {
+        (void) SD_WriteSlotsBarrier();
+    }
+
     /* Check the application's current state. */
 
     switch (gSDCardData.currentProcessState) {
@@ -1451,14 +2179,14 @@ void sd_card_manager_ProcessState() {
                     while (gSDCardData.sdCardWritePending == 1 && drainIter < 100) {
                         int pendingLen = SDCardWrite();
                         if (pendingLen > 0 && (size_t)pendingLen >= gSDCardData.writeBufferLength) {
-                            gSDCardData.currentFileBytes += gSDCardData.writeBufferLength;
+                            SD_AccountWritten((uint32_t)gSDCardData.writeBufferLength);
                             SD_TakeMutexDebug(gSDCardData.wMutex, "unmount_pending_write");
                             gSDCardData.sdCardWritePending = 0;
                             gSDCardData.writeBufferLength = 0;
                             gSDCardData.sdCardWriteBufferOffset = 0;
                             xSemaphoreGive(gSDCardData.wMutex);
                         } else if (pendingLen > 0) {
-                            gSDCardData.currentFileBytes += pendingLen;
+                            SD_AccountWritten((uint32_t)pendingLen);
                             SD_TakeMutexDebug(gSDCardData.wMutex, "unmount_partial_write");
                             gSDCardData.writeBufferLength -= pendingLen;
                             gSDCardData.sdCardWriteBufferOffset += pendingLen;
@@ -1476,6 +2204,12 @@ void sd_card_manager_ProcessState() {
                         drainIter++;
                     }
 
+                    // Container mode: seal the file (last block + index) into
+                    // the ring so the drain below writes it out with the rest.
+                    SD_TakeMutexDebug(gSDCardData.wMutex, "unmount_seal");
+                    sd_LogSeal();
+                    xSemaphoreGive(gSDCardData.wMutex);
+
                     // 2. Drain circular buffer — extract remaining data (NOT sector-aligned)
                     drainIter = 0;
                     while (CircularBuf_NumBytesAvailable(&gSDCardData.wCirbuf) > 0
@@ -1498,14 +2232,14 @@ void sd_card_manager_ProcessState() {
                             while (gSDCardData.sdCardWritePending == 1 && innerIter < 100) {
                                 writeLen = SDCardWrite();
                                 if (writeLen > 0 && (size_t)writeLen >= gSDCardData.writeBufferLength) {
-                                    gSDCardData.currentFileBytes += gSDCardData.writeBufferLength;
+                                    SD_AccountWritten((uint32_t)gSDCardData.writeBufferLength);
                                     SD_TakeMutexDebug(gSDCardData.wMutex, "unmount_drain_complete");
                                     gSDCardData.sdCardWritePending = 0;
                                     gSDCardData.writeBufferLength = 0;
                                     gSDCardData.sdCardWriteBufferOffset = 0;
                                     xSemaphoreGive(gSDCardData.wMutex);
                                 } else if (writeLen > 0) {
-                                    gSDCardData.currentFileBytes += writeLen;
+                                    SD_AccountWritten((uint32_t)writeLen);
                                     SD_TakeMutexDebug(gSDCardData.wMutex, "unmount_drain_partial");
                                     gSDCardData.writeBufferLength -= writeLen;
                                     gSDCardData.sdCardWriteBufferOffset += writeLen;
@@ -1530,6 +2264,8 @@ void sd_card_manager_ProcessState() {
                     }
                 }
 
+                SD_ReleaseLogFile();
+
                 // Flush filesystem buffers before closing
                 SD_TakeMutexDebug(gSDCardData.wMutex, "unmount_pending_check");
                 bool hasPendingData = gSDCardData.totalBytesFlushPending > 0;
@@ -1553,9 +2289,14 @@ void sd_card_manager_ProcessState() {
                 LOG_D("[SD] Closing file '%s'\r\n", gSDCardData.filePath);
                 if (SYS_FS_FileClose(gSDCardData.fileHandle) == SYS_FS_RES_FAILURE) {
                     LOG_E("[SD] Failed to close file during unmount: '%s', error=%d", gSDCardData.filePath, SYS_FS_Error());
+                } else if (gSDCardData.currentFileBytes > 0u) {
+                    /* a log file (READ/CRC handles account no bytes) */
+                    SD_RecordClosedCrc();
                 }
                 gSDCardData.fileHandle = SYS_FS_HANDLE_INVALID;
             }
+            /* After the close above: it borrows filePath. */
+            SD_DiscardNextLogFile();
             if (SYS_FS_Unmount(SD_CARD_MANAGER_DISK_MOUNT_NAME) == 0) {
                 gSDCardData.discMounted = false;
                 gLoggedUnmountFail = false;
@@ -1591,7 +2332,7 @@ void sd_card_manager_ProcessState() {
             } else {
                 gSDCardData.unmountRetryCount = 0;
                 // Reset file splitting state for next session
-                /* #689: curBucket/bucketPath are left alone here, and that is
+                /* #689: the bucket state and bucketPath are left alone here, and that is
                  * harmless rather than deliberate -- resetting fileCounter is
                  * what matters, because the next session's first open takes the
                  * fileCounter==0 branch and re-enters bucket 0, re-establishing
@@ -1607,6 +2348,8 @@ void sd_card_manager_ProcessState() {
                 gSDCardData.currentFileBytes = 0;
                 memset(gSDCardData.baseFilename, 0, sizeof(gSDCardData.baseFilename));
                 gSDCardData.fileSplittingEnabled = false;
+                gSDCardData.fileReserved = false;
+                gSDCardData.nextFileTried = false;
                 LOG_D("[SD] File splitting state reset for next session\r\n");
 
                 // Always go back to INIT after unmounting
@@ -1816,6 +2559,14 @@ void sd_card_manager_ProcessState() {
                 // Initialize file splitting if enabled
                 gSDCardData.fileSplittingEnabled = (gpSDCardSettings->maxFileSizeBytes > 0);
 
+                /* A rotation whose part WRITE_TO_FILE already created and
+                 * reserved takes that handle over: the bucket search, the
+                 * roll, the create and the reserve below have all been done,
+                 * outside the #757 window. */
+                const bool adopted = SD_AdoptNextLogFile();
+                SD_TrackRotation(adopted ? 1u : 0u,
+                                 (gSdRotating && !adopted) ? 1u : 0u);
+
                 // Extract base filename and generate actual filename with counter
                 bool bucketOk = true;
                 if (gSDCardData.fileCounter == 0) {
@@ -1838,11 +2589,13 @@ void sd_card_manager_ProcessState() {
                      * per session start, against sessions that run for minutes
                      * to hours. Paying it buys a cursor that cannot be stale,
                      * which is worth far more than the time it saves. */
-                    bucketOk = sd_EnterBucket(gpSDCardSettings->directory, 0u);
+                    bucketOk = SdBucket_Enter(&gSDCardData.bucket, &gSdBucketIo, 0u);
                 }
 
-                // #689: roll into the next bucket while the active one is at its
-                // ceiling, so FatFs never sees a large directory to scan. This
+                // #689: SdBucket_Place (Util/SdBucket.c) searches for an
+                // existing copy of the part, then rolls into the next bucket
+                // while the active one is at its ceiling, so FatFs never sees
+                // a large directory to scan. This
                 // replaces the old hard refuse, which merely converted the wedge
                 // into a dead stop: a long split session now keeps logging into
                 // P001, P002, ... instead of ending at 64 files.
@@ -1881,7 +2634,7 @@ void sd_card_manager_ProcessState() {
                  * and the consequence is bounded: one extra copy of one part
                  * name, nothing overwritten.
                  *
-                 * It must NOT be folded into the roll below, which was tried
+                 * It must NOT be folded into the roll after it, which was tried
                  * and is wrong: the roll only advances while a bucket is FULL,
                  * so it never runs when the active bucket has room -- and a
                  * bucket can have room while a LATER one still holds this
@@ -1891,61 +2644,31 @@ void sd_card_manager_ProcessState() {
                  * both shapes with one mechanism; a newly created bucket is
                  * empty, so nothing the roll creates can hold the part. */
                 bool reopenExisting = false;
-                if (bucketOk) {
-                    uint32_t reuseBucket = gSDCardData.curBucket;
-                    char probePath[SD_CARD_MANAGER_FILE_PATH_LEN_MAX + 1];
-                    for (uint32_t probe = gSDCardData.curBucket;
-                         probe <= SD_CARD_MANAGER_MAX_BUCKET; probe++) {
-                        if (!sd_BuildBucketPath(probePath, sizeof(probePath),
-                                                gpSDCardSettings->directory,
-                                                probe)) {
+                if (bucketOk && !adopted) {
+                    switch (SdBucket_Place(&gSDCardData.bucket, &gSdBucketIo,
+                                           gSDCardData.fileCounter, &reopenExisting)) {
+                        case SD_BUCKET_OK:
                             break;
-                        }
-                        if (probe != gSDCardData.curBucket) {
-                            bool probeFsError = false;
-                            bool present = sd_BucketDirExists(probePath,
-                                                              &probeFsError);
-                            if (probeFsError) {
-                                /* An unreadable bucket is NOT an absent one.
-                                 * Ending the search here would create a
-                                 * duplicate part on a card that is merely
-                                 * failing, so refuse instead -- the same
-                                 * fail-safe sd_EnterBucket applies to an
-                                 * unreadable count. */
-                                gSDCardData.writeRefuseReason =
-                                        SD_REFUSE_BUCKET_UNREADABLE;
-                                bucketOk = false;
-                                break;
-                            }
-                            if (!present) {
-                                break;
-                            }
-                        }
-                        bool targetFsError = false;
-                        bool found = sd_TargetExistsInBucketPath(probePath,
-                                                                 &targetFsError);
-                        if (targetFsError) {
-                            gSDCardData.writeRefuseReason =
-                                    SD_REFUSE_BUCKET_UNREADABLE;
+                        case SD_BUCKET_UNREADABLE:
+                            /* An unreadable bucket is NOT an absent one.
+                             * Ending the search there would create a duplicate
+                             * part on a card that is merely failing, so refuse
+                             * instead -- the same fail-safe sd_EnterBucket
+                             * applies to an unreadable count. */
+                            gSDCardData.writeRefuseReason = SD_REFUSE_BUCKET_UNREADABLE;
                             bucketOk = false;
                             break;
-                        }
-                        if (found) {
-                            reopenExisting = true;
-                            reuseBucket = probe;
+                        case SD_BUCKET_EXHAUSTED:
+                            /* Genuinely out of buckets: the scan started at 0
+                             * this session, so there is nothing behind us to find. */
+                            gSDCardData.writeRefuseReason = SD_REFUSE_BUCKETS_EXHAUSTED;
+                            bucketOk = false;
+                            break;
+                        default:
+                            bucketOk = false;   // sd_EnterBucket recorded why
                             break;
-                        }
-                    }
-                    /* Only re-enter when the part lives elsewhere: sd_EnterBucket
-                     * re-counts and zeroes filesInCurBucket, so calling it for
-                     * the bucket we are already in would forget the files this
-                     * session has added and overshoot the per-bucket ceiling. */
-                    if (reopenExisting && reuseBucket != gSDCardData.curBucket) {
-                        bucketOk = sd_EnterBucket(gpSDCardSettings->directory,
-                                                  reuseBucket);
-                        reopenExisting = bucketOk;
                     }
-                    /* The pre-walk borrowed filePath as scratch (see
+                    /* The search borrowed filePath as scratch (see
                      * sd_TargetExistsInBucketPath). Hand it back EMPTY rather
                      * than holding the last probe path.
                      *
@@ -1958,23 +2681,6 @@ void sd_card_manager_ProcessState() {
                     gSDCardData.filePath[0] = '\0';
                 }
 
-                uint32_t advanced = 0u;
-                while (bucketOk && !reopenExisting &&
-                       (gSDCardData.bucketFileCountAtStart +
-                        gSDCardData.filesInCurBucket) >= SD_CARD_MANAGER_MAX_DIR_FILES) {
-                    if (gSDCardData.curBucket >= SD_CARD_MANAGER_MAX_BUCKET ||
-                        advanced >= SD_CARD_MANAGER_BUCKET_ADVANCE_MAX) {
-                        /* Genuinely out of buckets: the scan started at 0
-                         * this session, so there is nothing behind us to find. */
-                        gSDCardData.writeRefuseReason = SD_REFUSE_BUCKETS_EXHAUSTED;
-                        bucketOk = false;
-                        break;
-                    }
-                    bucketOk = sd_EnterBucket(gpSDCardSettings->directory,
-                                              gSDCardData.curBucket + 1u);
-                    advanced++;
-                }
-
                 // Buckets exhausted (or a bucket could not be created). Clean-stop
                 // to IDLE with startupDirFull set, so SCPI_StartStreaming reports a
                 // precise error rather than a silent wedge — mirrors the #503
@@ -1985,12 +2691,13 @@ void sd_card_manager_ProcessState() {
                           "file-create wedges large directories (#689). Use a "
                           "larger SD:MAXSize, a different directory, or clear the "
                           "card.", gpSDCardSettings->directory,
-                          gSDCardData.bucketPath, (unsigned)gSDCardData.curBucket,
+                          gSDCardData.bucketPath, (unsigned)gSDCardData.bucket.cur,
                           (unsigned)SD_CARD_MANAGER_MAX_DIR_FILES,
                           (unsigned)SD_CARD_MANAGER_MAX_BUCKET);
                     gSDCardData.startupDirFull = true;
                     gSDCardData.lastOperationSuccess = false;
                     if (gSDCardData.fileHandle != SYS_FS_HANDLE_INVALID) {
+                        SD_ReleaseLogFile();
                         (void)SYS_FS_FileClose(gSDCardData.fileHandle);
                         gSDCardData.fileHandle = SYS_FS_HANDLE_INVALID;
                     }
@@ -2011,17 +2718,6 @@ void sd_card_manager_ProcessState() {
                 generateFilename(gSDCardData.filePath, sizeof(gSDCardData.filePath),
                                gSDCardData.fileCounter, gSDCardData.bucketPath,
                                gSDCardData.baseFilename, gpSDCardSettings->file);
-                // Count the attempt, not the success: a failed create still costs
-                // a directory entry scan, and over-counting only rolls us to a
-                // fresh bucket sooner, which is the safe direction.
-                /* A re-open of an existing target adds no directory entry, so
-                 * it must not be counted -- the same reason the roll above skips
-                 * it. Counting it inflated the estimate by one per session on
-                 * the STR:START readiness path. */
-                if (!reopenExisting) {
-                    gSDCardData.filesInCurBucket++;
-                }
-
                 LOG_D("[SD] Opening file '%s' (counter=%u, splitting=%s)\r\n",
                      gSDCardData.filePath, gSDCardData.fileCounter,
                      gSDCardData.fileSplittingEnabled ? "enabled" : "disabled");
@@ -2038,9 +2734,9 @@ void sd_card_manager_ProcessState() {
                 //      encodes WITHOUT metadata, writes to buffer
                 //   3. Streaming_ResetSdFileHeader() resets flags (too late)
                 //   => Non-metadata data at byte 0 of new file
-                /* #757: skipped during a rotation -- the close path above
-                 * already reset the metadata and the buffer, and the encoder
-                 * has been filling that buffer with the new file's header and
+                /* #757: skipped during a rotation -- the rotation already
+                 * reset the metadata at its drain snapshot, and the encoder
+                 * has been filling the buffer with the new file's header and
                  * data ever since. Repeating the reset here would throw away
                  * exactly the bytes this fix exists to keep. On a FIRST open
                  * (session start, not rotation) gSdRotating is false and this
@@ -2072,6 +2768,9 @@ void sd_card_manager_ProcessState() {
                  * the streaming task reads. */
                     SD_TakeMutexDebug(gSDCardData.wMutex, "open_file_clear_buffer");
                     CircularBuf_Reset(&gSDCardData.wCirbuf);
+                    /* Container mode is latched per session, here. */
+                    gSdLogActive = gpSDCardSettings->container;
+                    SdLogWriter_Begin(&gSdLog);
                     xSemaphoreGive(gSDCardData.wMutex);
                 }
 
@@ -2084,8 +2783,12 @@ void sd_card_manager_ProcessState() {
                 gSDCardData.sdCardWriteBufferOffset = 0;
 
                 // Use WRITE_PLUS to create/truncate file (overwrite mode)
-                gSDCardData.fileHandle = SYS_FS_FileOpen(gSDCardData.filePath,
-                        (SYS_FS_FILE_OPEN_WRITE_PLUS));
+                if (!adopted) {
+                    gSDCardData.fileHandle = SYS_FS_FileOpen(gSDCardData.filePath,
+                            (SYS_FS_FILE_OPEN_WRITE_PLUS));
+                    gSDCardData.fileReserved = SD_ReserveLogFile(
+                            gSDCardData.fileHandle, gSDCardData.filePath);
+                }
 
                 /* #782: a teardown may have landed while this open was in
                  * flight. SCPI (pri 7) preempts this task (pri 5), and
@@ -2179,6 +2882,9 @@ void sd_card_manager_ProcessState() {
                  * headers at byte 0. */
                 gSDCardData.totalBytesFlushPending = 0;
                 gSDCardData.currentFileBytes = 0;  // Reset byte counter for new file
+                gSDCardData.nextFileTried = false;
+                gSDCardData.writeCrcRunning = CRC32_Init();
+                SD_ForgetClosedCrc(gSDCardData.filePath);  // truncated by the open
                 gSDCardData.lastFlushMillis = pdTICKS_TO_MS(xTaskGetTickCount());
 
                 if (gSDCardData.fileHandle == SYS_FS_HANDLE_INVALID) {
@@ -2196,6 +2902,25 @@ void sd_card_manager_ProcessState() {
                 // #724: open the transient operand (opFile), not the logging target.
                 snprintf(gSDCardData.filePath, SD_CARD_MANAGER_FILE_PATH_LEN_MAX, "%s/%s",
                         gpSDCardSettings->directory, gpSDCardSettings->opFile);
+                if (gpSDCardSettings->mode == SD_CARD_MANAGER_MODE_COMPUTE_CRC) {
+                    /* A log this session wrote and closed already has its CRC
+                     * (folded in as it was written): no read-back. Completes
+                     * exactly as the COMPUTE_CRC EOF path does. */
+                    uint32_t crc, size;
+                    if (SD_LookupClosedCrc(gSDCardData.filePath, &crc, &size)) {
+                        taskENTER_CRITICAL();
+                        gSDCardData.crcResult = crc;
+                        gSDCardData.crcLength = size;
+                        gSDCardData.crcResultValid = true;
+                        taskEXIT_CRITICAL();
+                        LOG_D("[SD] CRC of '%s' from write-time CRC\r\n", gSDCardData.filePath);
+                        gSDCardData.lastOperationSuccess = true;
+                        gpSDCardSettings->mode = SD_CARD_MANAGER_MODE_NONE;
+                        gSDCardData.currentProcessState = SD_CARD_MANAGER_PROCESS_STATE_IDLE;
+                        xSemaphoreGive(gSDCardData.opCompleteSemaphore);
+                        break;
+                    }
+                }
                 LOG_D("[SD] Opening file for read: '%s'\r\n", gSDCardData.filePath);
 
                 gSDCardData.fileHandle = SYS_FS_FileOpen(gSDCardData.filePath,
@@ -2317,97 +3042,26 @@ void sd_card_manager_ProcessState() {
                 break;
             }
 
-            /* If read was success, try writing to the new file */
-            int writeLen = -2;
-            
-            // Process multiple chunks per cycle for better throughput
-            int chunksProcessed = 0;
-            
-            while (chunksProcessed < SD_CARD_MANAGER_MAX_CHUNKS_PER_CYCLE) {
-                SD_TakeMutexDebug(gSDCardData.wMutex, "write_loop_check");
-                uint32_t availBytes = CircularBuf_NumBytesAvailable(&gSDCardData.wCirbuf);
-                if (availBytes >= SD_SECTOR_SIZE_BYTES
-                        && gSDCardData.sdCardWritePending != 1) {
-                    /* #738: bound by the buffer we ACTUALLY have, not the
-                     * compile-time maximum. writeBufferSize is the runtime
-                     * size auto-balance assigned (SD_CARD_MANAGER_CONF_WBUFFER_SIZE
-                     * is only the 64 KB ceiling), and it collapses to the
-                     * inactive-interface minimum whenever SD is not the active
-                     * streaming interface. Extracting the ceiling into a
-                     * smaller buffer is refused by CircularBufferToSDWrite, so
-                     * the write fails and the data is dropped. Read under
-                     * wMutex, which is the mutex sd_card_manager_SetWriteBuffer
-                     * takes to change it. */
-                    uint32_t wbufCap = gSDCardData.writeBufferSize;
-                    uint32_t maxExtract = (availBytes < wbufCap) ? availBytes
-                                                                 : wbufCap;
-                    maxExtract = (maxExtract / SD_SECTOR_SIZE_BYTES) * SD_SECTOR_SIZE_BYTES;
-                    /* Unreachable today: the branch above requires availBytes
-                     * >= one sector, and writeBufferSize is floored at 512 (by
-                     * PrepareStreamingBuffers, twice, and by the 64 KB init).
-                     * Guarded anyway because this loop now DEPENDS on that
-                     * floor, and the public setter only rejects size == 0 — a
-                     * future caller passing a sub-sector size would truncate to
-                     * 0 here, and extracting 0 after setting sdCardWritePending
-                     * would leave the state machine waiting on a write that
-                     * never had data (Qodo #748). */
-                    if (maxExtract == 0) {
-                        xSemaphoreGive(gSDCardData.wMutex);
-                        LOG_E_ONCE(LOG_ONCE_SD_WBUF_SUBSECTOR,
-                                   "[SD] write buffer below one sector - drain stalled");
-                        break;
-                    }
-                    gSDCardData.sdCardWritePending = 1;
-                    CircularBuf_ProcessBytes(&gSDCardData.wCirbuf, NULL, maxExtract, &writeLen);
-                    gSDCardData.totalBytesFlushPending += gSDCardData.writeBufferLength;
-                    xSemaphoreGive(gSDCardData.wMutex);
-                    chunksProcessed++;
-                } else {
-                    // No data available or write already pending, release mutex
-                    xSemaphoreGive(gSDCardData.wMutex);
-                    
-                    // Note: sdCardWritePending check outside mutex is safe here because:
-                    // 1. Only this task modifies sdCardWritePending
-                    // 2. We're coordinating work within a single task, not between tasks
-                    // If this changes in future, this will need mutex protection
-                    if (gSDCardData.sdCardWritePending == 1) {
-                        writeLen = SDCardWrite();
-                        // Check error first: SDCardWrite returns int, but
-                        // writeBufferLength is size_t (unsigned). Without this
-                        // guard, -1 converts to SIZE_MAX and passes the >= check,
-                        // silently discarding the data.
-                        if (writeLen < 0) {
-                            gSDCardData.currentProcessState = SD_CARD_MANAGER_PROCESS_STATE_ERROR;
-                            LOG_E("[%s:%d]Error Writing to SD Card", __FILE__, __LINE__);
-                            break;
-                        } else if ((size_t)writeLen >= gSDCardData.writeBufferLength) {
-                            // Track bytes written for file splitting
-                            gSDCardData.currentFileBytes += gSDCardData.writeBufferLength;
-
-                            SD_TakeMutexDebug(gSDCardData.wMutex, "write_complete");
-                            gSDCardData.sdCardWritePending = 0;
-                            gSDCardData.writeBufferLength = 0;
-                            gSDCardData.sdCardWriteBufferOffset = 0;
-                            xSemaphoreGive(gSDCardData.wMutex);
-                        } else if (writeLen > 0) {
-                            // Partial write
-                            gSDCardData.currentFileBytes += writeLen;
+            /* Reap what the writer finished, stage the next chunks into free
+             * slots (see SD_WriteSlotsPump). Does not wait on the card. */
+            SD_WriteSlotsPump();
+            if (gSDCardData.currentProcessState == SD_CARD_MANAGER_PROCESS_STATE_ERROR) {
+                break;
+            }
 
-                            SD_TakeMutexDebug(gSDCardData.wMutex, "partial_write");
-                            gSDCardData.writeBufferLength -= writeLen;
-                            gSDCardData.sdCardWriteBufferOffset += writeLen;
-                            xSemaphoreGive(gSDCardData.wMutex);
-                            break;  // Partial write, don't process more chunks
-                        } else {
-                            // writeLen == 0: no progress — error out to avoid infinite retry
-                            gSDCardData.currentProcessState = SD_CARD_MANAGER_PROCESS_STATE_ERROR;
-                            LOG_E("[%s:%d]Zero-byte write to SD Card", __FILE__, __LINE__);
-                            break;
-                        }
-                    } else {
-                        break;  // No more data to process
-                    }
+            /* Half way through a part, create the next one (see
+             * SD_PrecreateNextLogFile). Once per part, and only while a
+             * rotation would still open another. */
+            if (gSDCardData.fileSplittingEnabled && !gSDCardData.nextFileTried &&
+                gSDCardData.nextFileHandle == SYS_FS_HANDLE_INVALID &&
+                gSDCardData.fileCounter < SD_CARD_MANAGER_MAX_SPLIT_FILES &&
+                gSDCardData.currentFileBytes >=
+                    gpSDCardSettings->maxFileSizeBytes / SD_CARD_MANAGER_PRECREATE_DIVISOR) {
+                if (!SD_WriteSlotsBarrier()) {
+                    gSDCardData.currentProcessState = SD_CARD_MANAGER_PROCESS_STATE_ERROR;
+                    break;
                 }
+                SD_PrecreateNextLogFile();
             }
 
             // Check if file size limit reached and rotation is needed
@@ -2417,60 +3071,49 @@ void sd_card_manager_ProcessState() {
                 LOG_D("[SD] File size limit reached (%llu >= %llu), rotating to next file\r\n",
                      gSDCardData.currentFileBytes, gpSDCardSettings->maxFileSizeBytes);
 
-                // Complete any pending write from the chunk processing loop.
-                // The loop can exit with sdCardWritePending=1 (4th chunk read
-                // but not yet written). Flush it to the OLD file before closing.
-                // Loop to handle partial writes (same logic as normal write path).
-                while (gSDCardData.sdCardWritePending == 1) {
-                    int pendingLen = SDCardWrite();
-                    if (pendingLen < 0) {
-                        LOG_E("[SD] Error flushing pending write before rotation");
-                        gSDCardData.currentProcessState = SD_CARD_MANAGER_PROCESS_STATE_ERROR;
-                        gSDCardData.sdCardWritePending = 0;
-                        /* #825: same obligation as the drain loop below. This chunk was
-                         * extracted from wCirbuf by the chunk loop (which exits with
-                         * sdCardWritePending=1 on its 4th chunk -- see the comment above),
-                         * so the bytes are already gone from the buffer. Nothing else can
-                         * see them: the drain loop counts its OWN writeBufferLength, and
-                         * the strand/abandon paths only count what is still in wCirbuf. */
-                        Streaming_ReportSdDiscard(gSDCardData.writeBufferLength);
-                        gSDCardData.writeBufferLength = 0;
-                        gSDCardData.sdCardWriteBufferOffset = 0;
-                        break;
-                    } else if ((size_t)pendingLen >= gSDCardData.writeBufferLength) {
-                        gSDCardData.currentFileBytes += gSDCardData.writeBufferLength;
-                        SD_TakeMutexDebug(gSDCardData.wMutex, "rotation_pending_write");
-                        gSDCardData.sdCardWritePending = 0;
-                        gSDCardData.writeBufferLength = 0;
-                        gSDCardData.sdCardWriteBufferOffset = 0;
-                        xSemaphoreGive(gSDCardData.wMutex);
-                    } else if (pendingLen > 0) {
-                        // Partial write — update offset and retry
-                        gSDCardData.currentFileBytes += pendingLen;
-                        SD_TakeMutexDebug(gSDCardData.wMutex, "rotation_partial_write");
-                        gSDCardData.writeBufferLength -= pendingLen;
-                        gSDCardData.sdCardWriteBufferOffset += pendingLen;
-                        xSemaphoreGive(gSDCardData.wMutex);
-                    } else {
-                        LOG_E("[SD] Zero-byte write during rotation flush");
-                        gSDCardData.currentProcessState = SD_CARD_MANAGER_PROCESS_STATE_ERROR;
-                        gSDCardData.sdCardWritePending = 0;
-                        /* #825: same obligation as the drain loop below. This chunk was
-                         * extracted from wCirbuf by the chunk loop (which exits with
-                         * sdCardWritePending=1 on its 4th chunk -- see the comment above),
-                         * so the bytes are already gone from the buffer. Nothing else can
-                         * see them: the drain loop counts its OWN writeBufferLength, and
-                         * the strand/abandon paths only count what is still in wCirbuf. */
-                        Streaming_ReportSdDiscard(gSDCardData.writeBufferLength);
-                        gSDCardData.writeBufferLength = 0;
-                        gSDCardData.sdCardWriteBufferOffset = 0;
-                        break;
-                    }
+                /* Everything below syncs and closes the file, and drains
+                 * synchronously through the whole writeBuffer: the writer has
+                 * to be done with both first. */
+                if (!SD_WriteSlotsBarrier()) {
+                    gSDCardData.currentProcessState = SD_CARD_MANAGER_PROCESS_STATE_ERROR;
+                    break;
                 }
 
-                // Drain circular buffer completely before rotation to prevent data loss
+                /* Split the stream here: what is buffered now is the rest of
+                 * the part being retired, everything the encoder appends from
+                 * now on belongs to the next one.
+                 *
+                 * #757: the next part's window opens at this snapshot -- the
+                 * metadata latch is cleared and gSdRotating set under the same
+                 * mutex that reads the level, so the first thing the encoder
+                 * puts behind the snapshot is the NEW file's header, and
+                 * everything it produces during the drain, the sync, the close
+                 * and the open follows it in order. Holding wMutex matters:
+                 * sd_card_manager_WriteToBuffer takes it too, so an encoder
+                 * that has already decided to write the header cannot slip it
+                 * in ahead of the snapshot.
+                 *
+                 * This used to happen AFTER the drain, with a buffer reset, and
+                 * whatever the producer appended during the drain was dropped
+                 * (counted, but lost): it was newer than the old file's tail
+                 * and would have landed ahead of the new header. Arming first
+                 * leaves nothing in that position, so a rotation loses no bytes.
+                 *
+                 * Conditional on actually rotating: the split-limit branch
+                 * below never opens a new file, so promising a drain there
+                 * would strand whatever accumulated. */
+                const bool willRotate =
+                        (gSDCardData.fileCounter < SD_CARD_MANAGER_MAX_SPLIT_FILES);
                 SD_TakeMutexDebug(gSDCardData.wMutex, "drain_buffer_check");
+                /* Container mode: the old file's last block and index go in
+                 * ahead of the snapshot, so the drain closes it properly and
+                 * the writer starts the next part on a block boundary. */
+                sd_LogSeal();
                 size_t bufferBytes = CircularBuf_NumBytesAvailable(&gSDCardData.wCirbuf);
+                if (willRotate) {
+                    Streaming_ResetSdFileHeader();
+                    gSdRotating = true;
+                }
                 xSemaphoreGive(gSDCardData.wMutex);
 
                 if (bufferBytes > 0) {
@@ -2557,14 +3200,14 @@ void sd_card_manager_ProcessState() {
                                     gSDCardData.sdCardWriteBufferOffset = 0;
                                     break;
                                 } else if ((size_t)writeLen >= gSDCardData.writeBufferLength) {
-                                    gSDCardData.currentFileBytes += gSDCardData.writeBufferLength;
+                                    SD_AccountWritten((uint32_t)gSDCardData.writeBufferLength);
                                     SD_TakeMutexDebug(gSDCardData.wMutex, "drain_complete");
                                     gSDCardData.sdCardWritePending = 0;
                                     gSDCardData.writeBufferLength = 0;
                                     gSDCardData.sdCardWriteBufferOffset = 0;
                                     xSemaphoreGive(gSDCardData.wMutex);
                                 } else if (writeLen > 0) {
-                                    gSDCardData.currentFileBytes += writeLen;
+                                    SD_AccountWritten((uint32_t)writeLen);
                                     gSDCardData.writeBufferLength -= writeLen;
                                     gSDCardData.sdCardWriteBufferOffset += writeLen;
                                 } else {
@@ -2592,86 +3235,9 @@ void sd_card_manager_ProcessState() {
                     }
                 }
 
-                /* #757: arm the NEW file's buffer BEFORE the sync and close,
-                 * not after.
-                 *
-                 * IsWriteReady() stays true right up to the FileClose below,
-                 * so the streaming task keeps enqueuing throughout the sync --
-                 * which is the slow part. Doing the reset afterwards meant
-                 * those bytes were sitting in the buffer when it was cleared,
-                 * and they were DISCARDED: ~95 bytes per rotation, invisible,
-                 * because nothing counted them. (Measured by counting them:
-                 * 3,702 bytes across 39 rotations in one 25 s arm. The old
-                 * code discarded them too, just as silently.)
-                 *
-                 * Resetting here instead keeps them. The buffer is empty at
-                 * this point -- the drain above just emptied it into the old
-                 * file -- so clearing the metadata latch now means the encoder
-                 * writes the NEW file's header first and everything enqueued
-                 * during the sync, the close and the open follows it, in
-                 * order, into the new file. Nothing is dropped and the header
-                 * is still at byte 0.
-                 *
-                 * Conditional on actually rotating: the split-limit branch
-                 * below never opens a new file, so promising a drain there
-                 * would strand whatever accumulated. */
-                const bool willRotate =
-                        (gSDCardData.fileCounter < SD_CARD_MANAGER_MAX_SPLIT_FILES);
-                if (willRotate) {
-                    /* The metadata clear MUST be inside the same mutex as the
-                     * buffer reset, not before it.
-                     *
-                     * Streaming_ResetSdFileHeader() sets gSdFileWasReady=false,
-                     * which is the encoder's cue to emit the next file's
-                     * header. The old file is still open here, so
-                     * IsBufferAccepting() is true; if the pri-6 streaming task
-                     * preempts this pri-5 one between that clear and the reset,
-                     * it generates the header, writes it into the buffer, and
-                     * sets gSdFileWasReady=true -- and then the reset below
-                     * wipes it. Nothing re-emits it (OPEN_FILE skips its own
-                     * reset while gSdRotating is true) and nothing counts it,
-                     * so the split file starts with data rows and no header,
-                     * silently. That is the same class of defect this issue is
-                     * about, arriving through the fix for it.
-                     *
-                     * Holding wMutex across both closes it, because
-                     * sd_card_manager_WriteToBuffer takes the same mutex: an
-                     * encoder that has already decided to write the header
-                     * blocks until the reset is done and then lands it in the
-                     * emptied buffer, still at byte 0. */
-                    SD_TakeMutexDebug(gSDCardData.wMutex, "rotation_open_window");
-                    Streaming_ResetSdFileHeader();
-                    /* #822: whatever the producer appended DURING the drain is
-                     * still here, and this reset is about to destroy it.
-                     *
-                     * It cannot be saved. It is newer than everything drained,
-                     * so it cannot go into the old file without reopening the
-                     * unbounded-drain livelock that #822 is; and it cannot be
-                     * carried into the new one, because ResetSdPbMetadata()
-                     * above has just armed the next header and these bytes
-                     * would land AHEAD of it.
-                     *
-                     * So it is dropped -- but it is COUNTED. The bounded drain
-                     * traded #822's visible overshoot for a discard, and an
-                     * uncounted discard would be the worse of the two: the
-                     * bytes were ACCEPTED by WriteToBuffer, so without this
-                     * they appear in neither file nor in SdDroppedBytes, and
-                     * the gap is invisible. Same reasoning, same accounting, as
-                     * sd_AbandonRotationWindow(). */
-                    size_t stranded =
-                            CircularBuf_NumBytesAvailable(&gSDCardData.wCirbuf);
-                    CircularBuf_Reset(&gSDCardData.wCirbuf);
-                    gSdRotating = true;
-                    xSemaphoreGive(gSDCardData.wMutex);
-                    if (stranded > 0u) {
-                        Streaming_ReportSdDiscard(stranded);
-                        LOG_D("[SD] rotation dropped %u byte(s) buffered during drain\r\n",
-                              (unsigned)stranded);
-                    }
-                }
-
                 // Flush and close current file
                 if (gSDCardData.fileHandle != SYS_FS_HANDLE_INVALID) {
+                    SD_ReleaseLogFile();
                     // Always sync before close - ensures all filesystem buffers flushed
                     // Not just our counter, but also FS driver and SD card controller caches
                     TickType_t syncStart = xTaskGetTickCount();
@@ -2704,27 +3270,15 @@ void sd_card_manager_ProcessState() {
                          gSDCardData.filePath, gSDCardData.currentFileBytes);
                 }
 
-                /* #757: open the buffer for the NEW file before the slow open.
-                 *
-                 * The previous ordering deferred both resets to OPEN_FILE so
-                 * the streaming task could not burn its one-shot header flag
-                 * before the new file existed. That ordering is precisely what
-                 * made this window lossy: the flag stayed set, no handle
-                 * existed, so the encoder was told sdSize == 0 and everything
-                 * it produced during the open was discarded and counted.
-                 *
-                 * Reversing it is safe because the drain above emptied the
-                 * buffer into the OLD file. Resetting the metadata here means
-                 * the first thing the encoder puts into the now-empty buffer
-                 * is the NEW file's header -- still at byte 0 -- and whatever
-                 * it encodes during the open follows in order. The buffer
-                 * reset is kept for the error paths where the drain could not
-                 * complete; on the normal path it is a no-op. */
+                /* #757: the NEW file's buffer has been open since the drain
+                 * snapshot. Deferring the metadata reset to OPEN_FILE, as this
+                 * once did, left the encoder with no handle and sdSize == 0
+                 * for the whole open, and everything it produced then was
+                 * discarded. The drain took exactly the old file's share, so
+                 * the buffer now starts with the new file's header. */
                 if (willRotate) {
-                    /* The window was already opened above, before the sync and
-                     * close, so that everything the encoder produced during
-                     * them is kept rather than discarded. All that remains is
-                     * to advance to the next file. */
+                    /* All that remains is to advance to the next file --
+                     * adopting it if it was pre-created. */
                     if (gSDCardData.currentProcessState
                         == SD_CARD_MANAGER_PROCESS_STATE_ERROR) {
                         /* #825: the drain above could not write its backlog and set
@@ -2738,6 +3292,7 @@ void sd_card_manager_ProcessState() {
                          * close it here exactly as the file-close failure does. */
                         sd_AbandonRotationWindow("drain write failed");
                     } else {
+                        SD_RecordClosedCrc();
                         gSDCardData.fileCounter++;
                         gSDCardData.currentProcessState = SD_CARD_MANAGER_PROCESS_STATE_OPEN_FILE;
                     }
@@ -2746,6 +3301,7 @@ void sd_card_manager_ProcessState() {
                           __FILE__, __LINE__, SD_CARD_MANAGER_MAX_SPLIT_FILES);
                     // Cleanly stop: close file if open and signal completion to prevent deadlock
                     if (gSDCardData.fileHandle != SYS_FS_HANDLE_INVALID) {
+                        SD_ReleaseLogFile();
                         TickType_t syncStart = xTaskGetTickCount();
                         int syncResult = SYS_FS_FileSync(gSDCardData.fileHandle);
                         SD_CheckFsOpDuration(syncStart, "FileSync(limit_stop)", syncResult);
@@ -2754,6 +3310,8 @@ void sd_card_manager_ProcessState() {
                         }
                         if (SYS_FS_FileClose(gSDCardData.fileHandle) == SYS_FS_RES_FAILURE) {
                             LOG_E("[SD] Failed to close file at split limit, error=%d", SYS_FS_Error());
+                        } else {
+                            SD_RecordClosedCrc();
                         }
                         gSDCardData.fileHandle = SYS_FS_HANDLE_INVALID;
                     }
@@ -2764,10 +3322,12 @@ void sd_card_manager_ProcessState() {
                      * just closed above. Count it here rather than let the next reset
                      * discard it silently, which is the same obligation the drain has.
                      * A clean stop already drained the buffer, so this is a no-op then.
-                     * Mirrors the #823 stranded-remainder accounting in the rotation path. */
+                     * Mirrors the #823 stranded-remainder accounting the rotation path had
+                     * before its drain snapshot began splitting the stream instead. */
                     SD_TakeMutexDebug(gSDCardData.wMutex, "split_limit_strand");
                     size_t splitStranded = CircularBuf_NumBytesAvailable(&gSDCardData.wCirbuf);
                     CircularBuf_Reset(&gSDCardData.wCirbuf);
+                    SdLogWriter_Begin(&gSdLog);
                     xSemaphoreGive(gSDCardData.wMutex);
                     if (splitStranded > 0u) {
                         Streaming_ReportSdDiscard(splitStranded);
@@ -2796,12 +3356,23 @@ void sd_card_manager_ProcessState() {
             uint64_t currentMillis = pdTICKS_TO_MS(xTaskGetTickCount());
 
             SD_TakeMutexDebug(gSDCardData.wMutex, "periodic_flush_check");
-            bool needsFlush = (currentMillis - gSDCardData.lastFlushMillis > 5000 ||
-                    gSDCardData.totalBytesFlushPending > SD_FLUSH_THRESHOLD) &&
+            /* A sync needs the file system, so it waits for the writer. Past
+             * the threshold alone that wait would come nearly every pass and
+             * undo the ping-pong, so the threshold sync is taken only when
+             * the writer is idle; the 5 s deadline still forces one. */
+            bool flushDue = currentMillis - gSDCardData.lastFlushMillis > 5000;
+            bool needsFlush = (flushDue ||
+                    (gSDCardData.totalBytesFlushPending > SD_FLUSH_THRESHOLD &&
+                     SdWriteSlots_InFlight(&gSDCardData.writeSlots) == 0u)) &&
                     gSDCardData.totalBytesFlushPending > 0;
             if (needsFlush) {
                 xSemaphoreGive(gSDCardData.wMutex);
 
+                if (!SD_WriteSlotsBarrier()) {
+                    gSDCardData.currentProcessState = SD_CARD_MANAGER_PROCESS_STATE_ERROR;
+                    break;
+                }
+
                 TickType_t syncStart = xTaskGetTickCount();
                 int syncResult = SYS_FS_FileSync(gSDCardData.fileHandle);
                 SD_CheckFsOpDuration(syncStart, "FileSync(periodic)", syncResult);
@@ -2832,18 +3403,11 @@ void sd_card_manager_ProcessState() {
             // Yields every 1 second to other tasks. Priority boosted to prevent preemption.
             // Diagnostic logging added for GitHub #146.
 
-            uint32_t totalBytesRead = 0;
-            uint32_t readCount = 0;
-
             // Boost task priority to match USB tasks for balanced time slicing
             TaskHandle_t currentTask = xTaskGetCurrentTaskHandle();
             UBaseType_t originalPriority = uxTaskPriorityGet(currentTask);
             vTaskPrioritySet(currentTask, 7);  // Same as USB tasks for round-robin scheduling
 
-            // Track time for periodic yielding
-            TickType_t lastYieldTime = xTaskGetTickCount();
-            const TickType_t yieldInterval = pdMS_TO_TICKS(1000);
-
             // EOF marker as literal constant (safer than sprintf).
             // Declared before the buffer-size check so the terminal bail
             // below (#703) can also emit it.
@@ -2890,136 +3454,128 @@ void sd_card_manager_ProcessState() {
             // Clear abort flag at start of transfer
             gTransferAbortRequested = false;
 
-            // Read entire file in continuous loop
-            while (1) {
-                // Check for user-requested abort
-                if (gTransferAbortRequested) {
-                    gTransferAbortRequested = false;
-                    LOG_E("[SD] Transfer ABORTED at %u bytes", totalBytesRead);
-                    sd_wait_usb_drain();
-                    /* Emit the terminator ONLY if no file content went out.
-                     *
-                     * That is #723's actual precedent: it made the PRE-transfer
-                     * failures terminal (buffer-too-small, open-failure) — both
-                     * of which have sent nothing — and #725 records why the
-                     * mid-transfer case was deliberately left out:
-                     *
-                     *   "sending a plain EOF marker after partial data would
-                     *    convert a detectable hang into a silently truncated
-                     *    file that looks complete — the wrong trade for a
-                     *    data-acquisition product"
-                     *
-                     * An earlier revision of this fix emitted it
-                     * unconditionally, which contradicts that decision: a host
-                     * would have accepted a truncated capture as a whole one.
-                     * A hang is recoverable and visible; a short file that
-                     * looks complete is neither.
-                     *
-                     * So: nothing sent -> terminate cleanly (the host learns
-                     * the transfer produced no data). Partial data sent -> stay
-                     * silent until #725 gives us a DISTINGUISHABLE terminator,
-                     * which is the only thing that makes this case honest.
-                     *
-                     * Skipping the emit on the partial path also avoids a
-                     * second stall: DataReadyCB retries for 10 s, and the abort
-                     * is reached precisely when the peer is not draining. */
-                    if (totalBytesRead == 0u) {
+            /* What to send: the file, or the requested range. A ranged SD:GET
+             * is framed (Util/SdReadPump.h): definite-length blocks with a
+             * CRC-32 each, ending in an empty block instead of the EOF
+             * marker, so the host can verify every block and resume after
+             * the last good one. */
+            const bool framed = (gpSDCardSettings->readSelect == SD_CARD_READ_BYTES);
+            uint32_t length = 0;
+            const bool rangeOk = sd_ResolveReadRange(&length);
+
+            /* The shared buffer is split in two: the next chunk is read from
+             * the card while the reply transport drains the previous one. */
+            sd_read_pump_ctx_t pumpCtx = {
+                .readCount = 0,
+                .lastYieldTime = xTaskGetTickCount(),
+            };
+            const SdReadPumpIo_t pumpIo = {
+                .read = sd_PumpRead,
+                .trySend = sd_PumpTrySend,
+                .send = sd_PumpSend,
+                .aborted = sd_PumpAborted,
+                .ctx = &pumpCtx,
+            };
+            uint64_t totalBytesRead = 0;
+            SdReadPumpResult pumpResult = rangeOk
+                    ? SdReadPump_Run(&pumpIo, gSdSharedBuffer, maxRead, length,
+                                     framed, &totalBytesRead)
+                    : SD_READ_PUMP_READ_ERROR;
+
+            if (pumpResult == SD_READ_PUMP_ABORTED &&
+                gSDCardData.fileHandle == SYS_FS_HANDLE_INVALID) {
+                // Abort if file handle became invalid
+                LOG_E("[SD] Transfer ABORTED: file handle invalid");
+            } else if (pumpResult == SD_READ_PUMP_ABORTED) {
+                // User-requested abort (or a reply transport that gave up)
+                gTransferAbortRequested = false;
+                LOG_E("[SD] Transfer ABORTED at %u bytes", (unsigned)totalBytesRead);
+                sd_wait_usb_drain();
+                /* Emit the terminator ONLY if no file content went out.
+                 *
+                 * That is #723's actual precedent: it made the PRE-transfer
+                 * failures terminal (buffer-too-small, open-failure) — both
+                 * of which have sent nothing — and #725 records why the
+                 * mid-transfer case was deliberately left out:
+                 *
+                 *   "sending a plain EOF marker after partial data would
+                 *    convert a detectable hang into a silently truncated
+                 *    file that looks complete — the wrong trade for a
+                 *    data-acquisition product"
+                 *
+                 * An earlier revision of this fix emitted it
+                 * unconditionally, which contradicts that decision: a host
+                 * would have accepted a truncated capture as a whole one.
+                 * A hang is recoverable and visible; a short file that
+                 * looks complete is neither.
+                 *
+                 * So: nothing sent -> terminate cleanly (the host learns
+                 * the transfer produced no data). Partial data sent -> stay
+                 * silent until #725 gives us a DISTINGUISHABLE terminator,
+                 * which is the only thing that makes this case honest. A
+                 * framed transfer is honest either way -- the host checks
+                 * each block's CRC -- but follows the same rule.
+                 *
+                 * Skipping the emit on the partial path also avoids a
+                 * second stall: DataReadyCB retries for 10 s, and the abort
+                 * is reached precisely when the peer is not draining. */
+                if (totalBytesRead == 0u) {
+                    if (framed) {
+                        (void)SdReadPump_SendEnd(&pumpIo);
+                    } else {
                         sd_card_manager_DataReadyCB(SD_CARD_MANAGER_MODE_READ,
                                 (uint8_t*)eofMarker, sizeof(eofMarker) - 1);
-                    } else {
-                        LOG_E("[SD] aborted after %u bytes - no terminator sent "
-                              "(a plain EOF would look like a complete file; "
-                              "#725 tracks a distinguishable one)",
-                              (unsigned)totalBytesRead);
-                    }
-                    if (gSDCardData.fileHandle != SYS_FS_HANDLE_INVALID) {
-                        SYS_FS_FileClose(gSDCardData.fileHandle);
-                        gSDCardData.fileHandle = SYS_FS_HANDLE_INVALID;
                     }
-                    totalBytesRead = 0;
-                    readCount = 0;
-                    break;
-                }
-
-                // Abort if file handle became invalid
-                if (gSDCardData.fileHandle == SYS_FS_HANDLE_INVALID) {
-                    LOG_E("[SD] Transfer ABORTED: file handle invalid");
-                    totalBytesRead = 0;
-                    readCount = 0;
-                    break;
+                } else {
+                    LOG_E("[SD] aborted after %u bytes - no terminator sent "
+                          "(a plain EOF would look like a complete file; "
+                          "#725 tracks a distinguishable one)",
+                          (unsigned)totalBytesRead);
                 }
+            } else if (pumpResult != SD_READ_PUMP_DONE) {
+                LOG_E("[SD] Transfer ERROR: %u MB, read#%u",
+                      (unsigned)(totalBytesRead / (1024u * 1024u)),
+                      (unsigned)pumpCtx.readCount);
 
-                // Read at maximum rate (backpressure handled by callback retry logic)
-                size_t bytesRead = SYS_FS_FileRead(gSDCardData.fileHandle, gSdSharedBuffer, maxRead);
-
-                if (bytesRead == (size_t) - 1) {
-                    LOG_E("[SD] Transfer ERROR: %u MB, read#%u", totalBytesRead/(1024*1024), readCount);
-
-                    // Wait for USB to drain any pending data before closing
-                    sd_wait_usb_drain();
-
-                    /* #725: send a DISTINGUISHABLE terminator, not silence and
-                     * not __END_OF_FILE__.
-                     *
-                     * Sending nothing (the old behaviour) leaves the host
-                     * waiting forever for a terminator that never arrives -- a
-                     * hang, with no way to tell it from a slow transfer.
-                     * Sending the normal EOF marker would be worse: the host
-                     * would accept a TRUNCATED file as complete, which on a
-                     * data-acquisition product means silently losing the tail
-                     * of a measurement. #703/PR #723 made the PRE-transfer
-                     * failures terminal for the same reason but deliberately
-                     * left this path alone rather than take that trade.
-                     *
-                     * A separate marker lets the host do the right thing: stop
-                     * waiting, and know the data is incomplete. */
-                    sd_card_manager_DataReadyCB(SD_CARD_MANAGER_MODE_READ,
-                            (uint8_t*)transferErrorMarker,
-                            sizeof(transferErrorMarker) - 1);
-
-                    // Close file handle to prevent resource leak
-                    if (SYS_FS_FileClose(gSDCardData.fileHandle) == SYS_FS_RES_FAILURE) {
-                        LOG_E("[SD] Failed to close file after read error, error=%d", SYS_FS_Error());
-                    }
-                    gSDCardData.fileHandle = SYS_FS_HANDLE_INVALID;
-                    totalBytesRead = 0;
-                    readCount = 0;
-                    break;
-
-                } else if (bytesRead == 0) {
-                    // End of file - wait for USB to drain before sending EOF marker
-                    sd_wait_usb_drain();
-
-                    // Send EOF marker using literal constant (safer than sprintf)
-                    sd_card_manager_DataReadyCB(SD_CARD_MANAGER_MODE_READ,
-                            (uint8_t*)eofMarker,
-                            sizeof(eofMarker) - 1);
+                // Wait for USB to drain any pending data before closing
+                sd_wait_usb_drain();
 
-                    // Close file handle
-                    if (SYS_FS_FileClose(gSDCardData.fileHandle) == SYS_FS_RES_FAILURE) {
-                        LOG_E("[SD] Failed to close file after read complete, error=%d", SYS_FS_Error());
-                    }
-                    gSDCardData.fileHandle = SYS_FS_HANDLE_INVALID;
+                /* #725: send a DISTINGUISHABLE terminator, not silence and
+                 * not __END_OF_FILE__.
+                 *
+                 * Sending nothing (the old behaviour) leaves the host
+                 * waiting forever for a terminator that never arrives -- a
+                 * hang, with no way to tell it from a slow transfer.
+                 * Sending the normal EOF marker would be worse: the host
+                 * would accept a TRUNCATED file as complete, which on a
+                 * data-acquisition product means silently losing the tail
+                 * of a measurement. #703/PR #723 made the PRE-transfer
+                 * failures terminal for the same reason but deliberately
+                 * left this path alone rather than take that trade.
+                 *
+                 * A separate marker lets the host do the right thing: stop
+                 * waiting, and know the data is incomplete. The pump stops
+                 * on a chunk boundary, so in a framed transfer the marker
+                 * stands where the next block header would. */
+                sd_card_manager_DataReadyCB(SD_CARD_MANAGER_MODE_READ,
+                        (uint8_t*)transferErrorMarker,
+                        sizeof(transferErrorMarker) - 1);
+            } else if (!framed) {
+                // End of file - wait for USB to drain before sending EOF marker
+                sd_wait_usb_drain();
 
-                    totalBytesRead = 0;
-                    readCount = 0;
-                    break;
+                // Send EOF marker using literal constant (safer than sprintf)
+                sd_card_manager_DataReadyCB(SD_CARD_MANAGER_MODE_READ,
+                        (uint8_t*)eofMarker,
+                        sizeof(eofMarker) - 1);
+            }
 
-                } else {
-                    // Data chunk read successfully
-                    totalBytesRead += bytesRead;
-                    readCount++;
-
-                    sd_card_manager_DataReadyCB(SD_CARD_MANAGER_MODE_READ,
-                            gSdSharedBuffer,
-                            bytesRead);
-
-                    // Delay every 1 second to allow lower priority tasks to run
-                    if ((xTaskGetTickCount() - lastYieldTime) >= yieldInterval) {
-                        vTaskDelay(pdMS_TO_TICKS(1));
-                        lastYieldTime = xTaskGetTickCount();
-                    }
+            // Close file handle to prevent resource leak
+            if (gSDCardData.fileHandle != SYS_FS_HANDLE_INVALID) {
+                if (SYS_FS_FileClose(gSDCardData.fileHandle) == SYS_FS_RES_FAILURE) {
+                    LOG_E("[SD] Failed to close file after read, error=%d", SYS_FS_Error());
                 }
+                gSDCardData.fileHandle = SYS_FS_HANDLE_INVALID;
             }
 
             // Restore original task priority
@@ -3153,9 +3709,10 @@ void sd_card_manager_ProcessState() {
                  * belt-and-braces for anything that reads the state before
                  * then -- not the load-bearing reset it was when the cursor
                  * persisted across sessions. */
-                gSDCardData.curBucket = 0u;
-                gSDCardData.bucketFileCountAtStart = 0u;
-                gSDCardData.filesInCurBucket = 0u;
+                SdBucket_Init(&gSDCardData.bucket, SD_CARD_MANAGER_MAX_DIR_FILES,
+                              SD_CARD_MANAGER_MAX_BUCKET);
+                /* Same for the write-time CRCs: those files are gone. */
+                memset(gSDCardData.closedCrc, 0, sizeof(gSDCardData.closedCrc));
                 /* bucketPath too, or the refusal LOG_E and the "bucket active"
                  * trace keep naming a P0xx directory the format just deleted --
                  * the state is cleared but its label still describes the old
@@ -3312,15 +3869,34 @@ void sd_card_manager_ProcessState() {
     }
 }
 
-void sd_card_manager_SetWriteBuffer(uint8_t* buf, uint32_t size) {
-    if (buf == NULL || size == 0) return;
+bool sd_card_manager_SetWriteBuffer(uint8_t* buf, uint32_t size) {
+    if (buf == NULL || size == 0) return false;
+
+    /* The log writer may still be reading a slot of the old buffer; give it
+     * the time it needs to finish (slots are re-carved by the SD task). */
+    TickType_t t = xTaskGetTickCount();
+    while (SdWriteSlots_InFlight(&gSDCardData.writeSlots) > 0u
+           && (xTaskGetTickCount() - t) < pdMS_TO_TICKS(1000)) {
+        vTaskDelay(1);
+    }
 
     SD_TakeMutexDebug(gSDCardData.wMutex, "set_write_buffer");
+    /* Still writing after the wait: moving writeBuffer now would let the
+     * pump re-carve slots over a chunk the writer is reading. Keep the old
+     * buffer and let the caller abort. */
+    uint32_t inFlight = SdWriteSlots_InFlight(&gSDCardData.writeSlots);
+    if (inFlight > 0u) {
+        xSemaphoreGive(gSDCardData.wMutex);
+        LOG_E("[SD] write buffer swap refused: %u chunks still in flight",
+              (unsigned) inFlight);
+        return false;
+    }
     gSDCardData.writeBuffer = buf;
     gSDCardData.writeBufferSize = size;
     gSDCardData.writeBufferLength = 0;
     gSDCardData.sdCardWriteBufferOffset = 0;
     xSemaphoreGive(gSDCardData.wMutex);
+    return true;
 }
 
 void sd_card_manager_SetCircularBuffer(uint8_t* buf, uint32_t size) {
@@ -3334,6 +3910,15 @@ void sd_card_manager_SetCircularBuffer(uint8_t* buf, uint32_t size) {
     xSemaphoreGive(gSDCardData.wMutex);
 }
 
+void sd_card_manager_StageWriteMark(const SdLogMark_t* mark) {
+    gSdLogMark = *mark;
+    gSdLogMarkSet = true;
+}
+
+bool sd_card_manager_ContainerEnabled(void) {
+    return gSdLogActive || gpSDCardSettings->container;
+}
+
 size_t sd_card_manager_WriteToBuffer(const char* pData, size_t len) {
     if (len == 0) return 0;
     if (gpSDCardSettings->enable != 1 || gpSDCardSettings->mode != SD_CARD_MANAGER_MODE_WRITE) {
@@ -3369,6 +3954,20 @@ size_t sd_card_manager_WriteToBuffer(const char* pData, size_t len) {
         xSemaphoreGive(gSDCardData.wMutex);
         return 0;
     }
+    if (gSdLogActive) {
+        /* Container mode: reserve room for the seal too (SdLogWriter_Cost), so
+         * a rotation or unmount can always close the file from the ring. */
+        const SdLogMark_t* mark = gSdLogMarkSet ? &gSdLogMark : NULL;
+        if (CircularBuf_NumBytesFree(&gSDCardData.wCirbuf) <
+                SdLogWriter_Cost(&gSdLog, len, mark)) {
+            xSemaphoreGive(gSDCardData.wMutex);
+            return 0;
+        }
+        SdLogWriter_Append(&gSdLog, (const uint8_t*)pData, len, mark, sd_LogSink, NULL);
+        gSdLogMarkSet = false;
+        xSemaphoreGive(gSDCardData.wMutex);
+        return len;
+    }
     if (CircularBuf_NumBytesFree(&gSDCardData.wCirbuf) < len) {
         xSemaphoreGive(gSDCardData.wMutex);
         return 0;
@@ -3378,6 +3977,37 @@ size_t sd_card_manager_WriteToBuffer(const char* pData, size_t len) {
     return bytesAdded;
 }
 
+uint8_t* sd_card_manager_ReserveWriteSpan(size_t minLen, size_t* pLen) {
+    *pLen = 0;
+    if (gpSDCardSettings->enable != 1 || gpSDCardSettings->mode != SD_CARD_MANAGER_MODE_WRITE) {
+        return NULL;
+    }
+
+    SD_TakeMutexDebug(gSDCardData.wMutex, "write_buffer_reserve");
+    /* #757: same authoritative re-check as WriteToBuffer. Holding the mutex
+     * until the commit also keeps sd_AbandonRotationWindow() from resetting
+     * the buffer underneath the span being filled. */
+    if (!sd_card_manager_IsBufferAccepting() || gSdLogActive) {
+        /* Container blocks are cut on append: no in-place encode. */
+        xSemaphoreGive(gSDCardData.wMutex);
+        return NULL;
+    }
+    uint32_t span = 0;
+    uint8_t* p = CircularBuf_Reserve(&gSDCardData.wCirbuf, &span);
+    if (p == NULL || span < minLen) {
+        xSemaphoreGive(gSDCardData.wMutex);
+        return NULL;
+    }
+    *pLen = span;
+    return p;
+}
+
+size_t sd_card_manager_CommitWriteSpan(size_t len) {
+    size_t bytesAdded = CircularBuf_Commit(&gSDCardData.wCirbuf, (uint32_t)len);
+    xSemaphoreGive(gSDCardData.wMutex);
+    return bytesAdded;
+}
+
 bool sd_card_manager_Deinit() {
     /* enable BEFORE the state, so the SD task can never observe
      * "DEINIT but still enabled" and re-arm off the stale flag. */
@@ -3871,12 +4501,12 @@ bool sd_card_manager_IsWriteReady(void) {
  *
  * During a rotation the old handle is closed before the new one is opened, and
  * the open is slow: a FatFs create is O(N) in directory occupancy, which is
- * why the loss this fixes grew with the number of files on the card. The
- * buffer is empty across that window (the rotation drains it before closing)
- * and its contents go to the NEW file, so accepting writes is safe and the
+ * why the loss this fixes grew with the number of files on the card. Across
+ * that window the buffer holds only NEW file bytes (the rotation drains the
+ * old file's share before closing), so accepting writes is safe and the
  * header still lands at byte 0 -- Streaming_ResetSdFileHeader() is called
- * before the window opens, so the first thing the encoder puts in the empty
- * buffer is the new file's header.
+ * as the window opens, so the first thing the encoder puts in the buffer
+ * behind the old file's tail is the new file's header.
  *
  * Returns false once the open resolves, in both directions: on success the
  * WRITE_TO_FILE arm above takes over, and on failure or teardown the flag is
@@ -4002,6 +4632,10 @@ size_t sd_card_manager_GetWriteBuffFreeSize() {
     // Must protect circular buffer access with mutex
     SD_TakeMutexDebug(gSDCardData.wMutex, "get_free_size");
     size_t freeSize = CircularBuf_NumBytesFree(&gSDCardData.wCirbuf);
+    if (gSdLogActive) {
+        // Payload that fits, after framing and the reserved seal.
+        freeSize = SdLogWriter_Room(&gSdLog, freeSize);
+    }
     xSemaphoreGive(gSDCardData.wMutex);
 
     if (!logged) {
@@ -4031,6 +4665,31 @@ void sd_card_manager_TrackWrite(uint32_t sectors, bool success, uint32_t elapsed
     taskEXIT_CRITICAL();
 }
 
+static void SD_TrackSlot(uint32_t writes, uint32_t overlapStages, uint32_t barrierWaits) {
+    taskENTER_CRITICAL();
+    gSdWriteMetrics.slotWrites += writes;
+    gSdWriteMetrics.slotOverlapStages += overlapStages;
+    gSdWriteMetrics.slotBarrierWaits += barrierWaits;
+    taskEXIT_CRITICAL();
+}
+
+static void SD_TrackPrealloc(uint32_t files, uint32_t fallbacks) {
+    taskENTER_CRITICAL();
+    gSdWriteMetrics.preallocFiles += files;
+    gSdWriteMetrics.preallocFallbacks += fallbacks;
+    taskEXIT_CRITICAL();
+}
+
+static void SD_TrackRotation(uint32_t precreated, uint32_t inlined) {
+    if (precreated == 0u && inlined == 0u) {
+        return;
+    }
+    taskENTER_CRITICAL();
+    gSdWriteMetrics.rotationsPrecreated += precreated;
+    gSdWriteMetrics.rotationsInline += inlined;
+    taskEXIT_CRITICAL();
+}
+
 void sd_card_manager_GetWriteMetricsSnapshot(sd_card_write_metrics_t* out) {
     taskENTER_CRITICAL();
     *out = gSdWriteMetrics;
@@ -9,6 +9,7 @@
 #include "definitions.h"
 #include "services/daqifi_settings.h"
 #include "Util/CircularBuffer.h"
+#include "Util/SdLogContainer.h"
 
 #define SD_CARD_MANAGER_CONF_RBUFFER_SIZE 512   // Small buffer, send directory listings in chunks
 #define SD_CARD_MANAGER_CONF_WBUFFER_SIZE 65536  // 64KB DMA write buffer max (coherent, sector-aligned)
@@ -29,6 +30,7 @@
 // WriteToBuffer timeout/wait removed — now non-blocking, callers use
 // Streaming_WriteWithRetry for uniform backpressure across all interfaces
 #define SD_CARD_MANAGER_MAX_CHUNKS_PER_CYCLE 4     // Max chunks to process per task cycle (4 * 5KB = 20KB)
+#define SD_CARD_MANAGER_WRITE_SLOTS 2              // Write buffer split into this many slots: stage one while the writer task puts the other on the card
 #define SD_CARD_MANAGER_TASK_DELAY_MS 1            // Task delay for SD card processing (reduced from 5ms)
 
 // Device paths for SD card operations
@@ -56,6 +58,15 @@ extern "C" {
         SD_CARD_REPLY_WIFI_TCP = 1,
     } sd_card_manager_reply_target_t;
 
+    /** Which part of opFile a READ sends (SD:GET / GET:BLOCks / GET:TIMe). */
+    typedef enum {
+        SD_CARD_READ_ALL = 0,       /**< the whole file */
+        SD_CARD_READ_BLOCKS = 1,    /**< container blocks [readArg1, readArg1 + readArg2) */
+        SD_CARD_READ_TIME = 2,      /**< container blocks holding ticks readArg1..readArg2 */
+        SD_CARD_READ_BYTES = 3,     /**< bytes [readArg1, readArg1 + readArg2), 0 = to the
+                                         end, sent framed (Util/SdReadPump.h) */
+    } sd_card_manager_read_select_t;
+
     typedef struct {
         bool enable;
         sd_card_manager_mode_t mode;
@@ -93,6 +104,23 @@ extern "C" {
         // and rejects with SCPI -200 if the card has fewer than this
         // many bytes free.  0 = no pre-start check (legacy behavior).
         uint64_t minFreeBytes;
+        // Contiguous preallocation per log file (SD:PREALLoc).  When > 0,
+        // OPEN_FILE reserves min(this, maxFileSizeBytes) as one cluster
+        // chain and rotation/close gives the unwritten tail back, so the
+        // streaming writes never allocate.  0 = grow cluster by cluster.
+        uint32_t preallocBytes;
+        // Container-mode logging (SD:CONTainer, Util/SdLogContainer.h).
+        // When set, the next session's files are written as indexed
+        // 4 KB blocks instead of the bare stream.  Latched when a session
+        // opens its first file, so changing it mid-session has no effect.
+        bool container;
+        // Transient READ range, set per request like opFile.  ALL for
+        // SD:GET; BLOCKS and TIME need a container-mode file and are
+        // resolved to a block range by the SD task before it seeks.  TIME
+        // arguments are timestamp ticks after the file's first record.
+        sd_card_manager_read_select_t readSelect;
+        uint64_t readArg1;
+        uint64_t readArg2;
     } sd_card_manager_settings_t;
 
 
@@ -153,6 +181,18 @@ extern "C" {
      */
     void sd_card_manager_ProcessState(void);
 
+    /**
+     * @brief Body of the SD writer task.
+     *
+     * Puts the log chunks the state machine stages into the write buffer's
+     * slots on the card, in order, so the next chunk can be staged while the
+     * previous one is transferring. Only ever touches the open log file, and
+     * only while the state machine has slots outstanding -- the state machine
+     * waits for it before any other file system call (FatFs is built without
+     * FF_FS_REENTRANT). Never returns.
+     */
+    void sd_card_manager_WriterTask(void);
+
     /**
      * @brief Writes data to the SD card manager's write buffer.
      *
@@ -173,6 +213,54 @@ extern "C" {
      */
     size_t sd_card_manager_WriteToBuffer(const char* pData, size_t len);
 
+    /**
+     * @brief Describes the bytes of the next successful WriteToBuffer().
+     *
+     * Container-mode logs record, per block, the timestamps and sample count
+     * of what was written into it; the producer states them here before the
+     * write. The mark is held until a write succeeds, so a retried write
+     * keeps it. Without one, the write is filed as opaque header bytes.
+     * Ignored outside container mode.
+     *
+     * @note Producer-only, like WriteToBuffer (the streaming task).
+     */
+    void sd_card_manager_StageWriteMark(const SdLogMark_t* mark);
+
+    /**
+     * @brief True if the session's SD files are (or will be) container-mode.
+     *
+     * Container blocks are cut as the bytes go into the ring, which rules out
+     * encoding in place (ReserveWriteSpan) and the USB+SD fan-out queue; the
+     * streaming task uses this to pick the copy path.
+     */
+    bool sd_card_manager_ContainerEnabled(void);
+
+    /**
+     * @brief Reserves a contiguous span of the write buffer to encode into.
+     *
+     * Zero-copy counterpart of sd_card_manager_WriteToBuffer(): the streaming
+     * task encodes straight into the returned span and then commits. Applies
+     * the same enable/mode and #757 accept checks, under the same mutex.
+     *
+     * @param[in]  minLen Smallest span worth taking.
+     * @param[out] pLen   Receives the span length.
+     *
+     * @return The span, or NULL (nothing held) if SD is not accepting or the
+     *         contiguous span is shorter than minLen.
+     *
+     * @note On success the buffer mutex is HELD until
+     *       sd_card_manager_CommitWriteSpan(), which must follow promptly on
+     *       the same task: the SD task cannot drain while it is held.
+     */
+    uint8_t* sd_card_manager_ReserveWriteSpan(size_t minLen, size_t* pLen);
+
+    /**
+     * @brief Publishes len bytes of the reserved span and releases the mutex.
+     *
+     * @return The number of bytes committed (0 abandons the reservation).
+     */
+    size_t sd_card_manager_CommitWriteSpan(size_t len);
+
     /**
      * @brief Retrieves the amount of free space available in the write buffer.
      *
@@ -203,11 +291,15 @@ extern "C" {
      * The buffer pointer comes from CoherentPool (DMA-safe).
      * Called at each stream start to optimize DMA size for active interfaces.
      * Must only be called when streaming is stopped and SD is idle.
+     * Waits up to 1 s for the log writer to finish its in-flight chunks and
+     * refuses the swap (logged) if any are still in flight after that.
      *
      * @param buf   Pointer to coherent buffer memory
      * @param size  Buffer size in bytes
+     * @return true if the buffer was swapped; false on bad arguments or a
+     *         write still in flight (the old buffer stays in place)
      */
-    void sd_card_manager_SetWriteBuffer(uint8_t* buf, uint32_t size);
+    bool sd_card_manager_SetWriteBuffer(uint8_t* buf, uint32_t size);
 
     /**
      * @brief Checks if the SD card manager is currently idle (not processing any operation).
@@ -512,6 +604,19 @@ void sd_card_manager_ReleaseClaim(void);
      */
     void sd_card_manager_DataReadyCB(sd_card_manager_mode_t mode, uint8_t *pDataBuff, size_t dataLen);
 
+    /**
+     * @brief Non-blocking form of sd_card_manager_DataReadyCB (READ only).
+     *
+     * Hands over as much of the data as the reply transport takes right now
+     * and returns without waiting. The READ loop offers each chunk this way
+     * before reading the next one from the card, and completes it with
+     * sd_card_manager_DataReadyCB afterwards, so the transport drains while
+     * the card is read. Weakly linked like DataReadyCB.
+     *
+     * @return Bytes taken (dataLen if the transfer was aborted)
+     */
+    size_t sd_card_manager_DataReadyTryCB(sd_card_manager_mode_t mode, const uint8_t *pDataBuff, size_t dataLen);
+
     /**
      * @brief SD write metrics for diagnosing performance and errors.
      */
@@ -522,6 +627,13 @@ void sd_card_manager_ReleaseClaim(void);
         uint32_t writeErrors;         /**< disk_write returned error */
         uint32_t writeMaxLatencyMs;   /**< Worst-case single write latency */
         uint32_t writeAlignedCopies;  /**< Writes needing aligned buffer copy */
+        uint32_t slotWrites;          /**< Log chunks completed by the writer task */
+        uint32_t slotOverlapStages;   /**< Chunks staged while another was still being written */
+        uint32_t slotBarrierWaits;    /**< Times the state machine waited on the writer before a sync/close */
+        uint32_t preallocFiles;       /**< Log files opened with a contiguous preallocated extent */
+        uint32_t preallocFallbacks;   /**< Preallocation refused (no contiguous space); file grew normally */
+        uint32_t rotationsPrecreated; /**< Rotations that adopted a part created ahead of time */
+        uint32_t rotationsInline;     /**< Rotations that had to create the part inside the rotation window */
     } sd_card_write_metrics_t;
 
     /**
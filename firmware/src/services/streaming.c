@@ -18,6 +18,8 @@
  */
 
 #include "streaming.h"
+#include "streaming_encode.h"
+#include "semphr.h"  // gFanoutMutex (USB+SD fan-out queue)
 
 #if PB_PROFILE_COUNTERS
 #include <xc.h>  // for _CP0_GET_COUNT() — coprocessor 0 cycle counter
@@ -33,13 +35,22 @@
 #include "Util/Logger.h"
 #include "Util/CircularBuffer.h"
 #include "Util/StreamingBufferPool.h"
+#include "Util/SharedBlockQueue.h"
+#include "Util/TcpFanout.h"
+#include "Util/CRC32.h"
 #include "Util/CoherentPool.h"
+#include "Util/RateControl.h"
+#include "Util/AcqPlan.h"
+#include "Util/Decimator.h"
+#include "Util/CaptureRing.h"
 #include "UsbCdc/UsbCdc.h"
 #include "../HAL/TimerApi/TimerApi.h"
 #include "HAL/ADC/MC12bADC.h"
 #include "HAL/ADC/AdcThreshold.h"
+#include "HAL/UserEdge/UserEdge.h"
 #include "sd_card_services/sd_card_manager.h"
 #include "wifi_services/wifi_tcp_server.h"
+#include "wifi_services/wifi_udp_stream.h"
 #include "state/runtime/BoardRuntimeConfig.h"
 
 // --- Test pattern streaming mode ---
@@ -91,6 +102,68 @@ static volatile uint32_t gStreamBaseTS = 0;      // TMR6 at the session's first
 static volatile uint32_t gStreamPeriodTicks = 0; // TMR6 ticks per streaming tick (Start-computed)
 static volatile uint32_t gStreamTSSeeded = 0u;   // baseTS captured this session? (ISR latch)
 
+// SYST:STR:ADAPTive (AIMD rate control). The controller runs in streaming_Task
+// once per RATE_CONTROL_PERIOD_MS and publishes its divisor in gRateDivisor;
+// the deferred task turns only every gRateDivisor-th tick into a sample. Ticks
+// keep their deterministic stamps (#717), so a decimated stream is the same
+// timebase with a longer step, which the PB block encoder already splits on.
+//
+// A change takes effect at the deferred task's next emitted tick, which
+// records it (gRateChange*, written only there -- pri 9, so a lower-priority
+// reader snapshots them in a critical section) for the encoder to stamp
+// (Streaming_RateStampDue). Everything is reset in Streaming_Start before the
+// timer runs.
+#define RATE_CONTROL_PERIOD_MS  500u
+static bool gRateAdaptive = false;               // latched from AdaptiveRate at Start
+static RateControl_t gRateControl;               // streaming_Task only
+static volatile uint32_t gRateDivisor = 1u;      // target, written by streaming_Task
+static uint32_t gRateDivisorApplied = 1u;        // deferred task only
+static uint32_t gRateSkip = 0u;                  // deferred task only: ticks left to skip
+static volatile uint32_t gRateChangeSeq = 0u;    // bumped per applied change
+static volatile uint32_t gRateChangeTs = 0u;     // stamp of the first tick at the new divisor
+static volatile uint32_t gRateChangeDivisor = 1u;
+static uint32_t gRateStampedSeq = 0u;            // streaming_Task: last change stamped
+static volatile uint32_t gRateStampDivisor = 1u; // divisor of the last stamp taken
+static uint32_t gRateStampPendingSeq = 0u;       // streaming_Task: change being stamped
+static uint32_t gRateStampPrevDivisor = 1u;      // restored if that stamp is not written
+static TickType_t gRateLastTick = 0;             // streaming_Task: last control period
+static uint32_t gRateLastLost = 0u;
+static uint32_t gRateLastDropped = 0u;
+static uint32_t gRatePeakFill = 0u;              // peak pool fill % this period
+
+// SYST:STR:DECimate (Util/Decimator.h), latched at Start. While active the
+// deferred task runs the acquisition plan on every tick into gDecimIn and
+// only a tick that closes a window takes a pool slot, with the filtered
+// frame from gDecimOut. gDecimFactor (1 when off) also scales the rate
+// stamps, which describe the decimated stream. All deferred-task only once
+// the session runs.
+static bool gDecimActive = false;
+static uint32_t gDecimFactor = 1u;
+static volatile uint32_t gDecimBits = 0u;   // extra bits applied; see Streaming_CodeScaleBits
+static Decimator_t gDecimator;
+static uint32_t gDecimIn[DECIM_MAX_CHANNELS];
+static uint32_t gDecimOut[DECIM_MAX_CHANNELS];
+
+// The extra bits a session configured as @p cfg scales its codes by: PB and
+// raw mode carry codes, the volt encoders get them at native scale.
+static uint32_t Streaming_DecimScaleBits(const StreamingRuntimeConfig* cfg) {
+    bool rawCodes = Streaming_EncodingIsPb(cfg->Encoding) || cfg->RawOutputMode;
+    return rawCodes ? cfg->DecimateExtraBits : 0u;
+}
+
+// SYST:STR:CAPture (Util/CaptureRing.h), latched at Start. While active the
+// deferred task writes every tick into gCapture, which lives in the
+// StreamingBufferPool tail, instead of the sample pool; once the capture is
+// DONE it replays the ring through the sample pool, so the session's own
+// encoder and transport carry it out. gCaptureForceSeq is bumped by
+// SYST:STR:CAPture:FORCe (SCPI task, single writer) and polled by the
+// deferred task; the rest is deferred-task only once the session runs.
+#define CAPTURE_REPLAY_PER_TICK 16u
+static bool gCaptureActive = false;
+static CaptureRing_t gCapture;
+static CaptureTrigger_t gCaptureTrigger;
+static volatile uint32_t gCaptureForceSeq = 0u;
+
 // Benchmark mode level (BENCHMARK_OFF/NOCAP/PIPELINE).
 // Uses uint32_t for guaranteed 32-bit atomic access on PIC32MZ.
 static volatile uint32_t gBenchmarkMode = BENCHMARK_OFF;
@@ -246,6 +319,22 @@ static volatile bool gPrimingPending = false;
  * already an unconditional expectation. */
 static volatile bool gSdExpectedThisSession = false;
 
+/* USB+SD fan-out queue (see Streaming_FanoutConfigure). The arena is the
+ * encoder region; gFanoutMutex serializes it between this task (producer,
+ * SD feeder) and the USB task (UsbCdc_BeginWrite -> Streaming_FanoutDrainUsb). */
+#define FANOUT_USB 0u
+#define FANOUT_SD  1u
+static SharedBlockQueue_t gFanout;
+static SemaphoreHandle_t gFanoutMutex = NULL;
+static volatile bool gFanoutActive = false;
+/* WiFi TCP fan-out: the same queue with one cursor per TCP client (consumer
+ * index = wifi_tcp_server client slot), also under gFanoutMutex. The WiFi
+ * task attaches and detaches clients as they connect and go. */
+static TcpFanout_t gWifiFanout;
+static volatile bool gFanoutWifi = false;
+/* A client attached mid-session: the next batch is encoded as a keyframe. */
+static volatile bool gFanoutWifiJoined = false;
+
 // Log-once flags: each error condition logs once per session via
 // LOG_E_SESSION / LOG_I_SESSION macros (gSessionOneShot bitmask in Logger).
 // All reset in Streaming_ClearStats() via Logger_ResetSessionOneShots().
@@ -349,10 +438,11 @@ static inline bool Streaming_PastStartupGrace(void) {
 
 // SD protobuf metadata field tags for standalone metadata message
 static const NanopbFlagsArray fields_sd_metadata = {
-    .Size = 6,
+    .Size = 7,
     .Data = {
         DaqifiOutMessage_timestamp_freq_tag,
         DaqifiOutMessage_analog_in_port_num_tag,
+        DaqifiOutMessage_analog_in_res_tag,    // carries the decimation code scale
         DaqifiOutMessage_digital_port_num_tag,
         DaqifiOutMessage_device_sn_tag,
         DaqifiOutMessage_device_pn_tag,
@@ -380,6 +470,10 @@ static const NanopbFlagsArray fields_sd_metadata = {
 // reads behind the IsEnabled check, so the mapping is fully written before
 // any reader sees it. On PIC32MZ single-core, no memory barriers are needed.
 static AInChannelMapping gChannelMapping = {0};
+// The deferred task's per-channel ops, compiled from the same config in
+// Streaming_BuildChannelMapping (see AcqPlan.h). Same write-before-enable
+// rule as gChannelMapping.
+static AcqPlan_t gAcqPlan = {0};
 
 // Encoder buffer — allocated from StreamingBufferPool, runtime-adjustable.
 // ENCODER_BUFFER_DEFAULT (8192) and ENCODER_BUFFER_MIN (1024) defined in
@@ -429,50 +523,12 @@ static TaskHandle_t gStreamingTaskHandle;
 static volatile uint32_t gStreamingTaskInCritical = 0;
 static volatile uint32_t gDeferredTaskInCritical = 0;
 
-// Sine wave period for test pattern 6: 256 samples per cycle.
-// Integer-only implementation via Q0.16 lookup table —
-// eliminates FPU usage in the deferred task so context switches
-// don't pay FPU save/restore cost. Table: (sin(i*2π/256)+1)*0.5 scaled
-// to [0,65535]. Runtime scaling: (lut[phase] * adcMax) >> 16 is one
-// 32-bit multiply + shift, no FPU.
-#define SINE_PERIOD 256
-static const uint16_t kSineLutQ16[SINE_PERIOD] = {
-    32768, 33572, 34375, 35178, 35979, 36779, 37575, 38369,
-    39160, 39947, 40729, 41507, 42279, 43046, 43807, 44560,
-    45307, 46046, 46777, 47500, 48214, 48919, 49613, 50298,
-    50972, 51635, 52287, 52927, 53555, 54170, 54773, 55362,
-    55938, 56499, 57047, 57579, 58097, 58600, 59087, 59558,
-    60013, 60451, 60873, 61278, 61666, 62036, 62389, 62724,
-    63041, 63339, 63620, 63881, 64124, 64348, 64553, 64739,
-    64905, 65053, 65180, 65289, 65377, 65446, 65496, 65525,
-    65535, 65525, 65496, 65446, 65377, 65289, 65180, 65053,
-    64905, 64739, 64553, 64348, 64124, 63881, 63620, 63339,
-    63041, 62724, 62389, 62036, 61666, 61278, 60873, 60451,
-    60013, 59558, 59087, 58600, 58097, 57579, 57047, 56499,
-    55938, 55362, 54773, 54170, 53555, 52927, 52287, 51635,
-    50972, 50298, 49613, 48919, 48214, 47500, 46777, 46046,
-    45307, 44560, 43807, 43046, 42279, 41507, 40729, 39947,
-    39160, 38369, 37575, 36779, 35979, 35178, 34375, 33572,
-    32768, 31963, 31160, 30357, 29556, 28756, 27960, 27166,
-    26375, 25588, 24806, 24028, 23256, 22489, 21728, 20975,
-    20228, 19489, 18758, 18035, 17321, 16616, 15922, 15237,
-    14563, 13900, 13248, 12608, 11980, 11365, 10762, 10173,
-     9597,  9036,  8488,  7956,  7438,  6935,  6448,  5977,
-     5522,  5084,  4662,  4257,  3869,  3499,  3146,  2811,
-     2494,  2196,  1915,  1654,  1411,  1187,   982,   796,
-      630,   482,   355,   246,   158,    89,    39,    10,
-        0,    10,    39,    89,   158,   246,   355,   482,
-      630,   796,   982,  1187,  1411,  1654,  1915,  2196,
-     2494,  2811,  3146,  3499,  3869,  4257,  4662,  5084,
-     5522,  5977,  6448,  6935,  7438,  7956,  8488,  9036,
-     9597, 10173, 10762, 11365, 11980, 12608, 13248, 13900,
-    14563, 15237, 15922, 16616, 17321, 18035, 18758, 19489,
-    20228, 20975, 21728, 22489, 23256, 24028, 24806, 25588,
-    26375, 27166, 27960, 28756, 29556, 30357, 31160, 31963,
-};
-
-_Static_assert((sizeof(kSineLutQ16) / sizeof(kSineLutQ16[0])) == SINE_PERIOD,
-               "kSineLutQ16 must have exactly SINE_PERIOD entries");
+/* Stop-time final encode pass (see Streaming_FlushHeldSamples): set by
+ * Streaming_Stop, cleared by streaming_Task after one iteration run with
+ * IsEnabled already false. Same atomicity rules as the flags above. */
+static volatile uint32_t gStopFlushPending = 0;
+// Bound on the stop-time flush; a pass normally takes well under 1 ms.
+#define STREAM_STOP_FLUSH_MS 50
 
 /* #549: the pool's active-USB overcommit floor must equal one USB CDC DMA
  * write, so a degraded partition never hands back an active USB ring below
@@ -482,53 +538,12 @@ _Static_assert((sizeof(kSineLutQ16) / sizeof(kSineLutQ16[0])) == SINE_PERIOD,
 _Static_assert(STREAMING_USB_ACTIVE_MIN == USBCDC_WBUFFER_SIZE,
                "#549: STREAMING_USB_ACTIVE_MIN must track USBCDC_WBUFFER_SIZE");
 
-/**
- * Generate a synthetic ADC value for test pattern streaming.
- * @param pattern    Pattern type (1-6, see switch cases)
- * @param channel    Channel ID (0-based)
- * @param sampleCount Monotonic sample counter (reset each session)
- * @param adcMax     Maximum ADC raw code (e.g. 4095 for 12-bit, 262143 for 18-bit)
- * @return Synthetic ADC value in [0, adcMax]
- */
-static uint32_t Streaming_GenerateTestValue(uint32_t pattern, uint8_t channel,
-                                             uint64_t sampleCount, uint32_t adcMax) {
-    uint32_t range = adcMax + 1;  // Values from 0 to adcMax inclusive
-    switch (pattern) {
-        case 1:  // Counter: predictable sequence for integrity verification
-            return (uint32_t)((sampleCount + channel) % range);
-        case 2:  // Midscale: constant value for consistent encoding size
-            return adcMax / 2;
-        case 3:  // Fullscale: maximum value for worst-case ProtoBuf size
-            return adcMax;
-        case 4:  // Walking: channel-dependent ramp for visual verification
-            return (uint32_t)(((sampleCount * (channel + 1))) % range);
-        case 5: {  // Triangle: ramps up then down, period = 2*adcMax samples
-            // Phase offset per channel so multi-channel view is staggered
-            uint32_t period = 2 * range;
-            uint32_t pos = (uint32_t)((sampleCount + (uint32_t)channel * (range / 4)) % period);
-            return (pos < range) ? pos : (period - 1 - pos);
-        }
-        case 6: {  // Sine: 256-sample period, integer Q0.16 LUT scaling
-            uint32_t phase = (uint32_t)((sampleCount + (uint32_t)channel * 32) % SINE_PERIOD);
-            /* Scale lut[phase] ∈ [0,65535] to [0,adcMax] with rounding.
-             * Multiply by (adcMax+1) and >>16 maps the full Q0.16 range
-             * (where 65535 represents ~1.0) to [0,adcMax] exactly; add
-             * 0x8000 for round-to-nearest; clamp against the +1 overshoot. */
-            uint64_t scaled =
-                ((uint64_t)kSineLutQ16[phase] * (uint64_t)(adcMax + 1U) + 0x8000ULL) >> 16;
-            if (scaled > adcMax) scaled = adcMax;
-            return (uint32_t)scaled;
-        }
-        default:
-            return 0;
-    }
-}
-
 // --- Channel mapping API ---
 
 uint8_t Streaming_BuildChannelMapping(const tBoardConfig* pBoardConfig,
                                        const AInRuntimeArray* pRuntimeChannels) {
     memset(&gChannelMapping, 0, sizeof(gChannelMapping));
+    AcqPlan_Reset(&gAcqPlan);
 
     size_t count = pBoardConfig->AInChannels.Size < pRuntimeChannels->Size
                  ? pBoardConfig->AInChannels.Size : pRuntimeChannels->Size;
@@ -544,11 +559,18 @@ uint8_t Streaming_BuildChannelMapping(const tBoardConfig* pBoardConfig,
             // from their ADC result registers in the deferred task, gated
             // on per-input ARDY.  Record the hardware channel number here
             // so the hot loop doesn't have to chase board-config pointers.
+            AcqOpKind kind = ACQ_OP_LATEST;
             if (ch->Type == AIn_MC12bADC && ch->Config.MC12b.ChannelType == 1) {
                 gChannelMapping.t1DirectMask |= (uint16_t)(1U << packed);
                 gChannelMapping.hwChannelIds[packed] =
                         (uint8_t)ch->Config.MC12b.ChannelId;
+                kind = ACQ_OP_T1_DIRECT;
+            } else if (ch->Type == AIn_AD7609) {
+                kind = ACQ_OP_AD7609;
             }
+            AcqPlan_Add(&gAcqPlan, kind, (uint8_t)i,
+                        gChannelMapping.hwChannelIds[packed],
+                        ch->DaqifiAdcChannelId);
             packed++;
         }
     }
@@ -620,7 +642,7 @@ uint32_t Streaming_ComputeMaxFreqForConfigIface(StreamingInterface iface) {
          * monitoring channels in the scan = scanCount - userT2 (8 when OBDiag). */
         uint32_t nMon = (scanCount > userT2) ? (scanCount - userT2) : 0u;
         maxFreq = Streaming_AdcAdditiveCap_NQ1(
-                type1, userT2, nMon, (sc->Encoding == Streaming_ProtoBuffer) ? 1u : 0u);
+                type1, userT2, nMon, Streaming_EncodingIsPb(sc->Encoding) ? 1u : 0u);
         /* #563: the additive model was fit at the default SAMC. It replaces the
          * EOS-rate/event-rate caps, but the SAMC/divider-dependent scan-busy
          * limit (#539) must still apply so a non-default SAMC can't push the cap
@@ -633,11 +655,12 @@ uint32_t Streaming_ComputeMaxFreqForConfigIface(StreamingInterface iface) {
         /* #574: SD-PB writer-vs-scan cap. The SD writer task loses CPU to the
          * scan's data-ready/EOS ISRs, so scan-armed configs sustain a lower
          * zero-loss SD rate than the ADC/transport terms predict. SD interface
-         * only — UsbAndSd is uncharacterized (separate follow-up). */
-        if (iface == StreamingInterface_SD) {
+         * only — UsbAndSd is uncharacterized (separate follow-up). A capture
+         * session writes nothing to the card until the burst is over. */
+        if (iface == StreamingInterface_SD && sc->CapturePost == 0u) {
             uint32_t sdMax = Streaming_SdAdditiveCap_NQ1(
                     type1, userT2, nMon,
-                    (sc->Encoding == Streaming_ProtoBuffer) ? 1u : 0u);
+                    Streaming_EncodingIsPb(sc->Encoding) ? 1u : 0u);
             if (sdMax < maxFreq) maxFreq = sdMax;
         }
     } else {
@@ -653,6 +676,12 @@ uint32_t Streaming_ComputeMaxFreqForConfigIface(StreamingInterface iface) {
         }
     }
 
+    /* SYST:STR:CAPture: the burst goes to RAM and the readout waits for the
+     * transport, so only the ADC/ISR/tick bounds above apply. */
+    if (sc->CapturePost > 0u) {
+        return maxFreq;
+    }
+
     /* Per-interface, per-format TRANSPORT cap (#524) applies to ALL variants;
      * binds CSV (byte-bound) below the ADC cap. Interface is a PARAMETER so the
      * capabilities query can compute for the detected interface w/o mutating
@@ -662,6 +691,23 @@ uint32_t Streaming_ComputeMaxFreqForConfigIface(StreamingInterface iface) {
     uint32_t transportMax = Streaming_TransportMaxFreq(
             iface, sc->Encoding, total,
             (bc != NULL && bc->BoardVariant == 1u) ? 1u : 0u);
+    /* SYST:STR:ADAPTive: the WiFi fits are worst-night-safe, so with the rate
+     * controller watching the link the cap may sit above them -- a night that
+     * cannot carry it decimates instead of dropping. Only the transport term:
+     * every sample is still acquired, so the ADC/ISR/SD bounds above stand.
+     * TCP only: the provisional UDP fit already carries this headroom. */
+    if (sc->AdaptiveRate && iface == StreamingInterface_WiFi) {
+        transportMax = (uint32_t)(((uint64_t)transportMax * STREAMING_ADAPTIVE_CAP_NUM)
+                                  / STREAMING_ADAPTIVE_CAP_DEN);
+    }
+    /* SYST:STR:DECimate: the transport carries one sample per N ticks, so
+     * its cap on the TICK rate is N times higher. Again only the transport
+     * term -- the ADC still converts, and the deferred task still runs the
+     * plan, on every tick. */
+    if (sc->DecimateFactor > 1u) {
+        uint64_t scaled = (uint64_t)transportMax * sc->DecimateFactor;
+        transportMax = (scaled > UINT32_MAX) ? UINT32_MAX : (uint32_t)scaled;
+    }
     if (transportMax < maxFreq) maxFreq = transportMax;
     return maxFreq;
 }
@@ -672,6 +718,150 @@ uint32_t Streaming_ComputeMaxFreqForConfig(void) {
     return Streaming_ComputeMaxFreqForConfigIface(sc->ActiveInterface);
 }
 
+// --- Acquisition plan hardware access (deferred task only) ---
+
+static bool Streaming_AcqReadResult(void* ctx, uint8_t hwChannel, uint32_t* pValue) {
+    (void)ctx;
+    // #541 D-A: T1 (dedicated-module) result read directly from the ADC
+    // result register, gated on the per-input ARDY flag (sets at conversion
+    // end, clears on ADCDATAx read -- FRM DS60001344E Fig 22-7 / p.22-88).
+    // Replaces the EOS-task -> LATEST-cache hop, whose freshness collapsed
+    // above ~4.6 kHz because EOSRDY only sets on full-scan completion (#539).
+    // The T1 conversion completes ~1.3 us after the TMR5 trigger and this
+    // task wakes several us later, so ARDY is essentially always set. Miss
+    // policy: NO spin -- the validMask bit stays 0 for this tick (#535).
+    return MC12b_ReadResult((ADCHS_CHANNEL_NUM)hwChannel, pValue);
+}
+
+static bool Streaming_AcqReadLatest(void* ctx, uint8_t slot, uint32_t* pValue) {
+    (void)ctx;
+    AInSample* pAiSample = BoardData_Get(BOARDDATA_AIN_LATEST, slot);
+    if (pAiSample == NULL) {
+        return false;
+    }
+    taskENTER_CRITICAL();
+    uint32_t ts = pAiSample->Timestamp;
+    uint32_t val = pAiSample->Value;
+    taskEXIT_CRITICAL();
+    // #533: Timestamp==0 marks the LATEST slot invalid -- Streaming_Start
+    // zeroes it so the previous session's final conversion (parked in this
+    // one-deep cache across the stop gap) can't be re-emitted as the new
+    // session's first sample. The slot revalidates when this session's first
+    // conversion lands. A genuine counter reading of 0 can never alias the
+    // sentinel: Streaming_TimerHandler clamps 0 -> 1 at the single capture
+    // point all stamps derive from. The PACKET Timestamp is the per-tick
+    // trigStamp (#717), not this slot's ts.
+    if (ts == 0) {
+        return false;
+    }
+    *pValue = val;
+    return true;
+}
+
+static void Streaming_AcqStoreLatest(void* ctx, const AcqOp_t* op, uint32_t value) {
+    // Refresh the LATEST cache so non-streaming readers (MEAS:VOLT:DC?) stay
+    // live during a session. Same per-tick work the EOS task used to do at
+    // the same priority -- relocated, not added. ctx is the tick's trigStamp.
+    AInSample wb;
+    wb.Timestamp = *(const uint32_t*)ctx;
+    wb.Channel = op->channelId;
+    wb.Value = value;
+    BoardData_Set(BOARDDATA_AIN_LATEST, op->slot, &wb);
+}
+
+static void Streaming_AcqT1Miss(void* ctx, const AcqOp_t* op) {
+    (void)ctx;
+    (void)op;
+    // Single-writer 32-bit increment -- no critical section needed
+    // (deferred task is the only writer).
+    gStreamStats.t1ArdyMisses++;
+    LOG_E_SESSION(LOG_SESSION_T1_ARDY_MISS,
+            "Streaming: T1 ARDY miss (result not ready at read)");
+}
+
+static const AcqPlanIo_t kAcqPlanIo = {
+    .readResult = Streaming_AcqReadResult,
+    .readLatest = Streaming_AcqReadLatest,
+    .storeLatest = Streaming_AcqStoreLatest,
+    .t1Miss = Streaming_AcqT1Miss,
+};
+
+/* SYST:STR:CAPture readout: move up to CAPTURE_REPLAY_PER_TICK frames from
+ * the finished capture into the sample pool, oldest first. A frame stays in
+ * the ring until the queue has taken it, so a busy encoder only slows the
+ * readout down -- nothing of a capture is dropped. Deferred task only. */
+static void Streaming_CaptureReplay(void) {
+    const size_t valueBytes = gCapture.channels * sizeof(uint32_t);
+    for (uint32_t n = 0; n < CAPTURE_REPLAY_PER_TICK; n++) {
+        const CaptureFrame_t* f = CaptureRing_Peek(&gCapture);
+        if (f == NULL) {
+            return;
+        }
+        AInPublicSampleList_t* s = AInSampleList_AllocateFromPool();
+        if (s == NULL) {
+            return;
+        }
+        s->Timestamp = f->Timestamp;
+        s->validMask = f->validMask;
+        s->channelCount = gCapture.channels;
+        memcpy(s->Values, f->Values, valueBytes);
+        if (!AInSampleList_PushBack(s)) {
+            AInSampleList_FreeToPool(s);
+            return;
+        }
+        CaptureRing_Consume(&gCapture);
+        taskENTER_CRITICAL();
+        gStreamStats.totalSamplesStreamed++;
+        if (f->clipMask != 0u) {
+            gStreamStats.clippedSamples++;
+            gStreamStats.clippedChannelMask |= f->clipMask;
+        }
+        taskEXIT_CRITICAL();
+    }
+}
+
+/* SYST:STR:CAPture: one tick of a capture session, in place of the sample
+ * path. Until the capture is DONE the acquisition plan runs straight into
+ * the ring slot and the trigger counters are polled; after that the tick
+ * only paces the readout. Deferred task only. */
+static void Streaming_CaptureTick(uint32_t trigStamp) {
+    if (CaptureRing_State(&gCapture) == CAPTURE_DONE) {
+        Streaming_CaptureReplay();
+        return;
+    }
+    CaptureFrame_t* f = CaptureRing_Claim(&gCapture);
+    if (f == NULL) {
+        return;                     /* read out: idle until STOP */
+    }
+    const uint32_t tickPattern = gTestPattern;       /* #814 snapshot */
+    uint32_t clip = 0u;
+    uint32_t valid;
+    if ((gBenchmarkMode == BENCHMARK_PIPELINE) || (tickPattern != 0)) {
+        valid = AcqPlan_RunSynthetic(&gAcqPlan, tickPattern,
+                gTestPatternSampleCount, f->Values, &clip);
+    } else {
+        valid = AcqPlan_RunHardware(&gAcqPlan, &kAcqPlanIo, &trigStamp,
+                f->Values, &clip);
+    }
+    /* #707/#745 priming: nothing is live before the first completed scan,
+     * so that tick is dry here too and takes no slot. */
+    if (gPrimingPending) {
+        if (gScanEosSeq == 1u) {
+            taskENTER_CRITICAL();
+            gDryTicks++;
+            taskEXIT_CRITICAL();
+            return;
+        }
+        gPrimingPending = false;
+    }
+    f->Timestamp = trigStamp;
+    f->validMask = (uint16_t)valid;
+    f->clipMask = (uint16_t)clip;
+    uint8_t fired = CaptureTrigger_Poll(&gCaptureTrigger, AdcThreshold_TripSeq(),
+                                        UserEdge_EventSeq(), gCaptureForceSeq);
+    CaptureRing_Commit(&gCapture, fired != 0u);
+}
+
 /**
  * @brief Deferred interrupt handler for sample collection.
  *
@@ -708,7 +898,6 @@ void _Streaming_Deferred_Interrupt_Task(void) {
             BOARDRUNTIMECONFIG_AIN_MODULES);
 
     AInPublicSampleList_t *pPublicSampleList=NULL;
-    AInSample *pAiSample;
 
     uint64_t ChannelScanFreqDivCount = 0;
 
@@ -813,14 +1002,85 @@ void _Streaming_Deferred_Interrupt_Task(void) {
             taskENTER_CRITICAL();
             gStreamTickIndex++;
             taskEXIT_CRITICAL();
+            /* SYST:STR:CAPture: the tick goes to the capture ring (or paces
+             * its readout) and never takes the sample path below. */
+            if (gCaptureActive) {
+                Streaming_CaptureTick(trigStamp);
+                goto pool_done;
+            }
+            /* SYST:STR:DECimate: the acquisition plan runs on EVERY tick,
+             * into the decimator, and only the tick that closes a window
+             * goes on to the pool with the filtered frame. That tick's own
+             * stamp (the window's last input) keeps the stream on the
+             * session grid at N times the step. The other ticks are
+             * decimated on purpose and counted with the adaptive ones. This
+             * runs before the adaptive skip below, so that thins the
+             * decimated stream and never the filter's input. */
+            uint32_t decimValid = 0u;
+            uint32_t decimClip = 0u;
+            if (gDecimActive) {
+                const uint32_t tickPattern = gTestPattern;   /* #814 snapshot */
+                uint32_t inClip = 0u;
+                uint32_t inValid;
+                if ((gBenchmarkMode == BENCHMARK_PIPELINE) || (tickPattern != 0)) {
+                    inValid = AcqPlan_RunSynthetic(&gAcqPlan, tickPattern,
+                            gTestPatternSampleCount, gDecimIn, &inClip);
+                } else {
+                    inValid = AcqPlan_RunHardware(&gAcqPlan, &kAcqPlanIo,
+                            &trigStamp, gDecimIn, &inClip);
+                }
+                /* #707/#745 priming (see the frame path below): a tick
+                 * before the first completed scan is dry, and must not
+                 * start the filter on a cache that is not live yet. */
+                if (gPrimingPending) {
+                    if (gScanEosSeq == 1u) {
+                        taskENTER_CRITICAL();
+                        gDryTicks++;
+                        taskEXIT_CRITICAL();
+                        goto pool_done;
+                    }
+                    gPrimingPending = false;
+                }
+                if (!Decimator_Push(&gDecimator, gDecimIn, inValid, inClip,
+                                    gDecimOut, &decimValid, &decimClip)) {
+                    taskENTER_CRITICAL();
+                    gStreamStats.decimatedTicks++;
+                    taskEXIT_CRITICAL();
+                    goto pool_done;
+                }
+            }
+            /* SYST:STR:ADAPTive: only every gRateDivisor-th tick is a sample.
+             * The skipped ones still advance gStreamTickIndex above, so the
+             * emitted stamps stay on the session's grid, and still trigger the
+             * ADC below (pool_done) so conversions keep their cadence. A new
+             * divisor is picked up on an emitted tick and recorded there for
+             * the encoder's rate stamp. Off (divisor 1) this is two compares. */
+            if (gRateSkip > 0u) {
+                gRateSkip--;
+                taskENTER_CRITICAL();
+                gStreamStats.decimatedTicks++;
+                taskEXIT_CRITICAL();
+                goto pool_done;
+            }
+            {
+                uint32_t div = gRateDivisor;
+                gRateSkip = div - 1u;
+                if (div != gRateDivisorApplied) {
+                    gRateDivisorApplied = div;
+                    gRateChangeTs = trigStamp;
+                    gRateChangeDivisor = div * gDecimFactor;
+                    gRateChangeSeq++;
+                }
+            }
             DioProbe_PulseStart(3);  /* probe 3: alloc + channel loop + queue push */
             // Use object pool instead of heap allocation (eliminates vPortFree overhead)
             // No heap check needed - pool uses pre-allocated static memory
             pPublicSampleList = AInSampleList_AllocateFromPool();
             if(pPublicSampleList==NULL) {
-                // #499: split counter — this path = pool depth too shallow for
-                // the configured rate. Distinct from the PushBack-fail path
-                // below, which is "queue full / streaming_Task too slow."
+                // #499: split counter — this path = every slot of the sample
+                // ring is queued or held by the encoder (pool depth too shallow
+                // for the rate, or streaming_Task draining too slowly -- the
+                // pool and the queue are one ring, so both land here).
                 // #483: Steady = post-startup-grace subset (the aggregate
                 // queueDroppedSamples stays for back-compat; per-sub-counter
                 // Steady variants intentionally not added — the existing
@@ -933,184 +1193,31 @@ void _Streaming_Deferred_Interrupt_Task(void) {
             const uint32_t framePattern = gTestPattern;      /* both are volatile uint32_t */
             const uint32_t frameBenchMode = gBenchmarkMode;
             uint32_t clipMask = 0;   /* #814: rails seen in THIS sample */
-            for (uint8_t j = 0; j < mapping->count; j++) {
-                uint8_t cfgIdx = mapping->configIndices[j];
-
-                uint32_t adcMax;
-                /* #814: AD7609 codes are SIGNED; MC12b codes are unsigned.
-                 * The rail test below has to know which, so record it here
-                 * alongside adcMax rather than re-deriving it. */
-                bool adcIsSigned;
-                // #368: this task is registered as pure-integer (see comment
-                // at top of _Streaming_Deferred_Interrupt_Task — no
-                // portTASK_USES_FLOATING_POINT()).  The historical bug:
-                // Resolution used to be `double`, so the cast in
-                // `adcMax = (uint32_t)Resolution - 1;` emitted FPU
-                // instructions that picked up register-contamination
-                // from FPU-using tasks during context switches, producing
-                // garbage like 0x80000FE6 instead of 4095.
-                //
-                // PR #369 fixed it with hardcoded integer constants here,
-                // and a follow-up (see #465) hardened the type system by
-                // changing MC12bModuleConfig.Resolution / AD7609Module-
-                // Config.Resolution to `uint32_t` in AInConfig.h.  Either
-                // defense alone is enough; keeping both means a future
-                // contributor can't accidentally re-introduce the bug
-                // by reverting one of the two.
-                /* #814: signedness describes the VALUE SITTING IN Values[j],
-                 * not merely the channel. A test pattern or PIPELINE run
-                 * writes a SYNTHETIC unsigned code in [0, adcMax] there --
-                 * Streaming_GenerateTestValue has no notion of AD7609's
-                 * two's-complement range -- so judging those as signed would
-                 * read a perfectly ordinary pattern value as a negative rail. */
-                const bool valueIsSynthetic =
-                        (frameBenchMode == BENCHMARK_PIPELINE) || (framePattern != 0);
-                if (pBoardConfig->AInChannels.Data[cfgIdx].Type == AIn_AD7609) {
-                    adcMax = 262143u;  // 18-bit AD7609
-                    adcIsSigned = !valueIsSynthetic;
-                } else {
-                    adcMax = 4095u;    // 12-bit MC12bADC
-                    adcIsSigned = false;
-                }
-
-                if (frameBenchMode == BENCHMARK_PIPELINE) {
-                    // Pipeline: skip ADC entirely, generate synthetic data directly.
-                    // Timestamp comes from the streaming timer tick captured by
-                    // Streaming_TimerHandler (BOARDDATA_STREAMING_TIMESTAMP) — same
-                    // source the ADC ISR uses for AInSample.Timestamp in normal
-                    // operation, so PB/CSV/JSON output is consistent across modes.
-                    pPublicSampleList->Values[j] =
-                        Streaming_GenerateTestValue(framePattern,
-                            mapping->channelIds[j],
-                            gTestPatternSampleCount, adcMax);
-                    pPublicSampleList->validMask |= (1U << j);
-                } else if (framePattern != 0) {
-                    // Test pattern: always produce deterministic data regardless
-                    // of ADC state. Packet Timestamp is the deterministic
-                    // trigStamp set once before the loop (#717) — no ADC read
-                    // needed here for the timestamp.
-                    pPublicSampleList->Values[j] =
-                        Streaming_GenerateTestValue(framePattern,
-                            mapping->channelIds[j],
-                            gTestPatternSampleCount, adcMax);
-                    pPublicSampleList->validMask |= (1U << j);
-                } else if (mapping->t1DirectMask & (1U << j)) {
-                    // #541 D-A: T1 (dedicated-module) result read directly
-                    // from the ADC result register, gated on the per-input
-                    // ARDY flag (sets at conversion end, clears on ADCDATAx
-                    // read — FRM DS60001344E Fig 22-7 / p.22-88).  Replaces
-                    // the EOS-task -> LATEST-cache hop, whose freshness
-                    // collapsed above ~4.6 kHz because EOSRDY only sets on
-                    // full-scan completion and the scan was being
-                    // retriggered out-of-spec (#539).  Timing: the T1
-                    // conversion completes ~1.3 us after the TMR5 trigger;
-                    // this task wakes several us later (ISR->task latency +
-                    // pool work above), so ARDY is essentially always set.
-                    // Miss policy: NO spin — leave the validMask bit 0 for
-                    // this tick (#535 semantics) and count it.
-                    uint32_t val;
-                    if (MC12b_ReadResult(
-                            (ADCHS_CHANNEL_NUM)mapping->hwChannelIds[j],
-                            &val)) {
-                        pPublicSampleList->Values[j] = val;
-                        pPublicSampleList->validMask |= (1U << j);
-                        // Packet Timestamp is the deterministic trigStamp set
-                        // before the loop (#717) — nothing to set per-channel.
-                        // Refresh the LATEST cache so non-streaming readers
-                        // (MEAS:VOLT:DC?) stay live during a session.  Same
-                        // per-tick work the EOS task used to do at the same
-                        // priority — relocated, not added.
-                        AInSample wb;
-                        wb.Timestamp = trigStamp;
-                        wb.Channel = mapping->channelIds[j];
-                        wb.Value = val;
-                        BoardData_Set(BOARDDATA_AIN_LATEST, cfgIdx, &wb);
-                    } else {
-                        // Single-writer 32-bit increment — no critical
-                        // section needed (deferred task is the only writer).
-                        gStreamStats.t1ArdyMisses++;
-                        LOG_E_SESSION(LOG_SESSION_T1_ARDY_MISS,
-                                "Streaming: T1 ARDY miss (result not ready at read)");
-                    }
-                } else {
-                    // Normal: read real ADC data from BoardData
-                    pAiSample = BoardData_Get(BOARDDATA_AIN_LATEST, cfgIdx);
-                    if (pAiSample != NULL) {
-                        taskENTER_CRITICAL();
-                        uint32_t ts = pAiSample->Timestamp;
-                        uint32_t val = pAiSample->Value;
-                        taskEXIT_CRITICAL();
-
-                        // #533: Timestamp==0 marks the LATEST slot invalid —
-                        // Streaming_Start zeroes it so the previous session's
-                        // final conversion (parked in this one-deep cache
-                        // across the stop gap) can't be re-emitted as the
-                        // new session's first sample.  Skipping leaves the
-                        // validMask bit 0; the slot revalidates when this
-                        // session's first conversion lands (next tick).
-                        // A genuine counter reading of 0 can never alias the
-                        // sentinel: Streaming_TimerHandler clamps 0 -> 1 at
-                        // the single capture point all stamps derive from.
-                        // #533 slot-validity gate stays: ts==0 marks the LATEST
-                        // slot invalid, so the value + validMask bit are gated on
-                        // it. The PACKET Timestamp is the deterministic trigStamp
-                        // (#717) and is no longer derived from this per-channel
-                        // slot ts — that per-channel derivation was the T2-first
-                        // aliasing source the #722 audit flagged (fix 2).
-                        if (ts != 0) {
-                            pPublicSampleList->Values[j] = val;
-                            pPublicSampleList->validMask |= (1U << j);
-                        }
-                    }
-                    // else: bit stays 0 in validMask (invalid)
-                }
-
-                /* #814: rail check, once per channel and after every branch
-                 * above, so it covers the ADC paths, the T1-direct path and
-                 * the test-pattern/PIPELINE paths alike. Only a channel whose
-                 * validMask bit is set is judged -- an invalid slot carries no
-                 * measurement to be at a rail.
-                 *
-                 * Both ends count: 0 is as much a rail as full scale. `>=`
-                 * rather than `==` on the top so a value that somehow exceeds
-                 * the module's range is caught rather than slipping past.
-                 *
-                 * Integer-only by construction -- this task is registered
-                 * pure-integer (no portTASK_USES_FLOATING_POINT), and adcMax
-                 * is the uint32_t constant chosen above precisely to keep the
-                 * FPU out of this loop (#368/#369). */
-                if (pPublicSampleList->validMask & (1U << j)) {
-                    const uint32_t v = pPublicSampleList->Values[j];
-                    bool railed;
-                    if (adcIsSigned) {
-                        /* AD7609 stores an 18-bit two's-complement code
-                         * SIGN-EXTENDED into this uint32_t (AD7609.c:454 ORs
-                         * AD7609_SIGN_EXTEND 0xFFFC0000 when bit 17 is set),
-                         * so the code range is -131072..+131071 and the rails
-                         * are those extremes -- NOT 0 and adcMax.
-                         *
-                         * Comparing it unsigned against adcMax is wrong in
-                         * both directions and neither failure is quiet: every
-                         * ordinary NEGATIVE reading sign-extends to a huge
-                         * unsigned value and would be flagged clipped (about
-                         * half of all samples on a bipolar +/-10 V board),
-                         * while true positive full scale, 131071, is below
-                         * adcMax and would never be flagged at all. 0 is
-                         * mid-scale here, not a rail.
-                         *
-                         * Bounds derived from adcMax so they cannot drift from
-                         * the board config's Resolution (262144 -> +/-131072). */
-                        const int32_t sv = (int32_t)v;
-                        const int32_t posRail = (int32_t)(adcMax >> 1);       /* +131071 */
-                        const int32_t negRail = -(int32_t)((adcMax >> 1) + 1); /* -131072 */
-                        railed = (sv >= posRail) || (sv <= negRail);
-                    } else {
-                        railed = (v == 0u) || (v >= adcMax);
-                    }
-                    if (railed) {
-                        clipMask |= (1U << j);
-                    }
-                }
+            /* Per-channel work comes from the acquisition plan compiled in
+             * Streaming_BuildChannelMapping: op kind, hardware channel, the
+             * ADC range (integer constants, #368/#369 -- this task stays off
+             * the FPU) and the #814 rail codes are all decided there, so the
+             * loop no longer chases board-config pointers per channel.
+             *
+             * PIPELINE skips the ADC entirely and a test pattern overrides
+             * it; both write SYNTHETIC unsigned codes in [0, adcMax] for
+             * every channel, whose rails are judged unsigned even on an
+             * AD7609 (#814). The packet Timestamp is the deterministic
+             * trigStamp set above (#717) on every path. */
+            if (gDecimActive) {
+                /* Already acquired and filtered above, this tick included. */
+                memcpy(pPublicSampleList->Values, gDecimOut,
+                       mapping->count * sizeof(uint32_t));
+                pPublicSampleList->validMask = (uint16_t)decimValid;
+                clipMask = decimClip;
+            } else if ((frameBenchMode == BENCHMARK_PIPELINE) || (framePattern != 0)) {
+                pPublicSampleList->validMask = (uint16_t)AcqPlan_RunSynthetic(
+                        &gAcqPlan, framePattern, gTestPatternSampleCount,
+                        pPublicSampleList->Values, &clipMask);
+            } else {
+                pPublicSampleList->validMask = (uint16_t)AcqPlan_RunHardware(
+                        &gAcqPlan, &kAcqPlanIo, &trigStamp,
+                        pPublicSampleList->Values, &clipMask);
             }
 
 
@@ -1179,9 +1286,9 @@ void _Streaming_Deferred_Interrupt_Task(void) {
             }
 
             if(!AInSampleList_PushBack(pPublicSampleList)){//failed pushing to Q
-                // #499: split counter — this path = FreeRTOS queue full,
-                // i.e. streaming_Task can't drain fast enough. Distinct from
-                // the AllocateFromPool-NULL path above (pool depth shallow).
+                // #499: split counter — this path = the ring refused to publish
+                // our claim (only possible if it was re-initialized under us);
+                // a slow drain shows up as AllocateFromPool-NULL above.
                 // #483: Steady = post-startup-grace subset of the aggregate.
                 bool pastGrace = Streaming_PastStartupGrace();
                 taskENTER_CRITICAL();
@@ -1317,7 +1424,11 @@ pool_done:
                         ChannelScanFreqDivCount++;
                     }
                 }
-                DIO_StreamingTrigger(&pBoardData->DIOLatest, &pBoardData->DIOSamples);
+                // A capture carries analog frames only; DIO samples pushed
+                // here would have no frame to ride on until the readout.
+                if (!gCaptureActive) {
+                    DIO_StreamingTrigger(&pBoardData->DIOLatest, &pBoardData->DIOSamples);
+                }
                 DioProbe_PulseEnd(4);
             }
 
@@ -1480,6 +1591,59 @@ static size_t Streaming_UsbWrite(const char* buf, size_t len) {
     return UsbCdc_WriteToBuffer(NULL, buf, len);
 }
 
+/* Zero-copy output: the transport ring the encoder writes into directly.
+ *
+ * The encoder buffer path copies every batch once more per transport
+ * (CircularBuf_AddBytes) -- three copies of every byte on USB+SD. Instead,
+ * each iteration first asks ONE transport for a contiguous span of its ring
+ * (CircularBuf_Reserve) and encodes straight into it; the commit publishes
+ * exactly the encoded bytes. With two outputs the second one copies out of
+ * that span before the commit, so the encoder buffer drops out of the USB+SD
+ * path entirely. The target is always the ring whose write would otherwise
+ * BLOCK (solo backpressure, WriteWithRetry) and the copy goes to the one that
+ * is no-retry (#534), so no mutex is ever held across a retry sleep.
+ *
+ * The span must be at least STREAMING_BATCH_FIRST_ROOM: the room every
+ * encoder already assumes one framed message fits in (STREAMING_BATCH_MIN_ROOM
+ * == ENCODER_BUFFER_MIN), plus a rate stamp ahead of it. A
+ * shorter span -- ring nearly full, or the insert point near the end of the
+ * ring -- is released at once and the iteration takes the encoder-buffer
+ * path, with its retry/backpressure and drop accounting unchanged.
+ *
+ * The transport's write mutex is held from reserve to commit, i.e. across
+ * the encode (bounded by STREAMING_BATCH_MAX messages). Each transport's
+ * drain only waits that long; the SD task's f_write runs outside it. */
+typedef enum {
+    STREAM_DIRECT_NONE = 0,
+    STREAM_DIRECT_USB,
+    STREAM_DIRECT_WIFI,
+    STREAM_DIRECT_SD,
+} StreamDirectSink;
+
+static uint8_t* Streaming_DirectReserve(StreamDirectSink sink, size_t* pLen) {
+    *pLen = 0;
+    switch (sink) {
+        case STREAM_DIRECT_USB:
+            return UsbCdc_ReserveWriteSpan(NULL, STREAMING_BATCH_FIRST_ROOM, pLen);
+        case STREAM_DIRECT_WIFI:
+            return wifi_manager_ReserveWriteSpan(STREAMING_BATCH_FIRST_ROOM, pLen);
+        case STREAM_DIRECT_SD:
+            return sd_card_manager_ReserveWriteSpan(STREAMING_BATCH_FIRST_ROOM, pLen);
+        default:
+            return NULL;
+    }
+}
+
+/* len == 0 releases the reservation without publishing anything. */
+static size_t Streaming_DirectCommit(StreamDirectSink sink, size_t len) {
+    switch (sink) {
+        case STREAM_DIRECT_USB:  return UsbCdc_CommitWriteSpan(NULL, len);
+        case STREAM_DIRECT_WIFI: return wifi_manager_CommitWriteSpan(len);
+        case STREAM_DIRECT_SD:   return sd_card_manager_CommitWriteSpan(len);
+        default:                 return 0;
+    }
+}
+
 /* #486 — distinguish "shutdown-initiated abort" from "true 10 s output
  * timeout" in the caller.  Pass-3 used `==0` for both and disambiguated
  * with an IsEnabled re-read at the call site; pass-5 Qodo /improve
@@ -1567,14 +1731,14 @@ void Streaming_ComputeAutoBuffers(uint32_t* outUsbSize, uint32_t* outWifiSize,
 
     bool hasUsb = (sc->ActiveInterface == StreamingInterface_USB ||
                    sc->ActiveInterface == StreamingInterface_UsbAndSd);
-    bool hasWifi = (sc->ActiveInterface == StreamingInterface_WiFi);
+    bool hasWifi = StreamingInterface_IsWiFi(sc->ActiveInterface);
     /* SD logging is actually requested only when all three conditions
      * hold: interface allows it (SD or All, or USB with enable+file
      * via SCPI_StartStreaming override), SD is enabled, and a filename
      * is set. Matches sdLoggingRequested in SCPIInterface.c — keeps
      * buffer allocation consistent with actual SD activity, avoids
      * reserving SD space during USB-only streaming when SD is dormant. */
-    bool hasSd = (sc->ActiveInterface != StreamingInterface_WiFi) &&
+    bool hasSd = !StreamingInterface_IsWiFi(sc->ActiveInterface) &&
                  sd->enable && sd->file[0] != '\0';
 
     // SD circular now lives in streaming pool (CPU-only, no DMA).
@@ -1646,8 +1810,19 @@ void Streaming_ComputeAutoBuffers(uint32_t* outUsbSize, uint32_t* outWifiSize,
     }
 
     // Encoder buffer: 16KB when SD active (larger writes reduce SPI overhead),
-    // 8KB default otherwise (sufficient for USB/WiFi).
-    *outEncoderSize = hasSd ? (ENCODER_BUFFER_DEFAULT * 2) : ENCODER_BUFFER_DEFAULT;
+    // 8KB default otherwise (sufficient for USB/WiFi). USB+SD encodes into
+    // the shared block queue that lives in the encoder region and both
+    // transports read from (Streaming_FanoutConfigure), so it gets the
+    // USB circular's share and the USB circular drops to its floor below.
+    // WiFi TCP does the same for its clients with the WiFi circular's share.
+    bool wifiTcp = (sc->ActiveInterface == StreamingInterface_WiFi);
+    if (hasUsb && hasSd) {
+        *outEncoderSize = STREAMING_SHARED_QUEUE_DEFAULT;
+    } else if (wifiTcp) {
+        *outEncoderSize = STREAMING_WIFI_SHARED_QUEUE_DEFAULT;
+    } else {
+        *outEncoderSize = hasSd ? (ENCODER_BUFFER_DEFAULT * 2) : ENCODER_BUFFER_DEFAULT;
+    }
 
     // Circular buffers: larger buffers reduce retry frequency for
     // all-or-nothing writes, but must leave enough pool for samples.
@@ -1676,13 +1851,20 @@ void Streaming_ComputeAutoBuffers(uint32_t* outUsbSize, uint32_t* outWifiSize,
     // post-shrink sample pool has 100× burst-absorption headroom for
     // streaming use.
     *outWifiSize = hasWifi ? STREAMING_WIFI_WIFI_ONLY : STREAMING_WIFI_MIN;
+    if (wifiTcp) {
+        *outWifiSize = STREAMING_WIFI_CONSOLE_ACTIVE;  // SCPI replies only
+    }
     *outUsbSize  = hasUsb  ? STREAMING_USB_DEFAULT    : STREAMING_USB_MIN;
+    if (hasUsb && hasSd) {
+        *outUsbSize = STREAMING_USB_ACTIVE_MIN;   // SCPI replies only
+    }
 }
 
 /*!
  * Starts the streaming timer
  */
 static void Streaming_DrainSessionSampleQueues(void);
+static void Streaming_FanoutConfigure(void);
 
 static void Streaming_Start(void) {
     if (!gpRuntimeConfigStream->Running) {
@@ -1730,7 +1912,58 @@ static void Streaming_Start(void) {
         // and we need stats to survive for post-session query.
         if (gpRuntimeConfigStream->IsEnabled) {
             Streaming_ClearStats();
-            Streaming_InitFlowWindow(gpRuntimeConfigStream->Frequency);
+            // SYST:STR:DECimate: latched for the session. The extra LSBs are
+            // only carried where the host receives codes (PB, CONF:ADC:RAWmode);
+            // the volt encoders convert native-scale codes, so they get the
+            // filtered average at 0 extra bits.
+            // SYST:STR:CAPture: latched for the session, and exclusive with
+            // decimation and adaptive rate -- a capture keeps every tick.
+            // SCPI_StartStreaming partitioned the pool for it and checked
+            // that pre+post frames fit the tail.
+            gCaptureActive = false;
+            if (gpRuntimeConfigStream->CapturePost > 0u) {
+                uint8_t* capBuf;
+                uint32_t capSize;
+                StreamingBufferPool_GetCapture(&capBuf, &capSize);
+                gCaptureActive = CaptureRing_Configure(&gCapture, capBuf, capSize,
+                        gChannelMapping.count, gpRuntimeConfigStream->CapturePre,
+                        gpRuntimeConfigStream->CapturePost);
+                if (gCaptureActive) {
+                    CaptureRing_Arm(&gCapture);
+                    CaptureTrigger_Init(&gCaptureTrigger,
+                            gpRuntimeConfigStream->CaptureSources,
+                            AdcThreshold_TripSeq(), UserEdge_EventSeq(),
+                            gCaptureForceSeq);
+                    // A comparator that tripped before the session masked
+                    // itself (latch-and-mask); let it fire for this capture.
+                    if (gpRuntimeConfigStream->CaptureSources & CAPTURE_SRC_ADC_THRESHOLD) {
+                        AdcThreshold_Rearm();
+                    }
+                } else {
+                    LOG_E("Streaming: capture %u+%u frames x %u ch does not fit, streaming",
+                          (unsigned)gpRuntimeConfigStream->CapturePre,
+                          (unsigned)gpRuntimeConfigStream->CapturePost,
+                          (unsigned)gChannelMapping.count);
+                }
+            }
+            gDecimActive = false;
+            gDecimFactor = 1u;
+            gDecimBits = 0u;
+            if (!gCaptureActive && gpRuntimeConfigStream->DecimateFactor > 1u) {
+                uint32_t bits = Streaming_DecimScaleBits(gpRuntimeConfigStream);
+                gDecimActive = Decimator_Configure(&gDecimator, gChannelMapping.count,
+                        gpRuntimeConfigStream->DecimateFactor,
+                        gpRuntimeConfigStream->DecimateStages, bits);
+                if (gDecimActive) {
+                    gDecimFactor = gpRuntimeConfigStream->DecimateFactor;
+                    gDecimBits = bits;
+                } else {
+                    LOG_E("Streaming: invalid decimation %u/%u, streaming undecimated",
+                          (unsigned)gpRuntimeConfigStream->DecimateFactor,
+                          (unsigned)gpRuntimeConfigStream->DecimateStages);
+                }
+            }
+            Streaming_InitFlowWindow(gpRuntimeConfigStream->Frequency / gDecimFactor);
             // Reset test pattern counter so each session starts at 0
             taskENTER_CRITICAL();
             gTestPatternSampleCount = 0;
@@ -1740,7 +1973,21 @@ static void Streaming_Start(void) {
             // baseTS + 0. periodTicks is computed just below.
             gStreamTSSeeded = 0u;
             gStreamTickIndex = 0;
+            // Adaptive rate: every session opens at the configured rate.
+            gRateDivisor = 1u;
+            gRateDivisorApplied = 1u;
+            gRateSkip = 0u;
+            gRateChangeSeq = 0u;
+            gRateStampedSeq = 0u;
+            gRateChangeDivisor = gDecimFactor;
+            gRateStampDivisor = gDecimFactor;
             taskEXIT_CRITICAL();
+            gRateAdaptive = gpRuntimeConfigStream->AdaptiveRate && !gCaptureActive;
+            RateControl_Init(&gRateControl, NULL);
+            gRateLastTick = xTaskGetTickCount();
+            gRateLastLost = 0u;
+            gRateLastDropped = 0u;
+            gRatePeakFill = 0u;
             // #717: periodTicks is config-derived (not timing), so compute it
             // here once — the EXACT TMR6-tick count of one streaming period:
             // (ClockPeriod+1) TMR4/5 cycles * (tsFreq / streamTimerFreq). The two
@@ -1765,6 +2012,31 @@ static void Streaming_Start(void) {
              * benchmark stream doesn't leave the flag set over a period nobody
              * configured. */
             Streaming_NoteRateConfigured();
+            // PB block sessions hold ~10 ms of ticks per block; the setting is
+            // inert for every other encoding.
+            {
+                uint16_t totalChannels = 0;
+                Streaming_CountActiveChannels(NULL, &totalChannels, NULL);
+                Streaming_EncodeSetBlockHold(
+                        Streaming_ActualRateMilliHz(gpRuntimeConfigStream->ClockPeriod)
+                                / gDecimFactor,
+                        totalChannels);
+            }
+            // SYST:STR:DELTa applies to the per-sample PB path only; the
+            // block encoding delta-codes its own rows. Resets the chain, so
+            // the session opens on a keyframe.
+            Nanopb_StreamingDeltaConfigure(
+                    (gpRuntimeConfigStream->Encoding == Streaming_ProtoBuffer) ?
+                    gpRuntimeConfigStream->PbDeltaKeyframeInterval : 0u);
+            // CSV sessions get the data-row writer specialized for their
+            // precision / raw / compact settings (csv_encoder.c).
+            if (Streaming_EncodingIsCsv(gpRuntimeConfigStream->Encoding)) {
+                csv_SelectRowWriter(true);
+            }
+            // JSON values go through the same fixed-point conversion.
+            if (gpRuntimeConfigStream->Encoding == Streaming_Json) {
+                json_SelectFixedPoint(true);
+            }
             // #450: anchor the startup-grace window at the start of each
             // enabled session.  Steady drop counters won't increment
             // until xTaskGetTickCount() - gStreamStartTick >= grace.
@@ -1828,6 +2100,9 @@ static void Streaming_Start(void) {
                         &css1, &css2);
                 MC12b_ApplyScanList(css1, css2);
                 gNeedSharedScan = (scanCount > 0);
+                // CONF:ADC:SCAN:DMA: read this list by DMA, one interrupt
+                // per scan. No-op (per-input ISRs) when off or empty.
+                (void)MC12b_StartScanDma(css1, css2);
                 /* #707/#745: enabled USER T2 channels only — monitoring
                  * excluded, no registers written (pure count). */
                 gPrimingPending =
@@ -1866,8 +2141,16 @@ static void Streaming_Start(void) {
                     gSdExpectedThisSession =
                         sdCfg->enable &&
                         (sdCfg->mode == SD_CARD_MANAGER_MODE_WRITE) &&
-                        (gpRuntimeConfigStream->ActiveInterface !=
-                            StreamingInterface_WiFi);
+                        !StreamingInterface_IsWiFi(
+                            gpRuntimeConfigStream->ActiveInterface);
+                }
+                // USB+SD sessions encode into the shared block queue; keyed
+                // on the SD expectation just latched.
+                Streaming_FanoutConfigure();
+                // UDP sessions number their datagrams from 0, which is how
+                // the receiver tells a new session from a wrapped one.
+                if (gpRuntimeConfigStream->ActiveInterface == StreamingInterface_WiFiUdp) {
+                    wifi_udp_stream_Start((uint8_t)gpRuntimeConfigStream->Encoding);
                 }
                 // #670: inform (log only) about any Type 2 threshold whose channel
                 // isn't in this session's scan — it won't monitor stream samples,
@@ -1917,7 +2200,7 @@ static bool Streaming_AllConfiguredTransportsDead(StreamingRuntimeConfig *cfg) {
     TickType_t graceTicks = pdMS_TO_TICKS((TickType_t)gTransportGraceSec * 1000U);
     bool wantUsb = (cfg->ActiveInterface == StreamingInterface_USB ||
                     cfg->ActiveInterface == StreamingInterface_UsbAndSd);
-    bool wantWifi = (cfg->ActiveInterface == StreamingInterface_WiFi);
+    bool wantWifi = StreamingInterface_IsWiFi(cfg->ActiveInterface);
     bool wantSd  = (cfg->ActiveInterface == StreamingInterface_SD ||
                     cfg->ActiveInterface == StreamingInterface_UsbAndSd);
 
@@ -2037,6 +2320,17 @@ static void Streaming_CountSdDrop(size_t packetSize) {
     taskEXIT_CRITICAL();
 }
 
+static void Streaming_CountWifiDrop(size_t packetSize) {
+    bool pastGrace = Streaming_PastStartupGrace();
+    taskENTER_CRITICAL();
+    gStreamStats.wifiDroppedBytes += packetSize;
+    if (pastGrace) {
+        gStreamStats.wifiDroppedBytesSteady += packetSize;
+    }
+    gQuesBits |= QUES_BIT_WIFI_OVERFLOW;
+    taskEXIT_CRITICAL();
+}
+
 /**
  * @brief Account for SD bytes that were buffered but can never be written.
  *
@@ -2059,18 +2353,494 @@ void Streaming_ReportSdDiscard(size_t bytes) {
     Streaming_CountSdDrop(bytes);
 }
 
+/* USB+SD fan-out: encode once, read twice.
+ *
+ * With USB and SD both live, every batch used to land in two rings: encoded
+ * into one (StreamDirectSink) and copied into the other, and a full SD ring
+ * dropped the batch for SD while a full USB ring dropped it for USB, each
+ * at encode time. Instead each batch is encoded ONCE into a block of gFanout
+ * (Util/SharedBlockQueue.h), and the two transports read it through their
+ * own cursors: this task feeds the SD ring from the SD cursor, and the USB
+ * task copies the USB cursor's blocks straight into its DMA buffer (the USB
+ * ring then only carries SCPI replies, which keep priority). A block is
+ * reclaimed once both have read it.
+ *
+ * A slow SD backs up only its own cursor. When the arena or the descriptor
+ * ring runs out, the oldest block is evicted from whichever consumer still
+ * holds it, and only that consumer's drop counter is charged -- USB loses
+ * nothing to a stalled card for as long as the arena holds the card's lag.
+ * In a PB delta session the consumer that lost a block also drops the rest
+ * of its backlog: those blocks are deltas against the one it lost, and the
+ * forced keyframe only reaches what is encoded next.
+ *
+ * WiFi TCP sessions use the same queue for the server's clients
+ * (Util/TcpFanout.h): the SCPI console reads cursor 0, and every stream tap
+ * its own. The console's blocks are kept -- a full arena waits on it, as the
+ * console's ring did (#520) -- while a tap that falls behind loses its own
+ * oldest blocks, and one that stops reading is disconnected by the WiFi task.
+ *
+ * Lock order: gFanoutMutex, then the transport's own write mutex. */
+
+/* Descriptors from the front of the encoder region (an eighth of it, a power
+ * of two), blocks in the rest. */
+static uintptr_t Streaming_FanoutCarve(uint32_t* pSlots, uint32_t* pArenaSize) {
+    uintptr_t base = ((uintptr_t)buffer + 3u) & ~(uintptr_t)3u;
+    uint32_t usable = bufferSize - (uint32_t)(base - (uintptr_t)buffer);
+    uint32_t slots = 2u;
+    while ((slots * 2u) * sizeof(SharedBlock_t) <= usable / 8u) {
+        slots *= 2u;
+    }
+    uint32_t descBytes = slots * (uint32_t)sizeof(SharedBlock_t);
+    *pSlots = slots;
+    *pArenaSize = (usable > descBytes) ? usable - descBytes : 0u;
+    return base;
+}
+
+static void Streaming_FanoutConfigure(void) {
+    StreamingInterface iface = gpRuntimeConfigStream->ActiveInterface;
+    /* Container-mode SD files are framed as the bytes enter the SD ring, with
+     * each batch's timestamps, which queue blocks no longer carry. */
+    bool usbAndSd = ((iface == StreamingInterface_UsbAndSd) ||
+                     (iface == StreamingInterface_USB && gSdExpectedThisSession)) &&
+                    !sd_card_manager_ContainerEnabled();
+    bool wifiTcp = (iface == StreamingInterface_WiFi);
+    bool ok = false;
+    uint32_t slots = 0u;
+    uint32_t arenaSize = 0u;
+    uint32_t maxBlock = 0u;
+
+    if (gFanoutMutex == NULL) {
+        return;
+    }
+    xSemaphoreTake(gFanoutMutex, portMAX_DELAY);
+    gFanoutActive = false;
+    gFanoutWifi = false;
+    gFanoutWifiJoined = false;
+    if (usbAndSd && buffer != NULL) {
+        /* A block must fit one USB transfer and half the SD ring whole --
+         * consumers never split one. */
+        uintptr_t base = Streaming_FanoutCarve(&slots, &arenaSize);
+        uint32_t descBytes = slots * (uint32_t)sizeof(SharedBlock_t);
+        maxBlock = UsbCdc_WriteTransferMax();
+        if (maxBlock > StreamingBufferPool_SdCircularSize() / 2u) {
+            maxBlock = StreamingBufferPool_SdCircularSize() / 2u;
+        }
+        if (maxBlock > arenaSize / 2u) {
+            maxBlock = arenaSize / 2u;
+        }
+        ok = (maxBlock >= STREAMING_BATCH_FIRST_ROOM) &&
+             SharedBlockQueue_Init(&gFanout, (SharedBlock_t*)base, slots,
+                                   (uint8_t*)(base + descBytes), arenaSize,
+                                   2u, maxBlock);
+        gFanoutActive = ok;
+        if (ok) {
+            LOG_I("USB+SD fan-out: %u B queue, %u blocks, %u B max block",
+                  (unsigned)arenaSize, (unsigned)slots, (unsigned)maxBlock);
+        }
+    } else if (wifiTcp && buffer != NULL) {
+        /* A block is one send() to the WINC, so it fits its send buffer. */
+        uintptr_t base = Streaming_FanoutCarve(&slots, &arenaSize);
+        uint32_t descBytes = slots * (uint32_t)sizeof(SharedBlock_t);
+        maxBlock = WIFI_WBUFFER_SIZE;
+        if (maxBlock > arenaSize / 2u) {
+            maxBlock = arenaSize / 2u;
+        }
+        ok = (maxBlock >= STREAMING_BATCH_FIRST_ROOM) &&
+             SharedBlockQueue_Init(&gFanout, (SharedBlock_t*)base, slots,
+                                   (uint8_t*)(base + descBytes), arenaSize,
+                                   WIFI_MAX_CLIENT, maxBlock) &&
+             TcpFanout_Init(&gWifiFanout, &gFanout, WIFI_MAX_CLIENT,
+                            WIFI_WBUFFER_SIZE);
+        if (ok) {
+            /* Clients connected before the start read from its first block;
+             * later ones are attached by the WiFi task as they connect. */
+            TickType_t now = xTaskGetTickCount();
+            uint8_t c;
+            for (c = 0; c < WIFI_MAX_CLIENT; c++) {
+                if (wifi_tcp_server_ClientConnected(c)) {
+                    TcpFanout_Attach(&gWifiFanout, c, (uint32_t)now);
+                }
+            }
+            LOG_I("WiFi fan-out: %u B queue, %u blocks, %u clients max",
+                  (unsigned)arenaSize, (unsigned)slots, (unsigned)WIFI_MAX_CLIENT);
+        }
+        gFanoutWifi = ok;
+        gFanoutActive = ok;
+    }
+    xSemaphoreGive(gFanoutMutex);
+    if (usbAndSd && !ok) {
+        /* Falls back to the two-ring path; only a manual SYST:MEM config
+         * with a tiny encoder buffer or USB DMA buffer gets here. */
+        LOG_E("USB+SD fan-out unavailable (encoder %u B) - per-transport writes",
+              (unsigned)bufferSize);
+    }
+    if (wifiTcp && !ok) {
+        /* The console's ring carries the stream, and only the console gets it. */
+        LOG_E("WiFi fan-out unavailable (encoder %u B) - console only",
+              (unsigned)bufferSize);
+    }
+}
+
+/* Stage the container-mode description of the next SD write: a file header,
+ * or the batch Streaming_EncodeBatch just produced. The map hash lets a
+ * reader tell segments with different channel sets or encodings apart. */
+static void Streaming_StageSdMark(uint8_t type) {
+    SdLogMark_t mark = {.type = type};
+    uint8_t enc = (uint8_t)gpRuntimeConfigStream->Encoding;
+    uint32_t crc = CRC32_Init();
+    crc = CRC32_Update(crc, &gChannelMapping.count, 1u);
+    crc = CRC32_Update(crc, gChannelMapping.channelIds, gChannelMapping.count);
+    crc = CRC32_Update(crc, &enc, 1u);
+    mark.mapHash = CRC32_Finalize(crc);
+    mark.scaleBits = (uint8_t)gDecimBits;
+    if (type == SDLOG_BLOCK_DATA) {
+        StreamingBatchSpan span;
+        Streaming_EncodeBatchSpan(&span);
+        mark.firstTs = span.firstTs;
+        mark.lastTs = span.lastTs;
+        mark.samples = span.samples;
+    }
+    sd_card_manager_StageWriteMark(&mark);
+}
+
+/* Charge evictions to the consumer that lost them (outside gFanoutMutex). */
+static void Streaming_FanoutCountDrops(const SharedBlockDrops_t* d) {
+    if (gFanoutWifi) {
+        /* Taps were charged in their own counters under the lock; the
+         * console is kept and never evicted. */
+        uint8_t c;
+        for (c = 0; c < SBQ_MAX_CONSUMERS; c++) {
+            if (d->blocks[c] > 0u) {
+                Nanopb_StreamingDeltaForceKeyframe();
+                break;
+            }
+        }
+        return;
+    }
+    if (d->bytes[FANOUT_USB] > 0u) {
+        bool pastGrace = Streaming_PastStartupGrace();
+        taskENTER_CRITICAL();
+        gStreamStats.usbDroppedBytes += d->bytes[FANOUT_USB];
+        if (pastGrace) {
+            gStreamStats.usbDroppedBytesSteady += d->bytes[FANOUT_USB];
+        }
+        gQuesBits |= QUES_BIT_USB_OVERFLOW;
+        taskEXIT_CRITICAL();
+        LOG_E_SESSION(LOG_SESSION_USB_DROP,
+            "Streaming: USB behind the shared queue - oldest blocks evicted");
+    }
+    if (d->bytes[FANOUT_SD] > 0u) {
+        Streaming_CountSdDrop(d->bytes[FANOUT_SD]);
+        LOG_E_SESSION(LOG_SESSION_SD_DROP,
+            "Streaming: SD behind the shared queue - oldest blocks evicted");
+    }
+    if (d->bytes[FANOUT_USB] > 0u || d->bytes[FANOUT_SD] > 0u) {
+        Nanopb_StreamingDeltaForceKeyframe();
+    }
+}
+
+/* Reserve the next block; evictions are charged before returning. */
+static uint8_t* Streaming_FanoutReserve(uint32_t* pSpan) {
+    SharedBlockDrops_t drops;
+    bool delta = (gpRuntimeConfigStream->Encoding == Streaming_ProtoBuffer) &&
+                 (gpRuntimeConfigStream->PbDeltaKeyframeInterval != 0u);
+    xSemaphoreTake(gFanoutMutex, portMAX_DELAY);
+    uint8_t* span = SharedBlockQueue_Reserve(&gFanout, STREAMING_BATCH_FIRST_ROOM,
+                                             pSpan, &drops);
+    if (delta) {
+        uint8_t c;
+        for (c = 0; c < SBQ_MAX_CONSUMERS; c++) {
+            if (drops.blocks[c] > 0u) {
+                drops.bytes[c] += SharedBlockQueue_Discard(&gFanout, c);
+            }
+        }
+    }
+    if (gFanoutWifi) {
+        (void)TcpFanout_ChargeDrops(&gWifiFanout, &drops);
+    }
+    xSemaphoreGive(gFanoutMutex);
+    Streaming_FanoutCountDrops(&drops);
+    return span;
+}
+
+/* WiFi fan-out: a refused Reserve means the arena is full behind the
+ * console. Wait for it the way the solo-WiFi path waited on its ring (#520),
+ * sending between tries; at the dead-interface timeout its backlog is dropped
+ * and counted as WiFi loss, and the stream goes on for the taps. */
+static uint8_t* gFanoutWaitSpan = NULL;
+static uint32_t gFanoutWaitSpanLen = 0u;
+
+static size_t Streaming_FanoutReserveTry(const char* unused, size_t len) {
+    (void)unused;
+    wifi_tcp_server_TransmitBufferedData();
+    gFanoutWaitSpan = Streaming_FanoutReserve(&gFanoutWaitSpanLen);
+    return (gFanoutWaitSpan != NULL) ? len : 0u;
+}
+
+static uint8_t* Streaming_FanoutReserveWifi(uint32_t* pSpan) {
+    gFanoutWaitSpan = NULL;
+    size_t r = Streaming_WriteWithRetry(Streaming_FanoutReserveTry, NULL,
+                                        STREAMING_BATCH_FIRST_ROOM);
+    if (r == STREAM_WRITE_RETURN_STOPPED) {
+        return NULL;
+    }
+    if (r == STREAM_WRITE_RETURN_TIMEOUT) {
+        xSemaphoreTake(gFanoutMutex, portMAX_DELAY);
+        uint32_t lost = TcpFanout_ReleasePrimary(&gWifiFanout);
+        xSemaphoreGive(gFanoutMutex);
+        Streaming_CountWifiDrop(lost);
+        Nanopb_StreamingDeltaForceKeyframe();
+        LOG_E_SESSION(LOG_SESSION_WIFI_DROP, "Streaming: WiFi interface dead (10s timeout)");
+        return Streaming_FanoutReserve(pSpan);
+    }
+    *pSpan = gFanoutWaitSpanLen;
+    return gFanoutWaitSpan;
+}
+
+/* Move the SD cursor's whole blocks into the SD ring while they fit. The
+ * write is all-or-nothing, so a block is either in the ring or still queued. */
+static void Streaming_FanoutFeedSd(void) {
+    for (;;) {
+        size_t room = sd_card_manager_GetWriteBuffFreeSize();
+        uint32_t len = 0;
+        bool fed = false;
+        xSemaphoreTake(gFanoutMutex, portMAX_DELAY);
+        const uint8_t* p = SharedBlockQueue_Peek(&gFanout, FANOUT_SD,
+                                                 (uint32_t)room, &len);
+        if (p != NULL &&
+            sd_card_manager_WriteToBuffer((const char*)p, len) == len) {
+            SharedBlockQueue_Consume(&gFanout, FANOUT_SD, len);
+            fed = true;
+        }
+        xSemaphoreGive(gFanoutMutex);
+        if (!fed) {
+            return;
+        }
+    }
+}
+
+/* One iteration's encode in fan-out mode; returns the bytes published. */
+static size_t Streaming_FanoutEncode(tBoardData* pBoardData,
+                                     StreamingEncoding encoding, bool sdLive,
+                                     bool* pEncoderFailed) {
+    uint32_t spanLen = 0;
+    *pEncoderFailed = false;
+    if (sdLive) {
+        Streaming_FanoutFeedSd();
+    }
+    uint8_t* span = Streaming_FanoutReserve(&spanLen);
+    if (span == NULL && gFanoutWifi) {
+        span = Streaming_FanoutReserveWifi(&spanLen);
+    }
+    if (span == NULL) {
+        /* Only a part-read block can refuse eviction, and both consumers
+         * take whole blocks; the samples simply stay queued. */
+        return 0;
+    }
+    if (gFanoutWifiJoined) {
+        gFanoutWifiJoined = false;
+        Nanopb_StreamingDeltaForceKeyframe();
+    }
+    size_t packetSize = Streaming_EncodeBatch(pBoardData, encoding, span,
+                                              spanLen, spanLen, pEncoderFailed);
+    xSemaphoreTake(gFanoutMutex, portMAX_DELAY);
+    SharedBlockQueue_Commit(&gFanout, (uint32_t)packetSize);
+    xSemaphoreGive(gFanoutMutex);
+    if (sdLive) {
+        Streaming_FanoutFeedSd();
+    }
+    if (gFanoutWifi && packetSize > 0u) {
+        wifi_tcp_server_KickStream();
+    }
+    return packetSize;
+}
+
+/* A new SD file (first open or rotation): what SD has queued was encoded for
+ * the previous one -- and in a PB delta session against its samples -- so
+ * it is dropped and counted, and the file opens on the header and a keyframe. */
+static void Streaming_FanoutDiscardSd(void) {
+    xSemaphoreTake(gFanoutMutex, portMAX_DELAY);
+    uint32_t lost = SharedBlockQueue_Discard(&gFanout, FANOUT_SD);
+    xSemaphoreGive(gFanoutMutex);
+    if (lost > 0u && gpRuntimeConfigStream->IsEnabled) {
+        Streaming_CountSdDrop(lost);
+    }
+}
+
+/* At stop, give the SD ring a bounded chance to take SD's backlog (USB's
+ * drains through UsbCdc_FlushWriteBuffer); whatever is left is SD loss. */
+static void Streaming_FanoutFlushSd(void) {
+    if (!gFanoutActive) {
+        return;
+    }
+    TickType_t start = xTaskGetTickCount();
+    uint32_t pending;
+    for (;;) {
+        if (gSdFileWasReady && sd_card_manager_IsBufferAccepting()) {
+            Streaming_FanoutFeedSd();
+        }
+        xSemaphoreTake(gFanoutMutex, portMAX_DELAY);
+        pending = SharedBlockQueue_Pending(&gFanout, FANOUT_SD);
+        xSemaphoreGive(gFanoutMutex);
+        if (pending == 0u ||
+            (xTaskGetTickCount() - start) > pdMS_TO_TICKS(500)) {
+            break;
+        }
+        vTaskDelay(1);
+    }
+    if (pending > 0u) {
+        xSemaphoreTake(gFanoutMutex, portMAX_DELAY);
+        pending = SharedBlockQueue_Discard(&gFanout, FANOUT_SD);
+        xSemaphoreGive(gFanoutMutex);
+        Streaming_CountSdDrop(pending);
+        LOG_E("Stream end: %u B of SD backlog not written", (unsigned)pending);
+    }
+}
+
+int Streaming_FanoutDrainUsb(uint32_t maxLen, int (*write)(uint8_t*, uint32_t)) {
+    int ret = 0;
+    if (!gFanoutActive || gFanoutMutex == NULL) {
+        return 0;
+    }
+    xSemaphoreTake(gFanoutMutex, portMAX_DELAY);
+    if (gFanoutActive) {
+        uint32_t len = 0;
+        const uint8_t* p = SharedBlockQueue_Peek(&gFanout, FANOUT_USB, maxLen, &len);
+        if (p != NULL) {
+            ret = write((uint8_t*)p, len);
+            if (ret > 0) {
+                SharedBlockQueue_Consume(&gFanout, FANOUT_USB, (uint32_t)ret);
+            }
+        }
+    }
+    xSemaphoreGive(gFanoutMutex);
+    return ret;
+}
+
+void Streaming_FanoutDetach(void) {
+    if (gFanoutMutex == NULL) {
+        return;
+    }
+    xSemaphoreTake(gFanoutMutex, portMAX_DELAY);
+    gFanoutActive = false;
+    gFanoutWifi = false;
+    xSemaphoreGive(gFanoutMutex);
+}
+
+int32_t Streaming_FanoutDrainWifi(uint8_t client, uint32_t minLen, TcpFanoutSend send) {
+    int32_t ret = 0;
+    if (!gFanoutWifi || gFanoutMutex == NULL) {
+        return 0;
+    }
+    xSemaphoreTake(gFanoutMutex, portMAX_DELAY);
+    if (gFanoutWifi) {
+        ret = TcpFanout_Drain(&gWifiFanout, client, minLen,
+                              (uint32_t)xTaskGetTickCount(), send, NULL);
+    }
+    xSemaphoreGive(gFanoutMutex);
+    return ret;
+}
+
+void Streaming_FanoutAttachWifi(uint8_t client) {
+    if (gFanoutMutex == NULL) {
+        return;
+    }
+    xSemaphoreTake(gFanoutMutex, portMAX_DELAY);
+    if (gFanoutWifi && !TcpFanout_IsAttached(&gWifiFanout, client)) {
+        TcpFanout_Attach(&gWifiFanout, client, (uint32_t)xTaskGetTickCount());
+        gFanoutWifiJoined = true;
+    }
+    xSemaphoreGive(gFanoutMutex);
+}
+
+void Streaming_FanoutDetachWifi(uint8_t client) {
+    if (gFanoutMutex == NULL) {
+        return;
+    }
+    xSemaphoreTake(gFanoutMutex, portMAX_DELAY);
+    if (gFanoutWifi) {
+        (void)TcpFanout_Detach(&gWifiFanout, client);
+    }
+    xSemaphoreGive(gFanoutMutex);
+}
+
+bool Streaming_FanoutWifiStalled(uint8_t client, uint32_t limitTicks) {
+    bool stalled = false;
+    if (!gFanoutWifi || gFanoutMutex == NULL) {
+        return false;
+    }
+    xSemaphoreTake(gFanoutMutex, portMAX_DELAY);
+    if (gFanoutWifi) {
+        stalled = TcpFanout_Stalled(&gWifiFanout, client,
+                                    (uint32_t)xTaskGetTickCount(), limitTicks);
+    }
+    xSemaphoreGive(gFanoutMutex);
+    return stalled;
+}
+
+bool Streaming_FanoutGetWifiClient(uint8_t client, TcpFanoutClient_t* out,
+                                   uint32_t* pPending) {
+    bool attached = false;
+    memset(out, 0, sizeof(*out));
+    *pPending = 0u;
+    if (gFanoutMutex == NULL || client >= WIFI_MAX_CLIENT) {
+        return false;
+    }
+    /* The counters outlive the session, like the rest of STATS?, until the
+     * slot's next attach. */
+    xSemaphoreTake(gFanoutMutex, portMAX_DELAY);
+    if (gWifiFanout.q != NULL) {
+        *out = gWifiFanout.client[client];
+        attached = gFanoutWifi && TcpFanout_IsAttached(&gWifiFanout, client);
+        *pPending = attached ? TcpFanout_Pending(&gWifiFanout, client) : 0u;
+    }
+    xSemaphoreGive(gFanoutMutex);
+    return attached;
+}
+
 /**
  * #533: drain both per-session sample queues (AIN + DIO) so no sample
  * captured by one session can be encoded into the next.  Called from
  * Streaming_Stop (the session is over — discard) and Streaming_Start
  * (symmetric backstop for a sample pushed by an in-flight deferred-task
  * tick between the stop-side drain and the next start).  Both pops are
- * 0-tick non-blocking (AINSAMPLE_/DIOSAMPLE_QUEUE_TICKS_TO_WAIT == 0).
+ * non-blocking (the AIN slot ring never blocks; DIOSAMPLE_QUEUE_TICKS_TO_WAIT == 0).
  */
 static void Streaming_DrainSessionSampleQueues(void) {
-    AInPublicSampleList_t* pStaleAin;
-    while (AInSampleList_PopFront(&pStaleAin)) {
-        if (pStaleAin != NULL) {
+    /* The AIN sample ring is single-consumer (AInSample.c): the pops below
+     * must not interleave with streaming_Task's. When called from that task
+     * (the #397 auto-stop) we ARE the consumer. Otherwise hold the scheduler
+     * off and only drain once the encoder is outside its #486 window -- it
+     * sets that flag before its first ring access, so flag clear + scheduler
+     * suspended means no encoder pop is half-done or can start. Bounded like
+     * SCPI_StartStreaming's quiescence wait; on timeout the AIN drain is
+     * skipped (the start-path ring re-init still discards the samples). */
+    bool ringOwned = (xTaskGetCurrentTaskHandle() == gStreamingTaskHandle);
+    if (!ringOwned) {
+        TickType_t qStart = xTaskGetTickCount();
+        for (;;) {
+            vTaskSuspendAll();
+            if (gStreamingTaskInCritical == 0) {
+                ringOwned = true;
+                break;
+            }
+            (void)xTaskResumeAll();
+            if ((xTaskGetTickCount() - qStart) > pdMS_TO_TICKS(100)) {
+                LOG_E("Streaming: AIN drain skipped, encoder not quiescent");
+                break;
+            }
+            vTaskDelay(1);
+        }
+        if (ringOwned) {
+            AInPublicSampleList_t* pStaleAin;
+            while (AInSampleList_PopFront(&pStaleAin)) {
+                AInSampleList_FreeToPool(pStaleAin);
+            }
+            (void)xTaskResumeAll();
+        }
+    } else {
+        AInPublicSampleList_t* pStaleAin;
+        while (AInSampleList_PopFront(&pStaleAin)) {
             AInSampleList_FreeToPool(pStaleAin);
         }
     }
@@ -2083,6 +2853,43 @@ static void Streaming_DrainSessionSampleQueues(void) {
     }
 }
 
+/* A PB block session holds up to a block of sample sets back from the
+ * encoder (Streaming_EncodeSetBlockHold), so at stop the tail of the
+ * session would still be queued and the drain below would discard it.
+ * Release the hold and let streaming_Task run final encode passes -- its
+ * transport writes stay non-blocking, since IsEnabled is already false --
+ * until the AIN queue is empty, a pass makes no progress, or the bound
+ * expires. Not from the streaming task itself (the #397 auto-stop: every
+ * transport is down, so there is nothing to flush to). Block sessions only:
+ * no other encoding holds samples back, so their stop keeps the #533 drain
+ * and adds no wait. */
+static void Streaming_FlushHeldSamples(void) {
+    if (gpRuntimeConfigStream->Encoding != Streaming_ProtoBufferBlock) {
+        return;
+    }
+    if (gStreamingTaskHandle == NULL ||
+        xTaskGetCurrentTaskHandle() == gStreamingTaskHandle) {
+        return;
+    }
+    Streaming_EncodeReleaseBlockHold();
+    TickType_t start = xTaskGetTickCount();
+    while (!AInSampleList_IsEmpty()) {
+        uint32_t popped = AInSampleList_PopCount();
+        gStopFlushPending = 1;
+        xTaskNotifyGive(gStreamingTaskHandle);
+        while (gStopFlushPending != 0 &&
+               (xTaskGetTickCount() - start) <= pdMS_TO_TICKS(STREAM_STOP_FLUSH_MS)) {
+            vTaskDelay(1);
+        }
+        if (gStopFlushPending != 0 || AInSampleList_PopCount() == popped) {
+            LOG_E("Stream end: %u sample sets not flushed",
+                  (unsigned)AInSampleList_Size());
+            break;
+        }
+    }
+    gStopFlushPending = 0;
+}
+
 static void Streaming_Stop(void) {
     if (gpRuntimeConfigStream->Running) {
         TimerApi_Stop(gpStreamingConfig->TimerIndex);
@@ -2091,6 +2898,9 @@ static void Streaming_Stop(void) {
         // Revert ADC to software triggering so non-streaming reads
         // (ADC_Tasks polling) still work.
         MC12b_ConfigureHardwareTrigger(false, false);
+        // Back to the per-input ISRs before the idle list differs from the
+        // span the DMA was copying.
+        MC12b_StopScanDma();
         // #541 D-B: restore the idle scan list (all public T2 + enabled
         // monitoring) so idle-time MEAS:VOLT:DC? and SYST:INFo monitoring
         // cover the full channel set again, not just last session's subset.
@@ -2116,7 +2926,25 @@ static void Streaming_Stop(void) {
         // desktop-observed leftover frame exactly one sample period past
         // the prior session's last frame.  A late deferred-task push after
         // this drain is caught by the symmetric drain in Streaming_Start.
+        // A PB block session's held sets are encoded first, not drained.
+        Streaming_FlushHeldSamples();
         Streaming_DrainSessionSampleQueues();
+        // Drop the PB delta chain with the samples it was built from, so
+        // nothing of this session's reference values reaches the next one.
+        Nanopb_StreamingDeltaConfigure(0u);
+        // Rate stamps and the INFO timebase fields describe the configured
+        // rate again once nothing is being decimated.
+        gRateAdaptive = false;
+        gRateStampDivisor = 1u;
+        gDecimActive = false;
+        gDecimFactor = 1u;
+        gDecimBits = 0u;
+        gCaptureActive = false;
+        // USB+SD fan-out: SD's share of the queue goes to the card now; USB's
+        // keeps draining from the USB task until the next re-partition.
+        Streaming_FanoutFlushSd();
+        // What the UDP ring still holds is sent; its socket closes after.
+        wifi_udp_stream_Stop();
 
         // #367 diagnostics: snapshot bytes still sitting in the WiFi TCP
         // circular buffer at session end.  If TotalBytesStreamed -
@@ -2124,6 +2952,13 @@ static void Streaming_Stop(void) {
         // accounting gap is "tail bytes never drained at Stop".
         gStreamStats.circularBufferEndBytes =
             wifi_tcp_server_GetCircularBufferAvailable();
+        if (gFanoutWifi) {
+            // The console's stream is queued in the fan-out, not its ring.
+            xSemaphoreTake(gFanoutMutex, portMAX_DELAY);
+            gStreamStats.circularBufferEndBytes +=
+                TcpFanout_Pending(&gWifiFanout, TCP_FANOUT_PRIMARY);
+            xSemaphoreGive(gFanoutMutex);
+        }
         if (gStreamStats.circularBufferEndBytes > 0) {
             LOG_E_SESSION(LOG_SESSION_BUFFER_TAIL,
                 "diag367: circular buffer tail at Stop = %u bytes",
@@ -2209,6 +3044,10 @@ void Streaming_Init(tStreamingConfig* pStreamingConfigInit,
     gStreamRateConfigured = 0u;
     gBenchmarkMode = BENCHMARK_OFF;
     gSdFileWasReady = false;
+    /* Fan-out queue: same retained-RAM concern -- a stale handle or flag
+     * would have the USB task read an arena nothing configured. */
+    gFanoutActive = false;
+    gFanoutMutex = xSemaphoreCreateMutex();
     memset((void*)&gStreamStats, 0, sizeof(gStreamStats));
     gTimerISRCalls = 0;
     gScanStaleDropped = 0;
@@ -2397,6 +3236,7 @@ void Streaming_GetStats(StreamingStats* out) {
                                                      : 0u;
     }
     out->scanStaleDropped = gScanStaleDropped;  // #557 (separate volatile, like timerISRCalls)
+    out->rateDivisor = gRateDivisor;            // live, not a session counter
     taskEXIT_CRITICAL();
 }
 
@@ -2556,6 +3396,135 @@ static void Streaming_UpdateFlowWindow(bool dropped) {
     taskEXIT_CRITICAL();
 }
 
+// Counter growth since the last control period. A mid-session
+// SYST:STR:STATS:CLEar restarts the counters, which reads as a smaller value.
+static uint32_t Streaming_RateDelta(uint32_t now, uint32_t* pLast) {
+    uint32_t d = (now >= *pLast) ? (now - *pLast) : now;
+    *pLast = now;
+    return d;
+}
+
+/**
+ * SYST:STR:ADAPTive controller step, called on every streaming_Task wake.
+ * Tracks the sample pool's peak fill between control periods -- the ring the
+ * #520 backpressure fills first when any transport falls behind, so it rises
+ * before anything is lost -- and once per RATE_CONTROL_PERIOD_MS feeds it to
+ * the controller with that period's lost samples and transport drop bytes.
+ * Nothing is fed during the startup grace: its transients are not the link.
+ */
+static void Streaming_RateControlService(void) {
+    if (!gRateAdaptive) {
+        return;
+    }
+    uint32_t cap = (uint32_t)AInSampleList_PoolCapacity();
+    if (cap > 0u) {
+        uint32_t fill = (uint32_t)(((uint64_t)AInSampleList_Size() * 100u) / cap);
+        if (fill > gRatePeakFill) gRatePeakFill = fill;
+    }
+    TickType_t now = xTaskGetTickCount();
+    if ((TickType_t)(now - gRateLastTick) < pdMS_TO_TICKS(RATE_CONTROL_PERIOD_MS)) {
+        return;
+    }
+    gRateLastTick = now;
+
+    RateControlSample_t s;
+    s.peakFillPct = gRatePeakFill;
+    s.lostSamples = Streaming_RateDelta(gStreamStats.queueDroppedSamples +
+                                        gStreamStats.encoderDroppedSamples,
+                                        &gRateLastLost);
+    s.droppedBytes = Streaming_RateDelta(gStreamStats.usbDroppedBytes +
+                                         gStreamStats.wifiDroppedBytes +
+                                         gStreamStats.sdDroppedBytes,
+                                         &gRateLastDropped);
+    gRatePeakFill = 0u;
+    if (!Streaming_PastStartupGrace()) {
+        return;
+    }
+
+    RateControlStep step = RateControl_Update(&gRateControl, &s);
+    if (step == RATE_CONTROL_HOLD) {
+        return;
+    }
+    gRateDivisor = RateControl_Divisor(&gRateControl);
+    taskENTER_CRITICAL();
+    if (step == RATE_CONTROL_DOWN) {
+        gStreamStats.rateDecreases++;
+    } else {
+        gStreamStats.rateIncreases++;
+    }
+    taskEXIT_CRITICAL();
+    LOG_D("Streaming: adaptive divisor %u (fill %u%%, lost %u, drop %u B)",
+          (unsigned)gRateDivisor, (unsigned)s.peakFillPct,
+          (unsigned)s.lostSamples, (unsigned)s.droppedBytes);
+}
+
+bool Streaming_RateStampDue(uint32_t ts) {
+    if (gRateChangeSeq == gRateStampedSeq) {
+        return false;                   // the common case: no change pending
+    }
+    taskENTER_CRITICAL();
+    uint32_t seq = gRateChangeSeq;
+    uint32_t changeTs = gRateChangeTs;
+    uint32_t div = gRateChangeDivisor;
+    taskEXIT_CRITICAL();
+    // Sets queued before the change are still at the old step. Wrap-safe.
+    if ((int32_t)(ts - changeTs) < 0) {
+        return false;
+    }
+    // Nanopb_Encode reads the divisor while it encodes the stamp; the change
+    // counts as stamped only once Streaming_RateStampDone says it was.
+    gRateStampPendingSeq = seq;
+    gRateStampPrevDivisor = gRateStampDivisor;
+    gRateStampDivisor = div;
+    return true;
+}
+
+void Streaming_RateStampDone(bool written) {
+    if (written) {
+        gRateStampedSeq = gRateStampPendingSeq;
+    } else {
+        gRateStampDivisor = gRateStampPrevDivisor;
+    }
+}
+
+uint32_t Streaming_RateStampDivisor(void) {
+    return gRateStampDivisor;
+}
+
+uint32_t Streaming_CodeScaleBits(void) {
+    if (gpRuntimeConfigStream == NULL) {
+        return 0u;
+    }
+    if (gpRuntimeConfigStream->IsEnabled) {
+        return gDecimBits;
+    }
+    // Idle: what the next START applies, so a host reading INFO first
+    // converts that session's codes right. A capture session decimates
+    // nothing; if its ring then fails to fit, START streams decimated and
+    // the running value above takes over.
+    if (gpRuntimeConfigStream->DecimateFactor <= 1u ||
+        gpRuntimeConfigStream->CapturePost > 0u) {
+        return 0u;
+    }
+    return Streaming_DecimScaleBits(gpRuntimeConfigStream);
+}
+
+void Streaming_CaptureForce(void) {
+    /* The SCPI consoles (USB, WiFi) run in different tasks. */
+    taskENTER_CRITICAL();
+    gCaptureForceSeq++;
+    taskEXIT_CRITICAL();
+}
+
+void Streaming_GetCaptureStatus(uint32_t* state, uint32_t* framesLeft,
+                                uint32_t* triggerTs, uint32_t* ignored) {
+    CaptureState s = CaptureRing_State(&gCapture);
+    *state = (uint32_t)s;
+    *framesLeft = (s == CAPTURE_DONE) ? gCapture.readLeft : 0u;
+    *triggerTs = gCapture.triggerTs;
+    *ignored = gCapture.ignoredTriggers;
+}
+
 bool Streaming_IsClipping(void)
 {
     /* Plain 32-bit load -- atomic on PIC32MZ, single writer (the deferred
@@ -2595,6 +3564,15 @@ void Streaming_NoteEosFired(void) {
 // so the 64-bit accumulate must also be critical-section guarded to
 // prevent torn reads on the snapshot side.  Idle-count is 32-bit so the
 // increment is atomic on PIC32MZ and doesn't need the critical section.
+void Streaming_AddProfileSample_PbEncode(uint32_t cycles, uint32_t bytesOut) {
+    taskENTER_CRITICAL();
+    gStreamStats.pbEncodeCycles += cycles;
+    if (cycles > gStreamStats.pbEncodeMaxCycles) {
+        gStreamStats.pbEncodeMaxCycles = cycles;
+    }
+    gStreamStats.pbEncodeBytesOut += bytesOut;
+    taskEXIT_CRITICAL();
+}
 void Streaming_AddProfileSample_WriteBuf(uint32_t cycles) {
     taskENTER_CRITICAL();
     gStreamStats.usbWriteBufCycles += cycles;
@@ -2674,26 +3652,18 @@ void Streaming_UpdateState(void) {
  * @note This function will return early if streaming is disabled or there is no data to process.
  */
 
-// #662 batch-pop: per encoder wake, encode up to STREAMING_BATCH_MAX samples
-// back-to-back into one buffer, then a SINGLE output write of the concatenated
-// framed messages. Amortizes the per-wake output-write + size-query overhead
-// across N samples. Each encoder call pops one sample and emits a self-framed
-// unit (PB length-delimited / CSV row / JSON object), so concatenating N is
-// byte-identical to N separate writes — invisible to clients (no wire-format
-// change). Bounded so a backlog can't monopolize the encoder or delay the
-// output write beyond N samples' worth. STREAMING_BATCH_MIN_ROOM is a
-// conservative worst-case single-message size: the batch stops before an
-// encode that isn't guaranteed to fit, so a 0 encoder return unambiguously
-// means empty-queue/failure rather than truncation.
-#define STREAMING_BATCH_MAX      8u
-#define STREAMING_BATCH_MIN_ROOM 1024u
+// #662 batch-pop: see streaming_encode.h for the batch bounds
+// (STREAMING_BATCH_MAX / STREAMING_BATCH_MIN_ROOM) and Streaming_EncodeBatch.
 
 void streaming_Task(void) {
-    // Enable FPU context saving for this task (required for ADC voltage conversion)
+    // Enable FPU context saving for this task. CSV and JSON values take the
+    // integer FixedPointCal path, but a value it cannot decide (near a
+    // rounding boundary), a precision above FIXEDFMT_MAX_PRECISION and a
+    // calibration change still convert in double here, and those results
+    // must survive a context switch -- so the flag stays.
     portTASK_USES_FLOATING_POINT();
 
      TickType_t xBlockTime = portMAX_DELAY;
-    NanopbFlagsArray nanopbFlag;
     size_t usbSize, wifiSize, sdSize;
     /* #371/#372: USB/WiFi gates moved to ActiveInterface checks at the
      * write sites — hasUsb / hasWifi are no longer consulted, removed
@@ -2714,17 +3684,19 @@ void streaming_Task(void) {
 
         // Don't process data or update QUES bits after streaming stops.
         // A notification may already be pending when Stop clears gQuesBits.
-        if (!pRunTimeStreamConf->IsEnabled) {
+        // The one exception is Streaming_Stop's final pass, which runs
+        // before that clear.
+        bool stopFlush = (gStopFlushPending != 0);
+        if (!pRunTimeStreamConf->IsEnabled && !stopFlush) {
             continue;
         }
 
         /* #486 — quiescence flag for cross-task sync against
          * SCPI_StartStreaming re-partition.  Set BEFORE any deref of the
-         * encoder buffer pointer, sample queue (AInSampleList_IsEmpty
-         * reads queue head/tail; AInSampleList_InitializeExternal calls
-         * vQueueDelete + xQueueCreate so the queue handle itself is a
-         * use-after-free target), DIO sample list, or output buffer
-         * size accessors.
+         * encoder buffer pointer, sample ring (AInSampleList_IsEmpty
+         * reads the ring counters; AInSampleList_InitializeExternal swaps
+         * the slot memory and resets the counters underneath us), DIO
+         * sample list, or output buffer size accessors.
          *
          * The compiler memory barrier prevents -O3 from hoisting any
          * subsequent non-volatile read above the volatile flag store.
@@ -2738,7 +3710,7 @@ void streaming_Task(void) {
          * flag and skip this iteration so quiescence is observable. */
         gStreamingTaskInCritical = 1;
         __asm__ __volatile__ ("" ::: "memory");
-        if (!pRunTimeStreamConf->IsEnabled) {
+        if (!pRunTimeStreamConf->IsEnabled && !stopFlush) {
             goto iter_done;
         }
 
@@ -2747,7 +3719,8 @@ void streaming_Task(void) {
         // and surface the reason via QUES bit 12 + LOG_E.  Individual
         // overflow bits (USB/WiFi/SD) still fire pre-grace for transient
         // drops — this only fires when nothing is consuming our data.
-        if (Streaming_AllConfiguredTransportsDead(pRunTimeStreamConf)) {
+        if (!stopFlush &&
+            Streaming_AllConfiguredTransportsDead(pRunTimeStreamConf)) {
             taskENTER_CRITICAL();
             gQuesBits |= QUES_BIT_TRANSPORT_DOWN;
             taskEXIT_CRITICAL();
@@ -2762,6 +3735,13 @@ void streaming_Task(void) {
         if (buffer == NULL || bufferSize == 0) {
             goto iter_done;
         }
+        // USB+SD fan-out: `buffer` holds the shared block queue, and the
+        // outputs read it on their own (see Streaming_FanoutConfigure).
+        bool fanout = gFanoutActive;
+
+        if (!stopFlush) {
+            Streaming_RateControlService();
+        }
 
         AINDataAvailable = !AInSampleList_IsEmpty();
         DIODataAvailable = !DIOSampleList_IsEmpty(&pBoardData->DIOSamples);
@@ -2771,7 +3751,9 @@ void streaming_Task(void) {
         }
 
         usbSize = UsbCdc_WriteBuffFreeSize(NULL);
-        wifiSize = wifi_manager_GetWriteBuffFreeSize();
+        wifiSize = (pRunTimeStreamConf->ActiveInterface == StreamingInterface_WiFiUdp)
+            ? wifi_udp_stream_GetWriteBuffFreeSize()
+            : wifi_manager_GetWriteBuffFreeSize();
         /* #757: gate on IsBufferAccepting, not IsWriteReady.
          *
          * The old gate asked "is a file open right now", which is false for
@@ -2801,39 +3783,64 @@ void streaming_Task(void) {
         // without injecting duplicate headers into the USB/WiFi stream.
         if (sdSize > 0 && !gSdFileWasReady) {
             gSdFileWasReady = true;
+            // This is where a rotation's Streaming_ResetSdFileHeader() latch
+            // is consumed: the new file must open on a PB keyframe, not on a
+            // delta against a sample that lives in the previous file. Taken
+            // here, in the encoding task and before this iteration's encode,
+            // rather than in the reset itself (sd_card_manager task).
+            Nanopb_StreamingDeltaForceKeyframe();
 
             // Write SD-only header/metadata for each new file so every
             // file is self-describing and independently parseable.
+            // In fan-out mode `buffer` is the queue: SD's backlog belongs
+            // to the previous file, and the header is built in a block
+            // borrowed from the queue and released unpublished.
+            uint8_t* hdrBuf = (uint8_t*)buffer;
+            size_t hdrRoom = bufferSize;
+            if (fanout) {
+                uint32_t scratchLen = 0;
+                Streaming_FanoutDiscardSd();
+                hdrBuf = Streaming_FanoutReserve(&scratchLen);
+                hdrRoom = scratchLen;
+            }
             size_t sdHdrLen = 0;
-            if (Streaming_EncodingIsCsv(pRunTimeStreamConf->Encoding)) {
+            if (hdrBuf == NULL) {
+                // no scratch block (see Streaming_FanoutEncode): no header
+            } else if (Streaming_EncodingIsCsv(pRunTimeStreamConf->Encoding)) {
                 // On rotation (header already sent to USB), generate
                 // SD-only header.  First file: encoder flag is false,
                 // so the encoder naturally includes the header for ALL
                 // interfaces — no special handling needed.
                 if (csv_IsHeaderSent()) {
                     sdHdrLen = csv_GenerateHeaderToBuffer(
-                            (char*)buffer, bufferSize);
+                            (char*)hdrBuf, hdrRoom);
                 }
             } else if (pRunTimeStreamConf->Encoding == Streaming_Json) {
                 if (json_IsHeaderSent()) {
                     sdHdrLen = json_GenerateHeaderToBuffer(
-                            (char*)buffer, bufferSize);
+                            (char*)hdrBuf, hdrRoom);
                 }
             } else {
                 // Protobuf: encode a standalone metadata message for SD
                 tBoardData* pBoardData =
                     BoardData_Get(BOARDDATA_ALL_DATA, true);
                 sdHdrLen = Nanopb_Encode(pBoardData,
-                    &fields_sd_metadata, (uint8_t*)buffer, bufferSize);
+                    &fields_sd_metadata, hdrBuf, hdrRoom);
             }
             if (sdHdrLen > 0) {
+                Streaming_StageSdMark(SDLOG_BLOCK_HEADER);
                 size_t written = sd_card_manager_WriteToBuffer(
-                        (const char*)buffer, sdHdrLen);
+                        (const char*)hdrBuf, sdHdrLen);
                 if (written != sdHdrLen) {
                     LOG_E("SD: header write failed, expected=%u written=%u",
                           (unsigned)sdHdrLen, (unsigned)written);
                 }
-                memset(buffer, 0, sdHdrLen);
+                memset(hdrBuf, 0, sdHdrLen);
+            }
+            if (fanout) {
+                xSemaphoreTake(gFanoutMutex, portMAX_DELAY);
+                SharedBlockQueue_Commit(&gFanout, 0u);
+                xSemaphoreGive(gFanoutMutex);
             }
         }
 
@@ -2866,7 +3873,7 @@ void streaming_Task(void) {
         if (pSDCardSettings && pSDCardSettings->enable &&
             pSDCardSettings->mode == SD_CARD_MANAGER_MODE_WRITE) {
             // Only enable SD if we're not streaming to WiFi (SPI bus conflict)
-            if (pRunTimeStreamConf->ActiveInterface != StreamingInterface_WiFi) {
+            if (!StreamingInterface_IsWiFi(pRunTimeStreamConf->ActiveInterface)) {
                 hasSD = (sdSize >= 128);
             }
         }
@@ -2907,6 +3914,13 @@ void streaming_Task(void) {
         switch (pRunTimeStreamConf->ActiveInterface) {
             case StreamingInterface_USB:      batchXportFree = usbSize; break;
             case StreamingInterface_WiFi:     batchXportFree = wifiSize; break;
+            case StreamingInterface_WiFiUdp:
+                // A batch may span datagrams, but losing any one of them
+                // loses the whole batch at the receiver: stop adding
+                // messages once a datagram's worth is encoded.
+                batchXportFree = (wifiSize < WIFI_UDP_STREAM_PAYLOAD_MAX + STREAMING_BATCH_MIN_ROOM)
+                    ? wifiSize : WIFI_UDP_STREAM_PAYLOAD_MAX + STREAMING_BATCH_MIN_ROOM;
+                break;
             case StreamingInterface_SD:       batchXportFree = sdSize; break;
             case StreamingInterface_UsbAndSd:
                 batchXportFree = (usbSize < sdSize) ? usbSize : sdSize; break;
@@ -2915,97 +3929,80 @@ void streaming_Task(void) {
         if (hasSD && sdSize < batchXportFree) {
             batchXportFree = sdSize;         // SD-logging override also writes SD
         }
-        packetSize = 0;
-        for (uint32_t batchIdx = 0; batchIdx < STREAMING_BATCH_MAX; batchIdx++) {
-            bool ainNow = !AInSampleList_IsEmpty();
-            bool dioNow = !DIOSampleList_IsEmpty(&pBoardData->DIOSamples);
-            if (!ainNow && !dioNow) {
-                break;                       // queue drained — normal batch end
-            }
-            // First message always encoded (drain the queue); additional
-            // messages must keep MIN_ROOM within the encoder buffer AND the
-            // smallest active transport ring, so the single all-or-nothing write
-            // below always fits its ring. Addition (not subtraction) avoids
-            // size_t underflow when a transport ring is momentarily full (free=0).
-            if (batchIdx > 0) {
-                if ((bufferSize - packetSize) < STREAMING_BATCH_MIN_ROOM) {
-                    break;                   // no encoder-buffer room
-                }
-                if ((packetSize + STREAMING_BATCH_MIN_ROOM) > batchXportFree) {
-                    break;                   // would overflow the smallest active ring
-                }
-            }
-
-            nanopbFlag.Size = 0;
-            nanopbFlag.Data[nanopbFlag.Size++] = DaqifiOutMessage_msg_time_stamp_tag;
-            if (ainNow) {
-                nanopbFlag.Data[nanopbFlag.Size++] = DaqifiOutMessage_analog_in_data_tag;
-            }
-            if (dioNow) {
-                nanopbFlag.Data[nanopbFlag.Size++] = DaqifiOutMessage_digital_data_tag;
-                nanopbFlag.Data[nanopbFlag.Size++] = DaqifiOutMessage_digital_port_dir_tag;
-            }
-
-            uint8_t *encPtr = (uint8_t *) buffer + packetSize;
-            size_t encRoom = bufferSize - packetSize;
-            size_t encoded = 0;
-            DioProbe_PulseStart(8);  /* probe 8: encode duration */
-            if (Streaming_EncodingIsCsv(pRunTimeStreamConf->Encoding)) {
-                DIO_TIMING_TEST_WRITE_STATE(1);
-                encoded = csv_Encode(pBoardData, &nanopbFlag, encPtr, encRoom);
-                DIO_TIMING_TEST_WRITE_STATE(0);
-            } else if (pRunTimeStreamConf->Encoding == Streaming_Json) {
-                DIO_TIMING_TEST_WRITE_STATE(1);
-                encoded = Json_Encode(pBoardData, &nanopbFlag, encPtr, encRoom);
-                DIO_TIMING_TEST_WRITE_STATE(0);
-            } else {
-                DIO_TIMING_TEST_WRITE_STATE(1);
-#if PB_PROFILE_COUNTERS
-                uint32_t pbStart = _CP0_GET_COUNT();
-                encoded = Nanopb_EncodeStreamingFast(pBoardData, &nanopbFlag, encPtr, encRoom);
-                uint32_t pbCycles = _CP0_GET_COUNT() - pbStart;
+        // Zero-copy: encode straight into one transport's ring when it has
+        // a contiguous MIN_ROOM span (see StreamDirectSink). UsbAndSd targets
+        // SD (USB is no-retry there); USB with the SD-logging override
+        // targets USB (SD is no-retry there). The other output copies out of
+        // the span below, and the commit waits for it. Any other case, or a
+        // short span, encodes into `buffer` as before.
+        bool sdLive = hasSD && gSdFileWasReady;
+        StreamDirectSink direct = STREAM_DIRECT_NONE;
+        bool directShared = false;
+        switch (pRunTimeStreamConf->ActiveInterface) {
+            case StreamingInterface_USB:
+                direct = STREAM_DIRECT_USB;
+                directShared = sdLive;
+                break;
+            case StreamingInterface_WiFi:
+                direct = STREAM_DIRECT_WIFI;
+                break;
+            case StreamingInterface_SD:
+                direct = sdLive ? STREAM_DIRECT_SD : STREAM_DIRECT_NONE;
+                break;
+            case StreamingInterface_UsbAndSd:
+                direct = sdLive ? STREAM_DIRECT_SD : STREAM_DIRECT_USB;
+                directShared = sdLive;
+                break;
+            default:
+                break;
+        }
+        size_t spanLen = 0;
+        uint8_t* span = fanout ? NULL : Streaming_DirectReserve(direct, &spanLen);
+        if (span == NULL) {
+            direct = STREAM_DIRECT_NONE;
+        }
+        const uint8_t* out = (span != NULL) ? span : (const uint8_t*)buffer;
+
+        bool encoderFailed = false;
+        if (fanout) {
+            // Published to the queue, not to a ring: both outputs below are
+            // skipped and read it through their cursors.
+            packetSize = Streaming_FanoutEncode(pBoardData,
+                    pRunTimeStreamConf->Encoding, sdLive, &encoderFailed);
+        } else if (span != NULL) {
+            packetSize = Streaming_EncodeBatch(pBoardData,
+                    pRunTimeStreamConf->Encoding, span, spanLen,
+                    (batchXportFree < spanLen) ? batchXportFree : spanLen,
+                    &encoderFailed);
+        } else {
+            packetSize = Streaming_EncodeBatch(pBoardData,
+                    pRunTimeStreamConf->Encoding,
+                    (uint8_t*)buffer, bufferSize, batchXportFree, &encoderFailed);
+        }
+        // Publish now unless the second output still has to copy it out.
+        if (direct != STREAM_DIRECT_NONE && !directShared) {
+            Streaming_DirectCommit(direct, packetSize);
+        }
+        if (encoderFailed) {
+            // A non-empty queue with guaranteed room produced nothing: a real
+            // encoder failure or the #484 shutdown race. Account exactly one
+            // lost sample (each encode pops exactly one, #297).
+            // #483: bump the Steady subset when past the 3 s startup grace.
+            if (pRunTimeStreamConf->IsEnabled) {
+                bool pastGrace = Streaming_PastStartupGrace();
                 taskENTER_CRITICAL();
-                gStreamStats.pbEncodeCycles += pbCycles;
-                if (pbCycles > gStreamStats.pbEncodeMaxCycles) {
-                    gStreamStats.pbEncodeMaxCycles = pbCycles;
-                }
-                if (encoded > 0) {
-                    gStreamStats.pbEncodeBytesOut += encoded;
+                gStreamStats.encoderFailures++;
+                gStreamStats.encoderDroppedSamples++;
+                if (pastGrace) {
+                    gStreamStats.encoderFailuresSteady++;
+                    gStreamStats.encoderDroppedSamplesSteady++;
                 }
+                gQuesBits |= QUES_BIT_ENCODER_FAIL;
                 taskEXIT_CRITICAL();
-#else
-                encoded = Nanopb_EncodeStreamingFast(pBoardData, &nanopbFlag, encPtr, encRoom);
-#endif
-                DIO_TIMING_TEST_WRITE_STATE(0);
-            }
-            DioProbe_PulseEnd(8);
-
-            if (encoded == 0) {
-                // The queue was non-empty (checked above) with guaranteed room,
-                // yet the encoder produced nothing → a real encoder failure OR
-                // the #484 shutdown race (Streaming_Stop ran mid-iteration and
-                // the encoder saw partially torn-down state — verified empirically
-                // to fire at Stop, not mid-stream). Account exactly one lost
-                // sample (each encode pops exactly one, #297) and stop the batch.
-                // #483: bump the Steady subset when past the 3 s startup grace.
-                if (pRunTimeStreamConf->IsEnabled) {
-                    bool pastGrace = Streaming_PastStartupGrace();
-                    taskENTER_CRITICAL();
-                    gStreamStats.encoderFailures++;
-                    gStreamStats.encoderDroppedSamples++;
-                    if (pastGrace) {
-                        gStreamStats.encoderFailuresSteady++;
-                        gStreamStats.encoderDroppedSamplesSteady++;
-                    }
-                    gQuesBits |= QUES_BIT_ENCODER_FAIL;
-                    taskEXIT_CRITICAL();
-                    LOG_E_SESSION(LOG_SESSION_ENCODER_SAMPLE_LOSS,
-                        "Streaming: encoder failure lost 1 sample");
-                    LOG_E_SESSION(LOG_SESSION_ENCODER_FAIL, "Streaming: Encoder failure detected");
-                }
-                break;
+                LOG_E_SESSION(LOG_SESSION_ENCODER_SAMPLE_LOSS,
+                    "Streaming: encoder failure lost 1 sample");
+                LOG_E_SESSION(LOG_SESSION_ENCODER_FAIL, "Streaming: Encoder failure detected");
             }
-            packetSize += encoded;
         }
         if (packetSize > 0) {
             taskENTER_CRITICAL();
@@ -3013,7 +4010,7 @@ void streaming_Task(void) {
             taskEXIT_CRITICAL();
         }
         DIO_TIMING_TEST_WRITE_STATE(1);
-        if (packetSize > 0) {
+        if (packetSize > 0 && !fanout) {
             DioProbe_PulseStart(9);  /* probe 9: output write duration */
             // All-or-nothing output writes. On timeout (10s), the interface
             // is assumed dead. Backpressure propagates to sample queue —
@@ -3031,7 +4028,10 @@ void streaming_Task(void) {
             // Now we call UsbCdc_WriteToBuffer unconditionally when USB is in
             // the active set; its own pre-check returns 0 on no-space, and
             // we count that as a drop.
-            if (pRunTimeStreamConf->ActiveInterface == StreamingInterface_USB) {
+            if (direct == STREAM_DIRECT_USB) {
+                // Encoded into the USB ring: committed above, or below once
+                // SD has copied it out.
+            } else if (pRunTimeStreamConf->ActiveInterface == StreamingInterface_USB) {
                 // #520 backpressure (solo USB): block the encoder on a full USB
                 // ring so the sample pool absorbs the burst (single drop point =
                 // pool exhaustion), bounded by WriteWithRetry's 10 s
@@ -3040,7 +4040,7 @@ void streaming_Task(void) {
                 // (below) — multi-output backpressure pacing is a separate
                 // ticket (SD would pace USB).
                 size_t usbWr = Streaming_WriteWithRetry(
-                    Streaming_UsbWrite, buffer, packetSize);
+                    Streaming_UsbWrite, out, packetSize);
                 if (usbWr == STREAM_WRITE_RETURN_TIMEOUT) {
                     bool pastGrace = Streaming_PastStartupGrace();
                     taskENTER_CRITICAL();
@@ -3050,13 +4050,17 @@ void streaming_Task(void) {
                     }
                     gQuesBits |= QUES_BIT_USB_OVERFLOW;
                     taskEXIT_CRITICAL();
+                    // A dropped packet breaks the PB delta chain for this
+                    // consumer: resync it with a keyframe. Same at every drop
+                    // site below.
+                    Nanopb_StreamingDeltaForceKeyframe();
                     LOG_E_SESSION(LOG_SESSION_USB_DROP, "Streaming: USB interface dead (10s timeout)");
                 }
                 // else: usbWr == packetSize (success) or STOPPED (stop-abort).
             } else if (pRunTimeStreamConf->ActiveInterface == StreamingInterface_UsbAndSd) {
                 // Multi-output: keep per-output all-or-nothing drop (unchanged —
                 // SD path below already backpressures via WriteWithRetry).
-                if (Streaming_UsbWrite((const char*)buffer, packetSize) != packetSize) {
+                if (Streaming_UsbWrite((const char*)out, packetSize) != packetSize) {
                     bool pastGrace = Streaming_PastStartupGrace();
                     // CLAUDE.md atomicity: 32-bit RMW (+=) is not atomic.
                     // Single critical section covers both counter bumps so
@@ -3069,6 +4073,7 @@ void streaming_Task(void) {
                     }
                     gQuesBits |= QUES_BIT_USB_OVERFLOW;
                     taskEXIT_CRITICAL();
+                    Nanopb_StreamingDeltaForceKeyframe();
                     LOG_E_SESSION(LOG_SESSION_USB_DROP, "Streaming: USB buffer overflow detected");
                 }
             }
@@ -3079,13 +4084,13 @@ void streaming_Task(void) {
             // wifiDroppedBytes=0.  Now we call WriteBuffer unconditionally when
             // WiFi is the active interface; WriteBuffer's pre-check returns 0
             // on no-space, and we count that as a drop.
-            if (pRunTimeStreamConf->ActiveInterface == StreamingInterface_WiFi) {
+            if (StreamingInterface_IsWiFi(pRunTimeStreamConf->ActiveInterface)) {
                 if (packetSize >= 4) {
                     LOG_E_SESSION(LOG_SESSION_PACKETSIZE,
                         "diag367: encoder packetSize=%u first4=0x%02x%02x%02x%02x",
                         (unsigned)packetSize,
-                        (unsigned)buffer[0], (unsigned)buffer[1],
-                        (unsigned)buffer[2], (unsigned)buffer[3]);
+                        (unsigned)out[0], (unsigned)out[1],
+                        (unsigned)out[2], (unsigned)out[3]);
                 } else {
                     LOG_E_SESSION(LOG_SESSION_PACKETSIZE,
                         "diag367: encoder packetSize=%u (<4 bytes)",
@@ -3104,8 +4109,18 @@ void streaming_Task(void) {
                 // stream forever.  WriteWithRetry also aborts (STOPPED) if
                 // streaming was stopped mid-retry, so STR:START quiescence isn't
                 // blocked.
-                size_t wifiWr = Streaming_WriteWithRetry(
-                    wifi_manager_WriteToBuffer, buffer, packetSize);
+                size_t wifiWr;
+                if (direct == STREAM_DIRECT_WIFI) {
+                    wifiWr = packetSize;
+                } else if (pRunTimeStreamConf->ActiveInterface == StreamingInterface_WiFiUdp) {
+                    // Every datagram of the batch carries its first timestamp.
+                    StreamingBatchSpan batchSpan;
+                    Streaming_EncodeBatchSpan(&batchSpan);
+                    wifi_udp_stream_StageBatch(batchSpan.firstTs);
+                    wifiWr = Streaming_WriteWithRetry(wifi_udp_stream_Write, out, packetSize);
+                } else {
+                    wifiWr = Streaming_WriteWithRetry(wifi_manager_WriteToBuffer, out, packetSize);
+                }
                 if (wifiWr == STREAM_WRITE_RETURN_TIMEOUT) {
                     bool pastGrace = Streaming_PastStartupGrace();
                     taskENTER_CRITICAL();
@@ -3115,12 +4130,17 @@ void streaming_Task(void) {
                     }
                     gQuesBits |= QUES_BIT_WIFI_OVERFLOW;
                     taskEXIT_CRITICAL();
+                    Nanopb_StreamingDeltaForceKeyframe();
                     LOG_E_SESSION(LOG_SESSION_WIFI_DROP, "Streaming: WiFi interface dead (10s timeout)");
                 }
                 // else: wifiWr == packetSize (success) or
                 //       STREAM_WRITE_RETURN_STOPPED (stop-abort, no bookkeeping).
             }
-            if (hasSD && gSdFileWasReady) {
+            if (direct == STREAM_DIRECT_SD) {
+                // Encoded into the SD ring: committed above, or below once
+                // USB has copied it out.
+            } else if (hasSD && gSdFileWasReady) {
+                Streaming_StageSdMark(SDLOG_BLOCK_DATA);
                 if (pRunTimeStreamConf->ActiveInterface != StreamingInterface_SD) {
                     /* #534: multi-output — a stalled SD must never block the
                      * (healthy) USB path through this shared encoder loop.
@@ -3140,7 +4160,7 @@ void streaming_Task(void) {
                      * drop+count, mirroring the USB side of this branch.
                      * Solo-SD keeps the blocking backpressure below
                      * (#520: pool absorbs the burst; single drop point). */
-                    if (sd_card_manager_WriteToBuffer((const char*)buffer,
+                    if (sd_card_manager_WriteToBuffer((const char*)out,
                                                       packetSize) != packetSize) {
                         /* Skip the bookkeeping when streaming was stopped
                          * mid-iteration — mirrors WriteWithRetry's STOPPED
@@ -3149,17 +4169,19 @@ void streaming_Task(void) {
                          * fault and must not pollute the session stats. */
                         if (pRunTimeStreamConf->IsEnabled) {
                             Streaming_CountSdDrop(packetSize);
+                            Nanopb_StreamingDeltaForceKeyframe();
                             LOG_E_SESSION(LOG_SESSION_SD_DROP,
                                 "Streaming: SD buffer overflow (multi-output no-retry)");
                         }
                     }
                 } else {
                     size_t wr = Streaming_WriteWithRetry(
-                        sd_card_manager_WriteToBuffer, buffer, packetSize);
+                        sd_card_manager_WriteToBuffer, out, packetSize);
                     if (wr == STREAM_WRITE_RETURN_TIMEOUT) {
                         /* True 10 s interface-dead timeout (pass-5 Qodo
                          * refinement): bump drop counters + QUES bit + log. */
                         Streaming_CountSdDrop(packetSize);
+                        Nanopb_StreamingDeltaForceKeyframe();
                         LOG_E_SESSION(LOG_SESSION_SD_DROP, "Streaming: SD interface dead (10s timeout)");
                     }
                     /* else: wr == packetSize (success) or
@@ -3184,8 +4206,9 @@ void streaming_Task(void) {
                     pRunTimeStreamConf->ActiveInterface == StreamingInterface_SD ||
                     pRunTimeStreamConf->ActiveInterface == StreamingInterface_UsbAndSd ||
                     (gSdExpectedThisSession &&
-                     pRunTimeStreamConf->ActiveInterface != StreamingInterface_WiFi));
-                bool sdWritten = hasSD && gSdFileWasReady;
+                     !StreamingInterface_IsWiFi(pRunTimeStreamConf->ActiveInterface)));
+                bool sdWritten = (direct == STREAM_DIRECT_SD) ||
+                                 (hasSD && gSdFileWasReady);
 
                 if (sdExpected && !sdWritten) {
                     // Gate on IsEnabled, mirroring the #484 encoder-failure
@@ -3195,12 +4218,16 @@ void streaming_Task(void) {
                     // operator should see counted (Qodo #536).
                     if (pRunTimeStreamConf->IsEnabled) {
                         Streaming_CountSdDrop(packetSize);
+                        Nanopb_StreamingDeltaForceKeyframe();
                         LOG_E_SESSION(LOG_SESSION_SD_DROP, "Streaming: SD output skipped (buffer full or file not ready)");
                     }
                 }
             }
             DioProbe_PulseEnd(9);
         }
+        if (direct != STREAM_DIRECT_NONE && directShared) {
+            Streaming_DirectCommit(direct, packetSize);
+        }
         DIO_TIMING_TEST_WRITE_STATE(0);
 
 iter_done:
@@ -3217,6 +4244,9 @@ iter_done:
          * on the exit side. */
         __asm__ __volatile__ ("" ::: "memory");
         gStreamingTaskInCritical = 0;
+        if (stopFlush) {
+            gStopFlushPending = 0;      // Streaming_FlushHeldSamples waits on this
+        }
     }
 }
 
@@ -3401,6 +4431,6 @@ bool Streaming_IsActiveOnWifiInterface(void) {
         (const volatile StreamingRuntimeConfig*)gpRuntimeConfigStream;
     if (cfg == NULL) return false;
     if (!cfg->IsEnabled) return false;
-    return (cfg->ActiveInterface == StreamingInterface_WiFi);
+    return StreamingInterface_IsWiFi(cfg->ActiveInterface);
 }
 
@@ -268,6 +268,14 @@ static inline bool Streaming_EncodingIsCsv(StreamingEncoding e)
     return (e == Streaming_Csv) || (e == Streaming_CsvCompact);
 }
 
+/* Both protobuf encodings share the per-sample PB cap coefficients (the
+ * additive ADC/SD models are per-tick costs, not byte costs); the block
+ * encoding's byte saving is applied on top in Streaming_TransportMaxFreq. */
+static inline bool Streaming_EncodingIsPb(StreamingEncoding e)
+{
+    return (e == Streaming_ProtoBuffer) || (e == Streaming_ProtoBufferBlock);
+}
+
 static inline uint32_t Streaming_TransportMaxFreq(StreamingInterface interface,
                                                   StreamingEncoding encoding,
                                                   uint32_t totalChannels,
@@ -281,8 +289,10 @@ static inline uint32_t Streaming_TransportMaxFreq(StreamingInterface interface,
      * blanket x0.5 placeholder at the bottom is skipped for that interface
      * only. Interfaces still uncharacterised keep the derate. */
     uint32_t jsonFitted = 0u;
+    uint32_t block = 0u;
     switch (encoding) {
         case Streaming_ProtoBuffer: pb = 1u; break;
+        case Streaming_ProtoBufferBlock: pb = 1u; block = 1u; break;
         case Streaming_Csv:         pb = 0u; break;
         /* #619: compact CSV emits strictly FEWER bytes per row than CSV, so the
          * CSV coefficients are a conservative (never-over) bound for it. Note
@@ -368,6 +378,24 @@ static inline uint32_t Streaming_TransportMaxFreq(StreamingInterface interface,
                 else                { single = 15000u; A = 34000u; B = 1u; }
             }
             break;
+        case StreamingInterface_WiFiUdp:
+            /* PROVISIONAL -- no UDP soak basis yet. The TCP fit below x3/2,
+             * the headroom SYST:STR:ADAPTive already grants TCP on a night
+             * that can carry it. Derived from the send path, not measured:
+             * wifi_udp_stream keeps WIFI_UDP_STREAM_MAX_IN_FLIGHT (2)
+             * sendto()s of <= 1400 B, and each completes when the WINC takes
+             * the datagram -- no host ACK clocks it, so the TCP fit's
+             * worst-night stalls (retransmits, a closed window) cannot occur;
+             * what remains is the same radio and the same SPI transfer.
+             * An over-cap here is not silent either: a datagram the radio
+             * cannot take is a sequence gap the receiver counts.
+             *   PB : single 8000/5175 -> 12000/7762, A 139000 -> 208500
+             *   CSV: single 4675 -> 7012, A 20000 -> 30000, low-n 4575
+             * The adaptive raise is not applied on top (streaming.c). Replace
+             * with a walk-down fit once soaked, as for TCP. */
+            if (pb) { single = isNQ1 ? 12000u : 7762u; A = 208500u; B = 30u; }
+            else    { single =  7012u; A =  30000u; B =  2u; }
+            break;
         case StreamingInterface_WiFi:
             /* Refit 2026-06-11 (take-5 walk-down soaks, T2-only,
              * atcap_20260611_045901.csv) — the first endurance basis with
@@ -461,9 +489,12 @@ static inline uint32_t Streaming_TransportMaxFreq(StreamingInterface interface,
          * validated AT CAP for n>=5 but over-caps n=2..4 — the measured
          * 3-ch soak ceiling is 3050 while the curve gives 4000.  Clamp
          * multi-channel WiFi CSV to that measured ceiling; transparent
-         * for n>=5 where the curve is already below it. */
+         * for n>=5 where the curve is already below it. UDP's provisional
+         * fit carries the same clamp x3/2. */
         if (interface == StreamingInterface_WiFi && !pb && hz > 3050u) {
             hz = 3050u;
+        } else if (interface == StreamingInterface_WiFiUdp && !pb && hz > 4575u) {
+            hz = 4575u;
         }
     }
     /* JSON emits ~2-3x CSV bytes/sample (object braces + per-sample field names),
@@ -482,6 +513,22 @@ static inline uint32_t Streaming_TransportMaxFreq(StreamingInterface interface,
      * supplies its own coefficients above and sets jsonFitted, so halving
      * there would re-apply a derate that the measurement already replaced. */
     if (json && !jsonFitted) hz /= 2u;
+    /* PB block: not yet characterized on hardware, so the PB caps above are
+     * scaled by the wire-byte ratio -- derived from the two layouts, NOT
+     * measured. Per tick, per-sample PB costs >= 7 + w*n bytes (length
+     * prefix, ts tag + a varint of >= 3 bytes, packed tag + length); a block
+     * costs <= w*n + 2 amortized (its ~38-byte header over >= 12 ticks). w is
+     * the widest per-value varint: 2 bytes for NQ1's 12-bit codes, 4 for
+     * NQ2/NQ3 (24-bit AD7173 worst case, so NQ3's 18-bit codes are covered
+     * too). Only the transport (byte) term scales: the additive ADC/SD models
+     * and STREAMING_ISR_MAX_HZ are per-tick costs the block format doesn't
+     * touch, and still bind via min() in ComputeMaxFreqForConfig. */
+    if (block) {
+        uint64_t w = isNQ1 ? 2u : 4u;
+        uint64_t wn = w * (uint64_t)totalChannels;
+        uint64_t scaled = ((uint64_t)hz * (7u + wn)) / (2u + wn);
+        hz = (scaled > STREAMING_ISR_MAX_HZ) ? STREAMING_ISR_MAX_HZ : (uint32_t)scaled;
+    }
     return (hz == 0u) ? 1u : hz;
 }
 
@@ -576,6 +623,9 @@ void Streaming_ReportSdDiscard(size_t bytes);
 // streaming_profile.h so consumers (UsbCdc.c) can pull in only that
 // header instead of all of streaming.h's transitive includes.
 #include "streaming_profile.h"
+// USB+SD fan-out hooks (Streaming_FanoutDrainUsb / _Detach), split out the
+// same way for UsbCdc.c.
+#include "streaming_fanout.h"
 
 // Streaming loss/throughput statistics, accumulated per session.
 // 32-bit fields are atomic on PIC32MZ; 64-bit fields require critical sections.
@@ -585,8 +635,10 @@ typedef struct {
     // #499 split — two distinct mechanisms previously combined in queueDroppedSamples:
     //   poolExhaustedSamples: AInSampleList_AllocateFromPool() returned NULL
     //                         (no free slot — pool depth too shallow for rate)
-    //   queueOverflowSamples: AInSampleList_PushBack() failed
-    //                         (FreeRTOS queue full — streaming_Task not draining fast enough)
+    //   queueOverflowSamples: AInSampleList_PushBack() failed. The pool and the
+    //                         queue are one slot ring, so a slow streaming_Task
+    //                         now shows up as poolExhaustedSamples; this stays
+    //                         0 unless a publish is rejected (ring re-init race)
     // Sum equals queueDroppedSamples (kept for backward compat with existing parsers).
     uint32_t poolExhaustedSamples;
     uint32_t queueOverflowSamples;
@@ -701,6 +753,18 @@ typedef struct {
     // #367 diagnostics — populated at Streaming_Stop() to reconcile the
     // accounting gap (TotalBytesStreamed vs WifiTcpBytesSent at saturation).
     uint32_t circularBufferEndBytes; // Bytes still in WiFi circular buffer at Stop
+    // SYST:STR:ADAPTive / SYST:STR:DECimate: timer ticks skipped by the rate
+    // controller or folded into a decimation window on purpose.
+    // Neither a sample nor a drop, so the #265 invariant reads
+    //   TimerISRCalls == TotalSamplesStreamed + QueueDroppedSamples + DecimatedTicks
+    // and is unchanged while both are off (always 0). 64-bit for the
+    // same reason timerISRCalls is. It does NOT hold in a SYST:STR:CAPture
+    // session, whose ticks fill a ring that is read out later:
+    // TotalSamplesStreamed counts the frames read out, nothing else.
+    uint64_t decimatedTicks;
+    uint32_t rateDivisor;            // live: every rateDivisor-th tick is a sample (1 = all)
+    uint32_t rateDecreases;          // controller steps down (divisor doubled)
+    uint32_t rateIncreases;          // controller steps up (divisor - 1)
 #if PB_PROFILE_COUNTERS
     // #388 PB streaming bottleneck instrumentation.  All cycle fields are
     // raw `_CP0_GET_COUNT()` differences (SYSCLK/2 = 100 MHz on PIC32MZ).
@@ -868,6 +932,45 @@ void Streaming_RestoreRateConfigured(bool configured);
 uint32_t Streaming_TimestampTicksPerSample(uint32_t clockPeriod);
 uint32_t Streaming_ActualRateMilliHz(uint32_t clockPeriod);
 
+// SYST:STR:ADAPTive: how far above the static WiFi transport cap (Streaming_
+// TransportMaxFreq) the configured rate may go when adaptive mode is on. The
+// rate controller decimates from there when the link cannot carry it.
+#define STREAMING_ADAPTIVE_CAP_NUM  3u
+#define STREAMING_ADAPTIVE_CAP_DEN  2u
+
+// Rate-change stamps for adaptive mode, encoder side (streaming_Task only).
+// Streaming_RateStampDue: true, once per change, when the message about to be
+//   encoded starts with the sample set stamped @p ts and that set is the first
+//   at a new decimation divisor. The encoder then emits a metadata message
+//   ahead of it, and reports with Streaming_RateStampDone whether it did.
+// Streaming_RateStampDone: @p written -- the stamp is in the batch; the change
+//   is stamped. Otherwise the divisor is put back and the next
+//   Streaming_RateStampDue offers the same change again.
+// Streaming_RateStampDivisor: the divisor of the last stamp taken, times the
+//   SYST:STR:DECimate factor (1 outside an adaptive or decimated session). Nanopb_Encode scales timestamp_ticks_per_sample and
+//   actual_rate_millihz by it, so the stamp reports the rate actually emitted.
+bool Streaming_RateStampDue(uint32_t ts);
+void Streaming_RateStampDone(bool written);
+uint32_t Streaming_RateStampDivisor(void);
+
+// SYST:STR:DECimate extra bits: streamed ADC codes are the converter's codes
+// times 2^Streaming_CodeScaleBits() -- the running session's, or while idle
+// what the next START would apply. Nanopb_Encode reports analog_in_res scaled
+// by it (INFO, SD PB header), and SD container blocks record it (trailer +26).
+uint32_t Streaming_CodeScaleBits(void);
+
+// SYST:STR:CAPture (Util/CaptureRing.h), SCPI side.
+// Streaming_CaptureForce: trigger the running capture on its next tick,
+//   whatever its sources (still subject to the pre window being full).
+// Streaming_GetCaptureStatus: the current or last capture -- its
+//   CaptureState, frames still to be read out (DONE only), the trigger
+//   frame's stamp (0 before a trigger) and the triggers ignored while the
+//   pre window was filling. Lock-free 32-bit reads; the deferred task is the
+//   only writer.
+void Streaming_CaptureForce(void);
+void Streaming_GetCaptureStatus(uint32_t* state, uint32_t* framesLeft,
+                                uint32_t* triggerTs, uint32_t* ignored);
+
 // Test pattern streaming mode.
 // 0=off (real ADC data), 1=counter, 2=midscale, 3=fullscale, 4=walking,
 // 5=triangle, 6=sine. Runtime-only (not persisted to NVM).
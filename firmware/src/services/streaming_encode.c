@@ -0,0 +1,195 @@
+/*! @file streaming_encode.c
+ *  @brief Batch encode step of streaming_Task. See streaming_encode.h.
+ */
+
+#include "streaming_encode.h"
+#include "streaming.h"
+#include "streaming_profile.h"
+
+#include "HAL/DIO.h"
+#include "HAL/DioProbe.h"
+#include "JSON_Encoder.h"
+#include "csv_encoder.h"
+#include "DaqifiPB/DaqifiOutMessage.pb.h"
+#include "DaqifiPB/NanoPB_Encoder.h"
+
+#if PB_PROFILE_COUNTERS
+#include <xc.h>  // for _CP0_GET_COUNT() — coprocessor 0 cycle counter
+#endif
+
+_Static_assert(STREAMING_PB_BLOCK_MAX_BYTES <= STREAMING_BATCH_MIN_ROOM,
+               "a PB block must fit the batch's worst-case message room");
+
+// Sample sets a PB block session lets queue before encoding; see
+// Streaming_EncodeSetBlockHold. Written by Streaming_Start before the timer
+// runs and released by Streaming_Stop (one aligned 32-bit store), read by
+// streaming_Task only.
+static volatile uint32_t gBlockHold = 1u;
+
+// What the last batch encoded; see Streaming_EncodeBatchSpan.
+static StreamingBatchSpan gBatchSpan;
+
+// SYST:STR:ADAPTive rate stamp: the timebase of the samples that follow it.
+static const NanopbFlagsArray gRateStampFields = {
+    .Size = 2,
+    .Data = {
+        DaqifiOutMessage_timestamp_ticks_per_sample_tag,
+        DaqifiOutMessage_actual_rate_millihz_tag,
+    }
+};
+
+void Streaming_EncodeSetBlockHold(uint32_t rateMilliHz, uint32_t channelCount) {
+    uint32_t hold = rateMilliHz / 100000u;          // 10 ms of ticks
+    size_t blockMax = Nanopb_StreamingBlockMaxSamples(channelCount,
+                                                      STREAMING_PB_BLOCK_MAX_BYTES);
+    if (hold > blockMax) hold = (uint32_t)blockMax;
+    if (hold < 1u) hold = 1u;
+    gBlockHold = hold;
+}
+
+void Streaming_EncodeReleaseBlockHold(void) {
+    gBlockHold = 1u;
+}
+
+size_t Streaming_EncodeBatch(tBoardData* pBoardData,
+                             StreamingEncoding encoding,
+                             uint8_t* pBuffer, size_t bufferSize,
+                             size_t xportFree,
+                             bool* pEncoderFailed) {
+    NanopbFlagsArray nanopbFlag;
+    size_t packetSize = 0;
+
+    *pEncoderFailed = false;
+    gBatchSpan.samples = 0u;
+
+    for (uint32_t batchIdx = 0; batchIdx < STREAMING_BATCH_MAX; batchIdx++) {
+        bool ainNow = !AInSampleList_IsEmpty();
+        bool dioNow = !DIOSampleList_IsEmpty(&pBoardData->DIOSamples);
+        if (!ainNow && !dioNow) {
+            break;                       // queue drained — normal batch end
+        }
+        // PB block: wait for a block's worth of ticks. Capped at half the
+        // live pool so a small pool still drains long before it can exhaust.
+        // DIO with no AIN queued is never held.
+        if (encoding == Streaming_ProtoBufferBlock && ainNow) {
+            size_t hold = AInSampleList_PoolCapacity() / 2u;
+            if (hold > gBlockHold) hold = gBlockHold;
+            if (AInSampleList_Size() < hold) {
+                break;
+            }
+        }
+        // First message always encoded (drain the queue); additional
+        // messages must keep MIN_ROOM within the encoder buffer AND the
+        // smallest active transport ring, so the single all-or-nothing write
+        // below always fits its ring. Addition (not subtraction) avoids
+        // size_t underflow when a transport ring is momentarily full (free=0).
+        if (batchIdx > 0) {
+            if ((bufferSize - packetSize) < STREAMING_BATCH_MIN_ROOM) {
+                break;                   // no encoder-buffer room
+            }
+            if ((packetSize + STREAMING_BATCH_MIN_ROOM) > xportFree) {
+                break;                   // would overflow the smallest active ring
+            }
+        }
+
+        nanopbFlag.Size = 0;
+        nanopbFlag.Data[nanopbFlag.Size++] = DaqifiOutMessage_msg_time_stamp_tag;
+        if (ainNow) {
+            nanopbFlag.Data[nanopbFlag.Size++] = DaqifiOutMessage_analog_in_data_tag;
+        }
+        if (dioNow) {
+            nanopbFlag.Data[nanopbFlag.Size++] = DaqifiOutMessage_digital_data_tag;
+            nanopbFlag.Data[nanopbFlag.Size++] = DaqifiOutMessage_digital_port_dir_tag;
+        }
+
+        // Timestamp of the set this message starts with, before it is popped.
+        uint32_t msgTs = 0u;
+        AInPublicSampleList_t* pAinFront;
+        DIOSample dioFront;
+        if (ainNow && AInSampleList_PeekFront(&pAinFront)) {
+            msgTs = pAinFront->Timestamp;
+        } else if (DIOSampleList_PeekFront(&pBoardData->DIOSamples, &dioFront)) {
+            msgTs = dioFront.Timestamp;
+        }
+        // Adaptive rate: the first message at a new decimation divisor is
+        // preceded by a stamp of the rate it runs at. It takes a pass of its
+        // own, and needs room for itself AND that message on every pass --
+        // the first one is exempt from the checks above only for a message.
+        // A stamp that does not fit ends the batch; it is still due, so it
+        // leads the next one. CSV/JSON rows carry their own timestamps and
+        // get no stamp.
+        if (Streaming_EncodingIsPb(encoding) && msgTs != 0u &&
+            Streaming_RateStampDue(msgTs)) {
+            size_t stamp = 0;
+            if ((bufferSize - packetSize) >= STREAMING_BATCH_FIRST_ROOM &&
+                (packetSize + STREAMING_BATCH_FIRST_ROOM) <= xportFree) {
+                stamp = Nanopb_Encode(pBoardData, &gRateStampFields,
+                                      pBuffer + packetSize,
+                                      bufferSize - packetSize);
+            }
+            Streaming_RateStampDone(stamp > 0u);
+            if (stamp == 0u) {
+                break;
+            }
+            packetSize += stamp;
+            continue;
+        }
+        uint32_t poppedBefore = AInSampleList_PopCount();
+
+        uint8_t *encPtr = pBuffer + packetSize;
+        size_t encRoom = bufferSize - packetSize;
+        size_t encoded = 0;
+        DioProbe_PulseStart(8);  /* probe 8: encode duration */
+        if (Streaming_EncodingIsCsv(encoding)) {
+            DIO_TIMING_TEST_WRITE_STATE(1);
+            encoded = csv_Encode(pBoardData, &nanopbFlag, encPtr, encRoom);
+            DIO_TIMING_TEST_WRITE_STATE(0);
+        } else if (encoding == Streaming_Json) {
+            DIO_TIMING_TEST_WRITE_STATE(1);
+            encoded = Json_Encode(pBoardData, &nanopbFlag, encPtr, encRoom);
+            DIO_TIMING_TEST_WRITE_STATE(0);
+        } else if (encoding == Streaming_ProtoBufferBlock) {
+            DIO_TIMING_TEST_WRITE_STATE(1);
+            encoded = Nanopb_EncodeStreamingBlock(pBoardData, &nanopbFlag, encPtr, encRoom);
+            DIO_TIMING_TEST_WRITE_STATE(0);
+        } else {
+            DIO_TIMING_TEST_WRITE_STATE(1);
+#if PB_PROFILE_COUNTERS
+            uint32_t pbStart = _CP0_GET_COUNT();
+            encoded = Nanopb_EncodeStreamingFast(pBoardData, &nanopbFlag, encPtr, encRoom);
+            Streaming_AddProfileSample_PbEncode(_CP0_GET_COUNT() - pbStart,
+                                                (uint32_t)encoded);
+#else
+            encoded = Nanopb_EncodeStreamingFast(pBoardData, &nanopbFlag, encPtr, encRoom);
+#endif
+            DIO_TIMING_TEST_WRITE_STATE(0);
+        }
+        DioProbe_PulseEnd(8);
+
+        if (encoded == 0) {
+            // The queue was non-empty (checked above) with guaranteed room,
+            // yet the encoder produced nothing → a real encoder failure OR
+            // the #484 shutdown race (Streaming_Stop ran mid-iteration and
+            // the encoder saw partially torn-down state — verified empirically
+            // to fire at Stop, not mid-stream). Each encode pops exactly one
+            // sample (#297); the caller accounts it and the batch stops here.
+            *pEncoderFailed = true;
+            break;
+        }
+        packetSize += encoded;
+
+        if (gBatchSpan.samples == 0u) {     // a rate stamp may come first
+            gBatchSpan.firstTs = msgTs;
+        }
+        gBatchSpan.lastTs = msgTs;
+        // AIN sets consumed; a DIO-only message is one set of its own.
+        uint32_t popped = AInSampleList_PopCount() - poppedBefore;
+        gBatchSpan.samples += (popped > 0u) ? popped : 1u;
+    }
+
+    return packetSize;
+}
+
+void Streaming_EncodeBatchSpan(StreamingBatchSpan* pSpan) {
+    *pSpan = gBatchSpan;
+}
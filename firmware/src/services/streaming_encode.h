@@ -0,0 +1,113 @@
+/*! @file streaming_encode.h
+ *  @brief Batch encode step of streaming_Task (#662), split out for host runs.
+ *
+ *  The encode half of the streaming task -- pop up to STREAMING_BATCH_MAX
+ *  sample sets, run the session's encoder on each, concatenate the framed
+ *  messages into the encoder buffer -- lives in its own translation unit so
+ *  that tests/host can link it against the real encoders, the real sample
+ *  pool and a synthetic tick source (tests/host/sim_pipeline.c). Everything
+ *  around it (transport writes, drop accounting, QUES bits, the #486
+ *  quiescence flag) stays in streaming.c, which is the only firmware caller.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../state/data/BoardData.h"
+#include "../state/runtime/StreamingRuntimeConfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// #662 batch-pop: per encoder wake, encode up to STREAMING_BATCH_MAX samples
+// back-to-back into one buffer, then a SINGLE output write of the concatenated
+// framed messages. Amortizes the per-wake output-write + size-query overhead
+// across N samples. Each encoder call pops one sample and emits a self-framed
+// unit (PB length-delimited / CSV row / JSON object), so concatenating N is
+// byte-identical to N separate writes — invisible to clients (no wire-format
+// change). Bounded so a backlog can't monopolize the encoder or delay the
+// output write beyond N samples' worth. STREAMING_BATCH_MIN_ROOM is a
+// conservative worst-case single-message size: the batch stops before an
+// encode that isn't guaranteed to fit, so a 0 encoder return unambiguously
+// means empty-queue/failure rather than truncation.
+#define STREAMING_BATCH_MAX      8u
+#define STREAMING_BATCH_MIN_ROOM 1024u
+// A batch may open with a SYST:STR:ADAPTive rate stamp (two uint32 fields,
+// 15 B framed) ahead of its first message; both have to fit, so that is the
+// room a batch needs before it starts.
+#define STREAMING_RATE_STAMP_ROOM   32u
+#define STREAMING_BATCH_FIRST_ROOM  (STREAMING_BATCH_MIN_ROOM + STREAMING_RATE_STAMP_ROOM)
+
+/** What the last Streaming_EncodeBatch() call encoded (for SD container
+ *  block trailers). Timestamps are raw TS-timer ticks. */
+typedef struct {
+    uint32_t firstTs;   ///< first sample set of the batch
+    uint32_t lastTs;    ///< first sample set of the batch's last message
+    uint32_t samples;   ///< sample sets consumed (0 = nothing encoded)
+} StreamingBatchSpan;
+
+/**
+ * @brief Set how many sample sets PB block encoding waits for (per session).
+ *
+ * Streaming_ProtoBufferBlock only earns its byte savings when a block holds
+ * many ticks, and with the encoder woken every tick the queue is usually one
+ * deep. So a block session lets samples accumulate until about 10 ms of them
+ * are queued -- never more than one block can carry for @p channelCount
+ * channels, and never more than half the sample pool, so the hold can't be
+ * what exhausts it. Other encodings ignore the setting.
+ *
+ * Called from Streaming_Start; Streaming_EncodeReleaseBlockHold undoes it.
+ *
+ * @param rateMilliHz  Actual streaming rate (Streaming_ActualRateMilliHz)
+ * @param channelCount Enabled public AIN channels
+ */
+void Streaming_EncodeSetBlockHold(uint32_t rateMilliHz, uint32_t channelCount);
+
+/**
+ * @brief Encode whatever is queued, however few sample sets (hold of 1).
+ *
+ * Called from Streaming_Stop before its final encode pass, so the sets a
+ * block session was still holding reach the outputs instead of the drain.
+ */
+void Streaming_EncodeReleaseBlockHold(void);
+
+/**
+ * @brief Encode one batch of queued sample sets into the encoder buffer.
+ *
+ * The FIRST message is always encoded (drain the queue; one framed message
+ * fits any legal ring). A rate stamp goes ahead of a message only while
+ * STREAMING_BATCH_FIRST_ROOM is left, on the first pass too; otherwise the
+ * batch ends and the stamp leads the next one. ADDITIONAL messages are added only while the batch
+ * keeps STREAMING_BATCH_MIN_ROOM within both the encoder buffer and
+ * @p xportFree, so the caller's single all-or-nothing transport write always
+ * fits its ring (#686).
+ *
+ * @param pBoardData     Board data (DIO sample list, stream trigger stamp)
+ * @param encoding       Session encoding (PB / PB block / JSON / CSV / CSV compact)
+ * @param pBuffer        Encoder buffer
+ * @param bufferSize     Encoder buffer size
+ * @param xportFree      Free bytes in the smallest active transport ring
+ * @param pEncoderFailed [out] true if an encoder returned 0 with data queued
+ *                       (one sample lost, #297) -- the caller accounts it
+ * @return Bytes of framed messages written to pBuffer (0 = nothing queued,
+ *         a PB block session still below its hold, or the first encode failed)
+ */
+size_t Streaming_EncodeBatch(tBoardData* pBoardData,
+                             StreamingEncoding encoding,
+                             uint8_t* pBuffer, size_t bufferSize,
+                             size_t xportFree,
+                             bool* pEncoderFailed);
+
+/**
+ * @brief Span of the last Streaming_EncodeBatch() result.
+ *
+ * Valid until the next call; streaming_Task only.
+ */
+void Streaming_EncodeBatchSpan(StreamingBatchSpan* pSpan);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,64 @@
+/*! @file streaming_fanout.h
+ *  @brief USB+SD and WiFi TCP fan-out: the shared encoded-block queue's transport hooks.
+ *
+ *  With USB and SD both streaming, each batch is encoded once into a shared
+ *  block queue (Util/SharedBlockQueue.h) instead of being written into both
+ *  transport rings. The streaming task feeds SD from it; the USB task reads
+ *  its own cursor straight into the DMA buffer. WiFi TCP sessions share the
+ *  queue the same way between the server's clients (Util/TcpFanout.h).
+ *  Isolated from streaming.h so that UsbCdc.c and wifi_tcp_server.c can
+ *  include it without the StreamingStats / BoardData / HAL dependency tree,
+ *  like streaming_profile.h.
+ */
+#ifndef STREAMING_FANOUT_H
+#define STREAMING_FANOUT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "Util/TcpFanout.h"
+
+/**
+ * Hands the USB cursor's next whole blocks (at most @p maxLen bytes) to
+ * @p write -- UsbCdc_Wrapper_Write -- and advances the cursor by what it
+ * accepted. Called by UsbCdc_BeginWrite when its own ring (SCPI replies) is
+ * empty, so replies keep priority over the stream.
+ *
+ * @return @p write's result, or 0 when fan-out is off or nothing is pending
+ */
+int Streaming_FanoutDrainUsb(uint32_t maxLen, int (*write)(uint8_t*, uint32_t));
+
+/**
+ * Stops fan-out and forgets the queue. Must run before the streaming pool is
+ * re-partitioned: the queue's arena is the encoder region, and the USB task
+ * would otherwise keep reading it while it is being re-carved.
+ */
+void Streaming_FanoutDetach(void);
+
+/**
+ * Hands WiFi TCP client @p client's pending blocks to @p send until it stops
+ * taking them (TcpFanout_Drain). A run shorter than @p minLen is held back.
+ *
+ * @return bytes taken, negative on a send error, 0 when fan-out is off
+ */
+int32_t Streaming_FanoutDrainWifi(uint8_t client, uint32_t minLen, TcpFanoutSend send);
+
+/** WiFi TCP client @p client connected: it reads from the next batch, which is
+ *  encoded as a keyframe. No-op outside a WiFi fan-out session. */
+void Streaming_FanoutAttachWifi(uint8_t client);
+
+/** WiFi TCP client @p client is going away: its backlog is released. Call
+ *  before the socket is shut, once no new send can start on it. */
+void Streaming_FanoutDetachWifi(uint8_t client);
+
+/** True when tap @p client has had data waiting and sent none of it for more
+ *  than @p limitTicks (TcpFanout_Stalled). */
+bool Streaming_FanoutWifiStalled(uint8_t client, uint32_t limitTicks);
+
+/**
+ * Copy WiFi TCP client @p client's counters and the bytes it still has queued.
+ * @return true if the client is attached to a running fan-out
+ */
+bool Streaming_FanoutGetWifiClient(uint8_t client, TcpFanoutClient_t* out,
+                                   uint32_t* pPending);
+
+#endif /* STREAMING_FANOUT_H */
@@ -18,6 +18,10 @@
 
 #if PB_PROFILE_COUNTERS
 
+// Task-context accumulator (caller is Streaming_EncodeBatch, streaming task):
+// one Nanopb_EncodeStreamingFast call's cycles and output bytes.
+void Streaming_AddProfileSample_PbEncode(uint32_t cycles, uint32_t bytesOut);
+
 // Task-context accumulators (callers on USB task, pri 7):
 void Streaming_AddProfileSample_WriteBuf(uint32_t cycles);
 void Streaming_AddProfileSample_DmaCopy(uint32_t cycles);
@@ -12,6 +12,7 @@
 #include "wifi_serial_bridge_interface.h"
 #include "iperf2/iperf2.h"
 #include "mdns_responder.h"                    // #345 mDNS/DNS-SD responder
+#include "wifi_udp_stream.h"                   // SYST:STR:INT 4 datagram transport
 #include "state/board/BoardConfig.h"           // #345 identity: serial/variant/revs
 #include "services/daqifi_settings.h"          // #345 friendly name
 #include "driver/winc/include/drv/common/nm_common.h"  // nm_reset (canonical WINC reset pulse)
@@ -612,6 +613,20 @@ static void SocketEventCallback(SOCKET socket, uint8_t messageType, void *pMessa
         return;
     }
 
+    /* Same for the UDP stream socket: its SENDTO completions release an
+     * in-flight slot and chain the next datagram. */
+    if (wifi_udp_stream_OwnsSocket(socket)) {
+        wifi_udp_stream_HandleSocketEvent(socket, messageType, pMessage);
+        return;
+    }
+
+    /* And for the stream taps (extra clients on the listen port): their
+     * SEND completions must not unwind the console's in-flight ring. */
+    if (wifi_tcp_server_TapOwnsSocket(socket)) {
+        wifi_tcp_server_HandleTapSocketEvent(socket, messageType, pMessage);
+        return;
+    }
+
     switch (messageType) {
         case SOCKET_MSG_BIND:
         {
@@ -696,8 +711,17 @@ static void SocketEventCallback(SOCKET socket, uint8_t messageType, void *pMessa
                 // streaming task references — so a sync shutdown of
                 // it is safe (the WINC sends a RST to the new peer,
                 // no corruption of the active session).
+                //
+                // With the console taken, a free tap slot takes the
+                // connection instead: it receives the stream and nothing
+                // else (wifi_tcp_server_AcceptTap).  Only when those are
+                // taken too is it refused.
                 if (gStateMachineContext.pTcpServerContext->client.clientSocket >= 0) {
-                    LOG_I("TCP: refusing 2nd client on listen socket (one-client policy, #452)");
+                    if (wifi_tcp_server_AcceptTap(pAcceptMessage->sock)) {
+                        LOG_I("TCP: 2nd client on listen socket taken as stream tap");
+                        break;
+                    }
+                    LOG_I("TCP: refusing client on listen socket (console and taps taken, #452)");
                     gStateMachineContext.pTcpServerContext->acceptRefused++;  // #560 Opt 0: climbing = PATH-2 zombie churn
                     int8_t rc = shutdown(pAcceptMessage->sock);
                     if (rc != SOCK_ERR_NO_ERROR) {
@@ -1533,6 +1557,7 @@ static wifi_manager_stateMachineReturnStatus_t MainState(stateMachineInst_t * co
             InvalidateStaLinkState();  // #517: clear cached RSSI/IP/assocHandle
             CloseUdpSocket(&pInstance->udpServerSocket);
             mdns_responder_Stop();     // #345: leave the mDNS group + close socket
+            wifi_udp_stream_Close();   // reopened by Service once the link is back
             wifi_tcp_server_CloseSocket();
             RESET_TCP_SOCKET_OPEN(pInstance);
             ResetEventFlag(&pInstance->eventFlags, WIFI_MANAGER_STATE_FLAG_UDP_SOCKET_OPEN);
@@ -2087,6 +2112,7 @@ static wifi_manager_stateMachineReturnStatus_t MainState(stateMachineInst_t * co
             returnStatus = WIFI_MANAGER_STATE_MACHINE_RETURN_STATUS_TRAN;
             pInstance->nextState = MainState;
             mdns_responder_Stop();       // #345: full teardown — free the mDNS socket
+            wifi_udp_stream_Close();
             if (GetEventFlagStatus(pInstance->eventFlags, WIFI_MANAGER_STATE_FLAG_UDP_SOCKET_OPEN))
                 CloseUdpSocket(&pInstance->udpServerSocket);
             if (GetEventFlagStatus(pInstance->eventFlags, WIFI_MANAGER_STATE_FLAG_TCP_SOCKET_OPEN)) {
@@ -2699,6 +2725,14 @@ size_t wifi_manager_WriteToBuffer(const char* pData, size_t len) {
     return wifi_tcp_server_WriteBuffer(pData, len);
 }
 
+uint8_t* wifi_manager_ReserveWriteSpan(size_t minLen, size_t* pLen) {
+    return wifi_tcp_server_ReserveWriteSpan(minLen, pLen);
+}
+
+size_t wifi_manager_CommitWriteSpan(size_t len) {
+    return wifi_tcp_server_CommitWriteSpan(len);
+}
+
 // #382 sub-bug 1: periodically reconcile STA_CONNECTED with chip reality.
 // Fires an async RSSI probe at most once per WIFI_STA_RECONCILE_PERIOD_TICKS
 // when STA is started, an association handle is valid, but our flag says
@@ -3082,6 +3116,8 @@ static void wifi_manager_ProcessStateImpl(bool drainTcpRx) {
         ApplyPowerSavePolicy(&gStateMachineContext);
         wifi_manager_ServiceConsoleIdleTimeout();  // #663: connect-and-never-send guard
         mdns_responder_ServiceHealth();            // #58: re-open a deaf mDNS socket
+        wifi_udp_stream_Service();                 // open/close the UDP stream socket
+        wifi_tcp_server_ServiceTaps();             // disconnect stream taps that stopped reading
     }
 
     if (gProcessStateMutex != NULL) {
@@ -356,6 +356,24 @@ extern "C" {
      * @return The number of bytes successfully written.
      */
     size_t wifi_manager_WriteToBuffer(const char* data, size_t len);
+
+    /**
+     * @brief Reserves a contiguous span of the TCP write buffer to encode into.
+     *
+     * @param[in]  minLen Smallest span worth taking.
+     * @param[out] pLen   Receives the span length.
+     *
+     * @return The span (the buffer stays locked until
+     *         wifi_manager_CommitWriteSpan()), or NULL if none is available.
+     */
+    uint8_t* wifi_manager_ReserveWriteSpan(size_t minLen, size_t* pLen);
+
+    /**
+     * @brief Publishes len bytes of the reserved span and unlocks the buffer.
+     *
+     * @return The number of bytes committed (0 abandons the reservation).
+     */
+    size_t wifi_manager_CommitWriteSpan(size_t len);
     /**
      * @brief Retrieves the TCP server Context.
      * 
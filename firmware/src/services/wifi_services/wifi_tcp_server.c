@@ -4,6 +4,7 @@
 #include "services/SCPI/SCPIInterface.h"
 #include "Util/Logger.h"
 #include "Util/StreamingBufferPool.h"
+#include "services/streaming_fanout.h"
 #include "socket.h"
 
 #ifndef min
@@ -101,55 +102,108 @@ bool wifi_tcp_server_ProcessReceivedBuff(void);
  * and clears any pending data in the client's buffers.
  */
 void wifi_tcp_server_CloseClientSocket(void);
-static bool TcpServerFlush() {
-    int16_t sockRet;
-    bool funRet = false;
-    if (gpServerData->client.clientSocket < 0) {
-        LOG_D("TCP flush: no client connected");
-        return false;
-    }
-    if (gpServerData->client.writeBufferLength >WIFI_WBUFFER_SIZE) {
-        gpServerData->client.writeBufferLength = WIFI_WBUFFER_SIZE;
-    } else if (gpServerData->client.writeBufferLength == 0) {
-        return true;
-    }
 
+/* One send() on the console socket. Shared by the reply ring's flush and the
+ * stream fan-out, so the SOCKET_MSG_SEND callback unwinds both through the
+ * same in-flight ring. */
+static int16_t TcpServerSend(const uint8_t* data, uint16_t len) {
     // Non-blocking send: try once, return immediately if WINC buffer is full
     // This prevents the streaming task from blocking for multiple milliseconds
     // during high-rate streaming when WiFi bandwidth is saturated
-    sockRet = send(gpServerData->client.clientSocket, (char*) gpServerData->client.writeBuffer, gpServerData->client.writeBufferLength, 0);
+    int16_t sockRet = send(gpServerData->client.clientSocket, (void*) data, len, 0);
 
-    if (sockRet == SOCK_ERR_CONN_ABORTED) {
-        funRet = false;
-    } else if (sockRet == SOCK_ERR_NO_ERROR) {
+    if (sockRet == SOCK_ERR_NO_ERROR) {
         // Update stats, ring slot, and inflight counter atomically so
         // the SOCKET_MSG_SEND callback reads consistent values if it
         // fires immediately on the WiFi task as soon as we exit.
         taskENTER_CRITICAL();
-        gpServerData->client.inflightSizes[gpServerData->client.inflightHead] =
-            gpServerData->client.writeBufferLength;
+        gpServerData->client.inflightSizes[gpServerData->client.inflightHead] = len;
         gpServerData->client.inflightHead =
             (gpServerData->client.inflightHead + 1) % WIFI_TCP_MAX_IN_FLIGHT;
-        gpServerData->client.wifiTcpBytesSent += gpServerData->client.writeBufferLength;
+        gpServerData->client.wifiTcpBytesSent += len;
         gpServerData->client.tcpInFlight++;
         taskEXIT_CRITICAL();
-        gpServerData->client.writeBufferLength = 0;
         gpServerData->client.lastActivityTick = xTaskGetTickCount(); // #663: TX keeps a streaming client non-idle
-        funRet = true;
-    } else if (sockRet == SOCK_ERR_BUFFER_FULL) {
-        // WINC module buffer full - return false without blocking
-        // Data remains in writeBuffer and will be retried on next TransmitBufferedData call
-        funRet = false;
-    } else {
+    } else if (sockRet != SOCK_ERR_CONN_ABORTED && sockRet != SOCK_ERR_BUFFER_FULL) {
         // Other error - log for debugging
         static uint32_t errorCount = 0;
         if ((++errorCount % 100) == 0) {
-            LOG_E("TcpServerFlush: send() returned error %d (count=%u)", sockRet, (unsigned)errorCount);
+            LOG_E("TcpServerSend: send() returned error %d (count=%u)", sockRet, (unsigned)errorCount);
+        }
+    }
+    return sockRet;
+}
+
+static bool TcpServerFlush() {
+    if (gpServerData->client.clientSocket < 0) {
+        LOG_D("TCP flush: no client connected");
+        return false;
+    }
+    if (gpServerData->client.writeBufferLength >WIFI_WBUFFER_SIZE) {
+        gpServerData->client.writeBufferLength = WIFI_WBUFFER_SIZE;
+    } else if (gpServerData->client.writeBufferLength == 0) {
+        return true;
+    }
+
+    // WINC module buffer full: data remains in writeBuffer and will be
+    // retried on next TransmitBufferedData call
+    if (TcpServerSend(gpServerData->client.writeBuffer,
+                      (uint16_t)gpServerData->client.writeBufferLength) != SOCK_ERR_NO_ERROR) {
+        return false;
+    }
+    gpServerData->client.writeBufferLength = 0;
+    return true;
+}
+
+/* Fan-out send callback (Streaming_FanoutDrainWifi): one stream block to
+ * client slot @p client. Returns len when sent, 0 when the socket has no
+ * room for it yet, negative on a send error. */
+static int FanoutSend(void* ctx, uint8_t client, const uint8_t* data, uint32_t len) {
+    UNUSED(ctx);
+    if (client == 0u) {
+        if (gpServerData->client.clientSocket < 0 ||
+            gpServerData->client.tcpInFlight >= WIFI_TCP_MAX_IN_FLIGHT) {
+            return 0;
         }
-        funRet = false;
+        int16_t rc = TcpServerSend(data, (uint16_t)len);
+        if (rc == SOCK_ERR_NO_ERROR) return (int)len;
+        return (rc == SOCK_ERR_BUFFER_FULL) ? 0 : -1;
     }
 
-    return funRet;
+    wifi_tcp_server_tapContext_t* tap = &gpServerData->tap[client - 1u];
+    SOCKET sock = tap->sock;
+    if (sock < 0 || tap->inFlight >= WIFI_TCP_TAP_MAX_IN_FLIGHT) {
+        return 0;
+    }
+    // Counted before the send: SOCKET_MSG_SEND can fire on the WINC task
+    // before send() returns here.
+    taskENTER_CRITICAL();
+    tap->inFlight++;
+    taskEXIT_CRITICAL();
+    int16_t rc = send(sock, (void*) data, (uint16_t)len, 0);
+    if (rc == SOCK_ERR_NO_ERROR) {
+        return (int)len;
+    }
+    taskENTER_CRITICAL();
+    if (tap->inFlight > 0u) {
+        tap->inFlight--;
+    }
+    taskEXIT_CRITICAL();
+    return (rc == SOCK_ERR_BUFFER_FULL) ? 0 : -1;
+}
+
+/* Stream blocks to every client: the console's only while its reply ring is
+ * empty, so a reply split across sends is never interleaved with the stream. */
+static void TransmitStream(uint32_t minLen, bool console) {
+    uint8_t i;
+    if (console) {
+        (void)Streaming_FanoutDrainWifi(0u, minLen, FanoutSend);
+    }
+    for (i = 0; i < WIFI_TCP_MAX_TAPS; i++) {
+        if (gpServerData->tap[i].sock >= 0) {
+            (void)Streaming_FanoutDrainWifi((uint8_t)(i + 1u), minLen, FanoutSend);
+        }
+    }
 }
 
 /**
@@ -356,6 +410,10 @@ void wifi_tcp_server_Initialize(wifi_tcp_server_context_t *pServerData) {
         for (uint8_t i = 0; i < WIFI_TCP_MAX_IN_FLIGHT; i++) {
             gpServerData->client.inflightSizes[i] = 0;
         }
+        for (uint8_t i = 0; i < WIFI_TCP_MAX_TAPS; i++) {
+            gpServerData->tap[i].sock = -1;
+            gpServerData->tap[i].inFlight = 0;
+        }
         microrl_init(&gpServerData->client.console, microrl_echo);
         microrl_set_echo(&gpServerData->client.console, false);
         microrl_set_execute_callback(&gpServerData->client.console, microrl_commandComplete);
@@ -447,11 +505,33 @@ static inline void ResetInflightRing(void) {
     }
 }
 
+/* Free tap slot @p i. The slot is cleared first so no new send starts on the
+ * socket, and the fan-out detach waits out a drain already sending on it. */
+static void CloseTap(uint8_t i) {
+    wifi_tcp_server_tapContext_t* tap = &gpServerData->tap[i];
+    taskENTER_CRITICAL();
+    SOCKET sock = tap->sock;
+    tap->sock = -1;
+    taskEXIT_CRITICAL();
+    if (sock < 0) {
+        return;
+    }
+    Streaming_FanoutDetachWifi((uint8_t)(i + 1u));
+    tap->inFlight = 0;
+    shutdown(sock);
+}
+
 void wifi_tcp_server_CloseSocket() {
+    uint8_t i;
     // The WINC driver's shutdown() automatically closes the socket
     if (gpServerData->client.clientSocket != -1) {
-        shutdown(gpServerData->client.clientSocket);
+        SOCKET sock = gpServerData->client.clientSocket;
         gpServerData->client.clientSocket = -1;
+        Streaming_FanoutDetachWifi(0u);
+        shutdown(sock);
+    }
+    for (i = 0; i < WIFI_TCP_MAX_TAPS; i++) {
+        CloseTap(i);
     }
 
     if (gpServerData->serverSocket != -1) {
@@ -481,8 +561,12 @@ void wifi_tcp_server_CloseSocket() {
 
 void wifi_tcp_server_CloseClientSocket() {
     if (gpServerData->client.clientSocket != -1) {
-        shutdown(gpServerData->client.clientSocket);
+        // Slot first, as for a tap: the fan-out stops sending the stream to
+        // it before the socket goes.
+        SOCKET sock = gpServerData->client.clientSocket;
         gpServerData->client.clientSocket = -1;
+        Streaming_FanoutDetachWifi(0u);
+        shutdown(sock);
     }
     gpServerData->client.readBufferLength = 0;
     // #437: deferred-reset pattern — never block the WINC driver task
@@ -526,6 +610,14 @@ bool wifi_tcp_server_HasActiveClient(void) {
     return (gpServerData != NULL) && (gpServerData->client.clientSocket >= 0);
 }
 
+bool wifi_tcp_server_ClientConnected(uint8_t slot) {
+    if (gpServerData == NULL || slot >= WIFI_MAX_CLIENT) {
+        return false;
+    }
+    return (slot == 0u) ? (gpServerData->client.clientSocket >= 0)
+                        : (gpServerData->tap[slot - 1u].sock >= 0);
+}
+
 // #367 diagnostics: bytes queued in the WiFi TCP write circular buffer
 // that haven't been drained to send() yet. Streaming_Stop snapshots this
 // to reconcile the accounting gap.
@@ -592,6 +684,41 @@ size_t wifi_tcp_server_WriteBuffer(const char* data, size_t len) {
     return bytesAdded;
 }
 
+uint8_t* wifi_tcp_server_ReserveWriteSpan(size_t minLen, size_t* pLen) {
+    *pLen = 0;
+    if (gpServerData->client.clientSocket < 0) {
+        return NULL;
+    }
+
+    xSemaphoreTake(gpServerData->client.wMutex, portMAX_DELAY);
+    DrainPendingBufferReset();
+    uint32_t span = 0;
+    uint8_t* p = CircularBuf_Reserve(&gpServerData->client.wCirbuf, &span);
+    if (p == NULL || span < minLen) {
+        // Not a rejection: the caller falls back to WriteBuffer, which
+        // does the #371 accounting if the packet really doesn't fit.
+        xSemaphoreGive(gpServerData->client.wMutex);
+        return NULL;
+    }
+    *pLen = span;
+    return p;   // wMutex held until wifi_tcp_server_CommitWriteSpan
+}
+
+size_t wifi_tcp_server_CommitWriteSpan(size_t len) {
+    size_t bytesAdded = CircularBuf_Commit(&gpServerData->client.wCirbuf, (uint32_t)len);
+
+    // Same proactive flush as WriteBuffer.
+    size_t bytesInBuffer = CircularBuf_NumBytesAvailable(&gpServerData->client.wCirbuf);
+    bool shouldFlush = (bytesAdded > 0) && (bytesInBuffer > (WIFI_WBUFFER_SIZE * 3 / 10));
+    xSemaphoreGive(gpServerData->client.wMutex);
+
+    if (shouldFlush && gpServerData->client.tcpInFlight < WIFI_TCP_MAX_IN_FLIGHT) {
+        wifi_tcp_server_TransmitBufferedData();
+    }
+
+    return bytesAdded;
+}
+
 bool wifi_tcp_server_ProcessReceivedBuff() {
     size_t j = 0;
     for (j = 0; j < gpServerData->client.readBufferLength; ++j) {
@@ -605,23 +732,128 @@ bool wifi_tcp_server_ProcessReceivedBuff() {
 bool wifi_tcp_server_TransmitBufferedData() {
     int ret;
     UNUSED(ret);
-    // #362 Step C: bail when WINC's HIF queue is at our cap.  Re-entry
-    // (from streaming_Task WriteBuffer trigger or WDRV_WINC_Tasks
+    // #362 Step C: skip the console when WINC's HIF queue is at our cap.
+    // Re-entry (from streaming_Task WriteBuffer trigger or WDRV_WINC_Tasks
     // SOCKET_MSG_SEND chain) drains one packet per call and increments
     // tcpInFlight in TcpServerFlush — the callback is what decrements it.
-    if (gpServerData->client.tcpInFlight >= WIFI_TCP_MAX_IN_FLIGHT) {
-        return false;
+    // The taps have caps of their own.
+    bool consoleFull = (gpServerData->client.tcpInFlight >= WIFI_TCP_MAX_IN_FLIGHT);
+    bool hasData = false;
+
+    if (!consoleFull) {
+        // Check if data available with mutex protection
+        xSemaphoreTake(gpServerData->client.wMutex, portMAX_DELAY);
+        DrainPendingBufferReset();
+        hasData = (CircularBuf_NumBytesAvailable(&gpServerData->client.wCirbuf) > 0);
+        if (hasData) {
+            CircularBuf_ProcessBytes(&gpServerData->client.wCirbuf, NULL, WIFI_WBUFFER_SIZE, &ret);
+        }
+        xSemaphoreGive(gpServerData->client.wMutex);
     }
+    TransmitStream(1u, !consoleFull && !hasData);
+    return !consoleFull;
+}
 
-    // Check if data available with mutex protection
+void wifi_tcp_server_KickStream(void) {
+    if (gpServerData == NULL) {
+        return;
+    }
     xSemaphoreTake(gpServerData->client.wMutex, portMAX_DELAY);
     DrainPendingBufferReset();
-    bool hasData = (CircularBuf_NumBytesAvailable(&gpServerData->client.wCirbuf) > 0);
-    if (hasData) {
-        CircularBuf_ProcessBytes(&gpServerData->client.wCirbuf, NULL, WIFI_WBUFFER_SIZE, &ret);
-    }
+    bool replies = (CircularBuf_NumBytesAvailable(&gpServerData->client.wCirbuf) > 0);
     xSemaphoreGive(gpServerData->client.wMutex);
-    return true;
+    // Same 30% trigger as the console ring's proactive flush (WriteBuffer).
+    TransmitStream(WIFI_WBUFFER_SIZE * 3 / 10, !replies);
+}
+
+/* Shared by every tap: what a tap sends is read and dropped. */
+static uint8_t gTapRxScratch[32];
+
+bool wifi_tcp_server_AcceptTap(SOCKET sock) {
+    uint8_t i;
+    if (gpServerData == NULL || sock < 0) {
+        return false;
+    }
+    for (i = 0; i < WIFI_TCP_MAX_TAPS; i++) {
+        if (gpServerData->tap[i].sock < 0) {
+            gpServerData->tap[i].inFlight = 0;
+            gpServerData->tap[i].sock = sock;
+            gpServerData->tapAccepted++;
+            Streaming_FanoutAttachWifi((uint8_t)(i + 1u));
+            recv(sock, gTapRxScratch, sizeof(gTapRxScratch), 0);
+            return true;
+        }
+    }
+    return false;
+}
+
+static int8_t TapSlotOf(SOCKET sock) {
+    uint8_t i;
+    if (gpServerData == NULL || sock < 0) {
+        return -1;
+    }
+    for (i = 0; i < WIFI_TCP_MAX_TAPS; i++) {
+        if (gpServerData->tap[i].sock == sock) {
+            return (int8_t)i;
+        }
+    }
+    return -1;
+}
+
+bool wifi_tcp_server_TapOwnsSocket(SOCKET sock) {
+    return TapSlotOf(sock) >= 0;
+}
+
+void wifi_tcp_server_HandleTapSocketEvent(SOCKET sock, uint8_t msgType, void* pvMsg) {
+    int8_t i = TapSlotOf(sock);
+    if (i < 0) {
+        return;
+    }
+    wifi_tcp_server_tapContext_t* tap = &gpServerData->tap[i];
+    switch (msgType) {
+        case SOCKET_MSG_SEND:
+        {
+            // A failed send surfaces as the tap's stall or its RECV error.
+            UNUSED(pvMsg);
+            taskENTER_CRITICAL();
+            if (tap->inFlight > 0u) {
+                tap->inFlight--;
+            }
+            taskEXIT_CRITICAL();
+            (void)Streaming_FanoutDrainWifi((uint8_t)(i + 1), 1u, FanoutSend);
+            break;
+        }
+        case SOCKET_MSG_RECV:
+        {
+            tstrSocketRecvMsg* pRecv = (tstrSocketRecvMsg*) pvMsg;
+            if (pRecv != NULL && pRecv->s16BufferSize > 0) {
+                recv(sock, gTapRxScratch, sizeof(gTapRxScratch), 0);
+            } else {
+                LOG_I("TCP: stream tap %d disconnected", (int)i + 1);
+                CloseTap((uint8_t)i);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void wifi_tcp_server_ServiceTaps(void) {
+    uint8_t i;
+    if (gpServerData == NULL) {
+        return;
+    }
+    for (i = 0; i < WIFI_TCP_MAX_TAPS; i++) {
+        if (gpServerData->tap[i].sock >= 0 &&
+            Streaming_FanoutWifiStalled((uint8_t)(i + 1u),
+                                        pdMS_TO_TICKS(WIFI_TCP_TAP_STALL_MS))) {
+            LOG_E("TCP: stream tap %u took no data for %u ms - closed",
+                  (unsigned)i + 1u, (unsigned)WIFI_TCP_TAP_STALL_MS);
+            gpServerData->tapStallClosed++;
+            CloseTap(i);
+        }
+    }
 }
 
 bool wifi_tcp_server_ResizeWriteBuffer(uint32_t newSize) {
@@ -18,7 +18,12 @@
 extern "C" {
 #endif
 
-#define WIFI_MAX_CLIENT 1
+/* Client slots on the listen port: the SCPI console (slot 0) and stream
+ * taps. A tap gets the stream and nothing else -- no console, no SCPI --
+ * so it costs a socket and a few counters, not a client context. With the
+ * listen socket that is 4 of the WINC's 7 TCP sockets; iperf2 uses 2. */
+#define WIFI_MAX_CLIENT 3
+#define WIFI_TCP_MAX_TAPS (WIFI_MAX_CLIENT - 1)
 #define WIFI_RBUFFER_SIZE ((SOCKET_BUFFER_MAX_LENGTH/2)-1)
 #define WIFI_WBUFFER_SIZE SOCKET_BUFFER_MAX_LENGTH  // Use full WINC1500 buffer capacity (1400 bytes)
 #define WIFI_CIRCULAR_BUFF_SIZE SOCKET_BUFFER_MAX_LENGTH*10
@@ -33,6 +38,14 @@ extern "C" {
 // because they're sample-queue-limited upstream of WiFi.
 #define WIFI_TCP_MAX_IN_FLIGHT 4
 
+/* Per tap: fewer sends queued at the WINC than the console, whose HIF queue
+ * depth they share. */
+#define WIFI_TCP_TAP_MAX_IN_FLIGHT 2
+
+/* A tap with stream data waiting that takes none of it for this long is
+ * disconnected (its blocks are already being evicted; this frees the slot). */
+#define WIFI_TCP_TAP_STALL_MS 5000u
+
 /**
  * Data for a particular TCP client
  */
@@ -123,6 +136,20 @@ typedef struct s_tcpClientContext
     uint32_t idleClosed;
 } wifi_tcp_server_clientContext_t;
 
+/**
+ * A stream-only client (slot 1..WIFI_TCP_MAX_TAPS). Its stream cursor and
+ * byte counters live in the streaming fan-out (Util/TcpFanout.h).
+ */
+typedef struct s_tcpTapContext
+{
+    /** -1 when the slot is free. Cleared before the fan-out detaches the
+     *  slot and the socket is shut, so no new send starts on it. */
+    volatile SOCKET sock;
+    /** send()s queued at the WINC, decremented by SOCKET_MSG_SEND. Written
+     *  under taskENTER_CRITICAL (streaming_Task and WDRV_WINC_Tasks). */
+    volatile uint8_t inFlight;
+} wifi_tcp_server_tapContext_t;
+
 /**
  * Tracks TCP Server Data
  */
@@ -134,6 +161,8 @@ typedef struct s_tcpServerContext
 
     wifi_tcp_server_clientContext_t client;
 
+    wifi_tcp_server_tapContext_t tap[WIFI_TCP_MAX_TAPS];
+
     /* #560/#475 listener-health observability (Opt 0).  uint32_t counters
      * surfaced in SYST:STReam:STATS? (read there under taskENTER_CRITICAL).
      * They PERSIST across streaming sessions (deliberately NOT reset at stream
@@ -155,10 +184,12 @@ typedef struct s_tcpServerContext
     uint32_t socketOpenFails;   /* socket()/bind() HIF-send failure in OpenSocket — nonzero = WINC TCP-table exhaustion (the H2 smoking gun). CROSS-TASK: guard with taskENTER_CRITICAL */
     uint32_t listenFails;       /* SOCKET_MSG_LISTEN reported status != 0 (single-writer: SocketEventCallback) */
     uint32_t acceptFails;       /* SOCKET_MSG_ACCEPT arrived with a NULL message (single-writer: SocketEventCallback) */
-    uint32_t acceptRefused;     /* one-client policy refused a 2nd connect — climbing = PATH-2 zombie churn (single-writer: SocketEventCallback) */
+    uint32_t acceptRefused;     /* refused a connect with the console and every tap taken — climbing = PATH-2 zombie churn (single-writer: SocketEventCallback) */
     uint32_t clientForceClosed; /* self-heal: dead client force-closed (0 until Opt 1) */
     uint32_t listenReopens;     /* self-heal: host re-listen count (0 until Opt 2) */
     uint32_t listenHardResets;  /* self-heal: WINC HardReset escalations (0 until Opt 3) */
+    uint32_t tapAccepted;       /* connections taken as stream taps (single-writer: SocketEventCallback) */
+    uint32_t tapStallClosed;    /* taps closed for taking no stream data (single-writer: app_WifiTask) */
 } wifi_tcp_server_context_t;
 
 /**
@@ -173,6 +204,14 @@ bool wifi_tcp_server_ResizeWriteBuffer(uint32_t newSize);
  *  Returns bytes accepted (0 = buffer full or no client - see #371 counters). */
 size_t wifi_tcp_server_WriteBuffer(const char* data, size_t len);
 
+/** Zero-copy variant of WriteBuffer: reserve a contiguous span of the write
+ *  buffer, fill it in place, then commit. Returns NULL (nothing held) when no
+ *  client is connected or the contiguous span is shorter than minLen. On
+ *  success wMutex stays HELD until wifi_tcp_server_CommitWriteSpan(), which
+ *  applies WriteBuffer's flush trigger. Commit 0 to abandon. */
+uint8_t* wifi_tcp_server_ReserveWriteSpan(size_t minLen, size_t* pLen);
+size_t wifi_tcp_server_CommitWriteSpan(size_t len);
+
 /** #598: true when the given SCPI context is the WiFi TCP console's. */
 bool wifi_tcp_server_ContextIsTcp(const scpi_t* context);
 
@@ -203,6 +242,36 @@ void wifi_tcp_server_SetWriteBuffer(uint8_t* buf, uint32_t size);
  */
 bool wifi_tcp_server_HasActiveClient(void);
 
+/** True when client slot @p slot (0 = console, 1.. = taps) has a socket. */
+bool wifi_tcp_server_ClientConnected(uint8_t slot);
+
+/**
+ * Send what is buffered: console replies first, then the console's and each
+ * tap's stream blocks. Called by the WiFi task loop and the SOCKET_MSG_SEND
+ * chain.
+ */
+bool wifi_tcp_server_TransmitBufferedData(void);
+
+/** Streaming task, after publishing a batch: send the clients' stream blocks
+ *  once a useful run has built up (the console ring's 30% flush trigger). */
+void wifi_tcp_server_KickStream(void);
+
+/**
+ * Take an accepted socket as a stream tap. False when every tap slot is
+ * taken; the caller refuses the connection.
+ */
+bool wifi_tcp_server_AcceptTap(SOCKET sock);
+
+/** True if @p sock is a tap's socket (routed ahead of the console handling). */
+bool wifi_tcp_server_TapOwnsSocket(SOCKET sock);
+
+/** Handle a WINC socket event for a tap's socket. */
+void wifi_tcp_server_HandleTapSocketEvent(SOCKET sock, uint8_t msgType, void* pvMsg);
+
+/** Close taps that stopped reading (WIFI_TCP_TAP_STALL_MS). Call from the
+ *  WiFi task's ProcessState loop, next to wifi_udp_stream_Service. */
+void wifi_tcp_server_ServiceTaps(void);
+
 /**
  * Returns the current count of bytes sitting in the WiFi TCP write
  * circular buffer (queued for send() but not yet drained).
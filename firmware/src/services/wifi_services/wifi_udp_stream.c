@@ -0,0 +1,303 @@
+/**
+ * @file wifi_udp_stream.c
+ * @brief WiFi UDP streaming transport (SYST:STR:INT 4). See header.
+ */
+#define LOG_LVL LOG_LEVEL_WIFI
+#define LOG_MODULE LOG_MODULE_WIFI
+#include "wifi_udp_stream.h"
+
+#include <string.h>
+#include "socket.h"
+#include "Util/CircularBuffer.h"
+#include "Util/Logger.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
+/* socket() retry cooldown in Service() calls (~5 ms each), as for the mDNS
+ * self-heal: a WINC out of sockets must not be asked again every pass. */
+#define UDP_STREAM_OPEN_COOLDOWN_ITERS   200u
+
+typedef struct {
+    SOCKET   sock;
+    bool     wanted;         /* Start .. Stop: Service keeps a socket open */
+    uint8_t  encoding;
+    uint16_t openCooldown;
+    uint32_t destIp;         /* network byte order, 0 = unset */
+    uint16_t destPort;
+    uint32_t nextSeq;
+    uint32_t batchTs;        /* StageBatch -> the next Write's firstTs */
+    volatile uint8_t inFlight;
+    /* The ring holds whole framed datagrams only: Write adds a batch's
+     * datagrams under mutex after checking they all fit, so Transmit can pop
+     * a header and then exactly its payload. staging is the datagram being
+     * sent; stagedLen stays non-zero while the WINC answers BUFFER_FULL. */
+    uint8_t* staging;
+    uint16_t stagedLen;
+    CircularBuf_t ring;
+    SemaphoreHandle_t mutex;
+    uint32_t batches;
+    uint32_t datagramsSent;
+    uint32_t datagramsFailed;
+    uint32_t rejectedBatches;
+    uint32_t rejectedBytes;
+    uint64_t bytesSent;
+} udp_stream_state_t;
+
+static udp_stream_state_t gUdp = {.sock = -1, .destPort = WIFI_UDP_STREAM_DEFAULT_PORT};
+
+void wifi_udp_stream_SetDestination(uint32_t ipNetworkOrder, uint16_t port) {
+    taskENTER_CRITICAL();
+    gUdp.destIp = ipNetworkOrder;
+    gUdp.destPort = (port != 0u) ? port : WIFI_UDP_STREAM_DEFAULT_PORT;
+    taskEXIT_CRITICAL();
+}
+
+void wifi_udp_stream_GetDestination(uint32_t* pIpNetworkOrder, uint16_t* pPort) {
+    taskENTER_CRITICAL();
+    *pIpNetworkOrder = gUdp.destIp;
+    *pPort = gUdp.destPort;
+    taskEXIT_CRITICAL();
+}
+
+bool wifi_udp_stream_HasDestination(void) {
+    return gUdp.destIp != 0u;
+}
+
+void wifi_udp_stream_SetBuffer(uint8_t* buf, uint32_t size) {
+    if (gUdp.mutex == NULL) {
+        gUdp.mutex = xSemaphoreCreateMutex();
+        if (gUdp.mutex == NULL) {
+            LOG_E("UDP stream: mutex alloc failed");
+            return;
+        }
+    }
+    xSemaphoreTake(gUdp.mutex, portMAX_DELAY);
+    if (buf == NULL || size < WIFI_UDP_STREAM_MIN_BUFFER) {
+        gUdp.staging = NULL;
+        CircularBuf_InitExternal(&gUdp.ring, NULL, NULL, 0);
+    } else {
+        gUdp.staging = buf;
+        CircularBuf_InitExternal(&gUdp.ring, NULL, buf + WIFI_UDP_STREAM_DATAGRAM_MAX,
+                                 size - WIFI_UDP_STREAM_DATAGRAM_MAX);
+    }
+    gUdp.stagedLen = 0;
+    xSemaphoreGive(gUdp.mutex);
+    if (buf != NULL) {
+        LOG_I("UDP stream ring: %u bytes", (unsigned)gUdp.ring.buf_size);
+    }
+}
+
+void wifi_udp_stream_Start(uint8_t encoding) {
+    if (gUdp.mutex == NULL) {
+        return;
+    }
+    xSemaphoreTake(gUdp.mutex, portMAX_DELAY);
+    CircularBuf_Reset(&gUdp.ring);
+    gUdp.stagedLen = 0;
+    gUdp.encoding = encoding;
+    gUdp.nextSeq = 0;
+    gUdp.batchTs = 0;
+    gUdp.batches = 0;
+    gUdp.datagramsSent = 0;
+    gUdp.datagramsFailed = 0;
+    gUdp.rejectedBatches = 0;
+    gUdp.rejectedBytes = 0;
+    gUdp.bytesSent = 0;
+    gUdp.openCooldown = 0;
+    gUdp.wanted = true;
+    xSemaphoreGive(gUdp.mutex);
+}
+
+void wifi_udp_stream_Stop(void) {
+    gUdp.wanted = false;
+}
+
+void wifi_udp_stream_StageBatch(uint32_t firstTs) {
+    gUdp.batchTs = firstTs;
+}
+
+static void UdpStreamSinkToRing(void* ctx, const uint8_t* hdr, const uint8_t* payload, size_t len) {
+    (void)ctx;
+    CircularBuf_AddBytes(&gUdp.ring, (uint8_t*)hdr, UDP_STREAM_HEADER_SIZE);
+    if (len > 0u) {
+        CircularBuf_AddBytes(&gUdp.ring, (uint8_t*)payload, (uint32_t)len);
+    }
+}
+
+size_t wifi_udp_stream_Write(const char* data, size_t len) {
+    if (len == 0u) {
+        return 0;
+    }
+    if (!gUdp.wanted || gUdp.mutex == NULL || gUdp.staging == NULL) {
+        gUdp.rejectedBatches++;
+        gUdp.rejectedBytes += (uint32_t)len;
+        return 0;
+    }
+    size_t cost = UdpStream_WireSize(len, WIFI_UDP_STREAM_PAYLOAD_MAX);
+    xSemaphoreTake(gUdp.mutex, portMAX_DELAY);
+    if (CircularBuf_NumBytesFree(&gUdp.ring) < cost) {
+        gUdp.rejectedBatches++;
+        gUdp.rejectedBytes += (uint32_t)len;
+        xSemaphoreGive(gUdp.mutex);
+        return 0;
+    }
+    /* Sequence numbers are taken here, at enqueue, not at sendto(): a
+     * datagram that sendto() later refuses shows up at the host as a gap,
+     * the same as one the air lost. */
+    UdpStream_Pack(&gUdp.nextSeq, gUdp.encoding, gUdp.batchTs, (const uint8_t*)data, len,
+                   WIFI_UDP_STREAM_PAYLOAD_MAX, UdpStreamSinkToRing, NULL);
+    gUdp.batches++;
+    xSemaphoreGive(gUdp.mutex);
+
+    wifi_udp_stream_Transmit();
+    return len;
+}
+
+size_t wifi_udp_stream_GetWriteBuffFreeSize(void) {
+    if (!gUdp.wanted || gUdp.staging == NULL) {
+        return 0;
+    }
+    /* NumBytesFree is safe from the producer side without the lock. */
+    uint32_t free = CircularBuf_NumBytesFree(&gUdp.ring);
+    uint32_t datagrams = (free + WIFI_UDP_STREAM_DATAGRAM_MAX - 1u) / WIFI_UDP_STREAM_DATAGRAM_MAX;
+    uint32_t headers = datagrams * UDP_STREAM_HEADER_SIZE;
+    return (free > headers) ? (size_t)(free - headers) : 0u;
+}
+
+void wifi_udp_stream_Transmit(void) {
+    if (gUdp.sock < 0 || gUdp.destIp == 0u || gUdp.mutex == NULL ||
+        gUdp.inFlight >= WIFI_UDP_STREAM_MAX_IN_FLIGHT) {
+        return;
+    }
+    struct sockaddr_in dst;
+    memset(&dst, 0, sizeof(dst));
+    dst.sin_family = AF_INET;
+    taskENTER_CRITICAL();
+    dst.sin_port = _htons(gUdp.destPort);
+    dst.sin_addr.s_addr = gUdp.destIp;
+    taskEXIT_CRITICAL();
+
+    xSemaphoreTake(gUdp.mutex, portMAX_DELAY);
+    while (gUdp.staging != NULL && gUdp.sock >= 0 &&
+           gUdp.inFlight < WIFI_UDP_STREAM_MAX_IN_FLIGHT) {
+        if (gUdp.stagedLen == 0u) {
+            int ret;
+            UdpStreamHeader_t h;
+            if (CircularBuf_NumBytesAvailable(&gUdp.ring) < UDP_STREAM_HEADER_SIZE) {
+                break;
+            }
+            CircularBuf_ProcessBytes(&gUdp.ring, gUdp.staging, UDP_STREAM_HEADER_SIZE, &ret);
+            if (!UdpStream_DecodeHeader(gUdp.staging, WIFI_UDP_STREAM_DATAGRAM_MAX, &h)) {
+                /* Only Write fills the ring, a datagram at a time; a bad
+                 * header means it was torn down under us. Start clean. */
+                LOG_E("UDP stream: ring out of step, reset");
+                CircularBuf_Reset(&gUdp.ring);
+                break;
+            }
+            CircularBuf_ProcessBytes(&gUdp.ring, gUdp.staging + UDP_STREAM_HEADER_SIZE,
+                                     h.payloadLen, &ret);
+            gUdp.stagedLen = (uint16_t)(UDP_STREAM_HEADER_SIZE + h.payloadLen);
+        }
+        int16_t rc = sendto(gUdp.sock, gUdp.staging, gUdp.stagedLen, 0,
+                            (struct sockaddr*)&dst, sizeof(dst));
+        if (rc == SOCK_ERR_BUFFER_FULL) {
+            break;                      /* keep it staged; SENDTO or Service retries */
+        }
+        if (rc == SOCK_ERR_NO_ERROR) {
+            taskENTER_CRITICAL();
+            gUdp.inFlight++;
+            taskEXIT_CRITICAL();
+            gUdp.datagramsSent++;
+            gUdp.bytesSent += gUdp.stagedLen;
+        } else {
+            gUdp.datagramsFailed++;
+            if ((gUdp.datagramsFailed % 100u) == 1u) {
+                LOG_E("UDP stream: sendto() returned %d (count=%u)", (int)rc,
+                      (unsigned)gUdp.datagramsFailed);
+            }
+        }
+        gUdp.stagedLen = 0;
+    }
+    xSemaphoreGive(gUdp.mutex);
+}
+
+static void UdpStreamShutSocket(void) {
+    if (gUdp.sock >= 0) {
+        (void)shutdown(gUdp.sock);   /* best-effort cleanup — rc intentionally ignored */
+    }
+    gUdp.sock = -1;
+    gUdp.inFlight = 0;
+}
+
+void wifi_udp_stream_Service(void) {
+    if (gUdp.wanted) {
+        if (gUdp.sock < 0 && gUdp.destIp != 0u) {
+            if (gUdp.openCooldown > 0u) {
+                gUdp.openCooldown--;
+                return;
+            }
+            gUdp.sock = socket(AF_INET, SOCK_DGRAM, 0);
+            if (gUdp.sock < 0) {
+                LOG_E("UDP stream: socket() failed: %d", (int)gUdp.sock);
+                gUdp.sock = -1;
+                gUdp.openCooldown = UDP_STREAM_OPEN_COOLDOWN_ITERS;
+                return;
+            }
+            gUdp.inFlight = 0;
+        }
+    } else if (gUdp.sock >= 0 && gUdp.inFlight == 0u && gUdp.stagedLen == 0u &&
+               CircularBuf_NumBytesAvailable(&gUdp.ring) == 0u) {
+        UdpStreamShutSocket();
+        return;
+    }
+    /* Re-kick a datagram left staged on BUFFER_FULL with nothing in flight to
+     * chain the retry from. */
+    wifi_udp_stream_Transmit();
+}
+
+void wifi_udp_stream_Close(void) {
+    if (gUdp.mutex != NULL) {
+        xSemaphoreTake(gUdp.mutex, portMAX_DELAY);
+        UdpStreamShutSocket();
+        gUdp.stagedLen = 0;
+        xSemaphoreGive(gUdp.mutex);
+    } else {
+        UdpStreamShutSocket();
+    }
+}
+
+bool wifi_udp_stream_OwnsSocket(SOCKET sock) {
+    return (sock >= 0) && (sock == gUdp.sock);
+}
+
+void wifi_udp_stream_HandleSocketEvent(SOCKET sock, uint8_t msgType, void* pvMsg) {
+    (void)pvMsg;
+    if (!wifi_udp_stream_OwnsSocket(sock)) {
+        return;
+    }
+    if (msgType == SOCKET_MSG_SENDTO) {
+        taskENTER_CRITICAL();
+        if (gUdp.inFlight > 0u) {
+            gUdp.inFlight--;
+        }
+        taskEXIT_CRITICAL();
+        wifi_udp_stream_Transmit();
+    }
+}
+
+void wifi_udp_stream_GetStats(wifi_udp_stream_stats_t* out) {
+    taskENTER_CRITICAL();
+    out->socketOpen = (gUdp.sock >= 0);
+    out->running = gUdp.wanted;
+    out->destIp = gUdp.destIp;
+    out->destPort = gUdp.destPort;
+    out->nextSeq = gUdp.nextSeq;
+    out->batches = gUdp.batches;
+    out->datagramsSent = gUdp.datagramsSent;
+    out->datagramsFailed = gUdp.datagramsFailed;
+    out->rejectedBatches = gUdp.rejectedBatches;
+    out->rejectedBytes = gUdp.rejectedBytes;
+    out->bytesSent = gUdp.bytesSent;
+    taskEXIT_CRITICAL();
+}
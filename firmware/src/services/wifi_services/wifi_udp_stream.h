@@ -0,0 +1,142 @@
+/**
+ * @file wifi_udp_stream.h
+ * @brief Stream data over UDP datagrams instead of the TCP console (SYST:STR:INT 4).
+ *
+ * TCP hands every lost segment back to the WINC as a retransmission, and a
+ * retransmission stalls everything queued behind it: on a marginal link the
+ * stream backs up into the circular buffer and the device drops whole batches
+ * it never sent. UDP trades that for loss the host can see. Each datagram
+ * carries a sequence number and the first-sample timestamp of its batch
+ * (Util/UdpStream.h), so a receiver counts exactly what the network lost and
+ * still parses every batch that arrived whole. tests/host/udp_stream_rx.c is
+ * the reference receiver.
+ *
+ * Model: one unbound UDP socket, sendto() a destination set at runtime with
+ * SYST:COMM:LAN:UDPStream:DESTination (never saved to NVM, like the rest of
+ * the stream setup). The TCP console stays up for SCPI, STR:STOP included.
+ *
+ * Buffering: the WiFi region of the streaming pool is shared with the TCP
+ * console while this interface is selected (PrepareStreamingBuffers). Of the
+ * region handed to SetBuffer, the first WIFI_UDP_STREAM_DATAGRAM_MAX bytes
+ * stage the datagram being sent; the rest is a ring of framed datagrams
+ * (header + payload) that Write fills and Transmit drains.
+ *
+ * Contexts: Write runs on streaming_Task; Transmit runs there and on the WiFi
+ * task (SOCKET_MSG_SENDTO chain, ProcessState); Service / Close /
+ * HandleSocketEvent run on the WiFi task only, so the socket is only ever
+ * opened and shut from the task that owns the WINC.
+ */
+#ifndef WIFI_UDP_STREAM_H
+#define WIFI_UDP_STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "socket.h"
+#include "Util/UdpStream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Default destination port: the one after the SCPI console's 9760. */
+#define WIFI_UDP_STREAM_DEFAULT_PORT   9761u
+
+/** Largest datagram handed to sendto(), header included. The WINC refuses
+ *  anything over SOCKET_BUFFER_MAX_LENGTH (1400). */
+#define WIFI_UDP_STREAM_DATAGRAM_MAX   1400u
+
+/** Stream bytes per datagram once its header is in. */
+#define WIFI_UDP_STREAM_PAYLOAD_MAX    (WIFI_UDP_STREAM_DATAGRAM_MAX - UDP_STREAM_HEADER_SIZE)
+
+/** sendto()s allowed outstanding at the WINC before Transmit waits for a
+ *  SOCKET_MSG_SENDTO. Two keep the radio busy while the next is staged
+ *  without crowding the HIF queue the TCP console also needs. */
+#define WIFI_UDP_STREAM_MAX_IN_FLIGHT  2u
+
+/** Smallest SetBuffer region that holds the staging buffer and a useful ring. */
+#define WIFI_UDP_STREAM_MIN_BUFFER     (WIFI_UDP_STREAM_DATAGRAM_MAX + 4u * WIFI_UDP_STREAM_DATAGRAM_MAX)
+
+typedef struct {
+    bool     socketOpen;
+    bool     running;         /**< between Start and Stop */
+    uint32_t destIp;          /**< network byte order, 0 = unset */
+    uint16_t destPort;
+    uint32_t nextSeq;         /**< seq the next datagram queued gets */
+    uint32_t batches;         /**< batches queued */
+    uint32_t datagramsSent;   /**< accepted by sendto() */
+    uint32_t datagramsFailed; /**< refused by sendto() for anything but a full buffer */
+    uint32_t rejectedBatches; /**< Write refused: ring full or not running */
+    uint32_t rejectedBytes;
+    uint64_t bytesSent;       /**< datagram bytes accepted, headers included */
+} wifi_udp_stream_stats_t;
+
+/**
+ * Set where datagrams go. @p ipNetworkOrder 0 clears the destination.
+ * Takes effect at the next datagram; a running stream is not restarted.
+ */
+void wifi_udp_stream_SetDestination(uint32_t ipNetworkOrder, uint16_t port);
+
+void wifi_udp_stream_GetDestination(uint32_t* pIpNetworkOrder, uint16_t* pPort);
+
+/** True once a destination has been set. STR:START on this interface refuses without one. */
+bool wifi_udp_stream_HasDestination(void);
+
+/**
+ * Hand the module its buffer (see Buffering above). NULL / 0 detaches it:
+ * Write then refuses everything. Only call with streaming stopped -- the
+ * pool is re-carved under PrepareStreamingBuffers' quiesce.
+ */
+void wifi_udp_stream_SetBuffer(uint8_t* buf, uint32_t size);
+
+/**
+ * Begin a session: sequence numbers restart at 0, the ring is emptied, and
+ * the WiFi task opens the socket on its next pass (Service).
+ * @param encoding the StreamingEncoding every datagram is tagged with.
+ */
+void wifi_udp_stream_Start(uint8_t encoding);
+
+/** End the session. What is still queued is sent; the socket closes once it drains. */
+void wifi_udp_stream_Stop(void);
+
+/** Timestamp (TS-timer ticks) of the first sample set in the next Write. */
+void wifi_udp_stream_StageBatch(uint32_t firstTs);
+
+/**
+ * Queue one encoder batch (whole messages). All or nothing: returns @p len
+ * when every datagram of it is queued, 0 when the ring could not take all of
+ * them (the caller's drop accounting counts it, as for the TCP path).
+ */
+size_t wifi_udp_stream_Write(const char* data, size_t len);
+
+/** Payload bytes one more Write could take, after its datagram headers. */
+size_t wifi_udp_stream_GetWriteBuffFreeSize(void);
+
+/** Send the next queued datagram if the WINC has room for it. Safe from either task. */
+void wifi_udp_stream_Transmit(void);
+
+/**
+ * Open the socket when a session wants it and close it once one has ended
+ * and drained. Call from WifiTask's ProcessState loop, next to
+ * mdns_responder_ServiceHealth.
+ */
+void wifi_udp_stream_Service(void);
+
+/** Shut the socket now (STA disconnect, DEINIT). The WINC's sockets are gone
+ *  with the link; Service reopens one if a session is still running. */
+void wifi_udp_stream_Close(void);
+
+/** True if @p sock is the stream's socket (routed ahead of the TCP handling). */
+bool wifi_udp_stream_OwnsSocket(SOCKET sock);
+
+/** Handle a WINC socket event for the stream's socket. */
+void wifi_udp_stream_HandleSocketEvent(SOCKET sock, uint8_t msgType, void* pvMsg);
+
+/** Copy the counters. Never fails. */
+void wifi_udp_stream_GetStats(wifi_udp_stream_stats_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WIFI_UDP_STREAM_H */
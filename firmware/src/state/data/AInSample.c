@@ -1,21 +1,44 @@
 /*! @file AInSample.c
- * @brief Analog input sample queue and object pool implementation.
+ * @brief Analog input sample pool + queue: one wait-free SPSC slot ring.
  *
- * Implements a FreeRTOS queue for streaming analog input samples between the
- * ADC interrupt handler and the streaming task. Uses an object pool with O(1)
- * free list allocation to eliminate heap overhead at high sample rates.
+ * The pool IS the queue. Samples are produced (deferred ISR task, pri 9) and
+ * consumed (streaming_Task / encoders, pri 6) strictly in FIFO order, so the
+ * slots can be handed out, published, popped and returned in ring order and
+ * no free list, pointer queue or mutex is needed:
+ *
+ *            released        popped              produced
+ *               |  encoder holds  |  queued (Size)   | claim |   free   |
+ *   slots: ... [r][r+1] ...      [p] ...            [P]     [P+1] ...
+ *
+ *  - AllocateFromPool (producer) claims slot P if fewer than capacity slots
+ *    are outstanding (produced - released < capacity).
+ *  - PushBack (producer) publishes the claim: produced++.
+ *  - PopFront / PeekFront (consumer) read slot p while popped != produced.
+ *  - FreeToPool (consumer) returns the oldest popped slot: released++.
+ *    FreeToPool on the producer's own unpublished claim (the PushBack-fail
+ *    and scan-priming paths in streaming.c) just drops the claim.
+ *
+ * Each counter has exactly one writer. produced / popped / released are
+ * free-running uint32 counts -- unsigned subtraction stays exact across the
+ * 2^32 wrap, same as CircularBuffer's producedBytes/consumedBytes (#276) --
+ * while each side also keeps the matching slot index (0..capacity-1) so the
+ * capacity need not be a power of two. Every operation is a handful of loads
+ * and stores with no lock, no critical section and no priority inheritance on
+ * the per-tick path (replaces poolMutex + the FreeRTOS pointer queue).
+ *
+ * Contract (all current callers satisfy it):
+ *  - ONE producer context allocates/publishes, at most one claim at a time.
+ *  - ONE consumer context at a time pops and frees, and frees popped slots in
+ *    pop order (pop -> encode -> free, one sample at a time).
+ *  - Initialize/InitializeExternal/Destroy run with both sides quiesced
+ *    (streaming stopped, the #486 encoder quiescence flag clear).
  *
  * Two initialization paths:
- * - AInSampleList_InitializeExternal(): Pool memory from StreamingBufferPool
+ * - AInSampleList_InitializeExternal(): slot memory from StreamingBufferPool
  *   (static BSS, zero fragmentation). Used at boot and re-partitioned at each
- *   stream start. FreeRTOS queue is reused across sessions.
+ *   stream start.
  * - AInSampleList_Initialize(): Legacy heap allocation path (fallback only).
  *
- * Performance characteristics:
- * - Queue: Standard FreeRTOS queue (thread-safe, ISR-safe)
- * - Pool allocation: O(1) via free list (no fragmentation, deterministic timing)
- * - Pool size: Configurable (default DEFAULT_AIN_SAMPLE_COUNT = 1100)
- *
  * @author Javier Longares Abaiz - When Technology becomes art.
  * @web www.javierlongares.com
  */
@@ -26,43 +49,69 @@
 
 #include "AInSample.h"
 #include "FreeRTOS.h"
-#include "queue.h"
 #include <string.h>  // For memset
 #include "Util/Logger.h"
 
-//! Ticks to wait for QUEUE OPERATIONS
-#define AINSAMPLE_QUEUE_TICKS_TO_WAIT               0  // No delay
-
-//! Queue handler for Analog inputs
-static QueueHandle_t analogInputsQueue;
-//! Size of the queue, in number of items
-static uint32_t queueSize = 0;
+/* Publication barrier between a slot's contents and the counter that hands
+ * it to the other side. PIC32MZ is single-core and both sides are tasks, so
+ * ordering only has to survive the compiler (same idiom as the #486 flag in
+ * streaming.c). The host build (tests/host, real pthreads on a multi-core
+ * machine) needs a hardware fence as well. */
+#if defined(__XC32)
+#define AINSAMPLE_BARRIER() __asm__ __volatile__ ("" ::: "memory")
+#else
+#define AINSAMPLE_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
 
 // =============================================================================
-// Object Pool (from StreamingBufferPool static BSS, or FreeRTOS heap fallback)
+// Slot ring (from StreamingBufferPool static BSS, or FreeRTOS heap fallback)
 // =============================================================================
 static uint8_t* samplePoolBase = NULL;   // Raw byte pointer (stride-indexed)
 static uint32_t poolCapacity = 0;
 static size_t poolElementStride = 0;     // Bytes per element (runtime-sized)
-static volatile uint32_t poolAllocCount = 0;     // Currently allocated (in use)
 static volatile uint32_t poolMaxAllocCount = 0;  // High-water mark (max ever in use)
-
-// =============================================================================
-// Free List Data Structures (O(1) allocation/deallocation)
-// =============================================================================
-static int16_t freeHead = -1;
-static int16_t* nextFree = NULL;
-
-static SemaphoreHandle_t poolMutex = NULL;
 static volatile bool poolActive = false;
 static bool poolOwnsMemory = false;  // false = external (StreamingBufferPool)
 
+// Producer-owned (deferred ISR task)
+static volatile uint32_t ringProduced = 0;   // samples published
+static uint32_t prodSlot = 0;                // slot index of ringProduced
+// Slot handed out by AllocateFromPool and not yet published, or NO_CLAIM.
+// One word so FreeToPool (which may run on the consumer) reads it untorn.
+#define AINSAMPLE_NO_CLAIM UINT32_MAX
+static volatile uint32_t prodClaim = AINSAMPLE_NO_CLAIM;
+
+// Consumer-owned (streaming_Task / encoders)
+static volatile uint32_t ringPopped = 0;     // samples popped
+static uint32_t popSlot = 0;                 // slot index of ringPopped
+static volatile uint32_t ringReleased = 0;   // popped samples returned to the pool
+static uint32_t releaseSlot = 0;             // slot index of ringReleased
+
+static inline uint32_t NextSlot(uint32_t slot) {
+    return (++slot == poolCapacity) ? 0u : slot;
+}
+
+static inline AInPublicSampleList_t* SlotPtr(uint32_t slot) {
+    return (AInPublicSampleList_t*)(samplePoolBase + (size_t)slot * poolElementStride);
+}
+
+// Empty the ring. Callers have already cleared poolActive (or never set it).
+static void ResetRing(void) {
+    ringProduced = 0;
+    prodSlot = 0;
+    prodClaim = AINSAMPLE_NO_CLAIM;
+    ringPopped = 0;
+    popSlot = 0;
+    ringReleased = 0;
+    releaseSlot = 0;
+    poolMaxAllocCount = 0;
+}
+
 void AInSampleList_Initialize(size_t maxSize, bool dropOnOverflow){
 
     (void)dropOnOverflow;
 
     // Destroy previous resources if re-initializing (any size change or same size).
-    // Must destroy before creating new queue to prevent orphaning the old handle.
     if (samplePoolBase != NULL) {
         AInSampleList_Destroy();
     }
@@ -75,335 +124,185 @@ void AInSampleList_Initialize(size_t maxSize, bool dropOnOverflow){
     size_t elemSize = AInSampleList_ElementSize(MAX_AIN_PUBLIC_CHANNELS);
 
     // Clamp further to what the heap can actually fit.
-    if (samplePoolBase == NULL) {
-        size_t perSample = elemSize + sizeof(int16_t);
-        size_t heapAvail = xPortGetFreeHeapSize();
-        // Reserve 10KB for queue + FreeRTOS overhead + alignment padding
-        size_t usable = (heapAvail > 10240) ? (heapAvail - 10240) : 0;
-        uint32_t maxFit = (uint32_t)(usable / perSample);
-
-        if (maxSize > maxFit) {
-            maxSize = (maxFit >= MIN_AIN_SAMPLE_COUNT) ? maxFit : MIN_AIN_SAMPLE_COUNT;
-        }
+    size_t heapAvail = xPortGetFreeHeapSize();
+    // Reserve 10KB for FreeRTOS overhead + alignment padding
+    size_t usable = (heapAvail > 10240) ? (heapAvail - 10240) : 0;
+    uint32_t maxFit = (uint32_t)(usable / elemSize);
+    if (maxSize > maxFit) {
+        maxSize = (maxFit >= MIN_AIN_SAMPLE_COUNT) ? maxFit : MIN_AIN_SAMPLE_COUNT;
     }
 
-    queueSize = maxSize;
-    analogInputsQueue = xQueueCreate(queueSize, sizeof(AInPublicSampleList_t *));
-    configASSERT(analogInputsQueue != NULL);
-
-    // Allocate pool from heap with max-channel element size
+    samplePoolBase = (uint8_t*)pvPortMalloc(maxSize * elemSize);
     if (samplePoolBase == NULL) {
-        poolCapacity = maxSize;
-        poolElementStride = elemSize;
-
-        samplePoolBase = (uint8_t*)pvPortMalloc(poolCapacity * poolElementStride);
-        if (samplePoolBase == NULL) {
-            LOG_E("Sample pool alloc failed (%u samples, %u bytes)",
-                  (unsigned)poolCapacity,
-                  (unsigned)(poolCapacity * poolElementStride));
-            vQueueDelete(analogInputsQueue);
-            analogInputsQueue = NULL;
-            queueSize = 0;
-            poolCapacity = 0;
-            configASSERT(0);
-            return;
-        }
-
-        nextFree = (int16_t*)pvPortMalloc(poolCapacity * sizeof(int16_t));
-        if (nextFree == NULL) {
-            vPortFree(samplePoolBase);
-            samplePoolBase = NULL;
-            vQueueDelete(analogInputsQueue);
-            analogInputsQueue = NULL;
-            queueSize = 0;
-            poolCapacity = 0;
-            LOG_E("Sample pool nextFree alloc failed");
-            configASSERT(0);
-            return;
-        }
-        poolOwnsMemory = true;
-    }
-
-    // Initialize object pool mutex
-    if (poolMutex == NULL) {
-        poolMutex = xSemaphoreCreateMutex();
-        configASSERT(poolMutex != NULL);
-    }
-
-    // Build free list chain: 0 → 1 → 2 → ... → N-1 → -1
-    for (uint32_t i = 0; i < poolCapacity - 1; i++) {
-        nextFree[i] = (int16_t)(i + 1);
+        LOG_E("Sample pool alloc failed (%u samples, %u bytes)",
+              (unsigned)maxSize, (unsigned)(maxSize * elemSize));
+        poolCapacity = 0;
+        configASSERT(0);
+        return;
     }
-    nextFree[poolCapacity - 1] = -1;  // End of list
-    freeHead = 0;  // Start at first entry
+    poolOwnsMemory = true;
+    poolCapacity = (uint32_t)maxSize;
+    poolElementStride = elemSize;
+    ResetRing();
 
+    AINSAMPLE_BARRIER();
     poolActive = true;
 }
 
-void AInSampleList_InitializeExternal(void* poolMem, int16_t* freeMem,
-                                       size_t maxSize, size_t elementSize) {
-    if (poolMem == NULL || freeMem == NULL || maxSize == 0 || elementSize == 0) {
-        LOG_E("Sample pool external init: NULL or zero (%p, %p, %u, %u)",
-              poolMem, freeMem, (unsigned)maxSize, (unsigned)elementSize);
+void AInSampleList_InitializeExternal(void* poolMem, size_t maxSize,
+                                      size_t elementSize) {
+    if (poolMem == NULL || maxSize == 0 || elementSize == 0) {
+        LOG_E("Sample pool external init: NULL or zero (%p, %u, %u)",
+              poolMem, (unsigned)maxSize, (unsigned)elementSize);
         return;
     }
 
     if (maxSize < MIN_AIN_SAMPLE_COUNT) maxSize = MIN_AIN_SAMPLE_COUNT;
     if (maxSize > MAX_AIN_SAMPLE_COUNT) maxSize = MAX_AIN_SAMPLE_COUNT;
 
-    // Create mutex if first call (boot-time malloc)
-    if (poolMutex == NULL) {
-        poolMutex = xSemaphoreCreateMutex();
-        configASSERT(poolMutex != NULL);
-    }
-
-    // Serialize reconfiguration — blocks any in-flight alloc/free
-    xSemaphoreTake(poolMutex, portMAX_DELAY);
+    // Block the fast paths, then swap. Both sides are quiesced by contract,
+    // so poolActive only has to stop a stray late call from touching the
+    // ring mid-swap.
     poolActive = false;
+    AINSAMPLE_BARRIER();
 
-    // Drain existing queue if present (reuse it to avoid runtime malloc)
-    if (analogInputsQueue != NULL) {
-        AInPublicSampleList_t* pStale;
-        while (xQueueReceive(analogInputsQueue, &pStale, 0) == pdTRUE) {
-            // Drain — old pool memory is being replaced
-        }
-
-        // Reuse existing queue when new size fits (avoids runtime malloc).
-        // Only recreate if new size exceeds current capacity — this can only
-        // happen via explicit SYST:MEM:SAMP:POOL > boot default.
-        if (maxSize > queueSize) {
-            size_t needed = maxSize * sizeof(AInPublicSampleList_t*) + 80;
-            size_t freeHeap = xPortGetFreeHeapSize();
-            if (freeHeap < needed + 1024) {
-                LOG_E("Sample queue resize skipped: need %u, heap free %u",
-                      (unsigned)needed, (unsigned)freeHeap);
-                maxSize = queueSize;  // Keep old queue, clamp pool to fit
-            } else {
-                LOG_I("Sample queue resize: %u -> %u slots (heap free %u)",
-                      (unsigned)queueSize, (unsigned)maxSize, (unsigned)freeHeap);
-                vQueueDelete(analogInputsQueue);
-                analogInputsQueue = xQueueCreate(maxSize, sizeof(AInPublicSampleList_t*));
-                configASSERT(analogInputsQueue != NULL);
-                queueSize = maxSize;
-            }
-        }
-    } else {
-        // First init — must create queue (boot-time malloc, heap is fresh)
-        queueSize = maxSize;
-        analogInputsQueue = xQueueCreate(queueSize, sizeof(AInPublicSampleList_t *));
-        configASSERT(analogInputsQueue != NULL);
+    if (poolOwnsMemory && samplePoolBase != NULL) {
+        vPortFree(samplePoolBase);   // leaving the heap fallback
     }
 
-    // Swap to externally provided memory (from StreamingBufferPool)
+    // Swap to externally provided memory (from StreamingBufferPool). The
+    // ring depth is exactly the partitioned count -- there is no separate
+    // queue whose size could disagree with it (#828).
     samplePoolBase = (uint8_t*)poolMem;
-    nextFree = freeMem;
-    poolCapacity = maxSize;
+    poolCapacity = (uint32_t)maxSize;
     poolElementStride = elementSize;
     poolOwnsMemory = false;
-    poolAllocCount = 0;
-    poolMaxAllocCount = 0;
-
-    // Build free list chain
-    for (uint32_t i = 0; i < poolCapacity - 1; i++) {
-        nextFree[i] = (int16_t)(i + 1);
-    }
-    nextFree[poolCapacity - 1] = -1;
-    freeHead = 0;
+    ResetRing();
 
+    AINSAMPLE_BARRIER();
     poolActive = true;
-    xSemaphoreGive(poolMutex);
 
     LOG_I("Sample pool: %u samples x %u bytes (external memory)",
           (unsigned)poolCapacity, (unsigned)poolElementStride);
 }
 
 /**
- * @brief Destroys the sample queue and resets the object pool.
+ * @brief Empties the ring and releases heap-owned slot memory.
  *
- * Thread safety note: We do NOT take poolMutex at the top of this function.
- * Instead, we use poolActive (32-bit atomic write on PIC32MZ) as a fast-path
- * guard that immediately blocks new AllocateFromPool/FreeToPool calls without
- * mutex contention. The mutex is only taken later (step 5) as a synchronization
- * barrier to ensure in-flight operations complete before freeing memory.
- * This is safe because Destroy is only called from Streaming_Start (task context,
- * streaming stopped) when no ISR or task is allocating from the pool.
- *
- * Teardown sequence (order matters):
- * 1. Block new pool operations (poolActive = false — atomic on PIC32MZ)
- * 2. Atomically capture and nullify queue handle
- * 3. Drain remaining samples
- * 4. Delete FreeRTOS queue
- * 5. Take mutex as barrier, free pool memory
+ * Only called with streaming stopped (Streaming_Start / re-init), so no
+ * producer or consumer is mid-operation. poolActive is cleared first so a
+ * stray late call fails fast instead of indexing freed memory.
  */
 void AInSampleList_Destroy()
 {
-    // Step 1: Block new pool operations (atomic 32-bit write, no mutex needed)
     poolActive = false;
+    AINSAMPLE_BARRIER();
 
-    // Step 2: Atomically capture and nullify queue handle to prevent further use
-    taskENTER_CRITICAL();
-    QueueHandle_t q = analogInputsQueue;
-    analogInputsQueue = NULL;
-    taskEXIT_CRITICAL();
-
-    // Step 3 & 4: Drain queue and delete (using captured handle)
-    if (q != NULL) {
-        AInPublicSampleList_t* pData;
-        while (xQueueReceive(q, &pData, 0) == pdTRUE) {
-            // Just drain — we're about to free the whole pool
-        }
-        vQueueDelete(q);
-    }
-
-    // Step 5: Free pool memory with proper synchronization.
-    // Take mutex as barrier if available; free unconditionally either way
-    // to prevent heap leaks if mutex creation failed during init.
-    if (poolMutex != NULL) {
-        xSemaphoreTake(poolMutex, portMAX_DELAY);
-    }
-    if (poolOwnsMemory) {
-        if (samplePoolBase != NULL) {
-            vPortFree(samplePoolBase);
-        }
-        if (nextFree != NULL) {
-            vPortFree(nextFree);
-        }
+    if (poolOwnsMemory && samplePoolBase != NULL) {
+        vPortFree(samplePoolBase);
     }
     samplePoolBase = NULL;
-    nextFree = NULL;
+    poolOwnsMemory = false;
     poolCapacity = 0;
     poolElementStride = 0;
-    freeHead = -1;
-    if (poolMutex != NULL) {
-        xSemaphoreGive(poolMutex);
-    }
-
-    queueSize = 0;
+    ResetRing();
 }
 
 bool AInSampleList_PushBack(const AInPublicSampleList_t* pData){
-    if (pData == NULL) {
+    // Only the producer's outstanding claim can be published.
+    if (pData == NULL || !poolActive || prodClaim == AINSAMPLE_NO_CLAIM ||
+        pData != SlotPtr(prodClaim)) {
         return false;
     }
 
-    // Atomically capture queue handle to prevent TOCTOU race with Destroy
-    taskENTER_CRITICAL();
-    QueueHandle_t q = analogInputsQueue;
-    taskEXIT_CRITICAL();
-
-    if (q == NULL) {
-        return false;
-    }
-
-    BaseType_t queueResult = xQueueSend(q, &pData, AINSAMPLE_QUEUE_TICKS_TO_WAIT);
-    return queueResult == pdTRUE;
+    AINSAMPLE_BARRIER();                 // sample contents before the publish
+    prodClaim = AINSAMPLE_NO_CLAIM;
+    prodSlot = NextSlot(prodSlot);
+    ringProduced = ringProduced + 1u;
+    return true;
 }
+
 bool AInSampleList_PopFront( AInPublicSampleList_t** ppData)
 {
-    if (ppData == NULL) {
+    if (ppData == NULL || !poolActive) {
         return false;
     }
 
-    // Atomically capture queue handle to prevent TOCTOU race with Destroy
-    taskENTER_CRITICAL();
-    QueueHandle_t q = analogInputsQueue;
-    taskEXIT_CRITICAL();
-
-    if (q == NULL) {
+    uint32_t produced = ringProduced;
+    AINSAMPLE_BARRIER();                 // counter before the slot contents
+    if (produced == ringPopped) {
         return false;
     }
-
-    BaseType_t queueResult = xQueueReceive(q, ppData, AINSAMPLE_QUEUE_TICKS_TO_WAIT);
-    return queueResult == pdTRUE;
+    *ppData = SlotPtr(popSlot);
+    popSlot = NextSlot(popSlot);
+    ringPopped = ringPopped + 1u;
+    return true;
 }
 
 bool AInSampleList_PeekFront(AInPublicSampleList_t** ppData)
 {
-    if (ppData == NULL) {
+    if (ppData == NULL || !poolActive) {
         return false;
     }
 
-    // Atomically capture queue handle to prevent TOCTOU race with Destroy
-    taskENTER_CRITICAL();
-    QueueHandle_t q = analogInputsQueue;
-    taskEXIT_CRITICAL();
-
-    if (q == NULL) {
+    uint32_t produced = ringProduced;
+    AINSAMPLE_BARRIER();
+    if (produced == ringPopped) {
         return false;
     }
-
-    BaseType_t queueResult = xQueuePeek(q, ppData, AINSAMPLE_QUEUE_TICKS_TO_WAIT);
-    return queueResult == pdTRUE;
+    *ppData = SlotPtr(popSlot);
+    return true;
 }
 
 size_t AInSampleList_Size()
 {
-    if (queueSize == 0) {
-        return 0;
-    }
-
-    // Atomically capture queue handle to prevent TOCTOU race with Destroy
-    taskENTER_CRITICAL();
-    QueueHandle_t q = analogInputsQueue;
-    taskEXIT_CRITICAL();
-
-    if (q == NULL) {
+    if (!poolActive) {
         return 0;
     }
+    return (size_t)(ringProduced - ringPopped);
+}
 
-    return (queueSize - uxQueueSpacesAvailable(q));
+uint32_t AInSampleList_PopCount(void)
+{
+    return ringPopped;
 }
 
 bool AInSampleList_IsEmpty()
 {
-    // Atomically capture queue handle to prevent TOCTOU race with Destroy
-    taskENTER_CRITICAL();
-    QueueHandle_t q = analogInputsQueue;
-    taskEXIT_CRITICAL();
-
-    if (q == NULL) {
-        return true;
-    }
-
-    AInPublicSampleList_t* pData;
-    BaseType_t queueResult = xQueuePeek(q, &pData, 0);
-    return queueResult != pdTRUE;
+    return !poolActive || (ringProduced == ringPopped);
 }
 
 
 // ============================================================================
-// Object Pool Implementation (dynamically allocated from heap)
+// Slot allocation
 // ============================================================================
 
 AInPublicSampleList_t* AInSampleList_AllocateFromPool() {
-    if (!poolActive || poolMutex == NULL) {
+    if (!poolActive || prodClaim != AINSAMPLE_NO_CLAIM) {
         return NULL;
     }
 
-    AInPublicSampleList_t* result = NULL;
-    xSemaphoreTake(poolMutex, portMAX_DELAY);
-
-    // O(1) allocation: pop from free list head (stride-based indexing)
-    if (freeHead >= 0 && samplePoolBase != NULL && poolElementStride > 0) {
-        int idx = freeHead;
-        freeHead = nextFree[idx];  // Move head to next free
-        result = (AInPublicSampleList_t*)(samplePoolBase + (size_t)idx * poolElementStride);
-        // Track usage high-water mark (atomic 32-bit RMW under mutex)
-        poolAllocCount++;
-        if (poolAllocCount > poolMaxAllocCount) {
-            poolMaxAllocCount = poolAllocCount;
-        }
-        // Clear entire element to ensure no stale data
-        memset(result, 0, poolElementStride);
+    uint32_t released = ringReleased;
+    AINSAMPLE_BARRIER();                 // consumer is done with the slot we reuse
+    uint32_t outstanding = ringProduced - released;
+    if (outstanding >= poolCapacity) {
+        return NULL;                     // every slot queued or held by the encoder
     }
 
-    xSemaphoreGive(poolMutex);
+    // High-water mark: producer is the only writer (ResetMaxUsed aside).
+    if (outstanding + 1u > poolMaxAllocCount) {
+        poolMaxAllocCount = outstanding + 1u;
+    }
 
+    AInPublicSampleList_t* result = SlotPtr(prodSlot);
+    // Clear entire element to ensure no stale data
+    memset(result, 0, poolElementStride);
+    prodClaim = prodSlot;
     return result;
 }
 
 void AInSampleList_FreeToPool(AInPublicSampleList_t* pSample) {
-    if (pSample == NULL || !poolActive || poolMutex == NULL ||
+    if (pSample == NULL || !poolActive ||
         samplePoolBase == NULL || poolElementStride == 0) {
         return;
     }
@@ -419,24 +318,26 @@ void AInSampleList_FreeToPool(AInPublicSampleList_t* pSample) {
         return;  // Not from our pool
     }
 
-    // O(1) deallocation: push to free list head.
-    // Guard against double-free: if poolAllocCount is already 0, returning
-    // early prevents free-list corruption (duplicate entries would cause the
-    // same slot to be handed out twice, leading to torn data). The counter
-    // check is inside the mutex so no TOCTOU race.
-    xSemaphoreTake(poolMutex, portMAX_DELAY);
-    if (poolAllocCount == 0) {
-        xSemaphoreGive(poolMutex);
+    // The two cases can't collide: a claim is slot `produced` taken while
+    // produced - released < capacity, and a slot the consumer still holds
+    // lies in [released, produced), so the two indices differ.
+    if ((uint32_t)index == prodClaim) {
+        prodClaim = AINSAMPLE_NO_CLAIM;  // producer dropping its unpublished claim
+        return;
+    }
+    if (ringPopped != ringReleased && (uint32_t)index == releaseSlot) {
+        AINSAMPLE_BARRIER();             // done reading the slot before handing it back
+        releaseSlot = NextSlot(releaseSlot);
+        ringReleased = ringReleased + 1u;
         return;
     }
-    poolAllocCount--;
-    nextFree[index] = freeHead;
-    freeHead = (int16_t)index;
-    xSemaphoreGive(poolMutex);
+    // Anything else is a double free or an out-of-order free: ignore it
+    // rather than hand a live slot out twice (torn data).
 }
 
 uint32_t AInSampleList_PoolInUse(void) {
-    return poolAllocCount;
+    uint32_t released = ringReleased;
+    return (ringProduced - released) + ((prodClaim != AINSAMPLE_NO_CLAIM) ? 1u : 0u);
 }
 
 uint32_t AInSampleList_PoolMaxUsed(void) {
@@ -444,7 +345,7 @@ uint32_t AInSampleList_PoolMaxUsed(void) {
 }
 
 void AInSampleList_PoolResetMaxUsed(void) {
-    poolMaxAllocCount = poolAllocCount;
+    poolMaxAllocCount = AInSampleList_PoolInUse();
 }
 
 size_t AInSampleList_PoolCapacity(void) {
@@ -109,12 +109,12 @@ extern "C" {
      * Used when no runtime override is configured (MemoryConfig.samplePoolCount = 0).
      *
      * Memory per sample depends on enabled channel count:
-     *   1ch: 14 bytes (12 data + 2 nextFree)
-     *   8ch: 42 bytes (40 data + 2 nextFree)
-     *  16ch: 74 bytes (72 data + 2 nextFree)
+     *   1ch: 12 bytes | 8ch: 40 bytes | 16ch: 72 bytes
+     * (the slots themselves are the queue -- no free-list or pointer-queue
+     * overhead per sample).
      *
-     * Default 1100 @ 16ch = ~81 KB (was 231 KB before compact pool).
-     * At 1ch, same 194KB pool yields ~14,000 samples.
+     * Default 1100 @ 16ch = ~79 KB (was 231 KB before compact pool).
+     * At 1ch, same 194KB pool yields ~16,000 samples (capped at MAX).
      */
 #define DEFAULT_AIN_SAMPLE_COUNT 1100
 #define MIN_AIN_SAMPLE_COUNT     100
@@ -122,41 +122,42 @@ extern "C" {
     ARRAYWRAPPERDEF(AInSampleArray, AInSample, MAX_AIN_CHANNEL);
 
     /**
-     * @brief Initializes the Analog Input Sample List queue.
+     * @brief Initializes the sample slot ring from the FreeRTOS heap.
      *
-     * This function initializes the queue with a maximum size.
+     * Fallback path only (StreamingBufferPool unavailable); slots are sized
+     * for all 16 channels.
      *
-     * @param maxSize Maximum number of items the queue can hold.
+     * @param maxSize Number of slots (pool depth == queue depth).
      */
     void AInSampleList_Initialize(size_t maxSize, bool dropOnOverflow);
 
     /**
      * @brief Initializes using externally-provided pool memory.
      *
-     * Like AInSampleList_Initialize but uses caller-provided memory for
-     * the sample pool and free-list arrays (e.g., from StreamingBufferPool).
-     * The FreeRTOS queue is still heap-allocated.
+     * Like AInSampleList_Initialize but uses caller-provided slot memory
+     * (StreamingBufferPool). Nothing is heap-allocated. Must only be called
+     * with streaming stopped -- the ring is emptied.
      *
-     * @param poolMem       Pre-allocated byte array for sample pool
-     * @param freeMem       Pre-allocated array of int16_t[maxSize]
-     * @param maxSize       Number of samples the arrays can hold
+     * @param poolMem       Pre-allocated byte array of maxSize * elementSize
+     * @param maxSize       Number of slots (pool depth == queue depth)
      * @param elementSize   Bytes per sample element (from AInSampleList_ElementSize)
      */
-    void AInSampleList_InitializeExternal(void* poolMem, int16_t* freeMem,
-                                           size_t maxSize, size_t elementSize);
+    void AInSampleList_InitializeExternal(void* poolMem, size_t maxSize,
+                                          size_t elementSize);
 
     /**
-     * @brief Destroys the Analog Input Sample List queue.
-     * 
-     * This function frees all items in the queue and deletes the queue.
+     * @brief Empties the ring and frees heap-owned slot memory.
+     *
+     * Streaming must be stopped.
      */
     void AInSampleList_Destroy(void);
 
     /**
-     * @brief Adds a new data sample to the queue.
-     * 
-     * This function adds a new data sample to the queue.
-     * 
+     * @brief Publishes the producer's allocated sample to the consumer.
+     *
+     * Producer side only. pData must be the slot returned by the last
+     * AInSampleList_AllocateFromPool; anything else is rejected.
+     *
      * @param pData Pointer to the data sample to be added.
      * @return True if the data was successfully added, false otherwise.
      */
@@ -190,6 +191,14 @@ extern "C" {
      */
     size_t AInSampleList_Size(void);
 
+    /**
+     * @brief Samples popped since the pool was last reset (wraps).
+     *
+     * Consumer-side counter: the difference across an encode is how many
+     * sample sets it consumed (a PB block takes several).
+     */
+    uint32_t AInSampleList_PopCount(void);
+
     /**
      * @brief Checks if the queue is empty.
      * 
@@ -200,8 +209,11 @@ extern "C" {
     /**
      * @brief Allocates a sample structure from the pre-allocated object pool.
      *
-     * Uses O(1) free list allocation to eliminate heap allocation overhead.
-     * The returned structure is zero-initialized.
+     * Producer side only, wait-free: claims the next slot in ring order if
+     * fewer than capacity samples are queued or held by the consumer. At most
+     * one claim may be outstanding -- publish it with PushBack or drop it with
+     * FreeToPool before allocating again. The returned structure is
+     * zero-initialized.
      *
      * @return Pointer to allocated sample, or NULL if pool is exhausted.
      */
@@ -210,8 +222,9 @@ extern "C" {
     /**
      * @brief Returns a sample structure to the object pool.
      *
-     * Uses O(1) free list deallocation to eliminate heap free overhead.
-     * Safe to call with NULL or non-pool pointers (will be ignored).
+     * Consumer side: returns the oldest popped sample (free in pop order).
+     * Producer side: drops the unpublished claim.
+     * Safe to call with NULL, non-pool or already-freed pointers (ignored).
      *
      * @param pSample Pointer to sample structure to return to pool.
      */
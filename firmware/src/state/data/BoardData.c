@@ -32,12 +32,11 @@ void InitializeBoardData(tBoardData* boardData) {
     // Use streaming buffer pool memory for sample pool (no heap fragmentation)
     {
         void* poolMem = NULL;
-        int16_t* freeMem = NULL;
         uint32_t count = 0;
         size_t elemSize = 0;
-        StreamingBufferPool_GetSamplePool(&poolMem, &freeMem, &count, &elemSize);
+        StreamingBufferPool_GetSamplePool(&poolMem, &count, &elemSize);
         if (poolMem != NULL && count > 0 && elemSize > 0) {
-            AInSampleList_InitializeExternal(poolMem, freeMem, count, elemSize);
+            AInSampleList_InitializeExternal(poolMem, count, elemSize);
         } else {
             // Fallback to heap allocation if pool not available
             AInSampleList_Initialize(DEFAULT_AIN_SAMPLE_COUNT, false);
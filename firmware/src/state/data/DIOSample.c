@@ -19,7 +19,6 @@ void DIOSampleList_Initialize(
     (void)dropOnOverflow;
 
     // Delete existing queue to avoid leaking the handle on re-init.
-    // Matches the pattern in AInSample.c.
     if (DIOQueue != NULL) {
         vQueueDelete(DIOQueue);
         DIOQueue = NULL;
@@ -34,7 +33,10 @@ void DIOSampleList_Destroy(DIOSampleList* list)
 {
     (void)list;
     
-    vQueueDelete( DIOQueue );
+    if (DIOQueue != NULL) {
+        vQueueDelete( DIOQueue );
+        DIOQueue = NULL;   // a later Initialize must not delete it again
+    }
 }
 
 bool DIOSampleList_PushBack(DIOSampleList* list, const DIOSample* data){
@@ -125,6 +125,14 @@ _Static_assert(sizeof(DEFAULT_NETWORK_HOST_NAME) <= WIFI_MANAGER_DNS_CLIENT_MAX_
         .VoltagePrecision = 4,  /* Initial default; overridden by board config at boot */ \
         .OnboardDiagEnabled = true, /* MODULE7 scans diag channels during streaming */ \
         .RawOutputMode = false, /* #158/#270: emit calibrated volts by default */ \
+        .PbDeltaKeyframeInterval = 0, /* absolute PB values; SYST:STR:DELTa enables */ \
+        .AdaptiveRate = false, /* static transport caps; SYST:STR:ADAPTive enables */ \
+        .DecimateFactor = 1, /* every tick is a sample; SYST:STR:DECimate enables */ \
+        .DecimateStages = 1, \
+        .DecimateExtraBits = 0, \
+        .CapturePre = 0, /* streaming, not capture; SYST:STR:CAPture enables */ \
+        .CapturePost = 0, \
+        .CaptureSources = 3, /* CAPTURE_SRC_ALL */ \
     }
 
 /**
@@ -162,6 +170,9 @@ _Static_assert(sizeof(DEFAULT_NETWORK_HOST_NAME) <= WIFI_MANAGER_DNS_CLIENT_MAX_
         .mode = SD_CARD_MANAGER_MODE_NONE, \
         .maxFileSizeBytes = SD_CARD_MANAGER_FAT32_SAFE_MAX_FILE_SIZE, \
         .minFreeBytes = 0,  /* #498: 0 = pre-start disk-full gate disabled */ \
+        .preallocBytes = 0, /* 0 = no preallocation (files grow cluster by cluster) */ \
+        .container = false, /* plain stream files; 1 = indexed blocks (SD:CONTainer) */ \
+        .readSelect = SD_CARD_READ_ALL, \
     }
 
 /**
@@ -19,6 +19,13 @@ extern "C" {
          * Appended as a new value rather than changing 2, so existing clients
          * are untouched; opt-in via SYST:STR:FORmat 3. */
         Streaming_CsvCompact=3,
+        /* Protobuf with N consecutive ticks per message: base timestamp +
+         * period + channel-major packed values, optionally delta coded per
+         * channel (Nanopb_EncodeStreamingBlock). Per-sample framing is most of
+         * the bytes of a low-channel PB stream; a block pays it once. New
+         * value so existing PB clients are untouched; opt-in via
+         * SYST:STR:FORmat 4. */
+        Streaming_ProtoBufferBlock=4,
         /* NOT an encoding -- the count, for bounds checks. Keep it last, and
          * add new encodings ABOVE it so it stays one past the end.
          *
@@ -41,7 +48,19 @@ extern "C" {
         StreamingInterface_WiFi = 1,
         StreamingInterface_SD = 2,
         StreamingInterface_UsbAndSd = 3,  // USB+SD concurrent (WiFi excluded — SPI bus conflict with SD)
+        /* WiFi, but as sequence-numbered UDP datagrams to a host set with
+         * SYST:COMM:LAN:UDPStream:DESTination (services/wifi_services/
+         * wifi_udp_stream.h). The TCP console stays up for SCPI. Same radio
+         * and SPI bus as StreamingInterface_WiFi, so everything that asks
+         * "is WiFi carrying the stream" goes through StreamingInterface_IsWiFi. */
+        StreamingInterface_WiFiUdp = 4,
     } StreamingInterface;
+
+    /** True for either WiFi transport (TCP or UDP): the WINC is on the SPI bus. */
+    static inline bool StreamingInterface_IsWiFi(StreamingInterface i)
+    {
+        return i == StreamingInterface_WiFi || i == StreamingInterface_WiFiUdp;
+    }
     
     /**
      * Contains the board configuration for the streaming timer
@@ -154,6 +173,59 @@ extern "C" {
          */
         bool RawOutputMode;
 
+        /**
+         * Delta/zigzag compression of the per-sample ProtoBuffer path. 0 (the
+         * default) keeps every message absolute. K > 0 lets the encoder send
+         * a message's channel values as zigzag differences from the previous
+         * message (field analog_in_data_delta) and forces an absolute
+         * keyframe at least every K messages, on a channel-layout change, at
+         * SD file rotation and after any transport drop. Only applies when
+         * Encoding is Streaming_ProtoBuffer; latched at START. Controlled via
+         * SYST:STR:DELTa. Runtime-only, resets on reboot.
+         */
+        uint16_t PbDeltaKeyframeInterval;
+
+        /**
+         * Adaptive rate control. When true the WiFi transport cap is relaxed
+         * to 3/2 of its static worst-night fit, and during a session only
+         * every d-th timer tick becomes a sample, with d chosen by an AIMD
+         * controller from pool fill, sample loss and transport drops
+         * (Util/RateControl.h). PB streams carry a metadata message with the
+         * new rate before the first sample at it. Latched at START.
+         * Controlled via SYST:STR:ADAPTive. Runtime-only, resets on reboot.
+         */
+        bool AdaptiveRate;
+
+        /**
+         * On-device decimation (Util/Decimator.h). DecimateFactor N > 1 runs
+         * every timer tick through a DecimateStages-stage CIC filter (1 =
+         * boxcar average) and streams one filtered sample per N ticks, so
+         * the stream goes out at Frequency/N and the transport caps bind at
+         * N times the tick rate. DecimateExtraBits scales the values by
+         * 2^bits to carry the resolution the averaging adds; it applies to
+         * PB and raw-mode sessions only (the volt encoders get native
+         * codes), and is reported with them (Streaming_CodeScaleBits).
+         * Latched at START. Controlled via SYST:STR:DECimate.
+         * Runtime-only, resets on reboot.
+         */
+        uint16_t DecimateFactor;
+        uint8_t DecimateStages;
+        uint8_t DecimateExtraBits;
+
+        /**
+         * Pre/post-trigger burst capture (Util/CaptureRing.h). CapturePost
+         * > 0 makes the next session a capture: every tick goes to a RAM
+         * ring instead of the transport until a trigger from CaptureSources
+         * (CAPTURE_SRC_*: ADC threshold trip, DIO edge) has been followed by
+         * CapturePost frames, CapturePre of them before it; the capture is
+         * then streamed out on the active interface. The transport and SD
+         * rate caps do not apply. Latched at START. Controlled via
+         * SYST:STR:CAPture. Runtime-only, resets on reboot.
+         */
+        uint32_t CapturePre;
+        uint32_t CapturePost;
+        uint8_t CaptureSources;
+
     } StreamingRuntimeConfig;
 
     /**
@@ -0,0 +1,259 @@
+/* ==========================================================================
+ * host_board.c — accessor implementations for the synthetic host board.
+ * See host_board.h.
+ *
+ * Every function here stands in for a firmware symbol the linked modules
+ * reference; the signature is the firmware's, the body is the minimum that
+ * keeps the encoders on their real paths. Where the firmware computes a
+ * value (ADC_ConvertToVoltageByIndex) the formula is copied from the source
+ * it mirrors and cited, so a drift between the two is visible in review.
+ * ========================================================================== */
+#include <string.h>
+#include <stdio.h>
+
+#include "host_board.h"
+
+#include "services/streaming.h"
+#include "services/csv_encoder.h"
+#include "services/JSON_Encoder.h"
+#include "HAL/ADC.h"
+#include "HAL/ADC/AD7609.h"
+
+static tBoardConfig        gHostConfig;
+static tBoardRuntimeConfig gHostRuntime;
+static tBoardData          gHostData;
+static AInChannelMapping   gHostMapping;
+static uint32_t            gHostTickHz;
+
+static const char* const kHostCsvFirst[MAX_AIN_PUBLIC_CHANNELS] = {
+    "ain0_ts,ain0_val",   "ain1_ts,ain1_val",   "ain2_ts,ain2_val",   "ain3_ts,ain3_val",
+    "ain4_ts,ain4_val",   "ain5_ts,ain5_val",   "ain6_ts,ain6_val",   "ain7_ts,ain7_val",
+    "ain8_ts,ain8_val",   "ain9_ts,ain9_val",   "ain10_ts,ain10_val", "ain11_ts,ain11_val",
+    "ain12_ts,ain12_val", "ain13_ts,ain13_val", "ain14_ts,ain14_val", "ain15_ts,ain15_val",
+};
+static const char* const kHostCsvSubsequent[MAX_AIN_PUBLIC_CHANNELS] = {
+    ",ain0_ts,ain0_val",   ",ain1_ts,ain1_val",   ",ain2_ts,ain2_val",   ",ain3_ts,ain3_val",
+    ",ain4_ts,ain4_val",   ",ain5_ts,ain5_val",   ",ain6_ts,ain6_val",   ",ain7_ts,ain7_val",
+    ",ain8_ts,ain8_val",   ",ain9_ts,ain9_val",   ",ain10_ts,ain10_val", ",ain11_ts,ain11_val",
+    ",ain12_ts,ain12_val", ",ain13_ts,ain13_val", ",ain14_ts,ain14_val", ",ain15_ts,ain15_val",
+};
+
+void HostBoard_Init(const HostBoardSetup* setup)
+{
+    memset(&gHostConfig, 0, sizeof(gHostConfig));
+    memset(&gHostRuntime, 0, sizeof(gHostRuntime));
+    memset(&gHostMapping, 0, sizeof(gHostMapping));
+
+    uint8_t channels = setup->channels;
+    if (channels > MAX_AIN_PUBLIC_CHANNELS) channels = MAX_AIN_PUBLIC_CHANNELS;
+    bool nq3 = (setup->variant == 3);
+
+    gHostConfig.BoardVariant      = setup->variant;
+    gHostConfig.boardSerialNumber = 0x0123456789ABCDEFull;
+    gHostConfig.csvChannelHeadersFirst      = kHostCsvFirst;
+    gHostConfig.csvChannelHeadersSubsequent = kHostCsvSubsequent;
+    gHostConfig.DIOChannels.Size  = 16;
+
+    /* Module 0 is always the MC12b (AIn_MC12bADC == 0); NQ3 adds the AD7609
+     * at index AIn_AD7609, which is where AD7609_ConvertToVoltage looks. */
+    gHostConfig.AInModules.Size = nq3 ? 2 : 1;
+    gHostConfig.AInModules.Data[AIn_MC12bADC].Type = AIn_MC12bADC;
+    gHostConfig.AInModules.Data[AIn_MC12bADC].Config.MC12b.Resolution = 4096;
+    gHostRuntime.AInModules.Size = gHostConfig.AInModules.Size;
+    gHostRuntime.AInModules.Data[AIn_MC12bADC].IsEnabled = true;
+    gHostRuntime.AInModules.Data[AIn_MC12bADC].Range = 5.0;
+    if (nq3) {
+        gHostConfig.AInModules.Data[AIn_AD7609].Type = AIn_AD7609;
+        gHostConfig.AInModules.Data[AIn_AD7609].Config.AD7609.Resolution = 262144;
+        gHostRuntime.AInModules.Data[AIn_AD7609].IsEnabled = true;
+        gHostRuntime.AInModules.Data[AIn_AD7609].Range = 10.0;
+    }
+
+    gHostConfig.AInChannels.Size  = MAX_AIN_PUBLIC_CHANNELS;
+    gHostRuntime.AInChannels.Size = MAX_AIN_PUBLIC_CHANNELS;
+    for (uint8_t i = 0; i < MAX_AIN_PUBLIC_CHANNELS; i++) {
+        AInChannel* ch = &gHostConfig.AInChannels.Data[i];
+        ch->DaqifiAdcChannelId = i;
+        if (nq3) {
+            ch->Type = AIn_AD7609;
+            ch->Config.AD7609.ChannelNumber = (uint8_t)(i & 7u);
+            ch->Config.AD7609.IsPublic = true;
+        } else {
+            ch->Type = AIn_MC12bADC;
+            ch->Config.MC12b.IsPublic = true;
+            ch->Config.MC12b.InternalScale = 1.0;
+            ch->Config.MC12b.ChannelType = MC12B_CHANNEL_TYPE_DEDICATED;
+        }
+        gHostRuntime.AInChannels.Data[i].IsEnabled = (i < channels);
+        gHostRuntime.AInChannels.Data[i].CalM = 1.0;
+        gHostRuntime.AInChannels.Data[i].CalB = 0.0;
+    }
+
+    gHostMapping.count = channels;
+    for (uint8_t j = 0; j < channels; j++) {
+        gHostMapping.channelIds[j]    = j;
+        gHostMapping.configIndices[j] = j;
+    }
+
+    gHostRuntime.DIOChannels.Size = 16;
+    gHostRuntime.DIOGlobalEnable  = setup->dioEnabled;
+    gHostRuntime.StreamingConfig.IsEnabled        = true;
+    gHostRuntime.StreamingConfig.Encoding         = setup->encoding;
+    gHostRuntime.StreamingConfig.ActiveInterface  = StreamingInterface_USB;
+    gHostRuntime.StreamingConfig.VoltagePrecision = setup->voltagePrecision;
+    gHostRuntime.StreamingConfig.RawOutputMode    = setup->rawMode;
+
+    gHostTickHz = setup->tickHz ? setup->tickHz : 1000000u;
+
+    csv_ResetEncoder();
+    json_ResetEncoder();
+}
+
+tBoardData* HostBoard_Data(void)
+{
+    return &gHostData;
+}
+
+void HostBoard_SetCal(uint8_t channel, double calM, double calB)
+{
+    if (channel >= MAX_AIN_PUBLIC_CHANNELS) return;
+    gHostRuntime.AInChannels.Data[channel].CalM = calM;
+    gHostRuntime.AInChannels.Data[channel].CalB = calB;
+}
+
+void HostBoard_SetRange(double range)
+{
+    AInType module = (gHostConfig.BoardVariant == 3) ? AIn_AD7609 : AIn_MC12bADC;
+    gHostRuntime.AInModules.Data[module].Range = range;
+}
+
+/* -------------------------------------------------------------------------
+ * Firmware accessors
+ * ------------------------------------------------------------------------- */
+void* BoardConfig_Get(enum eBoardParameter parameter, uint8_t index)
+{
+    (void)index;
+    switch (parameter) {
+        case BOARDCONFIG_ALL_CONFIG:    return &gHostConfig;
+        case BOARDCONFIG_VARIANT:       return &gHostConfig.BoardVariant;
+        case BOARDCONFIG_SERIAL_NUMBER: return &gHostConfig.boardSerialNumber;
+        case BOARDCONFIG_AIN_MODULE:    return &gHostConfig.AInModules;
+        case BOARDCONFIG_AIN_CHANNELS:  return &gHostConfig.AInChannels;
+        case BOARDCONFIG_DIO_CHANNEL:   return &gHostConfig.DIOChannels;
+        default:                        return NULL;
+    }
+}
+
+void* BoardRunTimeConfig_Get(enum eBoardRunTimeParameter parameter)
+{
+    switch (parameter) {
+        case BOARDRUNTIMECONFIG_ALL_CONFIG:        return &gHostRuntime;
+        case BOARDRUNTIMECONFIG_DIO_CHANNELS:      return &gHostRuntime.DIOChannels;
+        case BOARDRUNTIMECONFIG_DIO_GLOBAL_ENABLE: return &gHostRuntime.DIOGlobalEnable;
+        case BOARDRUNTIMECONFIG_AIN_MODULES:       return &gHostRuntime.AInModules;
+        case BOARDRUNTIMECONFIG_AIN_CHANNELS:      return &gHostRuntime.AInChannels;
+        case BOARDRUNTIME_STREAMING_CONFIGURATION: return &gHostRuntime.StreamingConfig;
+        case BOARDRUNTIME_WIFI_SETTINGS:           return &gHostRuntime.wifiSettings;
+        case BOARDRUNTIME_USB_SETTINGS:            return &gHostRuntime.usbSettings;
+        case BOARDRUNTIME_SD_CARD_SETTINGS:        return &gHostRuntime.sdCardConfig;
+        case BOARDRUNTIME_MEMORY_CONFIG:           return &gHostRuntime.memoryConfig;
+        default:                                   return NULL;
+    }
+}
+
+const AInChannelMapping* Streaming_GetChannelMapping(void)
+{
+    return &gHostMapping;
+}
+
+uint32_t TimerApi_FrequencyGet(uint8_t index)
+{
+    (void)index;
+    return gHostTickHz;
+}
+
+/* Mirrors ADC_ConvertToVoltageByIndex (HAL/ADC.c) dispatching to
+ * MC12b_ConvertToVoltage (HAL/ADC/MC12bADC.c) and AD7609_ConvertToVoltage
+ * (HAL/ADC/AD7609.c). Same operand order, so the doubles round identically. */
+double ADC_ConvertToVoltageByIndex(size_t channelIndex, uint32_t rawValue)
+{
+    if (channelIndex >= gHostConfig.AInChannels.Size) {
+        return 0.0;
+    }
+    const AInChannel* ch = &gHostConfig.AInChannels.Data[channelIndex];
+    const AInRuntimeConfig* rt = &gHostRuntime.AInChannels.Data[channelIndex];
+
+    if (ch->Type == AIn_MC12bADC) {
+        double range = gHostRuntime.AInModules.Data[AIn_MC12bADC].Range;
+        double scale = ch->Config.MC12b.InternalScale;
+        double CalM  = rt->CalM;
+        return (range * scale * CalM * (double)rawValue) /
+                (gHostConfig.AInModules.Data[AIn_MC12bADC].Config.MC12b.Resolution) + rt->CalB;
+    }
+    if (ch->Type == AIn_AD7609) {
+        double fullScaleVoltage = gHostRuntime.AInModules.Data[AIn_AD7609].Range;
+        const int32_t maxCode = AD7609_MAX_VALUE;
+        int32_t signedValue = (int32_t)(rawValue & (AD7609_MAX_VALUE | AD7609_SIGN_BIT));
+        if (signedValue & AD7609_SIGN_BIT) {
+            signedValue |= AD7609_SIGN_EXTEND;
+        }
+        return ((double)signedValue / (double)maxCode) * fullScaleVoltage;
+    }
+    return 0.0;
+}
+
+/* Mirrors ADC_GetLinearConversionByIndex (HAL/ADC.c) dispatching to
+ * MC12b_GetLinearConversion (HAL/ADC/MC12bADC.c) and
+ * AD7609_GetLinearConversion (HAL/ADC/AD7609.c). */
+bool ADC_GetLinearConversionByIndex(size_t channelIndex, ADC_LinearConversion* pOut)
+{
+    if (channelIndex >= gHostConfig.AInChannels.Size) {
+        return false;
+    }
+    const AInChannel* ch = &gHostConfig.AInChannels.Data[channelIndex];
+    const AInRuntimeConfig* rt = &gHostRuntime.AInChannels.Data[channelIndex];
+
+    if (ch->Type == AIn_MC12bADC) {
+        double range = gHostRuntime.AInModules.Data[AIn_MC12bADC].Range;
+        double scale = ch->Config.MC12b.InternalScale;
+        double CalM  = rt->CalM;
+        uint32_t resolution = gHostConfig.AInModules.Data[AIn_MC12bADC].Config.MC12b.Resolution;
+        pOut->Gain = (range * scale * CalM) / resolution;
+        pOut->Offset = rt->CalB;
+        pOut->CodeMax = resolution - 1u;
+        pOut->SignBits = 0;
+        return true;
+    }
+    if (ch->Type == AIn_AD7609) {
+        pOut->Gain = gHostRuntime.AInModules.Data[AIn_AD7609].Range / (double)AD7609_MAX_VALUE;
+        pOut->Offset = 0.0;
+        pOut->CodeMax = AD7609_SIGN_BIT;
+        pOut->SignBits = 18;
+        return true;
+    }
+    return false;
+}
+
+/* Timebase helpers used by the metadata (non-streaming) PB fields. The host
+ * board runs one fixed rate, so these are constants. */
+bool Streaming_IsRateConfigured(void) { return true; }
+bool Streaming_IsClipping(void) { return false; }
+uint32_t Streaming_TimestampTicksPerSample(uint32_t clockPeriod) { return clockPeriod; }
+uint32_t Streaming_ActualRateMilliHz(uint32_t clockPeriod)
+{
+    return clockPeriod ? (uint32_t)(((uint64_t)gHostTickHz * 1000u) / clockPeriod) : 0u;
+}
+/* No adaptive rate on the host: nothing is decimated, so nothing is stamped. */
+bool Streaming_RateStampDue(uint32_t ts) { (void)ts; return false; }
+void Streaming_RateStampDone(bool written) { (void)written; }
+uint32_t Streaming_RateStampDivisor(void) { return 1u; }
+uint32_t Streaming_CodeScaleBits(void) { return 0u; }
+
+/* Referenced only by Nanopb_Encode's device-info fields. */
+const char* daqifi_settings_GetFriendlyName(void) { return "host"; }
+UsbCdcData_t* UsbCdc_GetSettings(void) { return &gHostRuntime.usbSettings; }
+wifi_tcp_server_context_t* wifi_manager_GetTcpServerContext(void)
+{
+    static wifi_tcp_server_context_t ctx;
+    return &ctx;
+}
@@ -0,0 +1,53 @@
+/* ==========================================================================
+ * host_board.h — synthetic board for linking the REAL streaming pipeline on
+ * the PC host.
+ *
+ * The encoders (NanoPB_Encoder.c, csv_encoder.c, JSON_Encoder.c) and the
+ * batch step (streaming_encode.c) read the board through a handful of
+ * accessors -- BoardConfig_Get, BoardRunTimeConfig_Get,
+ * Streaming_GetChannelMapping, ADC_ConvertToVoltageByIndex,
+ * ADC_GetLinearConversionByIndex, TimerApi_... .
+ * On target those are backed by BoardConfig.c / ADC.c / streaming.c, which
+ * drag in the whole HAL. host_board.c implements the same accessors over
+ * plain static structs that a test can configure in one call, so the code
+ * under test is byte-for-byte the firmware's and only the board is fake.
+ *
+ * The fake board follows the shipped variants where it matters to the
+ * encoders: NQ1 is a 12-bit unipolar MC12b (Resolution 4096, Range 5.0 V),
+ * NQ3 an 18-bit bipolar AD7609 (+/-10 V). Channel i of the session is board
+ * channel i, all public.
+ * ========================================================================== */
+#ifndef HOST_BOARD_H
+#define HOST_BOARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "state/data/BoardData.h"
+#include "state/board/BoardConfig.h"
+#include "state/runtime/BoardRuntimeConfig.h"
+
+typedef struct {
+    uint8_t           variant;          /* 1 = NQ1 (MC12b), 3 = NQ3 (AD7609) */
+    uint8_t           channels;         /* enabled public channels, 1..16 */
+    StreamingEncoding encoding;
+    uint8_t           voltagePrecision; /* CSV/JSON: 0 = integer mV */
+    bool              rawMode;          /* CSV/JSON: emit raw codes */
+    bool              dioEnabled;       /* DIO global enable */
+    uint32_t          tickHz;           /* timestamp timer frequency */
+} HostBoardSetup;
+
+/* (Re)configure the fake board and reset the encoders' per-session state
+ * (CSV/JSON header-sent flags). */
+void HostBoard_Init(const HostBoardSetup* setup);
+
+/* The tBoardData the encoders receive (DIO sample list lives here). */
+tBoardData* HostBoard_Data(void);
+
+/* Per-channel calibration override (defaults: CalM 1.0, CalB 0.0). */
+void HostBoard_SetCal(uint8_t channel, double calM, double calB);
+
+/* Module range override for the variant's ADC (defaults: NQ1 5.0, NQ3 10.0). */
+void HostBoard_SetRange(double range);
+
+#endif /* HOST_BOARD_H */
@@ -0,0 +1,245 @@
+/* ==========================================================================
+ * pb_block_decode.c — see pb_block_decode.h.
+ * ========================================================================== */
+#include "pb_block_decode.h"
+
+#include <string.h>
+
+#define WT_VARINT 0u
+#define WT_64BIT  1u
+#define WT_LEN    2u
+#define WT_32BIT  5u
+
+/* DaqifiOutMessage field numbers used by the streaming formats. */
+#define F_TIMESTAMP     1u
+#define F_ANALOG_IN     2u
+#define F_DIGITAL       5u
+#define F_BLOCK_PERIOD  12u
+#define F_BLOCK_COUNT   13u
+#define F_BLOCK_ANALOG  14u
+#define F_BLOCK_DELTA   15u
+#define F_DIGITAL_DIR   37u
+#define F_ANALOG_DELTA  73u
+
+/* Wide enough for the largest block the firmware emits (1024 bytes of
+ * one-byte varints) with room to spare. */
+#define MAX_VALUES 2048u
+
+static bool get_varint(const uint8_t** p, const uint8_t* end, uint64_t* out)
+{
+    uint64_t v = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (*p >= end) return false;
+        uint8_t b = *(*p)++;
+        v |= (uint64_t)(b & 0x7Fu) << shift;
+        if ((b & 0x80u) == 0) {
+            *out = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+static int32_t unzigzag(uint64_t v)
+{
+    uint32_t u = (uint32_t)v;
+    return (int32_t)((u >> 1) ^ (0u - (u & 1u)));
+}
+
+/* Appends one sint32 (varint wire type) or a packed run (length wire type). */
+static bool get_sint32s(const uint8_t** p, const uint8_t* end, uint32_t wt,
+                        int32_t* vals, size_t* n)
+{
+    uint64_t v;
+    if (wt == WT_VARINT) {
+        if (!get_varint(p, end, &v) || *n >= MAX_VALUES) return false;
+        vals[(*n)++] = unzigzag(v);
+        return true;
+    }
+    if (wt != WT_LEN || !get_varint(p, end, &v) || v > (uint64_t)(end - *p)) {
+        return false;
+    }
+    const uint8_t* stop = *p + v;
+    while (*p < stop) {
+        if (!get_varint(p, stop, &v) || *n >= MAX_VALUES) return false;
+        vals[(*n)++] = unzigzag(v);
+    }
+    return true;
+}
+
+static bool skip_field(const uint8_t** p, const uint8_t* end, uint32_t wt)
+{
+    uint64_t v;
+    switch (wt) {
+        case WT_VARINT: return get_varint(p, end, &v);
+        case WT_64BIT:  if (end - *p < 8) return false; *p += 8; return true;
+        case WT_32BIT:  if (end - *p < 4) return false; *p += 4; return true;
+        case WT_LEN:
+            if (!get_varint(p, end, &v) || v > (uint64_t)(end - *p)) return false;
+            *p += v;
+            return true;
+        default:        return false;
+    }
+}
+
+/* bytes field of at most 2 bytes (digital_data / digital_port_dir). */
+static bool get_bytes2(const uint8_t** p, const uint8_t* end, uint32_t wt,
+                       uint8_t dst[2], bool* has)
+{
+    uint64_t v;
+    if (wt != WT_LEN || !get_varint(p, end, &v) || v > 2 || v > (uint64_t)(end - *p)) {
+        return false;
+    }
+    dst[0] = dst[1] = 0;
+    memcpy(dst, *p, (size_t)v);
+    *p += v;
+    *has = (v > 0);
+    return true;
+}
+
+static void note_prev(PbDecodeState* st, const PbTick* t)
+{
+    if (st != NULL && t->count > 0) {
+        st->havePrev = true;
+        st->count = t->count;
+        memcpy(st->prev, t->values, t->count * sizeof(t->values[0]));
+    }
+}
+
+bool PbDecode_Message(PbDecodeState* st, const uint8_t* msg, size_t len,
+                      PbTick* out, size_t maxTicks, size_t* nTicks)
+{
+    static int32_t ain[MAX_VALUES];
+    static int32_t block[MAX_VALUES];
+    static int32_t delta[MAX_VALUES];
+    size_t nAin = 0, nBlock = 0, nDelta = 0;
+    uint32_t ts = 0, period = 0, deltaRows = 0;
+    uint64_t count = 0;
+    bool isBlock = false;
+    PbTick first;
+    memset(&first, 0, sizeof(first));
+
+    const uint8_t* p = msg;
+    const uint8_t* end = msg + len;
+    while (p < end) {
+        uint64_t key, v;
+        if (!get_varint(&p, end, &key)) return false;
+        uint32_t field = (uint32_t)(key >> 3);
+        uint32_t wt = (uint32_t)(key & 7u);
+        bool ok;
+        switch (field) {
+            case F_TIMESTAMP:
+                ok = (wt == WT_VARINT) && get_varint(&p, end, &v);
+                ts = (uint32_t)v;
+                break;
+            case F_BLOCK_PERIOD:
+                ok = (wt == WT_VARINT) && get_varint(&p, end, &v);
+                period = (uint32_t)v;
+                break;
+            case F_BLOCK_COUNT:
+                ok = (wt == WT_VARINT) && get_varint(&p, end, &count);
+                isBlock = true;
+                break;
+            case F_BLOCK_DELTA:
+                ok = (wt == WT_VARINT) && get_varint(&p, end, &v);
+                deltaRows = (uint32_t)v;
+                break;
+            case F_ANALOG_IN:
+                ok = get_sint32s(&p, end, wt, ain, &nAin);
+                break;
+            case F_BLOCK_ANALOG:
+                ok = get_sint32s(&p, end, wt, block, &nBlock);
+                break;
+            case F_ANALOG_DELTA:
+                ok = get_sint32s(&p, end, wt, delta, &nDelta);
+                break;
+            case F_DIGITAL:
+                ok = get_bytes2(&p, end, wt, first.dio, &first.hasDio);
+                break;
+            case F_DIGITAL_DIR:
+                ok = get_bytes2(&p, end, wt, first.dir, &first.hasDir);
+                break;
+            default:
+                ok = skip_field(&p, end, wt);
+                break;
+        }
+        if (!ok) return false;
+    }
+
+    if (!isBlock) {
+        if (maxTicks < 1 || nAin > PB_DECODE_MAX_CHANNELS) return false;
+        first.timestamp = ts;
+        if (nDelta > 0) {
+            if (nAin > 0 || st == NULL || !st->havePrev || st->count != nDelta) {
+                return false;
+            }
+            first.count = nDelta;
+            first.isDelta = true;
+            for (size_t i = 0; i < nDelta; i++) {
+                first.values[i] = (int32_t)((uint32_t)st->prev[i] + (uint32_t)delta[i]);
+            }
+        } else {
+            first.count = nAin;
+            memcpy(first.values, ain, nAin * sizeof(ain[0]));
+        }
+        out[0] = first;
+        note_prev(st, &out[0]);
+        *nTicks = 1;
+        return true;
+    }
+
+    if (count == 0 || count > maxTicks || (nBlock % count) != 0) return false;
+    size_t rows = nBlock / (size_t)count;
+    if (rows > PB_DECODE_MAX_CHANNELS) return false;
+    for (size_t k = 0; k < count; k++) {
+        PbTick* t = &out[k];
+        memset(t, 0, sizeof(*t));
+        t->timestamp = ts + (uint32_t)k * period;
+        t->count = rows;
+    }
+    out[0].hasDio = first.hasDio;
+    memcpy(out[0].dio, first.dio, sizeof(first.dio));
+    out[0].hasDir = first.hasDir;
+    memcpy(out[0].dir, first.dir, sizeof(first.dir));
+    for (size_t r = 0; r < rows; r++) {
+        bool delta = (deltaRows >> r) & 1u;
+        uint32_t acc = 0;
+        for (size_t k = 0; k < count; k++) {
+            int32_t v = block[r * (size_t)count + k];
+            acc = delta ? acc + (uint32_t)v : (uint32_t)v;
+            out[k].values[r] = (int32_t)acc;
+        }
+    }
+    note_prev(st, &out[count - 1]);
+    *nTicks = (size_t)count;
+    return true;
+}
+
+bool PbDecode_Stream(PbDecodeState* st, const uint8_t* buf, size_t len, size_t* consumed,
+                     PbTick* out, size_t maxTicks, size_t* nTicks)
+{
+    const uint8_t* p = buf;
+    const uint8_t* end = buf + len;
+    *nTicks = 0;
+    while (p < end) {
+        const uint8_t* msgStart = p;
+        uint64_t msgLen;
+        if (!get_varint(&p, end, &msgLen)) {
+            p = msgStart;                    /* incomplete prefix */
+            break;
+        }
+        if (msgLen > (uint64_t)(end - p)) {
+            p = msgStart;                    /* incomplete body */
+            break;
+        }
+        size_t n = 0;
+        if (!PbDecode_Message(st, p, (size_t)msgLen, out + *nTicks, maxTicks - *nTicks, &n)) {
+            *consumed = (size_t)(msgStart - buf);
+            return false;
+        }
+        *nTicks += n;
+        p += msgLen;
+    }
+    *consumed = (size_t)(p - buf);
+    return true;
+}
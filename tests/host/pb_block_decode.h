@@ -0,0 +1,61 @@
+/* ==========================================================================
+ * pb_block_decode.h — reference decoder for the streaming protobuf wire
+ * format, per-sample AND block (SYST:STR:FORmat 0 / 4).
+ *
+ * Written from DaqifiOutMessage.proto, not from the encoder: it is a plain
+ * protobuf wire parser (fields in any order, unknown fields skipped, packed
+ * or unpacked repeated values, last-wins scalars) that turns each
+ * length-delimited DaqifiOutMessage back into the ticks it carries. A
+ * message with block_sample_count (field 13) is a block: tick k is stamped
+ * msg_time_stamp + k*block_period_ticks, and analog_in_block (field 14) holds
+ * block_sample_count values per channel, channel-major, with the rows flagged
+ * in analog_in_block_delta (field 15) delta coded. Any other message is one
+ * tick of analog_in_data (field 2) or, in a SYST:STR:DELTa session, of
+ * analog_in_data_delta (field 73): differences from the previous tick that
+ * carried analog values, which a PbDecodeState tracks across messages. DIO
+ * (fields 5 / 37) belongs to the message's first tick.
+ *
+ * Clients port this; the tests use it to round-trip the firmware encoder.
+ * ========================================================================== */
+#ifndef PB_BLOCK_DECODE_H
+#define PB_BLOCK_DECODE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PB_DECODE_MAX_CHANNELS 16u
+
+typedef struct {
+    uint32_t timestamp;
+    size_t   count;                          /* analog values in this tick */
+    int32_t  values[PB_DECODE_MAX_CHANNELS];
+    bool     isDelta;                        /* values came from field 73 */
+    bool     hasDio;
+    uint8_t  dio[2];
+    bool     hasDir;
+    uint8_t  dir[2];
+} PbTick;
+
+/* Delta chain across messages: the last decoded analog tick. Zero it before
+ * the first message of a stream (or after a gap); a delta message that
+ * arrives with no compatible reference fails to decode. */
+typedef struct {
+    bool     havePrev;
+    size_t   count;
+    int32_t  prev[PB_DECODE_MAX_CHANNELS];
+} PbDecodeState;
+
+/* Decode one DaqifiOutMessage body (no length prefix) into out[0..*nTicks).
+ * Returns false on a malformed message, more than maxTicks ticks, or a delta
+ * message @p st can't resolve (NULL @p st rejects every delta message). */
+bool PbDecode_Message(PbDecodeState* st, const uint8_t* msg, size_t len,
+                      PbTick* out, size_t maxTicks, size_t* nTicks);
+
+/* Decode a concatenation of length-delimited messages. Stops at the first
+ * incomplete trailing message; *consumed says how far it got. Returns false
+ * on a malformed message or if out[] fills up. */
+bool PbDecode_Stream(PbDecodeState* st, const uint8_t* buf, size_t len, size_t* consumed,
+                     PbTick* out, size_t maxTicks, size_t* nTicks);
+
+#endif /* PB_BLOCK_DECODE_H */
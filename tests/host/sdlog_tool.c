@@ -0,0 +1,273 @@
+/* ==========================================================================
+ * sdlog_tool.c — host reader / indexer for container-mode SD logs
+ * (SYST:STOR:SD:CONTainer 1, firmware/src/Util/SdLogContainer.h).
+ *
+ * Built on the firmware's own SdLogContainer.c, so the tool and the device
+ * agree on the format by construction.
+ *
+ *   info FILE                 check every block's CRC, print the block mix and
+ *                             the trailing index; exit 1 on a bad block
+ *   cat FILE [FIRST [COUNT]]  write the payload of blocks FIRST..FIRST+COUNT-1
+ *                             to stdout, starting at the first record, so the
+ *                             output is the plain CSV / JSON / PB stream the
+ *                             log would have held outside container mode
+ *                             (also works on what SD:GET:BLOCks / GET:TIMe
+ *                             returned)
+ *   time FILE T1 T2           print the block range holding ticks T1..T2
+ *                             after the file's first record (what SD:GET:TIMe
+ *                             resolves on the device), and the trailer reads
+ *                             it took
+ *   reindex FILE              for a log cut short (power loss, card pulled):
+ *                             drop the torn tail block and append the index
+ *                             block the firmware would have written at close
+ *
+ * Usage: sdlog_tool info|cat|time|reindex FILE [args]
+ * ========================================================================== */
+#define _POSIX_C_SOURCE 200809L
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "SdLogContainer.h"
+
+typedef struct {
+    FILE*    fp;
+    uint32_t reads;
+} ToolFile_t;
+
+static bool tool_read_trailer(void* ctx, uint32_t block, SdLogTrailer_t* t)
+{
+    ToolFile_t* f = (ToolFile_t*)ctx;
+    uint8_t tr[SDLOG_TRAILER_SIZE];
+    f->reads++;
+    if (fseeko(f->fp, (off_t)block * SDLOG_BLOCK_SIZE + SDLOG_PAYLOAD_SIZE, SEEK_SET) != 0 ||
+        fread(tr, 1, sizeof(tr), f->fp) != sizeof(tr)) {
+        return false;
+    }
+    return SdLog_DecodeTrailer(tr, t);
+}
+
+static void tool_sink(void* ctx, const uint8_t* data, size_t len)
+{
+    fwrite(data, 1, len, (FILE*)ctx);
+}
+
+static uint32_t tool_blocks(FILE* fp, uint64_t* pSize)
+{
+    fseeko(fp, 0, SEEK_END);
+    *pSize = (uint64_t)ftello(fp);
+    return (uint32_t)(*pSize / SDLOG_BLOCK_SIZE);
+}
+
+static bool tool_read_block(FILE* fp, uint32_t block, uint8_t* buf)
+{
+    return fseeko(fp, (off_t)block * SDLOG_BLOCK_SIZE, SEEK_SET) == 0 &&
+           fread(buf, 1, SDLOG_BLOCK_SIZE, fp) == SDLOG_BLOCK_SIZE;
+}
+
+/* The trailing index, if the last block is one and checks. */
+static bool tool_index(FILE* fp, uint32_t nblocks, SdLogIndex_t* ix)
+{
+    static uint8_t buf[SDLOG_BLOCK_SIZE];
+    SdLogTrailer_t t;
+    return nblocks > 0u && tool_read_block(fp, nblocks - 1u, buf) &&
+           SdLog_CheckBlock(buf, &t) && t.type == SDLOG_BLOCK_INDEX &&
+           SdLogIndex_Decode(buf, t.payloadLen, ix);
+}
+
+static int cmd_info(FILE* fp)
+{
+    static uint8_t buf[SDLOG_BLOCK_SIZE];
+    uint64_t size;
+    uint32_t nblocks = tool_blocks(fp, &size);
+    uint32_t count[3] = {0};
+    uint32_t bad = 0;
+    uint64_t payload = 0, samples = 0;
+
+    for (uint32_t b = 0; b < nblocks; b++) {
+        SdLogTrailer_t t;
+        if (!tool_read_block(fp, b, buf) || !SdLog_CheckBlock(buf, &t) || t.type > 2u) {
+            printf("block %u: bad trailer or CRC\n", (unsigned)b);
+            bad++;
+            continue;
+        }
+        count[t.type]++;
+        if (t.type != SDLOG_BLOCK_INDEX) {
+            payload += t.payloadLen;
+        }
+        samples += t.samples;
+    }
+    printf("%llu bytes, %u blocks: %u data, %u header, %u index, %u bad\n",
+           (unsigned long long)size, (unsigned)nblocks, (unsigned)count[0],
+           (unsigned)count[1], (unsigned)count[2], (unsigned)bad);
+    if (size % SDLOG_BLOCK_SIZE != 0u) {
+        printf("torn tail: %u bytes past the last whole block\n",
+               (unsigned)(size % SDLOG_BLOCK_SIZE));
+    }
+    printf("payload %llu bytes, %llu sample sets\n",
+           (unsigned long long)payload, (unsigned long long)samples);
+
+    SdLogIndex_t ix;
+    if (tool_index(fp, nblocks, &ix)) {
+        printf("index: %u blocks (%u data), %u sample sets, map 0x%08X, codes x%u\n",
+               (unsigned)ix.blocks, (unsigned)ix.dataBlocks, (unsigned)ix.samples,
+               (unsigned)ix.mapHash, 1u << ix.scaleBits);
+        printf("       ts 0x%08X .. 0x%08X (+%u wraps), stride %u\n",
+               (unsigned)ix.firstTs, (unsigned)ix.lastTs, (unsigned)ix.lastEpoch,
+               (unsigned)ix.stride);
+        for (uint32_t i = 0; i < ix.count; i++) {
+            SdLogTrailer_t e = {.firstTs = ix.entries[i].firstTs,
+                                .epoch = (uint16_t)ix.entries[i].epoch};
+            printf("       block %-8u +%lld ticks\n", (unsigned)ix.entries[i].block,
+                   (long long)SdLog_TrailerTicks(&e, ix.firstTs));
+        }
+    } else {
+        printf("no index (file not closed cleanly? see reindex)\n");
+    }
+    return bad == 0u ? 0 : 1;
+}
+
+static int cmd_cat(FILE* fp, uint32_t first, uint32_t count)
+{
+    static uint8_t buf[SDLOG_BLOCK_SIZE];
+    uint64_t size;
+    uint32_t nblocks = tool_blocks(fp, &size);
+    bool started = false;
+    for (uint32_t b = first; b < nblocks && b - first < count; b++) {
+        SdLogTrailer_t t;
+        if (!tool_read_block(fp, b, buf) || !SdLog_CheckBlock(buf, &t)) {
+            fprintf(stderr, "block %u: bad trailer or CRC, skipped\n", (unsigned)b);
+            started = false;
+            continue;
+        }
+        if (t.type == SDLOG_BLOCK_INDEX) {
+            continue;
+        }
+        size_t from = 0;
+        if (!started) {
+            /* Skip the tail of a record that began before the range. */
+            if (t.firstRecord == SDLOG_NO_RECORD) {
+                continue;
+            }
+            from = t.firstRecord;
+            started = true;
+        }
+        fwrite(buf + from, 1, t.payloadLen - from, stdout);
+    }
+    return 0;
+}
+
+static int cmd_time(FILE* fp, uint64_t t1, uint64_t t2)
+{
+    uint64_t size;
+    uint32_t nblocks = tool_blocks(fp, &size);
+    SdLogIndex_t ix;
+    bool haveIndex = tool_index(fp, nblocks, &ix);
+    ToolFile_t f = {.fp = fp};
+    uint32_t first, last;
+    if (!SdLog_FindRange(nblocks, haveIndex ? &ix : NULL, t1, t2,
+                         tool_read_trailer, &f, &first, &last)) {
+        printf("no records in range (%u trailer reads)\n", (unsigned)f.reads);
+        return 1;
+    }
+    printf("blocks %u..%u (%u blocks, %u trailer reads, %s)\n",
+           (unsigned)first, (unsigned)last, (unsigned)(last - first + 1u),
+           (unsigned)f.reads, haveIndex ? "indexed" : "no index");
+    return 0;
+}
+
+static int cmd_reindex(const char* path)
+{
+    static uint8_t buf[SDLOG_BLOCK_SIZE];
+    FILE* fp = fopen(path, "r+b");
+    if (fp == NULL) {
+        perror(path);
+        return 1;
+    }
+    uint64_t size;
+    uint32_t nblocks = tool_blocks(fp, &size);
+    SdLogIndex_t ix;
+    if (tool_index(fp, nblocks, &ix)) {
+        printf("already indexed\n");
+        fclose(fp);
+        return 0;
+    }
+
+    /* Rebuild from the trailers, the way the writer would have; stop at the
+     * first block that does not check -- everything after it is suspect. */
+    SdLogIndex_Init(&ix);
+    bool first = true;
+    uint32_t b = 0;
+    for (; b < nblocks; b++) {
+        SdLogTrailer_t t;
+        if (!tool_read_block(fp, b, buf) || !SdLog_CheckBlock(buf, &t) ||
+            t.type == SDLOG_BLOCK_INDEX) {
+            break;
+        }
+        SdLogIndex_Note(&ix, b, &t);
+        if (t.type == SDLOG_BLOCK_DATA && t.samples > 0u) {
+            if (first) {
+                ix.firstTs = t.firstTs;
+                first = false;
+            }
+            ix.lastTs = t.lastTs;
+            ix.lastEpoch = t.epoch + ((t.lastTs < t.firstTs) ? 1u : 0u);
+            ix.samples += t.samples;
+            ix.mapHash = t.mapHash;
+            ix.scaleBits = t.scaleBits;
+        }
+    }
+    fflush(fp);
+    if (ftruncate(fileno(fp), (off_t)b * SDLOG_BLOCK_SIZE) != 0 ||
+        fseeko(fp, (off_t)b * SDLOG_BLOCK_SIZE, SEEK_SET) != 0) {
+        perror(path);
+        fclose(fp);
+        return 1;
+    }
+    SdLogIndex_Emit(&ix, tool_sink, fp);
+    printf("kept %u blocks (dropped %llu bytes), appended an index of %u entries\n",
+           (unsigned)b, (unsigned long long)(size - (uint64_t)b * SDLOG_BLOCK_SIZE),
+           (unsigned)ix.count);
+    return fclose(fp) == 0 ? 0 : 1;
+}
+
+static int usage(void)
+{
+    fprintf(stderr, "usage: sdlog_tool info FILE\n"
+                    "       sdlog_tool cat FILE [FIRST [COUNT]]\n"
+                    "       sdlog_tool time FILE T1 T2\n"
+                    "       sdlog_tool reindex FILE\n");
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        return usage();
+    }
+    const char* cmd = argv[1];
+    if (strcmp(cmd, "reindex") == 0) {
+        return cmd_reindex(argv[2]);
+    }
+    FILE* fp = fopen(argv[2], "rb");
+    if (fp == NULL) {
+        perror(argv[2]);
+        return 1;
+    }
+    int rc;
+    if (strcmp(cmd, "info") == 0) {
+        rc = cmd_info(fp);
+    } else if (strcmp(cmd, "cat") == 0) {
+        uint32_t first = (argc > 3) ? (uint32_t)strtoul(argv[3], NULL, 0) : 0u;
+        uint32_t count = (argc > 4) ? (uint32_t)strtoul(argv[4], NULL, 0) : UINT32_MAX;
+        rc = cmd_cat(fp, first, count);
+    } else if (strcmp(cmd, "time") == 0 && argc > 4) {
+        rc = cmd_time(fp, strtoull(argv[3], NULL, 0), strtoull(argv[4], NULL, 0));
+    } else {
+        rc = usage();
+    }
+    fclose(fp);
+    return rc;
+}
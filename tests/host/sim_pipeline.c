@@ -0,0 +1,530 @@
+/* ==========================================================================
+ * sim_pipeline.c — host simulator + throughput benchmark for the streaming
+ * pipeline (producer -> sample pool/queue -> encoder batch -> transport ring
+ * -> drain).
+ *
+ * The code under test is the firmware's own: AInSample.c (pool + queue),
+ * streaming_encode.c (the #662 batch step), the PB / CSV / JSON encoders,
+ * nanopb and CircularBuffer.c. Only the board (host_board.c) and the clock
+ * are synthetic. Time is virtual: one loop iteration is one streaming timer
+ * tick, so a run is deterministic and independent of host speed; the encode
+ * step is additionally wall-clocked to give an ns/sample figure.
+ *
+ * Per tick, mirroring streaming.c:
+ *   producer (deferred ISR task) -- AllocateFromPool (NULL => poolExhausted),
+ *       fill Values, PushBack (fail => FreeToPool + queueOverflow), else
+ *       totalSamplesStreamed++.
+ *   consumer (streaming_Task), every --encode-every ticks -- retry any held
+ *       batch, then Streaming_EncodeBatch straight into a CircularBuf_Reserve
+ *       span of the ring + CircularBuf_Commit (the zero-copy path) when the
+ *       span has STREAMING_BATCH_FIRST_ROOM, else into the encoder buffer + one
+ *       all-or-nothing CircularBuf_AddBytes (--copy forces this). A batch
+ *       that does not fit is HELD (the solo-USB #520 backpressure:
+ *       WriteWithRetry blocks the encoder, so the pool absorbs the burst and
+ *       pool exhaustion is the single drop point).
+ *   transport -- drains --drain bytes/s through CircularBuf_ProcessBytes into
+ *       a sink that re-frames the stream (PB varint-delimited messages / CSV
+ *       lines) and counts what a client would see.
+ *
+ * Checks (non-zero exit on violation):
+ *   - #265 invariant: ticks == totalSamplesStreamed + queueDroppedSamples
+ *   - every accepted sample is either encoded, still queued, or an encoder
+ *     failure; nothing leaks out of the pool
+ *   - after the final drain, PB ticks (decoded by pb_block_decode.c, so a
+ *     block counts every sample it carries) / CSV data rows == samples
+ *     encoded (wire framing intact across batch concatenation and ring wrap)
+ *   - pbb: the last accepted tick reaches the sink -- the stop releases the
+ *     block hold before its final encode pass, as Streaming_FlushHeldSamples
+ *   - other encodings: the stop runs no encode pass; it drains the queue
+ *     (#533), which must leave it empty with every set accounted for, and
+ *     with a consumer that kept up (nothing queued at stop) the last tick
+ *     still reaches the sink
+ *
+ * Usage: sim_pipeline [--rate HZ] [--channels N] [--encoding pb|pbb|csv|csvc|json]
+ *                     [--seconds S] [--ring BYTES] [--drain BYTES_PER_S]
+ *                     [--pool N] [--encode-every TICKS] [--variant 1|3]
+ *                     [--delta K] [--copy] [--quiet]
+ * ========================================================================== */
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "host_board.h"
+#include "pb_block_decode.h"
+
+#include "services/DaqifiPB/DaqifiOutMessage.pb.h"
+#include "services/DaqifiPB/NanoPB_Encoder.h"
+#include "services/csv_encoder.h"
+#include "services/streaming.h"
+#include "services/streaming_encode.h"
+#include "state/data/AInSample.h"
+#include "state/data/DIOSample.h"
+#include "Util/CircularBuffer.h"
+
+#define SIM_ENCODER_BUFFER 4096u   /* matches the firmware's encoder buffer floor */
+
+typedef struct {
+    uint32_t rateHz;
+    uint8_t  channels;
+    StreamingEncoding encoding;
+    double   seconds;
+    uint32_t ringSize;
+    uint32_t drainBytesPerSec;
+    uint32_t poolCount;
+    uint32_t encodeEvery;
+    uint8_t  variant;
+    uint32_t deltaKeyframe;   /* SYST:STR:DELTa (pb only); 0 = off */
+    bool     copy;            /* never encode into the ring directly */
+    bool     quiet;
+} SimArgs;
+
+/* StreamingStats-style counters, same names as streaming.h. */
+typedef struct {
+    uint64_t timerISRCalls;
+    uint64_t totalSamplesStreamed;
+    uint64_t queueDroppedSamples;
+    uint64_t poolExhaustedSamples;
+    uint64_t queueOverflowSamples;
+    uint64_t encoderFailures;
+    uint64_t encodedSamples;
+    uint64_t stopDrainedSamples;  /* discarded by the stop drain (non-block) */
+    uint64_t totalBytesStreamed;
+    uint64_t heldBatches;
+    uint64_t directBatches;   /* encoded in place into the ring */
+    uint64_t maxQueueDepth;
+} SimStats;
+
+/* -------------------------------------------------------------------------
+ * Sink: re-frames the drained byte stream.
+ * ------------------------------------------------------------------------- */
+static struct {
+    StreamingEncoding encoding;
+    uint64_t bytes;
+    uint64_t messages;     /* CSV/JSON: lines */
+    uint64_t ticks;        /* PB: sample sets decoded (a block carries many) */
+    /* PB framing state: the bytes of a not yet complete message */
+    uint8_t  pending[SIM_ENCODER_BUFFER];
+    size_t   pendingLen;
+    bool     framingError;
+    PbDecodeState pb;      /* delta chain (--delta) */
+    uint32_t lastTs;       /* PB: timestamp of the newest tick decoded */
+} gSink;
+
+/* Every decoded tick costs at least one wire byte. */
+static PbTick gSinkTicks[SIM_ENCODER_BUFFER];
+
+static int Sink_Process(uint8_t* data, uint32_t len)
+{
+    gSink.bytes += len;
+    if (Streaming_EncodingIsPb(gSink.encoding)) {
+        /* Re-frame with the reference decoder (pb_block_decode.c), so both
+         * per-sample and block messages are counted in ticks. */
+        for (uint32_t i = 0; i < len && !gSink.framingError; ) {
+            size_t n = sizeof(gSink.pending) - gSink.pendingLen;
+            if (n > len - i) n = len - i;
+            memcpy(gSink.pending + gSink.pendingLen, data + i, n);
+            gSink.pendingLen += n;
+            i += (uint32_t)n;
+
+            size_t consumed = 0, nTicks = 0;
+            if (!PbDecode_Stream(&gSink.pb, gSink.pending, gSink.pendingLen, &consumed,
+                                 gSinkTicks, SIM_ENCODER_BUFFER, &nTicks) ||
+                (consumed == 0 && gSink.pendingLen == sizeof(gSink.pending))) {
+                gSink.framingError = true;   /* bad message or length prefix */
+                break;
+            }
+            gSink.ticks += nTicks;
+            if (nTicks > 0) {
+                gSink.lastTs = gSinkTicks[nTicks - 1u].timestamp;
+            }
+            memmove(gSink.pending, gSink.pending + consumed, gSink.pendingLen - consumed);
+            gSink.pendingLen -= consumed;
+        }
+    } else {
+        for (uint32_t i = 0; i < len; i++) {
+            if (data[i] == '\n') gSink.messages++;
+        }
+    }
+    return (int)len;
+}
+
+/* -------------------------------------------------------------------------
+ * Argument parsing
+ * ------------------------------------------------------------------------- */
+static bool ParseEncoding(const char* s, StreamingEncoding* out)
+{
+    if (strcmp(s, "pb") == 0)   { *out = Streaming_ProtoBuffer; return true; }
+    if (strcmp(s, "pbb") == 0)  { *out = Streaming_ProtoBufferBlock; return true; }
+    if (strcmp(s, "csv") == 0)  { *out = Streaming_Csv;         return true; }
+    if (strcmp(s, "csvc") == 0) { *out = Streaming_CsvCompact;  return true; }
+    if (strcmp(s, "json") == 0) { *out = Streaming_Json;        return true; }
+    return false;
+}
+
+static const char* EncodingName(StreamingEncoding e)
+{
+    switch (e) {
+        case Streaming_ProtoBuffer: return "pb";
+        case Streaming_ProtoBufferBlock: return "pbb";
+        case Streaming_Csv:         return "csv";
+        case Streaming_CsvCompact:  return "csvc";
+        case Streaming_Json:        return "json";
+        default:                    return "?";
+    }
+}
+
+static bool ParseArgs(int argc, char** argv, SimArgs* a)
+{
+    a->rateHz           = 1000;
+    a->channels         = 16;
+    a->encoding         = Streaming_ProtoBuffer;
+    a->seconds          = 1.0;
+    a->ringSize         = 16384;
+    a->drainBytesPerSec = 1000000;   /* ~USB FS bulk, practical */
+    a->poolCount        = DEFAULT_AIN_SAMPLE_COUNT;
+    a->encodeEvery      = 1;
+    a->variant          = 1;
+    a->deltaKeyframe    = 0;
+    a->copy             = false;
+    a->quiet            = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char* k = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(k, "--quiet") == 0) { a->quiet = true; continue; }
+        if (strcmp(k, "--copy") == 0)  { a->copy = true; continue; }
+        if (v == NULL) {
+            fprintf(stderr, "missing value for %s\n", k);
+            return false;
+        }
+        i++;
+        if      (strcmp(k, "--rate") == 0)         a->rateHz = (uint32_t)strtoul(v, NULL, 0);
+        else if (strcmp(k, "--channels") == 0)     a->channels = (uint8_t)strtoul(v, NULL, 0);
+        else if (strcmp(k, "--seconds") == 0)      a->seconds = strtod(v, NULL);
+        else if (strcmp(k, "--ring") == 0)         a->ringSize = (uint32_t)strtoul(v, NULL, 0);
+        else if (strcmp(k, "--drain") == 0)        a->drainBytesPerSec = (uint32_t)strtoul(v, NULL, 0);
+        else if (strcmp(k, "--pool") == 0)         a->poolCount = (uint32_t)strtoul(v, NULL, 0);
+        else if (strcmp(k, "--encode-every") == 0) a->encodeEvery = (uint32_t)strtoul(v, NULL, 0);
+        else if (strcmp(k, "--variant") == 0)      a->variant = (uint8_t)strtoul(v, NULL, 0);
+        else if (strcmp(k, "--delta") == 0)        a->deltaKeyframe = (uint32_t)strtoul(v, NULL, 0);
+        else if (strcmp(k, "--encoding") == 0) {
+            if (!ParseEncoding(v, &a->encoding)) {
+                fprintf(stderr, "unknown encoding '%s'\n", v);
+                return false;
+            }
+        } else {
+            fprintf(stderr, "unknown option '%s'\n", k);
+            return false;
+        }
+    }
+    if (a->rateHz == 0 || a->channels == 0 || a->channels > MAX_AIN_PUBLIC_CHANNELS ||
+        a->ringSize < 1024 || a->poolCount == 0 || a->encodeEvery == 0 ||
+        (a->variant != 1 && a->variant != 3)) {
+        fprintf(stderr, "invalid argument combination\n");
+        return false;
+    }
+    return true;
+}
+
+static uint64_t NowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Deterministic synthetic ADC code: a per-channel ramp, full-scale wrapped
+ * to the variant's code width (12-bit unipolar / 18-bit two's complement). */
+static uint32_t SyntheticCode(uint8_t variant, uint32_t tick, uint8_t ch)
+{
+    uint32_t v = tick * 37u + (uint32_t)ch * 1021u;
+    return (variant == 3) ? (v & 0x3FFFFu) : (v & 0xFFFu);
+}
+
+/* -------------------------------------------------------------------------
+ * Simulation
+ * ------------------------------------------------------------------------- */
+int main(int argc, char** argv)
+{
+    SimArgs args;
+    if (!ParseArgs(argc, argv, &args)) {
+        return 2;
+    }
+
+    const uint32_t tickHz = 1000000u;
+    HostBoardSetup setup = {
+        .variant          = args.variant,
+        .channels         = args.channels,
+        .encoding         = args.encoding,
+        .voltagePrecision = 0,
+        .rawMode          = false,
+        .dioEnabled       = false,
+        .tickHz           = tickHz,
+    };
+    HostBoard_Init(&setup);
+    tBoardData* pBoardData = HostBoard_Data();
+    DIOSampleList_Initialize(&pBoardData->DIOSamples, 16, false);
+
+    size_t elemSize = AInSampleList_ElementSize(args.channels);
+    void* poolMem = malloc(elemSize * args.poolCount);
+    uint8_t* ringMem = malloc(args.ringSize);
+    uint8_t* encBuf = malloc(SIM_ENCODER_BUFFER);
+    if (!poolMem || !ringMem || !encBuf) {
+        fprintf(stderr, "out of memory\n");
+        return 2;
+    }
+    AInSampleList_InitializeExternal(poolMem, args.poolCount, elemSize);
+
+    CircularBuf_t ring;
+    CircularBuf_InitExternal(&ring, Sink_Process, ringMem, args.ringSize);
+    memset(&gSink, 0, sizeof(gSink));
+    gSink.encoding = args.encoding;
+    Streaming_EncodeSetBlockHold(args.rateHz * 1000u, args.channels);   /* as Streaming_Start */
+    Nanopb_StreamingDeltaConfigure(
+            (args.encoding == Streaming_ProtoBuffer) ? args.deltaKeyframe : 0u);
+    if (Streaming_EncodingIsCsv(args.encoding)) {
+        csv_SelectRowWriter(true);
+    }
+
+    SimStats st;
+    memset(&st, 0, sizeof(st));
+
+    const uint64_t ticks = (uint64_t)((double)args.rateHz * args.seconds);
+    const uint32_t periodTicks = tickHz / args.rateHz ? tickHz / args.rateHz : 1u;
+    double drainCredit = 0.0;
+    const double drainPerTick = (double)args.drainBytesPerSec / (double)args.rateHz;
+    size_t heldSize = 0;
+    uint64_t encodeNs = 0;
+    uint32_t lastAcceptedTs = 0;
+
+    for (uint64_t t = 0; t < ticks; t++) {
+        /* ---- producer: one timer tick ---- */
+        st.timerISRCalls++;
+        AInPublicSampleList_t* s = AInSampleList_AllocateFromPool();
+        if (s == NULL) {
+            st.queueDroppedSamples++;
+            st.poolExhaustedSamples++;
+        } else {
+            s->Timestamp = (uint32_t)(1u + t * periodTicks);
+            s->channelCount = args.channels;
+            s->validMask = (uint16_t)((1u << args.channels) - 1u);
+            for (uint8_t j = 0; j < args.channels; j++) {
+                s->Values[j] = SyntheticCode(args.variant, (uint32_t)t, j);
+            }
+            if (!AInSampleList_PushBack(s)) {
+                AInSampleList_FreeToPool(s);
+                st.queueDroppedSamples++;
+                st.queueOverflowSamples++;
+            } else {
+                st.totalSamplesStreamed++;
+                lastAcceptedTs = (uint32_t)(1u + t * periodTicks);
+            }
+        }
+        size_t depth = AInSampleList_Size();
+        if (depth > st.maxQueueDepth) st.maxQueueDepth = depth;
+
+        /* ---- consumer: encoder task wake ---- */
+        if ((t % args.encodeEvery) == 0) {
+            for (;;) {
+                if (heldSize > 0) {
+                    if (CircularBuf_NumBytesFree(&ring) < heldSize) {
+                        break;              /* still blocked on the ring */
+                    }
+                    CircularBuf_AddBytes(&ring, encBuf, (uint32_t)heldSize);
+                    heldSize = 0;
+                }
+                if (AInSampleList_IsEmpty()) {
+                    break;
+                }
+                /* Zero-copy first, as streaming.c: a short span is
+                 * released (nothing to undo) and the batch is copied. */
+                uint32_t spanLen = 0;
+                uint8_t* span = args.copy ? NULL : CircularBuf_Reserve(&ring, &spanLen);
+                if (span != NULL && spanLen < STREAMING_BATCH_FIRST_ROOM) {
+                    span = NULL;
+                }
+                size_t before = AInSampleList_Size();
+                bool failed = false;
+                uint64_t t0 = NowNs();
+                size_t n = Streaming_EncodeBatch(pBoardData, args.encoding,
+                        span ? span : encBuf, span ? spanLen : SIM_ENCODER_BUFFER,
+                        CircularBuf_NumBytesFree(&ring), &failed);
+                encodeNs += NowNs() - t0;
+                size_t popped = before - AInSampleList_Size();
+                if (failed) {
+                    st.encoderFailures++;
+                    popped--;
+                }
+                st.encodedSamples += popped;
+                if (n == 0) {
+                    break;
+                }
+                st.totalBytesStreamed += n;
+                if (span != NULL) {
+                    CircularBuf_Commit(&ring, (uint32_t)n);
+                    st.directBatches++;
+                } else if (CircularBuf_NumBytesFree(&ring) >= n) {
+                    CircularBuf_AddBytes(&ring, encBuf, (uint32_t)n);
+                } else {
+                    heldSize = n;           /* #520: encoder blocks on a full ring */
+                    st.heldBatches++;
+                    break;
+                }
+            }
+        }
+
+        /* ---- transport drain ---- */
+        drainCredit += drainPerTick;
+        if (drainCredit >= 1.0) {
+            int err = 0;
+            uint32_t want = (uint32_t)drainCredit;
+            uint32_t got = 0;
+            /* ProcessBytes stops at the ring wrap; a second call takes the rest. */
+            for (int pass = 0; pass < 2 && got < want; pass++) {
+                got += CircularBuf_ProcessBytes(&ring, NULL, want - got, &err);
+            }
+            drainCredit -= got;
+            if (CircularBuf_NumBytesAvailable(&ring) == 0 && drainCredit > 1.0) {
+                drainCredit = 1.0;          /* an idle link does not bank credit */
+            }
+        }
+    }
+
+    /* Stop, as Streaming_Stop: a block session releases its hold and gets
+     * final encode passes (Streaming_FlushHeldSamples); every other
+     * encoding only drains the queue (Streaming_DrainSessionSampleQueues).
+     * Either way the batch already encoded is written and the ring drains. */
+    size_t stopQueued = AInSampleList_Size();
+    const bool flushPass = (args.encoding == Streaming_ProtoBufferBlock);
+    if (flushPass) {
+        Streaming_EncodeReleaseBlockHold();
+    } else {
+        AInPublicSampleList_t* stale;
+        while (AInSampleList_PopFront(&stale)) {
+            AInSampleList_FreeToPool(stale);
+            st.stopDrainedSamples++;
+        }
+    }
+    for (;;) {
+        int err = 0;
+        while (CircularBuf_ProcessBytes(&ring, NULL, args.ringSize, &err) > 0) { }
+        if (heldSize > 0) {
+            CircularBuf_AddBytes(&ring, encBuf, (uint32_t)heldSize);
+            heldSize = 0;
+            continue;
+        }
+        if (AInSampleList_IsEmpty()) break;
+        size_t before = AInSampleList_Size();
+        bool failed = false;
+        size_t n = Streaming_EncodeBatch(pBoardData, args.encoding, encBuf,
+                SIM_ENCODER_BUFFER, CircularBuf_NumBytesFree(&ring), &failed);
+        size_t popped = before - AInSampleList_Size();
+        if (failed) {
+            st.encoderFailures++;
+            popped--;
+        }
+        st.encodedSamples += popped;
+        st.totalBytesStreamed += n;
+        if (n == 0 && !failed) break;
+        heldSize = n;
+    }
+
+    /* ---- checks ---- */
+    int rc = 0;
+    if (st.timerISRCalls != st.totalSamplesStreamed + st.queueDroppedSamples) {
+        fprintf(stderr, "FAIL: invariant TimerISRCalls == Total + Dropped (%llu != %llu + %llu)\n",
+                (unsigned long long)st.timerISRCalls,
+                (unsigned long long)st.totalSamplesStreamed,
+                (unsigned long long)st.queueDroppedSamples);
+        rc = 1;
+    }
+    if (st.totalSamplesStreamed !=
+            st.encodedSamples + st.encoderFailures + st.stopDrainedSamples) {
+        fprintf(stderr, "FAIL: accepted %llu samples but encoded %llu + failed %llu"
+                " + drained at stop %llu\n",
+                (unsigned long long)st.totalSamplesStreamed,
+                (unsigned long long)st.encodedSamples,
+                (unsigned long long)st.encoderFailures,
+                (unsigned long long)st.stopDrainedSamples);
+        rc = 1;
+    }
+    if (!flushPass && (!AInSampleList_IsEmpty() || st.stopDrainedSamples != stopQueued)) {
+        fprintf(stderr, "FAIL: stop drain left %u sets queued (%llu of %u drained)\n",
+                (unsigned)AInSampleList_Size(),
+                (unsigned long long)st.stopDrainedSamples, (unsigned)stopQueued);
+        rc = 1;
+    }
+    if (AInSampleList_PoolInUse() != 0) {
+        fprintf(stderr, "FAIL: %u pool slots leaked\n", (unsigned)AInSampleList_PoolInUse());
+        rc = 1;
+    }
+    if (gSink.bytes != st.totalBytesStreamed) {
+        fprintf(stderr, "FAIL: sink saw %llu bytes, encoder produced %llu\n",
+                (unsigned long long)gSink.bytes, (unsigned long long)st.totalBytesStreamed);
+        rc = 1;
+    }
+    if (Streaming_EncodingIsPb(args.encoding)) {
+        if (gSink.framingError || gSink.pendingLen != 0 ||
+            gSink.ticks != st.encodedSamples) {
+            fprintf(stderr, "FAIL: PB framing (%llu ticks for %llu samples%s)\n",
+                    (unsigned long long)gSink.ticks,
+                    (unsigned long long)st.encodedSamples,
+                    gSink.framingError ? ", malformed message" : "");
+            rc = 1;
+        }
+        if (lastAcceptedTs != 0u && (flushPass || stopQueued == 0u) &&
+            gSink.lastTs != lastAcceptedTs) {
+            fprintf(stderr, "FAIL: last tick (ts %u) never reached the output "
+                    "(%u sets queued at stop, newest decoded ts %u)\n",
+                    (unsigned)lastAcceptedTs, (unsigned)stopQueued,
+                    (unsigned)gSink.lastTs);
+            rc = 1;
+        }
+    } else if (Streaming_EncodingIsCsv(args.encoding) && st.encodedSamples > 0) {
+        /* 4 header lines (device, serial, tick rate, column names), then one
+         * row per sample. */
+        if (gSink.messages != st.encodedSamples + 4u) {
+            fprintf(stderr, "FAIL: CSV %llu lines for %llu samples (+4 header)\n",
+                    (unsigned long long)gSink.messages,
+                    (unsigned long long)st.encodedSamples);
+            rc = 1;
+        }
+    }
+
+    /* ---- report ---- */
+    double simSeconds = (double)ticks / (double)args.rateHz;
+    double nsPerSample = st.encodedSamples ? (double)encodeNs / (double)st.encodedSamples : 0.0;
+    double lossPct = st.timerISRCalls
+            ? 100.0 * (double)st.queueDroppedSamples / (double)st.timerISRCalls : 0.0;
+    if (!args.quiet || rc != 0) {
+        char label[8];
+        snprintf(label, sizeof(label), "%s%s", EncodingName(args.encoding),
+                 args.deltaKeyframe ? "+d" : "");
+        printf("%-4s v%u %2uch %7u Hz ring %6u drain %8u B/s pool %5u every %u: "
+               "%9.0f smp/s %10.0f B/s %7.1f ns/smp loss %6.2f%% "
+               "(pool %llu, queue %llu, enc %llu, held %llu, direct %llu, maxq %llu, "
+               "stop drain %llu) %s\n",
+               label, args.variant, args.channels, args.rateHz,
+               args.ringSize, args.drainBytesPerSec, args.poolCount, args.encodeEvery,
+               simSeconds > 0 ? (double)st.encodedSamples / simSeconds : 0.0,
+               simSeconds > 0 ? (double)st.totalBytesStreamed / simSeconds : 0.0,
+               nsPerSample, lossPct,
+               (unsigned long long)st.poolExhaustedSamples,
+               (unsigned long long)st.queueOverflowSamples,
+               (unsigned long long)st.encoderFailures,
+               (unsigned long long)st.heldBatches,
+               (unsigned long long)st.directBatches,
+               (unsigned long long)st.maxQueueDepth,
+               (unsigned long long)st.stopDrainedSamples,
+               rc == 0 ? "OK" : "FAIL");
+    }
+
+    AInSampleList_Destroy();
+    DIOSampleList_Destroy(&pBoardData->DIOSamples);
+    free(poolMem);
+    free(ringMem);
+    free(encBuf);
+    return rc;
+}
@@ -0,0 +1,47 @@
+/* ==========================================================================
+ * Host-test stub for FreeRTOS.h.
+ *
+ * Just enough kernel for the streaming pipeline modules (AInSample.c,
+ * DIOSample.c, the encoders) to run on the PC host inside ONE thread: the
+ * queue is a real bounded FIFO (queue.h), mutexes always succeed, critical
+ * sections are no-ops. There is no scheduler -- the pipeline simulator drives
+ * the producer and consumer sides in lock-step from main().
+ *
+ * Tests that need genuine concurrency (two pthreads) must not lean on these
+ * primitives for correctness; that is the point of testing lock-free code
+ * against them.
+ * ========================================================================== */
+#ifndef FREERTOS_HOST_STUB_H
+#define FREERTOS_HOST_STUB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+typedef long          BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t      TickType_t;
+typedef void*         TaskHandle_t;
+
+#define pdTRUE        ((BaseType_t)1)
+#define pdFALSE       ((BaseType_t)0)
+#define pdPASS        pdTRUE
+#define pdFAIL        pdFALSE
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFu)
+#define portTICK_PERIOD_MS 1u
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(ms))
+
+#define configASSERT(x) ((void)(x))
+
+#define taskENTER_CRITICAL()               ((void)0)
+#define taskEXIT_CRITICAL()                ((void)0)
+#define taskENTER_CRITICAL_FROM_ISR()      (0u)
+#define taskEXIT_CRITICAL_FROM_ISR(x)      ((void)(x))
+#define portTASK_USES_FLOATING_POINT()     ((void)0)
+
+/* heap_4 reports its free bytes; the host heap is effectively unbounded. */
+static inline size_t xPortGetFreeHeapSize(void) { return (size_t)64u * 1024u * 1024u; }
+static inline void*  pvPortMalloc(size_t n) { return malloc(n); }
+static inline void   vPortFree(void* p) { free(p); }
+
+#endif /* FREERTOS_HOST_STUB_H */
@@ -0,0 +1,22 @@
+/* ==========================================================================
+ * Host-test stub for firmware/src/HAL/DioProbe.h.
+ *
+ * The real header reaches plib_gpio.h (and from there <xc.h>) by a relative
+ * path, so it cannot be shadowed piecemeal. On the host there is no pin to
+ * toggle: every probe call compiles to nothing, exactly as it does on target
+ * when no probe is routed (gDioProbeAnyActive == false).
+ * ========================================================================== */
+#ifndef DIOPROBE_HOST_STUB_H
+#define DIOPROBE_HOST_STUB_H
+
+#include <stdint.h>
+
+static inline void DioProbe_Toggle(uint8_t probeId)     { (void)probeId; }
+static inline void DioProbe_PulseStart(uint8_t probeId) { (void)probeId; }
+static inline void DioProbe_PulseEnd(uint8_t probeId)   { (void)probeId; }
+
+#define DIO_PROBE_TOGGLE(id)      ((void)(id))
+#define DIO_PROBE_PULSE_START(id) ((void)(id))
+#define DIO_PROBE_PULSE_END(id)   ((void)(id))
+
+#endif /* DIOPROBE_HOST_STUB_H */
@@ -2,8 +2,10 @@
  * Host-test stub for firmware/src/Util/Logger.h.
  *
  * The real Logger.h drags in FreeRTOS.h, semphr.h and libscpi types — none of
- * which exist on the PC host. CircularBuffer.c only ever calls LOG_E() (one
- * OSAL_Malloc-failure path), so a no-op variadic macro is all that's needed.
+ * which exist on the PC host. The modules under test only ever call the
+ * logging macros, so no-op variadic macros are all that's needed. The
+ * session-gated variants swallow their bit argument too, so the
+ * LOG_SESSION_* enum never has to exist here.
  * Defining these here (rather than pulling the real header) keeps the unit
  * under test free of firmware/RTOS dependencies.
  * ========================================================================== */
@@ -14,4 +16,8 @@
 #define LOG_I(...) ((void)0)
 #define LOG_D(...) ((void)0)
 
+#define LOG_E_SESSION(...) ((void)0)
+#define LOG_I_SESSION(...) ((void)0)
+#define LOG_D_SESSION(...) ((void)0)
+
 #endif /* LOGGER_HOST_STUB_H */
@@ -0,0 +1,9 @@
+/* ==========================================================================
+ * Host-test stub for firmware/src/Util/Logger.h, reached via the
+ * `#include "Util/Logger.h"` spelling most firmware modules use. Forwards to
+ * the flat stub (stubs/Logger.h) so both spellings resolve to the same no-ops.
+ * ========================================================================== */
+#ifndef UTIL_LOGGER_HOST_STUB_H
+#define UTIL_LOGGER_HOST_STUB_H
+#include "../Logger.h"
+#endif /* UTIL_LOGGER_HOST_STUB_H */
@@ -0,0 +1,6 @@
+/* Host-test shim for config/default/clock_config.h. The real header is
+ * preprocessor-only, so forward to it rather than duplicating the clock
+ * constants (TimerApi.h derives TIMER_CLOCK_FRQ from them). It is reached
+ * through this shim because putting config/default on the include path would
+ * let the REAL definitions.h shadow the stub one. */
+#include "../../../firmware/src/config/default/clock_config.h"
@@ -0,0 +1,12 @@
+/* ==========================================================================
+ * Host-test stub for the Harmony-generated configuration.h.
+ *
+ * The real header lives in firmware/src/config/default and pulls in the XC32
+ * device headers. Nothing the host-built modules read from it matters off
+ * target, so this is intentionally empty; definitions.h (also stubbed) carries
+ * the handful of Harmony types the firmware headers name.
+ * ========================================================================== */
+#ifndef CONFIGURATION_HOST_STUB_H
+#define CONFIGURATION_HOST_STUB_H
+
+#endif /* CONFIGURATION_HOST_STUB_H */
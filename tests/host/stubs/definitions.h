@@ -0,0 +1,47 @@
+/* ==========================================================================
+ * Host-test stub for the Harmony-generated definitions.h.
+ *
+ * The real header includes every peripheral library (plib_gpio, plib_adchs,
+ * the USB device stack, the WINC driver ...) and ultimately <xc.h>, none of
+ * which exist on the PC host. The firmware headers that the pipeline tests
+ * compile (BoardData.h, BoardConfig.h, BoardRuntimeConfig.h, UsbCdc.h,
+ * wifi_manager.h ...) only ever NAME these types in struct members and
+ * prototypes, so opaque integer/pointer stand-ins are enough: the host never
+ * touches the hardware fields, it just has to agree on the layout within one
+ * build.
+ *
+ * Add a typedef here (not in the test) when a newly-compiled module names
+ * another Harmony type.
+ * ========================================================================== */
+#ifndef DEFINITIONS_HOST_STUB_H
+#define DEFINITIONS_HOST_STUB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+/* --- peripheral libraries --------------------------------------------- */
+typedef uint32_t GPIO_PIN;
+typedef uint32_t GPIO_PORT;
+typedef uint32_t ADCHS_CHANNEL_NUM;
+typedef uint32_t ADCHS_MODULE_MASK;
+typedef void (*TMR_CALLBACK)(uint32_t status, uintptr_t context);
+
+/* --- system / driver framework ---------------------------------------- */
+typedef uint32_t  SYS_MODULE_INDEX;
+typedef uintptr_t DRV_HANDLE;
+
+/* --- USB device stack (UsbCdc.h) -------------------------------------- */
+typedef uintptr_t USB_DEVICE_HANDLE;
+typedef uintptr_t USB_DEVICE_CDC_TRANSFER_HANDLE;
+typedef uint32_t  USB_DEVICE_STATE;
+typedef struct { uint32_t dwDTERate; uint8_t bCharFormat, bParityType, bDataBits; } USB_CDC_LINE_CODING;
+typedef struct { uint16_t carrier : 1; uint16_t dtr : 1; } USB_CDC_CONTROL_LINE_STATE;
+
+/* --- crypto (daqifi_settings.h checksum size) ------------------------- */
+#define CRYPT_MD5_DIGEST_SIZE 16
+
+#endif /* DEFINITIONS_HOST_STUB_H */
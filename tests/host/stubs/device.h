@@ -0,0 +1,13 @@
+/* ==========================================================================
+ * Host-test stub for the XC32 device.h that FatFs's ff.h includes.
+ *
+ * ff.h only wants the toolchain's fixed-width types from it, which it also
+ * gets from <stdint.h> itself; nothing device-specific is needed to build
+ * ff.c against a RAM disk.
+ * ========================================================================== */
+#ifndef DEVICE_HOST_STUB_H
+#define DEVICE_HOST_STUB_H
+
+#include <stdint.h>
+
+#endif /* DEVICE_HOST_STUB_H */
@@ -0,0 +1,90 @@
+/* ==========================================================================
+ * Host-test stub for FreeRTOS queue.h -- a real copy-by-value bounded FIFO.
+ *
+ * Semantics match the kernel for the non-blocking calls the pipeline makes
+ * (every firmware call site passes a 0 tick timeout on the data path): send
+ * fails when full, receive/peek fail when empty. A non-zero timeout is
+ * treated as 0 -- with no scheduler nothing could fill or drain the queue
+ * while we "waited".
+ * ========================================================================== */
+#ifndef QUEUE_HOST_STUB_H
+#define QUEUE_HOST_STUB_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "FreeRTOS.h"
+
+typedef struct s_HostQueue {
+    uint8_t*    storage;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    UBaseType_t head;
+    UBaseType_t count;
+} HostQueue_t;
+
+typedef HostQueue_t* QueueHandle_t;
+
+static inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    if (length == 0 || itemSize == 0) return NULL;
+    QueueHandle_t q = (QueueHandle_t)calloc(1, sizeof(*q));
+    if (q == NULL) return NULL;
+    q->storage = (uint8_t*)malloc((size_t)length * itemSize);
+    if (q->storage == NULL) { free(q); return NULL; }
+    q->length   = length;
+    q->itemSize = itemSize;
+    return q;
+}
+
+static inline void vQueueDelete(QueueHandle_t q)
+{
+    if (q == NULL) return;
+    free(q->storage);
+    free(q);
+}
+
+static inline BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t wait)
+{
+    (void)wait;
+    if (q == NULL || q->count == q->length) return pdFALSE;
+    UBaseType_t tail = (q->head + q->count) % q->length;
+    memcpy(q->storage + (size_t)tail * q->itemSize, item, q->itemSize);
+    q->count++;
+    return pdTRUE;
+}
+#define xQueueSendToBack(q, i, w) xQueueSend((q), (i), (w))
+#define xQueueSendFromISR(q, i, w) xQueueSend((q), (i), 0)
+
+static inline BaseType_t xQueuePeek(QueueHandle_t q, void* item, TickType_t wait)
+{
+    (void)wait;
+    if (q == NULL || q->count == 0) return pdFALSE;
+    memcpy(item, q->storage + (size_t)q->head * q->itemSize, q->itemSize);
+    return pdTRUE;
+}
+
+static inline BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t wait)
+{
+    if (xQueuePeek(q, item, wait) != pdTRUE) return pdFALSE;
+    q->head = (q->head + 1) % q->length;
+    q->count--;
+    return pdTRUE;
+}
+
+static inline UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q)
+{
+    return (q == NULL) ? 0 : (q->length - q->count);
+}
+
+static inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    return (q == NULL) ? 0 : q->count;
+}
+
+static inline BaseType_t xQueueReset(QueueHandle_t q)
+{
+    if (q != NULL) { q->head = 0; q->count = 0; }
+    return pdPASS;
+}
+
+#endif /* QUEUE_HOST_STUB_H */
@@ -0,0 +1,23 @@
+/* ==========================================================================
+ * Host-test stub for FreeRTOS semphr.h.
+ *
+ * Single-threaded host: a mutex can always be taken. Handles are non-NULL
+ * sentinels so "was the mutex created?" checks in the firmware pass.
+ * ========================================================================== */
+#ifndef SEMPHR_HOST_STUB_H
+#define SEMPHR_HOST_STUB_H
+
+#include "FreeRTOS.h"
+
+typedef void* SemaphoreHandle_t;
+
+static int gHostSemaphoreSentinel;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void) { return &gHostSemaphoreSentinel; }
+static inline SemaphoreHandle_t xSemaphoreCreateBinary(void) { return &gHostSemaphoreSentinel; }
+static inline void vSemaphoreDelete(SemaphoreHandle_t s) { (void)s; }
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t t) { (void)s; (void)t; return pdTRUE; }
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t s) { (void)s; return pdTRUE; }
+static inline BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t s, BaseType_t* w) { (void)s; (void)w; return pdTRUE; }
+
+#endif /* SEMPHR_HOST_STUB_H */
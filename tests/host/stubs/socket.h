@@ -0,0 +1,23 @@
+/* ==========================================================================
+ * Host-test stub for the WINC1500 BSD-style socket.h.
+ *
+ * Shadows the real driver header (NOT <sys/socket.h>). Constants match the
+ * driver so wifi_tcp_server.h sizes its per-client buffers identically.
+ * ========================================================================== */
+#ifndef WINC_SOCKET_HOST_STUB_H
+#define WINC_SOCKET_HOST_STUB_H
+
+#include <stdint.h>
+
+typedef int8_t SOCKET;
+
+#define AF_INET 2
+
+/* The driver exports a BSD-compatible inet_ntop (JSON_Encoder prints the
+ * WiFi IP with it); same prototype as <arpa/inet.h> so libc links it. */
+const char* inet_ntop(int af, const void* src, char* dst, unsigned int size);
+
+#define HOSTNAME_MAX_SIZE        64
+#define SOCKET_BUFFER_MAX_LENGTH 1400
+
+#endif /* WINC_SOCKET_HOST_STUB_H */
@@ -0,0 +1,19 @@
+/* ==========================================================================
+ * Host-test stub for FreeRTOS task.h. No scheduler on the host: delays and
+ * notifications are no-ops, the tick count is whatever the test sets.
+ * ========================================================================== */
+#ifndef TASK_HOST_STUB_H
+#define TASK_HOST_STUB_H
+
+#include "FreeRTOS.h"
+
+static TickType_t gHostTickCount;
+
+static inline TickType_t xTaskGetTickCount(void) { return gHostTickCount; }
+static inline void vTaskDelay(TickType_t t) { gHostTickCount += t; }
+#define xTaskNotifyGive(h)                 ((void)(h))
+#define vTaskNotifyGiveFromISR(h, w)       ((void)(h), (void)(w))
+#define ulTaskNotifyTake(clear, t)         ((void)(clear), (void)(t), 1u)
+#define portYIELD_FROM_ISR(x)              ((void)(x))
+
+#endif /* TASK_HOST_STUB_H */
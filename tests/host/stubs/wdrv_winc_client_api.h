@@ -0,0 +1,6 @@
+/* Host-test stub for the WINC1500 driver's wdrv_winc_client_api.h (see
+ * wdrv_winc_common.h). Nothing from it is needed off target. */
+#ifndef WDRV_WINC_CLIENT_API_HOST_STUB_H
+#define WDRV_WINC_CLIENT_API_HOST_STUB_H
+#include "wdrv_winc_common.h"
+#endif /* WDRV_WINC_CLIENT_API_HOST_STUB_H */
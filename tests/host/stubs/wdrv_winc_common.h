@@ -0,0 +1,17 @@
+/* ==========================================================================
+ * Host-test stub for the WINC1500 driver's wdrv_winc_common.h.
+ *
+ * wifi_manager.h / daqifi_settings.h size their settings structs from these
+ * constants; the values match the real driver so struct layouts agree.
+ * ========================================================================== */
+#ifndef WDRV_WINC_COMMON_HOST_STUB_H
+#define WDRV_WINC_COMMON_HOST_STUB_H
+
+#include <stdint.h>
+
+#define WDRV_WINC_MAX_SSID_LEN 32
+#define WDRV_WINC_PSK_LEN      64
+
+typedef struct { uint8_t addr[6]; } WDRV_WINC_MAC_ADDR;
+
+#endif /* WDRV_WINC_COMMON_HOST_STUB_H */
@@ -0,0 +1,493 @@
+/* ==========================================================================
+ * test_acq_plan.c — host unit tests for firmware/src/Util/AcqPlan.c
+ *
+ * The deferred tick task's acquisition plan, run against a fake register
+ * file: ADCHS result registers with per-input ARDY flags (set by a
+ * "conversion", cleared by the read) and the BOARDDATA_AIN_LATEST cache
+ * (Timestamp 0 = invalid, #533). Covers the builder's ranges and rail
+ * codes, each op kind, the T1 miss path and LATEST write-back, and checks
+ * both executors against a copy of the per-channel loop they replaced in
+ * _Streaming_Deferred_Interrupt_Task over random configurations, codes and
+ * test patterns -- values, validMask and the #814 clip mask must be
+ * identical. Prints ns/frame for 16 channels, old loop vs plan.
+ *
+ * Run: make -C tests/host run
+ * ========================================================================== */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "AcqPlan.h"            /* real header (via -I firmware/src/Util) */
+#include "test_framework.h"
+
+/* --- Fake register file ------------------------------------------------------ */
+
+#define HW_CHANNELS   64
+#define CFG_CHANNELS  32
+
+typedef struct {
+    uint32_t data[HW_CHANNELS];     /* ADCDATAx */
+    uint64_t ardy;                  /* per-input ARDY */
+    uint32_t latestTs[CFG_CHANNELS];
+    uint32_t latestValue[CFG_CHANNELS];
+    uint8_t  latestChannel[CFG_CHANNELS];
+    uint32_t reads;
+    uint32_t misses;
+    uint32_t stores;
+} FakeBoard;
+
+static FakeBoard g_board;
+
+static void convert(uint8_t hw, uint32_t value)
+{
+    g_board.data[hw] = value;
+    g_board.ardy |= (1ull << hw);
+}
+
+static bool fake_read_result(void* ctx, uint8_t hw, uint32_t* pValue)
+{
+    (void)ctx;
+    g_board.reads++;
+    if (!(g_board.ardy & (1ull << hw))) {
+        return false;
+    }
+    g_board.ardy &= ~(1ull << hw);      /* cleared by the ADCDATAx read */
+    *pValue = g_board.data[hw];
+    return true;
+}
+
+static bool fake_read_latest(void* ctx, uint8_t slot, uint32_t* pValue)
+{
+    (void)ctx;
+    if (g_board.latestTs[slot] == 0u) {
+        return false;
+    }
+    *pValue = g_board.latestValue[slot];
+    return true;
+}
+
+static void fake_store_latest(void* ctx, const AcqOp_t* op, uint32_t value)
+{
+    g_board.stores++;
+    g_board.latestTs[op->slot] = *(const uint32_t*)ctx;
+    g_board.latestValue[op->slot] = value;
+    g_board.latestChannel[op->slot] = op->channelId;
+}
+
+static void fake_t1_miss(void* ctx, const AcqOp_t* op)
+{
+    (void)ctx;
+    (void)op;
+    g_board.misses++;
+}
+
+static const AcqPlanIo_t kFakeIo = {
+    .readResult = fake_read_result,
+    .readLatest = fake_read_latest,
+    .storeLatest = fake_store_latest,
+    .t1Miss = fake_t1_miss,
+};
+
+/* --- Reference: the loop the plan replaced ----------------------------------- */
+
+enum { REF_MC12B = 0, REF_AD7609 = 1 };
+#define BENCHMARK_PIPELINE 2
+
+typedef struct {
+    uint8_t  count;
+    uint8_t  type[16];          /* board config Type */
+    uint8_t  cfgIdx[16];
+    uint8_t  channelId[16];
+    uint8_t  hw[16];
+    uint16_t t1DirectMask;
+} RefMapping;
+
+/* Streaming_GenerateTestValue as it was in streaming.c. */
+static uint32_t ref_generate(uint32_t pattern, uint8_t channel, uint64_t sampleCount, uint32_t adcMax)
+{
+    uint32_t range = adcMax + 1;
+    switch (pattern) {
+        case 1: return (uint32_t)((sampleCount + channel) % range);
+        case 2: return adcMax / 2;
+        case 3: return adcMax;
+        case 4: return (uint32_t)(((sampleCount * (channel + 1))) % range);
+        case 5: {
+            uint32_t period = 2 * range;
+            uint32_t pos = (uint32_t)((sampleCount + (uint32_t)channel * (range / 4)) % period);
+            return (pos < range) ? pos : (period - 1 - pos);
+        }
+        case 6: return AcqPlan_GenerateTestValue(6, channel, sampleCount, adcMax);
+        default: return 0;
+    }
+}
+
+static uint32_t ref_frame(const RefMapping* m, uint32_t framePattern, uint32_t frameBenchMode,
+                          uint64_t sampleCount, uint32_t trigStamp, uint32_t* values,
+                          uint32_t* pClip)
+{
+    uint32_t validMask = 0, clipMask = 0;
+    for (uint8_t j = 0; j < m->count; j++) {
+        uint8_t cfgIdx = m->cfgIdx[j];
+        uint32_t adcMax;
+        bool adcIsSigned;
+        const bool valueIsSynthetic = (frameBenchMode == BENCHMARK_PIPELINE) || (framePattern != 0);
+        if (m->type[j] == REF_AD7609) {
+            adcMax = 262143u;
+            adcIsSigned = !valueIsSynthetic;
+        } else {
+            adcMax = 4095u;
+            adcIsSigned = false;
+        }
+        if (frameBenchMode == BENCHMARK_PIPELINE || framePattern != 0) {
+            values[j] = ref_generate(framePattern, m->channelId[j], sampleCount, adcMax);
+            validMask |= (1U << j);
+        } else if (m->t1DirectMask & (1U << j)) {
+            uint32_t val;
+            if (fake_read_result(NULL, m->hw[j], &val)) {
+                values[j] = val;
+                validMask |= (1U << j);
+                g_board.stores++;
+                g_board.latestTs[cfgIdx] = trigStamp;
+                g_board.latestValue[cfgIdx] = val;
+                g_board.latestChannel[cfgIdx] = m->channelId[j];
+            } else {
+                g_board.misses++;
+            }
+        } else {
+            if (g_board.latestTs[cfgIdx] != 0) {
+                values[j] = g_board.latestValue[cfgIdx];
+                validMask |= (1U << j);
+            }
+        }
+        if (validMask & (1U << j)) {
+            const uint32_t v = values[j];
+            bool railed;
+            if (adcIsSigned) {
+                const int32_t sv = (int32_t)v;
+                const int32_t posRail = (int32_t)(adcMax >> 1);
+                const int32_t negRail = -(int32_t)((adcMax >> 1) + 1);
+                railed = (sv >= posRail) || (sv <= negRail);
+            } else {
+                railed = (v == 0u) || (v >= adcMax);
+            }
+            if (railed) clipMask |= (1U << j);
+        }
+    }
+    *pClip = clipMask;
+    return validMask;
+}
+
+/* Streaming_BuildChannelMapping's plan calls for @p m. */
+static void build_plan(const RefMapping* m, AcqPlan_t* plan)
+{
+    AcqPlan_Reset(plan);
+    for (uint8_t j = 0; j < m->count; j++) {
+        AcqOpKind kind = ACQ_OP_LATEST;
+        if (m->t1DirectMask & (1U << j)) {
+            kind = ACQ_OP_T1_DIRECT;
+        } else if (m->type[j] == REF_AD7609) {
+            kind = ACQ_OP_AD7609;
+        }
+        AcqPlan_Add(plan, kind, m->cfgIdx[j], m->hw[j], m->channelId[j]);
+    }
+}
+
+static uint32_t g_rng = 2024u;
+
+static uint32_t rnd(uint32_t n)
+{
+    g_rng = g_rng * 1103515245u + 12345u;
+    return (g_rng >> 8) % n;
+}
+
+/* An AD7609 code as AD7609.c stores it: 18-bit two's complement, sign-extended. */
+static uint32_t ad7609_code(int32_t v)
+{
+    return (uint32_t)v;
+}
+
+/* Interesting codes near every rail, plus random ones. */
+static uint32_t random_code(uint8_t type)
+{
+    static const uint32_t mc12b[] = { 0u, 1u, 2048u, 4094u, 4095u, 4096u, 70000u };
+    static const int32_t ad7609[] = { -131072, -131071, -1, 0, 1, 131070, 131071, 131072 };
+    if (rnd(2)) {
+        return (type == REF_AD7609) ? ad7609_code(ad7609[rnd(8)]) : mc12b[rnd(7)];
+    }
+    if (type == REF_AD7609) {
+        return ad7609_code((int32_t)rnd(262144u) - 131072);
+    }
+    return rnd(4096u);
+}
+
+static void random_mapping(RefMapping* m)
+{
+    memset(m, 0, sizeof(*m));
+    m->count = (uint8_t)(1u + rnd(16));
+    uint8_t cfg = 0;
+    for (uint8_t j = 0; j < m->count; j++) {
+        cfg = (uint8_t)(cfg + 1u + rnd(2));
+        m->cfgIdx[j] = cfg;
+        m->channelId[j] = (uint8_t)rnd(24);
+        m->type[j] = (uint8_t)(rnd(3) == 0 ? REF_AD7609 : REF_MC12B);
+        if (m->type[j] == REF_MC12B && rnd(2)) {
+            m->t1DirectMask |= (uint16_t)(1u << j);
+            m->hw[j] = (uint8_t)j;      /* distinct per channel, like ADCHS T1 modules */
+        }
+    }
+}
+
+/* Loads the same random codes into every source for this tick. */
+static void random_tick(const RefMapping* m)
+{
+    for (uint8_t j = 0; j < m->count; j++) {
+        uint32_t code = random_code(m->type[j]);
+        if (m->t1DirectMask & (1U << j)) {
+            if (rnd(8)) convert(m->hw[j], code);
+        } else if (rnd(8)) {
+            g_board.latestTs[m->cfgIdx[j]] = 1u + rnd(1000u);
+            g_board.latestValue[m->cfgIdx[j]] = code;
+        } else {
+            g_board.latestTs[m->cfgIdx[j]] = 0u;
+        }
+    }
+}
+
+/* --- Tests ------------------------------------------------------------------- */
+
+TEST(test_builder_ranges_and_rails)
+{
+    AcqPlan_t plan;
+    AcqPlan_Reset(&plan);
+    ASSERT_TRUE(AcqPlan_Add(&plan, ACQ_OP_T1_DIRECT, 3, 11, 0));
+    ASSERT_TRUE(AcqPlan_Add(&plan, ACQ_OP_LATEST, 5, 0, 7));
+    ASSERT_TRUE(AcqPlan_Add(&plan, ACQ_OP_AD7609, 9, 0, 2));
+    ASSERT_EQ(plan.count, 3);
+    ASSERT_EQ(plan.t1Count, 1);
+    ASSERT_EQ(plan.op[0].kind, ACQ_OP_T1_DIRECT);
+    ASSERT_EQ(plan.op[0].hwChannel, 11);
+    ASSERT_EQ(plan.op[0].slot, 3);
+    ASSERT_EQ(plan.op[0].adcMax, 4095u);
+    ASSERT_EQ(plan.op[1].adcMax, 4095u);
+    ASSERT_EQ(plan.op[1].channelId, 7);
+    ASSERT_EQ(plan.op[2].adcMax, 262143u);
+    ASSERT_EQ(plan.op[2].railBias, 0x80000000u);
+
+    /* 16 channels fit, the 17th does not and leaves the plan alone */
+    AcqPlan_Reset(&plan);
+    for (uint8_t j = 0; j < ACQ_PLAN_MAX_CHANNELS; j++) {
+        ASSERT_TRUE(AcqPlan_Add(&plan, ACQ_OP_LATEST, j, 0, j));
+    }
+    ASSERT_FALSE(AcqPlan_Add(&plan, ACQ_OP_AD7609, 16, 0, 16));
+    ASSERT_EQ(plan.count, ACQ_PLAN_MAX_CHANNELS);
+}
+
+TEST(test_rails_per_kind)
+{
+    AcqPlan_t plan;
+    AcqPlan_Reset(&plan);
+    AcqPlan_Add(&plan, ACQ_OP_LATEST, 0, 0, 0);
+    AcqPlan_Add(&plan, ACQ_OP_AD7609, 1, 0, 1);
+    memset(&g_board, 0, sizeof(g_board));
+    g_board.latestTs[0] = g_board.latestTs[1] = 1u;
+
+    static const struct { uint32_t mc12b; int32_t ad; uint32_t clip; } cases[] = {
+        { 0u,    0,       0x1 },    /* 0 is a rail for MC12b, mid-scale for AD7609 */
+        { 1u,    -1,      0x0 },    /* -1 sign-extends to 0xFFFFFFFF: not a rail */
+        { 4094u, 131070,  0x0 },
+        { 4095u, 131071,  0x3 },    /* positive full scale */
+        { 5000u, -131072, 0x3 },    /* over range / negative full scale */
+        { 2048u, -131071, 0x0 },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        uint32_t values[2], clip = 0xFFu;
+        uint32_t stamp = 1u;
+        g_board.latestValue[0] = cases[i].mc12b;
+        g_board.latestValue[1] = ad7609_code(cases[i].ad);
+        ASSERT_EQ(AcqPlan_RunHardware(&plan, &kFakeIo, &stamp, values, &clip), 0x3);
+        ASSERT_EQ(clip, cases[i].clip);
+        ASSERT_EQ(values[1], ad7609_code(cases[i].ad));
+    }
+
+    /* synthetic codes are unsigned on an AD7609 too: 0 and adcMax are rails */
+    uint32_t values[2], clip;
+    ASSERT_EQ(AcqPlan_RunSynthetic(&plan, 3, 0, values, &clip), 0x3);
+    ASSERT_EQ(values[0], 4095u);
+    ASSERT_EQ(values[1], 262143u);
+    ASSERT_EQ(clip, 0x3);
+    ASSERT_EQ(AcqPlan_RunSynthetic(&plan, 2, 0, values, &clip), 0x3);
+    ASSERT_EQ(values[1], 131071u);
+    ASSERT_EQ(clip, 0x0);
+    /* PIPELINE without a pattern generates zeros: valid, and at the low rail */
+    ASSERT_EQ(AcqPlan_RunSynthetic(&plan, 0, 12345, values, &clip), 0x3);
+    ASSERT_EQ(values[0], 0u);
+    ASSERT_EQ(clip, 0x3);
+}
+
+TEST(test_t1_direct_ardy_gate_and_writeback)
+{
+    AcqPlan_t plan;
+    AcqPlan_Reset(&plan);
+    AcqPlan_Add(&plan, ACQ_OP_T1_DIRECT, 4, 2, 9);
+    AcqPlan_Add(&plan, ACQ_OP_LATEST, 6, 0, 10);
+    memset(&g_board, 0, sizeof(g_board));
+
+    uint32_t values[2] = { 0xDEADu, 0xBEEFu }, clip;
+    uint32_t stamp = 777u;
+    convert(2, 1234u);
+    /* LATEST slot still invalid (#533): only the T1 channel is valid */
+    ASSERT_EQ(AcqPlan_RunHardware(&plan, &kFakeIo, &stamp, values, &clip), 0x1);
+    ASSERT_EQ(values[0], 1234u);
+    ASSERT_EQ(values[1], 0xBEEFu);              /* untouched */
+    ASSERT_EQ(g_board.stores, 1);
+    ASSERT_EQ(g_board.latestTs[4], 777u);       /* MEAS:VOLT:DC? stays live */
+    ASSERT_EQ(g_board.latestValue[4], 1234u);
+    ASSERT_EQ(g_board.latestChannel[4], 9);
+    ASSERT_EQ(g_board.ardy, 0u);                /* the read cleared ARDY */
+
+    /* no new conversion: a miss, counted, no spin (one read per tick) */
+    g_board.latestTs[6] = 5u;
+    g_board.latestValue[6] = 100u;
+    g_board.reads = 0;
+    ASSERT_EQ(AcqPlan_RunHardware(&plan, &kFakeIo, &stamp, values, &clip), 0x2);
+    ASSERT_EQ(g_board.misses, 1);
+    ASSERT_EQ(g_board.reads, 1);
+    ASSERT_EQ(g_board.stores, 1);
+    ASSERT_EQ(values[1], 100u);
+    ASSERT_EQ(clip, 0x0);
+}
+
+TEST(test_plan_matches_old_loop)
+{
+    static FakeBoard before;
+    unsigned frames = 0, mismatches = 0;
+    for (int cfg = 0; cfg < 2000; cfg++) {
+        RefMapping m;
+        AcqPlan_t plan;
+        random_mapping(&m);
+        build_plan(&m, &plan);
+        ASSERT_EQ(plan.count, m.count);
+
+        for (int tick = 0; tick < 50; tick++) {
+            uint32_t pattern = 0, bench = 0;
+            switch (rnd(6)) {
+                case 0: pattern = 1u + rnd(6); break;
+                case 1: bench = BENCHMARK_PIPELINE; pattern = rnd(7); break;
+                case 2: pattern = 9u; break;            /* unknown pattern -> 0 */
+                default: break;
+            }
+            uint64_t sampleCount = ((uint64_t)rnd(1u << 20) << 20) | rnd(1u << 20);
+            uint32_t stamp = 1u + rnd(100000u);
+
+            memset(&g_board, 0, sizeof(g_board));
+            random_tick(&m);
+            before = g_board;
+
+            uint32_t refValues[16] = {0}, refClip;
+            uint32_t refValid = ref_frame(&m, pattern, bench, sampleCount, stamp, refValues, &refClip);
+            FakeBoard refBoard = g_board;
+
+            g_board = before;
+            uint32_t values[16] = {0}, clip, valid;
+            if (bench == BENCHMARK_PIPELINE || pattern != 0) {
+                valid = AcqPlan_RunSynthetic(&plan, pattern, sampleCount, values, &clip);
+            } else {
+                valid = AcqPlan_RunHardware(&plan, &kFakeIo, &stamp, values, &clip);
+            }
+
+            frames++;
+            bool same = valid == refValid && clip == refClip &&
+                        memcmp(values, refValues, sizeof(values)) == 0 &&
+                        g_board.misses == refBoard.misses && g_board.stores == refBoard.stores &&
+                        g_board.ardy == refBoard.ardy &&
+                        memcmp(g_board.latestTs, refBoard.latestTs, sizeof(g_board.latestTs)) == 0 &&
+                        memcmp(g_board.latestValue, refBoard.latestValue, sizeof(g_board.latestValue)) == 0;
+            if (!same && mismatches++ < 5) {
+                printf("    cfg %d tick %d: valid %x/%x clip %x/%x\n", cfg, tick,
+                       (unsigned)valid, (unsigned)refValid, (unsigned)clip, (unsigned)refClip);
+            }
+        }
+    }
+    printf("    %u frames, %u mismatches\n", frames, mismatches);
+    ASSERT_EQ(mismatches, 0);
+}
+
+TEST(test_generator_patterns)
+{
+    /* spot values from the pattern definitions */
+    ASSERT_EQ(AcqPlan_GenerateTestValue(1, 3, 4093, 4095), 4096u % 4096u);
+    ASSERT_EQ(AcqPlan_GenerateTestValue(2, 0, 99, 262143), 131071u);
+    ASSERT_EQ(AcqPlan_GenerateTestValue(4, 1, 3000, 4095), 6000u % 4096u);
+    ASSERT_EQ(AcqPlan_GenerateTestValue(5, 0, 4096, 4095), 4095u);      /* top of the triangle */
+    ASSERT_EQ(AcqPlan_GenerateTestValue(5, 0, 8191, 4095), 0u);
+    ASSERT_EQ(AcqPlan_GenerateTestValue(6, 0, 0, 4095), 2048u);         /* sine mid-scale */
+    ASSERT_EQ(AcqPlan_GenerateTestValue(6, 0, 64, 4095), 4095u);        /* peak, clamped */
+    ASSERT_EQ(AcqPlan_GenerateTestValue(6, 0, 192, 262143), 0u);
+    ASSERT_EQ(AcqPlan_GenerateTestValue(7, 0, 1, 4095), 0u);
+    for (uint32_t s = 0; s < 5000; s++) {
+        ASSERT_TRUE(AcqPlan_GenerateTestValue(6, (uint8_t)(s % 16), s, 262143) <= 262143u);
+    }
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+TEST(test_sixteen_channel_frame_cost)
+{
+    RefMapping m;
+    memset(&m, 0, sizeof(m));
+    m.count = 16;
+    for (uint8_t j = 0; j < 16; j++) {
+        m.cfgIdx[j] = j;
+        m.channelId[j] = j;
+        m.type[j] = (j < 8) ? REF_AD7609 : REF_MC12B;
+        if (j >= 12) {
+            m.t1DirectMask |= (uint16_t)(1u << j);
+            m.hw[j] = j;
+        }
+    }
+    AcqPlan_t plan;
+    build_plan(&m, &plan);
+    memset(&g_board, 0, sizeof(g_board));
+    for (uint8_t j = 0; j < 16; j++) {
+        g_board.latestTs[j] = 1u;
+        g_board.latestValue[j] = 1000u + j;
+    }
+
+    const int frames = 200000;
+    uint32_t values[16], clip, stamp = 1u, sink = 0;
+    double t0 = now_ns();
+    for (int f = 0; f < frames; f++) {
+        g_board.ardy = 0xF000u;
+        sink += ref_frame(&m, 0, 0, (uint64_t)f, stamp, values, &clip);
+    }
+    double t1 = now_ns();
+    for (int f = 0; f < frames; f++) {
+        g_board.ardy = 0xF000u;
+        sink += AcqPlan_RunHardware(&plan, &kFakeIo, &stamp, values, &clip);
+    }
+    double t2 = now_ns();
+    ASSERT_EQ(sink, (uint32_t)(2u * (uint32_t)frames * 0xFFFFu));
+    printf("    16 channels (8 AD7609, 4 T2, 4 T1): %.0f ns/frame old loop, %.0f ns/frame plan\n",
+           (t1 - t0) / frames, (t2 - t1) / frames);
+}
+
+int main(void)
+{
+    printf("Acquisition plan (deferred tick task)\n");
+    printf("-------------------------------------\n");
+    RUN(test_builder_ranges_and_rails);
+    RUN(test_rails_per_kind);
+    RUN(test_t1_direct_ardy_gate_and_writeback);
+    RUN(test_plan_matches_old_loop);
+    RUN(test_generator_patterns);
+    RUN(test_sixteen_channel_frame_cost);
+    return TEST_SUMMARY();
+}
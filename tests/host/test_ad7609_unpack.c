@@ -0,0 +1,260 @@
+/* ==========================================================================
+ * test_ad7609_unpack.c — host unit tests for firmware/src/Util/AD7609Unpack.c
+ *
+ * The word-at-a-time AD7609 frame unpacker, checked against a copy of the
+ * per-channel window reader it replaced in AD7609_ReadSamples (4-byte
+ * window over a 19-byte padded buffer, shift, mask, branchy sign extend):
+ * every 18-bit code at every channel position, random frames, and packed
+ * output over random enabled subsets. Prints ns/frame, old reader vs new.
+ *
+ * Run: make -C tests/host run
+ * ========================================================================== */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "AD7609Unpack.h"       /* real header (via -I firmware/src/Util) */
+#include "test_framework.h"
+
+static uint32_t rng_state = 0x7D0C1A55u;
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+/* --- Reference: the reader AD7609Unpack replaced ----------------------------- */
+
+static uint32_t ref_extract18(const uint8_t* buf, uint16_t bitPos) {
+    size_t byteIndex = bitPos >> 3;
+    uint8_t bitInByte = (uint8_t)(bitPos & 0x7U);
+    uint32_t window = ((uint32_t)buf[byteIndex]     << 24) |
+                      ((uint32_t)buf[byteIndex + 1U] << 16) |
+                      ((uint32_t)buf[byteIndex + 2U] << 8)  |
+                      ((uint32_t)buf[byteIndex + 3U]);
+    return ((window << bitInByte) >> (32 - 18)) & 0x3FFFFU;
+}
+
+static uint32_t ref_channel(const uint8_t* padded, uint8_t hw) {
+    uint32_t v = ref_extract18(padded, (uint16_t)(hw * 18u));
+    if (v & 0x20000u) {
+        v |= 0xFFFC0000U;
+    }
+    return v;
+}
+
+/* The SPI RX buffer: word-aligned, 18 bytes; the reference reads a padded
+ * copy, as the old 19-byte buffer did. */
+static _Alignas(4) uint8_t frame[AD7609_FRAME_BYTES];
+static uint8_t padded[AD7609_FRAME_BYTES + 1];
+
+static void random_frame(void) {
+    for (uint32_t i = 0; i < AD7609_FRAME_BYTES; i++) {
+        frame[i] = (uint8_t)rng();
+    }
+}
+
+/* Write an 18-bit code at channel position hw, MSB first. */
+static void put_code(uint8_t hw, uint32_t code) {
+    for (uint32_t b = 0; b < 18u; b++) {
+        uint32_t bit = hw * 18u + b;
+        uint8_t mask = (uint8_t)(0x80u >> (bit & 7u));
+        if ((code >> (17u - b)) & 1u) {
+            frame[bit >> 3] |= mask;
+        } else {
+            frame[bit >> 3] &= (uint8_t)~mask;
+        }
+    }
+}
+
+/* Number of channels where AD7609Unpack_Frame disagrees with the reference. */
+static uint32_t mismatches(void) {
+    int32_t out[AD7609_FRAME_CHANNELS];
+    memcpy(padded, frame, AD7609_FRAME_BYTES);
+    padded[AD7609_FRAME_BYTES] = (uint8_t)rng();    /* padding is don't-care */
+    AD7609Unpack_Frame(frame, out);
+    uint32_t bad = 0;
+    for (uint8_t hw = 0; hw < AD7609_FRAME_CHANNELS; hw++) {
+        bad += (uint32_t)out[hw] != ref_channel(padded, hw);
+    }
+    return bad;
+}
+
+/* --- Tests ------------------------------------------------------------------- */
+
+TEST(test_known_frames)
+{
+    int32_t out[AD7609_FRAME_CHANNELS];
+
+    memset(frame, 0, sizeof(frame));
+    AD7609Unpack_Frame(frame, out);
+    for (uint8_t hw = 0; hw < AD7609_FRAME_CHANNELS; hw++) {
+        ASSERT_EQ(out[hw], 0);
+    }
+
+    memset(frame, 0xFF, sizeof(frame));
+    AD7609Unpack_Frame(frame, out);
+    for (uint8_t hw = 0; hw < AD7609_FRAME_CHANNELS; hw++) {
+        ASSERT_EQ(out[hw], -1);
+    }
+
+    /* Rails and mid-scale neighbours on alternating channels. */
+    static const uint32_t codes[AD7609_FRAME_CHANNELS] = {
+        0x1FFFFu, 0x20000u, 0x00001u, 0x3FFFFu, 0x20001u, 0x00000u, 0x2AAAAu, 0x15555u,
+    };
+    static const int32_t want[AD7609_FRAME_CHANNELS] = {
+        131071, -131072, 1, -1, -131071, 0, -87382, 87381,
+    };
+    for (uint8_t hw = 0; hw < AD7609_FRAME_CHANNELS; hw++) {
+        put_code(hw, codes[hw]);
+    }
+    AD7609Unpack_Frame(frame, out);
+    for (uint8_t hw = 0; hw < AD7609_FRAME_CHANNELS; hw++) {
+        ASSERT_EQ(out[hw], want[hw]);
+    }
+    ASSERT_EQ(mismatches(), 0u);
+}
+
+TEST(test_every_code_every_channel)
+{
+    /* All 2^18 codes at each position, random neighbours each time. */
+    uint32_t bad = 0;
+    for (uint8_t hw = 0; hw < AD7609_FRAME_CHANNELS; hw++) {
+        for (uint32_t code = 0; code < (1u << 18); code++) {
+            random_frame();
+            put_code(hw, code);
+            bad += mismatches();
+        }
+    }
+    ASSERT_EQ(bad, 0u);
+}
+
+TEST(test_random_frames)
+{
+    uint32_t bad = 0;
+    for (uint32_t iter = 0; iter < 1000000u; iter++) {
+        random_frame();
+        bad += mismatches();
+    }
+    ASSERT_EQ(bad, 0u);
+}
+
+TEST(test_slot_map)
+{
+    AD7609SlotMap_t map;
+    AD7609SlotMap_Reset(&map);
+    ASSERT_EQ(map.count, 0u);
+
+    ASSERT_FALSE(AD7609SlotMap_Add(&map, 8, 0, 0));     /* hw out of range */
+    ASSERT_EQ(map.count, 0u);
+    for (uint8_t j = 0; j < AD7609_FRAME_CHANNELS; j++) {
+        ASSERT_TRUE(AD7609SlotMap_Add(&map, (uint8_t)(7u - j), (uint8_t)(j + 3u),
+                                      (uint8_t)(j + 100u)));
+    }
+    ASSERT_FALSE(AD7609SlotMap_Add(&map, 0, 0, 0));     /* full */
+    ASSERT_EQ(map.count, 8u);
+    ASSERT_EQ(map.hw[0], 7u);
+    ASSERT_EQ(map.slot[7], 10u);
+    ASSERT_EQ(map.channelId[7], 107u);
+
+    /* Empty map writes nothing. */
+    uint32_t values[AD7609_FRAME_CHANNELS] = {0xDEADBEEFu};
+    AD7609SlotMap_Reset(&map);
+    random_frame();
+    AD7609Unpack_Packed(frame, &map, values);
+    ASSERT_EQ(values[0], 0xDEADBEEFu);
+}
+
+TEST(test_packed_random_subsets)
+{
+    uint32_t bad = 0;
+    for (uint32_t iter = 0; iter < 100000u; iter++) {
+        /* A random subset of the channels in a random order, as a board
+         * table with IsEnabled filtering would produce. */
+        uint8_t order[AD7609_FRAME_CHANNELS];
+        for (uint8_t k = 0; k < AD7609_FRAME_CHANNELS; k++) {
+            order[k] = k;
+        }
+        for (uint8_t k = AD7609_FRAME_CHANNELS - 1u; k > 0; k--) {
+            uint8_t r = (uint8_t)(rng() % (k + 1u));
+            uint8_t t = order[k];
+            order[k] = order[r];
+            order[r] = t;
+        }
+        AD7609SlotMap_t map;
+        AD7609SlotMap_Reset(&map);
+        uint32_t enabled = rng();
+        for (uint8_t k = 0; k < AD7609_FRAME_CHANNELS; k++) {
+            if ((enabled >> k) & 1u) {
+                (void)AD7609SlotMap_Add(&map, order[k], k, (uint8_t)(order[k] + 1u));
+            }
+        }
+
+        random_frame();
+        memcpy(padded, frame, AD7609_FRAME_BYTES);
+        uint32_t values[AD7609_FRAME_CHANNELS];
+        AD7609Unpack_Packed(frame, &map, values);
+        for (uint8_t j = 0; j < map.count; j++) {
+            bad += values[j] != ref_channel(padded, map.hw[j]);
+        }
+        bad += map.count != (uint8_t)__builtin_popcount(enabled & 0xFFu);
+    }
+    ASSERT_EQ(bad, 0u);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+TEST(test_frame_cost)
+{
+    AD7609SlotMap_t map;
+    AD7609SlotMap_Reset(&map);
+    for (uint8_t hw = 0; hw < AD7609_FRAME_CHANNELS; hw++) {
+        ASSERT_TRUE(AD7609SlotMap_Add(&map, hw, hw, hw));
+    }
+    random_frame();
+    memcpy(padded, frame, AD7609_FRAME_BYTES);
+
+    const int frames = 1000000;
+    volatile uint8_t* vframe = frame;   /* keep the loads in the loop */
+    uint32_t values[AD7609_FRAME_CHANNELS], sinkOld = 0, sinkNew = 0;
+    double t0 = now_ns();
+    for (int f = 0; f < frames; f++) {
+        padded[0] = vframe[0];
+        for (uint8_t hw = 0; hw < AD7609_FRAME_CHANNELS; hw++) {
+            sinkOld += ref_channel(padded, hw);
+        }
+    }
+    double t1 = now_ns();
+    for (int f = 0; f < frames; f++) {
+        frame[0] = vframe[0];
+        AD7609Unpack_Packed(frame, &map, values);
+        for (uint8_t j = 0; j < AD7609_FRAME_CHANNELS; j++) {
+            sinkNew += values[j];
+        }
+    }
+    double t2 = now_ns();
+    ASSERT_EQ(sinkOld, sinkNew);
+    printf("    8 channels: %.1f ns/frame old reader, %.1f ns/frame unpacker\n",
+           (t1 - t0) / frames, (t2 - t1) / frames);
+}
+
+int main(void)
+{
+    printf("AD7609 frame unpacker\n");
+    printf("---------------------\n");
+    RUN(test_known_frames);
+    RUN(test_every_code_every_channel);
+    RUN(test_random_frames);
+    RUN(test_slot_map);
+    RUN(test_packed_random_subsets);
+    RUN(test_frame_cost);
+    return TEST_SUMMARY();
+}
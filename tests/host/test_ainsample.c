@@ -0,0 +1,373 @@
+/* ==========================================================================
+ * test_ainsample.c — PC host unit + stress tests for
+ * firmware/src/state/data/AInSample.c (the AIN sample slot ring)
+ *
+ * The pool is a wait-free SPSC ring: the deferred ISR task allocates and
+ * publishes, streaming_Task pops and frees, with no lock between them. The
+ * unit cases pin the single-threaded contract (FIFO order, exhaustion at
+ * capacity, claim drop, double/out-of-order free ignored, PushBack of a
+ * foreign pointer rejected, in-use / high-water accounting, a capacity that
+ * is not a power of two). The stress case runs a real producer and consumer
+ * on two pthreads and checks every sample arrives exactly once, in order and
+ * untorn, while the free-running counters cross 2^32.
+ *
+ * White-box: the source is #included so the tests can seed the ring's
+ * counters near UINT32_MAX (same idea as the CircularBuffer wrap tests).
+ * Its quoted "AInSample.h" resolves next to the source; everything else
+ * (FreeRTOS.h, Util/Logger.h) comes from -Istubs.
+ * ========================================================================== */
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "state/data/AInSample.c"
+#include "test_framework.h"
+
+#define TEST_CHANNELS   4u
+#define TEST_CAPACITY   101u    /* > MIN_AIN_SAMPLE_COUNT, not a power of two */
+
+/* One spare slot past capacity so "not from our pool" can be probed with an
+ * in-bounds pointer. */
+static uint8_t g_slots[(TEST_CAPACITY + 1u) * (sizeof(AInPublicSampleList_t) + 16u * sizeof(uint32_t))];
+
+static void ring_init(uint32_t capacity)
+{
+    memset(g_slots, 0xA5, sizeof(g_slots));
+    AInSampleList_InitializeExternal(g_slots, capacity,
+                                     AInSampleList_ElementSize(TEST_CHANNELS));
+}
+
+/* Seed all three free-running counters to the same value, as if `start`
+ * samples had already gone through the ring. Slot indices stay at 0: only
+ * the counter differences matter to the ring. */
+static void ring_seed(uint32_t start)
+{
+    ringProduced = start;
+    ringPopped   = start;
+    ringReleased = start;
+}
+
+static bool produce(uint32_t seq)
+{
+    AInPublicSampleList_t* s = AInSampleList_AllocateFromPool();
+    if (s == NULL) {
+        return false;
+    }
+    s->Timestamp = seq;
+    s->channelCount = TEST_CHANNELS;
+    s->validMask = (uint16_t)((1u << TEST_CHANNELS) - 1u);
+    for (uint32_t c = 0; c < TEST_CHANNELS; c++) {
+        s->Values[c] = seq ^ (0x01010101u * (c + 1u));
+    }
+    if (!AInSampleList_PushBack(s)) {
+        AInSampleList_FreeToPool(s);
+        return false;
+    }
+    return true;
+}
+
+/* Returns true if the sample is whole: every value derives from Timestamp. */
+static bool sample_intact(const AInPublicSampleList_t* s)
+{
+    if (s->channelCount != TEST_CHANNELS) return false;
+    for (uint32_t c = 0; c < TEST_CHANNELS; c++) {
+        if (s->Values[c] != (s->Timestamp ^ (0x01010101u * (c + 1u)))) return false;
+    }
+    return true;
+}
+
+/* ==========================================================================
+ * Single-threaded contract
+ * ========================================================================== */
+TEST(test_fifo_order)
+{
+    ring_init(TEST_CAPACITY);
+    for (uint32_t i = 0; i < 10; i++) {
+        ASSERT_TRUE(produce(i));
+    }
+    ASSERT_EQ(AInSampleList_Size(), 10);
+    ASSERT_FALSE(AInSampleList_IsEmpty());
+
+    AInPublicSampleList_t* peek = NULL;
+    ASSERT_TRUE(AInSampleList_PeekFront(&peek));
+    ASSERT_EQ(peek->Timestamp, 0);
+    ASSERT_EQ(AInSampleList_Size(), 10);     /* peek doesn't consume */
+
+    for (uint32_t i = 0; i < 10; i++) {
+        AInPublicSampleList_t* s = NULL;
+        ASSERT_TRUE(AInSampleList_PopFront(&s));
+        ASSERT_EQ(s->Timestamp, i);
+        ASSERT_TRUE(sample_intact(s));
+        AInSampleList_FreeToPool(s);
+    }
+    AInPublicSampleList_t* s = NULL;
+    ASSERT_FALSE(AInSampleList_PopFront(&s));
+    ASSERT_TRUE(AInSampleList_IsEmpty());
+    ASSERT_EQ(AInSampleList_PoolInUse(), 0);
+}
+
+TEST(test_alloc_clears_slot)
+{
+    ring_init(TEST_CAPACITY);   /* slots start as 0xA5 garbage */
+    AInPublicSampleList_t* s = AInSampleList_AllocateFromPool();
+    ASSERT_TRUE(s != NULL);
+    ASSERT_EQ(s->Timestamp, 0);
+    ASSERT_EQ(s->validMask, 0);
+    for (uint32_t c = 0; c < TEST_CHANNELS; c++) {
+        ASSERT_EQ(s->Values[c], 0);
+    }
+    AInSampleList_FreeToPool(s);
+}
+
+TEST(test_exhaustion_at_capacity)
+{
+    ring_init(TEST_CAPACITY);
+    for (uint32_t i = 0; i < TEST_CAPACITY; i++) {
+        ASSERT_TRUE(produce(i));
+    }
+    ASSERT_EQ(AInSampleList_PoolInUse(), TEST_CAPACITY);
+    ASSERT_TRUE(AInSampleList_AllocateFromPool() == NULL);
+
+    /* Popped but not yet freed still holds the slot (encoder owns it). */
+    AInPublicSampleList_t* s = NULL;
+    ASSERT_TRUE(AInSampleList_PopFront(&s));
+    ASSERT_TRUE(AInSampleList_AllocateFromPool() == NULL);
+
+    AInSampleList_FreeToPool(s);
+    ASSERT_TRUE(produce(TEST_CAPACITY));     /* reuses the freed slot */
+    ASSERT_TRUE(AInSampleList_AllocateFromPool() == NULL);
+    ASSERT_EQ(AInSampleList_PoolMaxUsed(), TEST_CAPACITY);
+}
+
+TEST(test_claim_drop_and_single_claim)
+{
+    ring_init(TEST_CAPACITY);
+    AInPublicSampleList_t* a = AInSampleList_AllocateFromPool();
+    ASSERT_TRUE(a != NULL);
+    ASSERT_TRUE(AInSampleList_AllocateFromPool() == NULL);  /* one claim at a time */
+    ASSERT_EQ(AInSampleList_PoolInUse(), 1);
+
+    AInSampleList_FreeToPool(a);                            /* drop unpublished claim */
+    ASSERT_EQ(AInSampleList_PoolInUse(), 0);
+    ASSERT_TRUE(AInSampleList_IsEmpty());
+    ASSERT_FALSE(AInSampleList_PushBack(a));                /* claim is gone */
+
+    AInPublicSampleList_t* b = AInSampleList_AllocateFromPool();
+    ASSERT_TRUE(b == a);                                    /* same slot handed out again */
+    ASSERT_TRUE(AInSampleList_PushBack(b));
+    ASSERT_EQ(AInSampleList_Size(), 1);
+}
+
+TEST(test_pushback_rejects_foreign)
+{
+    ring_init(TEST_CAPACITY);
+    AInPublicSampleList_t* a = AInSampleList_AllocateFromPool();
+    ASSERT_TRUE(a != NULL);
+    AInPublicSampleList_t* other = (AInPublicSampleList_t*)
+        ((uint8_t*)a + AInSampleList_ElementSize(TEST_CHANNELS));
+    ASSERT_FALSE(AInSampleList_PushBack(other));
+    ASSERT_FALSE(AInSampleList_PushBack(NULL));
+    ASSERT_TRUE(AInSampleList_PushBack(a));
+    ASSERT_FALSE(AInSampleList_PushBack(a));               /* already published */
+    ASSERT_EQ(AInSampleList_Size(), 1);
+}
+
+TEST(test_bad_frees_ignored)
+{
+    ring_init(TEST_CAPACITY);
+    ASSERT_TRUE(produce(1));
+    ASSERT_TRUE(produce(2));
+    AInPublicSampleList_t* s1 = NULL;
+    AInPublicSampleList_t* s2 = NULL;
+    ASSERT_TRUE(AInSampleList_PopFront(&s1));
+    ASSERT_TRUE(AInSampleList_PopFront(&s2));
+
+    AInSampleList_FreeToPool(s2);                           /* out of order: ignored */
+    ASSERT_EQ(AInSampleList_PoolInUse(), 2);
+    AInSampleList_FreeToPool((AInPublicSampleList_t*)((uint8_t*)s1 + 1)); /* misaligned */
+    AInSampleList_FreeToPool((AInPublicSampleList_t*)                    /* past capacity */
+        (g_slots + TEST_CAPACITY * AInSampleList_ElementSize(TEST_CHANNELS)));
+    AInSampleList_FreeToPool(NULL);
+    ASSERT_EQ(AInSampleList_PoolInUse(), 2);
+
+    AInSampleList_FreeToPool(s1);
+    ASSERT_EQ(AInSampleList_PoolInUse(), 1);
+    AInSampleList_FreeToPool(s1);                           /* double free: ignored */
+    ASSERT_EQ(AInSampleList_PoolInUse(), 1);
+    AInSampleList_FreeToPool(s2);
+    ASSERT_EQ(AInSampleList_PoolInUse(), 0);
+
+    /* A queued (not yet popped) slot can't be freed out from under the queue. */
+    ASSERT_TRUE(produce(3));
+    AInPublicSampleList_t* q = NULL;
+    ASSERT_TRUE(AInSampleList_PeekFront(&q));
+    AInSampleList_FreeToPool(q);
+    ASSERT_EQ(AInSampleList_Size(), 1);
+    ASSERT_EQ(AInSampleList_PoolInUse(), 1);
+}
+
+TEST(test_high_water_mark)
+{
+    ring_init(TEST_CAPACITY);
+    for (uint32_t i = 0; i < 7; i++) ASSERT_TRUE(produce(i));
+    ASSERT_EQ(AInSampleList_PoolMaxUsed(), 7);
+    for (uint32_t i = 0; i < 5; i++) {
+        AInPublicSampleList_t* s = NULL;
+        ASSERT_TRUE(AInSampleList_PopFront(&s));
+        AInSampleList_FreeToPool(s);
+    }
+    ASSERT_EQ(AInSampleList_PoolInUse(), 2);
+    ASSERT_EQ(AInSampleList_PoolMaxUsed(), 7);
+    AInSampleList_PoolResetMaxUsed();
+    ASSERT_EQ(AInSampleList_PoolMaxUsed(), 2);
+}
+
+TEST(test_slot_index_wrap_non_pow2)
+{
+    /* Several laps of a 101-slot ring at a fill level that never divides it:
+     * slot indices wrap mid-batch and pointers must still come back in
+     * order and inside the pool. */
+    ring_init(TEST_CAPACITY);
+    uint32_t next = 0;
+    uint8_t* lo = g_slots;
+    uint8_t* hi = g_slots + TEST_CAPACITY * AInSampleList_ElementSize(TEST_CHANNELS);
+    for (uint32_t lap = 0; lap < 40; lap++) {
+        for (uint32_t i = 0; i < 37; i++) ASSERT_TRUE(produce(lap * 37u + i));
+        for (uint32_t i = 0; i < 37; i++) {
+            AInPublicSampleList_t* s = NULL;
+            ASSERT_TRUE(AInSampleList_PopFront(&s));
+            ASSERT_TRUE((uint8_t*)s >= lo && (uint8_t*)s < hi);
+            ASSERT_EQ(s->Timestamp, next);
+            next++;
+            AInSampleList_FreeToPool(s);
+        }
+    }
+    ASSERT_EQ(AInSampleList_PoolInUse(), 0);
+}
+
+TEST(test_counter_wrap)
+{
+    ring_init(TEST_CAPACITY);
+    ring_seed(0xFFFFFFF0u);
+    for (uint32_t i = 0; i < TEST_CAPACITY; i++) ASSERT_TRUE(produce(i));
+    ASSERT_TRUE(ringProduced < 0xFFFFFFF0u);               /* crossed 2^32 */
+    ASSERT_EQ(AInSampleList_Size(), TEST_CAPACITY);
+    ASSERT_EQ(AInSampleList_PoolInUse(), TEST_CAPACITY);
+    ASSERT_TRUE(AInSampleList_AllocateFromPool() == NULL);
+
+    for (uint32_t i = 0; i < TEST_CAPACITY; i++) {
+        AInPublicSampleList_t* s = NULL;
+        ASSERT_TRUE(AInSampleList_PopFront(&s));
+        ASSERT_EQ(s->Timestamp, i);
+        AInSampleList_FreeToPool(s);
+    }
+    ASSERT_TRUE(AInSampleList_IsEmpty());
+    ASSERT_EQ(AInSampleList_PoolInUse(), 0);
+}
+
+TEST(test_reinit_resets)
+{
+    ring_init(TEST_CAPACITY);
+    ASSERT_TRUE(produce(1));
+    ASSERT_TRUE(AInSampleList_AllocateFromPool() != NULL);  /* dangling claim */
+    ring_init(TEST_CAPACITY);
+    ASSERT_TRUE(AInSampleList_IsEmpty());
+    ASSERT_EQ(AInSampleList_PoolInUse(), 0);
+    ASSERT_EQ(AInSampleList_PoolMaxUsed(), 0);
+    ASSERT_TRUE(produce(2));
+
+    AInSampleList_Destroy();
+    AInPublicSampleList_t* s = NULL;
+    ASSERT_FALSE(AInSampleList_PopFront(&s));
+    ASSERT_TRUE(AInSampleList_AllocateFromPool() == NULL);
+    ASSERT_EQ(AInSampleList_PoolCapacity(), 0);
+}
+
+/* ==========================================================================
+ * Two-thread stress: real producer vs real consumer, no lock between them.
+ * The producer retries until each sequence number is accepted, so the
+ * consumer must see 0, 1, 2, ... with nothing missing or repeated, and
+ * every sample's values must match its timestamp (no half-written slot was
+ * published, no live slot was handed out twice).
+ * ========================================================================== */
+#define STRESS_SAMPLES 2000000u
+
+static volatile int g_stress_bad_order;
+static volatile int g_stress_torn;
+
+static void* stress_producer(void* arg)
+{
+    (void)arg;
+    for (uint32_t seq = 0; seq < STRESS_SAMPLES; ) {
+        if (produce(seq)) {
+            seq++;
+        } else {
+            sched_yield();   /* ring full: let the consumer run (1-CPU hosts) */
+        }
+    }
+    return NULL;
+}
+
+static void* stress_consumer(void* arg)
+{
+    (void)arg;
+    uint32_t expect = 0;
+    while (expect < STRESS_SAMPLES) {
+        AInPublicSampleList_t* s = NULL;
+        if (!AInSampleList_PopFront(&s)) {
+            sched_yield();
+            continue;
+        }
+        if (s->Timestamp != expect) {
+            g_stress_bad_order++;
+            expect = s->Timestamp;
+        }
+        if (!sample_intact(s)) {
+            g_stress_torn++;
+        }
+        expect++;
+        AInSampleList_FreeToPool(s);
+    }
+    return NULL;
+}
+
+TEST(test_two_thread_stress_across_wrap)
+{
+    ring_init(TEST_CAPACITY);
+    ring_seed(0u - (STRESS_SAMPLES / 2u));   /* counters cross 2^32 mid-run */
+    g_stress_bad_order = 0;
+    g_stress_torn = 0;
+
+    pthread_t prod, cons;
+    ASSERT_EQ(pthread_create(&cons, NULL, stress_consumer, NULL), 0);
+    ASSERT_EQ(pthread_create(&prod, NULL, stress_producer, NULL), 0);
+    pthread_join(prod, NULL);
+    pthread_join(cons, NULL);
+
+    ASSERT_EQ(g_stress_bad_order, 0);
+    ASSERT_EQ(g_stress_torn, 0);
+    ASSERT_EQ(ringProduced, (uint32_t)(STRESS_SAMPLES / 2u));
+    ASSERT_TRUE(AInSampleList_IsEmpty());
+    ASSERT_EQ(AInSampleList_PoolInUse(), 0);
+    ASSERT_TRUE(AInSampleList_PoolMaxUsed() <= TEST_CAPACITY);
+}
+
+int main(void)
+{
+    printf("AInSample slot ring host tests\n");
+    printf("---------------------------------------------\n");
+    RUN(test_fifo_order);
+    RUN(test_alloc_clears_slot);
+    RUN(test_exhaustion_at_capacity);
+    RUN(test_claim_drop_and_single_claim);
+    RUN(test_pushback_rejects_foreign);
+    RUN(test_bad_frees_ignored);
+    RUN(test_high_water_mark);
+    RUN(test_slot_index_wrap_non_pow2);
+    RUN(test_counter_wrap);
+    RUN(test_reinit_resets);
+    RUN(test_two_thread_stress_across_wrap);
+    return TEST_SUMMARY();
+}
@@ -0,0 +1,272 @@
+/* ==========================================================================
+ * test_capture_ring.c — host unit tests for firmware/src/Util/CaptureRing.c
+ *
+ * The SYST:STR:CAPture ring and trigger the deferred tick task runs. Frames
+ * carry their tick number as the timestamp, so a readout can be checked
+ * exactly: pre+post consecutive ticks, oldest first, with the trigger tick
+ * at index pre. Covers the size limits, the pre-window holdoff (a trigger
+ * before pre frames exist is ignored and counted), pre = 0, post = 1, the
+ * states along the way, random capture sizes and trigger ticks over a ring
+ * that has wrapped many times, and the trigger's source selection and
+ * edge detection on the event counters.
+ *
+ * Run: make -C tests/host run
+ * ========================================================================== */
+#include <stdint.h>
+#include <string.h>
+
+#include "CaptureRing.h"        /* real header (via -I firmware/src/Util) */
+#include "test_framework.h"
+
+static uint32_t rng_state = 0x6C8E9CF5u;
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static uint32_t ring_storage[16384];   /* 64 KB, 4-byte aligned */
+#define RING_BYTES  ((uint32_t)sizeof(ring_storage))
+
+/* Record tick `tick` into the ring the way the deferred task does. */
+static CaptureState record(CaptureRing_t* r, uint32_t tick, bool trigger) {
+    CaptureFrame_t* f = CaptureRing_Claim(r);
+    if (f == NULL) {
+        return CaptureRing_State(r);
+    }
+    f->Timestamp = tick;
+    f->validMask = (uint16_t)((1u << r->channels) - 1u);
+    f->clipMask = (uint16_t)(tick & 1u);
+    for (uint8_t j = 0; j < r->channels; j++) {
+        f->Values[j] = tick * 16u + j;
+    }
+    return CaptureRing_Commit(r, trigger);
+}
+
+/* Read the ring out; true when it is pre+post consecutive ticks ending at
+ * trigTick+post-1, every value intact. */
+static bool readout_ok(CaptureRing_t* r, uint32_t trigTick) {
+    uint32_t first = trigTick - r->pre;
+    uint32_t n = 0;
+    const CaptureFrame_t* f;
+    while ((f = CaptureRing_Peek(r)) != NULL) {
+        uint32_t tick = first + n;
+        if (f->Timestamp != tick || f->clipMask != (tick & 1u)) {
+            return false;
+        }
+        for (uint8_t j = 0; j < r->channels; j++) {
+            if (f->Values[j] != tick * 16u + j) {
+                return false;
+            }
+        }
+        CaptureRing_Consume(r);
+        n++;
+    }
+    return n == r->frames && CaptureRing_State(r) == CAPTURE_READ &&
+           r->triggerTs == trigTick;
+}
+
+TEST(test_configure_limits)
+{
+    CaptureRing_t r;
+    uint8_t* buf = (uint8_t*)ring_storage;
+
+    ASSERT_EQ(CAPTURE_FRAME_STRIDE(1), 12u);
+    ASSERT_EQ(CAPTURE_FRAME_STRIDE(16), 72u);
+    ASSERT_EQ(CaptureRing_MaxFrames(720, 16), 10u);
+    ASSERT_EQ(CaptureRing_MaxFrames(719, 16), 9u);
+    ASSERT_EQ(CaptureRing_MaxFrames(720, 0), 0u);
+    ASSERT_EQ(CaptureRing_MaxFrames(720, 17), 0u);
+
+    ASSERT_TRUE(CaptureRing_Configure(&r, buf, 720, 16, 5, 5));
+    ASSERT_EQ(CaptureRing_State(&r), CAPTURE_IDLE);
+    ASSERT_TRUE(CaptureRing_Claim(&r) == NULL);          /* not armed */
+    ASSERT_TRUE(CaptureRing_Configure(&r, buf, 720, 16, 0, 10));
+    ASSERT_FALSE(CaptureRing_Configure(&r, buf, 720, 16, 6, 5));
+    ASSERT_FALSE(CaptureRing_Configure(&r, buf, 720, 16, 0, 11));
+    ASSERT_FALSE(CaptureRing_Configure(&r, buf, 720, 16, 5, 0));   /* post >= 1 */
+    ASSERT_FALSE(CaptureRing_Configure(&r, buf, 720, 16, UINT32_MAX, 2));
+    ASSERT_FALSE(CaptureRing_Configure(&r, NULL, 720, 16, 1, 1));
+    ASSERT_FALSE(CaptureRing_Configure(&r, buf, 720, 0, 1, 1));
+}
+
+TEST(test_states_and_holdoff)
+{
+    CaptureRing_t r;
+    ASSERT_TRUE(CaptureRing_Configure(&r, (uint8_t*)ring_storage, RING_BYTES, 4, 8, 4));
+    CaptureRing_Arm(&r);
+    ASSERT_EQ(CaptureRing_State(&r), CAPTURE_FILLING);
+
+    uint32_t tick = 0;
+    /* Triggers while fewer than pre frames exist are ignored. */
+    for (; tick < 7; tick++) {
+        ASSERT_EQ(record(&r, tick, tick == 3 || tick == 6), CAPTURE_FILLING);
+    }
+    ASSERT_EQ(r.ignoredTriggers, 2u);
+    ASSERT_EQ(record(&r, tick++, false), CAPTURE_ARMED);    /* 8 frames */
+    ASSERT_TRUE(CaptureRing_Peek(&r) == NULL);
+    for (; tick < 30; tick++) {
+        ASSERT_EQ(record(&r, tick, false), CAPTURE_ARMED);
+    }
+    /* Tick 30 triggers; it and the next 3 are the post window. */
+    ASSERT_EQ(record(&r, tick++, true), CAPTURE_TRIGGERED);
+    ASSERT_EQ(record(&r, tick++, true), CAPTURE_TRIGGERED);  /* no re-trigger */
+    ASSERT_EQ(record(&r, tick++, false), CAPTURE_TRIGGERED);
+    ASSERT_EQ(record(&r, tick++, false), CAPTURE_DONE);
+    ASSERT_EQ(r.ignoredTriggers, 2u);
+
+    /* Nothing is recorded once done. */
+    ASSERT_TRUE(CaptureRing_Claim(&r) == NULL);
+    ASSERT_EQ(CaptureRing_Commit(&r, true), CAPTURE_DONE);
+
+    const CaptureFrame_t* f = CaptureRing_Peek(&r);
+    ASSERT_TRUE(f != NULL);
+    ASSERT_EQ(f->Timestamp, 22u);
+    ASSERT_TRUE(readout_ok(&r, 30));
+    ASSERT_TRUE(CaptureRing_Peek(&r) == NULL);
+    CaptureRing_Consume(&r);                                 /* harmless */
+    ASSERT_EQ(CaptureRing_State(&r), CAPTURE_READ);
+
+    /* Re-arming starts over. */
+    CaptureRing_Arm(&r);
+    ASSERT_EQ(CaptureRing_State(&r), CAPTURE_FILLING);
+    ASSERT_EQ(r.ignoredTriggers, 0u);
+    ASSERT_EQ(r.triggerTs, 0u);
+}
+
+TEST(test_edge_windows)
+{
+    CaptureRing_t r;
+
+    /* pre = 0: armed at once, the trigger frame is the first read out. */
+    ASSERT_TRUE(CaptureRing_Configure(&r, (uint8_t*)ring_storage, RING_BYTES, 1, 0, 3));
+    CaptureRing_Arm(&r);
+    ASSERT_EQ(CaptureRing_State(&r), CAPTURE_ARMED);
+    for (uint32_t t = 0; t < 10; t++) {
+        ASSERT_EQ(record(&r, t, false), CAPTURE_ARMED);
+    }
+    ASSERT_EQ(record(&r, 10, true), CAPTURE_TRIGGERED);
+    ASSERT_EQ(record(&r, 11, false), CAPTURE_TRIGGERED);
+    ASSERT_EQ(record(&r, 12, false), CAPTURE_DONE);
+    ASSERT_TRUE(readout_ok(&r, 10));
+
+    /* post = 1: the trigger frame completes the capture. */
+    ASSERT_TRUE(CaptureRing_Configure(&r, (uint8_t*)ring_storage, RING_BYTES, 2, 3, 1));
+    CaptureRing_Arm(&r);
+    for (uint32_t t = 0; t < 3; t++) {
+        record(&r, t, false);
+    }
+    ASSERT_EQ(CaptureRing_State(&r), CAPTURE_ARMED);
+    ASSERT_EQ(record(&r, 3, true), CAPTURE_DONE);
+    ASSERT_TRUE(readout_ok(&r, 3));
+
+    /* A trigger on exactly the pre-th frame counts. */
+    ASSERT_TRUE(CaptureRing_Configure(&r, (uint8_t*)ring_storage, RING_BYTES, 1, 2, 2));
+    CaptureRing_Arm(&r);
+    record(&r, 0, false);
+    record(&r, 1, false);
+    ASSERT_EQ(record(&r, 2, true), CAPTURE_TRIGGERED);
+    ASSERT_EQ(record(&r, 3, false), CAPTURE_DONE);
+    ASSERT_TRUE(readout_ok(&r, 2));
+}
+
+TEST(test_random_captures)
+{
+    uint32_t failures = 0;
+    for (uint32_t run = 0; run < 2000; run++) {
+        CaptureRing_t r;
+        uint8_t channels = (uint8_t)(1u + rng() % CAPTURE_MAX_CHANNELS);
+        uint32_t maxFrames = CaptureRing_MaxFrames(RING_BYTES, channels);
+        uint32_t frames = 1u + rng() % (run < 1000 ? 64u : maxFrames);
+        uint32_t post = 1u + rng() % frames;
+        uint32_t pre = frames - post;
+        if (!CaptureRing_Configure(&r, (uint8_t*)ring_storage, RING_BYTES,
+                                   channels, pre, post)) {
+            failures++;
+            continue;
+        }
+        CaptureRing_Arm(&r);
+        /* Early triggers are ignored; the accepted one may come after the
+         * ring has wrapped many times over. */
+        uint32_t trigTick = pre + rng() % (5u * frames + 3u);
+        uint32_t early = 0;
+        uint32_t tick = 0;
+        while (CaptureRing_State(&r) != CAPTURE_DONE && tick < trigTick + post + 1u) {
+            bool trig = (tick == trigTick);
+            if (tick < pre && (rng() & 7u) == 0u) {
+                trig = true;
+                early++;
+            }
+            record(&r, tick++, trig);
+        }
+        if (CaptureRing_State(&r) != CAPTURE_DONE || tick != trigTick + post ||
+            r.ignoredTriggers != early || !readout_ok(&r, trigTick)) {
+            failures++;
+        }
+    }
+    ASSERT_EQ(failures, 0u);
+}
+
+TEST(test_trigger_sources)
+{
+    CaptureTrigger_t t;
+
+    CaptureTrigger_Init(&t, CAPTURE_SRC_ALL, 10, 20, 30);
+    ASSERT_EQ(CaptureTrigger_Poll(&t, 10, 20, 30), 0u);
+    ASSERT_EQ(CaptureTrigger_Poll(&t, 11, 20, 30), CAPTURE_SRC_ADC_THRESHOLD);
+    ASSERT_EQ(CaptureTrigger_Poll(&t, 11, 20, 30), 0u);            /* edge, not level */
+    ASSERT_EQ(CaptureTrigger_Poll(&t, 11, 25, 30), CAPTURE_SRC_DIO_EDGE);
+    ASSERT_EQ(CaptureTrigger_Poll(&t, 12, 26, 31),
+              CAPTURE_SRC_ADC_THRESHOLD | CAPTURE_SRC_DIO_EDGE | CAPTURE_SRC_FORCE);
+
+    /* Counters wrap. */
+    CaptureTrigger_Init(&t, CAPTURE_SRC_ALL, UINT32_MAX, 0, 0);
+    ASSERT_EQ(CaptureTrigger_Poll(&t, 0, 0, 0), CAPTURE_SRC_ADC_THRESHOLD);
+
+    /* An unselected source never fires and its events are consumed; a
+     * force always fires. */
+    CaptureTrigger_Init(&t, CAPTURE_SRC_DIO_EDGE, 0, 0, 0);
+    ASSERT_EQ(CaptureTrigger_Poll(&t, 5, 0, 0), 0u);
+    ASSERT_EQ(CaptureTrigger_Poll(&t, 5, 0, 1), CAPTURE_SRC_FORCE);
+    ASSERT_EQ(CaptureTrigger_Poll(&t, 5, 1, 1), CAPTURE_SRC_DIO_EDGE);
+    CaptureTrigger_Init(&t, CAPTURE_SRC_ADC_THRESHOLD, 0, 0, 0);
+    ASSERT_EQ(CaptureTrigger_Poll(&t, 0, 9, 0), 0u);
+    ASSERT_EQ(CaptureTrigger_Poll(&t, 1, 9, 0), CAPTURE_SRC_ADC_THRESHOLD);
+}
+
+TEST(test_trigger_drives_ring)
+{
+    /* The deferred task's loop: poll every tick, commit with the result.
+     * A DIO edge during the pre fill is consumed and ignored; the next
+     * comparator trip after the window is full is the trigger. */
+    CaptureRing_t r;
+    CaptureTrigger_t t;
+    uint32_t adc = 100, edge = 7, force = 0;
+    ASSERT_TRUE(CaptureRing_Configure(&r, (uint8_t*)ring_storage, RING_BYTES, 3, 16, 16));
+    CaptureRing_Arm(&r);
+    CaptureTrigger_Init(&t, CAPTURE_SRC_ALL, adc, edge, force);
+    uint32_t tick = 0;
+    for (; CaptureRing_State(&r) != CAPTURE_DONE; tick++) {
+        if (tick == 5) edge++;
+        if (tick == 40) adc++;
+        record(&r, tick, CaptureTrigger_Poll(&t, adc, edge, force) != 0u);
+        ASSERT_TRUE(tick < 100);
+    }
+    ASSERT_EQ(r.ignoredTriggers, 1u);
+    ASSERT_EQ(tick, 56u);
+    ASSERT_TRUE(readout_ok(&r, 40));
+}
+
+int main(void)
+{
+    printf("Capture ring (SYST:STR:CAPture)\n");
+    printf("-------------------------------\n");
+    RUN(test_configure_limits);
+    RUN(test_states_and_holdoff);
+    RUN(test_edge_windows);
+    RUN(test_random_captures);
+    RUN(test_trigger_sources);
+    RUN(test_trigger_drives_ring);
+    return TEST_SUMMARY();
+}
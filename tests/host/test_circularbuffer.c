@@ -4,7 +4,8 @@
  * Issue #124. Runs with plain gcc, no firmware/RTOS deps (osal + Logger are
  * stubbed under stubs/). Covers init / AddBytes / accounting / wrap-around /
  * ProcessBytes callback semantics (#126) / Reset / InitExternal / Resize /
- * SPSC counter wraparound near UINT32_MAX.
+ * SPSC counter wraparound near UINT32_MAX / zero-copy Reserve+Commit and its
+ * wrap handling.
  *
  * White-box: tests read and (for the counter-wrap cases) directly seed struct
  * fields, so they include the real CircularBuffer.h layout.
@@ -450,6 +451,209 @@ TEST(test_counter_wrap_through_real_api)
     CircularBuf_Deinit(&cb);
 }
 
+/* ========================================================================= */
+/* Zero-copy Reserve / Commit                                                */
+/* ========================================================================= */
+
+TEST(test_reserve_commit_basic)
+{
+    CircularBuf_t cb;
+    CircularBuf_Init(&cb, NULL, 16);
+
+    uint32_t span = 99;
+    uint8_t *p = CircularBuf_Reserve(&cb, &span);
+    ASSERT_TRUE(p == cb.buf_ptr);
+    ASSERT_EQ(span, 16);
+
+    memcpy(p, "HELLOWORLD", 10);
+    /* Nothing is visible until the commit. */
+    ASSERT_EQ(CircularBuf_NumBytesAvailable(&cb), 0);
+    ASSERT_EQ(CircularBuf_Commit(&cb, 10), 10);
+    ASSERT_EQ(CircularBuf_NumBytesAvailable(&cb), 10);
+
+    p = CircularBuf_Reserve(&cb, &span);
+    ASSERT_TRUE(p == cb.buf_ptr + 10);
+    ASSERT_EQ(span, 6);
+
+    uint8_t out[10] = {0};
+    int err = 0;
+    ASSERT_EQ(CircularBuf_ProcessBytes(&cb, out, 10, &err), 10);
+    ASSERT_BYTES(out, "HELLOWORLD", 10);
+
+    CircularBuf_Deinit(&cb);
+}
+
+TEST(test_reserve_span_stops_at_buffer_end)
+{
+    /* Insert point mid-buffer with free space on both sides of the wrap:
+     * the span is only the tail, the head comes with the next reservation. */
+    CircularBuf_t cb;
+    CircularBuf_Init(&cb, NULL, 8);
+    uint8_t out[8];
+    int err = 0;
+    CircularBuf_AddBytes(&cb, (uint8_t *)"ABCDE", 5);
+    CircularBuf_ProcessBytes(&cb, out, 5, &err);          /* empty, insert @5 */
+
+    uint32_t span = 0;
+    uint8_t *p = CircularBuf_Reserve(&cb, &span);
+    ASSERT_TRUE(p == cb.buf_ptr + 5);
+    ASSERT_EQ(span, 3);                                   /* not Free() == 8 */
+    memcpy(p, "XYZ", 3);
+    ASSERT_EQ(CircularBuf_Commit(&cb, 3), 3);
+
+    p = CircularBuf_Reserve(&cb, &span);
+    ASSERT_TRUE(p == cb.buf_ptr);                         /* wrapped */
+    ASSERT_EQ(span, 5);
+    memcpy(p, "12", 2);
+    ASSERT_EQ(CircularBuf_Commit(&cb, 2), 2);
+
+    /* Copy mode stitches the two commits back across the wrap. */
+    ASSERT_EQ(CircularBuf_ProcessBytes(&cb, out, 8, &err), 5);
+    ASSERT_BYTES(out, "XYZ12", 5);
+
+    CircularBuf_Deinit(&cb);
+}
+
+TEST(test_reserve_wraps_parked_insert_pointer)
+{
+    /* A fill that ends on the last byte parks insertPtr one past the end. */
+    CircularBuf_t cb;
+    CircularBuf_Init(&cb, NULL, 8);
+    uint8_t out[8];
+    int err = 0;
+    CircularBuf_AddBytes(&cb, (uint8_t *)"ABCDEFGH", 8);
+    ASSERT_TRUE(cb.insertPtr == cb.buf_ptr + 8);
+
+    /* Full: zero span, and a commit has nothing to publish. */
+    uint32_t span = 99;
+    CircularBuf_Reserve(&cb, &span);
+    ASSERT_EQ(span, 0);
+    ASSERT_EQ(CircularBuf_Commit(&cb, 1), 0);
+
+    CircularBuf_ProcessBytes(&cb, out, 3, &err);          /* free ABC */
+    uint8_t *p = CircularBuf_Reserve(&cb, &span);
+    ASSERT_TRUE(p == cb.buf_ptr);
+    ASSERT_EQ(span, 3);
+    memcpy(p, "IJK", 3);
+    ASSERT_EQ(CircularBuf_Commit(&cb, 3), 3);
+
+    ASSERT_EQ(CircularBuf_ProcessBytes(&cb, out, 8, &err), 8);
+    ASSERT_BYTES(out, "DEFGHIJK", 8);
+
+    CircularBuf_Deinit(&cb);
+}
+
+TEST(test_reserve_limited_by_consumer)
+{
+    /* Wrapped state: insert @3, remove @5 -- the span is the 2-byte gap. */
+    CircularBuf_t cb;
+    CircularBuf_Init(&cb, NULL, 8);
+    fill_wrapped_state(&cb);
+
+    uint32_t span = 0;
+    uint8_t *p = CircularBuf_Reserve(&cb, &span);
+    ASSERT_TRUE(p == cb.buf_ptr + 3);
+    ASSERT_EQ(span, 2);
+    ASSERT_EQ(CircularBuf_Commit(&cb, 3), 0);             /* over the span */
+    ASSERT_EQ(CircularBuf_NumBytesAvailable(&cb), 6);     /* unchanged */
+    memcpy(p, "LM", 2);
+    ASSERT_EQ(CircularBuf_Commit(&cb, 2), 2);
+    ASSERT_EQ(CircularBuf_NumBytesFree(&cb), 0);
+
+    uint8_t out[8];
+    int err = 0;
+    ASSERT_EQ(CircularBuf_ProcessBytes(&cb, out, 8, &err), 8);
+    ASSERT_BYTES(out, "FGHIJKLM", 8);
+
+    CircularBuf_Deinit(&cb);
+}
+
+TEST(test_commit_zero_and_abandoned_reservation)
+{
+    CircularBuf_t cb;
+    CircularBuf_Init(&cb, NULL, 8);
+    uint32_t span = 0;
+
+    uint8_t *p = CircularBuf_Reserve(&cb, &span);
+    memcpy(p, "JUNK", 4);                                 /* never committed */
+    ASSERT_EQ(CircularBuf_Commit(&cb, 0), 0);
+    ASSERT_EQ(CircularBuf_NumBytesAvailable(&cb), 0);
+
+    /* The next writer gets the same span and overwrites the junk. */
+    ASSERT_TRUE(CircularBuf_Reserve(&cb, &span) == p);
+    ASSERT_EQ(CircularBuf_AddBytes(&cb, (uint8_t *)"OK", 2), 2);
+    uint8_t out[8];
+    int err = 0;
+    ASSERT_EQ(CircularBuf_ProcessBytes(&cb, out, 8, &err), 2);
+    ASSERT_BYTES(out, "OK", 2);
+
+    CircularBuf_Deinit(&cb);
+}
+
+TEST(test_reserve_commit_counter_wrap)
+{
+    CircularBuf_t cb;
+    CircularBuf_Init(&cb, NULL, 8);
+    cb.producedBytes = 0xFFFFFFFDu;
+    cb.consumedBytes = 0xFFFFFFFDu;
+
+    uint32_t span = 0;
+    uint8_t *p = CircularBuf_Reserve(&cb, &span);
+    ASSERT_EQ(span, 8);
+    memcpy(p, "WXYZ", 4);
+    ASSERT_EQ(CircularBuf_Commit(&cb, 4), 4);
+    ASSERT_EQ(cb.producedBytes, 0x00000001u);             /* wrapped */
+    ASSERT_EQ(CircularBuf_NumBytesAvailable(&cb), 4);
+
+    CircularBuf_Reserve(&cb, &span);
+    ASSERT_EQ(span, 4);
+
+    CircularBuf_Deinit(&cb);
+}
+
+/* Reserve/Commit, with AddBytes as the short-span fallback, interleaved with
+ * partial consumes: the byte stream that comes out must be the one that went
+ * in, across many wraps at awkward offsets. */
+TEST(test_reserve_commit_stream_across_wraps)
+{
+    CircularBuf_t cb;
+    CircularBuf_Init(&cb, NULL, 37);                      /* odd on purpose */
+    uint32_t rng = 0x1234567u;
+    uint8_t nextIn = 0, nextOut = 0;
+    uint8_t chunk[37], out[37];
+    int err = 0;
+    int bad = 0, viaReserve = 0, viaAdd = 0;
+
+    for (int i = 0; i < 20000; i++) {
+        rng = rng * 1103515245u + 12345u;
+        uint32_t want = 1u + (rng >> 16) % 12u;
+        uint32_t span = 0;
+        uint8_t *p = CircularBuf_Reserve(&cb, &span);
+        if (span >= want) {
+            for (uint32_t k = 0; k < want; k++) p[k] = nextIn++;
+            ASSERT_EQ(CircularBuf_Commit(&cb, want), want);
+            viaReserve++;
+        } else if (CircularBuf_NumBytesFree(&cb) >= want) {
+            for (uint32_t k = 0; k < want; k++) chunk[k] = (uint8_t)(nextIn + k);
+            if (CircularBuf_AddBytes(&cb, chunk, want) == want) {
+                nextIn = (uint8_t)(nextIn + want);
+                viaAdd++;
+            }
+        }
+
+        uint32_t take = (rng >> 8) % 14u;
+        uint32_t got = CircularBuf_ProcessBytes(&cb, out, take, &err);
+        for (uint32_t k = 0; k < got; k++) {
+            if (out[k] != nextOut++) bad++;
+        }
+    }
+    ASSERT_EQ(bad, 0);
+    ASSERT_TRUE(viaReserve > 1000);
+    ASSERT_TRUE(viaAdd > 100);                            /* the fallback ran */
+
+    CircularBuf_Deinit(&cb);
+}
+
 /* ========================================================================= */
 /* NULL safety                                                               */
 /* ========================================================================= */
@@ -469,6 +673,10 @@ TEST(test_null_safety)
     ASSERT_EQ(CircularBuf_NumBytesAvailable(NULL), 0);
     ASSERT_EQ(CircularBuf_NumBytesFree(NULL), 0);
     ASSERT_EQ(CircularBuf_ProcessBytes(NULL, buf, 4, &err), 0);
+    uint32_t span = 99;
+    ASSERT_TRUE(CircularBuf_Reserve(NULL, &span) == NULL);
+    ASSERT_EQ(span, 0);
+    ASSERT_EQ(CircularBuf_Commit(NULL, 4), 0);
 
     /* AddBytes with NULL data pointer is also rejected. */
     CircularBuf_t cb;
@@ -510,6 +718,14 @@ int main(void)
     RUN(test_spsc_counter_wrap_math);
     RUN(test_counter_wrap_through_real_api);
 
+    RUN(test_reserve_commit_basic);
+    RUN(test_reserve_span_stops_at_buffer_end);
+    RUN(test_reserve_wraps_parked_insert_pointer);
+    RUN(test_reserve_limited_by_consumer);
+    RUN(test_commit_zero_and_abandoned_reservation);
+    RUN(test_reserve_commit_counter_wrap);
+    RUN(test_reserve_commit_stream_across_wraps);
+
     RUN(test_null_safety);
 
     return TEST_SUMMARY();
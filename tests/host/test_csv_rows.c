@@ -0,0 +1,388 @@
+/* ==========================================================================
+ * test_csv_rows.c — differential test and benchmark: the specialized CSV row
+ * writers (csv_SelectRowWriter(true), services/csv_encoder.c) against the
+ * generic per-field-checked tryWriteRow (csv_SelectRowWriter(false)).
+ *
+ * Both runs push the same sample sets through the real AIN slot ring / DIO
+ * queue and call the real csv_Encode with the same buffer size; every call
+ * must return the same bytes. Cases sweep both board variants, 1..16
+ * channels, raw / millivolt / every fixed precision (and one above the
+ * fixedfmt ceiling, which must stay generic), full and compact layouts, DIO
+ * on and off, sparse valid masks, short sample sets, DIO-only rows, buffers
+ * small enough to hit the end-of-buffer fallback, and calibrations that push
+ * values out of the fixedfmt envelope (snprintf fallback, NaN).
+ *
+ * Links the same firmware sources as sim_pipeline (see the Makefile) against
+ * host_board.c.
+ * ========================================================================== */
+#define _POSIX_C_SOURCE 199309L
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "host_board.h"
+
+#include "services/csv_encoder.h"
+#include "state/data/AInSample.h"
+#include "state/data/DIOSample.h"
+#include "test_framework.h"
+
+#define POOL_COUNT 256u
+#define MAX_SETS   200u
+#define OUT_MAX    8192u
+#define STREAM_MAX (256u * 1024u)
+
+static uint8_t  g_pool[POOL_COUNT * (sizeof(AInPublicSampleList_t) + MAX_AIN_PUBLIC_CHANNELS * sizeof(uint32_t))];
+static uint8_t  g_out[OUT_MAX];
+static char     g_ref[STREAM_MAX];
+static char     g_got[STREAM_MAX];
+static size_t   g_refCalls[MAX_SETS * 2u + 8u];
+static uint32_t g_rng = 0x2545F491u;
+
+static uint32_t rnd(void)
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+typedef struct {
+    bool     hasAin;
+    uint32_t timestamp;
+    uint16_t channelCount;
+    uint16_t validMask;
+    uint32_t values[MAX_AIN_PUBLIC_CHANNELS];
+    bool     hasDio;
+    DIOSample dio;
+} SampleSet;
+
+static SampleSet g_sets[MAX_SETS];
+
+static uint32_t edge_u32(void)
+{
+    static const uint32_t k[] = { 0u, 9u, 10u, 99999u, 4294967295u, 1000000000u };
+    return (rnd() & 1u) ? k[rnd() % (sizeof(k) / sizeof(k[0]))] : rnd();
+}
+
+/* ADC code for the variant: 12-bit unipolar, 18-bit sign-extended, or now
+ * and then an arbitrary word (raw mode prints whatever is there). */
+static uint32_t code(uint8_t variant)
+{
+    if (rnd() % 16u == 0) return rnd();
+    if (variant == 3) return (uint32_t)(((int32_t)(rnd() << 14)) >> 14);
+    return rnd() & 0xFFFu;
+}
+
+static void make_sets(uint8_t variant, uint8_t channels, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        SampleSet* s = &g_sets[i];
+        memset(s, 0, sizeof(*s));
+        s->hasAin = (rnd() % 8u) != 0;
+        s->hasDio = (rnd() % 3u) == 0 || !s->hasAin;
+        s->timestamp = edge_u32();
+        s->channelCount = (rnd() % 8u == 0) ? (uint16_t)(rnd() % (channels + 1u)) : channels;
+        uint32_t m = rnd() % 4u;
+        s->validMask = (m == 0) ? (uint16_t)rnd() : (m == 1) ? 0u : 0xFFFFu;
+        for (uint32_t j = 0; j < MAX_AIN_PUBLIC_CHANNELS; j++) {
+            s->values[j] = code(variant);
+        }
+        s->dio.Timestamp = edge_u32();
+        s->dio.Mask = 0xFFFF;
+        s->dio.Values = edge_u32();
+    }
+}
+
+static void queue_sets(size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        const SampleSet* s = &g_sets[i];
+        if (s->hasAin) {
+            AInPublicSampleList_t* a = AInSampleList_AllocateFromPool();
+            ASSERT_TRUE(a != NULL);
+            if (a == NULL) return;
+            a->Timestamp = s->timestamp;
+            a->channelCount = s->channelCount;
+            a->validMask = s->validMask;
+            memcpy(a->Values, s->values, s->channelCount * sizeof(a->Values[0]));
+            ASSERT_TRUE(AInSampleList_PushBack(a));
+        }
+        if (s->hasDio) {
+            ASSERT_TRUE(DIOSampleList_PushBack(&HostBoard_Data()->DIOSamples, &s->dio));
+        }
+    }
+}
+
+static void session(const HostBoardSetup* setup)
+{
+    HostBoard_Init(setup);
+    DIOSampleList_Initialize(&HostBoard_Data()->DIOSamples, MAX_SETS, false);
+    AInSampleList_InitializeExternal(g_pool, POOL_COUNT,
+                                     AInSampleList_ElementSize(MAX_AIN_PUBLIC_CHANNELS));
+}
+
+static void end_session(void)
+{
+    AInSampleList_Destroy();
+    DIOSampleList_Destroy(&HostBoard_Data()->DIOSamples);
+}
+
+/* Drains the queues through csv_Encode in bufSize calls; returns the stream
+ * length. calls[] records each call's length. */
+static size_t drain(char* stream, size_t bufSize, size_t* calls, size_t* nCalls)
+{
+    size_t len = 0;
+    *nCalls = 0;
+    for (;;) {
+        size_t n = csv_Encode(HostBoard_Data(), NULL, g_out, bufSize);
+        if (n == 0) break;
+        ASSERT_TRUE(len + n <= STREAM_MAX);
+        if (len + n > STREAM_MAX) break;
+        memcpy(stream + len, g_out, n);
+        len += n;
+        calls[(*nCalls)++] = n;
+        if (*nCalls >= MAX_SETS * 2u + 8u) break;
+    }
+    return len;
+}
+
+typedef struct {
+    double calM;     /* applied to channel 0 (1.0 = shipped) */
+    size_t bufSize;
+} CaseExtra;
+
+/* Runs one configuration generic-then-specialized over the same sets. */
+static unsigned run_case(const HostBoardSetup* setup, size_t nSets, const CaseExtra* x)
+{
+    uint32_t seed = g_rng;
+    make_sets(setup->variant, setup->channels, nSets);
+
+    session(setup);
+    HostBoard_SetCal(0, x->calM, 0.0);
+    csv_SelectRowWriter(false);
+    queue_sets(nSets);
+    size_t nRefCalls;
+    size_t refLen = drain(g_ref, x->bufSize, g_refCalls, &nRefCalls);
+    end_session();
+
+    session(setup);
+    HostBoard_SetCal(0, x->calM, 0.0);
+    csv_SelectRowWriter(true);
+    queue_sets(nSets);
+    size_t gotCalls[MAX_SETS * 2u + 8u];
+    size_t nGotCalls;
+    size_t gotLen = drain(g_got, x->bufSize, gotCalls, &nGotCalls);
+    bool drained = AInSampleList_IsEmpty();
+    end_session();
+
+    bool same = drained && refLen == gotLen && nRefCalls == nGotCalls &&
+                memcmp(g_ref, g_got, refLen) == 0 &&
+                memcmp(g_refCalls, gotCalls, nRefCalls * sizeof(gotCalls[0])) == 0;
+    if (!same) {
+        printf("    mismatch: v%u %uch enc %d prec %u raw %d dio %d calM %g buf %u seed 0x%08x"
+               " (%u vs %u bytes)\n",
+               (unsigned)setup->variant, (unsigned)setup->channels, (int)setup->encoding,
+               (unsigned)setup->voltagePrecision, (int)setup->rawMode, (int)setup->dioEnabled,
+               x->calM, (unsigned)x->bufSize, (unsigned)seed,
+               (unsigned)refLen, (unsigned)gotLen);
+    }
+    return same ? 0u : 1u;
+}
+
+/* ==========================================================================
+ * Cases
+ * ========================================================================== */
+TEST(test_matches_generic_writer)
+{
+    static const uint8_t precisions[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+    unsigned mismatches = 0, cases = 0;
+    for (uint8_t variant = 1; variant <= 3; variant += 2) {
+        for (uint8_t ch = 1; ch <= MAX_AIN_PUBLIC_CHANNELS; ch++) {
+            for (int compact = 0; compact <= 1; compact++) {
+                for (size_t pi = 0; pi <= sizeof(precisions); pi++) {
+                    bool raw = (pi == sizeof(precisions));
+                    HostBoardSetup s = {
+                        .variant = variant, .channels = ch,
+                        .encoding = compact ? Streaming_CsvCompact : Streaming_Csv,
+                        .voltagePrecision = raw ? 4 : precisions[pi],
+                        .rawMode = raw, .dioEnabled = (rnd() & 1u) != 0,
+                        .tickHz = 1000000u,
+                    };
+                    CaseExtra x = { .calM = 1.0, .bufSize = 4096u };
+                    mismatches += run_case(&s, 60, &x);
+                    cases++;
+                }
+            }
+        }
+    }
+    printf("    %u configurations\n", cases);
+    ASSERT_EQ(mismatches, 0);
+}
+
+TEST(test_small_buffers_and_fallback_values)
+{
+    /* Buffers from barely-one-row upward (end-of-buffer rows go generic), and
+     * calibrations that leave the fixedfmt envelope (snprintf rows). */
+    static const double cals[] = { 1.0, 1.0e9, -3.0e12, NAN, INFINITY };
+    unsigned mismatches = 0;
+    for (unsigned iter = 0; iter < 400u; iter++) {
+        HostBoardSetup s = {
+            .variant = (rnd() & 1u) ? 3 : 1,
+            .channels = (uint8_t)(1u + rnd() % MAX_AIN_PUBLIC_CHANNELS),
+            .encoding = (rnd() & 1u) ? Streaming_CsvCompact : Streaming_Csv,
+            .voltagePrecision = (uint8_t)(rnd() % 11u),
+            .rawMode = (rnd() % 4u) == 0,
+            .dioEnabled = (rnd() & 1u) != 0,
+            .tickHz = 1000000u,
+        };
+        CaseExtra x = {
+            .calM = cals[rnd() % (sizeof(cals) / sizeof(cals[0]))],
+            .bufSize = 900u + rnd() % 1200u,
+        };
+        mismatches += run_case(&s, 40, &x);
+    }
+    ASSERT_EQ(mismatches, 0);
+}
+
+TEST(test_mid_session_setting_change)
+{
+    /* csv_Encode re-selects when precision / raw mode change after START,
+     * exactly as the generic writer picks the change up on the next call. */
+    HostBoardSetup s = {
+        .variant = 1, .channels = 4, .encoding = Streaming_Csv,
+        .voltagePrecision = 4, .dioEnabled = false, .tickHz = 1000000u,
+    };
+    char out[2][512];
+    for (int pass = 0; pass < 2; pass++) {
+        session(&s);
+        csv_SelectRowWriter(pass == 1);
+        StreamingRuntimeConfig* cfg = BoardRunTimeConfig_Get(BOARDRUNTIME_STREAMING_CONFIGURATION);
+        size_t off = 0;
+        for (int step = 0; step < 3; step++) {
+            cfg->VoltagePrecision = (step == 1) ? 0 : 4;
+            cfg->RawOutputMode = (step == 2);
+            AInPublicSampleList_t* a = AInSampleList_AllocateFromPool();
+            ASSERT_TRUE(a != NULL);
+            if (a == NULL) break;
+            a->Timestamp = 1000u + (uint32_t)step;
+            a->channelCount = 4;
+            a->validMask = 0xF;
+            for (int j = 0; j < 4; j++) a->Values[j] = 1024u * (uint32_t)j + 7u;
+            ASSERT_TRUE(AInSampleList_PushBack(a));
+            size_t n = csv_Encode(HostBoard_Data(), NULL, g_out, sizeof(g_out));
+            memcpy(out[pass] + off, g_out, n);
+            off += n;
+        }
+        out[pass][off] = '\0';
+        end_session();
+    }
+    ASSERT_TRUE(strcmp(out[0], out[1]) == 0);
+    ASSERT_TRUE(strstr(out[1], "1002,7,1002,1031") != NULL);   /* raw row */
+}
+
+TEST(test_mid_session_calibration_change)
+{
+    /* The writers' fixed-point table is built at START; a CONF:ADC:chanCALM /
+     * chanCALB after that must still show up on the next batch. */
+    HostBoardSetup s = {
+        .variant = 1, .channels = 2, .encoding = Streaming_Csv,
+        .voltagePrecision = 4, .dioEnabled = false, .tickHz = 1000000u,
+    };
+    char out[2][512];
+    for (int pass = 0; pass < 2; pass++) {
+        session(&s);
+        csv_SelectRowWriter(pass == 1);
+        size_t off = 0;
+        for (int step = 0; step < 3; step++) {
+            HostBoard_SetCal(1, step == 0 ? 1.0 : 2.0, step == 2 ? -0.5 : 0.0);
+            AInPublicSampleList_t* a = AInSampleList_AllocateFromPool();
+            ASSERT_TRUE(a != NULL);
+            if (a == NULL) break;
+            a->Timestamp = 2000u + (uint32_t)step;
+            a->channelCount = 2;
+            a->validMask = 0x3;
+            a->Values[0] = 100u;
+            a->Values[1] = 2048u;
+            ASSERT_TRUE(AInSampleList_PushBack(a));
+            size_t n = csv_Encode(HostBoard_Data(), NULL, g_out, sizeof(g_out));
+            memcpy(out[pass] + off, g_out, n);
+            off += n;
+        }
+        out[pass][off] = '\0';
+        end_session();
+    }
+    ASSERT_TRUE(strcmp(out[0], out[1]) == 0);
+    ASSERT_TRUE(strstr(out[1], "2000,2.5000\n") != NULL);
+    ASSERT_TRUE(strstr(out[1], "2001,5.0000\n") != NULL);
+    ASSERT_TRUE(strstr(out[1], "2002,4.5000\n") != NULL);
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Wall-clock ns per row for one configuration, generic vs specialized. */
+static void bench_one(const char* label, uint8_t variant, uint8_t channels,
+                      StreamingEncoding enc, uint8_t precision, bool raw)
+{
+    HostBoardSetup s = {
+        .variant = variant, .channels = channels, .encoding = enc,
+        .voltagePrecision = precision, .rawMode = raw, .dioEnabled = false,
+        .tickHz = 1000000u,
+    };
+    const unsigned rounds = 200u, perRound = 128u;
+    double ns[2];
+    for (int pass = 0; pass < 2; pass++) {
+        session(&s);
+        csv_SelectRowWriter(pass == 1);
+        csv_Encode(HostBoard_Data(), NULL, g_out, sizeof(g_out));   /* header */
+        uint64_t total = 0;
+        for (unsigned r = 0; r < rounds; r++) {
+            for (unsigned i = 0; i < perRound; i++) {
+                AInPublicSampleList_t* a = AInSampleList_AllocateFromPool();
+                if (a == NULL) break;
+                a->Timestamp = 800000000u + r * perRound + i;
+                a->channelCount = channels;
+                a->validMask = 0xFFFF;
+                for (uint8_t j = 0; j < channels; j++) a->Values[j] = (i * 37u + j * 1021u) & 0xFFFu;
+                AInSampleList_PushBack(a);
+            }
+            uint64_t t0 = now_ns();
+            while (!AInSampleList_IsEmpty()) {
+                csv_Encode(HostBoard_Data(), NULL, g_out, 4096u);
+            }
+            total += now_ns() - t0;
+        }
+        ns[pass] = (double)total / (double)(rounds * perRound);
+        end_session();
+    }
+    printf("    %-16s %2uch: generic %7.1f ns/row, specialized %7.1f ns/row (%.2fx)\n",
+           label, (unsigned)channels, ns[0], ns[1], ns[1] > 0 ? ns[0] / ns[1] : 0.0);
+}
+
+TEST(test_benchmark)
+{
+    bench_one("raw compact", 1, 8, Streaming_CsvCompact, 4, true);
+    bench_one("mV full", 1, 8, Streaming_Csv, 0, false);
+    bench_one("prec 4 full", 1, 8, Streaming_Csv, 4, false);
+    bench_one("prec 4 compact", 1, 16, Streaming_CsvCompact, 4, false);
+    bench_one("raw full", 3, 16, Streaming_Csv, 6, true);
+}
+
+int main(void)
+{
+    printf("CSV specialized row writers vs generic writer\n");
+    printf("---------------------------------------------\n");
+    RUN(test_matches_generic_writer);
+    RUN(test_small_buffers_and_fallback_values);
+    RUN(test_mid_session_setting_change);
+    RUN(test_mid_session_calibration_change);
+    RUN(test_benchmark);
+    return TEST_SUMMARY();
+}
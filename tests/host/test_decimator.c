@@ -0,0 +1,381 @@
+/* ==========================================================================
+ * test_decimator.c — host unit tests for firmware/src/Util/Decimator.c
+ *
+ * The SYST:STR:DECimate boxcar / CIC filter the deferred tick task runs on
+ * every tick. Checked against a reference filter: the direct-form FIR with
+ * the CIC's impulse response (a length-N box convolved with itself once
+ * per stage), summed in int64 and divided by N^stages with exact
+ * round-half-up. The kernel has to agree exactly (it divides by a
+ * reciprocal and a fix-up step), produce the same validMask (a channel
+ * is valid once its whole window has been fed) and OR the clip masks of
+ * each window. Also covers the DC gain, the extra LSBs on a dithered input,
+ * full-scale inputs at the largest gain, and prints ns per 16-channel push.
+ *
+ * Run: make -C tests/host run
+ * ========================================================================== */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Decimator.h"          /* real header (via -I firmware/src/Util) */
+#include "test_framework.h"
+
+#define CODE_MAX    ((1 << 18) - 1)     /* |code| < 2^18, DECIM_INPUT_BITS */
+
+static uint32_t rng_state = 0x2545F491u;
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static int32_t random_code(void) {
+    return (int32_t)(rng() % (2u * CODE_MAX + 1u)) - CODE_MAX;
+}
+
+/* --- Reference filter -------------------------------------------------------- */
+
+#define REF_MAX_TAPS  (DECIM_MAX_STAGES * (DECIM_MAX_FACTOR - 1u) + 1u)
+
+typedef struct {
+    int64_t  h[REF_MAX_TAPS];
+    uint32_t taps;
+    int64_t  gain;
+    uint32_t factor;
+    uint32_t extraBits;
+    /* per channel: the held input history, newest first */
+    int64_t  x[DECIM_MAX_CHANNELS][REF_MAX_TAPS];
+    uint32_t fed[DECIM_MAX_CHANNELS];
+    int32_t  held[DECIM_MAX_CHANNELS];
+    uint32_t phase;
+    uint32_t clip;
+} RefFilter;
+
+static void ref_init(RefFilter* r, uint32_t factor, uint32_t stages, uint32_t extraBits) {
+    memset(r, 0, sizeof(*r));
+    r->factor = factor;
+    r->extraBits = extraBits;
+    r->h[0] = 1;
+    r->taps = 1;
+    r->gain = 1;
+    for (uint32_t s = 0; s < stages; s++) {
+        int64_t next[REF_MAX_TAPS] = {0};
+        for (uint32_t i = 0; i < r->taps; i++) {
+            for (uint32_t k = 0; k < factor; k++) {
+                next[i + k] += r->h[i];
+            }
+        }
+        r->taps += factor - 1u;
+        memcpy(r->h, next, sizeof(next));
+        r->gain *= factor;
+    }
+}
+
+/* floor(a / b) for b > 0 */
+static int64_t floor_div(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    return ((a % b) != 0 && a < 0) ? q - 1 : q;
+}
+
+static bool ref_push(RefFilter* r, const uint32_t* values, uint32_t validMask,
+                     uint32_t clipMask, uint32_t channels, int32_t* out,
+                     uint32_t* pValid, uint32_t* pClip) {
+    for (uint32_t j = 0; j < channels; j++) {
+        if (validMask & (1u << j)) {
+            r->held[j] = (int32_t)values[j];
+        } else if (r->fed[j] == 0u) {
+            continue;
+        }
+        memmove(&r->x[j][1], &r->x[j][0], (r->taps - 1u) * sizeof(int64_t));
+        r->x[j][0] = r->held[j];
+        r->fed[j]++;
+    }
+    r->clip |= clipMask;
+    if (++r->phase < r->factor) {
+        return false;
+    }
+    r->phase = 0;
+    uint32_t valid = 0;
+    for (uint32_t j = 0; j < channels; j++) {
+        if (r->fed[j] == 0u) {
+            continue;
+        }
+        int64_t y = 0;
+        for (uint32_t k = 0; k < r->taps; k++) {
+            y += r->h[k] * r->x[j][k];
+        }
+        /* round-half-up of y * 2^bits / gain */
+        out[j] = (int32_t)floor_div(y * ((int64_t)2 << r->extraBits) + r->gain, 2 * r->gain);
+        if (r->fed[j] >= r->taps) {
+            valid |= 1u << j;
+        }
+    }
+    *pValid = valid;
+    *pClip = r->clip & valid;
+    r->clip = 0;
+    return true;
+}
+
+/* --- Tests ------------------------------------------------------------------- */
+
+TEST(test_config_limits)
+{
+    Decimator_t dec;
+    ASSERT_TRUE(Decimator_IsValidConfig(2, 1, 0));
+    ASSERT_TRUE(Decimator_IsValidConfig(DECIM_MAX_FACTOR, DECIM_MAX_STAGES, DECIM_MAX_EXTRA_BITS));
+    ASSERT_FALSE(Decimator_IsValidConfig(1, 1, 0));
+    ASSERT_FALSE(Decimator_IsValidConfig(DECIM_MAX_FACTOR + 1u, 1, 0));
+    ASSERT_FALSE(Decimator_IsValidConfig(4, 0, 0));
+    ASSERT_FALSE(Decimator_IsValidConfig(4, DECIM_MAX_STAGES + 1u, 0));
+    ASSERT_FALSE(Decimator_IsValidConfig(4, 1, DECIM_MAX_EXTRA_BITS + 1u));
+
+    ASSERT_TRUE(Decimator_Configure(&dec, 4, 10, 3, 2));
+    ASSERT_EQ(dec.settle, 28);
+    ASSERT_FALSE(Decimator_Configure(&dec, DECIM_MAX_CHANNELS + 1u, 10, 3, 2));
+    ASSERT_FALSE(Decimator_Configure(&dec, 4, 1, 1, 0));
+    ASSERT_EQ(dec.factor, 10);              /* unchanged by a refused configure */
+}
+
+/* A constant input comes out as code << bits, exactly, once settled. */
+TEST(test_dc_gain)
+{
+    static const uint16_t factors[] = {2, 3, 5, 8, 10, 37, 64, 100, 128};
+    Decimator_t dec;
+    uint32_t in[2], out[2], valid, clip;
+
+    for (size_t f = 0; f < sizeof(factors) / sizeof(factors[0]); f++) {
+        for (uint8_t m = 1; m <= DECIM_MAX_STAGES; m++) {
+            for (uint8_t e = 0; e <= DECIM_MAX_EXTRA_BITS; e++) {
+                ASSERT_TRUE(Decimator_Configure(&dec, 2, factors[f], m, e));
+                in[0] = (uint32_t)CODE_MAX;
+                in[1] = (uint32_t)-131072;
+                uint32_t outputs = 0;
+                for (uint32_t t = 0; t < (uint32_t)(m + 2) * factors[f]; t++) {
+                    if (!Decimator_Push(&dec, in, 0x3u, 0u, out, &valid, &clip)) {
+                        continue;
+                    }
+                    outputs++;
+                    if (outputs * factors[f] >= dec.settle) {
+                        ASSERT_EQ(valid, 0x3u);
+                        ASSERT_EQ((int32_t)out[0], CODE_MAX << e);
+                        ASSERT_EQ((int32_t)out[1], -131072 * (1 << e));
+                    } else {
+                        ASSERT_EQ(valid, 0u);   /* window not full yet */
+                    }
+                }
+                ASSERT_EQ(outputs, (uint32_t)m + 2u);
+            }
+        }
+    }
+}
+
+/* 100,101,100,101... averages to 100.5: 201 at one extra bit, 100 or 101
+ * (round-half-up: 101) at none. */
+TEST(test_extra_bits_resolve_dither)
+{
+    Decimator_t dec;
+    uint32_t in[1], out[1], valid, clip;
+    int32_t last = 0;
+
+    ASSERT_TRUE(Decimator_Configure(&dec, 1, 4, 1, 1));
+    for (uint32_t t = 0; t < 16; t++) {
+        in[0] = 100u + (t & 1u);
+        if (Decimator_Push(&dec, in, 1u, 0u, out, &valid, &clip)) {
+            ASSERT_EQ(valid, 1u);
+            last = (int32_t)out[0];
+        }
+    }
+    ASSERT_EQ(last, 201);
+
+    ASSERT_TRUE(Decimator_Configure(&dec, 1, 4, 1, 0));
+    for (uint32_t t = 0; t < 4; t++) {
+        in[0] = 100u + (t & 1u);
+        if (Decimator_Push(&dec, in, 1u, 0u, out, &valid, &clip)) {
+            last = (int32_t)out[0];
+        }
+    }
+    ASSERT_EQ(last, 101);
+}
+
+/* Invalid inputs hold the last valid code; a channel starts on its first
+ * valid input; clip masks OR over the window and only on valid outputs. */
+TEST(test_validity_hold_and_clip)
+{
+    Decimator_t dec;
+    uint32_t in[2] = {0, 0}, out[2], valid, clip;
+
+    ASSERT_TRUE(Decimator_Configure(&dec, 2, 4, 1, 0));
+    /* window 1: channel 0 valid at t=0 only (held after), channel 1 starts
+     * at t=2, so its window is not full */
+    in[0] = 40; in[1] = 7;
+    ASSERT_FALSE(Decimator_Push(&dec, in, 0x1u, 0u, out, &valid, &clip));
+    in[0] = 999;
+    ASSERT_FALSE(Decimator_Push(&dec, in, 0x0u, 0x1u, out, &valid, &clip));
+    ASSERT_FALSE(Decimator_Push(&dec, in, 0x2u, 0u, out, &valid, &clip));
+    ASSERT_TRUE(Decimator_Push(&dec, in, 0x2u, 0x2u, out, &valid, &clip));
+    ASSERT_EQ(valid, 0x1u);
+    ASSERT_EQ(out[0], 40u);                 /* 40 held over the window */
+    ASSERT_EQ(clip, 0x1u);                  /* channel 1's clip: not valid yet */
+
+    /* window 2: both full; no clip this time */
+    in[0] = 8; in[1] = 3;
+    for (uint32_t t = 0; t < 3; t++) {
+        ASSERT_FALSE(Decimator_Push(&dec, in, 0x3u, 0u, out, &valid, &clip));
+    }
+    ASSERT_TRUE(Decimator_Push(&dec, in, 0x3u, 0u, out, &valid, &clip));
+    ASSERT_EQ(valid, 0x3u);
+    ASSERT_EQ(out[0], 8u);
+    ASSERT_EQ(out[1], 3u);
+    ASSERT_EQ(clip, 0u);
+
+    /* Reset starts every channel over */
+    Decimator_Reset(&dec);
+    for (uint32_t t = 0; t < 3; t++) {
+        ASSERT_FALSE(Decimator_Push(&dec, in, 0x0u, 0u, out, &valid, &clip));
+    }
+    ASSERT_TRUE(Decimator_Push(&dec, in, 0x0u, 0u, out, &valid, &clip));
+    ASSERT_EQ(valid, 0u);
+}
+
+static void run_against_reference(uint32_t channels, uint16_t factor, uint8_t stages,
+                                  uint8_t extraBits, uint32_t frames, int fullScale,
+                                  uint32_t* pMismatch) {
+    static RefFilter ref;
+    Decimator_t dec;
+    uint32_t in[DECIM_MAX_CHANNELS], out[DECIM_MAX_CHANNELS];
+    int32_t refOut[DECIM_MAX_CHANNELS];
+    uint32_t valid, clip, refValid, refClip;
+
+    Decimator_Configure(&dec, (uint8_t)channels, factor, stages, extraBits);
+    ref_init(&ref, factor, stages, extraBits);
+    for (uint32_t t = 0; t < frames * factor; t++) {
+        uint32_t validMask = 0, clipMask = 0;
+        for (uint32_t j = 0; j < channels; j++) {
+            if (fullScale) {
+                in[j] = (uint32_t)(((t / factor) & 1u) ? CODE_MAX : -CODE_MAX);
+            } else {
+                in[j] = (uint32_t)random_code();
+            }
+            /* mostly valid, some channels start late, rare misses */
+            if ((rng() % 64u) != 0u && t >= j) {
+                validMask |= 1u << j;
+            }
+            if ((rng() % 32u) == 0u) {
+                clipMask |= 1u << j;
+            }
+        }
+        clipMask &= validMask;
+        bool got = Decimator_Push(&dec, in, validMask, clipMask, out, &valid, &clip);
+        bool refGot = ref_push(&ref, in, validMask, clipMask, channels, refOut,
+                               &refValid, &refClip);
+        if (got != refGot) {
+            (*pMismatch)++;
+            continue;
+        }
+        if (!got) {
+            continue;
+        }
+        if (valid != refValid || clip != refClip) {
+            (*pMismatch)++;
+        }
+        for (uint32_t j = 0; j < channels; j++) {
+            if (!(refValid & (1u << j))) {
+                continue;
+            }
+            if ((int32_t)out[j] != refOut[j]) {
+                (*pMismatch)++;
+            }
+        }
+    }
+}
+
+/* Random configurations and codes, random late starts / misses / clips. */
+TEST(test_matches_reference_filter)
+{
+    uint32_t mismatch = 0, outputs = 0;
+    for (uint32_t trial = 0; trial < 300; trial++) {
+        uint32_t channels = 1u + rng() % DECIM_MAX_CHANNELS;
+        uint16_t factor = (uint16_t)(2u + rng() % (DECIM_MAX_FACTOR - 1u));
+        uint8_t stages = (uint8_t)(1u + rng() % DECIM_MAX_STAGES);
+        uint8_t extraBits = (uint8_t)(rng() % (DECIM_MAX_EXTRA_BITS + 1u));
+        uint32_t frames = 8u + rng() % 24u;
+        run_against_reference(channels, factor, stages, extraBits, frames, 0,
+                              &mismatch);
+        outputs += frames * channels;
+    }
+    printf("    %u channel outputs, %u mismatches\n",
+           (unsigned)outputs, (unsigned)mismatch);
+    ASSERT_EQ(mismatch, 0u);
+}
+
+/* Full-scale swings at every power-of-two factor and at the largest odd
+ * gains: the 64-bit registers, the reciprocal product and the fix-up. */
+TEST(test_full_scale)
+{
+    uint32_t mismatch = 0;
+    for (uint16_t factor = 2; factor <= DECIM_MAX_FACTOR; factor *= 2) {
+        for (uint8_t stages = 1; stages <= DECIM_MAX_STAGES; stages++) {
+            run_against_reference(4, factor, stages, DECIM_MAX_EXTRA_BITS, 12, 0,
+                                  &mismatch);
+            run_against_reference(4, factor, stages, DECIM_MAX_EXTRA_BITS, 12, 1,
+                                  &mismatch);
+        }
+    }
+    ASSERT_EQ(mismatch, 0u);
+
+    run_against_reference(16, 127, 3, DECIM_MAX_EXTRA_BITS, 12, 1, &mismatch);
+    run_against_reference(16, 125, 3, DECIM_MAX_EXTRA_BITS, 12, 1, &mismatch);
+    ASSERT_EQ(mismatch, 0u);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+TEST(test_sixteen_channel_push_cost)
+{
+    enum { PUSHES = 2000000 };
+    static uint32_t frames[256][DECIM_MAX_CHANNELS];
+    Decimator_t dec;
+    uint32_t out[DECIM_MAX_CHANNELS], valid, clip;
+    uint32_t sink = 0;
+
+    for (uint32_t i = 0; i < 256; i++) {
+        for (uint32_t j = 0; j < DECIM_MAX_CHANNELS; j++) {
+            frames[i][j] = rng() & 0xFFFu;
+        }
+    }
+    for (uint8_t stages = 1; stages <= DECIM_MAX_STAGES; stages++) {
+        ASSERT_TRUE(Decimator_Configure(&dec, DECIM_MAX_CHANNELS, 10, stages, 2));
+        double t0 = now_ns();
+        for (uint32_t i = 0; i < PUSHES; i++) {
+            if (Decimator_Push(&dec, frames[i & 255u], 0xFFFFu, 0u, out, &valid, &clip)) {
+                sink += out[i & 15u];
+            }
+        }
+        double t1 = now_ns();
+        printf("    %u stage(s), N=10: %.1f ns/push (16 ch)\n",
+               (unsigned)stages, (t1 - t0) / PUSHES);
+    }
+    ASSERT_TRUE(sink != 0xFFFFFFFFu);
+}
+
+int main(void)
+{
+    printf("Decimator (SYST:STR:DECimate)\n");
+    printf("-----------------------------\n");
+    RUN(test_config_limits);
+    RUN(test_dc_gain);
+    RUN(test_extra_bits_resolve_dither);
+    RUN(test_validity_hold_and_clip);
+    RUN(test_matches_reference_filter);
+    RUN(test_full_scale);
+    RUN(test_sixteen_channel_push_cost);
+    return TEST_SUMMARY();
+}
@@ -0,0 +1,435 @@
+/* ==========================================================================
+ * test_fatfs_prealloc.c — contiguous log-file preallocation (ffprealloc.c)
+ * on the REAL FatFs (ff.c, the firmware's ffconf.h) over a RAM disk.
+ *
+ * The disk logs every disk_read/disk_write, so the tests can say exactly
+ * what a streamed log costs the card: which data sectors were written and
+ * in what order, and how many FAT/FSINFO sectors went out around them. Each
+ * stream runs twice -- grown cluster by cluster (today's path) and reserved
+ * up front with f_reserve() -- on a card whose free space is fragmented the
+ * way a card that has held and lost a few logs is.
+ *
+ * Also covered: f_release() frees exactly the unwritten tail (cluster
+ * boundaries, empty files, never-reserved files), a power cut mid-stream
+ * leaves a correctly-sized file (unlike a bare f_expand), and a card with no
+ * contiguous run that long refuses cleanly and the file grows normally.
+ * ========================================================================== */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ff.h"
+#include "diskio.h"
+#include "ffprealloc.h"
+#include "test_framework.h"
+
+/* ---- RAM disk ---------------------------------------------------------- */
+
+#define SS          512u
+#define DISK_BYTES  (96u * 1024u * 1024u)
+#define DISK_SECTS  (DISK_BYTES / SS)
+#define CLUSTER     1024u          /* small clusters: ~98k, so mkfs picks FAT32 */
+
+static uint8_t* g_disk;            /* calloc'd: untouched pages stay virtual */
+
+typedef struct {
+    uint32_t reads;
+    uint32_t fatWrites;            /* sectors, both FAT copies */
+    uint32_t otherFsWrites;        /* FSINFO, the file's directory entry, boot */
+    uint32_t dataWrites;           /* disk_write calls for file data */
+    uint32_t dataSeeks;            /* data writes not starting where the last ended */
+    uint32_t lastDataEnd;
+    uint32_t worstWriteFsOps;      /* most FS-sector reads+writes inside one f_write() */
+} DiskLog_t;
+
+static DiskLog_t g_log;
+static FATFS     g_fs;
+static LBA_t     g_dirSect;        /* the streamed file's directory sector */
+
+PARTITION VolToPart[FF_VOLUMES] = { {0, 0} };
+
+DWORD get_fattime(void)
+{
+    return ((DWORD)(2026 - 1980) << 25) | (1u << 21) | (1u << 16);
+}
+
+DSTATUS disk_initialize(uint8_t pdrv) { return pdrv == 0 ? 0 : STA_NOINIT; }
+DSTATUS disk_status(uint8_t pdrv)     { return pdrv == 0 ? 0 : STA_NOINIT; }
+
+DRESULT disk_read(uint8_t pdrv, uint8_t* buff, uint32_t sector, uint32_t count)
+{
+    if (pdrv != 0 || sector + count > DISK_SECTS) return RES_PARERR;
+    memcpy(buff, g_disk + (size_t)sector * SS, (size_t)count * SS);
+    g_log.reads++;
+    return RES_OK;
+}
+
+DRESULT disk_write(uint8_t pdrv, const uint8_t* buff, uint32_t sector, uint32_t count)
+{
+    if (pdrv != 0 || sector + count > DISK_SECTS) return RES_PARERR;
+    memcpy(g_disk + (size_t)sector * SS, buff, (size_t)count * SS);
+    if (g_fs.fs_type != 0 && sector >= g_fs.database && sector != g_dirSect) {
+        if (g_log.dataWrites != 0 && sector != g_log.lastDataEnd) {
+            g_log.dataSeeks++;
+        }
+        g_log.dataWrites++;
+        g_log.lastDataEnd = sector + count;
+    } else if (g_fs.fs_type != 0 && sector >= g_fs.fatbase
+               && sector < g_fs.fatbase + g_fs.n_fats * g_fs.fsize) {
+        g_log.fatWrites += count;
+    } else {
+        g_log.otherFsWrites += count;
+    }
+    return RES_OK;
+}
+
+DRESULT disk_ioctl(uint8_t pdrv, uint8_t cmd, void* buff)
+{
+    if (pdrv != 0) return RES_PARERR;
+    switch (cmd) {
+        case CTRL_SYNC:        return RES_OK;
+        case GET_SECTOR_COUNT: *(LBA_t*)buff = DISK_SECTS; return RES_OK;
+        case GET_SECTOR_SIZE:  *(WORD*)buff = SS; return RES_OK;
+        case GET_BLOCK_SIZE:   *(DWORD*)buff = 1; return RES_OK;
+        default:               return RES_PARERR;
+    }
+}
+
+/* ---- helpers ----------------------------------------------------------- */
+
+static void format_and_mount(void)
+{
+    static BYTE work[FF_MAX_SS * 4];
+    const MKFS_PARM opt = { FM_FAT32, 2, 0, 0, CLUSTER };   /* two FATs, as SD cards ship */
+    f_mount(NULL, "", 0);
+    memset(&g_fs, 0, sizeof(g_fs));
+    memset(g_disk, 0, DISK_BYTES);
+    FRESULT r = f_mkfs("", &opt, work, sizeof(work));
+    if (r != FR_OK) {
+        printf("    f_mkfs failed: %d\n", (int)r);
+        exit(1);
+    }
+    r = f_mount(&g_fs, "", 1);
+    if (r != FR_OK) {
+        printf("    f_mount failed: %d\n", (int)r);
+        exit(1);
+    }
+}
+
+/* A power cut: whatever FatFs had not put on the disk is gone. */
+static void remount(void)
+{
+    f_mount(NULL, "", 0);
+    memset(&g_fs, 0, sizeof(g_fs));
+    (void)f_mount(&g_fs, "", 1);
+}
+
+static DWORD free_clusters(void)
+{
+    DWORD n = 0;
+    FATFS* fs;
+    (void)f_getfree("", &n, &fs);
+    return n;
+}
+
+static uint8_t pattern(uint32_t pos) { return (uint8_t)(pos * 31u + (pos >> 9)); }
+
+static bool write_pattern(FIL* fp, uint32_t from, uint32_t n, uint32_t chunk,
+                          uint32_t syncEvery)
+{
+    static uint8_t buf[8192];
+    uint32_t pos = from, sinceSync = 0;
+    while (pos < from + n) {
+        uint32_t len = from + n - pos < chunk ? from + n - pos : chunk;
+        for (uint32_t i = 0; i < len; i++) buf[i] = pattern(pos + i);
+        UINT bw = 0;
+        uint32_t ops = g_log.reads + g_log.fatWrites + g_log.otherFsWrites;
+        if (f_write(fp, buf, len, &bw) != FR_OK || bw != len) return false;
+        ops = g_log.reads + g_log.fatWrites + g_log.otherFsWrites - ops;
+        if (ops > g_log.worstWriteFsOps) g_log.worstWriteFsOps = ops;
+        pos += len;
+        sinceSync += len;
+        if (syncEvery != 0 && sinceSync >= syncEvery) {
+            if (f_sync(fp) != FR_OK) return false;
+            sinceSync = 0;
+        }
+    }
+    return true;
+}
+
+static bool file_matches(const char* path, uint32_t n)
+{
+    static uint8_t buf[8192];
+    FIL f;
+    if (f_open(&f, path, FA_READ) != FR_OK) return false;
+    bool ok = (f_size(&f) == n);
+    for (uint32_t pos = 0; ok && pos < n; ) {
+        UINT br = 0;
+        uint32_t len = n - pos < sizeof(buf) ? n - pos : sizeof(buf);
+        if (f_read(&f, buf, len, &br) != FR_OK || br != len) { ok = false; break; }
+        for (uint32_t i = 0; i < len; i++) {
+            if (buf[i] != pattern(pos + i)) { ok = false; break; }
+        }
+        pos += len;
+    }
+    f_close(&f);
+    return ok;
+}
+
+/* Leave the free space in holes of @p holeClusters, the way deleting every
+ * other log does, followed by the free rest of the card. */
+static void make_holes(uint32_t files, uint32_t holeClusters)
+{
+    char name[16];
+    for (uint32_t i = 0; i < files; i++) {
+        FIL f;
+        snprintf(name, sizeof(name), "OLD%03u.BIN", (unsigned)i);
+        f_open(&f, name, FA_WRITE | FA_CREATE_ALWAYS);
+        write_pattern(&f, 0, holeClusters * CLUSTER, 4096, 0);
+        f_close(&f);
+    }
+    for (uint32_t i = 0; i < files; i += 2) {
+        snprintf(name, sizeof(name), "OLD%03u.BIN", (unsigned)i);
+        f_unlink(name);
+    }
+}
+
+/* Allocate the free rest of the card behind the holes as FILL.BIN. */
+static bool fill_tail(uint32_t files, uint32_t holeClusters)
+{
+    FIL f;
+    DWORD tail = free_clusters() - files / 2u * holeClusters;
+    bool ok = f_open(&f, "FILL.BIN", FA_WRITE | FA_CREATE_ALWAYS) == FR_OK;
+    ok = ok && f_expand(&f, (FSIZE_t)tail * CLUSTER, 1) == FR_OK;
+    return f_close(&f) == FR_OK && ok;
+}
+
+/* Holes, then a free tail -- with FatFs's next-free hint (kept in FSINFO
+ * across mounts) at the end of the card, as it is once a card has been filled
+ * and cleared: the next allocation wraps around into the holes. */
+static void fragment(uint32_t files, uint32_t holeClusters)
+{
+    make_holes(files, holeClusters);
+    fill_tail(files, holeClusters);
+    f_unlink("FILL.BIN");
+    remount();
+}
+
+typedef struct {
+    DiskLog_t log;
+    bool      ok;
+} StreamResult_t;
+
+/* One log file as the SD manager writes it: 4 KB chunks, a sync every
+ * 256 KB, release and close at the end. */
+static StreamResult_t stream_log(const char* path, uint32_t bytes, uint32_t reserve)
+{
+    StreamResult_t res = { .ok = true };
+    FIL f;
+    res.ok &= f_open(&f, path, FA_WRITE | FA_CREATE_ALWAYS) == FR_OK;
+    if (reserve != 0) {
+        res.ok &= f_reserve(&f, reserve) == FR_OK;
+    }
+    g_dirSect = f.dir_sect;
+    memset(&g_log, 0, sizeof(g_log));
+    res.ok &= write_pattern(&f, 0, bytes, 4096, 256u * 1024u);
+    res.log = g_log;
+    g_dirSect = 0;
+    res.ok &= f_release(&f) == FR_OK;
+    res.ok &= f_close(&f) == FR_OK;
+    return res;
+}
+
+/* ---- tests ------------------------------------------------------------- */
+
+TEST(test_reserve_allocates_but_keeps_size)
+{
+    format_and_mount();
+    DWORD before = free_clusters();
+    FIL f;
+    ASSERT_EQ(f_open(&f, "LOG.BIN", FA_WRITE | FA_CREATE_ALWAYS), FR_OK);
+    ASSERT_EQ(f_reserve(&f, 8u * 1024u * 1024u + 1u), FR_OK);
+    ASSERT_EQ(f_size(&f), 0);
+    ASSERT_EQ(free_clusters(), before - (8u * 1024u * 1024u / CLUSTER + 1u));
+
+    /* Only an empty, writable file can be reserved; a refusal changes nothing. */
+    ASSERT_EQ(f_reserve(&f, 4096), FR_DENIED);
+    ASSERT_TRUE(write_pattern(&f, 0, 100, 100, 0));
+    ASSERT_EQ(f_size(&f), 100);
+    ASSERT_EQ(f_release(&f), FR_OK);
+    ASSERT_EQ(f_close(&f), FR_OK);
+    ASSERT_EQ(free_clusters(), before - 1u);
+    ASSERT_TRUE(file_matches("LOG.BIN", 100));
+
+    ASSERT_EQ(f_open(&f, "LOG.BIN", FA_READ), FR_OK);
+    ASSERT_EQ(f_reserve(&f, 4096), FR_DENIED);
+    f_close(&f);
+}
+
+TEST(test_release_frees_exactly_the_tail)
+{
+    /* Short of, on, and just past a cluster boundary, and nothing at all. */
+    const uint32_t sizes[] = { 0, 1, CLUSTER - 1, CLUSTER, CLUSTER + 1,
+                               64u * CLUSTER, 64u * CLUSTER + 517u };
+    format_and_mount();
+    DWORD before = free_clusters();
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        FIL f;
+        ASSERT_EQ(f_open(&f, "LOG.BIN", FA_WRITE | FA_CREATE_ALWAYS), FR_OK);
+        ASSERT_EQ(f_reserve(&f, 1024u * CLUSTER), FR_OK);
+        ASSERT_TRUE(write_pattern(&f, 0, sizes[i], 3000, 0));
+        ASSERT_EQ(f_release(&f), FR_OK);
+        ASSERT_EQ(f_close(&f), FR_OK);
+        ASSERT_EQ(free_clusters(), before - (sizes[i] + CLUSTER - 1u) / CLUSTER);
+        ASSERT_TRUE(file_matches("LOG.BIN", sizes[i]));
+
+        FILINFO fno;
+        ASSERT_EQ(f_stat("LOG.BIN", &fno), FR_OK);
+        ASSERT_EQ(fno.fsize, sizes[i]);
+    }
+}
+
+TEST(test_release_of_unreserved_file_is_harmless)
+{
+    format_and_mount();
+    DWORD before = free_clusters();
+    FIL f;
+    ASSERT_EQ(f_open(&f, "LOG.BIN", FA_WRITE | FA_CREATE_ALWAYS), FR_OK);
+    ASSERT_EQ(f_release(&f), FR_OK);                   /* empty, no chain */
+    ASSERT_TRUE(write_pattern(&f, 0, 5u * CLUSTER, 4096, 0));
+    ASSERT_EQ(f_release(&f), FR_OK);                   /* ends on a boundary */
+    ASSERT_TRUE(write_pattern(&f, 5u * CLUSTER, 77, 77, 0));
+    ASSERT_EQ(f_release(&f), FR_OK);
+    ASSERT_EQ(f_close(&f), FR_OK);
+    ASSERT_EQ(free_clusters(), before - 6u);
+    ASSERT_TRUE(file_matches("LOG.BIN", 5u * CLUSTER + 77u));
+}
+
+TEST(test_file_past_the_extent_grows_normally)
+{
+    /* Rotation checks the size after the write, so a file can run a little
+     * past MAXSize -- and so past its extent. */
+    format_and_mount();
+    DWORD before = free_clusters();
+    FIL f;
+    ASSERT_EQ(f_open(&f, "LOG.BIN", FA_WRITE | FA_CREATE_ALWAYS), FR_OK);
+    ASSERT_EQ(f_reserve(&f, 16u * CLUSTER), FR_OK);
+    ASSERT_TRUE(write_pattern(&f, 0, 20u * CLUSTER + 5u, 4096, 8192));
+    ASSERT_EQ(f_release(&f), FR_OK);
+    ASSERT_EQ(f_close(&f), FR_OK);
+    ASSERT_EQ(free_clusters(), before - 21u);
+    ASSERT_TRUE(file_matches("LOG.BIN", 20u * CLUSTER + 5u));
+}
+
+TEST(test_stream_is_contiguous_with_no_fat_traffic)
+{
+    const uint32_t bytes = 8u * 1024u * 1024u;
+
+    format_and_mount();
+    fragment(200, 8);
+    StreamResult_t grown = stream_log("GROWN.BIN", bytes, 0);
+    ASSERT_TRUE(grown.ok);
+    ASSERT_TRUE(file_matches("GROWN.BIN", bytes));
+
+    format_and_mount();
+    fragment(200, 8);
+    StreamResult_t reserved = stream_log("RESV.BIN", bytes, bytes);
+    ASSERT_TRUE(reserved.ok);
+    ASSERT_TRUE(file_matches("RESV.BIN", bytes));
+
+    printf("    8 MB, 4 KB writes, sync every 256 KB, fragmented card:\n");
+    printf("      grown:    %5u data writes, %4u seeks, %4u FAT + %3u other FS sectors written, %4u reads, worst f_write +%u FS ops\n",
+           (unsigned)grown.log.dataWrites, (unsigned)grown.log.dataSeeks,
+           (unsigned)grown.log.fatWrites, (unsigned)grown.log.otherFsWrites,
+           (unsigned)grown.log.reads, (unsigned)grown.log.worstWriteFsOps);
+    printf("      reserved: %5u data writes, %4u seeks, %4u FAT + %3u other FS sectors written, %4u reads, worst f_write +%u FS ops\n",
+           (unsigned)reserved.log.dataWrites, (unsigned)reserved.log.dataSeeks,
+           (unsigned)reserved.log.fatWrites, (unsigned)reserved.log.otherFsWrites,
+           (unsigned)reserved.log.reads, (unsigned)reserved.log.worstWriteFsOps);
+
+    /* The reserved stream never touches the FAT, and its data lands in one
+     * run; each sync costs just the directory entry. */
+    ASSERT_EQ(reserved.log.fatWrites, 0);
+    ASSERT_EQ(reserved.log.dataSeeks, 0);
+    ASSERT_EQ(reserved.log.otherFsWrites, bytes / (256u * 1024u));
+    /* ...and no write stops for more than one FAT sector read (one per 128
+     * clusters, following the chain). */
+    ASSERT_TRUE(reserved.log.worstWriteFsOps <= 1u);
+    ASSERT_TRUE(grown.log.worstWriteFsOps > reserved.log.worstWriteFsOps);
+    /* Growing fills the holes, and pays for the FAT at every sync. */
+    ASSERT_TRUE(grown.log.fatWrites >= bytes / (256u * 1024u));
+    ASSERT_TRUE(grown.log.dataSeeks > reserved.log.dataSeeks);
+    ASSERT_TRUE(reserved.log.reads < grown.log.reads);
+}
+
+TEST(test_power_cut_leaves_the_synced_size)
+{
+    const uint32_t synced = 300u * 1024u + 123u;
+    FIL f;
+
+    format_and_mount();
+    DWORD before = free_clusters();
+    ASSERT_EQ(f_open(&f, "LOG.BIN", FA_WRITE | FA_CREATE_ALWAYS), FR_OK);
+    ASSERT_EQ(f_reserve(&f, 4u * 1024u * 1024u), FR_OK);
+    ASSERT_TRUE(write_pattern(&f, 0, synced, 4096, 0));
+    ASSERT_EQ(f_sync(&f), FR_OK);
+    ASSERT_TRUE(write_pattern(&f, synced, 50000, 4096, 0));   /* lost */
+    remount();
+    ASSERT_TRUE(file_matches("LOG.BIN", synced));
+    /* The unreleased extent stays chained past the end until a chkdsk; it is
+     * never data. */
+    ASSERT_EQ(free_clusters(), before - 4u * 1024u * 1024u / CLUSTER);
+
+    /* A bare f_expand() commits the whole extent as the file's size. */
+    format_and_mount();
+    ASSERT_EQ(f_open(&f, "LOG.BIN", FA_WRITE | FA_CREATE_ALWAYS), FR_OK);
+    ASSERT_EQ(f_expand(&f, 4u * 1024u * 1024u, 1), FR_OK);
+    ASSERT_TRUE(write_pattern(&f, 0, synced, 4096, 0));
+    ASSERT_EQ(f_sync(&f), FR_OK);
+    remount();
+    FILINFO fno;
+    ASSERT_EQ(f_stat("LOG.BIN", &fno), FR_OK);
+    ASSERT_EQ(fno.fsize, 4u * 1024u * 1024u);
+}
+
+TEST(test_no_contiguous_space_falls_back)
+{
+    format_and_mount();
+    make_holes(100, 8);
+    ASSERT_TRUE(fill_tail(100, 8));
+    FIL f;
+
+    DWORD before = free_clusters();
+    ASSERT_EQ(before, 50u * 8u);
+    ASSERT_EQ(f_open(&f, "LOG.BIN", FA_WRITE | FA_CREATE_ALWAYS), FR_OK);
+    ASSERT_EQ(f_reserve(&f, 9u * CLUSTER), FR_DENIED);
+    ASSERT_EQ(free_clusters(), before);
+    ASSERT_EQ(f_reserve(&f, 8u * CLUSTER), FR_OK);      /* one hole fits */
+    ASSERT_TRUE(write_pattern(&f, 0, 20u * CLUSTER, 4096, 0));   /* and grows on */
+    ASSERT_EQ(f_release(&f), FR_OK);
+    ASSERT_EQ(f_close(&f), FR_OK);
+    ASSERT_EQ(free_clusters(), before - 20u);
+    ASSERT_TRUE(file_matches("LOG.BIN", 20u * CLUSTER));
+}
+
+int main(void)
+{
+    g_disk = calloc(1, DISK_BYTES);
+    if (g_disk == NULL) {
+        printf("cannot allocate the RAM disk\n");
+        return 1;
+    }
+    printf("FatFs preallocation (ffprealloc.c) on a RAM disk\n");
+    printf("---------------------------------------------\n");
+    RUN(test_reserve_allocates_but_keeps_size);
+    RUN(test_release_frees_exactly_the_tail);
+    RUN(test_release_of_unreserved_file_is_harmless);
+    RUN(test_file_past_the_extent_grows_normally);
+    RUN(test_stream_is_contiguous_with_no_fat_traffic);
+    RUN(test_power_cut_leaves_the_synced_size);
+    RUN(test_no_contiguous_space_falls_back);
+    free(g_disk);
+    return TEST_SUMMARY();
+}
@@ -0,0 +1,213 @@
+/* ==========================================================================
+ * test_fixedpointcal.c — exhaustive differential test for Util/FixedPointCal.h
+ *
+ * The integer conversion replaces ADC_ConvertToVoltageByIndex() -> "%.*f" on
+ * the CSV hot path, so the standard is the same as test_fixedpointfmt.c's:
+ * byte-identical output, checked against snprintf of the double path itself.
+ * Both sides come from the board: the double path is host_board.c's
+ * ADC_ConvertToVoltageByIndex and the coefficients are built from its
+ * ADC_GetLinearConversionByIndex, each a cited copy of the firmware formula.
+ *
+ * EVERY code of both ADCs -- 4096 on NQ1, all 262144 18-bit words on NQ3 --
+ * at every precision 1..FIXEDFMT_MAX_PRECISION, and at precision 0 against
+ * the millivolt column's own rounding, across calibrations chosen to move
+ * values onto and around rounding boundaries (identity, gains a hair off 1,
+ * negative gain, offsets of both signs, a -0.0 offset, both NQ3 ranges).
+ * A value the integer path declines is not a failure -- the encoder formats
+ * it from the double path -- but the decline rate is reported and bounded,
+ * because a path that declines everything would pass trivially.
+ *
+ * Run: make -C tests/host run
+ * ========================================================================== */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "host_board.h"
+
+#include "HAL/ADC.h"
+#include "FixedPointCal.h"
+#include "test_framework.h"
+
+static unsigned long g_checked;
+static unsigned long g_declined;
+static unsigned long g_checked_by_prec[FIXEDFMT_MAX_PRECISION + 1];
+static unsigned long g_declined_by_prec[FIXEDFMT_MAX_PRECISION + 1];
+static int g_shown;
+
+/* The millivolt column exactly as csv_encoder.c / JSON_Encoder.c compute it. */
+static int32_t double_mv(double v)
+{
+    double voltage_mv = v * 1000.0;
+    if (voltage_mv > (double)INT32_MAX) return INT32_MAX;
+    if (voltage_mv < (double)INT32_MIN) return INT32_MIN;
+    return (int32_t)(voltage_mv >= 0.0 ? voltage_mv + 0.5 : voltage_mv - 0.5);
+}
+
+/* Channel 0's coefficients for `precision` (3 for the millivolt column). */
+static FixedCalChannel prepare(unsigned precision)
+{
+    ADC_LinearConversion lin;
+    FixedCalChannel c;
+    memset(&c, 0, sizeof(c));
+    if (ADC_GetLinearConversionByIndex(0, &lin)) {
+        fixedcal_prepare(&c, lin.Gain, lin.Offset, lin.CodeMax, lin.SignBits,
+                         ADC_ConvertToVoltageByIndex(0, 0u),
+                         precision == 0u ? 3u : precision);
+    }
+    return c;
+}
+
+/* One code: 1 on mismatch (printed), 0 on agreement or decline. */
+static int differs(const FixedCalChannel* c, unsigned precision, uint32_t raw)
+{
+    uint64_t scaled;
+    bool neg;
+    g_checked++;
+    g_checked_by_prec[precision]++;
+    if (!fixedcal_scaled(c, raw, &scaled, &neg)) {
+        g_declined++;
+        g_declined_by_prec[precision]++;
+        return 0;
+    }
+
+    const double v = ADC_ConvertToVoltageByIndex(0, raw);
+    char mine[64];
+    char theirs[64];
+    if (precision == 0u) {
+        snprintf(mine, sizeof(mine), "%d", neg ? -(int32_t)scaled : (int32_t)scaled);
+        snprintf(theirs, sizeof(theirs), "%d", double_mv(v));
+    } else {
+        char* end = fixedfmt_scaled_to_str(scaled, neg, precision, mine, sizeof(mine) - 1u);
+        if (end == NULL) {
+            printf("    fixedfmt_scaled_to_str NULL: raw 0x%X @ %u\n", raw, precision);
+            return 1;
+        }
+        *end = '\0';
+        snprintf(theirs, sizeof(theirs), "%.*f", (int)precision, v);
+    }
+    if (strcmp(mine, theirs) != 0) {
+        if (g_shown++ < 10) {
+            printf("    MISMATCH raw 0x%X @ %u: integer \"%s\", double \"%s\" (%.17g)\n",
+                   raw, precision, mine, theirs, v);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+static void board(uint8_t variant)
+{
+    HostBoardSetup s = {
+        .variant = variant, .channels = 1, .encoding = Streaming_Csv,
+        .voltagePrecision = 4, .tickHz = 1000000u,
+    };
+    HostBoard_Init(&s);
+}
+
+TEST(test_nq1_every_code)
+{
+    static const double kCal[][2] = {
+        { 1.0, 0.0 },  { 1.0, -0.0 },       { 1.0001, -0.0023 },
+        { 0.98765, 0.0125 }, { -1.0, 0.0 }, { 1.5, 2.5 },
+        { 0.5, -2.5 }, { 1.0, 1e-9 },       { 0.66, 0.0 },
+        { 1.0, 0.00005 },                   /* moves dyadic ties off by half a digit */
+    };
+    board(1);
+    int mismatches = 0;
+    for (size_t k = 0; k < sizeof(kCal) / sizeof(kCal[0]); k++) {
+        HostBoard_SetCal(0, kCal[k][0], kCal[k][1]);
+        for (unsigned p = 0; p <= FIXEDFMT_MAX_PRECISION; p++) {
+            FixedCalChannel c = prepare(p);
+            ASSERT_TRUE(c.valid);
+            for (uint32_t raw = 0; raw < 4096u; raw++) {
+                mismatches += differs(&c, p, raw);
+            }
+        }
+    }
+    ASSERT_EQ(mismatches, 0);
+}
+
+TEST(test_nq3_every_code)
+{
+    static const double kRange[] = { 10.0, 5.0 };
+    board(3);
+    int mismatches = 0;
+    for (size_t k = 0; k < sizeof(kRange) / sizeof(kRange[0]); k++) {
+        HostBoard_SetRange(kRange[k]);
+        for (unsigned p = 0; p <= FIXEDFMT_MAX_PRECISION; p++) {
+            FixedCalChannel c = prepare(p);
+            ASSERT_TRUE(c.valid);
+            for (uint32_t raw = 0; raw < (1u << 18); raw++) {
+                mismatches += differs(&c, p, raw);
+            }
+            /* The sample path also hands over sign-extended words. */
+            for (int32_t code = -131072; code < 131072; code += 997) {
+                mismatches += differs(&c, p, (uint32_t)code);
+            }
+        }
+    }
+    ASSERT_EQ(mismatches, 0);
+}
+
+TEST(test_decline_rate)
+{
+    /* Declines cost the old double path, so they only need to be rare. The
+     * band is widest at precision 9 on NQ3, where the 18-bit code times the
+     * gain's quantisation error is largest against the 64-bit budget. */
+    for (unsigned p = 0; p <= FIXEDFMT_MAX_PRECISION; p++) {
+        double rate = g_checked_by_prec[p]
+                    ? (double)g_declined_by_prec[p] / (double)g_checked_by_prec[p] : 0.0;
+        printf("    precision %u: %lu values, %.4f%% to the double path\n",
+               p, g_checked_by_prec[p], 100.0 * rate);
+        ASSERT_TRUE(rate < 0.01);
+    }
+    ASSERT_TRUE(g_checked > 5000000ul);
+}
+
+TEST(test_out_of_envelope)
+{
+    FixedCalChannel c;
+    board(1);
+
+    HostBoard_SetCal(0, NAN, 0.0);
+    c = prepare(4);
+    ASSERT_FALSE(c.valid);
+
+    HostBoard_SetCal(0, 1.0, INFINITY);
+    c = prepare(4);
+    ASSERT_FALSE(c.valid);
+
+    /* |v| far beyond what the 64-bit budget holds at this precision. */
+    HostBoard_SetCal(0, 1.0e9, 0.0);
+    c = prepare(9);
+    ASSERT_FALSE(c.valid);
+
+    /* A code wider than the ADC is the double path's business. */
+    HostBoard_SetCal(0, 1.0, 0.0);
+    c = prepare(4);
+    ASSERT_TRUE(c.valid);
+    uint64_t scaled;
+    bool neg;
+    ASSERT_FALSE(fixedcal_scaled(&c, 4096u, &scaled, &neg));
+    ASSERT_TRUE(fixedcal_scaled(&c, 4095u, &scaled, &neg));
+    ASSERT_EQ(scaled, 49988u);     /* 5 * 4095 / 4096 = 4.99878 -> 4.9988 */
+    ASSERT_FALSE(neg);
+
+    /* Code 0 with no offset is exactly zero, signed as the double path signs it. */
+    ASSERT_TRUE(fixedcal_scaled(&c, 0u, &scaled, &neg));
+    ASSERT_EQ(scaled, 0u);
+    ASSERT_FALSE(neg);
+}
+
+int main(void)
+{
+    printf("Integer calibrated conversion vs double path\n");
+    printf("---------------------------------------------\n");
+    RUN(test_nq1_every_code);
+    RUN(test_nq3_every_code);
+    RUN(test_decline_rate);
+    RUN(test_out_of_envelope);
+    return TEST_SUMMARY();
+}
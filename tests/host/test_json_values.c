@@ -0,0 +1,337 @@
+/* ==========================================================================
+ * test_json_values.c — differential test and benchmark: JSON value fields
+ * from the fixed-point calibrated conversion (json_SelectFixedPoint(true),
+ * services/JSON_Encoder.c + Util/FixedPointCal.h) against the double
+ * ADC_ConvertToVoltageByIndex path (json_SelectFixedPoint(false)).
+ *
+ * Both runs push the same sample sets through the real AIN slot ring and
+ * call the real Json_Encode with the same buffer size; every call must
+ * return the same bytes. Cases sweep both board variants, 1..16 channels,
+ * integer millivolts, every fixed precision and one above the fixedfmt
+ * ceiling, raw mode, per-channel calibrations (including ones that leave
+ * the integer path's range, NaN and infinity) and a calibration change
+ * mid-session.
+ *
+ * Links the same firmware sources as sim_pipeline (see the Makefile) against
+ * host_board.c.
+ * ========================================================================== */
+#define _POSIX_C_SOURCE 199309L
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "host_board.h"
+
+#include "services/DaqifiPB/DaqifiOutMessage.pb.h"
+#include "services/JSON_Encoder.h"
+#include "state/data/AInSample.h"
+#include "state/data/DIOSample.h"
+#include "test_framework.h"
+
+#define POOL_COUNT 256u
+#define MAX_SETS   200u
+#define OUT_MAX    8192u
+#define STREAM_MAX (512u * 1024u)
+
+static uint8_t  g_pool[POOL_COUNT * (sizeof(AInPublicSampleList_t) + MAX_AIN_PUBLIC_CHANNELS * sizeof(uint32_t))];
+static uint8_t  g_out[OUT_MAX];
+static char     g_ref[STREAM_MAX];
+static char     g_got[STREAM_MAX];
+static uint32_t g_rng = 0x6C8E9CF5u;
+
+static const NanopbFlagsArray kAinFields = {
+    .Size = 2,
+    .Data = { DaqifiOutMessage_msg_time_stamp_tag, DaqifiOutMessage_analog_in_data_tag },
+};
+
+static uint32_t rnd(void)
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+typedef struct {
+    uint32_t timestamp;
+    uint16_t channelCount;
+    uint16_t validMask;
+    uint32_t values[MAX_AIN_PUBLIC_CHANNELS];
+} SampleSet;
+
+static SampleSet g_sets[MAX_SETS];
+
+/* ADC code for the variant: 12-bit unipolar or 18-bit sign-extended, the
+ * range ends more often than chance, now and then an arbitrary word. */
+static uint32_t code(uint8_t variant)
+{
+    uint32_t r = rnd() % 32u;
+    if (r == 0) return rnd();
+    if (variant == 3) {
+        if (r == 1) return 0x1FFFFu;
+        if (r == 2) return 0xFFFE0000u;
+        return (uint32_t)(((int32_t)(rnd() << 14)) >> 14);
+    }
+    if (r == 1) return 0xFFFu;
+    if (r == 2) return 0u;
+    return rnd() & 0xFFFu;
+}
+
+static void make_sets(uint8_t variant, uint8_t channels, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        SampleSet* s = &g_sets[i];
+        memset(s, 0, sizeof(*s));
+        s->timestamp = rnd();
+        s->channelCount = (rnd() % 8u == 0) ? (uint16_t)(rnd() % (channels + 1u)) : channels;
+        s->validMask = (rnd() % 4u == 0) ? (uint16_t)rnd() : 0xFFFFu;
+        for (uint32_t j = 0; j < MAX_AIN_PUBLIC_CHANNELS; j++) {
+            s->values[j] = code(variant);
+        }
+    }
+}
+
+static void queue_sets(size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        const SampleSet* s = &g_sets[i];
+        AInPublicSampleList_t* a = AInSampleList_AllocateFromPool();
+        ASSERT_TRUE(a != NULL);
+        if (a == NULL) return;
+        a->Timestamp = s->timestamp;
+        a->channelCount = s->channelCount;
+        a->validMask = s->validMask;
+        memcpy(a->Values, s->values, s->channelCount * sizeof(a->Values[0]));
+        ASSERT_TRUE(AInSampleList_PushBack(a));
+    }
+}
+
+static void session(const HostBoardSetup* setup)
+{
+    HostBoard_Init(setup);
+    DIOSampleList_Initialize(&HostBoard_Data()->DIOSamples, MAX_SETS, false);
+    AInSampleList_InitializeExternal(g_pool, POOL_COUNT,
+                                     AInSampleList_ElementSize(MAX_AIN_PUBLIC_CHANNELS));
+}
+
+static void end_session(void)
+{
+    AInSampleList_Destroy();
+    DIOSampleList_Destroy(&HostBoard_Data()->DIOSamples);
+}
+
+/* Drains the AIN queue through Json_Encode in bufSize calls; returns the
+ * stream length. */
+static size_t drain(char* stream, size_t bufSize)
+{
+    size_t len = 0;
+    NanopbFlagsArray fields = kAinFields;
+    for (unsigned calls = 0; calls < MAX_SETS * 2u + 8u; calls++) {
+        if (AInSampleList_IsEmpty() && calls > 0) break;
+        size_t n = Json_Encode(HostBoard_Data(), &fields, g_out, bufSize);
+        ASSERT_TRUE(len + n + 1u <= STREAM_MAX);
+        if (len + n + 1u > STREAM_MAX) break;
+        memcpy(stream + len, g_out, n);
+        len += n;
+        stream[len++] = '|';    /* call boundary */
+    }
+    return len;
+}
+
+/* Calibrations the channels draw from: shipped, typical trims, offsets, and
+ * values past the integer path (declined -> double path) or non-finite. */
+static const double kCalM[] = { 1.0, 1.0, 0.99873, 1.0125, -1.0, 2.0, 1.0e9, NAN, INFINITY };
+static const double kCalB[] = { 0.0, 0.0, 0.0, -0.00125, 0.0375, -0.5, 3.0e-7 };
+
+static void random_cal(uint8_t channels, bool wild)
+{
+    size_t nM = sizeof(kCalM) / sizeof(kCalM[0]) - (wild ? 0u : 3u);
+    for (uint8_t j = 0; j < channels; j++) {
+        HostBoard_SetCal(j, kCalM[rnd() % nM], kCalB[rnd() % (sizeof(kCalB) / sizeof(kCalB[0]))]);
+    }
+}
+
+/* Runs one configuration double-then-fixed over the same sets and
+ * calibrations. */
+static unsigned run_case(const HostBoardSetup* setup, size_t nSets, size_t bufSize, bool wild)
+{
+    uint32_t seed = g_rng;
+    make_sets(setup->variant, setup->channels, nSets);
+    uint32_t calSeed = rnd();
+
+    size_t len[2];
+    for (int pass = 0; pass < 2; pass++) {
+        session(setup);
+        uint32_t saved = g_rng;
+        g_rng = calSeed;
+        random_cal(setup->channels, wild);
+        g_rng = saved;
+        json_SelectFixedPoint(pass == 1);
+        queue_sets(nSets);
+        len[pass] = drain(pass ? g_got : g_ref, bufSize);
+        ASSERT_TRUE(AInSampleList_IsEmpty());
+        end_session();
+    }
+
+    bool same = len[0] == len[1] && memcmp(g_ref, g_got, len[0]) == 0;
+    if (!same) {
+        printf("    mismatch: v%u %uch prec %u raw %d buf %u seed 0x%08x (%u vs %u bytes)\n",
+               (unsigned)setup->variant, (unsigned)setup->channels,
+               (unsigned)setup->voltagePrecision, (int)setup->rawMode,
+               (unsigned)bufSize, (unsigned)seed, (unsigned)len[0], (unsigned)len[1]);
+    }
+    return same ? 0u : 1u;
+}
+
+/* ==========================================================================
+ * Cases
+ * ========================================================================== */
+TEST(test_matches_double_path)
+{
+    static const uint8_t precisions[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+    unsigned mismatches = 0, cases = 0;
+    for (uint8_t variant = 1; variant <= 3; variant += 2) {
+        for (uint8_t ch = 1; ch <= MAX_AIN_PUBLIC_CHANNELS; ch++) {
+            for (size_t pi = 0; pi <= sizeof(precisions); pi++) {
+                bool raw = (pi == sizeof(precisions));
+                HostBoardSetup s = {
+                    .variant = variant, .channels = ch, .encoding = Streaming_Json,
+                    .voltagePrecision = raw ? 4 : precisions[pi],
+                    .rawMode = raw, .dioEnabled = false, .tickHz = 1000000u,
+                };
+                mismatches += run_case(&s, 60, 4096u, false);
+                cases++;
+            }
+        }
+    }
+    printf("    %u configurations\n", cases);
+    ASSERT_EQ(mismatches, 0);
+}
+
+TEST(test_small_buffers_and_fallback_values)
+{
+    /* Buffers that end a call mid-set, and calibrations the integer path
+     * declines per channel. */
+    unsigned mismatches = 0;
+    for (unsigned iter = 0; iter < 400u; iter++) {
+        HostBoardSetup s = {
+            .variant = (rnd() & 1u) ? 3 : 1,
+            .channels = (uint8_t)(1u + rnd() % MAX_AIN_PUBLIC_CHANNELS),
+            .encoding = Streaming_Json,
+            .voltagePrecision = (uint8_t)(rnd() % 11u),
+            .rawMode = (rnd() % 8u) == 0,
+            .dioEnabled = false,
+            .tickHz = 1000000u,
+        };
+        mismatches += run_case(&s, 40, 300u + rnd() % 1500u, true);
+    }
+    ASSERT_EQ(mismatches, 0);
+}
+
+TEST(test_mid_session_changes)
+{
+    /* The table is built on the first call; a chanCALM / chanCALB or a
+     * precision change after that must show up on the next call. */
+    HostBoardSetup s = {
+        .variant = 1, .channels = 2, .encoding = Streaming_Json,
+        .voltagePrecision = 4, .dioEnabled = false, .tickHz = 1000000u,
+    };
+    static char out[2][4096];
+    for (int pass = 0; pass < 2; pass++) {
+        session(&s);
+        json_SelectFixedPoint(pass == 1);
+        StreamingRuntimeConfig* cfg = BoardRunTimeConfig_Get(BOARDRUNTIME_STREAMING_CONFIGURATION);
+        size_t off = 0;
+        for (int step = 0; step < 4; step++) {
+            HostBoard_SetCal(1, step == 0 ? 1.0 : 2.0, step >= 2 ? -0.5 : 0.0);
+            cfg->VoltagePrecision = (step == 3) ? 0 : 4;
+            AInPublicSampleList_t* a = AInSampleList_AllocateFromPool();
+            ASSERT_TRUE(a != NULL);
+            if (a == NULL) break;
+            a->Timestamp = 2000u + (uint32_t)step;
+            a->channelCount = 2;
+            a->validMask = 0x3;
+            a->Values[0] = 100u;
+            a->Values[1] = 2048u;
+            ASSERT_TRUE(AInSampleList_PushBack(a));
+            NanopbFlagsArray fields = kAinFields;
+            size_t n = Json_Encode(HostBoard_Data(), &fields, g_out, sizeof(g_out));
+            memcpy(out[pass] + off, g_out, n);
+            off += n;
+        }
+        out[pass][off] = '\0';
+        end_session();
+    }
+    ASSERT_TRUE(strcmp(out[0], out[1]) == 0);
+    ASSERT_TRUE(strstr(out[1], "{\"ch\":1, \"val\":2.5000}") != NULL);
+    ASSERT_TRUE(strstr(out[1], "{\"ch\":1, \"val\":5.0000}") != NULL);
+    ASSERT_TRUE(strstr(out[1], "{\"ch\":1, \"val\":4.5000}") != NULL);
+    ASSERT_TRUE(strstr(out[1], "{\"ch\":1, \"val\":4500}") != NULL);
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Wall-clock ns per sample set, double path vs fixed point. */
+static void bench_one(uint8_t variant, uint8_t channels, uint8_t precision)
+{
+    HostBoardSetup s = {
+        .variant = variant, .channels = channels, .encoding = Streaming_Json,
+        .voltagePrecision = precision, .rawMode = false, .dioEnabled = false,
+        .tickHz = 1000000u,
+    };
+    const unsigned rounds = 200u, perRound = 128u;
+    double ns[2];
+    for (int pass = 0; pass < 2; pass++) {
+        session(&s);
+        json_SelectFixedPoint(pass == 1);
+        NanopbFlagsArray fields = kAinFields;
+        Json_Encode(HostBoard_Data(), &fields, g_out, sizeof(g_out));   /* header */
+        uint64_t total = 0;
+        for (unsigned r = 0; r < rounds; r++) {
+            for (unsigned i = 0; i < perRound; i++) {
+                AInPublicSampleList_t* a = AInSampleList_AllocateFromPool();
+                if (a == NULL) break;
+                a->Timestamp = 800000000u + r * perRound + i;
+                a->channelCount = channels;
+                a->validMask = 0xFFFF;
+                for (uint8_t j = 0; j < channels; j++) a->Values[j] = (i * 37u + j * 1021u) & 0xFFFu;
+                AInSampleList_PushBack(a);
+            }
+            uint64_t t0 = now_ns();
+            while (!AInSampleList_IsEmpty()) {
+                Json_Encode(HostBoard_Data(), &fields, g_out, 4096u);
+            }
+            total += now_ns() - t0;
+        }
+        ns[pass] = (double)total / (double)(rounds * perRound);
+        end_session();
+    }
+    printf("    v%u %2uch prec %u: double %7.1f ns/set, fixed point %7.1f ns/set (%.2fx)\n",
+           (unsigned)variant, (unsigned)channels, (unsigned)precision,
+           ns[0], ns[1], ns[1] > 0 ? ns[0] / ns[1] : 0.0);
+}
+
+TEST(test_benchmark)
+{
+    bench_one(1, 8, 0);
+    bench_one(1, 8, 4);
+    bench_one(3, 16, 6);
+}
+
+int main(void)
+{
+    printf("JSON values: fixed-point conversion vs double path\n");
+    printf("--------------------------------------------------\n");
+    RUN(test_matches_double_path);
+    RUN(test_small_buffers_and_fallback_values);
+    RUN(test_mid_session_changes);
+    RUN(test_benchmark);
+    return TEST_SUMMARY();
+}
@@ -0,0 +1,376 @@
+/* ==========================================================================
+ * test_pb_block.c — PB block streaming encoding (SYST:STR:FORmat 4):
+ * Nanopb_EncodeStreamingBlock and the block hold in Streaming_EncodeBatch,
+ * round-tripped through the reference decoder (pb_block_decode.c).
+ *
+ * There is no nanopb reference to diff against (the block fields are
+ * FT_IGNORE), so the contract is the round trip: every queued sample set with
+ * at least one valid channel comes back as exactly one decoded tick with its
+ * timestamp and valid-channel values, in order, and DIO comes back on the
+ * first tick of the message that carried it. One hand-checked vector pins the
+ * wire layout itself.
+ *
+ * Links the same firmware sources as sim_pipeline (see the Makefile) against
+ * host_board.c.
+ * ========================================================================== */
+#include <stdint.h>
+#include <string.h>
+
+#include "host_board.h"
+#include "pb_block_decode.h"
+
+#include "services/DaqifiPB/DaqifiOutMessage.pb.h"
+#include "services/DaqifiPB/NanoPB_Encoder.h"
+#include "services/streaming_encode.h"
+#include "state/data/AInSample.h"
+#include "state/data/DIOSample.h"
+#include "test_framework.h"
+
+#define POOL_COUNT 256u
+#define OUT_SIZE   4096u
+#define MAX_TICKS  4096u
+
+static uint8_t  g_pool[POOL_COUNT * (sizeof(AInPublicSampleList_t) + MAX_AIN_PUBLIC_CHANNELS * sizeof(uint32_t))];
+static uint8_t  g_out[OUT_SIZE];
+static PbTick   g_ticks[MAX_TICKS];
+static PbTick   g_want[MAX_TICKS];
+static uint32_t g_rng = 0x9E3779B9u;
+
+static uint32_t rnd(void)
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+static NanopbFlagsArray stream_flags(bool withDio)
+{
+    NanopbFlagsArray f;
+    memset(&f, 0, sizeof(f));
+    f.Data[f.Size++] = DaqifiOutMessage_msg_time_stamp_tag;
+    f.Data[f.Size++] = DaqifiOutMessage_analog_in_data_tag;
+    if (withDio) {
+        f.Data[f.Size++] = DaqifiOutMessage_digital_data_tag;
+        f.Data[f.Size++] = DaqifiOutMessage_digital_port_dir_tag;
+    }
+    return f;
+}
+
+static void setup(uint8_t variant, uint8_t channels)
+{
+    HostBoardSetup s = {
+        .variant = variant, .channels = channels, .encoding = Streaming_ProtoBufferBlock,
+        .dioEnabled = true, .tickHz = 1000000u,
+    };
+    HostBoard_Init(&s);
+    DIOSampleList_Initialize(&HostBoard_Data()->DIOSamples, 16, false);
+    AInSampleList_InitializeExternal(g_pool, POOL_COUNT,
+                                     AInSampleList_ElementSize(MAX_AIN_PUBLIC_CHANNELS));
+    DIORuntimeArray* rt = BoardRunTimeConfig_Get(BOARDRUNTIMECONFIG_DIO_CHANNELS);
+    for (uint32_t x = 0; x < 16; x++) rt->Data[x].IsInput = true;
+}
+
+static void teardown(void)
+{
+    AInSampleList_Destroy();
+    DIOSampleList_Destroy(&HostBoard_Data()->DIOSamples);
+    Streaming_EncodeSetBlockHold(0, 0);
+}
+
+/* Queues one sample set and, when it has a valid channel, the tick the
+ * decoder must give back for it. */
+static void push(uint32_t ts, uint16_t channelCount, uint16_t validMask,
+                 const int32_t* values, size_t* nWant)
+{
+    AInPublicSampleList_t* s = AInSampleList_AllocateFromPool();
+    ASSERT_TRUE(s != NULL);
+    if (s == NULL) return;
+    s->Timestamp    = ts;
+    s->channelCount = channelCount;
+    s->validMask    = validMask;
+    PbTick t;
+    memset(&t, 0, sizeof(t));
+    t.timestamp = ts;
+    for (uint16_t j = 0; j < channelCount; j++) {
+        s->Values[j] = (uint32_t)values[j];
+        if (validMask & (1u << j)) {
+            t.values[t.count++] = values[j];
+        }
+    }
+    ASSERT_TRUE(AInSampleList_PushBack(s));
+    if (t.count > 0 && nWant != NULL) {
+        g_want[(*nWant)++] = t;
+    }
+}
+
+/* Decodes g_out[0..bytes) onto g_ticks[*nTicks..). */
+static void decode_append(size_t bytes, size_t* nTicks)
+{
+    size_t consumed = 0, n = 0;
+    ASSERT_TRUE(PbDecode_Stream(NULL, g_out, bytes, &consumed, g_ticks + *nTicks,
+                                MAX_TICKS - *nTicks, &n));
+    ASSERT_EQ(consumed, bytes);
+    *nTicks += n;
+}
+
+/* Encodes the whole queue with the block encoder and decodes it onto
+ * g_ticks; returns the number of messages. A 0 return is only legal when
+ * the sets it released were all empty. */
+static size_t drain(size_t* nTicks)
+{
+    NanopbFlagsArray f = stream_flags(false);
+    size_t off = 0, nMessages = 0;
+    *nTicks = 0;
+    while (!AInSampleList_IsEmpty()) {
+        size_t n = Nanopb_EncodeStreamingBlock(HostBoard_Data(), &f, g_out + off, OUT_SIZE - off);
+        ASSERT_TRUE(n > 0 || AInSampleList_IsEmpty());
+        ASSERT_TRUE(n <= STREAMING_PB_BLOCK_MAX_BYTES);
+        if (n == 0) break;
+        off += n;
+        nMessages++;
+        if (OUT_SIZE - off < STREAMING_PB_BLOCK_MAX_BYTES) {
+            decode_append(off, nTicks);
+            off = 0;
+        }
+    }
+    decode_append(off, nTicks);
+    return nMessages;
+}
+
+static bool ticks_equal(const PbTick* a, const PbTick* b)
+{
+    return a->timestamp == b->timestamp && a->count == b->count &&
+           memcmp(a->values, b->values, a->count * sizeof(a->values[0])) == 0;
+}
+
+/* ==========================================================================
+ * Cases
+ * ========================================================================== */
+TEST(test_known_vector)
+{
+    /* One channel, ticks 100/110/120, codes 1000/1001/1002. Delta (2+1+1
+     * bytes) beats raw (3 x 2 bytes), so row 0 is delta coded:
+     *   0E                 length 14
+     *   08 64              field 1  base ts = 100
+     *   60 0A              field 12 period = 10
+     *   68 03              field 13 count = 3
+     *   72 04 D0 0F 02 02  field 14 packed: zz(1000), zz(+1), zz(+1)
+     *   78 01              field 15 delta rows = 0b1 */
+    setup(1, 1);
+    const int32_t v[3] = { 1000, 1001, 1002 };
+    for (uint32_t k = 0; k < 3; k++) push(100u + 10u * k, 1, 0x1, &v[k], NULL);
+
+    NanopbFlagsArray f = stream_flags(false);
+    size_t n = Nanopb_EncodeStreamingBlock(HostBoard_Data(), &f, g_out, OUT_SIZE);
+    static const uint8_t expect[] = {
+        0x0E, 0x08, 0x64, 0x60, 0x0A, 0x68, 0x03,
+        0x72, 0x04, 0xD0, 0x0F, 0x02, 0x02, 0x78, 0x01,
+    };
+    ASSERT_EQ(n, sizeof(expect));
+    ASSERT_BYTES(g_out, expect, sizeof(expect));
+    ASSERT_TRUE(AInSampleList_IsEmpty());
+    ASSERT_EQ(AInSampleList_PoolInUse(), 0);
+    teardown();
+}
+
+TEST(test_random_round_trip)
+{
+    /* Runs of constant layout and step, broken by dropped ticks, layout
+     * changes, empty (no valid channel) sets and timestamp wrap; values mix
+     * ramps (delta wins), noise and full-range int32 jumps (delta wraps). */
+    setup(3, 16);
+    unsigned mismatches = 0;
+    for (unsigned iter = 0; iter < 400u; iter++) {
+        size_t nWant = 0;
+        uint32_t ts = (iter & 1u) ? 0xFFFFFF00u + (rnd() & 0xFFu) : rnd();
+        uint32_t period = 1u + (rnd() % 5000u);
+        uint16_t chCount = (uint16_t)(1u + rnd() % MAX_AIN_PUBLIC_CHANNELS);
+        uint16_t mask = (uint16_t)(rnd() | 1u);
+        int32_t base[MAX_AIN_PUBLIC_CHANNELS];
+        for (uint32_t j = 0; j < MAX_AIN_PUBLIC_CHANNELS; j++) base[j] = (int32_t)rnd();
+        uint32_t kind = rnd() % 3u;
+
+        size_t count = 1u + rnd() % (POOL_COUNT - 1u);
+        for (size_t i = 0; i < count; i++) {
+            uint32_t r = rnd() % 64u;
+            if (r == 0) ts += period;                      /* dropped tick */
+            if (r == 1) mask = (uint16_t)rnd();            /* layout change (maybe empty) */
+            if (r == 2) chCount = (uint16_t)(rnd() % (MAX_AIN_PUBLIC_CHANNELS + 1u));
+            if (r == 3) period = 1u + (rnd() % 5000u);     /* clock step */
+            int32_t vals[MAX_AIN_PUBLIC_CHANNELS];
+            for (uint32_t j = 0; j < MAX_AIN_PUBLIC_CHANNELS; j++) {
+                switch (kind) {
+                    case 0:  vals[j] = (int32_t)((uint32_t)base[j] + (uint32_t)i * (j + 1u)); break;
+                    case 1:  vals[j] = ((int32_t)((rnd() & 0x3FFFFu) << 14)) >> 14; break;
+                    default: vals[j] = (rnd() & 1u) ? INT32_MIN + (int32_t)(rnd() & 3u)
+                                                    : INT32_MAX - (int32_t)(rnd() & 3u); break;
+                }
+            }
+            push(ts, chCount, mask, vals, &nWant);
+            ts += period;
+        }
+
+        size_t nGot = 0;
+        drain(&nGot);
+        ASSERT_TRUE(AInSampleList_IsEmpty());
+        ASSERT_EQ(AInSampleList_PoolInUse(), 0);
+
+        bool same = (nGot == nWant);
+        for (size_t k = 0; same && k < nWant; k++) {
+            same = ticks_equal(&g_ticks[k], &g_want[k]);
+        }
+        if (!same && mismatches++ < 5) {
+            printf("    mismatch iter %u: got %u ticks, want %u\n",
+                   iter, (unsigned)nGot, (unsigned)nWant);
+        }
+    }
+    ASSERT_EQ(mismatches, 0);
+    teardown();
+}
+
+TEST(test_block_bounds)
+{
+    /* 16 full-width channels: a block stops where a worst-case sample would
+     * no longer fit STREAMING_PB_BLOCK_MAX_BYTES; 1 channel stops at the tick
+     * cap. Either way each message stays within the batch's message room. */
+    setup(3, 16);
+    size_t per16 = Nanopb_StreamingBlockMaxSamples(16, OUT_SIZE);
+    ASSERT_TRUE(per16 >= 2 && per16 < STREAMING_PB_BLOCK_MAX_SAMPLES);
+    ASSERT_EQ(Nanopb_StreamingBlockMaxSamples(1, OUT_SIZE), STREAMING_PB_BLOCK_MAX_SAMPLES);
+    ASSERT_EQ(Nanopb_StreamingBlockMaxSamples(16, 16), 0);
+
+    int32_t vals[MAX_AIN_PUBLIC_CHANNELS];
+    for (uint32_t j = 0; j < MAX_AIN_PUBLIC_CHANNELS; j++) vals[j] = INT32_MIN;
+    for (uint32_t k = 0; k < 3u * per16; k++) {
+        push(1000u + k, 16, 0xFFFF, vals, NULL);
+    }
+    size_t nTicks = 0;
+    ASSERT_EQ(drain(&nTicks), 3);
+    ASSERT_EQ(nTicks, 3u * per16);
+
+    for (uint32_t k = 0; k < 200u; k++) {
+        push(5u + 3u * k, 1, 0x1, vals, NULL);
+    }
+    ASSERT_EQ(drain(&nTicks), 2);        /* 128 + 72 */
+    ASSERT_EQ(nTicks, 200);
+    teardown();
+}
+
+TEST(test_dio_rides_first_tick)
+{
+    setup(1, 2);
+    size_t nWant = 0;
+    DIOSample d = { .Timestamp = 7, .Mask = 0xFFFF, .Values = 0xA55A };
+    ASSERT_TRUE(DIOSampleList_PushBack(&HostBoard_Data()->DIOSamples, &d));
+    const int32_t v[2] = { 3, 4 };
+    for (uint32_t k = 0; k < 5; k++) push(50u + 2u * k, 2, 0x3, v, &nWant);
+
+    NanopbFlagsArray f = stream_flags(true);
+    size_t n = Nanopb_EncodeStreamingBlock(HostBoard_Data(), &f, g_out, OUT_SIZE);
+    size_t consumed = 0, nGot = 0;
+    ASSERT_TRUE(PbDecode_Stream(NULL, g_out, n, &consumed, g_ticks, MAX_TICKS, &nGot));
+    ASSERT_EQ(nGot, 5);
+    ASSERT_TRUE(g_ticks[0].hasDio && g_ticks[0].hasDir);
+    ASSERT_EQ(g_ticks[0].dio[0], 0x5A);
+    ASSERT_EQ(g_ticks[0].dio[1], 0xA5);
+    ASSERT_FALSE(g_ticks[1].hasDio);
+    for (size_t k = 0; k < nGot; k++) ASSERT_TRUE(ticks_equal(&g_ticks[k], &g_want[k]));
+
+    /* No AIN queued: the DIO sample goes out as a standalone per-sample
+     * message, stamped with its own tick. */
+    d.Timestamp = 0x01020304u;
+    ASSERT_TRUE(DIOSampleList_PushBack(&HostBoard_Data()->DIOSamples, &d));
+    n = Nanopb_EncodeStreamingBlock(HostBoard_Data(), &f, g_out, OUT_SIZE);
+    ASSERT_TRUE(PbDecode_Stream(NULL, g_out, n, &consumed, g_ticks, MAX_TICKS, &nGot));
+    ASSERT_EQ(nGot, 1);
+    ASSERT_EQ(g_ticks[0].timestamp, 0x01020304u);
+    ASSERT_EQ(g_ticks[0].count, 0);
+    ASSERT_TRUE(g_ticks[0].hasDio);
+    teardown();
+}
+
+TEST(test_short_buffer_leaves_sample_queued)
+{
+    setup(1, 4);
+    const int32_t v[4] = { 1, 2, 3, 4 };
+    push(10, 4, 0xF, v, NULL);
+    NanopbFlagsArray f = stream_flags(false);
+    ASSERT_EQ(Nanopb_EncodeStreamingBlock(HostBoard_Data(), &f, g_out, 32), 0);
+    ASSERT_EQ(AInSampleList_Size(), 1);
+    ASSERT_TRUE(Nanopb_EncodeStreamingBlock(HostBoard_Data(), &f, g_out, OUT_SIZE) > 0);
+    ASSERT_TRUE(AInSampleList_IsEmpty());
+    teardown();
+}
+
+TEST(test_batch_hold)
+{
+    /* 10 kHz, 1 channel: the batch step waits for 10 ms (100 ticks) and then
+     * encodes them as one block, without reporting an encoder failure. */
+    setup(1, 1);
+    Streaming_EncodeSetBlockHold(10000u * 1000u, 1);
+    const int32_t v[1] = { 2048 };
+    bool failed = true;
+    for (uint32_t k = 0; k < 99u; k++) push(1u + 100u * k, 1, 0x1, v, NULL);
+    ASSERT_EQ(Streaming_EncodeBatch(HostBoard_Data(), Streaming_ProtoBufferBlock,
+                                    g_out, OUT_SIZE, OUT_SIZE, &failed), 0);
+    ASSERT_FALSE(failed);
+    ASSERT_EQ(AInSampleList_Size(), 99);
+
+    push(1u + 100u * 99u, 1, 0x1, v, NULL);
+    size_t n = Streaming_EncodeBatch(HostBoard_Data(), Streaming_ProtoBufferBlock,
+                                     g_out, OUT_SIZE, OUT_SIZE, &failed);
+    ASSERT_FALSE(failed);
+    ASSERT_TRUE(AInSampleList_IsEmpty());
+    size_t consumed = 0, nGot = 0;
+    ASSERT_TRUE(PbDecode_Stream(NULL, g_out, n, &consumed, g_ticks, MAX_TICKS, &nGot));
+    ASSERT_EQ(nGot, 100);
+
+    /* Hold 1 (rate unknown) flushes a single queued sample. */
+    Streaming_EncodeSetBlockHold(0, 1);
+    push(5, 1, 0x1, v, NULL);
+    ASSERT_TRUE(Streaming_EncodeBatch(HostBoard_Data(), Streaming_ProtoBufferBlock,
+                                      g_out, OUT_SIZE, OUT_SIZE, &failed) > 0);
+    ASSERT_TRUE(AInSampleList_IsEmpty());
+    teardown();
+}
+
+TEST(test_fewer_bytes_than_per_sample)
+{
+    /* The point of the format: a 1-channel 12-bit stream at a 4 us tick
+     * (20 kHz-class timestamps) costs several-fold fewer bytes per sample. */
+    setup(1, 1);
+    NanopbFlagsArray f = stream_flags(false);
+    size_t perSample = 0, block = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (uint32_t k = 0; k < 128u; k++) {
+            int32_t v[1] = { (int32_t)(2048u + (rnd() & 0x3Fu)) };
+            push(0x10000000u + 50u * k, 1, 0x1, v, NULL);
+        }
+        size_t bytes = 0;
+        while (!AInSampleList_IsEmpty()) {
+            bytes += (pass == 0)
+                ? Nanopb_EncodeStreamingFast(HostBoard_Data(), &f, g_out, OUT_SIZE)
+                : Nanopb_EncodeStreamingBlock(HostBoard_Data(), &f, g_out, OUT_SIZE);
+        }
+        if (pass == 0) perSample = bytes; else block = bytes;
+    }
+    printf("    1ch 12-bit, 128 ticks: per-sample %u B, block %u B\n",
+           (unsigned)perSample, (unsigned)block);
+    ASSERT_TRUE(block * 3u < perSample);
+    teardown();
+}
+
+int main(void)
+{
+    printf("Streaming PB block encoding round trip\n");
+    printf("---------------------------------------------\n");
+    RUN(test_known_vector);
+    RUN(test_random_round_trip);
+    RUN(test_block_bounds);
+    RUN(test_dio_rides_first_tick);
+    RUN(test_short_buffer_leaves_sample_queued);
+    RUN(test_batch_hold);
+    RUN(test_fewer_bytes_than_per_sample);
+    return TEST_SUMMARY();
+}
@@ -0,0 +1,558 @@
+/* ==========================================================================
+ * test_pb_stream.c — differential test: the streaming PB fast path
+ * (Nanopb_EncodeStreamingFast, services/DaqifiPB/NanoPB_Encoder.c) against
+ * nanopb's own generic encoder.
+ *
+ * The fast path writes the wire bytes by hand in one pass. Clients decode
+ * them as DaqifiOutMessage, so the contract is byte-identity with
+ * pb_encode_delimited() of a DaqifiOutMessage carrying the same fields. Every
+ * case here pushes samples through the real AIN slot ring / DIO queue, calls
+ * the real encoder, and compares the output with a reference built by
+ * filling a DaqifiOutMessage the way the fast path's doc describes (valid
+ * channels only, DIO in the first AIN message, standalone DIO otherwise) and
+ * running it through pb_encode_ex(PB_ENCODE_DELIMITED).
+ *
+ * Delta coding (SYST:STR:DELTa, field 73) has no nanopb reference; those
+ * cases hold keyframes to the same byte-identity and round-trip the deltas
+ * through the reference decoder (pb_block_decode.c).
+ *
+ * Links the same firmware sources as sim_pipeline (see the Makefile) against
+ * host_board.c.
+ * ========================================================================== */
+#include <stdint.h>
+#include <string.h>
+
+#include "host_board.h"
+#include "pb_block_decode.h"
+
+#include "libraries/nanopb/pb_encode.h"
+#include "services/DaqifiPB/DaqifiOutMessage.pb.h"
+#include "services/DaqifiPB/NanoPB_Encoder.h"
+#include "state/data/AInSample.h"
+#include "state/data/DIOSample.h"
+#include "test_framework.h"
+
+#define POOL_COUNT 128u
+#define OUT_SIZE   4096u
+
+static uint8_t  g_pool[POOL_COUNT * (sizeof(AInPublicSampleList_t) + MAX_AIN_PUBLIC_CHANNELS * sizeof(uint32_t))];
+static uint8_t  g_out[OUT_SIZE];
+static uint8_t  g_ref[OUT_SIZE];
+static uint32_t g_rng = 0x12345678u;
+
+static uint32_t rnd(void)
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+/* Values that sit on every zigzag varint length boundary, the sign edges,
+ * and the codes the two ADCs actually produce (12-bit unipolar, 18-bit
+ * sign-extended). */
+static int32_t edge_value(void)
+{
+    static const int32_t k[] = {
+        0, 1, -1, 63, -64, 64, -65, 8191, -8192, 8192, -8193,
+        1048575, -1048576, 1048576, -1048577, 134217727, -134217728,
+        134217728, -134217729, INT32_MAX, INT32_MIN, 4095, 131071, -131072,
+    };
+    switch (rnd() % 4u) {
+        case 0:  return k[rnd() % (sizeof(k) / sizeof(k[0]))];
+        case 1:  return (int32_t)(rnd() & 0xFFFu);
+        case 2:  return ((int32_t)((rnd() & 0x3FFFFu) << 14)) >> 14;
+        default: return (int32_t)rnd();
+    }
+}
+
+static uint32_t edge_timestamp(void)
+{
+    static const uint32_t k[] = { 0u, 1u, 127u, 128u, 16383u, 16384u, 0xFFFFFFFFu };
+    return (rnd() & 1u) ? k[rnd() % (sizeof(k) / sizeof(k[0]))] : rnd();
+}
+
+static NanopbFlagsArray stream_flags(bool withDio)
+{
+    NanopbFlagsArray f;
+    memset(&f, 0, sizeof(f));
+    f.Data[f.Size++] = DaqifiOutMessage_msg_time_stamp_tag;
+    f.Data[f.Size++] = DaqifiOutMessage_analog_in_data_tag;
+    if (withDio) {
+        f.Data[f.Size++] = DaqifiOutMessage_digital_data_tag;
+        f.Data[f.Size++] = DaqifiOutMessage_digital_port_dir_tag;
+    }
+    return f;
+}
+
+static void setup(uint8_t variant)
+{
+    HostBoardSetup s = {
+        .variant = variant, .channels = 16, .encoding = Streaming_ProtoBuffer,
+        .dioEnabled = true, .tickHz = 1000000u,
+    };
+    HostBoard_Init(&s);
+    DIOSampleList_Initialize(&HostBoard_Data()->DIOSamples, 16, false);
+    AInSampleList_InitializeExternal(g_pool, POOL_COUNT,
+                                     AInSampleList_ElementSize(MAX_AIN_PUBLIC_CHANNELS));
+}
+
+static void teardown(void)
+{
+    AInSampleList_Destroy();
+    DIOSampleList_Destroy(&HostBoard_Data()->DIOSamples);
+    Nanopb_StreamingDeltaConfigure(0);
+}
+
+/* Random direction bitmap into the runtime DIO config; returns the 2 bytes
+ * the encoder derives from it. */
+static void random_dio_dir(uint8_t dir[2])
+{
+    DIORuntimeArray* rt = BoardRunTimeConfig_Get(BOARDRUNTIMECONFIG_DIO_CHANNELS);
+    uint32_t bits = rnd() & 0xFFFFu;
+    for (uint32_t x = 0; x < 16; x++) {
+        rt->Data[x].IsInput = ((bits >> x) & 1u) != 0;
+    }
+    dir[0] = (uint8_t)bits;
+    dir[1] = (uint8_t)(bits >> 8);
+}
+
+typedef struct {
+    uint32_t timestamp;
+    uint16_t channelCount;
+    uint16_t validMask;
+    int32_t  values[MAX_AIN_PUBLIC_CHANNELS];
+} RefSample;
+
+static void random_sample(RefSample* r)
+{
+    r->timestamp    = edge_timestamp();
+    r->channelCount = (uint16_t)(rnd() % (MAX_AIN_PUBLIC_CHANNELS + 1u));
+    uint32_t m = rnd() % 4u;
+    r->validMask = (m == 0) ? 0xFFFFu : (m == 1) ? 0u : (uint16_t)rnd();
+    for (uint32_t j = 0; j < MAX_AIN_PUBLIC_CHANNELS; j++) {
+        r->values[j] = edge_value();
+    }
+}
+
+static void push_sample(const RefSample* r)
+{
+    AInPublicSampleList_t* s = AInSampleList_AllocateFromPool();
+    ASSERT_TRUE(s != NULL);
+    if (s == NULL) return;
+    s->Timestamp    = r->timestamp;
+    s->channelCount = r->channelCount;
+    s->validMask    = r->validMask;
+    for (uint16_t j = 0; j < r->channelCount; j++) {
+        s->Values[j] = (uint32_t)r->values[j];
+    }
+    ASSERT_TRUE(AInSampleList_PushBack(s));
+}
+
+/* nanopb reference for one delimited message; returns bytes appended. */
+static size_t ref_message(uint8_t* out, size_t room, uint32_t ts,
+                          const int32_t* values, size_t count,
+                          const uint8_t* dio, const uint8_t* dir)
+{
+    DaqifiOutMessage msg = DaqifiOutMessage_init_zero;
+    msg.msg_time_stamp = ts;
+    msg.analog_in_data_count = (pb_size_t)count;
+    if (count > 0) {
+        memcpy(msg.analog_in_data, values, count * sizeof(values[0]));
+    }
+    if (dio != NULL) {
+        msg.digital_data.size = 2;
+        memcpy(msg.digital_data.bytes, dio, 2);
+    }
+    if (dir != NULL) {
+        msg.digital_port_dir.size = 2;
+        memcpy(msg.digital_port_dir.bytes, dir, 2);
+    }
+    pb_ostream_t s = pb_ostream_from_buffer(out, room);
+    bool ok = pb_encode_ex(&s, DaqifiOutMessage_fields, &msg, PB_ENCODE_DELIMITED);
+    ASSERT_TRUE(ok);
+    return ok ? s.bytes_written : 0;
+}
+
+/* Reference for one Nanopb_EncodeStreamingFast call over `n` queued samples,
+ * mirroring its DIO rules: the popped DIO sample (if any) rides in the first
+ * AIN message that has values, the direction bitmap rides in every AIN
+ * message up to and including that one, and a DIO sample no AIN message took
+ * goes out alone with its own timestamp. */
+static size_t ref_call(uint8_t* out, const RefSample* samples, size_t n,
+                       bool withDio, const DIOSample* dioSample, const uint8_t dir[2])
+{
+    size_t off = 0;
+    uint8_t dioBytes[2];
+    bool dioPending = withDio && dioSample != NULL;
+    if (dioPending) {
+        memcpy(dioBytes, &dioSample->Values, 2);
+    }
+    for (size_t i = 0; i < n; i++) {
+        int32_t vals[MAX_AIN_PUBLIC_CHANNELS];
+        size_t count = 0;
+        for (uint16_t j = 0; j < samples[i].channelCount; j++) {
+            if (samples[i].validMask & (1u << j)) {
+                vals[count++] = samples[i].values[j];
+            }
+        }
+        if (count == 0) continue;
+        off += ref_message(out + off, OUT_SIZE - off, samples[i].timestamp, vals, count,
+                           dioPending ? dioBytes : NULL, withDio ? dir : NULL);
+        if (dioPending) {
+            dioPending = false;
+            withDio = false;          /* dir stops with the DIO sample */
+        }
+    }
+    if (dioPending) {
+        off += ref_message(out + off, OUT_SIZE - off, dioSample->Timestamp, NULL, 0,
+                           dioBytes, dir);
+    }
+    return off;
+}
+
+/* ==========================================================================
+ * Cases
+ * ========================================================================== */
+TEST(test_known_vector)
+{
+    /* Pins the hand-checked wire layout, independent of nanopb:
+     *   10                 length 16
+     *   08 01              field 1 ts = 1
+     *   12 03 01 80 01     field 2 packed: zz(-1)=1, zz(64)=128
+     *   2A 02 01 00        field 5 digital_data
+     *   AA 02 02 FF FF     field 37 digital_port_dir */
+    setup(1);
+    DIORuntimeArray* rt = BoardRunTimeConfig_Get(BOARDRUNTIMECONFIG_DIO_CHANNELS);
+    for (uint32_t x = 0; x < 16; x++) rt->Data[x].IsInput = true;
+    DIOSample d = { .Timestamp = 1, .Mask = 0xFFFF, .Values = 0x0001 };
+    ASSERT_TRUE(DIOSampleList_PushBack(&HostBoard_Data()->DIOSamples, &d));
+    RefSample r = { .timestamp = 1, .channelCount = 2, .validMask = 0x3, .values = { -1, 64 } };
+    push_sample(&r);
+
+    NanopbFlagsArray f = stream_flags(true);
+    size_t n = Nanopb_EncodeStreamingFast(HostBoard_Data(), &f, g_out, OUT_SIZE);
+    static const uint8_t expect[] = {
+        0x10, 0x08, 0x01, 0x12, 0x03, 0x01, 0x80, 0x01,
+        0x2A, 0x02, 0x01, 0x00, 0xAA, 0x02, 0x02, 0xFF, 0xFF,
+    };
+    ASSERT_EQ(n, sizeof(expect));
+    ASSERT_BYTES(g_out, expect, sizeof(expect));
+    teardown();
+}
+
+TEST(test_single_sample_matches_nanopb)
+{
+    setup(1);
+    unsigned mismatches = 0;
+    for (unsigned iter = 0; iter < 50000u; iter++) {
+        RefSample r;
+        random_sample(&r);
+        bool withDio = (rnd() & 1u) != 0;
+        uint8_t dir[2] = {0, 0};
+        DIOSample d;
+        bool haveDio = false;
+        if (withDio) {
+            random_dio_dir(dir);
+            if (rnd() % 4u != 0) {
+                d.Timestamp = edge_timestamp();
+                d.Mask = 0xFFFF;
+                d.Values = rnd();
+                haveDio = DIOSampleList_PushBack(&HostBoard_Data()->DIOSamples, &d);
+                ASSERT_TRUE(haveDio);
+            }
+        }
+        push_sample(&r);
+
+        NanopbFlagsArray f = stream_flags(withDio);
+        size_t got  = Nanopb_EncodeStreamingFast(HostBoard_Data(), &f, g_out, OUT_SIZE);
+        size_t want = ref_call(g_ref, &r, 1, withDio, haveDio ? &d : NULL, dir);
+        if (got != want || memcmp(g_out, g_ref, want) != 0) {
+            if (mismatches++ < 5) {
+                printf("    mismatch iter %u: ts=%u ch=%u mask=0x%04x dio=%d got=%u want=%u\n",
+                       iter, (unsigned)r.timestamp, (unsigned)r.channelCount,
+                       (unsigned)r.validMask, (int)haveDio, (unsigned)got, (unsigned)want);
+            }
+        }
+        ASSERT_TRUE(AInSampleList_IsEmpty());
+    }
+    ASSERT_EQ(mismatches, 0);
+    teardown();
+}
+
+TEST(test_multi_sample_call_matches_nanopb)
+{
+    setup(3);
+    unsigned mismatches = 0;
+    for (unsigned iter = 0; iter < 2000u; iter++) {
+        RefSample rs[24];
+        size_t n = 1u + rnd() % 24u;
+        for (size_t i = 0; i < n; i++) {
+            random_sample(&rs[i]);
+            push_sample(&rs[i]);
+        }
+        uint8_t dir[2];
+        random_dio_dir(dir);
+        DIOSample d = { .Timestamp = rnd(), .Mask = 0xFFFF, .Values = rnd() };
+        bool haveDio = (rnd() & 1u) && DIOSampleList_PushBack(&HostBoard_Data()->DIOSamples, &d);
+
+        NanopbFlagsArray f = stream_flags(true);
+        size_t got  = Nanopb_EncodeStreamingFast(HostBoard_Data(), &f, g_out, OUT_SIZE);
+        size_t want = ref_call(g_ref, rs, n, true, haveDio ? &d : NULL, dir);
+        if (got != want || memcmp(g_out, g_ref, want) != 0) {
+            mismatches++;
+        }
+        ASSERT_TRUE(AInSampleList_IsEmpty());
+    }
+    ASSERT_EQ(mismatches, 0);
+    teardown();
+}
+
+TEST(test_short_buffer_fails_cleanly)
+{
+    setup(1);
+    uint8_t dir[2];
+    random_dio_dir(dir);
+    DIOSample d = { .Timestamp = 0x12345678u, .Mask = 0xFFFF, .Values = 0xBEEF };
+    size_t want = ref_call(g_ref, NULL, 0, true, &d, dir);
+    ASSERT_TRUE(want > 0);
+
+    /* DIO-only session (no AIN flag): the standalone message is written
+     * straight into a buffer smaller than the worst case. Exact fit works... */
+    NanopbFlagsArray f;
+    memset(&f, 0, sizeof(f));
+    f.Data[f.Size++] = DaqifiOutMessage_digital_data_tag;
+    ASSERT_TRUE(DIOSampleList_PushBack(&HostBoard_Data()->DIOSamples, &d));
+    memset(g_out, 0xEE, sizeof(g_out));
+    ASSERT_EQ(Nanopb_EncodeStreamingFast(HostBoard_Data(), &f, g_out, want), want);
+    ASSERT_BYTES(g_out, g_ref, want);
+    ASSERT_EQ(g_out[want], 0xEE);
+
+    /* ...one byte short writes nothing at all. */
+    ASSERT_TRUE(DIOSampleList_PushBack(&HostBoard_Data()->DIOSamples, &d));
+    memset(g_out, 0xEE, sizeof(g_out));
+    ASSERT_EQ(Nanopb_EncodeStreamingFast(HostBoard_Data(), &f, g_out, want - 1u), 0);
+    ASSERT_EQ(g_out[0], 0xEE);
+
+    /* AIN path: below one worst-case message the sample stays queued. */
+    RefSample r = { .timestamp = 5, .channelCount = 1, .validMask = 1, .values = { 7 } };
+    push_sample(&r);
+    f = stream_flags(false);
+    ASSERT_EQ(Nanopb_EncodeStreamingFast(HostBoard_Data(), &f, g_out, 16), 0);
+    ASSERT_EQ(AInSampleList_Size(), 1);
+    teardown();
+}
+
+/* ---- delta coding ---- */
+
+/* Valid-channel values of a sample, as the decoder returns them. */
+static size_t valid_values(const RefSample* r, int32_t* out)
+{
+    size_t count = 0;
+    for (uint16_t j = 0; j < r->channelCount; j++) {
+        if (r->validMask & (1u << j)) {
+            out[count++] = r->values[j];
+        }
+    }
+    return count;
+}
+
+TEST(test_delta_known_vector)
+{
+    /* Keyframe, then a delta message:
+     *   07                 length 7
+     *   08 02              field 1 ts = 2
+     *   CA 04 02 02 03     field 73 packed: zz(+1)=2, zz(-2)=3 */
+    setup(1);
+    Nanopb_StreamingDeltaConfigure(8);
+    RefSample k = { .timestamp = 1, .channelCount = 2, .validMask = 0x3, .values = { 100, 200 } };
+    RefSample d = { .timestamp = 2, .channelCount = 2, .validMask = 0x3, .values = { 101, 198 } };
+    push_sample(&k);
+    push_sample(&d);
+
+    NanopbFlagsArray f = stream_flags(false);
+    size_t n = Nanopb_EncodeStreamingFast(HostBoard_Data(), &f, g_out, OUT_SIZE);
+    size_t key = ref_call(g_ref, &k, 1, false, NULL, NULL);
+    static const uint8_t expect[] = { 0x07, 0x08, 0x02, 0xCA, 0x04, 0x02, 0x02, 0x03 };
+    ASSERT_EQ(n, key + sizeof(expect));
+    ASSERT_BYTES(g_out, g_ref, key);
+    ASSERT_BYTES(g_out + key, expect, sizeof(expect));
+    teardown();
+}
+
+TEST(test_delta_round_trip)
+{
+    /* Random walks with occasional full-range jumps, layout changes and
+     * forced keyframes, several samples per call: every sample must decode
+     * back exactly, no run of deltas may reach K, and every keyframe must be
+     * the plain (nanopb-identical) message. */
+    static const uint32_t intervals[] = { 1u, 2u, 3u, 16u, 1000u };
+    for (size_t ki = 0; ki < sizeof(intervals) / sizeof(intervals[0]); ki++) {
+        uint32_t K = intervals[ki];
+        setup(3);
+        Nanopb_StreamingDeltaConfigure(K);
+        PbDecodeState st;
+        memset(&st, 0, sizeof(st));
+        RefSample cur = { .timestamp = 1, .channelCount = 8, .validMask = 0xFFu };
+        for (uint32_t j = 0; j < MAX_AIN_PUBLIC_CHANNELS; j++) cur.values[j] = edge_value();
+        unsigned mismatches = 0, deltas = 0, run = 0, maxRun = 0;
+
+        for (unsigned iter = 0; iter < 3000u; iter++) {
+            RefSample rs[16];
+            size_t n = 1u + rnd() % 16u;
+            for (size_t i = 0; i < n; i++) {
+                cur.timestamp += 1u + (rnd() & 3u);
+                if (rnd() % 64u == 0) {
+                    cur.channelCount = (uint16_t)(rnd() % (MAX_AIN_PUBLIC_CHANNELS + 1u));
+                    cur.validMask = (uint16_t)rnd();
+                }
+                for (uint32_t j = 0; j < MAX_AIN_PUBLIC_CHANNELS; j++) {
+                    cur.values[j] = (rnd() % 32u == 0) ? edge_value()
+                                  : (int32_t)((uint32_t)cur.values[j] + rnd() % 9u - 4u);
+                }
+                rs[i] = cur;
+                push_sample(&rs[i]);
+            }
+            if (rnd() % 16u == 0) {
+                Nanopb_StreamingDeltaForceKeyframe();
+            }
+            NanopbFlagsArray f = stream_flags(false);
+            size_t got = Nanopb_EncodeStreamingFast(HostBoard_Data(), &f, g_out, OUT_SIZE);
+            ASSERT_TRUE(AInSampleList_IsEmpty());
+
+            size_t consumed = 0, nTicks = 0;
+            static PbTick ticks[16];
+            ASSERT_TRUE(PbDecode_Stream(&st, g_out, got, &consumed, ticks, 16, &nTicks));
+            ASSERT_EQ(consumed, got);
+
+            /* Walk the messages alongside the decoded ticks. */
+            size_t off = 0, t = 0;
+            for (size_t i = 0; i < n; i++) {
+                int32_t want[MAX_AIN_PUBLIC_CHANNELS];
+                size_t count = valid_values(&rs[i], want);
+                if (count == 0) continue;
+                if (t >= nTicks) { mismatches++; break; }
+                size_t len = 1u + g_out[off];
+                if (ticks[t].timestamp != rs[i].timestamp || ticks[t].count != count ||
+                    memcmp(ticks[t].values, want, count * sizeof(want[0])) != 0) {
+                    mismatches++;
+                }
+                if (ticks[t].isDelta) {
+                    deltas++;
+                    run++;
+                    if (run > maxRun) maxRun = run;
+                } else {
+                    run = 0;
+                    size_t ref = ref_call(g_ref, &rs[i], 1, false, NULL, NULL);
+                    if (ref != len || memcmp(g_ref, g_out + off, len) != 0) mismatches++;
+                }
+                off += len;
+                t++;
+            }
+            ASSERT_EQ(t, nTicks);
+        }
+        ASSERT_EQ(mismatches, 0);
+        ASSERT_TRUE(maxRun < K);
+        if (K > 1) {
+            ASSERT_TRUE(deltas > 0);
+        } else {
+            ASSERT_EQ(deltas, 0);
+        }
+        teardown();
+    }
+}
+
+TEST(test_delta_keyframe_triggers)
+{
+    setup(1);
+    Nanopb_StreamingDeltaConfigure(100);
+    NanopbFlagsArray f = stream_flags(false);
+    PbDecodeState st;
+    memset(&st, 0, sizeof(st));
+    static PbTick ticks[4];
+    size_t consumed, nTicks;
+    RefSample r = { .timestamp = 10, .channelCount = 4, .validMask = 0xF,
+                    .values = { 1000, 2000, 3000, 4000 } };
+
+#define ENCODE_ONE(expectDelta) do {                                           \
+        push_sample(&r);                                                       \
+        size_t got_ = Nanopb_EncodeStreamingFast(HostBoard_Data(), &f,         \
+                                                 g_out, OUT_SIZE);             \
+        ASSERT_TRUE(PbDecode_Stream(&st, g_out, got_, &consumed, ticks, 4,     \
+                                    &nTicks));                                 \
+        ASSERT_EQ(nTicks, 1);                                                  \
+        ASSERT_EQ(ticks[0].isDelta, (expectDelta));                            \
+        ASSERT_EQ(ticks[0].values[0], r.values[0]);                            \
+        r.timestamp++;                                                         \
+        r.values[0]++;                                                         \
+    } while (0)
+
+    ENCODE_ONE(false);                    /* first message of the session */
+    ENCODE_ONE(true);
+    Nanopb_StreamingDeltaForceKeyframe(); /* SD rotation / transport drop */
+    ENCODE_ONE(false);
+    ENCODE_ONE(true);
+    r.validMask = 0x7;                    /* layout change */
+    ENCODE_ONE(false);
+    ENCODE_ONE(true);
+    r.values[0] = -1000000;               /* deltas no smaller than the values */
+    r.values[1] = 1000000;
+    r.values[2] = -1000000;
+    ENCODE_ONE(false);
+    ENCODE_ONE(true);
+    Nanopb_StreamingDeltaConfigure(100);  /* next START */
+    ENCODE_ONE(false);
+    Nanopb_StreamingDeltaConfigure(0);    /* off: plain messages only */
+    ENCODE_ONE(false);
+    ENCODE_ONE(false);
+#undef ENCODE_ONE
+
+    /* A decoder that joins mid-chain rejects the delta it can't resolve. */
+    Nanopb_StreamingDeltaConfigure(100);
+    push_sample(&r);
+    push_sample(&r);
+    size_t got = Nanopb_EncodeStreamingFast(HostBoard_Data(), &f, g_out, OUT_SIZE);
+    size_t first = 1u + g_out[0];
+    ASSERT_TRUE(got > first);
+    memset(&st, 0, sizeof(st));
+    ASSERT_FALSE(PbDecode_Stream(&st, g_out + first, got - first, &consumed, ticks, 4, &nTicks));
+    teardown();
+}
+
+TEST(test_delta_never_larger)
+{
+    /* Full-scale noise: every message may fall back to a keyframe, but a delta
+     * session never costs more bytes than the plain one. */
+    setup(3);
+    Nanopb_StreamingDeltaConfigure(1000);
+    size_t deltaBytes = 0, plainBytes = 0;
+    for (unsigned iter = 0; iter < 2000u; iter++) {
+        RefSample rs[8];
+        for (size_t i = 0; i < 8; i++) {
+            random_sample(&rs[i]);
+            rs[i].channelCount = 16;
+            rs[i].validMask = 0xFFFFu;
+            push_sample(&rs[i]);
+        }
+        NanopbFlagsArray f = stream_flags(false);
+        deltaBytes += Nanopb_EncodeStreamingFast(HostBoard_Data(), &f, g_out, OUT_SIZE);
+        plainBytes += ref_call(g_ref, rs, 8, false, NULL, NULL);
+    }
+    ASSERT_TRUE(deltaBytes <= plainBytes);
+    teardown();
+}
+
+int main(void)
+{
+    printf("Streaming PB fast path vs nanopb\n");
+    printf("---------------------------------------------\n");
+    RUN(test_known_vector);
+    RUN(test_single_sample_matches_nanopb);
+    RUN(test_multi_sample_call_matches_nanopb);
+    RUN(test_short_buffer_fails_cleanly);
+    RUN(test_delta_known_vector);
+    RUN(test_delta_round_trip);
+    RUN(test_delta_keyframe_triggers);
+    RUN(test_delta_never_larger);
+    return TEST_SUMMARY();
+}
@@ -0,0 +1,300 @@
+/* ==========================================================================
+ * test_rate_control.c — host unit tests for firmware/src/Util/RateControl.c
+ *
+ * The adaptive-rate controller (SYST:STR:ADAPTive) driven by a simulated
+ * link. Each control period the device produces rate/divisor samples into a
+ * sample ring, the link carries what the bandwidth trace allows, and whatever
+ * overflows the ring is lost -- the firmware's backpressure model, where a
+ * slow transport blocks the encoder and the samples pile up in the pool until
+ * AllocateFromPool fails. Covers the AIMD steps, holdoff, the dead band,
+ * probe backoff on a marginal link, recovery, and a whole "night" trace run
+ * at 1.5x the static cap against the same trace at the cap itself.
+ *
+ * Run: make -C tests/host run
+ * ========================================================================== */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "RateControl.h"        /* real header (via -I firmware/src/Util) */
+#include "test_framework.h"
+
+#define PERIOD_MS        500u       /* RATE_CONTROL_PERIOD_MS in streaming.c */
+#define BYTES_PER_SAMPLE 10u
+#define RING_SAMPLES     2000u
+#define CAP_HZ           10000u     /* the static transport cap */
+#define ADAPTIVE_HZ      (CAP_HZ * 3u / 2u)
+
+/* --- Simulated link ---------------------------------------------------------- */
+
+typedef struct {
+    uint32_t rateHz;
+    uint32_t backlog;           /* samples in the ring */
+    uint64_t produced;
+    uint64_t delivered;
+    uint64_t lost;
+} SimLink;
+
+/* One period at @p linkBps bytes/s. Returns what the controller sees. */
+static RateControlSample_t sim_period(SimLink* l, uint32_t divisor, uint32_t linkBps)
+{
+    RateControlSample_t s = {0};
+    uint32_t produced = (l->rateHz / divisor) * PERIOD_MS / 1000u;
+    uint32_t canSend = (uint32_t)((uint64_t)linkBps * PERIOD_MS / 1000u / BYTES_PER_SAMPLE);
+    uint32_t have = l->backlog + produced;
+    uint32_t sent = (have < canSend) ? have : canSend;
+    uint32_t left = have - sent;
+    if (left > RING_SAMPLES) {
+        s.lostSamples = left - RING_SAMPLES;
+        left = RING_SAMPLES;
+    }
+    l->backlog = left;
+    l->produced += produced;
+    l->delivered += sent;
+    l->lost += s.lostSamples;
+    s.peakFillPct = left * 100u / RING_SAMPLES;
+    return s;
+}
+
+static RateControlStep step(RateControl_t* rc, SimLink* l, uint32_t linkBps)
+{
+    RateControlSample_t s = sim_period(l, RateControl_Divisor(rc), linkBps);
+    return RateControl_Update(rc, &s);
+}
+
+static RateControlSample_t clean(void)
+{
+    RateControlSample_t s = {0};
+    return s;
+}
+
+static RateControlSample_t lossy(void)
+{
+    RateControlSample_t s = {0};
+    s.lostSamples = 1u;
+    return s;
+}
+
+/* --- Tests ------------------------------------------------------------------- */
+
+TEST(test_defaults_and_clamps)
+{
+    RateControl_t rc;
+    RateControl_Init(&rc, NULL);
+    ASSERT_EQ(RateControl_Divisor(&rc), 1);
+    ASSERT_EQ(rc.raiseNeed, rc.cfg.raiseAfter);
+    ASSERT_TRUE(rc.cfg.fillLowPct < rc.cfg.fillHighPct);
+
+    RateControlConfig_t cfg = {0};
+    cfg.maxDivisor = 200u;
+    cfg.raiseAfter = 0u;
+    cfg.raiseAfterMax = 0u;
+    cfg.fillHighPct = 80u;
+    cfg.fillLowPct = 60u;
+    RateControl_Init(&rc, &cfg);
+    ASSERT_EQ(rc.cfg.maxDivisor, RATE_CONTROL_MAX_DIVISOR);
+    ASSERT_EQ(rc.cfg.raiseAfter, 1);
+    ASSERT_EQ(rc.cfg.raiseAfterMax, 1);
+}
+
+TEST(test_loss_halves_and_clean_periods_step_back)
+{
+    RateControl_t rc;
+    RateControl_Init(&rc, NULL);
+    RateControlSample_t bad = lossy();
+    RateControlSample_t ok = clean();
+
+    ASSERT_EQ(RateControl_Update(&rc, &bad), RATE_CONTROL_DOWN);
+    ASSERT_EQ(RateControl_Divisor(&rc), 2);
+    ASSERT_EQ(RateControl_Update(&rc, &bad), RATE_CONTROL_HOLD);   /* holdoff */
+    ASSERT_EQ(RateControl_Update(&rc, &bad), RATE_CONTROL_DOWN);
+    ASSERT_EQ(RateControl_Divisor(&rc), 4);
+    ASSERT_EQ(rc.decreases, 2);
+
+    ASSERT_EQ(RateControl_Update(&rc, &ok), RATE_CONTROL_HOLD);    /* holdoff */
+    for (uint8_t i = 1; i < rc.cfg.raiseAfter; i++) {
+        ASSERT_EQ(RateControl_Update(&rc, &ok), RATE_CONTROL_HOLD);
+    }
+    ASSERT_EQ(RateControl_Update(&rc, &ok), RATE_CONTROL_UP);
+    ASSERT_EQ(RateControl_Divisor(&rc), 3);                        /* additive */
+    ASSERT_EQ(rc.increases, 1);
+}
+
+TEST(test_transport_drops_and_fill_count_as_congestion)
+{
+    RateControl_t rc;
+    RateControl_Init(&rc, NULL);
+    RateControlSample_t s = clean();
+    s.droppedBytes = 100u;
+    ASSERT_EQ(RateControl_Update(&rc, &s), RATE_CONTROL_DOWN);
+
+    RateControl_Init(&rc, NULL);
+    s = clean();
+    s.peakFillPct = rc.cfg.fillHighPct;
+    ASSERT_EQ(RateControl_Update(&rc, &s), RATE_CONTROL_DOWN);
+}
+
+TEST(test_dead_band_neither_raises_nor_cuts)
+{
+    RateControl_t rc;
+    RateControl_Init(&rc, NULL);
+    RateControlSample_t bad = lossy();
+    RateControl_Update(&rc, &bad);
+    RateControl_Update(&rc, &bad);          /* holdoff */
+    ASSERT_EQ(RateControl_Divisor(&rc), 2);
+
+    RateControlSample_t mid = clean();
+    mid.peakFillPct = (rc.cfg.fillLowPct + rc.cfg.fillHighPct) / 2u;
+    for (int i = 0; i < 50; i++) {
+        ASSERT_EQ(RateControl_Update(&rc, &mid), RATE_CONTROL_HOLD);
+    }
+    ASSERT_EQ(RateControl_Divisor(&rc), 2);
+
+    /* The dead band also breaks a clean run. */
+    RateControlSample_t ok = clean();
+    for (uint8_t i = 1; i < rc.cfg.raiseAfter; i++) {
+        RateControl_Update(&rc, &ok);
+    }
+    RateControl_Update(&rc, &mid);
+    ASSERT_EQ(RateControl_Update(&rc, &ok), RATE_CONTROL_HOLD);
+    ASSERT_EQ(RateControl_Divisor(&rc), 2);
+}
+
+TEST(test_divisor_saturates_at_max)
+{
+    RateControlConfig_t cfg;
+    RateControl_DefaultConfig(&cfg);
+    cfg.maxDivisor = 6u;
+    cfg.holdoff = 0u;
+    RateControl_t rc;
+    RateControl_Init(&rc, &cfg);
+    RateControlSample_t bad = lossy();
+    for (int i = 0; i < 10; i++) {
+        RateControl_Update(&rc, &bad);
+    }
+    ASSERT_EQ(RateControl_Divisor(&rc), 6);     /* 1, 2, 4, then clamped */
+    ASSERT_EQ(rc.decreases, 3);
+}
+
+TEST(test_good_link_never_decimates)
+{
+    RateControl_t rc;
+    RateControl_Init(&rc, NULL);
+    SimLink l = { .rateHz = ADAPTIVE_HZ };
+    for (int i = 0; i < 600; i++) {
+        ASSERT_EQ(step(&rc, &l, ADAPTIVE_HZ * BYTES_PER_SAMPLE * 2u), RATE_CONTROL_HOLD);
+    }
+    ASSERT_EQ(RateControl_Divisor(&rc), 1);
+    ASSERT_EQ(l.lost, 0);
+    ASSERT_EQ(l.delivered, l.produced);
+}
+
+TEST(test_capacity_drop_then_recovery)
+{
+    RateControl_t rc;
+    RateControl_Init(&rc, NULL);
+    SimLink l = { .rateHz = ADAPTIVE_HZ };
+    uint32_t good = ADAPTIVE_HZ * BYTES_PER_SAMPLE * 2u;
+    uint32_t poor = ADAPTIVE_HZ * BYTES_PER_SAMPLE * 2u / 5u;   /* 40% of demand */
+
+    int i;
+    for (i = 0; i < 20; i++) step(&rc, &l, good);
+    for (i = 0; i < 6; i++) step(&rc, &l, poor);
+    /* 40% of demand needs d >= 2.5: the halvings land on 4. */
+    ASSERT_EQ(RateControl_Divisor(&rc), 4);
+    ASSERT_TRUE(l.lost > 0u);
+
+    /* Settled: 3 holds, and the probes at 2 that fail cost well under 1%. */
+    uint64_t lostBefore = l.lost, producedBefore = l.produced;
+    for (i = 0; i < 100; i++) {
+        step(&rc, &l, poor);
+        ASSERT_TRUE(RateControl_Divisor(&rc) >= 2u);
+    }
+    ASSERT_TRUE((l.lost - lostBefore) * 100u < l.produced - producedBefore);
+    lostBefore = l.lost;
+
+    int periods = 0;
+    while (RateControl_Divisor(&rc) > 1u && periods < 200) {
+        step(&rc, &l, good);
+        periods++;
+    }
+    ASSERT_EQ(RateControl_Divisor(&rc), 1);
+    ASSERT_TRUE(periods <= 4 * 8);                /* a few raiseAfter runs */
+    ASSERT_EQ(l.lost, lostBefore);
+}
+
+TEST(test_marginal_link_backs_off_probing)
+{
+    RateControl_t rc;
+    RateControl_Init(&rc, NULL);
+    SimLink l = { .rateHz = ADAPTIVE_HZ };
+    /* Just under full-rate demand: d = 1 always overflows, d = 2 never does. */
+    uint32_t link = ADAPTIVE_HZ * BYTES_PER_SAMPLE * 9u / 10u;
+
+    uint32_t probesFirstHalf = 0, probesSecondHalf = 0;
+    for (int i = 0; i < 1200; i++) {
+        uint32_t before = rc.failedProbes;
+        step(&rc, &l, link);
+        if (rc.failedProbes != before) {
+            if (i < 600) probesFirstHalf++; else probesSecondHalf++;
+        }
+    }
+    ASSERT_TRUE(probesFirstHalf > 0u);
+    ASSERT_TRUE(probesSecondHalf < probesFirstHalf);
+    ASSERT_EQ(rc.raiseNeed, rc.cfg.raiseAfterMax);
+    /* Each failed probe costs a little; the run as a whole stays clean. */
+    ASSERT_TRUE(l.lost * 100u < l.produced);
+    printf("    marginal link: %u failed probes, lost %.3f%%\n",
+           (unsigned)rc.failedProbes, 100.0 * (double)l.lost / (double)l.produced);
+}
+
+/* A night of WiFi: mostly well above the static cap's demand, with deep
+ * fades. Adaptive mode at 1.5x the cap must carry more than the static cap,
+ * and lose less of it. */
+static uint32_t night_link(int period)
+{
+    uint32_t capDemand = CAP_HZ * BYTES_PER_SAMPLE;
+    int phase = period % 240;
+    if (phase >= 200 && phase < 220) return capDemand / 2u;   /* 10 s fade */
+    if (phase >= 120 && phase < 125) return capDemand / 4u;   /* short dip */
+    return capDemand * 17u / 10u;
+}
+
+TEST(test_night_trace_beats_the_static_cap)
+{
+    RateControl_t rc;
+    RateControl_Init(&rc, NULL);
+    SimLink adaptive = { .rateHz = ADAPTIVE_HZ };
+    SimLink fixed = { .rateHz = CAP_HZ };
+
+    srand(18);
+    for (int i = 0; i < 2400; i++) {
+        uint32_t link = night_link(i);
+        link = link - link / 20u + (uint32_t)(rand() % (int)(link / 10u + 1u));
+        step(&rc, &adaptive, link);
+        sim_period(&fixed, 1u, link);
+    }
+    ASSERT_TRUE(adaptive.delivered * 10u > fixed.delivered * 12u);
+    ASSERT_TRUE(adaptive.lost < fixed.lost);
+    ASSERT_TRUE(adaptive.lost * 2u < fixed.lost);
+    printf("    night trace: adaptive delivered %.2fx the static cap; lost %.3f%% vs %.3f%%\n",
+           (double)adaptive.delivered / (double)fixed.delivered,
+           100.0 * (double)adaptive.lost / (double)adaptive.produced,
+           100.0 * (double)fixed.lost / (double)fixed.produced);
+}
+
+int main(void)
+{
+    printf("Adaptive rate control (AIMD decimation)\n");
+    printf("---------------------------------------\n");
+    RUN(test_defaults_and_clamps);
+    RUN(test_loss_halves_and_clean_periods_step_back);
+    RUN(test_transport_drops_and_fill_count_as_congestion);
+    RUN(test_dead_band_neither_raises_nor_cuts);
+    RUN(test_divisor_saturates_at_max);
+    RUN(test_good_link_never_decimates);
+    RUN(test_capacity_drop_then_recovery);
+    RUN(test_marginal_link_backs_off_probing);
+    RUN(test_night_trace_beats_the_static_cap);
+    return TEST_SUMMARY();
+}
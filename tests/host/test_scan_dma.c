@@ -0,0 +1,235 @@
+/* ==========================================================================
+ * test_scan_dma.c — host unit tests for firmware/src/Util/ScanDma.c
+ *
+ * The shared-scan selection rule behind MC12b_ComputeScanList and the
+ * CONF:ADC:SCAN:DMA ping-pong readout. The scan lists are replayed against
+ * the recorded NQ1 board map (16 user channels + the 8 common monitoring
+ * channels) and must reproduce the Harmony boot CSS minus the dead
+ * temperature sensor. The DMA is modelled on a fake ADCDATA register file:
+ * each "scan" writes a per-scan value into the scanned registers and the
+ * "DMAC" copies the layout's span into ScanDma_Target, so every read can be
+ * checked against the scan it must come from.
+ *
+ * Run: make -C tests/host run
+ * ========================================================================== */
+#include <stdint.h>
+#include <string.h>
+
+#include "ScanDma.h"            /* real header (via -I firmware/src/Util) */
+#include "test_framework.h"
+
+static uint32_t rng_state = 0x1F123BB5u;
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+/* NQ1BoardConfig.c AInChannels, in table order: user channels 0-15 then
+ * COMMON_MONITORING_CHANNELS_BOARDCONFIG (3.3V, 2.5VREF, VBATT, 5V, 10V,
+ * TEMP, 5VREF, VSYS). */
+typedef struct { uint8_t an; uint8_t type; bool isPublic; } BoardEntry_t;
+static const BoardEntry_t kNq1[] = {
+    {11, 2, true}, {24, 2, true}, {25, 2, true}, {26, 2, true},
+    { 4, 1, true}, {39, 2, true}, {38, 2, true}, {27, 2, true},
+    { 0, 1, true}, { 5, 2, true}, { 1, 1, true}, { 6, 2, true},
+    { 2, 1, true}, { 7, 2, true}, { 3, 1, true}, { 8, 2, true},
+    {19, 2, false}, {31, 2, false}, {30, 2, false}, {42, 2, false},
+    {32, 2, false}, {44, 2, false}, {29, 2, false}, {41, 2, false},
+};
+#define NQ1_COUNT       (sizeof(kNq1) / sizeof(kNq1[0]))
+#define NQ1_USER_COUNT  16u
+#define NQ1_TEMP_INDEX  21u
+
+/* MC12b_ComputeScanList over the recorded map. userEnabled is a bitmask of
+ * table indices 0-15; monitoring channels use their boot defaults (all on
+ * but TEMP). */
+static uint32_t compute(uint32_t userEnabled, bool enabledOnly,
+                        bool includeMonitoring, uint32_t* css1, uint32_t* css2) {
+    uint32_t count = 0;
+    *css1 = 0;
+    *css2 = 0;
+    for (uint32_t i = 0; i < NQ1_COUNT; i++) {
+        ScanListInput_t in = {
+            .an = kNq1[i].an,
+            .dedicated = (kNq1[i].type == 1),
+            .monitoring = !kNq1[i].isPublic,
+            .enabled = (i < NQ1_USER_COUNT) ? ((userEnabled >> i) & 1u)
+                                            : (i != NQ1_TEMP_INDEX),
+        };
+        if (ScanList_Includes(&in, enabledOnly, includeMonitoring)) {
+            ScanList_Add(css1, css2, in.an);
+            count++;
+        }
+    }
+    return count;
+}
+
+/* Fake result registers; scan k leaves k * 64 + an in every scanned one. */
+static uint32_t adcdata[SCAN_LIST_AN_COUNT];
+static uint32_t bufs[2][SCAN_DMA_MAX_WORDS];
+
+static void convert(const ScanLayout_t* l, uint32_t scan) {
+    for (uint32_t an = 0; an < SCAN_LIST_AN_COUNT; an++) {
+        if (ScanLayout_Contains(l, an)) {
+            adcdata[an] = scan * 64u + an;
+        }
+    }
+}
+
+/* The DMAC block transfer plus the DMA4 ISR. */
+static void dma_scan(ScanDma_t* d, uint32_t scan) {
+    convert(&d->layout, scan);
+    memcpy((void*)ScanDma_Target(d), &adcdata[d->layout.firstAn],
+           d->layout.words * sizeof(uint32_t));
+    (void)ScanDma_Complete(d);
+}
+
+TEST(test_nq1_scan_lists)
+{
+    uint32_t css1, css2;
+
+    /* Idle list: every public T2 + enabled monitoring = boot CSS
+     * (0xef0809e0 / 0x16c1) without AN44. */
+    ASSERT_EQ(compute(0, false, true, &css1, &css2), 18u);
+    ASSERT_EQ(css1, 0xef0809e0u);
+    ASSERT_EQ(css2, 0x16c1u & ~(1u << (44 - 32)));
+
+    /* Session, nothing enabled, OBDiag on: monitoring only. */
+    ASSERT_EQ(compute(0, true, true, &css1, &css2), 7u);
+    ASSERT_EQ(css1, (1u << 19) | (1u << 29) | (1u << 30) | (1u << 31));
+    ASSERT_EQ(css2, (1u << 0) | (1u << 9) | (1u << 10));
+
+    /* Session, channel 0 (AN11) only, OBDiag off. */
+    ASSERT_EQ(compute(1u << 0, true, false, &css1, &css2), 1u);
+    ASSERT_EQ(css1, 1u << 11);
+    ASSERT_EQ(css2, 0u);
+
+    /* Type 1 channels are never scanned. */
+    uint32_t t1 = (1u << 4) | (1u << 8) | (1u << 10) | (1u << 12) | (1u << 14);
+    ASSERT_EQ(compute(t1, true, false, &css1, &css2), 0u);
+    ASSERT_EQ(css1 | css2, 0u);
+
+    /* All 16 enabled, OBDiag off: the 11 public T2 inputs. */
+    ASSERT_EQ(compute(0xFFFFu, true, false, &css1, &css2), 11u);
+    ASSERT_EQ(css1, 0x0F0009E0u);
+    ASSERT_EQ(css2, (1u << 6) | (1u << 7));
+
+    /* The out-of-range guard. */
+    ScanListInput_t bad = {.an = 70, .dedicated = false, .monitoring = false, .enabled = true};
+    ASSERT_FALSE(ScanList_Includes(&bad, true, true));
+}
+
+TEST(test_layouts)
+{
+    ScanLayout_t l;
+
+    /* Idle list: AN5..AN42 span, 18 inputs. */
+    ASSERT_TRUE(ScanLayout_Build(&l, 0xef0809e0u, 0x06c1u));
+    ASSERT_EQ(l.firstAn, 5u);
+    ASSERT_EQ(l.lastAn, 42u);
+    ASSERT_EQ(l.count, 18u);
+    ASSERT_EQ(l.words, 38u);
+    ASSERT_EQ(ScanLayout_WordOffset(&l, 5), 0u);
+    ASSERT_EQ(ScanLayout_WordOffset(&l, 42), 37u);
+    ASSERT_TRUE(ScanLayout_Contains(&l, 32));
+    ASSERT_FALSE(ScanLayout_Contains(&l, 9));       /* inside span, not scanned */
+    ASSERT_FALSE(ScanLayout_Contains(&l, 44));
+
+    /* One input. */
+    ASSERT_TRUE(ScanLayout_Build(&l, 1u << 11, 0));
+    ASSERT_EQ(l.firstAn, 11u);
+    ASSERT_EQ(l.lastAn, 11u);
+    ASSERT_EQ(l.words, 1u);
+
+    /* The widest span still fits a buffer half. */
+    ASSERT_TRUE(ScanLayout_Build(&l, 1u, 1u << (44 - 32)));
+    ASSERT_EQ(l.words, SCAN_DMA_MAX_WORDS);
+
+    /* Empty, or past ADCDATA44: rejected and untouched. */
+    ScanLayout_Build(&l, 1u << 11, 0);
+    ASSERT_FALSE(ScanLayout_Build(&l, 0, 0));
+    ASSERT_FALSE(ScanLayout_Build(&l, 1u << 11, 1u << (45 - 32)));
+    ASSERT_EQ(l.firstAn, 11u);
+}
+
+TEST(test_ping_pong_readout)
+{
+    ScanLayout_t l;
+    ScanDma_t d;
+    uint32_t v;
+    ASSERT_TRUE(ScanLayout_Build(&l, 0xef0809e0u, 0x06c1u));
+    ScanDma_Init(&d, &l, bufs[0], bufs[1]);
+
+    /* Nothing completed yet. */
+    ASSERT_FALSE(ScanDma_Read(&d, 11, &v));
+    ASSERT_EQ(v, 0u);
+    ASSERT_TRUE(ScanDma_Target(&d) == bufs[0]);
+
+    for (uint32_t scan = 1; scan <= 5; scan++) {
+        dma_scan(&d, scan);
+        ASSERT_EQ(d.seq, scan);
+        /* The DMAC always refills the other half. */
+        ASSERT_TRUE(ScanDma_Target(&d) == bufs[scan & 1u]);
+        ASSERT_TRUE(ScanDma_Read(&d, 11, &v));
+        ASSERT_EQ(v, scan * 64u + 11u);
+        ASSERT_TRUE(ScanDma_Read(&d, 42, &v));
+        ASSERT_EQ(v, scan * 64u + 42u);
+    }
+
+    /* Not in the layout: no value, even though the span copies it. */
+    ASSERT_FALSE(ScanDma_Read(&d, 9, &v));
+    ASSERT_FALSE(ScanDma_Read(&d, 0, &v));
+
+    /* A scan landing in the target half does not show until completed. */
+    memset((void*)ScanDma_Target(&d), 0xA5, l.words * sizeof(uint32_t));
+    ASSERT_TRUE(ScanDma_Read(&d, 5, &v));
+    ASSERT_EQ(v, 5u * 64u + 5u);
+}
+
+TEST(test_random_layouts)
+{
+    uint32_t failures = 0;
+    for (uint32_t iter = 0; iter < 2000; iter++) {
+        uint32_t css1 = rng() & rng() & ~0x1Fu;     /* no dedicated AN0-4 */
+        uint32_t css2 = rng() & 0x1FFFu;            /* up to AN44 */
+        ScanLayout_t l;
+        ScanDma_t d;
+        if (!ScanLayout_Build(&l, css1, css2)) {
+            failures += (css1 | css2) != 0u;
+            continue;
+        }
+        ScanDma_Init(&d, &l, bufs[0], bufs[1]);
+        uint32_t scans = 1u + (rng() % 4u);
+        for (uint32_t s = 1; s <= scans; s++) {
+            dma_scan(&d, iter * 8u + s);
+        }
+        uint32_t seen = 0;
+        for (uint32_t an = 0; an < 64; an++) {
+            uint32_t v;
+            bool scanned = an < 32 ? ((css1 >> an) & 1u) : ((css2 >> (an - 32)) & 1u);
+            bool ok = ScanDma_Read(&d, an, &v);
+            if (ok != scanned || (ok && v != (iter * 8u + scans) * 64u + an)) {
+                failures++;
+            }
+            seen += ok;
+        }
+        if (seen != l.count || l.words != l.lastAn - l.firstAn + 1u ||
+            l.words > SCAN_DMA_MAX_WORDS) {
+            failures++;
+        }
+    }
+    ASSERT_EQ(failures, 0u);
+}
+
+int main(void)
+{
+    printf("Scan DMA (CONF:ADC:SCAN:DMA)\n");
+    printf("----------------------------\n");
+    RUN(test_nq1_scan_lists);
+    RUN(test_layouts);
+    RUN(test_ping_pong_readout);
+    RUN(test_random_layouts);
+    return TEST_SUMMARY();
+}
@@ -0,0 +1,753 @@
+/* ==========================================================================
+ * test_scpi_cmdindex.c — host tests for the libscpi command index
+ * (firmware/src/libraries/scpi/libscpi/src/cmdindex.c)
+ *
+ * The index must find exactly the command the linear scan in
+ * findCommandHeader() finds, for every header. Checked against:
+ *
+ *   - libscpi's own matchCommand() cases (test/test_scpi_utils.c), each as a
+ *     one-pattern table;
+ *   - the command-handling and error cases of libscpi's test/test_parser.c,
+ *     run through SCPI_Input() on an indexed and a linear context side by side;
+ *   - the firmware's real scpi_commands[] table, with every short/long/mixed
+ *     form of every pattern plus mutations and random headers;
+ *   - random tables using optional nodes and numeric suffixes.
+ *
+ * The libscpi sources are linked with --wrap=matchCommand, so the last case
+ * can count how many patterns each lookup actually tries.
+ *
+ * The pattern list and the match cases come from build-time headers the
+ * Makefile extracts (scpi_patterns_uut.h, scpi_match_cases_uut.h), so they
+ * always track the real sources.
+ *
+ * Run: make -C tests/host run
+ * ========================================================================== */
+#define _POSIX_C_SOURCE 199309L
+
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "scpi/scpi.h"          /* real libscpi (via -I libscpi/inc) */
+#include "utils_private.h"      /* matchCommand (via -I libscpi/src) */
+#include "test_framework.h"
+
+/* --- matchCommand call counting ------------------------------------------- */
+
+scpi_bool_t __real_matchCommand(const char * pattern, const char * cmd, size_t len,
+                                int32_t *numbers, size_t numbers_len, int32_t default_value);
+scpi_bool_t __wrap_matchCommand(const char * pattern, const char * cmd, size_t len,
+                                int32_t *numbers, size_t numbers_len, int32_t default_value);
+
+static unsigned long g_match_calls;
+
+scpi_bool_t __wrap_matchCommand(const char * pattern, const char * cmd, size_t len,
+                                int32_t *numbers, size_t numbers_len, int32_t default_value)
+{
+    g_match_calls++;
+    return __real_matchCommand(pattern, cmd, len, numbers, numbers_len, default_value);
+}
+
+/* --- Extracted sources ----------------------------------------------------- */
+
+static const char* const daqifi_patterns[] = {
+#include "scpi_patterns_uut.h"
+    NULL
+};
+
+typedef struct {
+    const char* pattern;
+    const char* header;
+    scpi_bool_t match;
+} MatchCase;
+
+static const MatchCase match_cases[] = {
+#include "scpi_match_cases_uut.h"
+};
+
+/* --- Helpers ---------------------------------------------------------------- */
+
+#define ENTRIES_MAX 4096
+
+static scpi_command_index_entry_t g_entries[ENTRIES_MAX];
+static scpi_command_index_t g_index;
+
+/* What findCommandHeader() did before the index. */
+static const scpi_command_t* linear_find(const scpi_command_t* cmdlist, const char* header, size_t len)
+{
+    for (size_t i = 0; cmdlist[i].pattern != NULL; i++) {
+        if (matchCommand(cmdlist[i].pattern, header, len, NULL, 0, 0)) {
+            return &cmdlist[i];
+        }
+    }
+    return NULL;
+}
+
+/* Headers whose index result differs from the linear scan's. */
+static unsigned g_mismatches;
+static unsigned g_found;
+static unsigned g_checked;
+
+static void check_header(const scpi_command_index_t* index, const char* header)
+{
+    size_t len = strlen(header);
+    const scpi_command_t* want = linear_find(index->cmdlist, header, len);
+    const scpi_command_t* got = SCPI_CommandIndexFind(index, header, len);
+    g_checked++;
+    if (want != NULL) {
+        g_found++;
+    }
+    if (got != want) {
+        if (g_mismatches++ < 10) {
+            printf("    mismatch: \"%s\" linear %s, index %s\n", header,
+                   want ? want->pattern : "(none)", got ? got->pattern : "(none)");
+        }
+    }
+}
+
+static uint32_t g_rng = 12345u;
+
+static uint32_t rnd(uint32_t n)
+{
+    g_rng = g_rng * 1103515245u + 12345u;
+    return (g_rng >> 8) % n;
+}
+
+static void random_case(char* s)
+{
+    for (; *s; s++) {
+        if (isalpha((unsigned char)*s) && rnd(2)) {
+            *s = (char)(islower((unsigned char)*s) ? toupper((unsigned char)*s) : tolower((unsigned char)*s));
+        }
+    }
+}
+
+/* --- Pattern nodes ---------------------------------------------------------- */
+
+#define NODES_MAX 8
+#define NODE_LEN  32
+
+typedef struct {
+    char longForm[NODE_LEN];
+    char shortForm[NODE_LEN];
+    int  suffix;                /* '#' */
+} Node;
+
+typedef struct {
+    Node node[NODES_MAX];
+    int  count;
+    int  query;
+    int  common;                /* "*IDN?" style */
+} Split;
+
+/* Splits a pattern without optional groups (brackets are dropped). */
+static void split_pattern(const char* p, Split* out)
+{
+    memset(out, 0, sizeof(*out));
+    size_t len = strlen(p);
+    if (len > 0 && p[len - 1] == '?') {
+        out->query = 1;
+        len--;
+    }
+    out->common = (p[0] == '*');
+    size_t i = 0;
+    while (i < len && out->count < NODES_MAX) {
+        while (i < len && (p[i] == ':' || p[i] == '[' || p[i] == ']')) i++;
+        if (i >= len) break;
+        Node* n = &out->node[out->count++];
+        size_t l = 0, s = 0;
+        int lower = 0;
+        while (i < len && p[i] != ':' && p[i] != '[' && p[i] != ']') {
+            if (p[i] == '#') {
+                n->suffix = 1;
+            } else if (l < NODE_LEN - 1) {
+                if (islower((unsigned char)p[i])) lower = 1;
+                n->longForm[l++] = (char)toupper((unsigned char)p[i]);
+                if (!lower) n->shortForm[s++] = p[i];
+            }
+            i++;
+        }
+    }
+}
+
+/* Builds a header from @p sp: node forms by @p mask (bit set = long). */
+static void build_header(const Split* sp, unsigned mask, int colon, int query,
+                         const char* digits, char* out, size_t cap)
+{
+    size_t o = 0;
+    out[0] = '\0';
+    if (colon) o += (size_t)snprintf(out + o, cap - o, ":");
+    for (int i = 0; i < sp->count && o < cap; i++) {
+        const Node* n = &sp->node[i];
+        o += (size_t)snprintf(out + o, cap - o, "%s%s%s", i ? ":" : "",
+                              (mask >> i) & 1u ? n->longForm : n->shortForm,
+                              n->suffix ? digits : "");
+    }
+    if (query && o < cap) snprintf(out + o, cap - o, "?");
+}
+
+/* --- Tests ------------------------------------------------------------------ */
+
+TEST(test_matchcommand_cases_agree)
+{
+    size_t n = sizeof(match_cases) / sizeof(match_cases[0]);
+    ASSERT_TRUE(n > 100);
+    for (size_t i = 0; i < n; i++) {
+        const MatchCase* c = &match_cases[i];
+        scpi_command_t table[2] = {
+            { .pattern = c->pattern, .callback = NULL, },
+            SCPI_CMD_LIST_END
+        };
+        ASSERT_TRUE(SCPI_CommandIndexInit(&g_index, table, g_entries, ENTRIES_MAX));
+        const scpi_command_t* got = SCPI_CommandIndexFind(&g_index, c->header, strlen(c->header));
+        if ((got != NULL) != (c->match == TRUE)) {
+            printf("    \"%s\" vs \"%s\": expected %s\n", c->pattern, c->header,
+                   c->match ? "match" : "no match");
+        }
+        ASSERT_EQ(got != NULL, c->match == TRUE);
+        ASSERT_TRUE(got == linear_find(table, c->header, strlen(c->header)));
+    }
+}
+
+/* test/test_parser.c's command table and callbacks */
+
+static scpi_result_t text_function(scpi_t* context)
+{
+    char param[100];
+    size_t param_len;
+
+    if (!SCPI_ParamCopyText(context, param, 100, &param_len, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+    if (!SCPI_ParamCopyText(context, param, 100, &param_len, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+    SCPI_ResultText(context, param);
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t test_treeA(scpi_t* context)
+{
+    SCPI_ResultInt32(context, 10);
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t test_treeB(scpi_t* context)
+{
+    SCPI_ResultInt32(context, 20);
+    return SCPI_RES_OK;
+}
+
+static double test_sample_received = NAN;
+
+static scpi_result_t SCPI_Sample(scpi_t* context)
+{
+    const char* val;
+    size_t len;
+    if (!SCPI_ParamArbitraryBlock(context, &val, &len, TRUE)) return SCPI_RES_ERR;
+    if (len != sizeof(test_sample_received)) return SCPI_RES_ERR;
+    memcpy(&test_sample_received, val, sizeof(test_sample_received));
+    return SCPI_RES_OK;
+}
+
+static const scpi_command_t parser_commands[] = {
+    { .pattern = "*CLS", .callback = SCPI_CoreCls,},
+    { .pattern = "*ESE", .callback = SCPI_CoreEse,},
+    { .pattern = "*ESE?", .callback = SCPI_CoreEseQ,},
+    { .pattern = "*ESR?", .callback = SCPI_CoreEsrQ,},
+    { .pattern = "*IDN?", .callback = SCPI_CoreIdnQ,},
+    { .pattern = "*OPC", .callback = SCPI_CoreOpc,},
+    { .pattern = "*OPC?", .callback = SCPI_CoreOpcQ,},
+    { .pattern = "*RST", .callback = SCPI_CoreRst,},
+    { .pattern = "*SRE", .callback = SCPI_CoreSre,},
+    { .pattern = "*SRE?", .callback = SCPI_CoreSreQ,},
+    { .pattern = "*STB?", .callback = SCPI_CoreStbQ,},
+    { .pattern = "*TST?", .callback = SCPI_CoreTstQ,},
+    { .pattern = "*WAI", .callback = SCPI_CoreWai,},
+
+    { .pattern = "SYSTem:ERRor[:NEXT]?", .callback = SCPI_SystemErrorNextQ,},
+    { .pattern = "SYSTem:ERRor:COUNt?", .callback = SCPI_SystemErrorCountQ,},
+    { .pattern = "SYSTem:VERSion?", .callback = SCPI_SystemVersionQ,},
+
+    { .pattern = "STATus:QUEStionable[:EVENt]?", .callback = SCPI_StatusQuestionableEventQ,},
+    { .pattern = "STATus:QUEStionable:CONDition?", .callback = SCPI_StatusQuestionableConditionQ,},
+    { .pattern = "STATus:QUEStionable:ENABle", .callback = SCPI_StatusQuestionableEnable,},
+    { .pattern = "STATus:QUEStionable:ENABle?", .callback = SCPI_StatusQuestionableEnableQ,},
+
+    { .pattern = "STATus:OPERation[:EVENt]?", .callback = SCPI_StatusOperationEventQ, },
+    { .pattern = "STATus:OPERation:CONDition?", .callback = SCPI_StatusOperationConditionQ, },
+    { .pattern = "STATus:OPERation:ENABle", .callback = SCPI_StatusOperationEnable, },
+    { .pattern = "STATus:OPERation:ENABle?", .callback = SCPI_StatusOperationEnableQ, },
+
+    { .pattern = "STATus:PRESet", .callback = SCPI_StatusPreset,},
+
+    { .pattern = "TEXTfunction?", .callback = text_function,},
+
+    { .pattern = "TEST:TREEA?", .callback = test_treeA,},
+    { .pattern = "TEST:TREEB?", .callback = test_treeB,},
+
+    { .pattern = "STUB", .callback = SCPI_Stub,},
+    { .pattern = "STUB?", .callback = SCPI_StubQ,},
+
+    { .pattern = "SAMple", .callback = SCPI_Sample,},
+    SCPI_CMD_LIST_END
+};
+
+#define SCPI_INPUT_BUFFER_LENGTH 256
+#define SCPI_ERROR_QUEUE_SIZE    4
+
+typedef struct {
+    scpi_t ctx;
+    char input[SCPI_INPUT_BUFFER_LENGTH];
+    scpi_error_t errq[SCPI_ERROR_QUEUE_SIZE];
+    char out[1024];
+    size_t outPos;
+    int_fast16_t err[128];
+    size_t errPos;
+} Session;
+
+static size_t session_write(scpi_t* context, const char* data, size_t len)
+{
+    Session* s = (Session*)context->user_context;
+    memcpy(s->out + s->outPos, data, len);
+    s->outPos += len;
+    s->out[s->outPos] = '\0';
+    return len;
+}
+
+static scpi_result_t session_flush(scpi_t* context)
+{
+    (void)context;
+    return SCPI_RES_OK;
+}
+
+static int session_error(scpi_t* context, int_fast16_t err)
+{
+    Session* s = (Session*)context->user_context;
+    s->err[s->errPos++] = err;
+    return 0;
+}
+
+static scpi_result_t session_control(scpi_t* context, scpi_ctrl_name_t ctrl, scpi_reg_val_t val)
+{
+    (void)context; (void)ctrl; (void)val;
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t session_reset(scpi_t* context)
+{
+    (void)context;
+    return SCPI_RES_OK;
+}
+
+static scpi_interface_t session_interface = {
+    .error = session_error,
+    .write = session_write,
+    .control = session_control,
+    .flush = session_flush,
+    .reset = session_reset,
+};
+
+static void session_init(Session* s, const scpi_command_index_t* index)
+{
+    memset(s, 0, sizeof(*s));
+    SCPI_Init(&s->ctx, parser_commands, &session_interface, scpi_units_def,
+              "MA", "IN", NULL, "VER",
+              s->input, SCPI_INPUT_BUFFER_LENGTH,
+              s->errq, SCPI_ERROR_QUEUE_SIZE);
+    s->ctx.user_context = s;
+    s->ctx.cmd_index = index;
+}
+
+static void session_clear(Session* s)
+{
+    s->out[0] = '\0';
+    s->outPos = 0;
+    s->err[0] = 0;
+    s->errPos = 0;
+    SCPI_RegClearBits(&s->ctx, SCPI_REG_STB, STB_QMA);
+    SCPI_RegSet(&s->ctx, SCPI_REG_ESR, 0);
+    SCPI_ErrorClear(&s->ctx);
+}
+
+typedef struct {
+    const char* in[2];          /* fed in turn, like one command split in two */
+    const char* out;            /* NULL: only compare the two sessions */
+    int result;                 /* -1: don't care */
+    int err;
+} ParserCase;
+
+#define LONG_INPUT \
+    "ABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJ" \
+    "ABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJ" \
+    "ABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJABCDEFGHIJ"
+
+static const ParserCase parser_cases[] = {
+    /* testCommandsHandling */
+    { { "*IDN?\r\n", NULL }, "MA,IN,0,VER\r\n", -1, 0 },
+    { { "*IDN?\r\n*IDN?\r\n*IDN?\r\n*IDN?\r\n", NULL },
+      "MA,IN,0,VER\r\nMA,IN,0,VER\r\nMA,IN,0,VER\r\nMA,IN,0,VER\r\n", -1, 0 },
+    { { "*IDN?;*IDN?;*IDN?;*IDN?\r\n", NULL }, "MA,IN,0,VER;MA,IN,0,VER;MA,IN,0,VER;MA,IN,0,VER\r\n", -1, 0 },
+    { { "*IDN?;STUB\r\n", NULL }, "MA,IN,0,VER\r\n", -1, 0 },
+    { { "*IDN?;*OPC;*IDN?\r\n", NULL }, "MA,IN,0,VER;MA,IN,0,VER\r\n", -1, 0 },
+    { { "*IDN?", "\r\n" }, "MA,IN,0,VER\r\n", -1, 0 },
+    { { ";*IDN?\r\n", NULL }, "MA,IN,0,VER\r\n", -1, 0 },
+    { { ";", "*IDN?\r\n" }, "MA,IN,0,VER\r\n", -1, 0 },
+    { { "*IDN?", "" }, "MA,IN,0,VER\r\n", -1, 0 },
+    { { "TEST:TREEA?;TREEB?\r\n", NULL }, "10;20\r\n", -1, 0 },
+    { { "TEST:TREEA?;:TEXT? \"PARAM1\", \"PARAM2\"\r\n", NULL }, "10;\"PARAM2\"\r\n", -1, 0 },
+    { { "TEXT? \"\", \"test\r\n\"\r\n", NULL }, "\"test\r\n\"\r\n", -1, 0 },
+    /* testErrorHandling */
+    { { "*IDN?\r\n", NULL }, "MA,IN,0,VER\r\n", TRUE, 0 },
+    { { "IDN?\r\n", NULL }, "", FALSE, SCPI_ERROR_UNDEFINED_HEADER },
+    { { "*ESE\r\n", NULL }, "", FALSE, SCPI_ERROR_MISSING_PARAMETER },
+    { { "*IDN? 12\r\n", NULL }, "MA,IN,0,VER\r\n", FALSE, SCPI_ERROR_PARAMETER_NOT_ALLOWED },
+    { { "TEXT? \"PARAM1\", \"PARAM2\"\r\n", NULL }, "\"PARAM2\"\r\n", TRUE, 0 },
+    { { LONG_INPUT, NULL }, "", FALSE, SCPI_ERROR_INPUT_BUFFER_OVERRUN },
+    { { "*SRE\r\n", NULL }, "", FALSE, SCPI_ERROR_MISSING_PARAMETER },
+    /* optional nodes, forms and tree traversal through the index */
+    { { "SYST:ERR?\r\n", NULL }, NULL, -1, 0 },
+    { { "syst:err:next?;COUN?\r\n", NULL }, NULL, -1, 0 },
+    { { ":STAT:OPER:EVEN?;COND?\r\n", NULL }, NULL, -1, 0 },
+    { { "STATus:QUEStionable:ENABle 5;ENAB?\r\n", NULL }, NULL, -1, 0 },
+    { { "stat:ques?;:STAT:PRES;*ESR?\r\n", NULL }, NULL, -1, 0 },
+    { { "TEST:TREEA?;TREEC?\r\n", NULL }, NULL, -1, 0 },
+    { { "TEST:TREE?\r\n", NULL }, NULL, -1, 0 },
+    { { ":*IDN?\r\n", NULL }, NULL, -1, 0 },
+    { { "TEXTfunction? \"a\", \"b\";TEXTF? \"c\", \"d\"\r\n", NULL }, NULL, -1, 0 },
+    { { "SAM #18abcdefgh\r\n", NULL }, NULL, -1, 0 },
+    { { "SYST:VERS?;SYST:VERSION?;SYST:VERSI?\r\n", NULL }, NULL, -1, 0 },
+};
+
+static void feed(Session* s, const ParserCase* c, scpi_bool_t* result)
+{
+    for (int k = 0; k < 2 && c->in[k] != NULL; k++) {
+        *result = SCPI_Input(&s->ctx, c->in[k], strlen(c->in[k]));
+    }
+}
+
+TEST(test_parser_cases_indexed_and_linear)
+{
+    static Session indexed, linear;
+    ASSERT_TRUE(SCPI_CommandIndexInit(&g_index, parser_commands, g_entries, ENTRIES_MAX));
+    ASSERT_EQ(g_index.unindexed, 0);
+    session_init(&indexed, &g_index);
+    session_init(&linear, NULL);
+
+    for (size_t i = 0; i < sizeof(parser_cases) / sizeof(parser_cases[0]); i++) {
+        const ParserCase* c = &parser_cases[i];
+        scpi_bool_t ri = FALSE, rl = FALSE;
+        session_clear(&indexed);
+        session_clear(&linear);
+        feed(&indexed, c, &ri);
+        feed(&linear, c, &rl);
+
+        if (strcmp(indexed.out, linear.out) != 0 || indexed.err[0] != linear.err[0] || ri != rl) {
+            printf("    case %zu (\"%.20s\"): indexed \"%s\"/%d/%d, linear \"%s\"/%d/%d\n", i, c->in[0],
+                   indexed.out, (int)indexed.err[0], ri, linear.out, (int)linear.err[0], rl);
+        }
+        ASSERT_TRUE(strcmp(indexed.out, linear.out) == 0);
+        ASSERT_EQ(indexed.errPos, linear.errPos);
+        ASSERT_EQ(indexed.err[0], linear.err[0]);
+        ASSERT_EQ(ri, rl);
+        if (c->out != NULL) {
+            ASSERT_TRUE(strcmp(indexed.out, c->out) == 0);
+            ASSERT_EQ(indexed.err[0], c->err);
+        }
+        if (c->result >= 0) {
+            ASSERT_EQ(ri, c->result);
+        }
+    }
+}
+
+TEST(test_index_that_does_not_fit_falls_back_to_linear)
+{
+    static Session s;
+    /* three short forms of two-letter nodes need more than 4 entries */
+    ASSERT_FALSE(SCPI_CommandIndexInit(&g_index, parser_commands, g_entries, 4));
+    ASSERT_TRUE(g_index.cmdlist == NULL);
+    ASSERT_TRUE(SCPI_CommandIndexFind(&g_index, "*IDN?", 5) == NULL);
+
+    session_init(&s, &g_index);
+    session_clear(&s);
+    ASSERT_TRUE(SCPI_Input(&s.ctx, "*IDN?;TEST:TREEB?\r\n", 19));
+    ASSERT_TRUE(strcmp(s.out, "MA,IN,0,VER;20\r\n") == 0);
+
+    /* an index built for another list is never consulted */
+    static const scpi_command_t other[] = {
+        { .pattern = "*IDN?", .callback = test_treeA, },
+        SCPI_CMD_LIST_END
+    };
+    ASSERT_TRUE(SCPI_CommandIndexInit(&g_index, other, g_entries, ENTRIES_MAX));
+    session_clear(&s);
+    ASSERT_TRUE(SCPI_Input(&s.ctx, "*IDN?\r\n", 7));
+    ASSERT_TRUE(strcmp(s.out, "MA,IN,0,VER\r\n") == 0);
+}
+
+static scpi_command_t g_daqifi[sizeof(daqifi_patterns) / sizeof(daqifi_patterns[0])];
+
+static void daqifi_table(void)
+{
+    for (size_t i = 0; i < sizeof(daqifi_patterns) / sizeof(daqifi_patterns[0]); i++) {
+        g_daqifi[i].pattern = daqifi_patterns[i];
+        g_daqifi[i].callback = NULL;
+    }
+}
+
+/* Every form of every pattern, each one mutated a few ways. */
+static void daqifi_forms(const Split* sp, const char* digits)
+{
+    char h[256];
+    unsigned masks = 1u << (sp->count > 6 ? 6 : sp->count);
+    for (unsigned mask = 0; mask < masks; mask++) {
+        for (int v = 0; v < 8; v++) {
+            int colon = v & 1, query = (v >> 1) & 1;
+            if (v & 4) {
+                query = sp->query;
+            }
+            build_header(sp, mask, colon, query, digits, h, sizeof(h));
+            check_header(&g_index, h);
+            random_case(h);
+            check_header(&g_index, h);
+
+            size_t len = strlen(h);
+            if (len > 2) {
+                /* truncated, digit appended, character dropped mid-way */
+                char t[256];
+                memcpy(t, h, len - 1);
+                t[len - 1] = '\0';
+                check_header(&g_index, t);
+                snprintf(t, sizeof(t), "%s7", h);
+                check_header(&g_index, t);
+                size_t cut = 1 + rnd((uint32_t)len - 1);
+                memcpy(t, h, cut);
+                strcpy(t + cut, h + cut + 1);
+                check_header(&g_index, t);
+            }
+        }
+    }
+}
+
+TEST(test_daqifi_table_index_matches_linear)
+{
+    daqifi_table();
+    size_t commands = sizeof(daqifi_patterns) / sizeof(daqifi_patterns[0]) - 1;
+    ASSERT_TRUE(commands > 250);
+    /* the firmware's SCPI_COMMAND_INDEX_ENTRIES */
+    ASSERT_TRUE(SCPI_CommandIndexInit(&g_index, g_daqifi, g_entries, 512));
+    ASSERT_EQ(g_index.unindexed, 0);
+    printf("    %zu commands, %u index entries (%zu bytes)\n", commands,
+           (unsigned)g_index.hashed, g_index.hashed * sizeof(scpi_command_index_entry_t));
+
+    g_mismatches = g_found = g_checked = 0;
+    Split sp;
+    for (size_t i = 0; i < commands; i++) {
+        split_pattern(daqifi_patterns[i], &sp);
+        daqifi_forms(&sp, "");
+        daqifi_forms(&sp, "12");
+
+        /* the pattern as written, and its short form, must find itself */
+        char h[256];
+        build_header(&sp, ~0u, 0, sp.query, "1", h, sizeof(h));
+        const scpi_command_t* found = SCPI_CommandIndexFind(&g_index, h, strlen(h));
+        ASSERT_TRUE(found != NULL);
+        ASSERT_TRUE(found == linear_find(g_daqifi, h, strlen(h)));
+    }
+
+    /* random headers from the table's own vocabulary */
+    static char vocab[4096][NODE_LEN];
+    size_t words = 0;
+    for (size_t i = 0; i < commands; i++) {
+        split_pattern(daqifi_patterns[i], &sp);
+        for (int n = 0; n < sp.count && words + 2 <= 4096; n++) {
+            strcpy(vocab[words++], sp.node[n].longForm);
+            strcpy(vocab[words++], sp.node[n].shortForm);
+        }
+    }
+    static const char* const junk[] = { "*", "?", "#", "1", "", "::", " ", "[", "]" };
+    for (int r = 0; r < 200000; r++) {
+        char h[256];
+        size_t o = 0;
+        int nodes = 1 + (int)rnd(4);
+        if (rnd(4) == 0) o += (size_t)snprintf(h + o, sizeof(h) - o, ":");
+        for (int n = 0; n < nodes; n++) {
+            o += (size_t)snprintf(h + o, sizeof(h) - o, "%s%s", n ? ":" : "", vocab[rnd((uint32_t)words)]);
+            if (rnd(8) == 0) {
+                o += (size_t)snprintf(h + o, sizeof(h) - o, "%s", junk[rnd(9)]);
+            }
+        }
+        if (rnd(2)) snprintf(h + o, sizeof(h) - o, "?");
+        random_case(h);
+        check_header(&g_index, h);
+    }
+
+    printf("    %u headers, %u matching a command, %u mismatches\n", g_checked, g_found, g_mismatches);
+    ASSERT_EQ(g_mismatches, 0);
+    ASSERT_TRUE(g_found > g_checked / 10);
+}
+
+/* Random tables in the full pattern syntax: optional nodes, '#' suffixes,
+ * multi-node and nested groups the index has to leave unindexed. */
+static const char* const synth_nodes[] = {
+    "MEASure", "VOLTage", "CURRent", "DC", "AC", "CHANnel#", "SOURce#", "SENSe",
+    "A", "Ab", "ABc", "AB", "TEST#", "NEXT", "EVENt", "STATus", "CONFigure", "ADC",
+    "LIST", "LISt", "lIST", "OUTPut#", "DNS1", "X", "ENABle",
+};
+static const char* const synth_groups[] = {
+    "[:NEXT]", "[:EVENt]", "[:SOURce#]", "[:DC]", "[:A:B]", "[:CHANnel[:LIST]]",
+};
+
+static void synth_pattern(char* out, size_t cap)
+{
+    size_t o = 0;
+    if (rnd(20) == 0) {
+        snprintf(out, cap, "*%s%s", rnd(2) ? "IDN" : "OPC", rnd(2) ? "?" : "");
+        return;
+    }
+    int nodes = 1 + (int)rnd(4);
+    for (int n = 0; n < nodes; n++) {
+        if (n == 0 && rnd(10) == 0) {
+            o += (size_t)snprintf(out + o, cap - o, "[%s]", synth_nodes[rnd(25)]);
+        } else if (n > 0 && rnd(4) == 0) {
+            o += (size_t)snprintf(out + o, cap - o, "%s", synth_groups[rnd(6)]);
+        } else {
+            o += (size_t)snprintf(out + o, cap - o, "%s%s", n ? ":" : "", synth_nodes[rnd(25)]);
+        }
+    }
+    if (rnd(3) == 0) snprintf(out + o, cap - o, "?");
+}
+
+TEST(test_random_tables_index_matches_linear)
+{
+    static char patterns[40][128];
+    static scpi_command_t table[41];
+    unsigned unindexed = 0;
+    g_mismatches = g_found = g_checked = 0;
+
+    for (int t = 0; t < 300; t++) {
+        int count = 1 + (int)rnd(40);
+        for (int i = 0; i < count; i++) {
+            synth_pattern(patterns[i], sizeof(patterns[i]));
+            table[i].pattern = patterns[i];
+            table[i].callback = NULL;
+        }
+        table[count].pattern = NULL;
+        ASSERT_TRUE(SCPI_CommandIndexInit(&g_index, table, g_entries, ENTRIES_MAX));
+        unindexed += g_index.unindexed;
+
+        for (int r = 0; r < 400; r++) {
+            char p[128], h[256];
+            Split sp;
+            /* headers derived from a pattern of the table, or a fresh one */
+            if (rnd(4)) {
+                strcpy(p, table[rnd((uint32_t)count)].pattern);
+            } else {
+                synth_pattern(p, sizeof(p));
+            }
+            split_pattern(p, &sp);
+            int keep = sp.count;
+            if (keep > 1 && rnd(4) == 0) keep--;                 /* optional node left out */
+            Split cut = sp;
+            cut.count = keep;
+            if (keep < sp.count && rnd(2)) {
+                memmove(&cut.node[keep - 1], &sp.node[keep], sizeof(Node)); /* ... mid-way */
+            }
+            static const char* const digits[] = { "", "1", "3", "12", "0" };
+            build_header(&cut, rnd(256), cut.common ? 0 : (int)rnd(2),
+                         rnd(4) ? sp.query : (int)rnd(2), digits[rnd(5)], h, sizeof(h));
+            if (cut.common && rnd(8) == 0) {
+                memmove(h + 1, h, strlen(h) + 1);
+                h[0] = ':';
+            }
+            random_case(h);
+            check_header(&g_index, h);
+        }
+    }
+
+    printf("    %u headers over 300 tables (%u unindexed patterns), %u matching, %u mismatches\n",
+           g_checked, unindexed, g_found, g_mismatches);
+    ASSERT_EQ(g_mismatches, 0);
+    ASSERT_TRUE(unindexed > 0);
+    ASSERT_TRUE(g_found > g_checked / 10);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+TEST(test_index_tries_few_patterns)
+{
+    daqifi_table();
+    ASSERT_TRUE(SCPI_CommandIndexInit(&g_index, g_daqifi, g_entries, 512));
+
+    /* a streaming-time command near the end of the table */
+    static const char* const hot[] = { "SYST:STR:STOP", "SYSTem:STReam:STATS?", "SYST:STR:DATA?" };
+    for (size_t i = 0; i < 3; i++) {
+        size_t len = strlen(hot[i]);
+        g_match_calls = 0;
+        const scpi_command_t* want = linear_find(g_daqifi, hot[i], len);
+        unsigned long linearCalls = g_match_calls;
+        g_match_calls = 0;
+        const scpi_command_t* got = SCPI_CommandIndexFind(&g_index, hot[i], len);
+        ASSERT_TRUE(want != NULL);
+        ASSERT_TRUE(got == want);
+        ASSERT_TRUE(g_match_calls <= 3);
+        ASSERT_TRUE(linearCalls >= 200);
+        printf("    %-22s %3lu matchCommand calls linear, %lu indexed\n", hot[i], linearCalls, g_match_calls);
+    }
+
+    /* every command's own short form, on average */
+    size_t commands = sizeof(daqifi_patterns) / sizeof(daqifi_patterns[0]) - 1;
+    static char headers[512][128];
+    unsigned long linearCalls = 0, indexCalls = 0;
+    for (size_t i = 0; i < commands; i++) {
+        Split sp;
+        split_pattern(daqifi_patterns[i], &sp);
+        build_header(&sp, 0, 0, sp.query, "1", headers[i], sizeof(headers[i]));
+        g_match_calls = 0;
+        linear_find(g_daqifi, headers[i], strlen(headers[i]));
+        linearCalls += g_match_calls;
+        g_match_calls = 0;
+        SCPI_CommandIndexFind(&g_index, headers[i], strlen(headers[i]));
+        indexCalls += g_match_calls;
+    }
+    ASSERT_TRUE(indexCalls * 50 < linearCalls);
+
+    const int rounds = 200;
+    double t0 = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < commands; i++) {
+            linear_find(g_daqifi, headers[i], strlen(headers[i]));
+        }
+    }
+    double t1 = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < commands; i++) {
+            SCPI_CommandIndexFind(&g_index, headers[i], strlen(headers[i]));
+        }
+    }
+    double t2 = now_ns();
+    double lookups = (double)rounds * (double)commands;
+    printf("    per lookup: %.1f vs %.2f matchCommand calls, %.0f vs %.0f ns (linear vs indexed)\n",
+           (double)linearCalls / (double)commands, (double)indexCalls / (double)commands,
+           (t1 - t0) / lookups, (t2 - t1) / lookups);
+}
+
+int main(void)
+{
+    printf("SCPI command index\n");
+    printf("------------------\n");
+    RUN(test_matchcommand_cases_agree);
+    RUN(test_parser_cases_indexed_and_linear);
+    RUN(test_index_that_does_not_fit_falls_back_to_linear);
+    RUN(test_daqifi_table_index_matches_linear);
+    RUN(test_random_tables_index_matches_linear);
+    RUN(test_index_tries_few_patterns);
+    return TEST_SUMMARY();
+}
@@ -0,0 +1,293 @@
+/* ==========================================================================
+ * test_sd_read_pump.c — firmware/src/Util/SdReadPump.c unit tests
+ *
+ * The SD:GET transfer loop over a RAM "file" and a model of the reply
+ * transport: a ring of RING_SIZE bytes that trySend fills without waiting,
+ * send fills by draining first, and the "USB task" drains by DRAIN_PER_READ
+ * bytes for every card read (the overlap the two halves exist for). What
+ * reaches the host is parsed as the device promises -- definite-length
+ * blocks, each followed by its CRC-32, ending in "#10" -- and compared with
+ * the file, including a transfer that is aborted, checked and resumed.
+ *
+ * Run: make -C tests/host run
+ * ========================================================================== */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CRC32.h"
+#include "SdReadPump.h"   /* real headers (via -I firmware/src/Util) */
+#include "test_framework.h"
+
+#define FILE_SIZE      (300u * 1024u + 123u)
+#define WIRE_CAP       (2u * FILE_SIZE)
+#define RING_SIZE      2048u
+#define DRAIN_PER_READ 1500u
+
+static uint8_t g_file[FILE_SIZE];
+static uint8_t g_wire[WIRE_CAP];
+static uint8_t g_buf[16384];
+
+typedef struct {
+    size_t   pos;            /* file read position */
+    size_t   readErrorAt;   /* a read at/after this position fails (0 = never) */
+    uint32_t abortAfter;    /* aborted() true after this many reads (0 = never) */
+    uint32_t reads;
+    size_t   ring;           /* bytes queued in the reply ring */
+    size_t   wireLen;        /* bytes the host has received */
+    size_t   drainedInRead;  /* ring bytes drained while a card read ran */
+} Io_t;
+
+static void io_drain(Io_t* io, size_t n)
+{
+    if (n > io->ring) {
+        n = io->ring;
+    }
+    io->ring -= n;
+}
+
+static size_t io_read(void* ctx, uint8_t* buf, size_t len)
+{
+    Io_t* io = (Io_t*)ctx;
+    io->reads++;
+    if (io->readErrorAt != 0u && io->pos + len > io->readErrorAt) {
+        return (size_t)-1;
+    }
+    size_t n = FILE_SIZE - io->pos;
+    if (n > len) {
+        n = len;
+    }
+    memcpy(buf, g_file + io->pos, n);
+    io->pos += n;
+    size_t before = io->ring;
+    io_drain(io, DRAIN_PER_READ);
+    io->drainedInRead += before - io->ring;
+    return n;
+}
+
+static void io_put(Io_t* io, const uint8_t* data, size_t n)
+{
+    memcpy(g_wire + io->wireLen, data, n);
+    io->wireLen += n;
+    io->ring += n;
+}
+
+static size_t io_try_send(void* ctx, const uint8_t* data, size_t len)
+{
+    Io_t* io = (Io_t*)ctx;
+    size_t n = RING_SIZE - io->ring;
+    if (n > len) {
+        n = len;
+    }
+    io_put(io, data, n);
+    return n;
+}
+
+static bool io_send(void* ctx, const uint8_t* data, size_t len)
+{
+    Io_t* io = (Io_t*)ctx;
+    while (len > 0u) {
+        if (io->ring == RING_SIZE) {
+            io_drain(io, 512u);   /* "wait" for the transport */
+        }
+        size_t n = io_try_send(ctx, data, len);
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool io_aborted(void* ctx)
+{
+    Io_t* io = (Io_t*)ctx;
+    return io->abortAfter != 0u && io->reads >= io->abortAfter;
+}
+
+static SdReadPumpResult pump(Io_t* io, size_t offset, uint64_t length, bool framed,
+                             size_t bufSize, uint64_t* pSent)
+{
+    SdReadPumpIo_t pio = {io_read, io_try_send, io_send, io_aborted, io};
+    io->pos = offset;
+    return SdReadPump_Run(&pio, g_buf, bufSize, length, framed, pSent);
+}
+
+/* Host side of framed mode: append every block whose CRC checks to @p out,
+ * stop at the first bad or incomplete one. Returns the verified payload
+ * bytes; *pEnded says the terminator was seen. */
+static size_t parse_blocks(const uint8_t* w, size_t len, uint8_t* out, bool* pEnded,
+                           uint32_t* pBlocks)
+{
+    size_t at = 0, got = 0;
+    *pEnded = false;
+    *pBlocks = 0;
+    while (at + 2u <= len && w[at] == '#') {
+        size_t digits = (size_t)(w[at + 1] - '0');
+        if (digits < 1u || digits > 9u || at + 2u + digits > len) {
+            break;
+        }
+        size_t n = 0;
+        for (size_t i = 0; i < digits; i++) {
+            n = n * 10u + (size_t)(w[at + 2u + i] - '0');
+        }
+        size_t data = at + 2u + digits;
+        if (data + n + 4u > len) {
+            break;
+        }
+        uint32_t crc = ((uint32_t)w[data + n] << 24) | ((uint32_t)w[data + n + 1] << 16) |
+                       ((uint32_t)w[data + n + 2] << 8) | w[data + n + 3];
+        if (crc != CRC32_Compute(w + data, n)) {
+            break;
+        }
+        if (n == 0u) {
+            *pEnded = true;
+            break;
+        }
+        memcpy(out + got, w + data, n);
+        got += n;
+        at = data + n + 4u;
+        (*pBlocks)++;
+    }
+    return got;
+}
+
+/* ------------------------------------------------------------------------ */
+
+TEST(test_block_header)
+{
+    uint8_t h[SD_READ_PUMP_HEADER_MAX];
+    ASSERT_EQ(SdReadPump_BlockHeader(h, 0u), 3u);
+    ASSERT_BYTES(h, "#10", 3u);
+    ASSERT_EQ(SdReadPump_BlockHeader(h, 7680u), 6u);
+    ASSERT_BYTES(h, "#47680", 6u);
+    ASSERT_EQ(SdReadPump_BlockHeader(h, 999999999u), 11u);
+    ASSERT_BYTES(h, "#9999999999", 11u);
+}
+
+TEST(test_unframed_sends_the_file_and_overlaps_reads)
+{
+    static Io_t io;
+    uint64_t sent;
+    memset(&io, 0, sizeof(io));
+    ASSERT_EQ(pump(&io, 0u, UINT64_MAX, false, sizeof(g_buf), &sent), SD_READ_PUMP_DONE);
+    ASSERT_EQ(sent, (uint64_t)FILE_SIZE);
+    ASSERT_EQ(io.wireLen, (size_t)FILE_SIZE);
+    ASSERT_BYTES(g_wire, g_file, FILE_SIZE);
+    /* Every read but the first ran with the previous chunk's bytes queued. */
+    ASSERT_TRUE(io.drainedInRead >= (size_t)(io.reads - 2u) * DRAIN_PER_READ);
+    printf("    %u reads, %u B drained under card reads\n",
+           (unsigned)io.reads, (unsigned)io.drainedInRead);
+}
+
+TEST(test_framed_range_round_trips)
+{
+    static uint8_t got[FILE_SIZE];
+    static const size_t bufs[] = {SD_READ_PUMP_MIN_BUFFER, 5000u, sizeof(g_buf)};
+    static const size_t offs[] = {0u, 1u, 4096u, 77777u, FILE_SIZE - 10u, FILE_SIZE};
+    static const uint64_t lens[] = {1u, 511u, 512u, 70000u, UINT64_MAX};
+    for (size_t b = 0; b < sizeof(bufs) / sizeof(bufs[0]); b++) {
+        for (size_t o = 0; o < sizeof(offs) / sizeof(offs[0]); o++) {
+            for (size_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+                static Io_t io;
+                uint64_t sent;
+                bool ended;
+                uint32_t blocks;
+                memset(&io, 0, sizeof(io));
+                ASSERT_EQ(pump(&io, offs[o], lens[l], true, bufs[b], &sent),
+                          SD_READ_PUMP_DONE);
+                size_t expect = FILE_SIZE - offs[o];
+                if (lens[l] < expect) {
+                    expect = (size_t)lens[l];
+                }
+                ASSERT_EQ(sent, (uint64_t)expect);
+                ASSERT_EQ(parse_blocks(g_wire, io.wireLen, got, &ended, &blocks), expect);
+                ASSERT_TRUE(ended);
+                ASSERT_BYTES(got, g_file + offs[o], expect);
+                /* Nothing after the terminator and its CRC. */
+                ASSERT_BYTES(g_wire + io.wireLen - 7u, "#10\0\0\0\0", 7u);
+            }
+        }
+    }
+}
+
+TEST(test_abort_then_resume_from_the_verified_bytes)
+{
+    static uint8_t got[FILE_SIZE];
+    static Io_t io;
+    uint64_t sent;
+    bool ended;
+    uint32_t blocks;
+    const size_t offset = 1000u;
+
+    memset(&io, 0, sizeof(io));
+    io.abortAfter = 9u;
+    ASSERT_EQ(pump(&io, offset, UINT64_MAX, true, sizeof(g_buf), &sent), SD_READ_PUMP_ABORTED);
+    /* The last chunk handed over may be cut short on the wire, as a stalled
+     * link would leave it; the host keeps only the blocks that check. */
+    size_t cut = io.wireLen - 100u;
+    size_t have = parse_blocks(g_wire, cut, got, &ended, &blocks);
+    ASSERT_FALSE(ended);
+    ASSERT_TRUE(have > 0u && have < sent);
+    ASSERT_BYTES(got, g_file + offset, have);
+
+    /* A flipped byte inside a block stops the host at that block. */
+    size_t cutBlocks = blocks;
+    g_wire[20] ^= 0x40u;
+    ASSERT_EQ(parse_blocks(g_wire, cut, got, &ended, &blocks), 0u);
+    g_wire[20] ^= 0x40u;
+
+    memset(&io, 0, sizeof(io));
+    ASSERT_EQ(pump(&io, offset + have, UINT64_MAX, true, sizeof(g_buf), &sent),
+              SD_READ_PUMP_DONE);
+    size_t rest = parse_blocks(g_wire, io.wireLen, got + have, &ended, &blocks);
+    ASSERT_TRUE(ended);
+    ASSERT_EQ(have + rest, (size_t)(FILE_SIZE - offset));
+    ASSERT_BYTES(got, g_file + offset, FILE_SIZE - offset);
+    printf("    resumed at +%u after %u verified blocks\n", (unsigned)have,
+           (unsigned)cutBlocks);
+}
+
+TEST(test_read_error_stops_on_a_block_boundary)
+{
+    static uint8_t got[FILE_SIZE];
+    static Io_t io;
+    uint64_t sent;
+    bool ended;
+    uint32_t blocks;
+
+    memset(&io, 0, sizeof(io));
+    io.readErrorAt = 50000u;
+    ASSERT_EQ(pump(&io, 0u, UINT64_MAX, true, sizeof(g_buf), &sent), SD_READ_PUMP_READ_ERROR);
+    /* Every chunk read before the error is on the wire whole. */
+    ASSERT_EQ(parse_blocks(g_wire, io.wireLen, got, &ended, &blocks), (size_t)sent);
+    ASSERT_FALSE(ended);
+    ASSERT_TRUE(sent > 0u && sent < 50000u);
+    ASSERT_BYTES(got, g_file, (size_t)sent);
+}
+
+TEST(test_small_buffer_is_refused)
+{
+    static Io_t io;
+    uint64_t sent;
+    memset(&io, 0, sizeof(io));
+    ASSERT_EQ(pump(&io, 0u, UINT64_MAX, true, SD_READ_PUMP_MIN_BUFFER - 1u, &sent),
+              SD_READ_PUMP_BAD_BUFFER);
+    ASSERT_EQ(io.reads, 0u);
+    ASSERT_EQ(io.wireLen, 0u);
+}
+
+int main(void)
+{
+    printf("SdReadPump host tests\n");
+    srand(15);
+    for (size_t i = 0; i < FILE_SIZE; i++) {
+        g_file[i] = (uint8_t)rand();
+    }
+    RUN(test_block_header);
+    RUN(test_unframed_sends_the_file_and_overlaps_reads);
+    RUN(test_framed_range_round_trips);
+    RUN(test_abort_then_resume_from_the_verified_bytes);
+    RUN(test_read_error_stops_on_a_block_boundary);
+    RUN(test_small_buffer_is_refused);
+    TEST_SUMMARY();
+}
@@ -0,0 +1,890 @@
+/* ==========================================================================
+ * test_sd_rotation.c — split-log rotation with pre-created parts, on the
+ * REAL FatFs (ff.c, the firmware's ffconf.h, ffprealloc.c) over a RAM disk.
+ *
+ * SdPartCache.c and SdBucket.c are tested directly: SdBucket's decisions
+ * first against a scripted card (unreadable buckets, failed mkdirs, full
+ * buckets), then driving the same FatFs calls sd_card_manager.c makes for
+ * SdBucketIo_t. Parts are created both ways the manager does it: inside the
+ * rotation window (OPEN_FILE, SdBucket_Place) and half way through the part
+ * before (SD_PrecreateNextLogFile, SdBucket_PlanPrecreate), with the rotation
+ * adopting the handle when SdBucket_Adoptable says it may.
+ *
+ * The stream is modelled too. While the rotation window is open, every card
+ * operation lets the encoder append to the ring, as it does on the device;
+ * the rotation splits the stream at its drain snapshot and the next part's
+ * header goes in behind it. Every part is read back: its header, then the
+ * stream picking up exactly where the previous part stopped.
+ * ========================================================================== */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ff.h"
+#include "diskio.h"
+#include "ffprealloc.h"
+#include "SdBucket.h"
+#include "SdPartCache.h"
+#include "test_framework.h"
+
+/* ---- RAM disk ---------------------------------------------------------- */
+
+#define SS          512u
+#define DISK_BYTES  (96u * 1024u * 1024u)
+#define DISK_SECTS  (DISK_BYTES / SS)
+#define CLUSTER     1024u          /* small clusters: ~98k, so mkfs picks FAT32 */
+
+static uint8_t* g_disk;            /* calloc'd: untouched pages stay virtual */
+static FATFS    g_fs;
+static uint32_t g_ops;             /* disk_read + disk_write calls */
+
+static void card_op(void);
+
+PARTITION VolToPart[FF_VOLUMES] = { {0, 0} };
+
+DWORD get_fattime(void)
+{
+    return ((DWORD)(2026 - 1980) << 25) | (1u << 21) | (1u << 16);
+}
+
+DSTATUS disk_initialize(uint8_t pdrv) { return pdrv == 0 ? 0 : STA_NOINIT; }
+DSTATUS disk_status(uint8_t pdrv)     { return pdrv == 0 ? 0 : STA_NOINIT; }
+
+DRESULT disk_read(uint8_t pdrv, uint8_t* buff, uint32_t sector, uint32_t count)
+{
+    if (pdrv != 0 || sector + count > DISK_SECTS) return RES_PARERR;
+    memcpy(buff, g_disk + (size_t)sector * SS, (size_t)count * SS);
+    card_op();
+    return RES_OK;
+}
+
+DRESULT disk_write(uint8_t pdrv, const uint8_t* buff, uint32_t sector, uint32_t count)
+{
+    if (pdrv != 0 || sector + count > DISK_SECTS) return RES_PARERR;
+    memcpy(g_disk + (size_t)sector * SS, buff, (size_t)count * SS);
+    card_op();
+    return RES_OK;
+}
+
+DRESULT disk_ioctl(uint8_t pdrv, uint8_t cmd, void* buff)
+{
+    if (pdrv != 0) return RES_PARERR;
+    switch (cmd) {
+        case CTRL_SYNC:        return RES_OK;
+        case GET_SECTOR_COUNT: *(LBA_t*)buff = DISK_SECTS; return RES_OK;
+        case GET_SECTOR_SIZE:  *(WORD*)buff = SS; return RES_OK;
+        case GET_BLOCK_SIZE:   *(DWORD*)buff = 1; return RES_OK;
+        default:               return RES_PARERR;
+    }
+}
+
+static void format_and_mount(void)
+{
+    static BYTE work[FF_MAX_SS * 4];
+    const MKFS_PARM opt = { FM_FAT32, 2, 0, 0, CLUSTER };
+    f_mount(NULL, "", 0);
+    memset(&g_fs, 0, sizeof(g_fs));
+    memset(g_disk, 0, DISK_BYTES);
+    if (f_mkfs("", &opt, work, sizeof(work)) != FR_OK || f_mount(&g_fs, "", 1) != FR_OK) {
+        printf("    cannot format the RAM disk\n");
+        exit(1);
+    }
+}
+
+static DWORD free_clusters(void)
+{
+    DWORD n = 0;
+    FATFS* fs;
+    (void)f_getfree("", &n, &fs);
+    return n;
+}
+
+/* ---- the stream -------------------------------------------------------- */
+
+#define RING_BYTES      (32u * 1024u)  /* the SD circular buffer */
+#define PART_BYTES      4096u          /* SD:MAXSize */
+#define ENCODE_CHUNK    512u           /* encoder output per steady-state pass */
+#define WINDOW_PER_OP   64u            /* encoder output per card op in the window */
+#define HEADER_LEN      10u            /* "PART01234\n" */
+
+static uint8_t  g_ring[RING_BYTES];
+static uint32_t g_ringHead, g_ringCount, g_ringPeak;
+static uint32_t g_streamPos;           /* stream bytes produced */
+static uint32_t g_seed;
+static uint32_t g_lost;                /* produced with the ring full */
+static uint32_t g_headerFor;           /* part whose header goes next, +1; 0 = none */
+static bool     g_inWindow;
+
+static uint8_t stream_byte(uint32_t pos) { return (uint8_t)(pos * 131u + (pos >> 8) + g_seed); }
+
+static void ring_push(const uint8_t* p, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        if (g_ringCount == RING_BYTES) {
+            g_lost += n - i;
+            return;
+        }
+        g_ring[(g_ringHead + g_ringCount) % RING_BYTES] = p[i];
+        g_ringCount++;
+    }
+    if (g_ringCount > g_ringPeak) g_ringPeak = g_ringCount;
+}
+
+static uint32_t ring_pop(uint8_t* p, uint32_t n)
+{
+    if (n > g_ringCount) n = g_ringCount;
+    for (uint32_t i = 0; i < n; i++) {
+        p[i] = g_ring[(g_ringHead + i) % RING_BYTES];
+    }
+    g_ringHead = (g_ringHead + n) % RING_BYTES;
+    g_ringCount -= n;
+    return n;
+}
+
+/* The encoder: a pending header first (Streaming_ResetSdFileHeader armed
+ * it), then samples. */
+static void produce(uint32_t n)
+{
+    uint8_t buf[ENCODE_CHUNK];
+    if (g_headerFor != 0) {
+        char hdr[16];
+        snprintf(hdr, sizeof(hdr), "PART%05u\n", (unsigned)(g_headerFor - 1u));
+        ring_push((const uint8_t*)hdr, HEADER_LEN);
+        g_headerFor = 0;
+    }
+    while (n > 0) {
+        uint32_t len = n < sizeof(buf) ? n : (uint32_t)sizeof(buf);
+        for (uint32_t i = 0; i < len; i++) buf[i] = stream_byte(g_streamPos + i);
+        g_streamPos += len;
+        ring_push(buf, len);
+        n -= len;
+    }
+}
+
+static void card_op(void)
+{
+    g_ops++;
+    if (g_inWindow) {
+        produce(WINDOW_PER_OP);
+    }
+}
+
+/* ---- the manager's part naming ----------------------------------------- */
+
+#define MAX_DIR_FILES   64u
+#define MAX_BUCKET      64u
+#define LOG_DIR         "LOGS"
+#define LOG_FILE        "run.bin"
+#define LOG_BASE        "run"
+#define MAX_PARTS       4200u
+
+static void bucket_path(char* out, size_t len, uint32_t bucket)
+{
+    if (bucket == 0) snprintf(out, len, "%s", LOG_DIR);
+    else             snprintf(out, len, "%s/P%03u", LOG_DIR, (unsigned)bucket);
+}
+
+static void part_path(char* out, size_t len, const char* dir, uint32_t counter)
+{
+    if (counter == 0) snprintf(out, len, "%s/%s", dir, LOG_FILE);
+    else              snprintf(out, len, "%s/%s-%u.bin", dir, LOG_BASE, (unsigned)counter);
+}
+
+static bool is_dir(const char* path)
+{
+    FILINFO fi;
+    return f_stat(path, &fi) == FR_OK && (fi.fattrib & AM_DIR) != 0;
+}
+
+static bool is_file(const char* path)
+{
+    FILINFO fi;
+    return f_stat(path, &fi) == FR_OK && (fi.fattrib & AM_DIR) == 0;
+}
+
+/* SdBucketIo_t on FatFs, as sd_card_manager.c implements it: sd_EnterBucket
+ * (mkdir, CountDirEntries' bounded walk, one stat of the next bucket),
+ * sd_BucketExists and sd_BucketHoldsPart. */
+static uint32_t g_partStats;           /* part-name stats: each a directory scan */
+
+static bool io_enter(void* ctx, uint32_t bucket, uint32_t* pCount,
+                     SdPartCache_t* pParts, bool* pNextExists)
+{
+    char path[32], next[32];
+    (void)ctx;
+    bucket_path(path, sizeof(path), bucket);
+    if (bucket != 0) {
+        FRESULT r = f_mkdir(path);
+        if (r != FR_OK && r != FR_EXIST) return false;
+    }
+    DIR d;
+    FILINFO fi;
+    uint32_t n = 0;
+    if (f_opendir(&d, path) == FR_OK) {
+        while (n < MAX_DIR_FILES) {
+            if (f_readdir(&d, &fi) != FR_OK) return false;
+            if (fi.fname[0] == '\0') break;
+            if (strcmp(fi.fname, ".") == 0 || strcmp(fi.fname, "..") == 0) continue;
+            if ((fi.fattrib & AM_DIR) == 0) {
+                SdPartCache_Note(pParts, fi.fname, LOG_BASE, LOG_FILE);
+            }
+            n++;
+        }
+        if (n >= MAX_DIR_FILES && (f_readdir(&d, &fi) != FR_OK || fi.fname[0] != '\0')) {
+            SdPartCache_Invalidate(pParts);
+        }
+        f_closedir(&d);
+    }
+    *pCount = n;
+    bucket_path(next, sizeof(next), bucket + 1u);
+    *pNextExists = bucket < MAX_BUCKET && is_dir(next);
+    return true;
+}
+
+static bool io_bucket_exists(void* ctx, uint32_t bucket, bool* pFsError)
+{
+    char path[32];
+    (void)ctx;
+    *pFsError = false;
+    bucket_path(path, sizeof(path), bucket);
+    return is_dir(path);
+}
+
+static bool io_part_exists(void* ctx, uint32_t bucket, uint32_t counter, bool* pFsError)
+{
+    char dir[32], path[64];
+    (void)ctx;
+    *pFsError = false;
+    bucket_path(dir, sizeof(dir), bucket);
+    part_path(path, sizeof(path), dir, counter);
+    g_partStats++;
+    return is_file(path);
+}
+
+static const SdBucketIo_t g_io = { NULL, io_enter, io_bucket_exists, io_part_exists };
+
+typedef enum { MODE_INLINE, MODE_PRECREATE } Mode_t;
+
+typedef struct {
+    Mode_t     mode;
+    SdBucket_t b;
+    FIL        cur, next;
+    bool       nextOpen;
+    uint32_t   nextCounter;
+    uint32_t   nextBucket;
+    uint32_t   counter;
+    uint32_t   curBytes;
+    bool       tried;
+    uint8_t    partBucket[MAX_PARTS];
+    /* results */
+    uint32_t   precreated, inlined;
+    uint32_t   partStats;
+    uint32_t   worstWindowOps;
+    uint32_t   worstWindowPart;
+} Session_t;
+
+static bool open_part(FIL* fp, uint32_t bucket, uint32_t counter)
+{
+    char dir[32], path[64];
+    bucket_path(dir, sizeof(dir), bucket);
+    part_path(path, sizeof(path), dir, counter);
+    if (f_open(fp, path, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) return false;
+    (void)f_reserve(fp, PART_BYTES);
+    return true;
+}
+
+/* OPEN_FILE: SdBucket_Place, then the create. */
+static bool open_inline(Session_t* s, uint32_t counter)
+{
+    bool reopen;
+    uint32_t stats = g_partStats;
+    SdBucketResult r = SdBucket_Place(&s->b, &g_io, counter, &reopen);
+    s->partStats += g_partStats - stats;
+    if (r != SD_BUCKET_OK) return false;
+    s->partBucket[counter] = (uint8_t)s->b.cur;
+    return open_part(&s->cur, s->b.cur, counter);
+}
+
+/* SD_PrecreateNextLogFile: SdBucket_PlanPrecreate, then the create. */
+static void precreate(Session_t* s)
+{
+    uint32_t counter = s->counter + 1u;
+    s->tried = true;
+    SdBucketPrecreate plan = SdBucket_PlanPrecreate(&s->b, &g_io, counter);
+    if (plan != SD_BUCKET_PRE_NEW && plan != SD_BUCKET_PRE_REOPEN) return;
+    if (!open_part(&s->next, s->b.cur, counter)) return;
+    if (plan == SD_BUCKET_PRE_NEW) SdBucket_NoteCreated(&s->b, counter);
+    s->partBucket[counter] = (uint8_t)s->b.cur;
+    s->nextOpen = true;
+    s->nextCounter = counter;
+    s->nextBucket = s->b.cur;
+}
+
+static bool write_out(FIL* fp, uint32_t n, uint32_t* pBytes)
+{
+    static uint8_t buf[4096];
+    while (n > 0) {
+        uint32_t len = ring_pop(buf, n < sizeof(buf) ? n : (uint32_t)sizeof(buf));
+        UINT bw = 0;
+        if (len == 0) return true;
+        if (f_write(fp, buf, len, &bw) != FR_OK || bw != len) return false;
+        *pBytes += len;
+        n -= len;
+    }
+    return true;
+}
+
+static bool rotate(Session_t* s)
+{
+    uint32_t ops = g_ops;
+    g_inWindow = true;
+    /* The drain snapshot: the old part's share; the next header behind it. */
+    uint32_t snapshot = g_ringCount;
+    g_headerFor = s->counter + 2u;
+    bool ok = write_out(&s->cur, snapshot, &s->curBytes);
+    ok = ok && f_release(&s->cur) == FR_OK;
+    ok = ok && f_close(&s->cur) == FR_OK;
+    s->counter++;
+    if (s->nextOpen && SdBucket_Adoptable(&s->b, s->nextBucket, s->nextCounter, s->counter)) {
+        s->cur = s->next;
+        s->nextOpen = false;
+        s->precreated++;
+    } else {
+        ok = ok && open_inline(s, s->counter);
+        s->inlined++;
+    }
+    g_inWindow = false;
+    if (g_ops - ops > s->worstWindowOps) {
+        s->worstWindowOps = g_ops - ops;
+        s->worstWindowPart = s->counter;
+    }
+    s->curBytes = 0;
+    s->tried = false;
+    return ok;
+}
+
+/* One logging session: parts 0..lastPart, stopping @p stopBytes into the
+ * last one. Returns false on any FatFs error. */
+static bool run_session(Session_t* s, Mode_t mode, uint32_t lastPart, uint32_t stopBytes,
+                        uint32_t seed)
+{
+    memset(s, 0, sizeof(*s));
+    s->mode = mode;
+    g_ringHead = g_ringCount = g_ringPeak = 0;
+    g_streamPos = 0;
+    g_lost = 0;
+    g_seed = seed;
+    g_headerFor = 1u;
+    (void)f_mkdir(LOG_DIR);
+    SdBucket_Init(&s->b, MAX_DIR_FILES, MAX_BUCKET);
+    if (!SdBucket_Enter(&s->b, &g_io, 0) || !open_inline(s, 0)) return false;
+    for (;;) {
+        produce(ENCODE_CHUNK);
+        if (!write_out(&s->cur, (g_ringCount / SS) * SS, &s->curBytes)) return false;
+        if (s->counter == lastPart && s->curBytes >= stopBytes) break;
+        if (mode == MODE_PRECREATE && !s->tried && !s->nextOpen
+                && s->curBytes >= PART_BYTES / 2u) {
+            precreate(s);
+        }
+        if (s->curBytes >= PART_BYTES && !rotate(s)) return false;
+    }
+    /* STOP: the unmount drain, then the unused part is closed and removed. */
+    bool ok = write_out(&s->cur, g_ringCount, &s->curBytes);
+    ok = ok && f_release(&s->cur) == FR_OK && f_close(&s->cur) == FR_OK;
+    if (s->nextOpen) {
+        char path[64], dir[32];
+        bucket_path(dir, sizeof(dir), s->partBucket[s->nextCounter]);
+        part_path(path, sizeof(path), dir, s->nextCounter);
+        ok = ok && f_release(&s->next) == FR_OK && f_close(&s->next) == FR_OK;
+        ok = ok && f_unlink(path) == FR_OK;
+        s->nextOpen = false;
+    }
+    return ok;
+}
+
+/* Every part is its header followed by the stream, continuing exactly where
+ * the previous part stopped, and the parts hold the whole stream. */
+static bool parts_hold_the_stream(const Session_t* s, uint32_t lastPart)
+{
+    static uint8_t buf[PART_BYTES * 2];
+    uint32_t pos = 0;
+    for (uint32_t c = 0; c <= lastPart; c++) {
+        char dir[32], path[64], hdr[HEADER_LEN + 1];
+        bucket_path(dir, sizeof(dir), s->partBucket[c]);
+        part_path(path, sizeof(path), dir, c);
+        FIL f;
+        UINT br = 0;
+        if (f_open(&f, path, FA_READ) != FR_OK) {
+            printf("    part %u missing (%s)\n", (unsigned)c, path);
+            return false;
+        }
+        bool ok = f_size(&f) <= sizeof(buf) && f_read(&f, buf, sizeof(buf), &br) == FR_OK;
+        f_close(&f);
+        snprintf(hdr, sizeof(hdr), "PART%05u\n", (unsigned)c);
+        if (!ok || br < HEADER_LEN || memcmp(buf, hdr, HEADER_LEN) != 0) {
+            printf("    part %u: no header\n", (unsigned)c);
+            return false;
+        }
+        for (uint32_t i = HEADER_LEN; i < br; i++, pos++) {
+            if (buf[i] != stream_byte(pos)) {
+                printf("    part %u: stream breaks at byte %u\n", (unsigned)c, (unsigned)i);
+                return false;
+            }
+        }
+    }
+    return pos == g_streamPos;
+}
+
+/* No bucket holds more than its ceiling, and each part exists exactly once. */
+static bool layout_is_sound(uint32_t lastPart)
+{
+    static uint8_t seen[MAX_PARTS + 1];
+    memset(seen, 0, sizeof(seen));
+    for (uint32_t bk = 0; bk <= MAX_BUCKET; bk++) {
+        char dir[32];
+        DIR d;
+        FILINFO fi;
+        uint32_t n = 0;
+        bucket_path(dir, sizeof(dir), bk);
+        if (f_opendir(&d, dir) != FR_OK) break;
+        while (f_readdir(&d, &fi) == FR_OK && fi.fname[0] != '\0') {
+            uint32_t c;
+            if (bk == 0 && (fi.fattrib & AM_DIR)) continue;     /* the buckets */
+            n++;
+            if (SdPartCache_ParseName(fi.fname, LOG_BASE, LOG_FILE, &c)
+                    && c <= MAX_PARTS && seen[c]++ != 0) {
+                printf("    part %u found twice\n", (unsigned)c);
+                return false;
+            }
+        }
+        f_closedir(&d);
+        if (n > MAX_DIR_FILES) {
+            printf("    %s holds %u entries\n", dir, (unsigned)n);
+            return false;
+        }
+    }
+    for (uint32_t c = 0; c <= MAX_PARTS; c++) {
+        if ((seen[c] != 0) != (c <= lastPart)) {
+            printf("    part %u %s\n", (unsigned)c, seen[c] ? "left behind" : "missing");
+            return false;
+        }
+    }
+    return true;
+}
+
+/* ---- tests ------------------------------------------------------------- */
+
+TEST(test_parse_names)
+{
+    uint32_t c = 99;
+    ASSERT_TRUE(SdPartCache_ParseName("run.bin", "run", "run.bin", &c));
+    ASSERT_EQ(c, 0);
+    ASSERT_TRUE(SdPartCache_ParseName("run-1.bin", "run", "run.bin", &c));
+    ASSERT_EQ(c, 1);
+    ASSERT_TRUE(SdPartCache_ParseName("RUN-4711.BIN", "run", "run.bin", &c));
+    ASSERT_EQ(c, 4711);
+    ASSERT_TRUE(SdPartCache_ParseName("log-12", "log", "log", &c));     /* no extension */
+    ASSERT_EQ(c, 12);
+    ASSERT_FALSE(SdPartCache_ParseName("run-0.bin", "run", "run.bin", &c));
+    ASSERT_FALSE(SdPartCache_ParseName("run-01.bin", "run", "run.bin", &c));
+    ASSERT_FALSE(SdPartCache_ParseName("run-.bin", "run", "run.bin", &c));
+    ASSERT_FALSE(SdPartCache_ParseName("run-1.bin.bak", "run", "run.bin", &c));
+    ASSERT_FALSE(SdPartCache_ParseName("run-1.csv", "run", "run.bin", &c));
+    ASSERT_FALSE(SdPartCache_ParseName("run-1x.bin", "run", "run.bin", &c));
+    ASSERT_FALSE(SdPartCache_ParseName("rerun-1.bin", "run", "run.bin", &c));
+    ASSERT_FALSE(SdPartCache_ParseName("run-1234567890.bin", "run", "run.bin", &c));
+    ASSERT_FALSE(SdPartCache_ParseName("run", "run", "run.bin", &c));
+}
+
+TEST(test_lookup_and_add)
+{
+    SdPartCache_t c;
+    bool present = true;
+    SdPartCache_Init(&c);
+    ASSERT_TRUE(SdPartCache_Lookup(&c, 0, &present));
+    ASSERT_FALSE(present);
+    ASSERT_TRUE(SdPartCache_Lookup(&c, 7, &present));
+    ASSERT_FALSE(present);
+
+    /* A session's parts, in order: exact throughout. */
+    SdPartCache_Add(&c, 0);
+    for (uint32_t n = 1; n <= 5; n++) SdPartCache_Add(&c, n);
+    SdPartCache_Add(&c, 3);                                 /* a reopen adds nothing */
+    for (uint32_t n = 0; n <= 5; n++) {
+        ASSERT_TRUE(SdPartCache_Lookup(&c, n, &present));
+        ASSERT_TRUE(present);
+    }
+    ASSERT_TRUE(SdPartCache_Lookup(&c, 6, &present));
+    ASSERT_FALSE(present);
+
+    /* A walk that finds a hole knows the outside, not the inside. */
+    SdPartCache_Init(&c);
+    SdPartCache_Note(&c, "run-9.bin", "run", "run.bin");
+    SdPartCache_Note(&c, "run-7.bin", "run", "run.bin");
+    SdPartCache_Note(&c, "notes.txt", "run", "run.bin");
+    ASSERT_FALSE(SdPartCache_Lookup(&c, 8, &present));
+    ASSERT_TRUE(SdPartCache_Lookup(&c, 6, &present));
+    ASSERT_FALSE(present);
+    ASSERT_TRUE(SdPartCache_Lookup(&c, 10, &present));
+    ASSERT_FALSE(present);
+    SdPartCache_Add(&c, 10);
+    ASSERT_TRUE(SdPartCache_Lookup(&c, 11, &present));
+    ASSERT_FALSE(present);
+    SdPartCache_Add(&c, 20);                                /* not adjacent */
+    ASSERT_FALSE(SdPartCache_Lookup(&c, 11, &present));
+    ASSERT_FALSE(SdPartCache_Lookup(&c, 0, &present));
+
+    /* A walk cut short knows nothing. */
+    SdPartCache_Init(&c);
+    SdPartCache_Invalidate(&c);
+    ASSERT_FALSE(SdPartCache_Lookup(&c, 1, &present));
+}
+
+/* A scripted card for SdBucket: which buckets exist, how full each is, which
+ * parts each holds, and which operations fail. */
+typedef struct {
+    bool     exists[8];
+    uint32_t count[8];
+    uint32_t parts[8];          /* bit n: part n */
+    bool     partial[8];        /* the walk stops early */
+    int      failEnter;         /* bucket whose mkdir fails, -1 none */
+    int      unreadable;        /* bucket whose stat fails, -1 none */
+    uint32_t enters, stats;
+} FakeCard_t;
+
+static bool fake_enter(void* ctx, uint32_t bucket, uint32_t* pCount,
+                       SdPartCache_t* pParts, bool* pNextExists)
+{
+    FakeCard_t* c = ctx;
+    c->enters++;
+    if ((int)bucket == c->failEnter) return false;
+    c->exists[bucket] = true;
+    *pCount = c->count[bucket];
+    for (uint32_t n = 0; n < 32; n++) {
+        if (c->parts[bucket] & (1u << n)) {
+            char name[16];
+            if (n == 0) snprintf(name, sizeof(name), "%s", LOG_FILE);
+            else        snprintf(name, sizeof(name), "%s-%u.bin", LOG_BASE, (unsigned)n);
+            SdPartCache_Note(pParts, name, LOG_BASE, LOG_FILE);
+        }
+    }
+    if (c->partial[bucket]) SdPartCache_Invalidate(pParts);
+    *pNextExists = bucket + 1u < 8u && c->exists[bucket + 1u];
+    return true;
+}
+
+static bool fake_bucket_exists(void* ctx, uint32_t bucket, bool* pFsError)
+{
+    FakeCard_t* c = ctx;
+    *pFsError = (int)bucket == c->unreadable;
+    return bucket < 8u && c->exists[bucket];
+}
+
+static bool fake_part_exists(void* ctx, uint32_t bucket, uint32_t counter, bool* pFsError)
+{
+    FakeCard_t* c = ctx;
+    c->stats++;
+    *pFsError = false;
+    return (c->parts[bucket] >> counter) & 1u;
+}
+
+static void fake_card(FakeCard_t* c, SdBucketIo_t* io, SdBucket_t* b)
+{
+    memset(c, 0, sizeof(*c));
+    c->exists[0] = true;
+    c->failEnter = -1;
+    c->unreadable = -1;
+    io->ctx = c;
+    io->enter = fake_enter;
+    io->bucketExists = fake_bucket_exists;
+    io->partExists = fake_part_exists;
+    SdBucket_Init(b, 4, 5);     /* 4 entries per bucket, buckets 0..5 */
+}
+
+TEST(test_bucket_place)
+{
+    FakeCard_t c;
+    SdBucketIo_t io;
+    SdBucket_t b;
+    bool reopen;
+
+    /* Fresh card: parts fill bucket 0, then roll into 1, no stat needed. */
+    fake_card(&c, &io, &b);
+    ASSERT_TRUE(SdBucket_Enter(&b, &io, 0));
+    for (uint32_t n = 0; n < 6; n++) {
+        ASSERT_EQ(SdBucket_Place(&b, &io, n, &reopen), SD_BUCKET_OK);
+        ASSERT_FALSE(reopen);
+        ASSERT_EQ(b.cur, n < 4 ? 0u : 1u);
+    }
+    ASSERT_EQ(c.stats, 0);
+    ASSERT_EQ(b.filesIn, 2);
+    ASSERT_TRUE(SdBucket_Full(&b) == false);
+
+    /* An earlier session's part 6 lives in bucket 2: reopened there, and it
+     * adds no entry. */
+    fake_card(&c, &io, &b);
+    c.exists[1] = c.exists[2] = true;
+    c.count[0] = 2;
+    c.count[2] = 3;
+    c.parts[2] = 1u << 6;
+    ASSERT_TRUE(SdBucket_Enter(&b, &io, 0));
+    ASSERT_TRUE(b.nextExists);
+    ASSERT_EQ(SdBucket_Place(&b, &io, 6, &reopen), SD_BUCKET_OK);
+    ASSERT_TRUE(reopen);
+    ASSERT_EQ(b.cur, 2);
+    ASSERT_EQ(b.countAtStart, 3);
+    ASSERT_EQ(b.filesIn, 0);
+
+    /* A bucket that cannot be stat'ed ends the search in a refusal, not a
+     * duplicate part. */
+    fake_card(&c, &io, &b);
+    c.exists[1] = true;
+    c.unreadable = 1;
+    ASSERT_TRUE(SdBucket_Enter(&b, &io, 0));
+    ASSERT_EQ(SdBucket_Place(&b, &io, 1, &reopen), SD_BUCKET_UNREADABLE);
+
+    /* A walk that stopped early makes the active bucket cost a stat. */
+    fake_card(&c, &io, &b);
+    c.partial[0] = true;
+    c.parts[0] = 1u << 3;
+    ASSERT_TRUE(SdBucket_Enter(&b, &io, 0));
+    ASSERT_EQ(SdBucket_Place(&b, &io, 3, &reopen), SD_BUCKET_OK);
+    ASSERT_TRUE(reopen);
+    ASSERT_EQ(c.stats, 1);
+
+    /* Every bucket full: exhausted. */
+    fake_card(&c, &io, &b);
+    for (uint32_t k = 0; k < 8; k++) {
+        c.exists[k] = true;
+        c.count[k] = 4;
+    }
+    ASSERT_TRUE(SdBucket_Enter(&b, &io, 0));
+    ASSERT_EQ(SdBucket_Place(&b, &io, 1, &reopen), SD_BUCKET_EXHAUSTED);
+    ASSERT_EQ(b.cur, 5);
+
+    /* The roll's mkdir fails: the active bucket stays. */
+    fake_card(&c, &io, &b);
+    c.count[0] = 4;
+    c.failEnter = 1;
+    ASSERT_TRUE(SdBucket_Enter(&b, &io, 0));
+    ASSERT_EQ(SdBucket_Place(&b, &io, 1, &reopen), SD_BUCKET_ENTER_FAILED);
+    ASSERT_EQ(b.cur, 0);
+    ASSERT_EQ(b.countAtStart, 4);
+}
+
+TEST(test_bucket_precreate_and_adopt)
+{
+    FakeCard_t c;
+    SdBucketIo_t io;
+    SdBucket_t b;
+
+    /* Room in the active bucket: a new part, counted once created. */
+    fake_card(&c, &io, &b);
+    c.count[0] = 1;
+    c.parts[0] = 1u;
+    ASSERT_TRUE(SdBucket_Enter(&b, &io, 0));
+    ASSERT_EQ(SdBucket_PlanPrecreate(&b, &io, 1), SD_BUCKET_PRE_NEW);
+    SdBucket_NoteCreated(&b, 1);
+    ASSERT_EQ(b.filesIn, 1);
+    ASSERT_TRUE(SdBucket_Adoptable(&b, 0, 1, 1));
+    ASSERT_FALSE(SdBucket_Adoptable(&b, 0, 1, 2));     /* another part */
+    ASSERT_FALSE(SdBucket_Adoptable(&b, 1, 1, 1));     /* another bucket */
+
+    /* Already there: reopened in place, even in a full bucket. */
+    ASSERT_EQ(SdBucket_PlanPrecreate(&b, &io, 1), SD_BUCKET_PRE_REOPEN);
+
+    /* Full: rolls ahead of the rotation into a bucket that did not exist. */
+    fake_card(&c, &io, &b);
+    c.count[0] = 4;
+    ASSERT_TRUE(SdBucket_Enter(&b, &io, 0));
+    ASSERT_EQ(SdBucket_PlanPrecreate(&b, &io, 1), SD_BUCKET_PRE_NEW);
+    ASSERT_EQ(b.cur, 1);
+    ASSERT_TRUE(c.exists[1]);
+    ASSERT_FALSE(SdBucket_Adoptable(&b, 0, 1, 1));
+
+    /* The roll fails: declined, the active bucket kept, and the next bucket
+     * now counts as existing (its mkdir may have landed), so the next try
+     * declines without touching the card. */
+    fake_card(&c, &io, &b);
+    c.count[0] = 4;
+    c.failEnter = 1;
+    ASSERT_TRUE(SdBucket_Enter(&b, &io, 0));
+    ASSERT_EQ(SdBucket_PlanPrecreate(&b, &io, 1), SD_BUCKET_PRE_ROLL_FAILED);
+    ASSERT_EQ(b.cur, 0);
+    ASSERT_TRUE(b.nextExists);
+    uint32_t enters = c.enters;
+    ASSERT_EQ(SdBucket_PlanPrecreate(&b, &io, 1), SD_BUCKET_PRE_DECLINE);
+    ASSERT_EQ(c.enters, enters);
+
+    /* A later bucket might hold it, or the cache cannot tell: declined. */
+    fake_card(&c, &io, &b);
+    c.exists[1] = true;
+    ASSERT_TRUE(SdBucket_Enter(&b, &io, 0));
+    ASSERT_EQ(SdBucket_PlanPrecreate(&b, &io, 1), SD_BUCKET_PRE_DECLINE);
+    fake_card(&c, &io, &b);
+    c.partial[0] = true;
+    ASSERT_TRUE(SdBucket_Enter(&b, &io, 0));
+    ASSERT_EQ(SdBucket_PlanPrecreate(&b, &io, 1), SD_BUCKET_PRE_DECLINE);
+
+    /* Last bucket full: left to Place, which refuses. */
+    fake_card(&c, &io, &b);
+    c.count[5] = 4;
+    ASSERT_TRUE(SdBucket_Enter(&b, &io, 5));
+    ASSERT_EQ(SdBucket_PlanPrecreate(&b, &io, 1), SD_BUCKET_PRE_DECLINE);
+    ASSERT_EQ(b.cur, 5);
+}
+
+/* Whatever the cache claims to know about a real directory, f_stat agrees. */
+static uint32_t cache_disagreements(uint32_t upTo, uint32_t* pKnown)
+{
+    SdBucket_t b;
+    char path[64];
+    uint32_t wrong = 0;
+    *pKnown = 0;
+    SdBucket_Init(&b, MAX_DIR_FILES, MAX_BUCKET);
+    if (!SdBucket_Enter(&b, &g_io, 0)) return 1;
+    for (uint32_t n = 0; n <= upTo; n++) {
+        bool present;
+        if (!SdPartCache_Lookup(&b.parts, n, &present)) continue;
+        (*pKnown)++;
+        part_path(path, sizeof(path), LOG_DIR, n);
+        wrong += (present != is_file(path));
+    }
+    return wrong;
+}
+
+TEST(test_cache_agrees_with_the_card)
+{
+    static const char* names[] = {
+        "RUN-30.BIN", "run-042.bin", "run-31.bin.bak", "other.bin", "run-43.csv",
+    };
+    char path[64];
+    FIL f;
+    uint32_t known;
+    format_and_mount();
+    ASSERT_EQ(f_mkdir(LOG_DIR), FR_OK);
+    for (uint32_t n = 0; n <= 29; n++) {
+        part_path(path, sizeof(path), LOG_DIR, n);
+        ASSERT_EQ(f_open(&f, path, FA_WRITE | FA_CREATE_ALWAYS), FR_OK);
+        f_close(&f);
+    }
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        snprintf(path, sizeof(path), "%s/%s", LOG_DIR, names[i]);
+        ASSERT_EQ(f_open(&f, path, FA_WRITE | FA_CREATE_ALWAYS), FR_OK);
+        f_close(&f);
+    }
+    ASSERT_EQ(f_mkdir(LOG_DIR "/run-32.bin"), FR_OK);     /* a directory is not a part */
+
+    ASSERT_EQ(cache_disagreements(60, &known), 0);
+    ASSERT_EQ(known, 61);                                  /* 0..30 exact, the rest absent */
+
+    ASSERT_EQ(f_unlink(LOG_DIR "/run-12.bin"), FR_OK);
+    ASSERT_EQ(cache_disagreements(60, &known), 0);
+    ASSERT_EQ(known, 61 - 30);                             /* 1..30 now unknown */
+}
+
+TEST(test_rotation_of_thousands_of_parts)
+{
+    static Session_t inl, pre;
+    const uint32_t last = 3999;
+
+    format_and_mount();
+    ASSERT_TRUE(run_session(&inl, MODE_INLINE, last, PART_BYTES / 2u, 1));
+    ASSERT_TRUE(parts_hold_the_stream(&inl, last));
+    ASSERT_TRUE(layout_is_sound(last));
+    uint32_t inlPeak = g_ringPeak, inlLost = g_lost;
+
+    format_and_mount();
+    DWORD before = free_clusters();
+    ASSERT_TRUE(run_session(&pre, MODE_PRECREATE, last, PART_BYTES / 2u, 1));
+    ASSERT_TRUE(parts_hold_the_stream(&pre, last));
+    ASSERT_TRUE(layout_is_sound(last));
+    ASSERT_EQ(g_lost, 0);
+    ASSERT_EQ(pre.precreated, last);                       /* every rotation, rolls included */
+    ASSERT_EQ(pre.inlined, 0);
+    ASSERT_EQ(pre.partStats, 0);                           /* the cache answered every search */
+    ASSERT_TRUE(pre.b.cur >= 60);
+    ASSERT_TRUE(free_clusters() < before);
+
+    /* What is left in the window is the old part's drain and close: a fixed
+     * cost, where the create it replaces scans a directory and, at each roll,
+     * makes and walks a new one. */
+    ASSERT_TRUE(pre.worstWindowOps < inl.worstWindowOps);
+    ASSERT_TRUE(g_ringPeak < inlPeak);
+    printf("    %u parts in %u buckets; worst rotation window %u card ops "
+           "(part %u), ring peak %u B, lost %u B\n",
+           (unsigned)(last + 1u), (unsigned)(pre.b.cur + 1u),
+           (unsigned)pre.worstWindowOps, (unsigned)pre.worstWindowPart,
+           (unsigned)g_ringPeak, (unsigned)g_lost);
+    printf("    created in the window: worst %u card ops (part %u), ring peak %u B, "
+           "lost %u B, %u part stats\n",
+           (unsigned)inl.worstWindowOps, (unsigned)inl.worstWindowPart,
+           (unsigned)inlPeak, (unsigned)inlLost, (unsigned)inl.partStats);
+}
+
+TEST(test_second_session_overwrites_in_place)
+{
+    static Session_t first, again;
+    const uint32_t last = 299;
+
+    format_and_mount();
+    ASSERT_TRUE(run_session(&first, MODE_PRECREATE, last, PART_BYTES / 2u, 1));
+    ASSERT_TRUE(layout_is_sound(last));
+
+    /* Same base name, shorter: the parts are rewritten where they are, and
+     * none is duplicated into a later bucket. Where the cache cannot tell,
+     * the rotation searches: all through the configured directory, whose walk
+     * also meets the bucket directories and so never ends under the cap, and
+     * once per bucket for the part that lives in the next one. */
+    ASSERT_TRUE(run_session(&again, MODE_PRECREATE, last, PART_BYTES / 4u, 7));
+    ASSERT_TRUE(parts_hold_the_stream(&again, last));
+    ASSERT_TRUE(layout_is_sound(last));
+    ASSERT_EQ(g_lost, 0);
+    ASSERT_EQ(memcmp(again.partBucket, first.partBucket, last + 1u), 0);
+    ASSERT_EQ(again.inlined, (MAX_DIR_FILES - 1u) + first.b.cur);
+    ASSERT_EQ(again.precreated + again.inlined, last);
+}
+
+TEST(test_stop_removes_the_unused_part)
+{
+    static Session_t s;
+    format_and_mount();
+    ASSERT_TRUE(run_session(&s, MODE_PRECREATE, 2, PART_BYTES * 3u / 4u, 3));
+    ASSERT_TRUE(parts_hold_the_stream(&s, 2));
+    ASSERT_TRUE(layout_is_sound(2));
+    ASSERT_FALSE(is_file(LOG_DIR "/run-3.bin"));
+
+    /* And its reserved extent went back with it. */
+    DWORD used = 0;
+    for (uint32_t c = 0; c <= 2; c++) {
+        char path[64];
+        FILINFO fi;
+        part_path(path, sizeof(path), LOG_DIR, c);
+        ASSERT_EQ(f_stat(path, &fi), FR_OK);
+        used += (DWORD)((fi.fsize + CLUSTER - 1u) / CLUSTER);
+    }
+    ASSERT_EQ(free_clusters() + used + 1u /* LOGS */, g_fs.n_fatent - 2u - 1u /* root */);
+}
+
+int main(void)
+{
+    g_disk = calloc(1, DISK_BYTES);
+    if (g_disk == NULL) {
+        printf("cannot allocate the RAM disk\n");
+        return 1;
+    }
+    printf("Split-log rotation (SdPartCache.c, SdBucket.c, pre-created parts) on a RAM disk\n");
+    printf("---------------------------------------------\n");
+    RUN(test_parse_names);
+    RUN(test_lookup_and_add);
+    RUN(test_bucket_place);
+    RUN(test_bucket_precreate_and_adopt);
+    RUN(test_cache_agrees_with_the_card);
+    RUN(test_rotation_of_thousands_of_parts);
+    RUN(test_second_session_overwrites_in_place);
+    RUN(test_stop_removes_the_unused_part);
+    free(g_disk);
+    return TEST_SUMMARY();
+}
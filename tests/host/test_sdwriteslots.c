@@ -0,0 +1,466 @@
+/* ==========================================================================
+ * test_sdwriteslots.c — firmware/src/Util/SdWriteSlots.c unit tests and a
+ * virtual-time model of the SD WRITE_TO_FILE pass.
+ *
+ * Unit cases: carving (power-of-two count, sector-multiple slots, shrinking
+ * for small buffers), in-order submit/service/reap, the full ring, short
+ * writes retried inside a slot, and a failed slot stopping every later one.
+ *
+ * The model runs the manager's pass against a fake block device on one
+ * virtual clock: a producer fills the circular buffer at a fixed rate; every
+ * SD task tick the manager reaps finished chunks (CRC), stages new ones from
+ * the circular buffer into the coherent buffer (copy) and, in the legacy
+ * configuration, writes each one itself before staging the next. In the
+ * slotted configurations the fake device takes submitted slots through the
+ * REAL SdWriteSlots_Service while the manager keeps staging. Everything the
+ * device wrote is compared byte for byte with what the producer generated.
+ *
+ * Run: make -C tests/host run
+ * ========================================================================== */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "SdWriteSlots.h"   /* real header (via -I firmware/src/Util) */
+#include "test_framework.h"
+
+#define SECTOR 512u
+
+/* --------------------------------------------------------------------------
+ * Fake block device: appends to a RAM disk, optionally short-writes.
+ * ------------------------------------------------------------------------ */
+typedef struct {
+    uint8_t* disk;
+    uint32_t cap;
+    uint32_t pos;
+    uint32_t maxPerCall;    /* 0 = whole request */
+    int      failAtCall;    /* call index that returns -1 (negative = never) */
+    int      zeroAtCall;    /* call index that returns 0 (negative = never) */
+    int      calls;
+} FakeDisk_t;
+
+static int fake_write(void* ctx, const uint8_t* data, uint32_t len)
+{
+    FakeDisk_t* d = (FakeDisk_t*)ctx;
+    int call = d->calls++;
+    if (call == d->failAtCall) return -1;
+    if (call == d->zeroAtCall) return 0;
+    if (d->maxPerCall != 0u && len > d->maxPerCall) len = d->maxPerCall;
+    if (len > d->cap - d->pos) len = d->cap - d->pos;
+    memcpy(d->disk + d->pos, data, len);
+    d->pos += len;
+    return (int)len;
+}
+
+static void fake_init(FakeDisk_t* d, uint8_t* disk, uint32_t cap)
+{
+    memset(d, 0, sizeof(*d));
+    d->disk = disk;
+    d->cap = cap;
+    d->failAtCall = -1;
+    d->zeroAtCall = -1;
+}
+
+static uint8_t g_buf[16384];
+static uint8_t g_small_disk[65536];
+
+/* --------------------------------------------------------------------------
+ * Unit cases
+ * ------------------------------------------------------------------------ */
+TEST(test_init_carves_aligned_slots)
+{
+    SdWriteSlots_t s;
+    ASSERT_TRUE(SdWriteSlots_Init(&s, g_buf, 16384, 2, SECTOR));
+    ASSERT_EQ(s.count, 2u);
+    ASSERT_EQ(s.slotSize, 8192u);
+    ASSERT_TRUE(s.slot[1].data == g_buf + 8192);
+
+    /* 3 rounds down to 2; an odd size loses its sub-sector remainder. */
+    ASSERT_TRUE(SdWriteSlots_Init(&s, g_buf, 5000, 3, SECTOR));
+    ASSERT_EQ(s.count, 2u);
+    ASSERT_EQ(s.slotSize, 2048u);
+
+    /* Too small for two aligned slots: one slot, not two unaligned ones. */
+    ASSERT_TRUE(SdWriteSlots_Init(&s, g_buf, 900, 2, SECTOR));
+    ASSERT_EQ(s.count, 1u);
+    ASSERT_EQ(s.slotSize, 512u);
+
+    ASSERT_TRUE(SdWriteSlots_Init(&s, g_buf, 16384, 99, SECTOR));
+    ASSERT_EQ(s.count, (uint32_t)SD_WRITE_SLOTS_MAX);
+
+    /* Not one sector: refused, and the instance stays inert. */
+    ASSERT_FALSE(SdWriteSlots_Init(&s, g_buf, 511, 2, SECTOR));
+    uint32_t cap = 1;
+    ASSERT_TRUE(SdWriteSlots_Acquire(&s, &cap) == NULL);
+    ASSERT_EQ(cap, 0u);
+    ASSERT_FALSE(SdWriteSlots_Init(&s, NULL, 4096, 2, SECTOR));
+    ASSERT_FALSE(SdWriteSlots_Init(&s, g_buf, 4096, 0, SECTOR));
+}
+
+TEST(test_in_order_ping_pong)
+{
+    SdWriteSlots_t s;
+    FakeDisk_t d;
+    fake_init(&d, g_small_disk, sizeof(g_small_disk));
+    ASSERT_TRUE(SdWriteSlots_Init(&s, g_buf, 4096, 2, SECTOR));
+
+    uint32_t cap;
+    uint8_t* a = SdWriteSlots_Acquire(&s, &cap);
+    ASSERT_TRUE(a == g_buf);
+    ASSERT_EQ(cap, 2048u);
+    memset(a, 'A', 2048);
+    SdWriteSlots_Submit(&s, 2048);
+
+    /* The second slot is stageable while the first is still in flight. */
+    uint8_t* b = SdWriteSlots_Acquire(&s, &cap);
+    ASSERT_TRUE(b == g_buf + 2048);
+    memset(b, 'B', 1024);
+    SdWriteSlots_Submit(&s, 1024);
+    ASSERT_EQ(SdWriteSlots_InFlight(&s), 2u);
+    ASSERT_TRUE(SdWriteSlots_Acquire(&s, &cap) == NULL);
+    ASSERT_TRUE(SdWriteSlots_Reap(&s) == NULL);
+
+    ASSERT_TRUE(SdWriteSlots_Service(&s, fake_write, &d));
+    ASSERT_EQ(SdWriteSlots_InFlight(&s), 1u);
+    const SdWriteSlot_t* r = SdWriteSlots_Reap(&s);
+    ASSERT_TRUE(r != NULL && r->data == a);
+    ASSERT_EQ(r->done, 2048u);
+    /* Completed but not released: still not free. */
+    ASSERT_TRUE(SdWriteSlots_Acquire(&s, &cap) == NULL);
+    SdWriteSlots_Release(&s);
+    ASSERT_TRUE(SdWriteSlots_Acquire(&s, &cap) == a);
+
+    ASSERT_TRUE(SdWriteSlots_Service(&s, fake_write, &d));
+    ASSERT_FALSE(SdWriteSlots_Service(&s, fake_write, &d));
+    r = SdWriteSlots_Reap(&s);
+    ASSERT_TRUE(r != NULL && r->data == b);
+    ASSERT_EQ(r->done, 1024u);
+    SdWriteSlots_Release(&s);
+    SdWriteSlots_Release(&s);   /* nothing left: no-op */
+    ASSERT_EQ(SdWriteSlots_Outstanding(&s), 0u);
+
+    ASSERT_EQ(d.pos, 3072u);
+    ASSERT_EQ(g_small_disk[0], 'A');
+    ASSERT_EQ(g_small_disk[2047], 'A');
+    ASSERT_EQ(g_small_disk[2048], 'B');
+    ASSERT_EQ(g_small_disk[3071], 'B');
+}
+
+TEST(test_short_writes_retried_in_slot)
+{
+    SdWriteSlots_t s;
+    FakeDisk_t d;
+    fake_init(&d, g_small_disk, sizeof(g_small_disk));
+    d.maxPerCall = 700;
+    ASSERT_TRUE(SdWriteSlots_Init(&s, g_buf, 4096, 1, SECTOR));
+    uint32_t cap;
+    uint8_t* p = SdWriteSlots_Acquire(&s, &cap);
+    for (uint32_t i = 0; i < cap; i++) p[i] = (uint8_t)(i * 7u);
+    SdWriteSlots_Submit(&s, cap);
+    ASSERT_TRUE(SdWriteSlots_Service(&s, fake_write, &d));
+    ASSERT_EQ(d.calls, 6);          /* ceil(4096 / 700) */
+    ASSERT_EQ(SdWriteSlots_Reap(&s)->done, 4096u);
+    ASSERT_FALSE(s.failed);
+    ASSERT_EQ(memcmp(g_small_disk, g_buf, 4096), 0);
+
+    /* Submit clamps to the slot. */
+    SdWriteSlots_Release(&s);
+    SdWriteSlots_Acquire(&s, &cap);
+    SdWriteSlots_Submit(&s, cap + 1000u);
+    ASSERT_EQ(s.slot[0].len, cap);
+}
+
+TEST(test_failure_stops_later_slots)
+{
+    SdWriteSlots_t s;
+    FakeDisk_t d;
+    uint32_t cap;
+    fake_init(&d, g_small_disk, sizeof(g_small_disk));
+    d.maxPerCall = 1000;
+    d.failAtCall = 1;               /* first slot: 1000 bytes, then an error */
+    ASSERT_TRUE(SdWriteSlots_Init(&s, g_buf, 16384, 4, SECTOR));
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TRUE(SdWriteSlots_Acquire(&s, &cap) != NULL);
+        SdWriteSlots_Submit(&s, cap);
+    }
+    while (SdWriteSlots_Service(&s, fake_write, &d)) {
+    }
+    ASSERT_TRUE(s.failed);
+    ASSERT_EQ(d.calls, 2);          /* the later slots never reached the device */
+    ASSERT_EQ(SdWriteSlots_Reap(&s)->done, 1000u);
+    SdWriteSlots_Release(&s);
+    ASSERT_EQ(SdWriteSlots_Reap(&s)->done, 0u);
+    SdWriteSlots_Release(&s);
+    ASSERT_EQ(SdWriteSlots_Reap(&s)->done, 0u);
+    SdWriteSlots_Release(&s);
+    ASSERT_EQ(d.pos, 1000u);
+
+    /* No progress counts as a failure too (a stalled card must not spin). */
+    fake_init(&d, g_small_disk, sizeof(g_small_disk));
+    d.zeroAtCall = 0;
+    ASSERT_TRUE(SdWriteSlots_Init(&s, g_buf, 4096, 2, SECTOR));
+    SdWriteSlots_Acquire(&s, &cap);
+    SdWriteSlots_Submit(&s, cap);
+    ASSERT_TRUE(SdWriteSlots_Service(&s, fake_write, &d));
+    ASSERT_TRUE(s.failed);
+    ASSERT_EQ(SdWriteSlots_Reap(&s)->done, 0u);
+}
+
+TEST(test_counters_wrap)
+{
+    SdWriteSlots_t s;
+    FakeDisk_t d;
+    uint32_t cap;
+    ASSERT_TRUE(SdWriteSlots_Init(&s, g_buf, 4096, 4, SECTOR));
+    s.submitted = s.completed = s.reaped = 0xFFFFFFFEu;
+    for (int round = 0; round < 8; round++) {
+        fake_init(&d, g_small_disk, sizeof(g_small_disk));
+        uint8_t* p = SdWriteSlots_Acquire(&s, &cap);
+        ASSERT_TRUE(p != NULL);
+        ASSERT_TRUE(p == s.slot[(0xFFFFFFFEu + (uint32_t)round) & 3u].data);
+        memset(p, round, cap);
+        SdWriteSlots_Submit(&s, cap);
+        ASSERT_TRUE(SdWriteSlots_Service(&s, fake_write, &d));
+        ASSERT_EQ(SdWriteSlots_Reap(&s)->done, cap);
+        SdWriteSlots_Release(&s);
+        ASSERT_EQ(g_small_disk[0], (uint8_t)round);
+    }
+    ASSERT_EQ(SdWriteSlots_Outstanding(&s), 0u);
+}
+
+/* --------------------------------------------------------------------------
+ * Virtual-time model of WRITE_TO_FILE
+ * ------------------------------------------------------------------------ */
+typedef struct {
+    const char* name;
+    uint32_t slots;         /* 0 = legacy: the manager writes each chunk itself */
+    uint32_t bufSize;       /* the coherent write buffer the slots are carved from */
+    double   rateBps;       /* producer */
+    uint32_t circCap;       /* circular buffer; the producer drops when full */
+    double   seconds;
+} ModelCfg_t;
+
+/* Costs, in microseconds. The card figures are a 20 MHz SPI link plus a fixed
+ * per-FileWrite cost (FatFs cluster walk, CMD25 and the card's stop-tran
+ * busy); the CPU figures are the copy into the uncached coherent buffer and
+ * the CRC read back out of it. Only their ratio matters to the comparison. */
+#define TICK_US         1000.0  /* SD_CARD_MANAGER_TASK_DELAY_MS */
+#define PASS_US         20.0    /* state machine, mutexes */
+#define STAGE_US_PER_B  0.020
+#define CRC_US_PER_B    0.035
+#define DEV_CALL_US     250.0
+#define DEV_US_PER_B    0.400
+#define MAX_CHUNKS      4       /* SD_CARD_MANAGER_MAX_CHUNKS_PER_CYCLE */
+
+typedef struct {
+    uint64_t produced;      /* accepted into the circular buffer */
+    uint64_t extracted;     /* staged out of it */
+    uint64_t written;       /* reaped as on the card */
+    uint64_t dropped;
+    double   producedUpTo;
+    double   devBusyUs;
+    uint32_t overlapStages; /* chunks staged while another was on the wire */
+    uint32_t maxBacklog;
+} ModelOut_t;
+
+#define DISK_CAP (8u << 20)
+static uint8_t g_disk[DISK_CAP];
+
+/* Producer's byte at stream position i (drops remove whole spans, so accepted
+ * bytes are numbered consecutively). */
+static inline uint8_t gen(uint64_t i)
+{
+    uint32_t x = (uint32_t)(i * 2654435761u) ^ (uint32_t)(i >> 13);
+    return (uint8_t)(x ^ (x >> 11));
+}
+
+static void produce_until(const ModelCfg_t* c, ModelOut_t* o, double t)
+{
+    if (t <= o->producedUpTo) return;
+    uint64_t want = (uint64_t)(c->rateBps * t / 1e6) -
+                    (uint64_t)(c->rateBps * o->producedUpTo / 1e6);
+    o->producedUpTo = t;
+    uint64_t level = o->produced - o->extracted;
+    uint64_t room = c->circCap - level;
+    uint64_t take = (want < room) ? want : room;
+    o->produced += take;
+    o->dropped += want - take;
+    if (o->produced - o->extracted > o->maxBacklog) {
+        o->maxBacklog = (uint32_t)(o->produced - o->extracted);
+    }
+}
+
+/* Sector-aligned extract, as the steady-state loop does. */
+static uint32_t stage(ModelOut_t* o, uint8_t* dst, uint32_t cap)
+{
+    uint64_t avail = o->produced - o->extracted;
+    uint32_t n = (avail < cap) ? (uint32_t)avail : cap;
+    n = (n / SECTOR) * SECTOR;
+    for (uint32_t i = 0; i < n; i++) dst[i] = gen(o->extracted + i);
+    o->extracted += n;
+    return n;
+}
+
+static double dev_cost(uint32_t n)
+{
+    return DEV_CALL_US + DEV_US_PER_B * (double)n;
+}
+
+typedef struct {
+    SdWriteSlots_t slots;
+    FakeDisk_t     disk;
+    double         submitAt[SD_WRITE_SLOTS_MAX];
+    double         devFreeAt;
+} Writer_t;
+
+/* The writer task: finish every submitted slot whose transfer ends by t. */
+static void writer_until(Writer_t* w, ModelOut_t* o, double t)
+{
+    while (SdWriteSlots_InFlight(&w->slots) > 0u) {
+        uint32_t seq = w->slots.completed & (w->slots.count - 1u);
+        double start = w->submitAt[seq] > w->devFreeAt ? w->submitAt[seq] : w->devFreeAt;
+        double end = start + dev_cost(w->slots.slot[seq].len);
+        if (end > t) break;
+        SdWriteSlots_Service(&w->slots, fake_write, &w->disk);
+        w->devFreeAt = end;
+        o->devBusyUs += end - start;
+    }
+}
+
+static void run_model(const ModelCfg_t* c, ModelOut_t* o)
+{
+    static uint8_t wbuf[65536];
+    static Writer_t w;
+    memset(o, 0, sizeof(*o));
+    memset(&w, 0, sizeof(w));
+    fake_init(&w.disk, g_disk, DISK_CAP);
+    if (c->slots != 0u) {
+        SdWriteSlots_Init(&w.slots, wbuf, c->bufSize, c->slots, SECTOR);
+    }
+    const double end = c->seconds * 1e6;
+    double t = 0.0;
+    while (t < end) {
+        double now = t + PASS_US;
+        if (c->slots == 0u) {
+            /* Legacy: extract, write, account -- one chunk at a time. */
+            for (int k = 0; k < MAX_CHUNKS; k++) {
+                produce_until(c, o, now);
+                uint32_t n = stage(o, wbuf, c->bufSize);
+                if (n == 0u) break;
+                now += STAGE_US_PER_B * n;
+                fake_write(&w.disk, wbuf, n);
+                o->devBusyUs += dev_cost(n);
+                now += dev_cost(n);
+                now += CRC_US_PER_B * n;
+                o->written += n;
+            }
+        } else {
+            writer_until(&w, o, now);
+            const SdWriteSlot_t* r;
+            while ((r = SdWriteSlots_Reap(&w.slots)) != NULL) {
+                now += CRC_US_PER_B * r->done;
+                o->written += r->done;
+                SdWriteSlots_Release(&w.slots);
+            }
+            for (int k = 0; k < MAX_CHUNKS; k++) {
+                writer_until(&w, o, now);
+                produce_until(c, o, now);
+                uint32_t cap;
+                uint8_t* dst = SdWriteSlots_Acquire(&w.slots, &cap);
+                if (dst == NULL) break;
+                uint32_t n = stage(o, dst, cap);
+                if (n == 0u) break;
+                now += STAGE_US_PER_B * n;
+                if (SdWriteSlots_InFlight(&w.slots) > 0u) o->overlapStages++;
+                w.submitAt[w.slots.submitted & (w.slots.count - 1u)] = now;
+                SdWriteSlots_Submit(&w.slots, n);
+            }
+        }
+        t = now + TICK_US;
+        produce_until(c, o, t);
+    }
+    /* Let the card finish what was submitted, so the byte check covers it. */
+    if (c->slots != 0u) {
+        writer_until(&w, o, 1e300);
+        const SdWriteSlot_t* r;
+        while ((r = SdWriteSlots_Reap(&w.slots)) != NULL) {
+            o->written += r->done;
+            SdWriteSlots_Release(&w.slots);
+        }
+        o->devBusyUs = (o->devBusyUs < end) ? o->devBusyUs : end;
+    }
+}
+
+static int disk_matches(const ModelOut_t* o)
+{
+    for (uint64_t i = 0; i < o->written; i++) {
+        if (g_disk[i] != gen(i)) return 0;
+    }
+    return 1;
+}
+
+static double model_mbps(const ModelCfg_t* c, ModelOut_t* o)
+{
+    run_model(c, o);
+    double mbps = (double)o->written / c->seconds / 1e6;
+    printf("    %-22s %5.2f MB/s card busy %5.1f%%  dropped %8llu  backlog max %6u  overlapped %u\n",
+           c->name, mbps, 100.0 * o->devBusyUs / (c->seconds * 1e6),
+           (unsigned long long)o->dropped, (unsigned)o->maxBacklog,
+           (unsigned)o->overlapStages);
+    return mbps;
+}
+
+TEST(test_model_overlap_beats_serial)
+{
+    /* Saturated: the producer outruns the card, so this is the writer's
+     * ceiling. Same 16 KB coherent buffer in every configuration. */
+    ModelCfg_t legacy = { "legacy (blocking)", 0, 16384, 4e6, 65536, 2.0 };
+    ModelCfg_t one    = { "1 slot (writer task)", 1, 16384, 4e6, 65536, 2.0 };
+    ModelCfg_t two    = { "2 slots (ping-pong)", 2, 16384, 4e6, 65536, 2.0 };
+    ModelOut_t ol, o1, o2;
+
+    double l = model_mbps(&legacy, &ol);
+    ASSERT_TRUE(disk_matches(&ol));
+    double a = model_mbps(&one, &o1);
+    ASSERT_TRUE(disk_matches(&o1));
+    double b = model_mbps(&two, &o2);
+    ASSERT_TRUE(disk_matches(&o2));
+
+    ASSERT_EQ(o1.overlapStages, 0u);    /* one slot cannot overlap anything */
+    ASSERT_TRUE(o2.overlapStages > 0u);
+    ASSERT_TRUE(b > l * 1.05);
+    ASSERT_TRUE(b > a * 1.05);
+    /* With two slots the card is idle only while the first chunk stages. */
+    ASSERT_TRUE(o2.devBusyUs > 0.97 * two.seconds * 1e6);
+}
+
+TEST(test_model_keeps_up_where_serial_drops)
+{
+    /* Between the two ceilings: the serial writer falls behind and the
+     * circular buffer overflows; the slotted one keeps up and drops nothing. */
+    ModelCfg_t legacy = { "legacy @2.2 MB/s", 0, 16384, 2.2e6, 65536, 2.0 };
+    ModelCfg_t two    = { "2 slots @2.2 MB/s", 2, 16384, 2.2e6, 65536, 2.0 };
+    ModelOut_t ol, o2;
+    model_mbps(&legacy, &ol);
+    model_mbps(&two, &o2);
+    ASSERT_TRUE(disk_matches(&ol));
+    ASSERT_TRUE(disk_matches(&o2));
+    ASSERT_TRUE(ol.dropped > 0u);
+    ASSERT_EQ(o2.dropped, 0u);
+    ASSERT_TRUE(o2.maxBacklog < ol.maxBacklog);
+    ASSERT_EQ(o2.written + (o2.produced - o2.extracted), o2.produced);
+}
+
+int main(void)
+{
+    printf("SdWriteSlots\n");
+    printf("---------------------------------------------\n");
+    RUN(test_init_carves_aligned_slots);
+    RUN(test_in_order_ping_pong);
+    RUN(test_short_writes_retried_in_slot);
+    RUN(test_failure_stops_later_slots);
+    RUN(test_counters_wrap);
+    RUN(test_model_overlap_beats_serial);
+    RUN(test_model_keeps_up_where_serial_drops);
+    return TEST_SUMMARY();
+}
@@ -0,0 +1,452 @@
+/* ==========================================================================
+ * test_sharedblockqueue.c — host unit tests for firmware/src/Util/SharedBlockQueue.c
+ *
+ * The USB+SD fan-out queue: one encoded copy of each batch, one cursor per
+ * transport. Covers argument checks, zero-copy sharing (both consumers read
+ * the producer's bytes in place), refcounted reclaim, the contiguous
+ * allocator's wrap, whole-block Peek, per-consumer eviction accounting, the
+ * partial-consume pin, the descriptor-ring limit, Discard, consumers that
+ * attach and detach mid-stream, kept consumers, and a randomized
+ * fast/slow run in which the fast consumer must lose nothing and the slow one
+ * must see only whole blocks, in order, with every missing byte accounted.
+ *
+ * Run: make -C tests/host run
+ * ========================================================================== */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SharedBlockQueue.h"   /* real header (via -I firmware/src/Util) */
+#include "test_framework.h"
+
+#define FAST 0
+#define SLOW 1
+
+#define SLOTS 64
+
+static uint8_t g_arena[4096];
+static SharedBlock_t g_blocks[SLOTS];
+
+/* Reserve minLen and publish exactly len bytes of `fill`; returns the span. */
+static uint8_t* put(SharedBlockQueue_t* q, uint32_t minLen, uint32_t len,
+                    uint8_t fill, SharedBlockDrops_t* drops)
+{
+    SharedBlockDrops_t local;
+    uint32_t span = 0;
+    uint8_t* p = SharedBlockQueue_Reserve(q, minLen, &span, drops ? drops : &local);
+    if (p == NULL) return NULL;
+    if (len > span) len = span;
+    memset(p, fill, len);
+    SharedBlockQueue_Commit(q, len);
+    return p;
+}
+
+TEST(test_init_rejects_bad_args)
+{
+    SharedBlockQueue_t q;
+    ASSERT_FALSE(SharedBlockQueue_Init(&q, NULL, SLOTS, g_arena, 64, 1, 0));
+    ASSERT_FALSE(SharedBlockQueue_Init(&q, g_blocks, 1, g_arena, 64, 1, 0));
+    ASSERT_FALSE(SharedBlockQueue_Init(&q, g_blocks, 48, g_arena, 64, 1, 0));
+    ASSERT_FALSE(SharedBlockQueue_Init(&q, g_blocks, SLOTS, NULL, 64, 1, 0));
+    ASSERT_FALSE(SharedBlockQueue_Init(&q, g_blocks, SLOTS, g_arena, 0, 1, 0));
+    ASSERT_FALSE(SharedBlockQueue_Init(&q, g_blocks, SLOTS, g_arena, 64, 0, 0));
+    ASSERT_FALSE(SharedBlockQueue_Init(&q, g_blocks, SLOTS, g_arena, 64, SBQ_MAX_CONSUMERS + 1, 0));
+    ASSERT_TRUE(SharedBlockQueue_Init(&q, g_blocks, SLOTS, g_arena, 64, 2, 0));
+    ASSERT_EQ(q.maxBlock, 64);
+    ASSERT_TRUE(SharedBlockQueue_Init(&q, g_blocks, SLOTS, g_arena, 64, 2, 200));
+    ASSERT_EQ(q.maxBlock, 64);
+
+    /* A block larger than maxBlock can never be had. */
+    SharedBlockDrops_t d;
+    uint32_t span;
+    ASSERT_TRUE(SharedBlockQueue_Init(&q, g_blocks, SLOTS, g_arena, 64, 2, 32));
+    ASSERT_TRUE(SharedBlockQueue_Reserve(&q, 33, &span, &d) == NULL);
+    ASSERT_TRUE(SharedBlockQueue_Reserve(&q, 8, &span, &d) == g_arena);
+    ASSERT_EQ(span, 32);
+}
+
+TEST(test_both_consumers_read_the_same_bytes)
+{
+    SharedBlockQueue_t q;
+    SharedBlockQueue_Init(&q, g_blocks, SLOTS, g_arena, 256, 2, 0);
+    uint8_t* blk = put(&q, 16, 40, 0xA5, NULL);
+    ASSERT_TRUE(blk != NULL);
+
+    uint32_t len;
+    const uint8_t* a = SharedBlockQueue_Peek(&q, FAST, 256, &len);
+    ASSERT_TRUE(a == blk);               /* in place: no copy per consumer */
+    ASSERT_EQ(len, 40);
+    const uint8_t* b = SharedBlockQueue_Peek(&q, SLOW, 256, &len);
+    ASSERT_TRUE(b == blk);
+    ASSERT_EQ(len, 40);
+
+    ASSERT_EQ(SharedBlockQueue_Pending(&q, FAST), 40);
+    ASSERT_EQ(SharedBlockQueue_Pending(&q, SLOW), 40);
+    ASSERT_TRUE(SharedBlockQueue_Peek(&q, 2, 256, &len) == NULL);   /* no such consumer */
+}
+
+TEST(test_reclaim_waits_for_every_consumer)
+{
+    SharedBlockQueue_t q;
+    SharedBlockQueue_Init(&q, g_blocks, SLOTS, g_arena, 256, 2, 0);
+    put(&q, 16, 100, 1, NULL);
+    put(&q, 16, 100, 2, NULL);
+    ASSERT_EQ(q.tail - q.head, 2);
+
+    ASSERT_EQ(SharedBlockQueue_Consume(&q, FAST, 200), 200);
+    ASSERT_EQ(q.tail - q.head, 2);       /* SLOW still holds both */
+    ASSERT_EQ(q.blocks[0].refs, 1);
+
+    ASSERT_EQ(SharedBlockQueue_Consume(&q, SLOW, 100), 100);
+    ASSERT_EQ(q.tail - q.head, 1);
+    ASSERT_EQ(SharedBlockQueue_Consume(&q, SLOW, 100), 100);
+    ASSERT_EQ(q.tail - q.head, 0);
+
+    /* Consuming past the end stops at what was published. */
+    ASSERT_EQ(SharedBlockQueue_Consume(&q, FAST, 10), 0);
+
+    /* Empty again: the next block starts back at offset 0. */
+    ASSERT_TRUE(put(&q, 16, 8, 3, NULL) == g_arena);
+}
+
+TEST(test_allocator_wraps_without_splitting)
+{
+    SharedBlockQueue_t q;
+    SharedBlockDrops_t d;
+    SharedBlockQueue_Init(&q, g_blocks, SLOTS, g_arena, 256, 2, 0);
+    put(&q, 100, 100, 1, NULL);          /* [0,100) */
+    put(&q, 100, 100, 2, NULL);          /* [100,200) */
+    SharedBlockQueue_Consume(&q, FAST, 100);
+    SharedBlockQueue_Consume(&q, SLOW, 100);
+
+    /* 56 bytes left at the end, 100 free at the front: wrap to 0. */
+    uint8_t* p = put(&q, 80, 80, 3, &d);
+    ASSERT_TRUE(p == g_arena);
+    ASSERT_EQ(d.blocks[FAST] + d.blocks[SLOW], 0);
+
+    /* The wrapped block is not merged with the one at 100. */
+    uint32_t len;
+    const uint8_t* r = SharedBlockQueue_Peek(&q, FAST, 1000, &len);
+    ASSERT_TRUE(r == g_arena + 100);
+    ASSERT_EQ(len, 100);
+    SharedBlockQueue_Consume(&q, FAST, len);
+    r = SharedBlockQueue_Peek(&q, FAST, 1000, &len);
+    ASSERT_TRUE(r == g_arena);
+    ASSERT_EQ(len, 80);
+
+    /* Room is now only [80,100): a 20-byte block fits, a 21-byte one would
+     * have to evict the block at 100 (still held by SLOW). */
+    uint32_t span;
+    ASSERT_TRUE(SharedBlockQueue_Reserve(&q, 20, &span, &d) == g_arena + 80);
+    ASSERT_EQ(span, 20);
+    SharedBlockQueue_Commit(&q, 0);      /* released, nothing published */
+    ASSERT_EQ(SharedBlockQueue_Pending(&q, FAST), 80);
+}
+
+TEST(test_peek_returns_whole_blocks_only)
+{
+    SharedBlockQueue_t q;
+    SharedBlockQueue_Init(&q, g_blocks, SLOTS, g_arena, 1024, 1, 0);
+    put(&q, 1, 30, 1, NULL);
+    put(&q, 1, 30, 2, NULL);
+    put(&q, 1, 30, 3, NULL);
+
+    uint32_t len;
+    ASSERT_TRUE(SharedBlockQueue_Peek(&q, 0, 29, &len) == NULL);
+    ASSERT_EQ(len, 0);
+    ASSERT_TRUE(SharedBlockQueue_Peek(&q, 0, 59, &len) == g_arena);
+    ASSERT_EQ(len, 30);
+    ASSERT_TRUE(SharedBlockQueue_Peek(&q, 0, 60, &len) == g_arena);
+    ASSERT_EQ(len, 60);
+    ASSERT_TRUE(SharedBlockQueue_Peek(&q, 0, 1000, &len) == g_arena);
+    ASSERT_EQ(len, 90);
+
+    /* After a short write the rest of that block comes back on its own. */
+    SharedBlockQueue_Consume(&q, 0, 10);
+    ASSERT_TRUE(SharedBlockQueue_Peek(&q, 0, 1000, &len) == g_arena + 10);
+    ASSERT_EQ(len, 20);
+    ASSERT_EQ(SharedBlockQueue_Pending(&q, 0), 80);
+}
+
+TEST(test_eviction_charges_only_the_lagging_consumer)
+{
+    SharedBlockQueue_t q;
+    SharedBlockDrops_t d;
+    SharedBlockQueue_Init(&q, g_blocks, SLOTS, g_arena, 300, 2, 0);
+    put(&q, 100, 100, 1, NULL);
+    put(&q, 100, 100, 2, NULL);
+    put(&q, 100, 100, 3, NULL);
+    SharedBlockQueue_Consume(&q, FAST, 300);  /* FAST is caught up */
+
+    /* Arena full: the oldest block goes, and only SLOW loses it. */
+    ASSERT_TRUE(put(&q, 100, 100, 4, &d) == g_arena);
+    ASSERT_EQ(d.bytes[FAST], 0);
+    ASSERT_EQ(d.blocks[FAST], 0);
+    ASSERT_EQ(d.bytes[SLOW], 100);
+    ASSERT_EQ(d.blocks[SLOW], 1);
+
+    uint32_t len;
+    const uint8_t* r = SharedBlockQueue_Peek(&q, SLOW, 100, &len);
+    ASSERT_TRUE(r == g_arena + 100);
+    ASSERT_EQ(r[0], 2);
+    r = SharedBlockQueue_Peek(&q, FAST, 100, &len);
+    ASSERT_TRUE(r == g_arena);
+    ASSERT_EQ(r[0], 4);
+
+    /* Two evictions to make room, both of blocks FAST has already read; the
+     * block FAST has not read yet is the one that survives. */
+    ASSERT_TRUE(put(&q, 200, 200, 5, &d) == g_arena + 100);
+    ASSERT_EQ(d.bytes[SLOW], 200);
+    ASSERT_EQ(d.blocks[SLOW], 2);
+    ASSERT_EQ(d.bytes[FAST], 0);
+    ASSERT_EQ(SharedBlockQueue_Pending(&q, FAST), 300);
+    ASSERT_EQ(SharedBlockQueue_Pending(&q, SLOW), 300);
+}
+
+TEST(test_partly_sent_block_is_pinned)
+{
+    SharedBlockQueue_t q;
+    SharedBlockDrops_t d;
+    uint32_t span;
+    SharedBlockQueue_Init(&q, g_blocks, SLOTS, g_arena, 200, 2, 0);
+    put(&q, 100, 100, 1, NULL);
+    put(&q, 100, 100, 2, NULL);
+    SharedBlockQueue_Consume(&q, FAST, 200);
+    SharedBlockQueue_Consume(&q, SLOW, 40);   /* front of block 1 already sent */
+
+    ASSERT_TRUE(SharedBlockQueue_Reserve(&q, 100, &span, &d) == NULL);
+    ASSERT_EQ(d.bytes[SLOW], 0);
+    ASSERT_EQ(SharedBlockQueue_Pending(&q, SLOW), 160);
+
+    /* Finishing it unpins it; the block behind it can then be evicted. */
+    SharedBlockQueue_Consume(&q, SLOW, 60);
+    ASSERT_TRUE(SharedBlockQueue_Reserve(&q, 100, &span, &d) == g_arena);
+    ASSERT_EQ(d.bytes[SLOW], 0);
+    SharedBlockQueue_Commit(&q, 100);
+    /* 101 bytes only fit once both blocks are gone: SLOW loses both, FAST
+     * only the one it had not read yet. */
+    ASSERT_TRUE(SharedBlockQueue_Reserve(&q, 101, &span, &d) == g_arena);
+    ASSERT_EQ(d.bytes[SLOW], 200);
+    ASSERT_EQ(d.blocks[SLOW], 2);
+    ASSERT_EQ(d.bytes[FAST], 100);
+}
+
+TEST(test_descriptor_ring_limit_evicts)
+{
+    SharedBlockQueue_t q;
+    SharedBlockDrops_t d;
+    SharedBlockQueue_Init(&q, g_blocks, SLOTS, g_arena, sizeof(g_arena), 2, 0);
+    for (int i = 0; i < SLOTS; i++) {
+        ASSERT_TRUE(put(&q, 1, 4, (uint8_t)i, &d) != NULL);
+        ASSERT_EQ(d.blocks[SLOW], 0);
+    }
+    SharedBlockQueue_Consume(&q, FAST, 4 * SLOTS);
+
+    /* Plenty of bytes, no free descriptor: the oldest block makes way. */
+    ASSERT_TRUE(put(&q, 1, 4, 0xEE, &d) != NULL);
+    ASSERT_EQ(d.blocks[SLOW], 1);
+    ASSERT_EQ(d.bytes[SLOW], 4);
+    ASSERT_EQ(d.blocks[FAST], 0);
+    ASSERT_EQ(q.tail - q.head, SLOTS);
+}
+
+TEST(test_discard_drops_one_backlog)
+{
+    SharedBlockQueue_t q;
+    SharedBlockQueue_Init(&q, g_blocks, SLOTS, g_arena, 512, 2, 0);
+    put(&q, 1, 50, 1, NULL);
+    put(&q, 1, 70, 2, NULL);
+    SharedBlockQueue_Consume(&q, SLOW, 20);
+
+    ASSERT_EQ(SharedBlockQueue_Discard(&q, SLOW), 100);
+    ASSERT_EQ(SharedBlockQueue_Pending(&q, SLOW), 0);
+    ASSERT_EQ(SharedBlockQueue_Pending(&q, FAST), 120);
+    ASSERT_EQ(q.tail - q.head, 2);           /* FAST still owns them */
+    ASSERT_EQ(SharedBlockQueue_Discard(&q, FAST), 120);
+    ASSERT_EQ(q.tail - q.head, 0);
+}
+
+/* Each block carries its sequence number, length and a seq-derived fill, so a
+ * consumer can check it received whole blocks, uncorrupted, in order. */
+static void stamp(uint8_t* p, uint32_t seq, uint32_t len)
+{
+    memcpy(p, &seq, 4);
+    memcpy(p + 4, &len, 4);
+    for (uint32_t i = 8; i < len; i++) p[i] = (uint8_t)(seq * 31u + i);
+}
+
+typedef struct {
+    uint32_t lastSeq;
+    int      started;
+    uint64_t bytes;
+    uint64_t dropped;
+    int      bad;
+} Reader;
+
+/* Consume up to maxLen through Peek, checking each block in the run. */
+static void read_some(SharedBlockQueue_t* q, uint8_t c, uint32_t maxLen, Reader* r)
+{
+    uint32_t len;
+    const uint8_t* p = SharedBlockQueue_Peek(q, c, maxLen, &len);
+    if (p == NULL) return;
+    uint32_t off = 0;
+    while (off < len) {
+        uint32_t seq, blen;
+        memcpy(&seq, p + off, 4);
+        memcpy(&blen, p + off + 4, 4);
+        if (blen < 8 || off + blen > len || (r->started && seq <= r->lastSeq)) {
+            r->bad++;
+            break;
+        }
+        for (uint32_t i = 8; i < blen; i++) {
+            if (p[off + i] != (uint8_t)(seq * 31u + i)) { r->bad++; break; }
+        }
+        r->lastSeq = seq;
+        r->started = 1;
+        off += blen;
+    }
+    r->bytes += len;
+    SharedBlockQueue_Consume(q, c, len);
+}
+
+TEST(test_fast_and_slow_consumers)
+{
+    SharedBlockQueue_t q;
+    SharedBlockDrops_t d;
+    Reader fast = {0}, slow = {0};
+    uint64_t produced = 0;
+    uint32_t seq = 0;
+    srand(12345);
+    SharedBlockQueue_Init(&q, g_blocks, SLOTS, g_arena, sizeof(g_arena), 2, 512);
+
+    for (int step = 0; step < 200000; step++) {
+        uint32_t want = 8u + (uint32_t)(rand() % 300);
+        uint32_t span;
+        uint8_t* p = SharedBlockQueue_Reserve(&q, want, &span, &d);
+        ASSERT_TRUE(p != NULL);
+        if (p == NULL) break;
+        ASSERT_TRUE(span >= want && span <= 512);
+        ASSERT_EQ(d.bytes[FAST], 0);
+        slow.dropped += d.bytes[SLOW];
+
+        if (rand() % 50 == 0) {
+            SharedBlockQueue_Commit(&q, 0);   /* encoder produced nothing */
+        } else {
+            stamp(p, seq++, want);
+            SharedBlockQueue_Commit(&q, want);
+            produced += want;
+        }
+
+        /* FAST drains a USB-sized chunk every step; SLOW stalls for long
+         * stretches and then drains at a fraction of the production rate. */
+        read_some(&q, FAST, 512, &fast);
+        read_some(&q, FAST, 512, &fast);
+        if ((step / 1000) % 3 != 0 && rand() % 4 == 0) {
+            read_some(&q, SLOW, 600, &slow);
+        }
+    }
+    while (SharedBlockQueue_Pending(&q, FAST) > 0) read_some(&q, FAST, 512, &fast);
+    while (SharedBlockQueue_Pending(&q, SLOW) > 0) read_some(&q, SLOW, 512, &slow);
+
+    ASSERT_EQ(fast.bad, 0);
+    ASSERT_EQ(slow.bad, 0);
+    ASSERT_EQ(fast.bytes, produced);          /* the fast one lost nothing */
+    ASSERT_EQ(fast.lastSeq, seq - 1u);
+    ASSERT_TRUE(slow.dropped > 0);            /* ... while the slow one did */
+    ASSERT_EQ(slow.bytes + slow.dropped, produced);
+    ASSERT_EQ(q.tail - q.head, 0);            /* every block reclaimed */
+    printf("    %u blocks, %llu B; slow consumer lost %llu B to eviction\n",
+           (unsigned)seq, (unsigned long long)produced,
+           (unsigned long long)slow.dropped);
+}
+
+TEST(test_attach_and_detach)
+{
+    SharedBlockQueue_t q;
+    SharedBlockQueue_Init(&q, g_blocks, SLOTS, g_arena, 256, 2, 0);
+    ASSERT_TRUE(SharedBlockQueue_IsAttached(&q, FAST));
+    ASSERT_TRUE(SharedBlockQueue_IsAttached(&q, SLOW));
+
+    /* A detached consumer's backlog is released with it... */
+    put(&q, 16, 50, 1, NULL);
+    ASSERT_EQ(SharedBlockQueue_Detach(&q, SLOW), 50);
+    ASSERT_FALSE(SharedBlockQueue_IsAttached(&q, SLOW));
+    ASSERT_EQ(SharedBlockQueue_Detach(&q, SLOW), 0);
+    ASSERT_EQ(q.blocks[0].refs, 1);
+    /* ...and later blocks carry no reference for it. */
+    put(&q, 16, 50, 2, NULL);
+    ASSERT_EQ(q.blocks[1].refs, 1);
+    uint32_t len;
+    ASSERT_TRUE(SharedBlockQueue_Peek(&q, SLOW, 256, &len) == NULL);
+    ASSERT_EQ(SharedBlockQueue_Pending(&q, SLOW), 0);
+    ASSERT_EQ(SharedBlockQueue_Consume(&q, SLOW, 10), 0);
+    ASSERT_EQ(SharedBlockQueue_Consume(&q, FAST, 100), 100);
+    ASSERT_EQ(q.tail - q.head, 0);
+
+    /* Attaching starts at the next block: nothing already queued is its. */
+    put(&q, 16, 30, 3, NULL);
+    SharedBlockQueue_Attach(&q, SLOW);
+    ASSERT_EQ(SharedBlockQueue_Pending(&q, SLOW), 0);
+    put(&q, 16, 30, 4, NULL);
+    ASSERT_EQ(SharedBlockQueue_Pending(&q, SLOW), 30);
+    ASSERT_EQ(SharedBlockQueue_Pending(&q, FAST), 60);
+    const uint8_t* r = SharedBlockQueue_Peek(&q, SLOW, 256, &len);
+    ASSERT_EQ(r[0], 4);
+    /* Attaching again is a no-op: the backlog stays. */
+    SharedBlockQueue_Attach(&q, SLOW);
+    ASSERT_EQ(SharedBlockQueue_Pending(&q, SLOW), 30);
+
+    /* Nobody attached: a published block is reclaimed at once. */
+    SharedBlockQueue_Detach(&q, FAST);
+    SharedBlockQueue_Detach(&q, SLOW);
+    ASSERT_EQ(q.tail - q.head, 0);
+    put(&q, 16, 30, 5, NULL);
+    ASSERT_EQ(q.tail - q.head, 0);
+}
+
+TEST(test_kept_consumer_is_never_evicted)
+{
+    SharedBlockQueue_t q;
+    SharedBlockDrops_t d;
+    uint32_t span;
+    SharedBlockQueue_Init(&q, g_blocks, SLOTS, g_arena, 300, 2, 0);
+    SharedBlockQueue_SetKeep(&q, 1u << FAST);
+    put(&q, 100, 100, 1, NULL);
+    put(&q, 100, 100, 2, NULL);
+    put(&q, 100, 100, 3, NULL);
+
+    /* Both hold the oldest block and FAST is kept: refuse, evict nothing. */
+    ASSERT_TRUE(SharedBlockQueue_Reserve(&q, 100, &span, &d) == NULL);
+    ASSERT_EQ(d.blocks[FAST] + d.blocks[SLOW], 0);
+    ASSERT_EQ(SharedBlockQueue_Pending(&q, SLOW), 300);
+
+    /* Once FAST has read it, the block goes -- charged to SLOW alone. */
+    SharedBlockQueue_Consume(&q, FAST, 100);
+    ASSERT_TRUE(put(&q, 100, 100, 4, &d) == g_arena);
+    ASSERT_EQ(d.blocks[SLOW], 1);
+    ASSERT_EQ(d.bytes[FAST], 0);
+
+    /* A kept consumer that detaches no longer holds anything back. */
+    SharedBlockQueue_Detach(&q, FAST);
+    ASSERT_TRUE(put(&q, 100, 100, 5, &d) != NULL);
+    ASSERT_EQ(d.blocks[SLOW], 1);
+}
+
+int main(void)
+{
+    printf("Shared block queue (USB+SD fan-out)\n");
+    printf("---------------------------------------------\n");
+    RUN(test_init_rejects_bad_args);
+    RUN(test_both_consumers_read_the_same_bytes);
+    RUN(test_reclaim_waits_for_every_consumer);
+    RUN(test_allocator_wraps_without_splitting);
+    RUN(test_peek_returns_whole_blocks_only);
+    RUN(test_eviction_charges_only_the_lagging_consumer);
+    RUN(test_partly_sent_block_is_pinned);
+    RUN(test_descriptor_ring_limit_evicts);
+    RUN(test_discard_drops_one_backlog);
+    RUN(test_attach_and_detach);
+    RUN(test_kept_consumer_is_never_evicted);
+    RUN(test_fast_and_slow_consumers);
+    return TEST_SUMMARY();
+}
@@ -0,0 +1,461 @@
+/* ==========================================================================
+ * test_tcp_fanout.c — host unit tests for firmware/src/Util/TcpFanout.c
+ *
+ * Several WiFi TCP clients reading one encoded stream through their own
+ * cursors over a SharedBlockQueue. The sockets are simulated: each client's
+ * send callback takes at most a few sends per tick (its in-flight cap, as
+ * the WINC's SOCKET_MSG_SEND would release them) and writes what it takes to
+ * that client's receive buffer, where every block must arrive whole, in
+ * order, exactly once. Covers attach/detach mid-stream, the primary's
+ * backpressure (never evicted, the producer waits), per-tap eviction and its
+ * counters, stall detection, the early-kick threshold, send errors, and a
+ * randomized run with a fast primary, a steady tap and a stalling tap.
+ *
+ * Run: make -C tests/host run
+ * ========================================================================== */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "TcpFanout.h"          /* real header (via -I firmware/src/Util) */
+#include "test_framework.h"
+
+#define CONSOLE 0
+#define TAP1    1
+#define TAP2    2
+#define CLIENTS 3
+
+#define SLOTS    64
+#define MAX_SEND 256            /* one simulated send() */
+
+static uint8_t g_arena[4096];
+static SharedBlock_t g_blocks[SLOTS];
+
+/* --- Simulated sockets ---------------------------------------------------- */
+
+typedef struct {
+    int      credit;            /* sends it still takes this tick */
+    int      fail;              /* next send returns an error */
+    uint32_t calls;
+    uint8_t  rx[1u << 22];
+    uint32_t rxLen;
+} SimSocket;
+
+static SimSocket g_sock[CLIENTS];
+
+static int sim_send(void* ctx, uint8_t client, const uint8_t* data, uint32_t len)
+{
+    SimSocket* s = &((SimSocket*)ctx)[client];
+    s->calls++;
+    if (s->fail) {
+        s->fail = 0;
+        return -1;
+    }
+    if (s->credit <= 0) {
+        return 0;               /* WINC buffer full / in-flight cap */
+    }
+    s->credit--;
+    if (s->rxLen + len <= sizeof(s->rx)) {
+        memcpy(s->rx + s->rxLen, data, len);
+    }
+    s->rxLen += len;
+    return (int)len;
+}
+
+static void sim_reset(void)
+{
+    memset(g_sock, 0, sizeof(g_sock));
+}
+
+/* --- Producer --------------------------------------------------------------
+ * Block: [seq u32 LE][len u16 LE][fill bytes = seq & 0xFF], len >= 6. */
+
+static uint32_t g_seq;
+
+static bool publish(TcpFanout_t* f, uint32_t len, uint32_t* pPrimaryLost)
+{
+    SharedBlockDrops_t d;
+    uint32_t span = 0;
+    uint8_t* p = SharedBlockQueue_Reserve(f->q, len, &span, &d);
+    uint32_t lost = TcpFanout_ChargeDrops(f, &d);
+    if (pPrimaryLost) *pPrimaryLost += lost;
+    if (p == NULL) return false;
+    p[0] = (uint8_t)g_seq;
+    p[1] = (uint8_t)(g_seq >> 8);
+    p[2] = (uint8_t)(g_seq >> 16);
+    p[3] = (uint8_t)(g_seq >> 24);
+    p[4] = (uint8_t)len;
+    p[5] = (uint8_t)(len >> 8);
+    memset(p + 6, (uint8_t)g_seq, len - 6u);
+    SharedBlockQueue_Commit(f->q, len);
+    g_seq++;
+    return true;
+}
+
+/* Parse a client's receive buffer: whole blocks, strictly increasing seq.
+ * Returns the block count, or -1 on a torn / corrupt / out-of-order block. */
+static int parse_rx(const SimSocket* s, uint32_t* pFirst, uint32_t* pLast)
+{
+    uint32_t at = 0;
+    int n = 0;
+    uint32_t prev = 0;
+    while (at < s->rxLen) {
+        if (s->rxLen - at < 6u) return -1;
+        const uint8_t* b = s->rx + at;
+        uint32_t seq = (uint32_t)b[0] | ((uint32_t)b[1] << 8) |
+                       ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+        uint32_t len = (uint32_t)b[4] | ((uint32_t)b[5] << 8);
+        if (len < 6u || s->rxLen - at < len) return -1;
+        for (uint32_t i = 6; i < len; i++) {
+            if (b[i] != (uint8_t)seq) return -1;
+        }
+        if (n > 0 && seq <= prev) return -1;
+        if (n == 0 && pFirst) *pFirst = seq;
+        prev = seq;
+        at += len;
+        n++;
+    }
+    if (pLast) *pLast = prev;
+    return n;
+}
+
+static void setup(SharedBlockQueue_t* q, TcpFanout_t* f, uint32_t arena)
+{
+    sim_reset();
+    g_seq = 0;
+    SharedBlockQueue_Init(q, g_blocks, SLOTS, g_arena, arena, CLIENTS, MAX_SEND);
+    TcpFanout_Init(f, q, CLIENTS, MAX_SEND);
+}
+
+/* --- Tests ---------------------------------------------------------------- */
+
+TEST(test_init_rejects_bad_args)
+{
+    SharedBlockQueue_t q;
+    TcpFanout_t f;
+    SharedBlockQueue_Init(&q, g_blocks, SLOTS, g_arena, 1024, CLIENTS, MAX_SEND);
+    ASSERT_FALSE(TcpFanout_Init(&f, NULL, CLIENTS, MAX_SEND));
+    ASSERT_FALSE(TcpFanout_Init(&f, &q, 0, MAX_SEND));
+    ASSERT_FALSE(TcpFanout_Init(&f, &q, 2, MAX_SEND));     /* != queue's consumers */
+    ASSERT_FALSE(TcpFanout_Init(&f, &q, CLIENTS, 0));
+    ASSERT_TRUE(TcpFanout_Init(&f, &q, CLIENTS, MAX_SEND));
+
+    /* Everyone starts detached; with nobody reading, blocks do not pile up. */
+    for (uint8_t c = 0; c < CLIENTS; c++) {
+        ASSERT_FALSE(TcpFanout_IsAttached(&f, c));
+    }
+    g_seq = 0;
+    ASSERT_TRUE(publish(&f, 100, NULL));
+    ASSERT_EQ(q.tail - q.head, 0);
+
+    /* Calls on a client that does not exist do nothing. */
+    sim_reset();
+    TcpFanout_Attach(&f, CLIENTS, 0);
+    ASSERT_EQ(TcpFanout_Drain(&f, CLIENTS, 1, 0, sim_send, g_sock), 0);
+    ASSERT_EQ(TcpFanout_Detach(&f, CLIENTS), 0);
+}
+
+TEST(test_every_client_gets_the_whole_stream)
+{
+    SharedBlockQueue_t q;
+    TcpFanout_t f;
+    setup(&q, &f, 4096);
+    for (uint8_t c = 0; c < CLIENTS; c++) TcpFanout_Attach(&f, c, 0);
+
+    for (int i = 0; i < 200; i++) {
+        ASSERT_TRUE(publish(&f, 40 + (uint32_t)(i % 7) * 10, NULL));
+        for (uint8_t c = 0; c < CLIENTS; c++) {
+            g_sock[c].credit = 2;
+            TcpFanout_Drain(&f, c, 1, (uint32_t)i, sim_send, g_sock);
+        }
+    }
+    uint32_t first, last;
+    for (uint8_t c = 0; c < CLIENTS; c++) {
+        ASSERT_EQ(parse_rx(&g_sock[c], &first, &last), 200);
+        ASSERT_EQ(first, 0);
+        ASSERT_EQ(last, 199);
+        ASSERT_EQ(f.client[c].droppedBytes, 0);
+        ASSERT_EQ(f.client[c].bytesSent, g_sock[c].rxLen);
+    }
+    /* Identical bytes: encoded once, read three times. */
+    ASSERT_EQ(g_sock[TAP1].rxLen, g_sock[CONSOLE].rxLen);
+    ASSERT_BYTES(g_sock[TAP1].rx, g_sock[CONSOLE].rx, g_sock[CONSOLE].rxLen);
+    ASSERT_BYTES(g_sock[TAP2].rx, g_sock[CONSOLE].rx, g_sock[CONSOLE].rxLen);
+    ASSERT_EQ(q.tail - q.head, 0);
+}
+
+TEST(test_sends_are_whole_blocks_up_to_max_send)
+{
+    SharedBlockQueue_t q;
+    TcpFanout_t f;
+    setup(&q, &f, 4096);
+    TcpFanout_Attach(&f, TAP1, 0);
+    for (int i = 0; i < 10; i++) publish(&f, 100, NULL);
+
+    /* 256-byte sends: two 100-byte blocks per send, never a split block. */
+    g_sock[TAP1].credit = 1;
+    ASSERT_EQ(TcpFanout_Drain(&f, TAP1, 1, 0, sim_send, g_sock), 200);
+    ASSERT_EQ(g_sock[TAP1].rxLen, 200);
+    ASSERT_EQ(TcpFanout_Pending(&f, TAP1), 800);
+    g_sock[TAP1].credit = 100;
+    ASSERT_EQ(TcpFanout_Drain(&f, TAP1, 1, 0, sim_send, g_sock), 800);
+    ASSERT_EQ(f.client[TAP1].sends, 5);
+    ASSERT_EQ(parse_rx(&g_sock[TAP1], NULL, NULL), 10);
+}
+
+TEST(test_late_client_starts_at_the_next_block)
+{
+    SharedBlockQueue_t q;
+    TcpFanout_t f;
+    setup(&q, &f, 4096);
+    TcpFanout_Attach(&f, CONSOLE, 0);
+    for (int i = 0; i < 5; i++) publish(&f, 50, NULL);
+
+    TcpFanout_Attach(&f, TAP2, 0);
+    ASSERT_EQ(TcpFanout_Pending(&f, TAP2), 0);
+    publish(&f, 50, NULL);
+    g_sock[TAP2].credit = 10;
+    g_sock[CONSOLE].credit = 10;
+    TcpFanout_Drain(&f, TAP2, 1, 0, sim_send, g_sock);
+    TcpFanout_Drain(&f, CONSOLE, 1, 0, sim_send, g_sock);
+    uint32_t first;
+    ASSERT_EQ(parse_rx(&g_sock[TAP2], &first, NULL), 1);
+    ASSERT_EQ(first, 5);
+    ASSERT_EQ(parse_rx(&g_sock[CONSOLE], &first, NULL), 6);
+    ASSERT_EQ(first, 0);
+    ASSERT_EQ(f.client[TAP2].droppedBytes, 0);  /* joining is not a loss */
+}
+
+TEST(test_slow_tap_loses_only_its_own_blocks)
+{
+    SharedBlockQueue_t q;
+    TcpFanout_t f;
+    setup(&q, &f, 1000);
+    for (uint8_t c = 0; c < CLIENTS; c++) TcpFanout_Attach(&f, c, 0);
+
+    /* TAP2 takes nothing; the other two keep up. */
+    uint32_t primaryLost = 0;
+    for (int i = 0; i < 50; i++) {
+        ASSERT_TRUE(publish(&f, 100, &primaryLost));
+        g_sock[CONSOLE].credit = 1;
+        g_sock[TAP1].credit = 1;
+        TcpFanout_Drain(&f, CONSOLE, 1, (uint32_t)i, sim_send, g_sock);
+        TcpFanout_Drain(&f, TAP1, 1, (uint32_t)i, sim_send, g_sock);
+        TcpFanout_Drain(&f, TAP2, 1, (uint32_t)i, sim_send, g_sock);
+    }
+    ASSERT_EQ(primaryLost, 0);
+    ASSERT_EQ(f.client[CONSOLE].droppedBytes, 0);
+    ASSERT_EQ(f.client[TAP1].droppedBytes, 0);
+    ASSERT_TRUE(f.client[TAP2].droppedBlocks > 0);
+    ASSERT_EQ(f.client[TAP2].droppedBytes + TcpFanout_Pending(&f, TAP2), 50 * 100);
+    ASSERT_EQ(parse_rx(&g_sock[CONSOLE], NULL, NULL), 50);
+    ASSERT_EQ(parse_rx(&g_sock[TAP1], NULL, NULL), 50);
+
+    /* When it resumes it gets the newest whole blocks, in order. */
+    g_sock[TAP2].credit = 100;
+    TcpFanout_Drain(&f, TAP2, 1, 50, sim_send, g_sock);
+    uint32_t first, last;
+    int n = parse_rx(&g_sock[TAP2], &first, &last);
+    ASSERT_TRUE(n > 0);
+    ASSERT_EQ(last, 49);
+    ASSERT_EQ((uint32_t)n * 100 + f.client[TAP2].droppedBytes, 50 * 100);
+}
+
+TEST(test_primary_backpressures_instead_of_losing)
+{
+    SharedBlockQueue_t q;
+    TcpFanout_t f;
+    setup(&q, &f, 1000);
+    TcpFanout_Attach(&f, CONSOLE, 0);
+    TcpFanout_Attach(&f, TAP1, 0);
+
+    /* The console takes nothing: the arena fills, then Reserve refuses. */
+    uint32_t primaryLost = 0;
+    int published = 0;
+    while (publish(&f, 100, &primaryLost)) published++;
+    ASSERT_EQ(published, 10);
+    ASSERT_EQ(primaryLost, 0);
+    ASSERT_EQ(TcpFanout_Pending(&f, CONSOLE), 1000);
+
+    /* The producer gives up waiting: only then is the console charged. */
+    ASSERT_EQ(TcpFanout_ReleasePrimary(&f), 1000);
+    ASSERT_EQ(f.client[CONSOLE].droppedBytes, 1000);
+    /* The tap's backlog is its own and survives the release. */
+    ASSERT_EQ(TcpFanout_Pending(&f, TAP1), 1000);
+    ASSERT_TRUE(publish(&f, 100, &primaryLost));
+    ASSERT_EQ(primaryLost, 0);
+    ASSERT_EQ(f.client[TAP1].droppedBlocks, 1);
+}
+
+TEST(test_stalled_tap_is_reported)
+{
+    SharedBlockQueue_t q;
+    TcpFanout_t f;
+    setup(&q, &f, 1000);
+    TcpFanout_Attach(&f, CONSOLE, 0);
+    TcpFanout_Attach(&f, TAP1, 0);
+    TcpFanout_Attach(&f, TAP2, 0);
+    const uint32_t limit = 100;
+
+    /* Idle with nothing queued is not a stall, however long. */
+    ASSERT_FALSE(TcpFanout_Stalled(&f, TAP1, 1000, limit));
+    TcpFanout_Drain(&f, TAP1, 1, 1000, sim_send, g_sock);
+    TcpFanout_Drain(&f, TAP2, 1, 1000, sim_send, g_sock);
+
+    /* TAP1 keeps up, TAP2 takes nothing, the console takes nothing either. */
+    uint32_t now;
+    for (now = 1000; now < 1300; now += 10) {
+        publish(&f, 100, NULL);
+        g_sock[CONSOLE].credit = 1;
+        TcpFanout_Drain(&f, CONSOLE, 1, now, sim_send, g_sock);
+        g_sock[TAP1].credit = 1;
+        TcpFanout_Drain(&f, TAP1, 1, now, sim_send, g_sock);
+        TcpFanout_Drain(&f, TAP2, 1, now, sim_send, g_sock);
+        if (now < 1000 + limit) {
+            ASSERT_FALSE(TcpFanout_Stalled(&f, TAP2, now, limit));
+        }
+    }
+    ASSERT_TRUE(TcpFanout_Stalled(&f, TAP2, now, limit));
+    ASSERT_FALSE(TcpFanout_Stalled(&f, TAP1, now, limit));
+    /* Evicted down to an empty cursor is still not caught up. */
+    TcpFanout_Drain(&f, TAP2, 1, now, sim_send, g_sock);
+    ASSERT_TRUE(TcpFanout_Stalled(&f, TAP2, now, limit));
+
+    /* The console is never "stalled": the producer waits on it instead. */
+    g_sock[CONSOLE].credit = 0;
+    publish(&f, 100, NULL);
+    ASSERT_FALSE(TcpFanout_Stalled(&f, CONSOLE, now + 10 * limit, limit));
+
+    /* One send taken resets the clock. */
+    g_sock[TAP2].credit = 1;
+    TcpFanout_Drain(&f, TAP2, 1, now, sim_send, g_sock);
+    ASSERT_FALSE(TcpFanout_Stalled(&f, TAP2, now + 1, limit));
+
+    /* Detached: nothing to report, its blocks released. */
+    TcpFanout_Detach(&f, TAP2);
+    ASSERT_FALSE(TcpFanout_Stalled(&f, TAP2, now + 10 * limit, limit));
+    ASSERT_EQ(TcpFanout_Pending(&f, TAP2), 0);
+}
+
+TEST(test_reattach_restarts_the_counters)
+{
+    SharedBlockQueue_t q;
+    TcpFanout_t f;
+    setup(&q, &f, 500);
+    TcpFanout_Attach(&f, TAP1, 0);
+    for (int i = 0; i < 8; i++) publish(&f, 100, NULL);
+    ASSERT_TRUE(f.client[TAP1].droppedBytes > 0);
+    ASSERT_EQ(TcpFanout_Detach(&f, TAP1), 500);
+    ASSERT_EQ(q.tail - q.head, 0);           /* nothing left holding the arena */
+
+    TcpFanout_Attach(&f, TAP1, 42);
+    ASSERT_EQ(f.client[TAP1].droppedBytes, 0);
+    ASSERT_EQ(f.client[TAP1].lastProgress, 42);
+    ASSERT_EQ(TcpFanout_Pending(&f, TAP1), 0);
+}
+
+TEST(test_min_len_holds_back_short_runs)
+{
+    SharedBlockQueue_t q;
+    TcpFanout_t f;
+    setup(&q, &f, 4096);
+    TcpFanout_Attach(&f, CONSOLE, 0);
+    g_sock[CONSOLE].credit = 10;
+
+    publish(&f, 40, NULL);
+    ASSERT_EQ(TcpFanout_Drain(&f, CONSOLE, 64, 0, sim_send, g_sock), 0);
+    ASSERT_EQ(g_sock[CONSOLE].calls, 0);
+    publish(&f, 40, NULL);
+    ASSERT_EQ(TcpFanout_Drain(&f, CONSOLE, 64, 0, sim_send, g_sock), 80);
+    publish(&f, 40, NULL);
+    ASSERT_EQ(TcpFanout_Drain(&f, CONSOLE, 1, 0, sim_send, g_sock), 40);
+}
+
+TEST(test_send_error_keeps_the_data)
+{
+    SharedBlockQueue_t q;
+    TcpFanout_t f;
+    setup(&q, &f, 4096);
+    TcpFanout_Attach(&f, TAP1, 0);
+    publish(&f, 60, NULL);
+
+    g_sock[TAP1].credit = 5;
+    g_sock[TAP1].fail = 1;
+    ASSERT_EQ(TcpFanout_Drain(&f, TAP1, 1, 0, sim_send, g_sock), -1);
+    ASSERT_EQ(f.client[TAP1].sendErrors, 1);
+    ASSERT_EQ(TcpFanout_Pending(&f, TAP1), 60);
+    ASSERT_EQ(TcpFanout_Drain(&f, TAP1, 1, 0, sim_send, g_sock), 60);
+    ASSERT_EQ(parse_rx(&g_sock[TAP1], NULL, NULL), 1);
+}
+
+/* A long randomized session: the console drains fast with occasional short
+ * stalls (the producer waits them out), TAP1 drains at a little under the
+ * production rate, TAP2 stalls for long stretches. Every client must see
+ * only whole blocks in order; the console must lose nothing; each tap's
+ * received + dropped + pending bytes must equal what was published after it
+ * attached. */
+TEST(test_randomized_three_clients)
+{
+    SharedBlockQueue_t q;
+    TcpFanout_t f;
+    setup(&q, &f, 4096);
+    srand(1234);
+    for (uint8_t c = 0; c < CLIENTS; c++) TcpFanout_Attach(&f, c, 0);
+
+    uint64_t produced = 0;
+    uint32_t primaryLost = 0;
+    uint32_t waits = 0;
+    for (uint32_t tick = 0; tick < 20000; tick++) {
+        uint32_t len = 16u + (uint32_t)(rand() % 200);
+        if (publish(&f, len, &primaryLost)) {
+            produced += len;
+        } else {
+            waits++;            /* backpressure: this batch waits a tick */
+        }
+        g_sock[CONSOLE].credit = ((tick / 500) % 7 == 3) ? 0 : 2;
+        g_sock[TAP1].credit = (rand() % 3 != 0) ? 1 : 0;
+        g_sock[TAP2].credit = ((tick / 2000) % 2 == 1 && rand() % 2) ? 1 : 0;
+        for (uint8_t c = 0; c < CLIENTS; c++) {
+            TcpFanout_Drain(&f, c, 1, tick, sim_send, g_sock);
+        }
+    }
+    for (uint8_t c = 0; c < CLIENTS; c++) {
+        g_sock[c].credit = 1000000;
+        TcpFanout_Drain(&f, c, 1, 20000, sim_send, g_sock);
+    }
+
+    uint32_t first, last;
+    ASSERT_TRUE(waits > 0);
+    ASSERT_EQ(primaryLost, 0);
+    ASSERT_EQ(parse_rx(&g_sock[CONSOLE], &first, &last), (int)g_seq);
+    ASSERT_EQ(g_sock[CONSOLE].rxLen, produced);
+    for (uint8_t c = TAP1; c <= TAP2; c++) {
+        ASSERT_TRUE(parse_rx(&g_sock[c], NULL, &last) > 0);
+        ASSERT_EQ(last, g_seq - 1u);
+        ASSERT_EQ(g_sock[c].rxLen + f.client[c].droppedBytes, produced);
+    }
+    ASSERT_TRUE(f.client[TAP2].droppedBytes > f.client[TAP1].droppedBytes);
+    ASSERT_EQ(q.tail - q.head, 0);
+    printf("    %u blocks, %llu B; producer waited %u ticks on the console; "
+           "taps lost %u / %u B\n",
+           (unsigned)g_seq, (unsigned long long)produced, (unsigned)waits,
+           (unsigned)f.client[TAP1].droppedBytes, (unsigned)f.client[TAP2].droppedBytes);
+}
+
+int main(void)
+{
+    printf("TCP fan-out (WiFi clients over one shared queue)\n");
+    printf("---------------------------------------------\n");
+    RUN(test_init_rejects_bad_args);
+    RUN(test_every_client_gets_the_whole_stream);
+    RUN(test_sends_are_whole_blocks_up_to_max_send);
+    RUN(test_late_client_starts_at_the_next_block);
+    RUN(test_slow_tap_loses_only_its_own_blocks);
+    RUN(test_primary_backpressures_instead_of_losing);
+    RUN(test_stalled_tap_is_reported);
+    RUN(test_reattach_restarts_the_counters);
+    RUN(test_min_len_holds_back_short_runs);
+    RUN(test_send_error_keeps_the_data);
+    RUN(test_randomized_three_clients);
+    return TEST_SUMMARY();
+}
@@ -0,0 +1,381 @@
+/* ==========================================================================
+ * test_udp_stream.c — firmware/src/Util/UdpStream.c unit tests
+ *
+ * Header encoding, the batch packer and the receiver's loss accounting, then
+ * the packer over a real UDP socket pair on 127.0.0.1: a session of batches
+ * (single messages up to a few datagrams long, and runs of small ones) is
+ * packed and sent with some datagrams withheld and one pair swapped, and
+ * what the receiver passes on must be exactly the batches that arrived
+ * whole, message for message, with the withheld datagrams counted lost.
+ *
+ * Run: make -C tests/host run
+ * ========================================================================== */
+#define _POSIX_C_SOURCE 200809L
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "UdpStream.h"   /* real header (via -I firmware/src/Util) */
+#include "test_framework.h"
+
+#define MAX_PAYLOAD   1384u   /* WIFI_WBUFFER_SIZE minus the header */
+#define BATCHES       400u
+#define STREAM_CAP    (BATCHES * 4u * MAX_PAYLOAD)
+#define MAX_DGRAMS    4096u
+
+/* --------------------------------------------------------------------------
+ * Messages: [u16 len][u32 id][len - 6 bytes of id-derived filler]
+ * ------------------------------------------------------------------------ */
+static size_t put_message(uint8_t* out, uint32_t id, size_t len)
+{
+    out[0] = (uint8_t)(len >> 8);
+    out[1] = (uint8_t)len;
+    out[2] = (uint8_t)(id >> 24);
+    out[3] = (uint8_t)(id >> 16);
+    out[4] = (uint8_t)(id >> 8);
+    out[5] = (uint8_t)id;
+    for (size_t i = 6; i < len; i++) {
+        out[i] = (uint8_t)(id * 31u + i);
+    }
+    return len;
+}
+
+/* Parse a delivered stream into message ids; false on any malformed one. */
+static bool parse_messages(const uint8_t* s, size_t len, uint32_t* ids, size_t* pCount)
+{
+    size_t at = 0, n = 0;
+    while (at < len) {
+        if (len - at < 6u) {
+            return false;
+        }
+        size_t mlen = ((size_t)s[at] << 8) | s[at + 1];
+        uint32_t id = ((uint32_t)s[at + 2] << 24) | ((uint32_t)s[at + 3] << 16) |
+                      ((uint32_t)s[at + 4] << 8) | s[at + 5];
+        if (mlen < 6u || mlen > len - at) {
+            return false;
+        }
+        for (size_t i = 6; i < mlen; i++) {
+            if (s[at + i] != (uint8_t)(id * 31u + i)) {
+                return false;
+            }
+        }
+        ids[n++] = id;
+        at += mlen;
+    }
+    *pCount = n;
+    return true;
+}
+
+/* --------------------------------------------------------------------------
+ * Sink that records datagrams in memory
+ * ------------------------------------------------------------------------ */
+typedef struct {
+    uint8_t  data[MAX_DGRAMS][UDP_STREAM_HEADER_SIZE + MAX_PAYLOAD];
+    size_t   len[MAX_DGRAMS];
+    uint32_t count;
+} Dgrams_t;
+
+static Dgrams_t g_dgrams;
+
+static void mem_sink(void* ctx, const uint8_t* hdr, const uint8_t* payload, size_t len)
+{
+    Dgrams_t* d = (Dgrams_t*)ctx;
+    memcpy(d->data[d->count], hdr, UDP_STREAM_HEADER_SIZE);
+    memcpy(d->data[d->count] + UDP_STREAM_HEADER_SIZE, payload, len);
+    d->len[d->count] = UDP_STREAM_HEADER_SIZE + len;
+    d->count++;
+}
+
+/* ------------------------------------------------------------------------ */
+
+TEST(test_header_round_trip)
+{
+    UdpStreamHeader_t h = {.flags = UDP_STREAM_FLAG_CONT | UDP_STREAM_FLAG_MORE,
+                           .encoding = 4u, .payloadLen = 1384u,
+                           .seq = 0xA1B2C3D4u, .firstTs = 0x01020304u};
+    uint8_t buf[UDP_STREAM_HEADER_SIZE + 1384u];
+    UdpStreamHeader_t got;
+    UdpStream_EncodeHeader(buf, &h);
+    ASSERT_BYTES(buf, "DQ\x01\x03\xA1\xB2\xC3\xD4\x01\x02\x03\x04\x05\x68\x04\x00", 16u);
+    ASSERT_TRUE(UdpStream_DecodeHeader(buf, sizeof(buf), &got));
+    ASSERT_EQ(got.flags, h.flags);
+    ASSERT_EQ(got.encoding, h.encoding);
+    ASSERT_EQ(got.payloadLen, h.payloadLen);
+    ASSERT_EQ(got.seq, h.seq);
+    ASSERT_EQ(got.firstTs, h.firstTs);
+
+    /* Short datagram, bad magic, unknown version. */
+    ASSERT_FALSE(UdpStream_DecodeHeader(buf, sizeof(buf) - 1u, &got));
+    ASSERT_FALSE(UdpStream_DecodeHeader(buf, 15u, &got));
+    buf[1] = 'X';
+    ASSERT_FALSE(UdpStream_DecodeHeader(buf, sizeof(buf), &got));
+    buf[1] = 'Q';
+    buf[2] = 2u;
+    ASSERT_FALSE(UdpStream_DecodeHeader(buf, sizeof(buf), &got));
+}
+
+TEST(test_pack_splits_a_large_batch)
+{
+    static uint8_t batch[3000];
+    uint32_t seq = 7u;
+    for (size_t i = 0; i < sizeof(batch); i++) {
+        batch[i] = (uint8_t)i;
+    }
+    g_dgrams.count = 0;
+    ASSERT_EQ(UdpStream_Pack(&seq, 2u, 0xCAFEu, batch, sizeof(batch), MAX_PAYLOAD,
+                             mem_sink, &g_dgrams), 3u);
+    ASSERT_EQ(seq, 10u);
+    ASSERT_EQ(UdpStream_WireSize(sizeof(batch), MAX_PAYLOAD),
+              g_dgrams.len[0] + g_dgrams.len[1] + g_dgrams.len[2]);
+
+    static const uint8_t flags[3] = {UDP_STREAM_FLAG_MORE,
+                                     UDP_STREAM_FLAG_CONT | UDP_STREAM_FLAG_MORE,
+                                     UDP_STREAM_FLAG_CONT};
+    size_t at = 0;
+    for (uint32_t i = 0; i < 3u; i++) {
+        UdpStreamHeader_t h;
+        ASSERT_TRUE(UdpStream_DecodeHeader(g_dgrams.data[i], g_dgrams.len[i], &h));
+        ASSERT_EQ(h.seq, 7u + i);
+        ASSERT_EQ(h.flags, flags[i]);
+        ASSERT_EQ(h.firstTs, 0xCAFEu);
+        ASSERT_EQ(h.encoding, 2u);
+        ASSERT_BYTES(g_dgrams.data[i] + UDP_STREAM_HEADER_SIZE, batch + at, h.payloadLen);
+        at += h.payloadLen;
+    }
+    ASSERT_EQ(at, sizeof(batch));
+
+    /* Exactly one payload's worth is one datagram, flags clear. */
+    g_dgrams.count = 0;
+    ASSERT_EQ(UdpStream_Pack(&seq, 2u, 0u, batch, MAX_PAYLOAD, MAX_PAYLOAD,
+                             mem_sink, &g_dgrams), 1u);
+    ASSERT_EQ(g_dgrams.data[0][3], 0u);
+    ASSERT_EQ(UdpStream_WireSize(MAX_PAYLOAD, MAX_PAYLOAD), MAX_PAYLOAD + 16u);
+    ASSERT_EQ(UdpStream_WireSize(MAX_PAYLOAD + 1u, MAX_PAYLOAD), MAX_PAYLOAD + 33u);
+}
+
+static UdpStreamRxResult rx(UdpStreamRx_t* r, uint32_t seq, uint8_t flags)
+{
+    UdpStreamHeader_t h = {.seq = seq, .flags = flags, .payloadLen = 10u};
+    return UdpStreamRx_Accept(r, &h);
+}
+
+TEST(test_rx_accounting)
+{
+    const uint8_t M = UDP_STREAM_FLAG_MORE, C = UDP_STREAM_FLAG_CONT;
+    UdpStreamRx_t r;
+    memset(&r, 0, sizeof(r));
+
+    /* Joining mid-session: the seqs before the first one seen are lost, and a
+     * batch already under way is dropped until the next one starts. */
+    ASSERT_EQ(rx(&r, 5u, C | M), UDP_STREAM_RX_DROP);
+    ASSERT_EQ(rx(&r, 6u, C), UDP_STREAM_RX_DROP);
+    ASSERT_EQ(r.lost, 5u);
+    ASSERT_EQ(rx(&r, 7u, 0u), UDP_STREAM_RX_DELIVER);
+
+    /* A three-piece batch arriving whole. */
+    ASSERT_EQ(rx(&r, 8u, M), UDP_STREAM_RX_DELIVER);
+    ASSERT_EQ(rx(&r, 9u, C | M), UDP_STREAM_RX_DELIVER);
+    ASSERT_EQ(rx(&r, 10u, C), UDP_STREAM_RX_DELIVER);
+    ASSERT_EQ(r.torn, 0u);
+
+    /* A batch that loses its middle piece: the open batch and the tail go. */
+    ASSERT_EQ(rx(&r, 11u, M), UDP_STREAM_RX_DELIVER);
+    ASSERT_EQ(rx(&r, 13u, C), UDP_STREAM_RX_DROP);
+    ASSERT_EQ(r.torn, 1u);
+    ASSERT_EQ(r.lost, 6u);
+
+    /* A batch that loses its tail: the next batch restarts clean. */
+    ASSERT_EQ(rx(&r, 14u, M), UDP_STREAM_RX_DELIVER);
+    ASSERT_EQ(rx(&r, 16u, 0u), UDP_STREAM_RX_RESTART);
+    ASSERT_EQ(r.torn, 2u);
+    ASSERT_EQ(r.lost, 7u);
+
+    /* The lost one turns up after all: late, ignored, still counted lost. */
+    ASSERT_EQ(rx(&r, 15u, C), UDP_STREAM_RX_LATE);
+    ASSERT_EQ(r.late, 1u);
+    ASSERT_EQ(rx(&r, 17u, 0u), UDP_STREAM_RX_DELIVER);
+
+    /* A new session starts over at 0. */
+    ASSERT_EQ(rx(&r, 0u, 0u), UDP_STREAM_RX_DELIVER);
+    ASSERT_EQ(r.sessions, 1u);
+    ASSERT_EQ(r.lost, 7u);
+
+    /* seq wraps at 2^32 without a false loss or a new session. */
+    r.nextSeq = 0xFFFFFFFFu;
+    ASSERT_EQ(rx(&r, 0xFFFFFFFFu, M), UDP_STREAM_RX_DELIVER);
+    ASSERT_EQ(rx(&r, 0u, C), UDP_STREAM_RX_DELIVER);
+    ASSERT_EQ(rx(&r, 1u, 0u), UDP_STREAM_RX_DELIVER);
+    ASSERT_EQ(r.lost, 7u);
+    ASSERT_EQ(r.sessions, 1u);
+    ASSERT_EQ(r.received, 16u);
+}
+
+/* --------------------------------------------------------------------------
+ * Loopback session
+ * ------------------------------------------------------------------------ */
+typedef struct {
+    int       tx;
+    struct sockaddr_in to;
+    uint32_t  sent;          /* datagrams packed so far */
+    uint32_t  withheld;
+    int       heldBack;      /* index of a datagram swapped with the next, or -1 */
+    uint8_t   held[UDP_STREAM_HEADER_SIZE + MAX_PAYLOAD];
+    size_t    heldLen;
+    bool      lostDgram[MAX_DGRAMS]; /* withheld or late: its batch can't arrive */
+} Sender_t;
+
+static void udp_sink(void* ctx, const uint8_t* hdr, const uint8_t* payload, size_t len)
+{
+    Sender_t* s = (Sender_t*)ctx;
+    uint8_t d[UDP_STREAM_HEADER_SIZE + MAX_PAYLOAD];
+    uint32_t i = s->sent++;
+    memcpy(d, hdr, UDP_STREAM_HEADER_SIZE);
+    memcpy(d + UDP_STREAM_HEADER_SIZE, payload, len);
+    len += UDP_STREAM_HEADER_SIZE;
+
+    if (i % 37u == 11u || i % 101u == 50u) {   /* "the air ate it" */
+        s->withheld++;
+        s->lostDgram[i] = true;
+        return;
+    }
+    if ((int)i == s->heldBack) {
+        memcpy(s->held, d, len);
+        s->heldLen = len;
+        s->lostDgram[i] = true;
+        return;
+    }
+    sendto(s->tx, d, len, 0, (struct sockaddr*)&s->to, sizeof(s->to));
+    if (s->heldLen > 0u) {
+        sendto(s->tx, s->held, s->heldLen, 0, (struct sockaddr*)&s->to, sizeof(s->to));
+        s->heldLen = 0;
+    }
+}
+
+typedef struct {
+    uint8_t* out;
+    size_t   outLen;
+    uint8_t  open[8u * MAX_PAYLOAD];
+    size_t   openLen;
+    UdpStreamRx_t rx;
+    uint32_t bad;
+} Receiver_t;
+
+/* What a host does with each datagram (udp_stream_rx.c is the same loop). */
+static void receive_all(int sock, Receiver_t* r)
+{
+    uint8_t d[2048];
+    ssize_t n;
+    while ((n = recv(sock, d, sizeof(d), MSG_DONTWAIT)) > 0) {
+        UdpStreamHeader_t h;
+        if (!UdpStream_DecodeHeader(d, (size_t)n, &h)) {
+            r->bad++;
+            continue;
+        }
+        switch (UdpStreamRx_Accept(&r->rx, &h)) {
+            case UDP_STREAM_RX_RESTART:
+                r->openLen = 0;
+                /* fall through */
+            case UDP_STREAM_RX_DELIVER:
+                memcpy(r->open + r->openLen, d + UDP_STREAM_HEADER_SIZE, h.payloadLen);
+                r->openLen += h.payloadLen;
+                if ((h.flags & UDP_STREAM_FLAG_MORE) == 0u) {
+                    memcpy(r->out + r->outLen, r->open, r->openLen);
+                    r->outLen += r->openLen;
+                    r->openLen = 0;
+                }
+                break;
+            case UDP_STREAM_RX_DROP:
+                r->openLen = 0;
+                break;
+            case UDP_STREAM_RX_LATE:
+                break;
+        }
+    }
+}
+
+TEST(test_loopback_session)
+{
+    static uint8_t batch[4u * MAX_PAYLOAD];
+    static uint8_t expect[STREAM_CAP], got[STREAM_CAP];
+    static uint32_t expectIds[BATCHES * 64u], gotIds[BATCHES * 64u];
+    static Sender_t s;
+    static Receiver_t r;
+    size_t expectLen = 0, expectCount = 0;
+
+    int rxSock = socket(AF_INET, SOCK_DGRAM, 0);
+    s.tx = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_TRUE(rxSock >= 0 && s.tx >= 0);
+    struct sockaddr_in addr = {.sin_family = AF_INET};
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(bind(rxSock, (struct sockaddr*)&addr, sizeof(addr)), 0);
+    socklen_t alen = sizeof(s.to);
+    ASSERT_EQ(getsockname(rxSock, (struct sockaddr*)&s.to, &alen), 0);
+    s.heldBack = 200;
+    r.out = got;
+
+    uint32_t seq = 0, id = 0;
+    srand(16);
+    for (uint32_t b = 0; b < BATCHES; b++) {
+        /* Mostly runs of small messages that fill a datagram, sometimes one
+         * message spanning up to three. */
+        size_t len = 0;
+        uint32_t firstId = id;
+        if (b % 9u == 4u) {
+            len = put_message(batch, id++, MAX_PAYLOAD + 1u + (size_t)rand() % (2u * MAX_PAYLOAD));
+        } else {
+            size_t m;
+            while ((m = 6u + (size_t)rand() % 200u) <= MAX_PAYLOAD - len) {
+                len += put_message(batch + len, id++, m);
+            }
+        }
+        uint32_t first = s.sent;
+        UdpStream_Pack(&seq, 0u, 1000u * b, batch, len, MAX_PAYLOAD, udp_sink, &s);
+
+        bool whole = true;
+        for (uint32_t i = first; i < s.sent; i++) {
+            whole = whole && !s.lostDgram[i];
+        }
+        if (whole) {
+            memcpy(expect + expectLen, batch, len);
+            expectLen += len;
+            for (uint32_t m = firstId; m < id; m++) {
+                expectIds[expectCount++] = m;
+            }
+        }
+        receive_all(rxSock, &r);   /* keep the socket buffer from overflowing */
+    }
+    nanosleep(&(struct timespec){.tv_nsec = 10000000}, NULL);
+    receive_all(rxSock, &r);
+
+    size_t gotCount = 0;
+    ASSERT_EQ(r.bad, 0u);
+    ASSERT_EQ(r.rx.lost, (uint64_t)s.withheld + 1u);   /* + the swapped one */
+    ASSERT_EQ(r.rx.late, 1u);
+    ASSERT_EQ(r.rx.received + s.withheld, (uint64_t)s.sent);
+    ASSERT_EQ(r.outLen, expectLen);
+    ASSERT_BYTES(got, expect, expectLen);
+    ASSERT_TRUE(parse_messages(got, r.outLen, gotIds, &gotCount));
+    ASSERT_EQ(gotCount, expectCount);
+    ASSERT_BYTES(gotIds, expectIds, expectCount * sizeof(uint32_t));
+    printf("    %u datagrams, %u withheld, %u batches torn, %u/%u messages delivered\n",
+           (unsigned)s.sent, (unsigned)s.withheld, (unsigned)r.rx.torn,
+           (unsigned)gotCount, (unsigned)id);
+    close(rxSock);
+    close(s.tx);
+}
+
+int main(void)
+{
+    printf("UdpStream host tests\n");
+    RUN(test_header_round_trip);
+    RUN(test_pack_splits_a_large_batch);
+    RUN(test_rx_accounting);
+    RUN(test_loopback_session);
+    TEST_SUMMARY();
+}
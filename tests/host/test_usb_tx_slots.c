@@ -0,0 +1,470 @@
+/* ==========================================================================
+ * test_usb_tx_slots.c — firmware/src/Util/UsbTxSlots.c unit tests and a
+ * virtual-time model of the USB CDC write path.
+ *
+ * Unit cases: carving (two packet-multiple slots, the 64 KB transfer cap,
+ * one slot for small buffers), the claim/queue/submit/complete handoff in
+ * order, the claim excluding a second writer, the zero-length-packet rule,
+ * a failed submit backing out, teardown forgetting in-flight transfers, and
+ * counter wrap.
+ *
+ * The model runs UsbCdc_BeginWrite's loop against a fake IN endpoint on one
+ * virtual clock: a producer fills the circular buffer at a fixed rate; the
+ * USB task claims a slot, spends copy time filling it, and queues it; the
+ * endpoint moves the oldest queued slot at wire speed and completes it. With
+ * one slot the wire waits out every copy; with two the next transfer is
+ * already queued when the last one finishes. Everything the host received is
+ * compared byte for byte with what the producer generated, and every burst
+ * must end with a transfer that terminates the host's read.
+ *
+ * Run: make -C tests/host run
+ * ========================================================================== */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "UsbTxSlots.h"     /* real header (via -I firmware/src/Util) */
+#include "test_framework.h"
+
+#define NO_HANDLE ((uintptr_t)-1)
+
+static uint8_t g_dma[2u * USB_TX_TRANSFER_MAX + 4096u];
+
+/* Stand-in for USB_DEVICE_CDC_Write filling in the transfer handle. */
+static uintptr_t g_nextHandle = 0x100;
+
+static UsbTxSlot_t* submit(UsbTxSlots_t* t, uint32_t len, bool more)
+{
+    UsbTxSlot_t* s = UsbTxSlots_Queue(t, len, more);
+    if (s != NULL) {
+        s->handle = g_nextHandle++;
+    }
+    UsbTxSlots_Submitted(t, s != NULL);
+    return s;
+}
+
+/* --------------------------------------------------------------------------
+ * Unit cases
+ * ------------------------------------------------------------------------ */
+TEST(test_init_carves_packet_slots)
+{
+    UsbTxSlots_t t;
+    ASSERT_TRUE(UsbTxSlots_Init(&t, g_dma, 16384, USB_TX_MAX_PACKET_HS, NO_HANDLE));
+    ASSERT_EQ(t.count, 2u);
+    ASSERT_EQ(t.slotSize, 8192u);
+    ASSERT_TRUE(t.slot[1].data == g_dma + 8192);
+    ASSERT_TRUE(t.slot[0].handle == NO_HANDLE);
+
+    /* An odd size loses its sub-packet remainder per slot. */
+    ASSERT_TRUE(UsbTxSlots_Init(&t, g_dma, 5000, USB_TX_MAX_PACKET_HS, NO_HANDLE));
+    ASSERT_EQ(t.count, 2u);
+    ASSERT_EQ(t.slotSize, 2048u);
+
+    /* The 512 B SCPI-only minimum: one slot, as before. */
+    ASSERT_TRUE(UsbTxSlots_Init(&t, g_dma, 900, USB_TX_MAX_PACKET_HS, NO_HANDLE));
+    ASSERT_EQ(t.count, 1u);
+    ASSERT_EQ(t.slotSize, 512u);
+
+    /* A whole coherent pool: each transfer stops at 64 KB. */
+    ASSERT_TRUE(UsbTxSlots_Init(&t, g_dma, sizeof(g_dma), USB_TX_MAX_PACKET_HS, NO_HANDLE));
+    ASSERT_EQ(t.count, 2u);
+    ASSERT_EQ(UsbTxSlots_SlotSize(&t), USB_TX_TRANSFER_MAX);
+
+    /* Not one packet: refused, and the instance stays inert. */
+    ASSERT_FALSE(UsbTxSlots_Init(&t, g_dma, 511, USB_TX_MAX_PACKET_HS, NO_HANDLE));
+    uint32_t cap = 1;
+    ASSERT_TRUE(UsbTxSlots_Claim(&t, &cap) == NULL);
+    ASSERT_EQ(cap, 0u);
+    ASSERT_FALSE(UsbTxSlots_Init(&t, NULL, 4096, USB_TX_MAX_PACKET_HS, NO_HANDLE));
+
+    /* No max packet yet: high speed assumed. */
+    ASSERT_TRUE(UsbTxSlots_Init(&t, g_dma, 4096, 0, NO_HANDLE));
+    ASSERT_EQ(t.maxPacket, USB_TX_MAX_PACKET_HS);
+}
+
+TEST(test_in_order_handoff)
+{
+    UsbTxSlots_t t;
+    ASSERT_TRUE(UsbTxSlots_Init(&t, g_dma, 4096, USB_TX_MAX_PACKET_HS, NO_HANDLE));
+
+    uint32_t cap;
+    uint8_t* a = UsbTxSlots_Claim(&t, &cap);
+    ASSERT_TRUE(a == g_dma);
+    ASSERT_EQ(cap, 2048u);
+    UsbTxSlot_t* sa = submit(&t, 2048, true);
+    ASSERT_TRUE(sa != NULL && sa->data == a);
+    ASSERT_FALSE(sa->overlapped);
+
+    /* The second slot fills while the first is on the wire. */
+    uint8_t* b = UsbTxSlots_Claim(&t, &cap);
+    ASSERT_TRUE(b == g_dma + 2048);
+    UsbTxSlot_t* sb = submit(&t, 700, false);
+    ASSERT_TRUE(sb != NULL && sb->overlapped);
+    ASSERT_EQ(UsbTxSlots_InFlight(&t), 2u);
+    ASSERT_TRUE(UsbTxSlots_Claim(&t, &cap) == NULL);
+    ASSERT_EQ(cap, 0u);
+
+    /* Completions come back oldest first; anything else is not ours. */
+    uint32_t len = 0;
+    ASSERT_FALSE(UsbTxSlots_Complete(&t, sb->handle, &len));
+    ASSERT_FALSE(UsbTxSlots_Complete(&t, NO_HANDLE, &len));
+    ASSERT_FALSE(UsbTxSlots_Complete(&t, 0x5, &len));
+    ASSERT_TRUE(UsbTxSlots_Complete(&t, sa->handle, &len));
+    ASSERT_EQ(len, 2048u);
+    ASSERT_EQ(UsbTxSlots_InFlight(&t), 1u);
+    ASSERT_TRUE(sa->handle == NO_HANDLE);
+
+    /* The freed slot is the next one claimed. */
+    ASSERT_TRUE(UsbTxSlots_Claim(&t, &cap) == a);
+    UsbTxSlots_Unclaim(&t);
+    ASSERT_TRUE(UsbTxSlots_Complete(&t, sb->handle, &len));
+    ASSERT_EQ(len, 700u);
+    ASSERT_EQ(UsbTxSlots_InFlight(&t), 0u);
+    ASSERT_EQ(t.transfers, 2u);
+    ASSERT_EQ(t.overlapped, 1u);
+}
+
+TEST(test_claim_excludes_second_writer)
+{
+    UsbTxSlots_t t;
+    ASSERT_TRUE(UsbTxSlots_Init(&t, g_dma, 4096, USB_TX_MAX_PACKET_HS, NO_HANDLE));
+    uint32_t cap;
+    ASSERT_TRUE(UsbTxSlots_Claim(&t, &cap) != NULL);
+    /* A slot is free, but a writer is mid-fill: the next one would queue
+     * behind a transfer that does not exist yet. */
+    ASSERT_TRUE(UsbTxSlots_Claim(&t, &cap) == NULL);
+    /* The claim survives Queue until the driver call has returned. */
+    UsbTxSlot_t* s = UsbTxSlots_Queue(&t, 100, false);
+    ASSERT_TRUE(s != NULL);
+    ASSERT_TRUE(UsbTxSlots_Claim(&t, &cap) == NULL);
+    s->handle = g_nextHandle++;
+    UsbTxSlots_Submitted(&t, true);
+    ASSERT_TRUE(UsbTxSlots_Claim(&t, &cap) != NULL);
+    UsbTxSlots_Unclaim(&t);
+    ASSERT_TRUE(UsbTxSlots_Claim(&t, &cap) != NULL);
+    UsbTxSlots_Unclaim(&t);
+
+    /* Queue without a claim, or with nothing to send, queues nothing. */
+    ASSERT_TRUE(UsbTxSlots_Queue(&t, 100, false) == NULL);
+    ASSERT_TRUE(UsbTxSlots_Claim(&t, &cap) != NULL);
+    ASSERT_TRUE(UsbTxSlots_Queue(&t, 0, false) == NULL);
+    UsbTxSlots_Unclaim(&t);
+    ASSERT_EQ(UsbTxSlots_InFlight(&t), 1u);
+}
+
+TEST(test_zlp_rule)
+{
+    UsbTxSlots_t t;
+    uint32_t cap;
+    ASSERT_TRUE(UsbTxSlots_Init(&t, g_dma, 8192, USB_TX_MAX_PACKET_HS, NO_HANDLE));
+
+    /* Packet multiple, more already buffered: continue the host's read. */
+    UsbTxSlots_Claim(&t, &cap);
+    UsbTxSlot_t* s = submit(&t, 2048, true);
+    ASSERT_TRUE(s->morePending);
+    ASSERT_TRUE(t.moreWaiting);
+    ASSERT_EQ(t.zlps, 0u);
+
+    /* Packet multiple, nothing behind it: terminate with a ZLP. */
+    UsbTxSlots_Claim(&t, &cap);
+    s = submit(&t, 1024, false);
+    ASSERT_FALSE(s->morePending);
+    ASSERT_FALSE(t.moreWaiting);
+    ASSERT_EQ(t.zlps, 1u);
+    UsbTxSlots_Reset(&t);
+
+    /* Short last packet ends the read by itself, more or not. */
+    UsbTxSlots_Claim(&t, &cap);
+    s = submit(&t, 1000, true);
+    ASSERT_FALSE(s->morePending);
+    ASSERT_TRUE(t.moreWaiting);
+    UsbTxSlots_Claim(&t, &cap);
+    s = submit(&t, 100, false);
+    ASSERT_FALSE(s->morePending);
+    ASSERT_EQ(t.zlps, 1u);
+    UsbTxSlots_Reset(&t);
+
+    /* Full speed: 64-byte packets make 1000 a non-multiple and 960 one. */
+    UsbTxSlots_SetMaxPacket(&t, USB_TX_MAX_PACKET_FS);
+    UsbTxSlots_SetMaxPacket(&t, 0);     /* ignored */
+    ASSERT_EQ(t.maxPacket, USB_TX_MAX_PACKET_FS);
+    UsbTxSlots_Claim(&t, &cap);
+    s = submit(&t, 960, true);
+    ASSERT_TRUE(s->morePending);
+    UsbTxSlots_Claim(&t, &cap);
+    s = submit(&t, 960, false);
+    ASSERT_FALSE(s->morePending);
+    ASSERT_EQ(t.zlps, 2u);
+
+    /* Oversize is clipped to the slot before the rule is applied. */
+    UsbTxSlots_Reset(&t);
+    UsbTxSlots_Claim(&t, &cap);
+    s = submit(&t, cap + 10u, true);
+    ASSERT_EQ(s->len, cap);
+    ASSERT_TRUE(s->morePending);
+}
+
+TEST(test_failed_submit_backs_out)
+{
+    UsbTxSlots_t t;
+    uint32_t cap;
+    ASSERT_TRUE(UsbTxSlots_Init(&t, g_dma, 4096, USB_TX_MAX_PACKET_HS, NO_HANDLE));
+    uint8_t* a = UsbTxSlots_Claim(&t, &cap);
+    UsbTxSlot_t* s = UsbTxSlots_Queue(&t, 2048, false);
+    ASSERT_TRUE(s != NULL);
+    ASSERT_EQ(UsbTxSlots_InFlight(&t), 1u);
+    UsbTxSlots_Submitted(&t, false);
+    ASSERT_EQ(UsbTxSlots_InFlight(&t), 0u);
+    ASSERT_EQ(t.transfers, 0u);
+    ASSERT_EQ(t.zlps, 0u);
+    ASSERT_TRUE(s->handle == NO_HANDLE);
+    /* Same slot again, so order is unchanged. */
+    ASSERT_TRUE(UsbTxSlots_Claim(&t, &cap) == a);
+}
+
+TEST(test_reset_forgets_in_flight)
+{
+    UsbTxSlots_t t;
+    uint32_t cap, len;
+    ASSERT_TRUE(UsbTxSlots_Init(&t, g_dma, 4096, USB_TX_MAX_PACKET_HS, NO_HANDLE));
+    UsbTxSlots_Claim(&t, &cap);
+    UsbTxSlot_t* a = submit(&t, 100, false);
+    uintptr_t ha = a->handle;
+    UsbTxSlots_Claim(&t, &cap);
+    ASSERT_TRUE(UsbTxSlots_Queue(&t, 200, false) != NULL);
+
+    /* Disconnect while the second is inside the driver call. */
+    UsbTxSlots_Reset(&t);
+    ASSERT_EQ(UsbTxSlots_InFlight(&t), 0u);
+    UsbTxSlots_Submitted(&t, false);        /* nothing to undo */
+    ASSERT_EQ(UsbTxSlots_InFlight(&t), 0u);
+    ASSERT_FALSE(UsbTxSlots_Complete(&t, ha, &len));   /* late event */
+
+    /* Both slots usable again. */
+    ASSERT_TRUE(UsbTxSlots_Claim(&t, &cap) != NULL);
+    ASSERT_TRUE(submit(&t, 10, false) != NULL);
+    ASSERT_TRUE(UsbTxSlots_Claim(&t, &cap) != NULL);
+    ASSERT_TRUE(submit(&t, 10, false) != NULL);
+    ASSERT_EQ(UsbTxSlots_InFlight(&t), 2u);
+}
+
+TEST(test_counters_wrap)
+{
+    UsbTxSlots_t t;
+    uint32_t cap, len;
+    ASSERT_TRUE(UsbTxSlots_Init(&t, g_dma, 4096, USB_TX_MAX_PACKET_HS, NO_HANDLE));
+    t.queued = t.completed = 0xFFFFFFFEu;
+    uint8_t* prev = NULL;
+    for (int i = 0; i < 6; i++) {
+        /* Two in flight across the wrap, then both back in order. */
+        uint8_t* a = UsbTxSlots_Claim(&t, &cap);
+        UsbTxSlot_t* sa = submit(&t, 64, false);
+        uint8_t* b = UsbTxSlots_Claim(&t, &cap);
+        UsbTxSlot_t* sb = submit(&t, 64, false);
+        ASSERT_TRUE(a != NULL && b != NULL && a != b);
+        ASSERT_TRUE(prev == NULL || a != prev);   /* slots keep alternating */
+        ASSERT_EQ(UsbTxSlots_InFlight(&t), 2u);
+        ASSERT_TRUE(UsbTxSlots_Complete(&t, sa->handle, &len));
+        ASSERT_TRUE(UsbTxSlots_Complete(&t, sb->handle, &len));
+        ASSERT_EQ(UsbTxSlots_InFlight(&t), 0u);
+        prev = b;
+    }
+}
+
+/* --------------------------------------------------------------------------
+ * Virtual-time model of UsbCdc_BeginWrite against a fake IN endpoint.
+ * ------------------------------------------------------------------------ */
+#define RING_SIZE   (64u * 1024u)
+#define HOST_MAX    (8u * 1024u * 1024u)
+
+typedef struct {
+    const char* name;
+    uint32_t slots;         /* 1: the single-buffer path this replaced */
+    uint32_t dmaSize;       /* bytes carved into slots */
+    double   produceBps;    /* encoder into the circular buffer */
+    double   copyBps;       /* circular buffer into a slot */
+    double   wireBps;       /* bulk IN while a transfer is queued */
+    double   seconds;
+} UsbModelCfg_t;
+
+typedef struct {
+    uint32_t produced, dropped, received;
+    uint32_t transfers, overlapped;
+    uint32_t unterminated;      /* reads left open with nothing following */
+    double   wireIdle;          /* seconds the wire waited with data buffered */
+    bool     intact;
+} UsbModelOut_t;
+
+#define MODEL_DT        10e-6
+#define MODEL_TICK      1e-3    /* app_USBDeviceTask: ProcessState, vTaskDelay(1) */
+
+static uint8_t g_ring[RING_SIZE];
+static uint8_t g_host[HOST_MAX];
+
+static void model_usb(const UsbModelCfg_t* c, UsbModelOut_t* o)
+{
+    UsbTxSlots_t t;
+    memset(o, 0, sizeof(*o));
+    UsbTxSlots_Init(&t, g_dma, c->dmaSize, USB_TX_MAX_PACKET_HS, NO_HANDLE);
+    if (c->slots == 1u) {
+        t.count = 1u;
+        t.slotSize = (c->dmaSize / USB_TX_MAX_PACKET_HS) * USB_TX_MAX_PACKET_HS;
+    }
+
+    uint32_t head = 0, tail = 0;            /* ring, free-running */
+    double produceAcc = 0.0;
+    uint8_t seq = 0;                        /* next produced byte value */
+
+    /* The USB task: every tick one ProcessState pass fills a free slot, and
+     * the other one too while the first fill left bytes behind, then sleeps. */
+    double nextWake = 0.0;
+    uint32_t fillsLeft = 0;
+    bool filling = false;
+    uint32_t fillLen = 0;
+    bool fillMore = false;
+    double fillDone = 0.0;
+
+    /* The endpoint: bytes of the oldest queued slot already sent. */
+    double wireSent = 0.0;
+
+    uint32_t steps = (uint32_t)(c->seconds / MODEL_DT);
+    for (uint32_t i = 0; i < steps; i++) {
+        double now = i * MODEL_DT;
+
+        if (now < c->seconds * 0.8) {       /* then drain */
+            produceAcc += c->produceBps * MODEL_DT;
+            while (produceAcc >= 1.0) {
+                produceAcc -= 1.0;
+                if (head - tail < RING_SIZE) {
+                    g_ring[head % RING_SIZE] = seq;
+                    head++;
+                    o->produced++;
+                } else {
+                    o->dropped++;
+                }
+                seq++;
+            }
+        }
+
+        if (now >= nextWake) {
+            fillsLeft = t.count;
+            nextWake += MODEL_TICK;
+        }
+        if (filling && now >= fillDone) {
+            UsbTxSlot_t* s = UsbTxSlots_Queue(&t, fillLen, fillMore);
+            s->handle = g_nextHandle++;
+            UsbTxSlots_Submitted(&t, true);
+            filling = false;
+        }
+        if (fillsLeft > 0u && !filling) {
+            uint32_t cap = 0;
+            uint8_t* dst = (head != tail) ? UsbTxSlots_Claim(&t, &cap) : NULL;
+            if (dst != NULL) {
+                uint32_t n = head - tail;
+                if (n > cap) n = cap;
+                for (uint32_t k = 0; k < n; k++) {
+                    dst[k] = g_ring[(tail + k) % RING_SIZE];
+                }
+                tail += n;
+                fillLen = n;
+                fillMore = (head != tail);
+                fillDone = now + n / c->copyBps;
+                filling = true;
+                fillsLeft = fillMore ? fillsLeft - 1u : 0u;
+            } else {
+                fillsLeft = 0u;             /* back to vTaskDelay */
+            }
+        }
+
+        /* Endpoint: the oldest queued slot moves at wire speed. */
+        if (UsbTxSlots_InFlight(&t) == 0u) {
+            if (head != tail || filling) {
+                o->wireIdle += MODEL_DT;
+            }
+            continue;
+        }
+        UsbTxSlot_t* s = &t.slot[t.completed % t.count];
+        wireSent += c->wireBps * MODEL_DT;
+        if (wireSent >= s->len) {
+            wireSent = 0.0;
+            if (o->received + s->len <= HOST_MAX) {
+                memcpy(g_host + o->received, s->data, s->len);
+            }
+            o->received += s->len;
+            bool keptOpen = s->morePending;
+            uint32_t len = 0;
+            UsbTxSlots_Complete(&t, s->handle, &len);
+            /* A read left open must have a transfer on its way. */
+            if (keptOpen && UsbTxSlots_InFlight(&t) == 0u && !filling &&
+                head == tail) {
+                o->unterminated++;
+            }
+        }
+    }
+
+    o->transfers = t.transfers;
+    o->overlapped = t.overlapped;
+    o->intact = (head == tail) && !filling && UsbTxSlots_InFlight(&t) == 0u &&
+                o->received == o->produced && o->received <= HOST_MAX;
+    /* Without drops the host sees the production sequence unbroken. */
+    for (uint32_t k = 1; k < o->received && o->intact && o->dropped == 0u; k++) {
+        if ((uint8_t)(g_host[k] - g_host[k - 1]) != 1u) {
+            o->intact = false;
+        }
+    }
+    printf("    %-22s recv %8u  drop %7u  xfers %5u  overlapped %5u  wire idle %.3f s\n",
+           c->name, (unsigned)o->received, (unsigned)o->dropped,
+           (unsigned)o->transfers, (unsigned)o->overlapped, o->wireIdle);
+}
+
+TEST(test_model_delivers_everything)
+{
+    /* Well inside both ceilings: nothing dropped, the stream arrives whole,
+     * and the drained pipeline leaves no host read hanging. */
+    UsbModelCfg_t one = { "1 slot @2 MB/s", 1, 16384u, 2e6, 100e6, 35e6, 1.0 };
+    UsbModelCfg_t two = { "2 slots @2 MB/s", 2, 16384u, 2e6, 100e6, 35e6, 1.0 };
+    UsbModelOut_t o1, o2;
+    model_usb(&one, &o1);
+    model_usb(&two, &o2);
+    ASSERT_EQ(o1.dropped, 0u);
+    ASSERT_EQ(o2.dropped, 0u);
+    ASSERT_TRUE(o1.intact);
+    ASSERT_TRUE(o2.intact);
+    ASSERT_EQ(o1.unterminated, 0u);
+    ASSERT_EQ(o2.unterminated, 0u);
+}
+
+TEST(test_model_overlap_keeps_up_where_single_drops)
+{
+    /* Between the two ceilings. One slot: a transfer per task tick at most,
+     * and the wire idles from its end to the next tick's copy. Two: the next
+     * transfer is queued behind the one on the wire, in the same DMA memory. */
+    UsbModelCfg_t one = { "1 slot @28 MB/s", 1, 32768u, 28e6, 100e6, 35e6, 0.25 };
+    UsbModelCfg_t two = { "2 slots @28 MB/s", 2, 32768u, 28e6, 100e6, 35e6, 0.25 };
+    UsbModelOut_t o1, o2;
+    model_usb(&one, &o1);
+    model_usb(&two, &o2);
+    ASSERT_TRUE(o1.dropped > 0u);
+    ASSERT_EQ(o1.overlapped, 0u);
+    ASSERT_EQ(o2.dropped, 0u);
+    ASSERT_TRUE(o2.intact);
+    ASSERT_TRUE(o2.overlapped > 0u);
+    ASSERT_EQ(o2.unterminated, 0u);
+    ASSERT_TRUE(o2.wireIdle < o1.wireIdle);
+}
+
+int main(void)
+{
+    printf("UsbTxSlots\n");
+    printf("---------------------------------------------\n");
+    RUN(test_init_carves_packet_slots);
+    RUN(test_in_order_handoff);
+    RUN(test_claim_excludes_second_writer);
+    RUN(test_zlp_rule);
+    RUN(test_failed_submit_backs_out);
+    RUN(test_reset_forgets_in_flight);
+    RUN(test_counters_wrap);
+    RUN(test_model_delivers_everything);
+    RUN(test_model_overlap_keeps_up_where_single_drops);
+    return TEST_SUMMARY();
+}
@@ -0,0 +1,183 @@
+/* ==========================================================================
+ * udp_stream_rx.c — reference receiver for WiFi UDP streaming
+ * (SYST:STR:INT 4, firmware/src/Util/UdpStream.h).
+ *
+ * Built on the firmware's own UdpStream.c. Listens on a UDP port, checks
+ * each datagram's sequence number, and writes the batches that arrived whole
+ * to FILE -- the same CSV / JSON / PB stream a TCP or USB client would have
+ * read, minus what the network lost. Once a second it prints to stderr:
+ *
+ *     datagrams received, lost (seq gaps) and the loss rate, late arrivals,
+ *     batches torn by a lost piece, delivered KB/s, and the last batch's
+ *     first-sample timestamp
+ *
+ * and a summary on exit (Ctrl-C, or after -t seconds). Loss is only ever
+ * counted here: the device numbers every datagram it queues and does not
+ * retransmit.
+ *
+ * Usage: udp_stream_rx [-p PORT] [-o FILE|-] [-t SECONDS] [-q]
+ *        (default port 9761, no output file)
+ * ========================================================================== */
+#define _POSIX_C_SOURCE 200809L
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "UdpStream.h"
+
+#define RX_DEFAULT_PORT 9761
+#define RX_BATCH_MAX    (64u * 1024u)
+
+static volatile sig_atomic_t g_stop;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    g_stop = 1;
+}
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void report(const char* tag, const UdpStreamRx_t* rx, uint64_t bytes, double secs,
+                   uint32_t lastTs)
+{
+    uint64_t expected = rx->received - rx->late + rx->lost;
+    fprintf(stderr, "%s rx %llu  lost %llu (%.3f%%)  late %llu  torn %llu  %.1f KB/s  ts 0x%08X\n",
+            tag, (unsigned long long)rx->received, (unsigned long long)rx->lost,
+            expected ? 100.0 * (double)rx->lost / (double)expected : 0.0,
+            (unsigned long long)rx->late, (unsigned long long)rx->torn,
+            secs > 0.0 ? (double)bytes / secs / 1024.0 : 0.0, (unsigned)lastTs);
+}
+
+static int usage(void)
+{
+    fprintf(stderr, "usage: udp_stream_rx [-p PORT] [-o FILE|-] [-t SECONDS] [-q]\n");
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    int port = RX_DEFAULT_PORT;
+    const char* path = NULL;
+    double limit = 0.0;
+    int quiet = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:o:t:q")) != -1) {
+        switch (opt) {
+            case 'p': port = atoi(optarg); break;
+            case 'o': path = optarg; break;
+            case 't': limit = atof(optarg); break;
+            case 'q': quiet = 1; break;
+            default:  return usage();
+        }
+    }
+
+    FILE* out = NULL;
+    if (path != NULL) {
+        out = (strcmp(path, "-") == 0) ? stdout : fopen(path, "wb");
+        if (out == NULL) {
+            perror(path);
+            return 1;
+        }
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    int rcvbuf = 4 * 1024 * 1024;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons((uint16_t)port)};
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (sock < 0 || bind(sock, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        perror("bind");
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    static uint8_t dgram[2048];
+    static uint8_t batch[RX_BATCH_MAX];
+    size_t batchLen = 0;
+    UdpStreamRx_t rx;
+    memset(&rx, 0, sizeof(rx));
+    uint64_t delivered = 0, bad = 0, windowBytes = 0;
+    uint32_t lastTs = 0;
+    double start = 0.0, window = now_sec();
+
+    while (!g_stop) {
+        struct pollfd pfd = {.fd = sock, .events = POLLIN};
+        if (poll(&pfd, 1, 200) > 0) {
+            ssize_t n = recv(sock, dgram, sizeof(dgram), 0);
+            UdpStreamHeader_t h;
+            if (n <= 0 || !UdpStream_DecodeHeader(dgram, (size_t)n, &h)) {
+                bad++;
+                continue;
+            }
+            if (start == 0.0) {
+                start = now_sec();
+            }
+            switch (UdpStreamRx_Accept(&rx, &h)) {
+                case UDP_STREAM_RX_RESTART:
+                    batchLen = 0;
+                    /* fall through */
+                case UDP_STREAM_RX_DELIVER:
+                    if (batchLen + h.payloadLen > sizeof(batch)) {
+                        batchLen = 0;   /* cannot be a batch this device sent */
+                        break;
+                    }
+                    memcpy(batch + batchLen, dgram + UDP_STREAM_HEADER_SIZE, h.payloadLen);
+                    batchLen += h.payloadLen;
+                    if ((h.flags & UDP_STREAM_FLAG_MORE) == 0u) {
+                        if (out != NULL) {
+                            fwrite(batch, 1, batchLen, out);
+                        }
+                        delivered += batchLen;
+                        windowBytes += batchLen;
+                        lastTs = h.firstTs;
+                        batchLen = 0;
+                    }
+                    break;
+                case UDP_STREAM_RX_DROP:
+                    batchLen = 0;
+                    break;
+                case UDP_STREAM_RX_LATE:
+                    break;
+            }
+        }
+        double t = now_sec();
+        if (!quiet && t - window >= 1.0) {
+            report("  ", &rx, windowBytes, t - window, lastTs);
+            window = t;
+            windowBytes = 0;
+        }
+        if (limit > 0.0 && start != 0.0 && t - start >= limit) {
+            break;
+        }
+    }
+
+    double secs = (start != 0.0) ? now_sec() - start : 0.0;
+    report("total", &rx, delivered, secs, lastTs);
+    fprintf(stderr, "      %llu bytes delivered, %llu sessions, %llu undecodable datagrams\n",
+            (unsigned long long)delivered, (unsigned long long)rx.sessions + (rx.started ? 1u : 0u),
+            (unsigned long long)bad);
+    if (out != NULL && out != stdout) {
+        fclose(out);
+    }
+    close(sock);
+    return 0;
+}